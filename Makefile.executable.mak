@@ -42,6 +42,11 @@ ifeq ($(OS),Windows_NT)
     endif
 endif
 
+# Opt-in allocation call-site tracking. See memory_call_sites_report()
+ifeq ($(TRACK_ALLOCATIONS),yes)
+DEFINES += -DBMEMORY_TRACK_CALL_SITES=1
+endif
+
 # Defaults to debug unless release is specified
 ifeq ($(TARGET),release)
 # release
@@ -63,6 +63,11 @@ ifeq ($(DO_VERSION),yes)
 	endif
 endif
 
+# Opt-in allocation call-site tracking. See memory_call_sites_report()
+ifeq ($(TRACK_ALLOCATIONS),yes)
+DEFINES += -DBMEMORY_TRACK_CALL_SITES=1
+endif
+
 # Defaults to debug unless release is specified
 ifeq ($(TARGET),release)
 # release
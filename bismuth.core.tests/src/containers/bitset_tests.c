@@ -0,0 +1,183 @@
+#include "bitset_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/bitset.h>
+#include <memory/bmemory.h>
+#include <time/bclock.h>
+
+u8 bitset_should_set_clear_and_count(void)
+{
+    bitset set;
+    expect_to_be_true(bitset_create(200, &set));
+    expect_should_be(200, set.bit_count);
+    expect_should_be(4, set.word_count);
+    expect_should_be(0, bitset_count(&set));
+
+    // Either side of each word boundary
+    const u32 indices[] = {0, 1, 63, 64, 127, 128, 199};
+    for (u32 i = 0; i < 7; ++i)
+        bitset_set(&set, indices[i]);
+    expect_should_be(7, bitset_count(&set));
+    for (u32 i = 0; i < 7; ++i)
+        expect_to_be_true(bitset_test(&set, indices[i]));
+    expect_to_be_false(bitset_test(&set, 2));
+    expect_to_be_false(bitset_test(&set, 65));
+
+    // Setting twice changes nothing
+    bitset_set(&set, 64);
+    expect_should_be(7, bitset_count(&set));
+
+    bitset_clear(&set, 64);
+    expect_to_be_false(bitset_test(&set, 64));
+    expect_to_be_true(bitset_test(&set, 63));
+    expect_should_be(6, bitset_count(&set));
+
+    bitset_clear_all(&set);
+    expect_should_be(0, bitset_count(&set));
+
+    bitset_destroy(&set);
+    expect_should_be(0, set.bit_count);
+    expect_should_be(0, set.words);
+
+    return true;
+}
+
+u8 bitset_should_find_next(void)
+{
+    bitset set;
+    expect_to_be_true(bitset_create(300, &set));
+    expect_should_be(INVALID_ID, bitset_find_next_set(&set, 0));
+    expect_should_be(0, bitset_find_next_clear(&set, 0));
+
+    bitset_set(&set, 5);
+    bitset_set(&set, 64);
+    bitset_set(&set, 250);
+    bitset_set(&set, 299);
+
+    // Walk every set bit in order
+    const u32 expected[] = {5, 64, 250, 299};
+    u32 found = 0;
+    for (u32 i = bitset_find_next_set(&set, 0); i != INVALID_ID; i = bitset_find_next_set(&set, i + 1))
+    {
+        expect_should_be(expected[found], i);
+        found++;
+    }
+    expect_should_be(4, found);
+    expect_should_be(64, bitset_find_next_set(&set, 6));
+    expect_should_be(64, bitset_find_next_set(&set, 64));
+    expect_should_be(INVALID_ID, bitset_find_next_set(&set, 300));
+    expect_should_be(INVALID_ID, bitset_find_next_set(&set, 1000));
+
+    // Fill everything, leaving gaps to find
+    for (u32 i = 0; i < 300; ++i)
+        bitset_set(&set, i);
+    expect_should_be(INVALID_ID, bitset_find_next_clear(&set, 0));
+    bitset_clear(&set, 130);
+    expect_should_be(130, bitset_find_next_clear(&set, 0));
+    expect_should_be(130, bitset_find_next_clear(&set, 130));
+    // The spare bits in the last word are clear, but aren't part of the set
+    expect_should_be(INVALID_ID, bitset_find_next_clear(&set, 131));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+u8 bitset_should_resize(void)
+{
+    bitset set = {0};
+    expect_should_be(INVALID_ID, bitset_find_next_set(&set, 0));
+    expect_should_be(0, bitset_count(&set));
+
+    expect_to_be_true(bitset_resize(&set, 70));
+    bitset_set(&set, 3);
+    bitset_set(&set, 69);
+
+    // Growing keeps existing bits, and new ones start clear
+    expect_to_be_true(bitset_resize(&set, 1000));
+    expect_to_be_true(bitset_test(&set, 3));
+    expect_to_be_true(bitset_test(&set, 69));
+    expect_should_be(2, bitset_count(&set));
+    expect_should_be(INVALID_ID, bitset_find_next_set(&set, 70));
+
+    // Shrinking drops bits beyond the new end, even within the same word
+    expect_to_be_true(bitset_resize(&set, 60));
+    expect_should_be(1, bitset_count(&set));
+    expect_to_be_true(bitset_resize(&set, 128));
+    expect_to_be_false(bitset_test(&set, 69));
+    expect_should_be(1, bitset_count(&set));
+
+    bitset_destroy(&set);
+    return true;
+}
+
+u8 bitset_benchmark(void)
+{
+    // Finding the few active entries among many, as systems scanning an array of flags do
+    const u32 bit_count = 1 << 20;
+    const u32 passes = 20;
+    bclock clock;
+
+    b8* flags = ballocate(sizeof(b8) * bit_count, MEMORY_TAG_ARRAY);
+    bitset set;
+    bitset_create(bit_count, &set);
+    // Roughly 1 in 100 active
+    u32 seed = 99;
+    for (u32 i = 0; i < bit_count / 100; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        u32 index = seed % bit_count;
+        flags[index] = true;
+        bitset_set(&set, index);
+    }
+
+    u64 sum = 0;
+    bclock_start(&clock);
+    for (u32 p = 0; p < passes; ++p)
+    {
+        for (u32 i = 0; i < bit_count; ++i)
+        {
+            if (flags[i])
+                sum += i;
+        }
+    }
+    bclock_update(&clock);
+    f64 scan_time = clock.elapsed;
+
+    u64 bitset_sum = 0;
+    bclock_start(&clock);
+    for (u32 p = 0; p < passes; ++p)
+    {
+        for (u32 i = bitset_find_next_set(&set, 0); i != INVALID_ID; i = bitset_find_next_set(&set, i + 1))
+            bitset_sum += i;
+    }
+    bclock_update(&clock);
+    f64 bitset_time = clock.elapsed;
+
+    u64 count_sum = 0;
+    bclock_start(&clock);
+    for (u32 p = 0; p < passes; ++p)
+        count_sum += bitset_count(&set);
+    bclock_update(&clock);
+    f64 count_time = clock.elapsed;
+
+    BINFO("bitset: finding active entries among %u, %u passes: flag array scan %.2fms, bitset find_next_set %.2fms, bitset_count %.2fms",
+          bit_count, passes, scan_time * 1000.0, bitset_time * 1000.0, count_time * 1000.0);
+
+    bitset_destroy(&set);
+    bfree(flags, sizeof(b8) * bit_count, MEMORY_TAG_ARRAY);
+    expect_should_be(sum, bitset_sum);
+    expect_to_be_true(count_sum > 0);
+
+    return true;
+}
+
+void bitset_register_tests(void)
+{
+    test_manager_register_test(bitset_should_set_clear_and_count, "bitset should set, clear and count bits");
+    test_manager_register_test(bitset_should_find_next, "bitset should find the next set and clear bits");
+    test_manager_register_test(bitset_should_resize, "bitset should keep bits when resized");
+    test_manager_register_test(bitset_benchmark, "bitset benchmark against scanning a flag array");
+}
@@ -0,0 +1,244 @@
+#include "chunked_array_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/chunked_array.h>
+#include <containers/darray.h>
+#include <memory/bmemory.h>
+#include <time/bclock.h>
+
+typedef struct test_item
+{
+    u32 id;
+    f32 value;
+    u64 payload;
+} test_item;
+
+u8 chunked_array_should_keep_addresses_stable(void)
+{
+    chunked_array arr;
+    expect_to_be_true(chunked_array_create(sizeof(test_item), 4, &arr));
+    expect_should_be(2, arr.chunk_shift);
+
+    // Pointers handed out by push stay valid as more chunks are added
+    test_item* pointers[100];
+    for (u32 i = 0; i < 100; ++i)
+    {
+        test_item item = {i, i * 0.5f, (u64)i * 1000};
+        pointers[i] = chunked_array_push(&arr, &item);
+        expect_should_not_be(0, pointers[i]);
+    }
+    expect_should_be(100, arr.length);
+    expect_should_be(25, arr.chunk_count);
+    for (u32 i = 0; i < 100; ++i)
+    {
+        expect_should_be(pointers[i], chunked_array_get(&arr, i));
+        expect_should_be(i, pointers[i]->id);
+        expect_should_be((u64)i * 1000, pointers[i]->payload);
+    }
+
+    // A push with no value gives a zeroed element
+    test_item* zeroed = chunked_array_push(&arr, 0);
+    expect_should_be(0, zeroed->id);
+    expect_should_be(0, zeroed->payload);
+
+    // Popping comes off the end
+    test_item popped;
+    expect_to_be_true(chunked_array_pop(&arr, &popped));
+    expect_to_be_true(chunked_array_pop(&arr, &popped));
+    expect_should_be(99, popped.id);
+    expect_should_be(99, arr.length);
+
+    chunked_array_destroy(&arr);
+    expect_should_be(0, arr.chunks);
+    expect_should_be(0, arr.length);
+    return true;
+}
+
+u8 chunked_array_should_iterate_by_chunk(void)
+{
+    chunked_array arr;
+    expect_to_be_true(chunked_array_create(sizeof(u32), 16, &arr));
+    expect_should_be(0, chunked_array_chunk_count(&arr));
+
+    for (u32 i = 0; i < 50; ++i)
+        chunked_array_push(&arr, &i);
+
+    // 3 full chunks and a partial one
+    expect_should_be(4, chunked_array_chunk_count(&arr));
+    u32 expected = 0;
+    for (u32 c = 0; c < chunked_array_chunk_count(&arr); ++c)
+    {
+        u32 count = 0;
+        u32* values = chunked_array_chunk_get(&arr, c, &count);
+        u32 expected_count = c < 3 ? 16 : 2;
+        expect_should_be(expected_count, count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            expect_should_be(expected, values[i]);
+            expected++;
+        }
+    }
+    expect_should_be(50, expected);
+
+    chunked_array_destroy(&arr);
+    return true;
+}
+
+u8 chunked_array_should_reserve_and_shrink(void)
+{
+    chunked_array arr;
+    // Default chunks fit within 4KiB
+    expect_to_be_true(chunked_array_create(24, 0, &arr));
+    expect_should_be(128, 1u << arr.chunk_shift);
+    chunked_array_destroy(&arr);
+    // Elements bigger than that get a chunk each
+    expect_to_be_true(chunked_array_create(5000, 0, &arr));
+    expect_should_be(0, arr.chunk_shift);
+    chunked_array_destroy(&arr);
+
+    // Counts are rounded up to a power of two
+    expect_to_be_true(chunked_array_create(sizeof(u64), 10, &arr));
+    expect_should_be(16, 1u << arr.chunk_shift);
+
+    expect_to_be_true(chunked_array_reserve(&arr, 100));
+    expect_should_be(7, arr.chunk_count);
+    expect_should_be(112, chunked_array_capacity(&arr));
+
+    // Pushing within the reserved capacity allocates nothing new
+    u8** chunks = arr.chunks;
+    u64* first = 0;
+    for (u64 i = 0; i < 100; ++i)
+    {
+        u64* p = chunked_array_push(&arr, &i);
+        if (i == 0)
+            first = p;
+    }
+    expect_should_be(chunks, arr.chunks);
+    expect_should_be(7, arr.chunk_count);
+
+    // Shrinking releases unused chunks, but never moves elements
+    for (u32 i = 0; i < 60; ++i)
+        chunked_array_pop(&arr, 0);
+    chunked_array_shrink(&arr);
+    expect_should_be(3, arr.chunk_count);
+    expect_should_be(first, chunked_array_get(&arr, 0));
+    expect_should_be(39, *(u64*)chunked_array_get(&arr, 39));
+
+    // Clearing keeps the chunks for reuse
+    chunked_array_clear(&arr);
+    expect_should_be(0, arr.length);
+    expect_should_be(3, arr.chunk_count);
+    expect_should_be(first, chunked_array_push(&arr, 0));
+
+    chunked_array_clear(&arr);
+    chunked_array_shrink(&arr);
+    expect_should_be(0, arr.chunk_count);
+    expect_should_be(0, arr.chunks);
+
+    // Still usable after shrinking away everything
+    u64 value = 77;
+    expect_should_be(77, *(u64*)chunked_array_push(&arr, &value));
+
+    BDEBUG("Note: The following errors are intentionally caused by this test");
+    expect_to_be_false(chunked_array_create(0, 0, &arr));
+    expect_to_be_false(chunked_array_create(4, 0, 0));
+
+    chunked_array_destroy(&arr);
+    return true;
+}
+
+u8 darray_should_grow_by_at_least_min_bytes(void)
+{
+    // A darray of one pointer jumps straight to DARRAY_MIN_GROWTH_BYTES worth on its first growth
+    void** arr = darray_create(void*);
+    expect_should_be(1, darray_capacity(arr));
+    for (u64 i = 0; i < 2; ++i)
+        darray_push(arr, (void*)i);
+    expect_should_be(DARRAY_MIN_GROWTH_BYTES / sizeof(void*), darray_capacity(arr));
+    expect_should_be((void*)1, arr[1]);
+    // Unused elements are still zeroed
+    expect_should_be(0, arr[2]);
+    darray_destroy(arr);
+
+    // Reserving an estimate of 0 is allowed
+    u32* empty = darray_reserve(u32, 0);
+    expect_should_be(1, darray_capacity(empty));
+    darray_destroy(empty);
+    return true;
+}
+
+u8 chunked_array_benchmark(void)
+{
+    const u32 count = 1000000;
+    bclock clock;
+    u64 sum = 0;
+
+    bclock_start(&clock);
+    test_item* created = darray_create(test_item);
+    for (u32 i = 0; i < count; ++i)
+        darray_push(created, ((test_item){i, 1.0f, i}));
+    bclock_update(&clock);
+    f64 darray_push_time = clock.elapsed;
+
+    bclock_start(&clock);
+    test_item* reserved = darray_reserve(test_item, count);
+    for (u32 i = 0; i < count; ++i)
+        darray_push(reserved, ((test_item){i, 1.0f, i}));
+    bclock_update(&clock);
+    f64 darray_reserved_push_time = clock.elapsed;
+
+    chunked_array chunked;
+    chunked_array_create(sizeof(test_item), 0, &chunked);
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+    {
+        test_item item = {i, 1.0f, i};
+        chunked_array_push(&chunked, &item);
+    }
+    bclock_update(&clock);
+    f64 chunked_push_time = clock.elapsed;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        sum += created[i].payload;
+    bclock_update(&clock);
+    f64 darray_iterate_time = clock.elapsed;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        sum += ((test_item*)chunked_array_get(&chunked, i))->payload;
+    bclock_update(&clock);
+    f64 chunked_index_time = clock.elapsed;
+
+    bclock_start(&clock);
+    u32 chunk_count = chunked_array_chunk_count(&chunked);
+    for (u32 c = 0; c < chunk_count; ++c)
+    {
+        u32 n = 0;
+        test_item* items = chunked_array_chunk_get(&chunked, c, &n);
+        for (u32 i = 0; i < n; ++i)
+            sum += items[i].payload;
+    }
+    bclock_update(&clock);
+    f64 chunked_iterate_time = clock.elapsed;
+
+    BINFO("x%u push: darray %.3fms, darray reserved %.3fms, chunked_array %.3fms", count, darray_push_time * 1000.0, darray_reserved_push_time * 1000.0, chunked_push_time * 1000.0);
+    BINFO("x%u iterate: darray %.3fms, chunked_array by index %.3fms, chunked_array by chunk %.3fms (%llu)", count, darray_iterate_time * 1000.0, chunked_index_time * 1000.0, chunked_iterate_time * 1000.0, sum & 1);
+
+    darray_destroy(created);
+    darray_destroy(reserved);
+    chunked_array_destroy(&chunked);
+    return true;
+}
+
+void chunked_array_register_tests(void)
+{
+    test_manager_register_test(chunked_array_should_keep_addresses_stable, "chunked_array should keep element addresses stable");
+    test_manager_register_test(chunked_array_should_iterate_by_chunk, "chunked_array should iterate chunk by chunk");
+    test_manager_register_test(chunked_array_should_reserve_and_shrink, "chunked_array should reserve and shrink");
+    test_manager_register_test(darray_should_grow_by_at_least_min_bytes, "darray should grow by at least DARRAY_MIN_GROWTH_BYTES");
+    test_manager_register_test(chunked_array_benchmark, "chunked_array push/iterate benchmark against darray");
+}
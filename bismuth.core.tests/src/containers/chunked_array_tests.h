@@ -0,0 +1,3 @@
+#pragma once
+
+void chunked_array_register_tests(void);
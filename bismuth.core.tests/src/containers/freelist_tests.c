@@ -4,6 +4,7 @@
 #include <containers/freelist.h>
 #include <defines.h>
 #include <memory/bmemory.h>
+#include <time/bclock.h>
 
 u8 freelist_should_create_and_destroy(void)
 {
@@ -331,7 +332,7 @@ u8 util_freelist_free(freelist* list, alloc_data* data, u64* currently_allocated
     return true;
 }
 
-u8 freelist_multiple_alloc_and_free_random(void)
+static u8 util_freelist_multiple_alloc_and_free_random(freelist_mode mode)
 {
     freelist list;
 
@@ -351,11 +352,11 @@ u8 freelist_multiple_alloc_and_free_random(void)
 
     // Get memory requirement
     u64 memory_requirement = 0;
-    freelist_create(total_size, &memory_requirement, 0, 0);
+    freelist_create_mode(total_size, mode, &memory_requirement, 0, 0);
 
     // Allocate and create freelist
     void* block = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
-    freelist_create(total_size, &memory_requirement, block, &list);
+    freelist_create_mode(total_size, mode, &memory_requirement, block, &list);
 
     // Verify free space
     u64 free_space = freelist_free_space(&list);
@@ -429,6 +430,234 @@ u8 freelist_multiple_alloc_and_free_random(void)
     return true;
 }
 
+u8 freelist_multiple_alloc_and_free_random(void)
+{
+    return util_freelist_multiple_alloc_and_free_random(FREELIST_MODE_FIRST_FIT);
+}
+
+u8 freelist_segregated_multiple_alloc_and_free_random(void)
+{
+    return util_freelist_multiple_alloc_and_free_random(FREELIST_MODE_SEGREGATED_FIT);
+}
+
+u8 freelist_segregated_should_coalesce_neighbours(void)
+{
+    freelist list;
+
+    u64 memory_requirement = 0;
+    u64 total_size = 4096;
+    freelist_create_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, 0, 0);
+    void* block = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, block, &list);
+    expect_should_be(total_size, freelist_free_space(&list));
+
+    // Take the whole list in four chunks of differing sizes
+    u64 sizes[4] = {512, 1000, 24, 2560};
+    u64 offsets[4] = {0};
+    u64 expected_offset = 0;
+    for (u32 i = 0; i < 4; ++i)
+    {
+        expect_to_be_true(freelist_allocate_block(&list, sizes[i], &offsets[i]));
+        expect_should_be(expected_offset, offsets[i]);
+        expected_offset += sizes[i];
+    }
+    expect_should_be(0, freelist_free_space(&list));
+
+    // Nothing left
+    BDEBUG("The following warning message is intentional");
+    u64 offset = INVALID_ID;
+    expect_should_be(false, freelist_allocate_block(&list, 8, &offset));
+
+    // Free in an order that hits isolated, merge-right, merge-left and merge-both cases
+    expect_to_be_true(freelist_free_block(&list, sizes[2], offsets[2]));
+    expect_to_be_true(freelist_free_block(&list, sizes[1], offsets[1]));
+    expect_to_be_true(freelist_free_block(&list, sizes[3], offsets[3]));
+    expect_to_be_true(freelist_free_block(&list, sizes[0], offsets[0]));
+    expect_should_be(total_size, freelist_free_space(&list));
+
+    // If everything coalesced, the entire list is available as one range
+    expect_to_be_true(freelist_allocate_block(&list, total_size, &offset));
+    expect_should_be(0, offset);
+    expect_to_be_true(freelist_free_block(&list, total_size, offset));
+
+    // Clearing should also give back one range
+    expect_to_be_true(freelist_allocate_block(&list, 100, &offset));
+    freelist_clear(&list);
+    expect_should_be(total_size, freelist_free_space(&list));
+    expect_to_be_true(freelist_allocate_block(&list, total_size, &offset));
+    expect_should_be(0, offset);
+
+    freelist_destroy(&list);
+    expect_should_be(0, list.memory);
+    bfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_segregated_should_resize(void)
+{
+    freelist list;
+
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, 0, 0);
+    void* block = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, block, &list);
+
+    // Leave a hole at the front and a free tail, which should join up with the new space
+    u64 offset_a = 0, offset_b = 0;
+    expect_to_be_true(freelist_allocate_block(&list, 256, &offset_a));
+    expect_to_be_true(freelist_allocate_block(&list, 512, &offset_b));
+    expect_to_be_true(freelist_free_block(&list, 256, offset_a));
+    expect_should_be(512, freelist_free_space(&list));
+
+    u64 new_size = 4096;
+    u64 new_requirement = 0;
+    expect_to_be_true(freelist_resize(&list, &new_requirement, 0, new_size, 0));
+    void* new_block = ballocate(new_requirement, MEMORY_TAG_ENGINE);
+    void* old_block = 0;
+    expect_to_be_true(freelist_resize(&list, &new_requirement, new_block, new_size, &old_block));
+    expect_should_be(block, old_block);
+    bfree(old_block, memory_requirement, MEMORY_TAG_ENGINE);
+    expect_should_be(new_size - 512, freelist_free_space(&list));
+
+    // The old tail (256) plus new space must be one contiguous range
+    u64 offset = 0;
+    expect_to_be_true(freelist_allocate_block(&list, new_size - 768, &offset));
+    expect_should_be(768, offset);
+    // The old hole should still be at the front
+    expect_to_be_true(freelist_allocate_block(&list, 256, &offset));
+    expect_should_be(0, offset);
+    expect_should_be(0, freelist_free_space(&list));
+
+    freelist_destroy(&list);
+    bfree(new_block, new_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+static u8 util_freelist_allocate_block_at(freelist_mode mode)
+{
+    freelist list;
+    u64 memory_requirement = 0;
+    u64 total_size = 1024;
+    freelist_create_mode(total_size, mode, &memory_requirement, 0, 0);
+    void* block = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create_mode(total_size, mode, &memory_requirement, block, &list);
+
+    u64 offset_a = 0, offset_b = 0;
+    expect_to_be_true(freelist_allocate_block(&list, 128, &offset_a));
+    expect_to_be_true(freelist_allocate_block(&list, 128, &offset_b));
+    expect_to_be_true(freelist_free_block(&list, 128, offset_b));
+
+    // Grow the first block into the freed space after it
+    expect_to_be_true(freelist_allocate_block_at(&list, 64, offset_a + 128));
+    expect_should_be(total_size - 192, freelist_free_space(&list));
+    // Not the start of a free range
+    expect_should_be(false, freelist_allocate_block_at(&list, 16, offset_a + 32));
+    expect_should_be(false, freelist_allocate_block_at(&list, 16, 512));
+    // Too big
+    expect_should_be(false, freelist_allocate_block_at(&list, total_size, 192));
+    // Exactly the rest
+    expect_to_be_true(freelist_allocate_block_at(&list, total_size - 192, 192));
+    expect_should_be(0, freelist_free_space(&list));
+
+    expect_to_be_true(freelist_free_block(&list, total_size, 0));
+    expect_should_be(total_size, freelist_free_space(&list));
+
+    freelist_destroy(&list);
+    bfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 freelist_should_allocate_block_at(void)
+{
+    return util_freelist_allocate_block_at(FREELIST_MODE_FIRST_FIT) && util_freelist_allocate_block_at(FREELIST_MODE_SEGREGATED_FIT);
+}
+
+// Fragments the list with many live allocations of random sizes, then churns through
+// allocate/free pairs. Returns the time taken for the churn phase
+static f64 util_freelist_fragmentation_run(freelist_mode mode, alloc_data* datas, u32 live_count, u32 churn_ops, u64 total_size, b8* out_ok)
+{
+    freelist list;
+    u64 memory_requirement = 0;
+    freelist_create_mode(total_size, mode, &memory_requirement, 0, 0);
+    void* block = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    freelist_create_mode(total_size, mode, &memory_requirement, block, &list);
+
+    *out_ok = true;
+    for (u32 i = 0; i < live_count * 2; ++i)
+    {
+        if (!freelist_allocate_block(&list, datas[i].size, &datas[i].offset))
+            *out_ok = false;
+    }
+    // Free every other one so free space is scattered into many small holes
+    for (u32 i = 0; i < live_count * 2; i += 2)
+    {
+        freelist_free_block(&list, datas[i].size, datas[i].offset);
+        datas[i].offset = INVALID_ID;
+    }
+
+    bclock clock;
+    bclock_start(&clock);
+    for (u32 i = 0; i < churn_ops; ++i)
+    {
+        u32 index = (i * 2654435761u) % (live_count * 2);
+        if (datas[index].offset == INVALID_ID)
+        {
+            if (!freelist_allocate_block(&list, datas[index].size, &datas[index].offset))
+                datas[index].offset = INVALID_ID;
+        }
+        else
+        {
+            freelist_free_block(&list, datas[index].size, datas[index].offset);
+            datas[index].offset = INVALID_ID;
+        }
+    }
+    bclock_update(&clock);
+
+    for (u32 i = 0; i < live_count * 2; ++i)
+    {
+        if (datas[i].offset != INVALID_ID)
+        {
+            freelist_free_block(&list, datas[i].size, datas[i].offset);
+            datas[i].offset = INVALID_ID;
+        }
+    }
+    if (freelist_free_space(&list) != total_size)
+        *out_ok = false;
+
+    freelist_destroy(&list);
+    bfree(block, memory_requirement, MEMORY_TAG_ENGINE);
+    return clock.elapsed;
+}
+
+u8 freelist_fragmentation_stress_benchmark(void)
+{
+    const u32 live_count = 8192;
+    const u32 churn_ops = 50000;
+    alloc_data* datas = ballocate(sizeof(alloc_data) * live_count * 2, MEMORY_TAG_ARRAY);
+    u64 total_size = 0;
+    for (u32 i = 0; i < live_count * 2; ++i)
+    {
+        datas[i].size = (u64)brandom_in_range(16, 4096);
+        datas[i].offset = INVALID_ID;
+        total_size += datas[i].size;
+    }
+    // Headroom so the churn phase can also land in the tail
+    total_size += total_size / 4;
+
+    b8 ok = false;
+    f64 first_fit = util_freelist_fragmentation_run(FREELIST_MODE_FIRST_FIT, datas, live_count, churn_ops, total_size, &ok);
+    expect_to_be_true(ok);
+    f64 segregated = util_freelist_fragmentation_run(FREELIST_MODE_SEGREGATED_FIT, datas, live_count, churn_ops, total_size, &ok);
+    expect_to_be_true(ok);
+
+    BINFO("Freelist fragmentation stress (%u holes, %u ops): first-fit=%.3fms, segregated-fit=%.3fms",
+          live_count, churn_ops, first_fit * 1000.0, segregated * 1000.0);
+
+    bfree(datas, sizeof(alloc_data) * live_count * 2, MEMORY_TAG_ARRAY);
+    return true;
+}
+
 void freelist_register_tests(void)
 {
     test_manager_register_test(freelist_should_create_and_destroy, "Freelist should create and destroy");
@@ -437,4 +666,9 @@ void freelist_register_tests(void)
     test_manager_register_test(freelist_should_allocate_one_and_free_multi_varying_sizes, "Freelist allocate and free multiple entries of varying sizes");
     test_manager_register_test(freelist_should_allocate_to_full_and_fail_to_allocate_more, "Freelist allocate to full and fail when trying to allocate more");
     test_manager_register_test(freelist_multiple_alloc_and_free_random, "Freelist should randomly allocate and free");
+    test_manager_register_test(freelist_segregated_multiple_alloc_and_free_random, "Segregated freelist should randomly allocate and free");
+    test_manager_register_test(freelist_segregated_should_coalesce_neighbours, "Segregated freelist should coalesce neighbouring ranges");
+    test_manager_register_test(freelist_segregated_should_resize, "Segregated freelist should resize");
+    test_manager_register_test(freelist_should_allocate_block_at, "Freelist should allocate at a given offset");
+    test_manager_register_test(freelist_fragmentation_stress_benchmark, "Freelist fragmentation stress benchmark");
 }
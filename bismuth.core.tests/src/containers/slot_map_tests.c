@@ -0,0 +1,187 @@
+#include "slot_map_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/slot_map.h>
+#include <identifiers/bhandle.h>
+#include <memory/bmemory.h>
+#include <time/bclock.h>
+
+u8 slot_map_should_create_and_validate_handles(void)
+{
+    slot_map map;
+    expect_to_be_true(slot_map_create(0, 4, &map));
+    expect_should_be(4, map.capacity);
+
+    bhandle handles[10];
+    for (u32 i = 0; i < 10; ++i)
+    {
+        expect_to_be_true(slot_map_add(&map, 0, &handles[i]));
+        // Slots are handed out lowest first
+        expect_should_be(i, handles[i].handle_index);
+        expect_to_be_true(bhandle_is_valid(handles[i]));
+    }
+    // Grew by doubling
+    expect_should_be(10, map.count);
+    expect_should_be(16, map.capacity);
+
+    for (u32 i = 0; i < 10; ++i)
+        expect_to_be_true(slot_map_is_valid(&map, handles[i]));
+
+    // Removed handles go stale, and can't be removed twice
+    expect_to_be_true(slot_map_remove(&map, handles[3], 0));
+    expect_to_be_false(slot_map_is_valid(&map, handles[3]));
+    expect_to_be_false(slot_map_remove(&map, handles[3], 0));
+    expect_should_be(9, map.count);
+
+    // The freed slot is reused, but the old handle stays stale
+    bhandle reused;
+    expect_to_be_true(slot_map_add(&map, 0, &reused));
+    expect_should_be(3, reused.handle_index);
+    expect_should_not_be(handles[3].unique_id.uniqueid, reused.unique_id.uniqueid);
+    expect_to_be_true(slot_map_is_valid(&map, reused));
+    expect_to_be_false(slot_map_is_valid(&map, handles[3]));
+
+    // Handles which were never handed out are rejected
+    expect_to_be_false(slot_map_is_valid(&map, bhandle_invalid()));
+    expect_to_be_false(slot_map_is_valid(&map, bhandle_create_with_u64_identifier(500, 1)));
+    // A free slot doesn't match even a handle made up to look right for it
+    bhandle free_slot = bhandle_create_with_u64_identifier(12, ((u64)2 << 32) | 12);
+    expect_to_be_false(slot_map_is_valid(&map, free_slot));
+    free_slot.unique_id.uniqueid = ((u64)1 << 32) | 12;
+    expect_to_be_false(slot_map_is_valid(&map, free_slot));
+
+    slot_map_destroy(&map);
+    expect_to_be_false(slot_map_is_valid(&map, reused));
+    return true;
+}
+
+u8 slot_map_should_keep_values_dense(void)
+{
+    slot_map map;
+    expect_to_be_true(slot_map_create(sizeof(u64), 0, &map));
+
+    bhandle handles[100];
+    for (u64 i = 0; i < 100; ++i)
+        expect_to_be_true(slot_map_add(&map, &i, &handles[i]));
+
+    // Remove every third entry
+    for (u32 i = 0; i < 100; i += 3)
+    {
+        u64 removed = 0;
+        expect_to_be_true(slot_map_remove(&map, handles[i], &removed));
+        expect_should_be(i, removed);
+    }
+    expect_should_be(66, map.count);
+
+    // Every remaining value is still found through its handle
+    for (u32 i = 0; i < 100; ++i)
+    {
+        u64* value = slot_map_get(&map, handles[i]);
+        if (i % 3 == 0)
+        {
+            expect_should_be(0, value);
+        }
+        else
+        {
+            expect_should_not_be(0, value);
+            expect_should_be(i, *value);
+        }
+    }
+
+    // The dense arrays hold exactly the remaining entries, and map back to their handles
+    u64* values = (u64*)map.values;
+    u64 sum = 0;
+    for (u32 d = 0; d < map.count; ++d)
+    {
+        bhandle h = slot_map_handle_at(&map, d);
+        expect_to_be_true(slot_map_is_valid(&map, h));
+        expect_should_be(values[d], *(u64*)slot_map_get(&map, h));
+        sum += values[d];
+    }
+    // 0 to 99, less the multiples of 3
+    expect_should_be(4950 - 1683, sum);
+
+    // Clearing makes everything stale
+    slot_map_clear(&map);
+    expect_should_be(0, map.count);
+    for (u32 i = 0; i < 100; ++i)
+        expect_to_be_false(slot_map_is_valid(&map, handles[i]));
+
+    // A zeroed value when none is given
+    bhandle h;
+    expect_to_be_true(slot_map_add(&map, 0, &h));
+    expect_should_be(0, *(u64*)slot_map_get(&map, h));
+
+    slot_map_destroy(&map);
+    return true;
+}
+
+u8 slot_map_benchmark(void)
+{
+    // Churn against a large number of live objects, where a linear scan for a free slot suffers most
+    const u32 live_count = 20000;
+    const u32 churn_count = 20000;
+    bclock clock;
+
+    // A linear free-slot scan, as handle-based systems did it before
+    u64* ids = ballocate(sizeof(u64) * live_count * 2, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < live_count * 2; ++i)
+        ids[i] = INVALID_ID_U64;
+    for (u32 i = 0; i < live_count; ++i)
+        ids[i] = i + 1;
+    bclock_start(&clock);
+    u32 victim = 0;
+    for (u32 i = 0; i < churn_count; ++i)
+    {
+        // Free one slot towards the end, then scan for a free one
+        victim = (victim + 7919) % live_count;
+        ids[victim] = INVALID_ID_U64;
+        for (u32 s = 0; s < live_count * 2; ++s)
+        {
+            if (ids[s] == INVALID_ID_U64)
+            {
+                ids[s] = i + 1;
+                break;
+            }
+        }
+    }
+    bclock_update(&clock);
+    f64 scan_time = clock.elapsed;
+    bfree(ids, sizeof(u64) * live_count * 2, MEMORY_TAG_ARRAY);
+
+    slot_map map;
+    slot_map_create(0, live_count, &map);
+    bhandle* handles = ballocate(sizeof(bhandle) * live_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < live_count; ++i)
+        slot_map_add(&map, 0, &handles[i]);
+    bclock_start(&clock);
+    victim = 0;
+    for (u32 i = 0; i < churn_count; ++i)
+    {
+        victim = (victim + 7919) % live_count;
+        slot_map_remove(&map, handles[victim], 0);
+        slot_map_add(&map, 0, &handles[victim]);
+    }
+    u32 valid = 0;
+    for (u32 i = 0; i < live_count; ++i)
+        valid += slot_map_is_valid(&map, handles[i]);
+    bclock_update(&clock);
+    f64 map_time = clock.elapsed;
+    expect_should_be(live_count, valid);
+
+    BINFO("%u churns with %u live: linear slot scan %.3fms, slot_map %.3fms", churn_count, live_count, scan_time * 1000.0, map_time * 1000.0);
+
+    bfree(handles, sizeof(bhandle) * live_count, MEMORY_TAG_ARRAY);
+    slot_map_destroy(&map);
+    return true;
+}
+
+void slot_map_register_tests(void)
+{
+    test_manager_register_test(slot_map_should_create_and_validate_handles, "slot_map should create and validate handles");
+    test_manager_register_test(slot_map_should_keep_values_dense, "slot_map should keep values dense");
+    test_manager_register_test(slot_map_benchmark, "slot_map churn benchmark against a linear slot scan");
+}
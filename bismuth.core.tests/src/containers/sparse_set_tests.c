@@ -0,0 +1,149 @@
+#include "sparse_set_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/sparse_set.h>
+#include <memory/bmemory.h>
+#include <time/bclock.h>
+
+u8 sparse_set_should_insert_remove_and_contain(void)
+{
+    sparse_set set;
+    expect_to_be_true(sparse_set_create(100, &set));
+    expect_should_be(0, set.count);
+    expect_to_be_false(sparse_set_contains(&set, 0));
+
+    expect_to_be_true(sparse_set_insert(&set, 10));
+    expect_to_be_true(sparse_set_insert(&set, 0));
+    expect_to_be_true(sparse_set_insert(&set, 99));
+    // Already a member
+    expect_to_be_false(sparse_set_insert(&set, 10));
+    expect_should_be(3, set.count);
+
+    BDEBUG("Note: The following error is intentionally caused by this test");
+    expect_to_be_false(sparse_set_insert(&set, 100));
+    expect_to_be_false(sparse_set_contains(&set, 100));
+
+    expect_to_be_true(sparse_set_contains(&set, 0));
+    expect_to_be_true(sparse_set_contains(&set, 10));
+    expect_to_be_true(sparse_set_contains(&set, 99));
+    expect_to_be_false(sparse_set_contains(&set, 50));
+
+    // Members are packed in insertion order until something is removed
+    expect_should_be(10, set.dense[0]);
+    expect_should_be(0, set.dense[1]);
+    expect_should_be(99, set.dense[2]);
+
+    // The last member fills the gap
+    expect_to_be_true(sparse_set_remove(&set, 10));
+    expect_to_be_false(sparse_set_remove(&set, 10));
+    expect_to_be_false(sparse_set_contains(&set, 10));
+    expect_should_be(2, set.count);
+    expect_should_be(99, set.dense[0]);
+    expect_should_be(0, set.dense[1]);
+    expect_to_be_true(sparse_set_contains(&set, 99));
+
+    // Clearing is O(1), and stale entries aren't mistaken for members
+    sparse_set_clear(&set);
+    expect_should_be(0, set.count);
+    expect_to_be_false(sparse_set_contains(&set, 0));
+    expect_to_be_false(sparse_set_contains(&set, 99));
+    expect_to_be_true(sparse_set_insert(&set, 99));
+    expect_to_be_false(sparse_set_contains(&set, 0));
+
+    sparse_set_destroy(&set);
+    expect_should_be(0, set.universe);
+    return true;
+}
+
+u8 sparse_set_should_resize(void)
+{
+    sparse_set set = {0};
+    expect_to_be_false(sparse_set_contains(&set, 0));
+
+    expect_to_be_true(sparse_set_resize(&set, 16));
+    for (u32 i = 0; i < 16; i += 2)
+        sparse_set_insert(&set, i);
+    expect_should_be(8, set.count);
+
+    // Growing keeps members
+    expect_to_be_true(sparse_set_resize(&set, 1000));
+    for (u32 i = 0; i < 16; ++i)
+    {
+        b8 expected = (i % 2) == 0;
+        expect_should_be(expected, sparse_set_contains(&set, i));
+    }
+    expect_to_be_true(sparse_set_insert(&set, 999));
+
+    // Shrinking drops members which no longer fit
+    expect_to_be_true(sparse_set_resize(&set, 7));
+    expect_should_be(4, set.count);
+    for (u32 i = 0; i < set.count; ++i)
+        expect_to_be_true(set.dense[i] < 7);
+    expect_to_be_true(sparse_set_contains(&set, 6));
+    expect_to_be_false(sparse_set_contains(&set, 8));
+
+    sparse_set_destroy(&set);
+    return true;
+}
+
+u8 sparse_set_benchmark(void)
+{
+    // Marking entries dirty, with repeats, as a transform system does when objects move every frame
+    const u32 universe = 20000;
+    const u32 mark_count = 200000;
+    bclock clock;
+
+    // A plain array checked for duplicates before every add, as the xform dirty list did before
+    u32* list = ballocate(sizeof(u32) * universe, MEMORY_TAG_ARRAY);
+    u32 list_count = 0;
+    u32 seed = 7;
+    bclock_start(&clock);
+    for (u32 i = 0; i < mark_count; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        u32 value = (seed >> 8) % universe;
+        b8 found = false;
+        for (u32 j = 0; j < list_count; ++j)
+        {
+            if (list[j] == value)
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            list[list_count++] = value;
+    }
+    bclock_update(&clock);
+    f64 scan_time = clock.elapsed;
+    bfree(list, sizeof(u32) * universe, MEMORY_TAG_ARRAY);
+
+    sparse_set set;
+    sparse_set_create(universe, &set);
+    seed = 7;
+    bclock_start(&clock);
+    for (u32 i = 0; i < mark_count; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        sparse_set_insert(&set, (seed >> 8) % universe);
+    }
+    bclock_update(&clock);
+    f64 set_time = clock.elapsed;
+
+    BINFO("sparse_set: %u marks over %u entries (%u unique): linear duplicate check %.2fms, sparse_set %.2fms",
+          mark_count, universe, set.count, scan_time * 1000.0, set_time * 1000.0);
+
+    expect_should_be(list_count, set.count);
+    sparse_set_destroy(&set);
+    return true;
+}
+
+void sparse_set_register_tests(void)
+{
+    test_manager_register_test(sparse_set_should_insert_remove_and_contain, "sparse_set should insert, remove and contain values");
+    test_manager_register_test(sparse_set_should_resize, "sparse_set should keep members when resized");
+    test_manager_register_test(sparse_set_benchmark, "sparse_set benchmark against a linear duplicate check");
+}
@@ -0,0 +1,342 @@
+#include "u64_btree_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/u64_btree.h>
+#include <memory/bmemory.h>
+#include <time/bclock.h>
+
+// Walks the whole tree, checking keys come back in strictly increasing order. Returns the number of entries seen
+static u32 entries_in_order(const u64_btree* tree, b8* out_ordered)
+{
+    u64_btree_iterator it = u64_btree_range(tree, 0, U64_MAX);
+    u64 key = 0;
+    u64 previous = 0;
+    u32 seen = 0;
+    *out_ordered = true;
+    while (u64_btree_iterator_next(&it, &key, 0))
+    {
+        if (seen && key <= previous)
+            *out_ordered = false;
+        previous = key;
+        seen++;
+    }
+    return seen;
+}
+
+u8 u64_btree_should_insert_and_find(void)
+{
+    u64_btree tree = {0};
+    expect_should_be(0, u64_btree_find(&tree, 5));
+
+    bt_node_value value = {.u64 = 23};
+    expect_to_be_true(u64_btree_insert(&tree, 5, value));
+    value.u64 = 42;
+    expect_to_be_true(u64_btree_insert(&tree, 0, value));
+    expect_should_be(2, tree.count);
+    expect_should_be(1, tree.height);
+
+    const bt_node_value* found = u64_btree_find(&tree, 5);
+    expect_should_not_be(0, found);
+    expect_should_be(23, found->u64);
+    // Key 0 is a valid key like any other
+    found = u64_btree_find(&tree, 0);
+    expect_should_not_be(0, found);
+    expect_should_be(42, found->u64);
+    expect_should_be(0, u64_btree_find(&tree, 6));
+
+    // Inserting an existing key leaves the original value
+    value.u64 = 99;
+    expect_to_be_false(u64_btree_insert(&tree, 5, value));
+    expect_should_be(23, u64_btree_find(&tree, 5)->u64);
+    expect_should_be(2, tree.count);
+
+    u64_btree_cleanup(&tree);
+    expect_should_be(0, tree.root);
+    expect_should_be(0, tree.count);
+    expect_should_be(0, tree.height);
+    return true;
+}
+
+u8 u64_btree_should_stay_balanced(void)
+{
+    const u32 count = 100000;
+    u64_btree tree = {0};
+
+    // Increasing keys are the worst case for an unbalanced tree
+    for (u64 i = 0; i < count; ++i)
+    {
+        bt_node_value value = {.u64 = i * 3};
+        u64_btree_insert(&tree, i, value);
+    }
+    expect_should_be(count, tree.count);
+    // 100000 entries at no fewer than 16 children per level fit in five levels
+    expect_to_be_true(tree.height <= 5);
+
+    for (u64 i = 0; i < count; ++i)
+    {
+        const bt_node_value* found = u64_btree_find(&tree, i);
+        if (!found || found->u64 != i * 3)
+        {
+            BERROR("Lookup of key %llu failed", i);
+            return false;
+        }
+    }
+    u64_btree_cleanup(&tree);
+
+    // And decreasing keys
+    for (u64 i = count; i > 0; --i)
+    {
+        bt_node_value value = {.u64 = i};
+        u64_btree_insert(&tree, i, value);
+    }
+    expect_should_be(count, tree.count);
+    expect_to_be_true(tree.height <= 5);
+    b8 ordered;
+    expect_should_be(count, entries_in_order(&tree, &ordered));
+    expect_to_be_true(ordered);
+    u64_btree_cleanup(&tree);
+
+    return true;
+}
+
+u8 u64_btree_should_delete(void)
+{
+    const u32 count = 5000;
+    u64_btree tree = {0};
+    u64* keys = ballocate(sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < count; ++i)
+    {
+        keys[i] = ((u64)i * 0x9E3779B97F4A7C15ULL) | 1;
+        bt_node_value value = {.u64 = i};
+        u64_btree_insert(&tree, keys[i], value);
+    }
+    expect_should_be(count, tree.count);
+
+    expect_to_be_false(u64_btree_delete(&tree, 2, 0));
+
+    // Delete every other entry, in insertion (effectively random) order
+    for (u32 i = 0; i < count; i += 2)
+    {
+        bt_node_value deleted = {0};
+        expect_to_be_true(u64_btree_delete(&tree, keys[i], &deleted));
+        expect_should_be(i, deleted.u64);
+        expect_to_be_false(u64_btree_delete(&tree, keys[i], 0));
+    }
+    expect_should_be(count / 2, tree.count);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const bt_node_value* found = u64_btree_find(&tree, keys[i]);
+        if ((i % 2) ? (!found || found->u64 != i) : (found != 0))
+        {
+            BERROR("Lookup of entry %u gave the wrong result after deletion", i);
+            return false;
+        }
+    }
+    b8 ordered;
+    expect_should_be(count / 2, entries_in_order(&tree, &ordered));
+    expect_to_be_true(ordered);
+
+    // Delete the rest, which should leave nothing behind
+    for (u32 i = 1; i < count; i += 2)
+        expect_to_be_true(u64_btree_delete(&tree, keys[i], 0));
+    expect_should_be(0, tree.count);
+    expect_should_be(0, tree.root);
+    expect_should_be(0, tree.height);
+
+    // Still usable afterwards
+    bt_node_value value = {.u64 = 7};
+    expect_to_be_true(u64_btree_insert(&tree, 7, value));
+    expect_should_be(7, u64_btree_find(&tree, 7)->u64);
+    u64_btree_cleanup(&tree);
+
+    bfree(keys, sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 u64_btree_should_iterate_range(void)
+{
+    u64_btree tree = {0};
+    // Keys 10, 20, ... 10000
+    for (u64 i = 1000; i > 0; --i)
+    {
+        bt_node_value value = {.u64 = i};
+        u64_btree_insert(&tree, i * 10, value);
+    }
+
+    // Bounds are inclusive, and need not be keys themselves
+    u64_btree_iterator it = u64_btree_range(&tree, 95, 200);
+    u64 key = 0;
+    bt_node_value value = {0};
+    u64 expected = 100;
+    while (u64_btree_iterator_next(&it, &key, &value))
+    {
+        expect_should_be(expected, key);
+        expect_should_be(expected / 10, value.u64);
+        expected += 10;
+    }
+    expect_should_be(210, expected);
+
+    // Empty ranges
+    it = u64_btree_range(&tree, 11, 19);
+    expect_to_be_false(u64_btree_iterator_next(&it, 0, 0));
+    it = u64_btree_range(&tree, 10001, U64_MAX);
+    expect_to_be_false(u64_btree_iterator_next(&it, 0, 0));
+    it = u64_btree_range(&tree, 500, 400);
+    expect_to_be_false(u64_btree_iterator_next(&it, 0, 0));
+
+    // The whole tree
+    b8 ordered;
+    expect_should_be(1000, entries_in_order(&tree, &ordered));
+    expect_to_be_true(ordered);
+
+    u64_btree_cleanup(&tree);
+
+    // An empty tree has nothing to iterate
+    it = u64_btree_range(&tree, 0, U64_MAX);
+    expect_to_be_false(u64_btree_iterator_next(&it, 0, 0));
+    return true;
+}
+
+u8 u64_btree_should_build(void)
+{
+    const u32 counts[] = {1, 31, 32, 100, 1000, 40000};
+    for (u32 c = 0; c < 6; ++c)
+    {
+        u32 count = counts[c];
+        u64* keys = ballocate(sizeof(u64) * count, MEMORY_TAG_ARRAY);
+        bt_node_value* values = ballocate(sizeof(bt_node_value) * count, MEMORY_TAG_ARRAY);
+        for (u32 i = 0; i < count; ++i)
+        {
+            keys[i] = (u64)i * 2;
+            values[i].u64 = i;
+        }
+
+        u64_btree tree = {0};
+        expect_to_be_true(u64_btree_build(&tree, count, keys, values));
+        expect_should_be(count, tree.count);
+        b8 ordered;
+        expect_should_be(count, entries_in_order(&tree, &ordered));
+        expect_to_be_true(ordered);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            const bt_node_value* found = u64_btree_find(&tree, keys[i]);
+            if (!found || found->u64 != i || u64_btree_find(&tree, keys[i] + 1))
+            {
+                BERROR("Lookup of entry %u gave the wrong result after building %u entries", i, count);
+                return false;
+            }
+        }
+
+        // A built tree can be changed like any other. Delete the first half and insert the odd keys between
+        for (u32 i = 0; i < count / 2; ++i)
+            expect_to_be_true(u64_btree_delete(&tree, keys[i], 0));
+        for (u32 i = 0; i < count; ++i)
+        {
+            bt_node_value value = {.u64 = i};
+            expect_to_be_true(u64_btree_insert(&tree, keys[i] + 1, value));
+        }
+        expect_should_be(count + (count - count / 2), tree.count);
+        expect_should_be(tree.count, entries_in_order(&tree, &ordered));
+        expect_to_be_true(ordered);
+
+        u64_btree_cleanup(&tree);
+        bfree(keys, sizeof(u64) * count, MEMORY_TAG_ARRAY);
+        bfree(values, sizeof(bt_node_value) * count, MEMORY_TAG_ARRAY);
+    }
+
+    // Keys out of order are rejected
+    u64 bad_keys[3] = {1, 3, 3};
+    bt_node_value bad_values[3] = {0};
+    u64_btree tree = {0};
+    BDEBUG("Note: The following error is intentionally caused by this test");
+    expect_to_be_false(u64_btree_build(&tree, 3, bad_keys, bad_values));
+    expect_should_be(0, tree.root);
+
+    return true;
+}
+
+u8 u64_btree_benchmark(void)
+{
+    const u32 count = 200000;
+    u64* keys = ballocate(sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    bt_node_value* values = ballocate(sizeof(bt_node_value) * count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < count; ++i)
+        values[i].u64 = i;
+    bclock clock;
+
+    // Three orders: increasing and decreasing (which turn an unbalanced BST into a list), and scattered
+    const char* order_names[3] = {"increasing", "decreasing", "scattered"};
+    for (u32 order = 0; order < 3; ++order)
+    {
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (order == 0)
+                keys[i] = i;
+            else if (order == 1)
+                keys[i] = count - i;
+            else
+                keys[i] = (u64)i * 0x9E3779B97F4A7C15ULL;
+        }
+
+        u64_btree tree = {0};
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            u64_btree_insert(&tree, keys[i], values[i]);
+        bclock_update(&clock);
+        f64 insert_time = clock.elapsed;
+
+        u64 sum = 0;
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            sum += u64_btree_find(&tree, keys[i])->u64;
+        bclock_update(&clock);
+        f64 find_time = clock.elapsed;
+        expect_should_be(((u64)count * (count - 1)) / 2, sum);
+
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            u64_btree_delete(&tree, keys[i], 0);
+        bclock_update(&clock);
+        f64 delete_time = clock.elapsed;
+        expect_should_be(0, tree.count);
+
+        BINFO("u64_btree x%u %s keys: insert %.3fms, find %.3fms, delete %.3fms", count, order_names[order], insert_time * 1000.0, find_time * 1000.0, delete_time * 1000.0);
+    }
+
+    // Bulk building from keys which are already sorted
+    for (u32 i = 0; i < count; ++i)
+        keys[i] = i;
+    u64_btree tree = {0};
+    bclock_start(&clock);
+    u64_btree_build(&tree, count, keys, values);
+    bclock_update(&clock);
+    f64 build_time = clock.elapsed;
+    u32 built_height = tree.height;
+    u64_btree_cleanup(&tree);
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        u64_btree_insert(&tree, keys[i], values[i]);
+    bclock_update(&clock);
+    BINFO("u64_btree x%u sorted keys: build %.3fms (height %u), insert one at a time %.3fms (height %u)", count, build_time * 1000.0, built_height, clock.elapsed * 1000.0, tree.height);
+    u64_btree_cleanup(&tree);
+
+    bfree(keys, sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    bfree(values, sizeof(bt_node_value) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void u64_btree_register_tests(void)
+{
+    test_manager_register_test(u64_btree_should_insert_and_find, "u64 btree should insert and find");
+    test_manager_register_test(u64_btree_should_stay_balanced, "u64 btree should stay balanced with ordered keys");
+    test_manager_register_test(u64_btree_should_delete, "u64 btree should delete");
+    test_manager_register_test(u64_btree_should_iterate_range, "u64 btree should iterate ranges in order");
+    test_manager_register_test(u64_btree_should_build, "u64 btree should build from sorted entries");
+    test_manager_register_test(u64_btree_benchmark, "u64 btree degenerate input benchmark");
+}
@@ -0,0 +1,333 @@
+#include "u64_hashtable_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/hashtable.h>
+#include <containers/u64_hashtable.h>
+#include <memory/bmemory.h>
+#include <strings/bstring.h>
+#include <time/bclock.h>
+#include <utils/crc64.h>
+
+u8 u64_hashtable_should_create_and_destroy(void)
+{
+    u64_hashtable table;
+    expect_to_be_true(u64_hashtable_create(sizeof(u64), 0, &table));
+    expect_should_not_be(0, table.keys);
+    expect_should_be(sizeof(u64), table.element_size);
+    expect_should_be(0, table.count);
+    // Always a power of two
+    expect_should_be(0, (table.capacity & (table.capacity - 1)));
+
+    u64_hashtable_destroy(&table);
+    expect_should_be(0, table.keys);
+    expect_should_be(0, table.capacity);
+
+    expect_to_be_false(u64_hashtable_create(0, 0, &table));
+    return true;
+}
+
+u8 u64_hashtable_should_set_get_and_overwrite(void)
+{
+    u64_hashtable table;
+    u64_hashtable_create(sizeof(u64), 0, &table);
+
+    u64 value = 23;
+    expect_to_be_true(u64_hashtable_set(&table, 0xDEADBEEFULL, &value));
+    value = 42;
+    // Key 0 is a valid key like any other
+    expect_to_be_true(u64_hashtable_set(&table, 0, &value));
+    expect_should_be(2, table.count);
+
+    u64 out_value = 0;
+    expect_to_be_true(u64_hashtable_get(&table, 0xDEADBEEFULL, &out_value));
+    expect_should_be(23, out_value);
+    expect_to_be_true(u64_hashtable_get(&table, 0, &out_value));
+    expect_should_be(42, out_value);
+    expect_to_be_false(u64_hashtable_get(&table, 12345, &out_value));
+    expect_to_be_false(u64_hashtable_contains(&table, 12345));
+
+    // Setting an existing key replaces its value
+    value = 99;
+    expect_to_be_true(u64_hashtable_set(&table, 0xDEADBEEFULL, &value));
+    expect_should_be(2, table.count);
+    u64* stored = u64_hashtable_get_ptr(&table, 0xDEADBEEFULL);
+    expect_should_not_be(0, stored);
+    expect_should_be(99, *stored);
+    // Modified in place
+    *stored = 100;
+    expect_to_be_true(u64_hashtable_get(&table, 0xDEADBEEFULL, &out_value));
+    expect_should_be(100, out_value);
+
+    u64_hashtable_destroy(&table);
+    return true;
+}
+
+u8 u64_hashtable_should_grow(void)
+{
+    u64_hashtable table;
+    u64_hashtable_create(sizeof(u32), 0, &table);
+    u32 initial_capacity = table.capacity;
+
+    // Sequential keys, like ids
+    const u32 count = 20000;
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 value = i * 3;
+        expect_to_be_true(u64_hashtable_set(&table, i, &value));
+    }
+    expect_should_be(count, table.count);
+    expect_to_be_true((table.capacity > initial_capacity));
+    // Never more than 7/8 full
+    expect_to_be_true(((u64)table.count * 8 <= (u64)table.capacity * 7));
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 value = 0;
+        expect_to_be_true(u64_hashtable_get(&table, i, &value));
+        expect_should_be(i * 3, value);
+    }
+
+    // Reserving less than is already there does nothing
+    u32 capacity = table.capacity;
+    expect_to_be_true(u64_hashtable_reserve(&table, 10));
+    expect_should_be(capacity, table.capacity);
+    expect_to_be_true(u64_hashtable_fits(&table, count));
+    expect_to_be_false(u64_hashtable_fits(&table, capacity));
+    expect_to_be_true(u64_hashtable_reserve(&table, capacity * 2));
+    expect_to_be_true((table.capacity > capacity));
+    expect_to_be_true(u64_hashtable_fits(&table, capacity));
+    expect_should_be(count, table.count);
+    u32 value = 0;
+    expect_to_be_true(u64_hashtable_get(&table, count - 1, &value));
+    expect_should_be((count - 1) * 3, value);
+
+    u64_hashtable_destroy(&table);
+    return true;
+}
+
+u8 u64_hashtable_should_remove_without_tombstones(void)
+{
+    u64_hashtable table;
+    u64_hashtable_create(sizeof(u64), 0, &table);
+
+    const u32 count = 5000;
+    for (u64 i = 0; i < count; ++i)
+    {
+        u64 key = crc64(0, (const u8*)&i, sizeof(u64));
+        u64_hashtable_set(&table, key, &i);
+    }
+
+    // Remove every other entry
+    for (u64 i = 0; i < count; i += 2)
+    {
+        u64 key = crc64(0, (const u8*)&i, sizeof(u64));
+        expect_to_be_true(u64_hashtable_remove(&table, key));
+        expect_to_be_false(u64_hashtable_remove(&table, key));
+    }
+    expect_should_be(count / 2, table.count);
+
+    // Everything left is still reachable, and every removed slot really is empty again
+    u32 occupied = 0;
+    for (u32 i = 0; i < table.capacity; ++i)
+    {
+        if (table.distances[i])
+            occupied++;
+    }
+    expect_should_be(count / 2, occupied);
+    for (u64 i = 0; i < count; ++i)
+    {
+        u64 key = crc64(0, (const u8*)&i, sizeof(u64));
+        u64 value = 0;
+        if (i % 2)
+        {
+            expect_to_be_true(u64_hashtable_get(&table, key, &value));
+            expect_should_be(i, value);
+        }
+        else
+        {
+            expect_to_be_false(u64_hashtable_contains(&table, key));
+        }
+    }
+
+    u64_hashtable_clear(&table);
+    expect_should_be(0, table.count);
+    u64 key = crc64(0, (const u8*)&occupied, sizeof(u32));
+    expect_to_be_false(u64_hashtable_contains(&table, key));
+
+    u64_hashtable_destroy(&table);
+    return true;
+}
+
+u8 u64_hashtable_should_iterate(void)
+{
+    u64_hashtable table;
+    u64_hashtable_create(sizeof(u32), 0, &table);
+
+    u64 key_sum = 0;
+    u64 value_sum = 0;
+    for (u32 i = 1; i <= 100; ++i)
+    {
+        u32 value = i * 2;
+        u64_hashtable_set(&table, i * 1000, &value);
+        key_sum += i * 1000;
+        value_sum += value;
+    }
+
+    u32 iterator = 0;
+    u64 key = 0;
+    void* value = 0;
+    u32 visited = 0;
+    while (u64_hashtable_iterate(&table, &iterator, &key, &value))
+    {
+        key_sum -= key;
+        value_sum -= *(u32*)value;
+        visited++;
+    }
+    expect_should_be(100, visited);
+    expect_should_be(0, key_sum);
+    expect_should_be(0, value_sum);
+
+    u64_hashtable_destroy(&table);
+    return true;
+}
+
+u8 u64_hashtable_should_match_reference(void)
+{
+    // Random sets and removes over a small key range, checked against a plain array
+    const u32 key_range = 2048;
+    u32* reference = ballocate(sizeof(u32) * key_range, MEMORY_TAG_ARRAY);
+    u64_hashtable table;
+    u64_hashtable_create(sizeof(u32), 0, &table);
+
+    u32 present = 0;
+    u64 state = 0x12345678ULL;
+    for (u32 i = 0; i < 100000; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        u32 key = (u32)(state >> 33) % key_range;
+        if ((state >> 20) & 3)
+        {
+            u32 value = i + 1;
+            u64_hashtable_set(&table, key, &value);
+            if (!reference[key])
+                present++;
+            reference[key] = value;
+        }
+        else
+        {
+            b8 removed = u64_hashtable_remove(&table, key);
+            expect_should_be((reference[key] != 0), removed);
+            if (reference[key])
+                present--;
+            reference[key] = 0;
+        }
+    }
+
+    expect_should_be(present, table.count);
+    for (u32 key = 0; key < key_range; ++key)
+    {
+        u32 value = 0;
+        b8 found = u64_hashtable_get(&table, key, &value);
+        expect_should_be((reference[key] != 0), found);
+        if (found)
+            expect_should_be(reference[key], value);
+    }
+
+    u64_hashtable_destroy(&table);
+    bfree(reference, sizeof(u32) * key_range, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 u64_hashtable_benchmark(void)
+{
+    const u32 count = 20000;
+    char** names = ballocate(sizeof(char*) * count, MEMORY_TAG_ARRAY);
+    u64* keys = ballocate(sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < count; ++i)
+    {
+        names[i] = string_format("entity_%u", i);
+        // What a bname of the same string would hold
+        keys[i] = crc64(0, (const u8*)names[i], string_length(names[i]));
+    }
+    bclock clock;
+
+    // Existing string-keyed table, given twice the room it needs
+    hashtable old_table;
+    u32 old_count = count * 2;
+    void* old_memory = ballocate(sizeof(u64) * old_count, MEMORY_TAG_ARRAY);
+    hashtable_create(sizeof(u64), old_count, old_memory, false, &old_table);
+    bclock_start(&clock);
+    for (u64 i = 0; i < count; ++i)
+        hashtable_set(&old_table, names[i], &i);
+    bclock_update(&clock);
+    f64 old_insert_time = clock.elapsed;
+
+    u32 old_wrong = 0;
+    bclock_start(&clock);
+    for (u64 i = 0; i < count; ++i)
+    {
+        u64 value = 0;
+        hashtable_get(&old_table, names[i], &value);
+        if (value != i)
+            old_wrong++;
+    }
+    bclock_update(&clock);
+    f64 old_lookup_time = clock.elapsed;
+    hashtable_destroy(&old_table);
+    bfree(old_memory, sizeof(u64) * old_count, MEMORY_TAG_ARRAY);
+
+    // New table, growing from empty
+    u64_hashtable new_table;
+    u64_hashtable_create(sizeof(u64), 0, &new_table);
+    bclock_start(&clock);
+    for (u64 i = 0; i < count; ++i)
+        u64_hashtable_set(&new_table, keys[i], &i);
+    bclock_update(&clock);
+    f64 new_insert_time = clock.elapsed;
+
+    u32 new_wrong = 0;
+    bclock_start(&clock);
+    for (u64 i = 0; i < count; ++i)
+    {
+        u64 value = 0;
+        u64_hashtable_get(&new_table, keys[i], &value);
+        if (value != i)
+            new_wrong++;
+    }
+    bclock_update(&clock);
+    f64 new_lookup_time = clock.elapsed;
+    u64_hashtable_destroy(&new_table);
+
+    // Same again with room made up front, which leaves out the cost of growing
+    u64_hashtable_create(sizeof(u64), count, &new_table);
+    bclock_start(&clock);
+    for (u64 i = 0; i < count; ++i)
+        u64_hashtable_set(&new_table, keys[i], &i);
+    bclock_update(&clock);
+    f64 reserved_insert_time = clock.elapsed;
+    u64_hashtable_destroy(&new_table);
+
+    BINFO("%u entries: hashtable insert %.3fms, lookup %.3fms (%u lost to collisions)", count, old_insert_time * 1000.0, old_lookup_time * 1000.0, old_wrong);
+    BINFO("%u entries: u64_hashtable insert %.3fms (%.3fms reserved), lookup %.3fms (%u lost to collisions)", count, new_insert_time * 1000.0, reserved_insert_time * 1000.0, new_lookup_time * 1000.0, new_wrong);
+    expect_should_be(0, new_wrong);
+
+    for (u32 i = 0; i < count; ++i)
+        string_free(names[i]);
+    bfree(names, sizeof(char*) * count, MEMORY_TAG_ARRAY);
+    bfree(keys, sizeof(u64) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void u64_hashtable_register_tests(void)
+{
+    test_manager_register_test(u64_hashtable_should_create_and_destroy, "u64 hashtable should create and destroy");
+    test_manager_register_test(u64_hashtable_should_set_get_and_overwrite, "u64 hashtable should set, get and overwrite");
+    test_manager_register_test(u64_hashtable_should_grow, "u64 hashtable should grow as entries are added");
+    test_manager_register_test(u64_hashtable_should_remove_without_tombstones, "u64 hashtable should remove entries without tombstones");
+    test_manager_register_test(u64_hashtable_should_iterate, "u64 hashtable should iterate all entries");
+    test_manager_register_test(u64_hashtable_should_match_reference, "u64 hashtable should match a reference under random sets and removes");
+    test_manager_register_test(u64_hashtable_benchmark, "u64 hashtable vs hashtable insert/lookup benchmark");
+}
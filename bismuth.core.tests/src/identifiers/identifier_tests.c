@@ -0,0 +1,181 @@
+#include "identifier_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <identifiers/identifier.h>
+#include <math/mtwister.h>
+#include <memory/bmemory.h>
+#include <platform/platform.h>
+#include <threads/batomic.h>
+#include <threads/bthread.h>
+#include <time/bclock.h>
+#include <utils/bsort.h>
+
+#define IDENTIFIER_TEST_MAX_THREADS 8
+
+typedef struct identifier_thread_params
+{
+    u32 id_count;
+    // Where to write the created ids. Optional; if not provided the ids are only summed, for benchmarking
+    u64* out_ids;
+    u64 sum;
+    volatile u32* ready_count;
+    u32 thread_count;
+} identifier_thread_params;
+
+static u32 identifier_thread_run(void* params)
+{
+    identifier_thread_params* typed = params;
+
+    // Start together, to make contention likely
+    batomic_fetch_add_u32(typed->ready_count, 1);
+    while (batomic_load_u32(typed->ready_count) < typed->thread_count)
+        platform_sleep(0);
+
+    if (typed->out_ids)
+    {
+        for (u32 i = 0; i < typed->id_count; ++i)
+            typed->out_ids[i] = identifier_create().uniqueid;
+    }
+    else
+    {
+        u64 sum = 0;
+        for (u32 i = 0; i < typed->id_count; ++i)
+            sum += identifier_create().uniqueid;
+        typed->sum = sum;
+    }
+    return 1;
+}
+
+// Runs thread_count threads each creating id_count ids. Returns false if a thread could not be created
+static b8 identifier_threads_run(u32 thread_count, u32 id_count, u64* out_ids)
+{
+    volatile u32 ready_count = 0;
+    identifier_thread_params params[IDENTIFIER_TEST_MAX_THREADS] = {0};
+    bthread threads[IDENTIFIER_TEST_MAX_THREADS];
+    b8 result = true;
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        params[i].id_count = id_count;
+        params[i].out_ids = out_ids ? out_ids + (u64)i * id_count : 0;
+        params[i].ready_count = &ready_count;
+        params[i].thread_count = thread_count;
+        if (!bthread_create(identifier_thread_run, &params[i], false, &threads[i]))
+        {
+            // Let the threads already started get going, so they can finish
+            batomic_store_u32(&ready_count, thread_count);
+            thread_count = i;
+            result = false;
+            break;
+        }
+    }
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        bthread_wait(&threads[i]);
+        bthread_destroy(&threads[i]);
+    }
+    return result;
+}
+
+u8 identifier_should_be_unique_and_valid(void)
+{
+    const u32 count = 100000;
+    bsort_key_u64* keys = ballocate(sizeof(bsort_key_u64) * count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < count; ++i)
+    {
+        keys[i].key = identifier_create().uniqueid;
+        keys[i].index = i;
+    }
+
+    bradix_sort_u64(keys, count, 0);
+    b8 unique = true;
+    for (u32 i = 1; i < count && unique; ++i)
+        unique = keys[i].key != keys[i - 1].key;
+    b8 valid = keys[0].key != 0 && keys[count - 1].key != INVALID_ID_U64;
+
+    // Ids should look random, not count upwards: roughly half of the bits differ between consecutive ids
+    u64 total_changed = 0;
+    u64 previous = identifier_create().uniqueid;
+    for (u32 i = 0; i < 1000; ++i)
+    {
+        u64 next = identifier_create().uniqueid;
+        total_changed += __builtin_popcountll(previous ^ next);
+        previous = next;
+    }
+    f64 average_changed = (f64)total_changed / 1000;
+
+    bfree(keys, sizeof(bsort_key_u64) * count, MEMORY_TAG_ARRAY);
+    expect_to_be_true(unique);
+    expect_to_be_true(valid);
+    expect_to_be_true((average_changed > 28.0));
+    expect_to_be_true((average_changed < 36.0));
+
+    identifier a = identifier_from_u64(1234);
+    expect_to_be_true(identifiers_equal(a, identifier_from_u64(1234)));
+    expect_to_be_false(identifiers_equal(a, identifier_from_u64(4321)));
+
+    return true;
+}
+
+u8 identifier_should_be_unique_across_threads(void)
+{
+    const u32 thread_count = IDENTIFIER_TEST_MAX_THREADS;
+    const u32 id_count = 50000;
+    const u32 total = thread_count * id_count;
+    u64* ids = ballocate(sizeof(u64) * total, MEMORY_TAG_ARRAY);
+    bsort_key_u64* keys = ballocate(sizeof(bsort_key_u64) * total, MEMORY_TAG_ARRAY);
+
+    b8 started = identifier_threads_run(thread_count, id_count, ids);
+
+    for (u32 i = 0; i < total; ++i)
+    {
+        keys[i].key = ids[i];
+        keys[i].index = i;
+    }
+    bradix_sort_u64(keys, total, 0);
+    b8 unique = true;
+    for (u32 i = 1; i < total && unique; ++i)
+        unique = keys[i].key != keys[i - 1].key;
+
+    bfree(keys, sizeof(bsort_key_u64) * total, MEMORY_TAG_ARRAY);
+    bfree(ids, sizeof(u64) * total, MEMORY_TAG_ARRAY);
+    expect_to_be_true(started);
+    expect_to_be_true(unique);
+
+    return true;
+}
+
+u8 identifier_benchmark(void)
+{
+    const u32 id_count = 2000000;
+    bclock clock;
+
+    // The previous generator: one global Mersenne Twister, which was never safe to share between threads
+    mtrand_state generator = mtrand_create(1234);
+    u64 sum = 0;
+    bclock_start(&clock);
+    for (u32 i = 0; i < id_count; ++i)
+        sum += mtrand_generate(&generator);
+    bclock_update(&clock);
+    BINFO("identifier: global mtrand, 1 thread: %.1fM ids/s (%llu)", (id_count / clock.elapsed) / 1000000.0, sum & 1);
+
+    for (u32 thread_count = 1; thread_count <= IDENTIFIER_TEST_MAX_THREADS; thread_count *= 2)
+    {
+        bclock_start(&clock);
+        expect_to_be_true(identifier_threads_run(thread_count, id_count, 0));
+        bclock_update(&clock);
+        f64 total = (f64)id_count * thread_count;
+        BINFO("identifier: identifier_create, %u thread(s): %.1fM ids/s", thread_count, (total / clock.elapsed) / 1000000.0);
+    }
+
+    return true;
+}
+
+void identifier_register_tests(void)
+{
+    test_manager_register_test(identifier_should_be_unique_and_valid, "Identifiers should be unique, valid and well spread");
+    test_manager_register_test(identifier_should_be_unique_across_threads, "Identifiers should be unique across threads");
+    test_manager_register_test(identifier_benchmark, "Identifier creation throughput benchmark");
+}
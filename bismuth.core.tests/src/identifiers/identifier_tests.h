@@ -0,0 +1,3 @@
+#pragma once
+
+void identifier_register_tests(void);
@@ -1,15 +1,33 @@
 #include <logger.h>
 
 #include "containers/array_tests.h"
+#include "containers/bitset_tests.h"
+#include "containers/chunked_array_tests.h"
 #include "containers/darray_tests.h"
 #include "containers/freelist_tests.h"
 #include "containers/hashtable_tests.h"
 #include "containers/stackarray_tests.h"
+#include "containers/slot_map_tests.h"
+#include "containers/sparse_set_tests.h"
+#include "containers/u64_btree_tests.h"
+#include "containers/u64_hashtable_tests.h"
+#include "identifiers/identifier_tests.h"
 #include "memory/dynamic_allocator_tests.h"
+#include "memory/frame_scratch_tests.h"
 #include "memory/linear_allocator_tests.h"
+#include "memory/memory_stats_tests.h"
+#include "memory/small_allocator_tests.h"
+#include "parsers/bson_binary_tests.h"
 #include "parsers/bson_parser_tests.h"
+#include "strings/bname_tests.h"
+#include "strings/string_float_tests.h"
+#include "strings/string_format_tests.h"
+#include "strings/string_scan_tests.h"
 #include "strings/string_tests.h"
+#include "systems/job_system_tests.h"
 #include "test_manager.h"
+#include "utils/bsort_tests.h"
+#include "utils/hash_tests.h"
 
 int main(void)
 {
@@ -19,14 +37,32 @@ int main(void)
 
     // TODO: Add test registrations here
     string_register_tests();
+    bname_register_tests();
+    string_format_register_tests();
+    string_scan_register_tests();
+    string_float_register_tests();
     array_register_tests();
     darray_register_tests();
+    chunked_array_register_tests();
     stackarray_register_tests();
     bson_parser_register_tests();
+    bson_binary_register_tests();
     linear_allocator_register_tests();
     hashtable_register_tests();
+    u64_hashtable_register_tests();
+    u64_btree_register_tests();
+    slot_map_register_tests();
+    bitset_register_tests();
+    sparse_set_register_tests();
     freelist_register_tests();
     dynamic_allocator_register_tests();
+    small_allocator_register_tests();
+    frame_scratch_register_tests();
+    memory_stats_register_tests();
+    job_system_register_tests();
+    bsort_register_tests();
+    hash_register_tests();
+    identifier_register_tests();
     string_register_tests();
 
     BDEBUG("Starting tests...");
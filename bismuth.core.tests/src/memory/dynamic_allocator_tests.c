@@ -6,6 +6,7 @@
 
 #include <memory/allocators/dynamic_allocator.h>
 #include <memory/bmemory.h>
+#include <time/bclock.h>
 
 u8 dynamic_allocator_should_create_and_destroy(void)
 {
@@ -737,6 +738,133 @@ u8 dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random
     return true;
 }
 
+u8 dynamic_allocator_should_resize_in_place(void)
+{
+    dynamic_allocator alloc;
+    u64 memory_requirement = 0;
+    const u64 allocator_size = 4096;
+    expect_to_be_true(dynamic_allocator_create_mode(allocator_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, 0, 0));
+    void* memory = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    expect_to_be_true(dynamic_allocator_create_mode(allocator_size, FREELIST_MODE_SEGREGATED_FIT, &memory_requirement, memory, &alloc));
+
+    u8* block = dynamic_allocator_allocate_aligned(&alloc, 100, 16);
+    expect_should_not_be(0, block);
+    for (u32 i = 0; i < 100; ++i)
+        block[i] = (u8)i;
+    u64 free_after_first = dynamic_allocator_free_space(&alloc);
+
+    // Nothing after the block yet, so it should grow in place and keep its contents
+    expect_to_be_true(dynamic_allocator_resize_in_place(&alloc, block, 1000));
+    expect_should_be(free_after_first - 900, dynamic_allocator_free_space(&alloc));
+    u64 size = 0;
+    u16 alignment = 0;
+    expect_to_be_true(dynamic_allocator_get_size_alignment(&alloc, block, &size, &alignment));
+    expect_should_be(1000, size);
+    expect_should_be(16, alignment);
+    for (u32 i = 0; i < 100; ++i)
+        expect_should_be((u8)i, block[i]);
+
+    // Once something sits directly after it, growth has to fail and leave the block untouched
+    void* neighbour = dynamic_allocator_allocate(&alloc, 64);
+    expect_should_not_be(0, neighbour);
+    u64 free_before_fail = dynamic_allocator_free_space(&alloc);
+    expect_should_be(false, dynamic_allocator_resize_in_place(&alloc, block, 2000));
+    expect_should_be(free_before_fail, dynamic_allocator_free_space(&alloc));
+
+    // Shrinking always works and hands the tail back
+    expect_to_be_true(dynamic_allocator_resize_in_place(&alloc, block, 200));
+    expect_should_be(free_before_fail + 800, dynamic_allocator_free_space(&alloc));
+    expect_to_be_true(dynamic_allocator_get_size_alignment(&alloc, block, &size, &alignment));
+    expect_should_be(200, size);
+
+    expect_to_be_true(dynamic_allocator_free_aligned(&alloc, block));
+    expect_to_be_true(dynamic_allocator_free(&alloc, neighbour, 64));
+    expect_should_be(allocator_size, dynamic_allocator_free_space(&alloc));
+
+    dynamic_allocator_destroy(&alloc);
+    bfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 dynamic_allocator_growth_benchmark(void)
+{
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(256);
+    expect_to_be_true(memory_system_initialize(config));
+
+    const u32 rounds = 64;
+    const u64 final_size = MEBIBYTES(8);
+
+    // Baseline: what breallocate used to do, a fresh zeroed block plus a full copy each growth
+    u64 naive_copied = 0;
+    u64 naive_zeroed = 0;
+    bclock clock;
+    bclock_start(&clock);
+    for (u32 r = 0; r < rounds; ++r)
+    {
+        u64 size = 64;
+        void* block = ballocate(size, MEMORY_TAG_ARRAY);
+        while (size < final_size)
+        {
+            u64 new_size = size * 2;
+            void* new_block = ballocate(new_size, MEMORY_TAG_ARRAY);
+            bcopy_memory(new_block, block, size);
+            bfree(block, size, MEMORY_TAG_ARRAY);
+            naive_copied += size;
+            naive_zeroed += new_size;
+            block = new_block;
+            size = new_size;
+        }
+        bfree(block, size, MEMORY_TAG_ARRAY);
+    }
+    bclock_update(&clock);
+    f64 naive_time = clock.elapsed;
+
+    // breallocate, which grows in place when it can and otherwise only clears the new tail
+    u64 realloc_copied = 0;
+    u64 realloc_zeroed = 0;
+    u32 in_place = 0;
+    u32 growths = 0;
+    bclock_start(&clock);
+    for (u32 r = 0; r < rounds; ++r)
+    {
+        u64 size = 64;
+        u8* block = ballocate(size, MEMORY_TAG_ARRAY);
+        block[0] = 0xAB;
+        while (size < final_size)
+        {
+            u64 new_size = size * 2;
+            u8* new_block = breallocate(block, size, new_size, MEMORY_TAG_ARRAY);
+            growths++;
+            if (new_block == block)
+                in_place++;
+            else
+                realloc_copied += size;
+            realloc_zeroed += new_size - size;
+            block = new_block;
+            size = new_size;
+        }
+        expect_should_be(0xAB, block[0]);
+        expect_should_be(0, block[size - 1]);
+        bfree(block, size, MEMORY_TAG_ARRAY);
+    }
+    bclock_update(&clock);
+    f64 realloc_time = clock.elapsed;
+
+    BINFO("Growth to %lluB x%u: naive copied=%lluB zeroed=%lluB in %.3fms; breallocate copied=%lluB zeroed=%lluB in %.3fms (%u of %u in place)",
+          final_size, rounds, naive_copied, naive_zeroed, naive_time * 1000.0, realloc_copied, realloc_zeroed, realloc_time * 1000.0, in_place, growths);
+    expect_to_be_true((realloc_copied < naive_copied));
+    expect_to_be_true((realloc_zeroed < naive_zeroed));
+
+    // Uninitialized blocks come from the same place and free the same way
+    void* raw = ballocate_uninitialized(KIBIBYTES(64), MEMORY_TAG_ARRAY);
+    expect_should_not_be(0, raw);
+    bfree(raw, KIBIBYTES(64), MEMORY_TAG_ARRAY);
+
+    memory_system_shutdown();
+    return true;
+}
+
 void dynamic_allocator_register_tests(void)
 {
     test_manager_register_test(dynamic_allocator_should_create_and_destroy, "Dynamic allocator should create and destroy");
@@ -748,4 +876,6 @@ void dynamic_allocator_register_tests(void)
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments, "Dynamic allocator multiple aligned allocations with different alignments");
     test_manager_register_test(dynamic_allocator_multiple_alloc_aligned_different_alignments_random, "Dynamic allocator multiple aligned allocations with different alignments in random order");
     test_manager_register_test(dynamic_allocator_multiple_alloc_and_free_aligned_different_alignments_random, "Dynamic allocator randomization test");
+    test_manager_register_test(dynamic_allocator_should_resize_in_place, "Dynamic allocator should resize blocks in place");
+    test_manager_register_test(dynamic_allocator_growth_benchmark, "Dynamic allocator growth benchmark");
 }
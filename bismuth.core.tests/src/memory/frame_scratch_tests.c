@@ -0,0 +1,214 @@
+#include "frame_scratch_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <memory/frame_scratch.h>
+#include <platform/platform.h>
+#include <threads/batomic.h>
+#include <threads/bthread.h>
+#include <time/bclock.h>
+
+u8 frame_scratch_should_allocate_aligned(void)
+{
+    expect_to_be_true(frame_scratch_initialize(KIBIBYTES(4)));
+
+    u8* a = frame_scratch_allocate(3);
+    u8* b = frame_scratch_allocate(40);
+    u8* c = frame_scratch_allocate(1);
+    expect_should_not_be(0, a);
+    expect_should_not_be(0, b);
+    expect_should_not_be(0, c);
+    expect_should_be(0, ((u64)a % 16));
+    expect_should_be(0, ((u64)b % 16));
+    expect_should_be(0, ((u64)c % 16));
+    // Bump allocation, so blocks follow on from each other
+    expect_should_be(16, (u64)(b - a));
+    expect_should_be(48, (u64)(c - b));
+
+    // A zero size gets nothing
+    expect_should_be(0, frame_scratch_allocate(0));
+
+    frame_scratch_shutdown();
+    return true;
+}
+
+u8 frame_scratch_should_keep_previous_frame(void)
+{
+    expect_to_be_true(frame_scratch_initialize(KIBIBYTES(4)));
+
+    u32* first = frame_scratch_allocate(sizeof(u32));
+    *first = 1234;
+
+    // Next frame gets the other arena, so the first frame's data survives
+    frame_scratch_frame_advance();
+    u32* second = frame_scratch_allocate(sizeof(u32));
+    *second = 5678;
+    expect_should_not_be(first, second);
+    expect_should_be(1234, *first);
+
+    // The frame after that reuses the first arena from the start
+    frame_scratch_frame_advance();
+    u32* third = frame_scratch_allocate(sizeof(u32));
+    expect_should_be(first, third);
+    expect_should_be(5678, *second);
+
+    // Skipping frames entirely means both arenas are free again
+    frame_scratch_frame_advance();
+    frame_scratch_frame_advance();
+    frame_scratch_frame_advance();
+    u32* fourth = frame_scratch_allocate(sizeof(u32));
+    expect_to_be_true((fourth == first || fourth == second));
+
+    frame_scratch_shutdown();
+    return true;
+}
+
+u8 frame_scratch_should_fail_when_full(void)
+{
+    expect_to_be_true(frame_scratch_initialize(256));
+
+    expect_should_not_be(0, frame_scratch_allocate(200));
+    BDEBUG("The following error is intentionally caused by this test");
+    expect_should_be(0, frame_scratch_allocate(100));
+    expect_should_not_be(0, frame_scratch_allocate(48));
+
+    frame_scratch_thread_stats stats[4];
+    expect_should_be(1, frame_scratch_stats_get(4, stats));
+    expect_should_be(platform_current_thread_id(), stats[0].thread_id);
+    expect_should_be(256, stats[0].capacity);
+    expect_should_be(256, stats[0].high_water);
+    expect_should_be(1, stats[0].failed_allocations);
+
+    // The high-water mark carries across frames
+    frame_scratch_frame_advance();
+    expect_should_not_be(0, frame_scratch_allocate(16));
+    expect_should_be(1, frame_scratch_stats_get(4, stats));
+    expect_should_be(256, stats[0].high_water);
+
+    frame_scratch_shutdown();
+    return true;
+}
+
+typedef struct scratch_thread_params
+{
+    u32 allocation_count;
+    volatile u32* ready_count;
+    u32 thread_count;
+    void* first_block;
+    volatile b8 failed;
+} scratch_thread_params;
+
+static u32 scratch_thread_run(void* params)
+{
+    scratch_thread_params* typed = params;
+    u64* blocks[1000];
+    for (u32 i = 0; i < typed->allocation_count; ++i)
+    {
+        blocks[i] = frame_scratch_allocate(sizeof(u64));
+        if (!blocks[i])
+        {
+            typed->failed = true;
+            break;
+        }
+        *blocks[i] = i;
+    }
+    typed->first_block = blocks[0];
+
+    // Hold on to the arenas until every thread has allocated, so they are all in use at once
+    batomic_fetch_add_u32(typed->ready_count, 1);
+    while (batomic_load_u32(typed->ready_count) < typed->thread_count)
+        platform_sleep(0);
+
+    // Every thread's values should be untouched by the others
+    for (u32 i = 0; i < typed->allocation_count && !typed->failed; ++i)
+    {
+        if (*blocks[i] != i)
+            typed->failed = true;
+    }
+
+    frame_scratch_thread_release();
+    return 1;
+}
+
+u8 frame_scratch_threads_should_have_own_arenas(void)
+{
+    expect_to_be_true(frame_scratch_initialize(KIBIBYTES(64)));
+
+    const u32 thread_count = 4;
+    volatile u32 ready_count = 0;
+    scratch_thread_params params[4] = {0};
+    bthread threads[4];
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        params[i].allocation_count = 1000;
+        params[i].ready_count = &ready_count;
+        params[i].thread_count = thread_count;
+        expect_to_be_true(bthread_create(scratch_thread_run, &params[i], false, &threads[i]));
+    }
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        bthread_wait(&threads[i]);
+        bthread_destroy(&threads[i]);
+    }
+
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        expect_to_be_false(params[i].failed);
+        for (u32 k = i + 1; k < thread_count; ++k)
+            expect_should_not_be(params[i].first_block, params[k].first_block);
+    }
+
+    // Released threads no longer show up in stats
+    expect_should_be(0, frame_scratch_stats_get(0, 0));
+
+    frame_scratch_shutdown();
+    return true;
+}
+
+u8 frame_scratch_benchmark(void)
+{
+    expect_to_be_true(frame_scratch_initialize(MEBIBYTES(8)));
+
+    const u32 allocation_count = 100000;
+    const u64 size = 48;
+    bclock clock;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < allocation_count; ++i)
+    {
+        void* block = frame_scratch_allocate(size);
+        ((u8*)block)[0] = (u8)i;
+    }
+    bclock_update(&clock);
+    f64 scratch_time = clock.elapsed;
+
+    void** blocks = ballocate(sizeof(void*) * allocation_count, MEMORY_TAG_ARRAY);
+    bclock_start(&clock);
+    for (u32 i = 0; i < allocation_count; ++i)
+    {
+        blocks[i] = ballocate(size, MEMORY_TAG_JOB);
+        ((u8*)blocks[i])[0] = (u8)i;
+    }
+    for (u32 i = 0; i < allocation_count; ++i)
+        bfree(blocks[i], size, MEMORY_TAG_JOB);
+    bclock_update(&clock);
+    f64 heap_time = clock.elapsed;
+    bfree(blocks, sizeof(void*) * allocation_count, MEMORY_TAG_ARRAY);
+
+    BINFO("%u temporaries of %lluB: frame scratch %.3fms, ballocate/bfree %.3fms", allocation_count, size, scratch_time * 1000.0, heap_time * 1000.0);
+
+    frame_scratch_shutdown();
+    return true;
+}
+
+void frame_scratch_register_tests(void)
+{
+    test_manager_register_test(frame_scratch_should_allocate_aligned, "Frame scratch should bump allocate aligned blocks");
+    test_manager_register_test(frame_scratch_should_keep_previous_frame, "Frame scratch should keep the previous frame's allocations");
+    test_manager_register_test(frame_scratch_should_fail_when_full, "Frame scratch should fail allocations that don't fit and track high-water marks");
+    test_manager_register_test(frame_scratch_threads_should_have_own_arenas, "Frame scratch threads should each get their own arenas");
+    test_manager_register_test(frame_scratch_benchmark, "Frame scratch vs heap temporaries benchmark");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void frame_scratch_register_tests(void);
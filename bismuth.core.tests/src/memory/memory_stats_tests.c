@@ -0,0 +1,232 @@
+#include "memory_stats_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <strings/bstring.h>
+#include <threads/bthread.h>
+
+static b8 memory_stats_setup(void)
+{
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    return memory_system_initialize(config);
+}
+
+static void memory_stats_teardown(void)
+{
+    memory_system_thread_release();
+    memory_system_shutdown();
+}
+
+u8 memory_stats_histogram_buckets(void)
+{
+    expect_should_be(16, memory_size_histogram_bucket_limit(0));
+    expect_should_be(32, memory_size_histogram_bucket_limit(1));
+    expect_should_be(131072, memory_size_histogram_bucket_limit(13));
+    expect_to_be_true((memory_size_histogram_bucket_limit(MEMORY_SIZE_HISTOGRAM_BUCKETS - 1) == U64_MAX));
+
+    expect_to_be_true(memory_stats_setup());
+
+    memory_system_stats before;
+    expect_to_be_true(memory_system_stats_get(&before));
+
+    // Small blocks are counted by their size class, so these all land in the (16, 32] bucket
+    void* small_blocks[10];
+    for (u32 i = 0; i < 10; ++i)
+        small_blocks[i] = ballocate(20, MEMORY_TAG_AUDIO);
+    // Too big for the small allocator. Lands in the (64KiB, 128KiB] bucket
+    void* large_block = ballocate(100000, MEMORY_TAG_AUDIO);
+
+    memory_system_stats after;
+    expect_to_be_true(memory_system_stats_get(&after));
+    const memory_tag_stats* b = &before.tags[MEMORY_TAG_AUDIO];
+    const memory_tag_stats* a = &after.tags[MEMORY_TAG_AUDIO];
+    expect_should_be(10, a->size_histogram[1] - b->size_histogram[1]);
+    expect_should_be(1, a->size_histogram[13] - b->size_histogram[13]);
+    expect_should_be(11, a->allocation_count - b->allocation_count);
+    expect_should_be(10 * 32 + 100000, a->allocated - b->allocated);
+    expect_should_be(10 * 32 + 100000, after.total_allocated - before.total_allocated);
+    expect_should_be(11, after.live_allocation_count - before.live_allocation_count);
+
+    for (u32 i = 0; i < 10; ++i)
+        bfree(small_blocks[i], 20, MEMORY_TAG_AUDIO);
+    bfree(large_block, 100000, MEMORY_TAG_AUDIO);
+
+    expect_to_be_true(memory_system_stats_get(&after));
+    expect_should_be(b->allocated, a->allocated);
+    expect_should_be(11, a->free_count - b->free_count);
+    expect_should_be(10 * 32 + 100000, a->freed_bytes - b->freed_bytes);
+    expect_should_be(before.live_allocation_count, after.live_allocation_count);
+    // Histograms count allocations made, so they don't go down on free
+    expect_should_be(10, a->size_histogram[1] - b->size_histogram[1]);
+
+    memory_stats_teardown();
+    return true;
+}
+
+u8 memory_stats_frame_rate_and_peaks(void)
+{
+    expect_to_be_true(memory_stats_setup());
+
+    const u64 block_size = KIBIBYTES(8);
+    memory_system_frame_mark();
+    memory_system_stats stats;
+    expect_to_be_true(memory_system_stats_get(&stats));
+    u64 first_frame = stats.frame_number;
+    u64 baseline = stats.tags[MEMORY_TAG_JOB].allocated;
+
+    // One frame's worth of allocations, all freed again within the frame
+    void* blocks[5];
+    for (u32 i = 0; i < 5; ++i)
+        blocks[i] = ballocate(block_size, MEMORY_TAG_JOB);
+    // Peaks are sampled whenever stats are gathered
+    expect_to_be_true(memory_system_stats_get(&stats));
+    for (u32 i = 0; i < 5; ++i)
+        bfree(blocks[i], block_size, MEMORY_TAG_JOB);
+    memory_system_frame_mark();
+
+    expect_to_be_true(memory_system_stats_get(&stats));
+    expect_should_be(first_frame + 1, stats.frame_number);
+    expect_should_be(5, stats.tags[MEMORY_TAG_JOB].frame_allocation_count);
+    expect_should_be(5 * block_size, stats.tags[MEMORY_TAG_JOB].frame_allocated_bytes);
+    expect_to_be_true((stats.frame_allocation_count >= 5));
+    expect_should_be(baseline, stats.tags[MEMORY_TAG_JOB].allocated);
+    expect_to_be_true((stats.tags[MEMORY_TAG_JOB].peak_allocated >= baseline + 5 * block_size));
+    expect_to_be_true((stats.peak_total_allocated >= stats.total_allocated + 5 * block_size));
+
+    // A frame with no allocations. The peak is kept
+    memory_system_frame_mark();
+    expect_to_be_true(memory_system_stats_get(&stats));
+    expect_should_be(0, stats.tags[MEMORY_TAG_JOB].frame_allocation_count);
+    expect_should_be(0, stats.tags[MEMORY_TAG_JOB].frame_allocated_bytes);
+    expect_to_be_true((stats.tags[MEMORY_TAG_JOB].peak_allocated >= baseline + 5 * block_size));
+
+    memory_stats_teardown();
+    return true;
+}
+
+#define REPORT_THREAD_COUNT 4
+#define REPORT_THREAD_ITERATIONS 5000
+
+static u32 report_thread_run(void* params)
+{
+    // Reported allocations take the same per-thread path as real ones
+    for (u32 i = 0; i < REPORT_THREAD_ITERATIONS; ++i)
+        ballocate_report(64, MEMORY_TAG_VULKAN_EXT);
+    for (u32 i = 0; i < REPORT_THREAD_ITERATIONS / 2; ++i)
+        bfree_report(64, MEMORY_TAG_VULKAN_EXT);
+    memory_system_thread_release();
+    return 0;
+}
+
+u8 memory_stats_threads_sum(void)
+{
+    expect_to_be_true(memory_stats_setup());
+
+    memory_system_stats before;
+    expect_to_be_true(memory_system_stats_get(&before));
+
+    bthread threads[REPORT_THREAD_COUNT];
+    for (u32 i = 0; i < REPORT_THREAD_COUNT; ++i)
+        bthread_create(report_thread_run, 0, false, &threads[i]);
+    for (u32 i = 0; i < REPORT_THREAD_COUNT; ++i)
+    {
+        bthread_wait(&threads[i]);
+        bthread_destroy(&threads[i]);
+    }
+
+    memory_system_stats after;
+    expect_to_be_true(memory_system_stats_get(&after));
+    const memory_tag_stats* b = &before.tags[MEMORY_TAG_VULKAN_EXT];
+    const memory_tag_stats* a = &after.tags[MEMORY_TAG_VULKAN_EXT];
+    expect_should_be(REPORT_THREAD_COUNT * REPORT_THREAD_ITERATIONS, a->allocation_count - b->allocation_count);
+    expect_should_be(REPORT_THREAD_COUNT * (REPORT_THREAD_ITERATIONS / 2), a->free_count - b->free_count);
+    expect_should_be(REPORT_THREAD_COUNT * (REPORT_THREAD_ITERATIONS / 2) * 64, a->allocated - b->allocated);
+    // 64 bytes is in the (32, 64] bucket
+    expect_should_be(REPORT_THREAD_COUNT * REPORT_THREAD_ITERATIONS, a->size_histogram[2] - b->size_histogram[2]);
+    expect_should_be(REPORT_THREAD_COUNT * (REPORT_THREAD_ITERATIONS / 2), after.live_allocation_count - before.live_allocation_count);
+
+    for (u32 i = 0; i < REPORT_THREAD_COUNT * (REPORT_THREAD_ITERATIONS / 2); ++i)
+        bfree_report(64, MEMORY_TAG_VULKAN_EXT);
+    expect_should_be(before.live_allocation_count, get_memory_alloc_count());
+
+    memory_stats_teardown();
+    return true;
+}
+
+#if BMEMORY_TRACK_CALL_SITES
+static b8 call_site_find(const char* file, u32 line, memory_call_site_stats* out_site)
+{
+    memory_call_site_stats sites[512];
+    u32 count = BMIN(memory_call_sites_get(512, sites), 512);
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (sites[i].file && sites[i].line == line && strings_equal(sites[i].file, file))
+        {
+            *out_site = sites[i];
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+u8 memory_stats_call_sites(void)
+{
+    expect_to_be_true(memory_stats_setup());
+
+#if BMEMORY_TRACK_CALL_SITES
+    void* blocks[3];
+    u32 alloc_line = __LINE__ + 2;
+    for (u32 i = 0; i < 3; ++i)
+        blocks[i] = ballocate(100, MEMORY_TAG_GAME);
+
+    memory_call_site_stats site;
+    expect_to_be_true(call_site_find(__FILE__, alloc_line, &site));
+    expect_should_be(3, site.allocation_count);
+    expect_should_be(300, site.allocated_bytes);
+    expect_should_be(3, site.live_count);
+    expect_should_be(MEMORY_TAG_GAME, site.tag);
+
+    bfree(blocks[0], 100, MEMORY_TAG_GAME);
+    // A resize moves the block over to the resizing call site
+    u32 realloc_line = __LINE__ + 1;
+    blocks[1] = breallocate(blocks[1], 100, 4000, MEMORY_TAG_GAME);
+
+    expect_to_be_true(call_site_find(__FILE__, alloc_line, &site));
+    expect_should_be(2, site.free_count);
+    expect_should_be(1, site.live_count);
+    expect_should_be(100, site.live_bytes);
+    expect_to_be_true(call_site_find(__FILE__, realloc_line, &site));
+    expect_should_be(1, site.live_count);
+    expect_should_be(4000, site.live_bytes);
+
+    bfree(blocks[1], 4000, MEMORY_TAG_GAME);
+    bfree(blocks[2], 100, MEMORY_TAG_GAME);
+    expect_to_be_true(call_site_find(__FILE__, alloc_line, &site));
+    expect_should_be(0, site.live_count);
+    expect_to_be_true(call_site_find(__FILE__, realloc_line, &site));
+    expect_should_be(0, site.live_bytes);
+
+    memory_call_sites_report(5);
+#else
+    // Compiled out, so there is never anything to report
+    void* block = ballocate(100, MEMORY_TAG_GAME);
+    expect_should_be(0, memory_call_sites_get(0, 0));
+    bfree(block, 100, MEMORY_TAG_GAME);
+#endif
+
+    memory_stats_teardown();
+    return true;
+}
+
+void memory_stats_register_tests(void)
+{
+    test_manager_register_test(memory_stats_histogram_buckets, "Memory stats per-tag size histograms");
+    test_manager_register_test(memory_stats_frame_rate_and_peaks, "Memory stats per-frame allocation rate and peaks");
+    test_manager_register_test(memory_stats_threads_sum, "Memory stats sum per-thread counters");
+    test_manager_register_test(memory_stats_call_sites, "Memory stats allocation call-site tracking");
+}
@@ -0,0 +1,236 @@
+#include "small_allocator_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/allocators/small_allocator.h>
+#include <memory/bmemory.h>
+#include <platform/platform.h>
+#include <threads/bthread.h>
+#include <time/bclock.h>
+
+u8 small_allocator_should_create_and_destroy(void)
+{
+    small_allocator alloc;
+    u64 memory_requirement = 0;
+    b8 result = small_allocator_create(SMALL_ALLOCATOR_PAGE_SIZE * 4, &memory_requirement, 0, 0);
+    expect_to_be_true(result);
+
+    void* memory = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    result = small_allocator_create(SMALL_ALLOCATOR_PAGE_SIZE * 4, &memory_requirement, memory, &alloc);
+    expect_to_be_true(result);
+    expect_should_not_be(0, alloc.memory);
+    expect_should_be(SMALL_ALLOCATOR_PAGE_SIZE * 4, small_allocator_total_space(&alloc));
+    expect_should_be(0, small_allocator_page_space(&alloc));
+
+    small_allocator_destroy(&alloc);
+    expect_should_be(0, alloc.memory);
+    bfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 small_allocator_size_classes_and_alignment(void)
+{
+    small_allocator alloc;
+    u64 memory_requirement = 0;
+    small_allocator_create(SMALL_ALLOCATOR_PAGE_SIZE * 64, &memory_requirement, 0, 0);
+    void* memory = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    small_allocator_create(SMALL_ALLOCATOR_PAGE_SIZE * 64, &memory_requirement, memory, &alloc);
+
+    small_allocator_cache cache = {0};
+
+    expect_to_be_true(small_allocator_accepts(1, 1));
+    expect_to_be_true(small_allocator_accepts(SMALL_ALLOCATOR_MAX_SIZE, SMALL_ALLOCATOR_ALIGNMENT));
+    expect_to_be_false(small_allocator_accepts(SMALL_ALLOCATOR_MAX_SIZE + 1, 1));
+    expect_to_be_false(small_allocator_accepts(16, SMALL_ALLOCATOR_ALIGNMENT * 2));
+
+    for (u64 size = 1; size <= SMALL_ALLOCATOR_MAX_SIZE; size += 7)
+    {
+        u64 block_size = 0;
+        void* block = small_allocator_allocate(&alloc, &cache, size, &block_size);
+        expect_should_not_be(0, block);
+        expect_to_be_true((block_size >= size));
+        expect_should_be(0, (((u64)block) % SMALL_ALLOCATOR_ALIGNMENT));
+        expect_to_be_true(small_allocator_owns(&alloc, block));
+        expect_should_be(block_size, small_allocator_block_size(&alloc, block));
+
+        // Make sure the whole block is writable without stomping on neighbours
+        bset_memory(block, 0xAB, block_size);
+
+        u64 freed_size = 0;
+        expect_to_be_true(small_allocator_free(&alloc, &cache, block, &freed_size));
+        expect_should_be(block_size, freed_size);
+    }
+
+    // Something not from the allocator should not be owned
+    u64 stack_value = 0;
+    expect_to_be_false(small_allocator_owns(&alloc, &stack_value));
+
+    small_allocator_cache_flush(&alloc, &cache);
+    small_allocator_destroy(&alloc);
+    bfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+u8 small_allocator_exhaust_and_reuse(void)
+{
+    small_allocator alloc;
+    u64 memory_requirement = 0;
+    small_allocator_create(SMALL_ALLOCATOR_PAGE_SIZE, &memory_requirement, 0, 0);
+    void* memory = ballocate(memory_requirement, MEMORY_TAG_ENGINE);
+    small_allocator_create(SMALL_ALLOCATOR_PAGE_SIZE, &memory_requirement, memory, &alloc);
+
+    small_allocator_cache cache_a = {0};
+    small_allocator_cache cache_b = {0};
+
+    // A single page of 64-byte blocks
+    const u32 block_count = SMALL_ALLOCATOR_PAGE_SIZE / 64;
+    void** blocks = ballocate(sizeof(void*) * block_count, MEMORY_TAG_ARRAY);
+    for (u32 i = 0; i < block_count; ++i)
+    {
+        blocks[i] = small_allocator_allocate(&alloc, &cache_a, 64, 0);
+        expect_should_not_be(0, blocks[i]);
+    }
+    expect_should_be(SMALL_ALLOCATOR_PAGE_SIZE, small_allocator_page_space(&alloc));
+
+    // Region is now exhausted for every class
+    expect_should_be(0, small_allocator_allocate(&alloc, &cache_b, 64, 0));
+    expect_should_be(0, small_allocator_allocate(&alloc, &cache_b, 16, 0));
+
+    // Free everything on a thread cache which did not allocate them, then flush back to the shared pool
+    for (u32 i = 0; i < block_count; ++i)
+        expect_to_be_true(small_allocator_free(&alloc, &cache_b, blocks[i], 0));
+    small_allocator_cache_flush(&alloc, &cache_b);
+
+    // The first cache should be able to get every block back without a new page
+    for (u32 i = 0; i < block_count; ++i)
+    {
+        blocks[i] = small_allocator_allocate(&alloc, &cache_a, 64, 0);
+        expect_should_not_be(0, blocks[i]);
+    }
+    expect_should_be(SMALL_ALLOCATOR_PAGE_SIZE, small_allocator_page_space(&alloc));
+    expect_should_be(0, small_allocator_allocate(&alloc, &cache_a, 64, 0));
+
+    bfree(blocks, sizeof(void*) * block_count, MEMORY_TAG_ARRAY);
+    small_allocator_destroy(&alloc);
+    bfree(memory, memory_requirement, MEMORY_TAG_ENGINE);
+    return true;
+}
+
+typedef struct alloc_thread_params
+{
+    u32 iterations;
+    u16 alignment;
+    b8 failed;
+} alloc_thread_params;
+
+#define ALLOC_THREAD_BATCH 64
+
+static u32 alloc_thread_run(void* params)
+{
+    alloc_thread_params* p = params;
+    void* blocks[ALLOC_THREAD_BATCH];
+    u64 sizes[ALLOC_THREAD_BATCH];
+    for (u32 i = 0; i < p->iterations; ++i)
+    {
+        // Allocate a batch of mixed sizes, then release them in reverse
+        for (u32 j = 0; j < ALLOC_THREAD_BATCH; ++j)
+        {
+            sizes[j] = 8 + ((i * 31 + j * 17) % 500);
+            blocks[j] = ballocate_aligned(sizes[j], p->alignment, MEMORY_TAG_ARRAY);
+            if (!blocks[j])
+                p->failed = true;
+            else
+                *(u64*)blocks[j] = sizes[j];
+        }
+        for (i32 j = ALLOC_THREAD_BATCH - 1; j >= 0; --j)
+        {
+            if (blocks[j])
+            {
+                if (*(u64*)blocks[j] != sizes[j])
+                    p->failed = true;
+                bfree_aligned(blocks[j], sizes[j], p->alignment, MEMORY_TAG_ARRAY);
+            }
+        }
+    }
+    memory_system_thread_release();
+    return 0;
+}
+
+// Runs thread_count threads of alloc/free traffic and returns ops per second
+static f64 run_alloc_threads(u32 thread_count, u32 iterations, u16 alignment, b8* out_failed)
+{
+    bthread threads[16];
+    alloc_thread_params params[16];
+    bclock clock;
+    bclock_start(&clock);
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        params[i].iterations = iterations;
+        params[i].alignment = alignment;
+        params[i].failed = false;
+        bthread_create(alloc_thread_run, &params[i], false, &threads[i]);
+    }
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        bthread_wait(&threads[i]);
+        bthread_destroy(&threads[i]);
+        if (params[i].failed)
+            *out_failed = true;
+    }
+    bclock_update(&clock);
+    f64 ops = (f64)thread_count * iterations * ALLOC_THREAD_BATCH * 2;
+    return ops / clock.elapsed;
+}
+
+u8 small_allocator_memory_system_contention_benchmark(void)
+{
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(256);
+    config.small_alloc_size = MEBIBYTES(64);
+    expect_to_be_true(memory_system_initialize(config));
+
+    u64 baseline_count = get_memory_alloc_count();
+
+    // Small blocks report their size class
+    void* block = ballocate(20, MEMORY_TAG_ARRAY);
+    u64 size = 0;
+    u16 alignment = 0;
+    expect_to_be_true(bmemory_get_size_alignment(block, &size, &alignment));
+    expect_should_be(32, size);
+    expect_should_be(SMALL_ALLOCATOR_ALIGNMENT, alignment);
+    expect_should_be(baseline_count + 1, get_memory_alloc_count());
+    bfree(block, 20, MEMORY_TAG_ARRAY);
+    expect_should_be(baseline_count, get_memory_alloc_count());
+
+    i32 processor_count = platform_get_processor_count();
+    // NOTE: Always run at least 4 threads so the concurrent paths get exercised even on small machines
+    u32 max_threads = (u32)BCLAMP(processor_count, 4, 16);
+    const u32 iterations = 2000;
+
+    b8 failed = false;
+    for (u32 thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+        // Alignment above SMALL_ALLOCATOR_ALIGNMENT forces the global (locked) path, for comparison
+        f64 global_ops = run_alloc_threads(thread_count, iterations / 4, SMALL_ALLOCATOR_ALIGNMENT * 2, &failed);
+        f64 small_ops = run_alloc_threads(thread_count, iterations, 1, &failed);
+        BINFO("  %2u thread(s): per-thread cache %10.0f ops/sec, global heap %10.0f ops/sec", thread_count, small_ops, global_ops);
+    }
+    expect_to_be_false(failed);
+
+    // Everything allocated by the worker threads must have been accounted for
+    expect_should_be(baseline_count, get_memory_alloc_count());
+
+    memory_system_thread_release();
+    memory_system_shutdown();
+    return true;
+}
+
+void small_allocator_register_tests(void)
+{
+    test_manager_register_test(small_allocator_should_create_and_destroy, "Small allocator should create and destroy");
+    test_manager_register_test(small_allocator_size_classes_and_alignment, "Small allocator size classes and alignment");
+    test_manager_register_test(small_allocator_exhaust_and_reuse, "Small allocator exhaust region and reuse freed blocks");
+    test_manager_register_test(small_allocator_memory_system_contention_benchmark, "Small allocator memory system contention benchmark");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void small_allocator_register_tests(void);
@@ -0,0 +1,315 @@
+#include "bson_binary_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <containers/darray.h>
+#include <memory/bmemory.h>
+#include <parsers/bson_binary.h>
+#include <parsers/bson_parser.h>
+#include <platform/filesystem.h>
+#include <strings/bstring.h>
+#include <strings/bstring_id.h>
+#include <time/bclock.h>
+
+static const char* test_source =
+    "version = 2\n"
+    "name = \"binary test\"\n"
+    "scale = 1.5\n"
+    "negative = -42\n"
+    "enabled = true\n"
+    "empty_string = \"\"\n"
+    "empty_object = {\n"
+    "}\n"
+    "nodes = [\n"
+    "    {\n"
+    "        name = \"first\"\n"
+    "        values = [\n"
+    "            1\n"
+    "            2.25\n"
+    "            \"three\"\n"
+    "            false\n"
+    "        ]\n"
+    "    }\n"
+    "    {\n"
+    "        name = \"second\"\n"
+    "        children = [\n"
+    "        ]\n"
+    "    }\n"
+    "]\n";
+
+u8 bson_binary_should_round_trip(void)
+{
+    bson_tree tree;
+    expect_to_be_true(bson_tree_from_string(test_source, &tree));
+
+    u64 size = 0;
+    void* data = 0;
+    expect_to_be_true(bson_tree_to_binary(&tree, &size, &data));
+    expect_to_be_true(bson_binary_is_binary(data, size));
+    expect_to_be_false(bson_binary_is_binary(test_source, string_length(test_source)));
+
+    // Read values in place
+    bson_binary_reader reader;
+    bson_binary_object root;
+    expect_to_be_true(bson_binary_reader_open(data, size, &reader));
+    expect_to_be_true(bson_binary_reader_root_get(&reader, &root));
+    expect_should_be(BSON_OBJECT_TYPE_OBJECT, root.type);
+    expect_should_be(8, root.count);
+
+    i64 i = 0;
+    f32 f = 0;
+    b8 b = false;
+    const char* s = 0;
+    expect_to_be_true(bson_binary_object_value_get_int(&root, "version", &i));
+    expect_should_be(2, i);
+    expect_to_be_true(bson_binary_object_value_get_int(&root, "negative", &i));
+    expect_should_be(-42, i);
+    expect_to_be_true(bson_binary_object_value_get_float(&root, "scale", &f));
+    expect_float_to_be(1.5f, f);
+    expect_to_be_true(bson_binary_object_value_get_bool(&root, "enabled", &b));
+    expect_to_be_true(b);
+    expect_to_be_true(bson_binary_object_value_get_string(&root, "name", &s));
+    expect_string_to_be("binary test", s);
+    expect_to_be_true(bson_binary_object_value_get_string(&root, "empty_string", &s));
+    expect_string_to_be("", s);
+    expect_to_be_false(bson_binary_object_value_get_string(&root, "version", &s));
+    expect_to_be_false(bson_binary_object_value_get_int(&root, "missing", &i));
+
+    bson_binary_object empty;
+    expect_to_be_true(bson_binary_object_value_get_object(&root, "empty_object", &empty));
+    expect_should_be(0, empty.count);
+
+    bson_binary_object nodes;
+    expect_to_be_true(bson_binary_object_value_get_object(&root, "nodes", &nodes));
+    expect_should_be(BSON_OBJECT_TYPE_ARRAY, nodes.type);
+    expect_should_be(2, nodes.count);
+
+    bson_binary_value element;
+    expect_to_be_true(bson_binary_object_property_at(&nodes, 0, &element));
+    expect_should_be(BSON_PROPERTY_TYPE_OBJECT, element.type);
+    expect_should_be(INVALID_BSTRING_ID, element.name);
+    expect_to_be_true(bson_binary_object_value_get_string(&element.value.o, "name", &s));
+    expect_string_to_be("first", s);
+
+    bson_binary_value values;
+    expect_to_be_true(bson_binary_object_property_find(&element.value.o, bstring_id_create("values"), &values));
+    expect_should_be(BSON_PROPERTY_TYPE_ARRAY, values.type);
+    expect_should_be(4, values.value.o.count);
+    expect_to_be_true(bson_binary_object_property_at(&values.value.o, 2, &element));
+    expect_should_be(BSON_PROPERTY_TYPE_STRING, element.type);
+    expect_string_to_be("three", element.value.s);
+    expect_to_be_false(bson_binary_object_property_at(&values.value.o, 4, &element));
+
+    // Converting back gives the same tree
+    bson_tree round_trip;
+    expect_to_be_true(bson_tree_from_binary(data, size, &round_trip));
+    const char* original_str = bson_tree_to_string(&tree);
+    const char* round_trip_str = bson_tree_to_string(&round_trip);
+    b8 same = strings_equal(original_str, round_trip_str);
+    string_free(original_str);
+    string_free(round_trip_str);
+    expect_to_be_true(same);
+
+    bson_tree_cleanup(&round_trip);
+    bson_tree_cleanup(&tree);
+    bfree(data, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 bson_binary_should_reject_bad_data(void)
+{
+    bson_tree tree;
+    expect_to_be_true(bson_tree_from_string(test_source, &tree));
+    u64 size = 0;
+    void* data = 0;
+    expect_to_be_true(bson_tree_to_binary(&tree, &size, &data));
+    bson_tree_cleanup(&tree);
+
+    bson_binary_reader reader;
+    BDEBUG("Note: The following errors are intentionally caused by this test");
+
+    // Truncated
+    expect_to_be_false(bson_binary_reader_open(data, size - 1, &reader));
+    expect_to_be_false(bson_binary_reader_open(data, 4, &reader));
+
+    // Not binary at all
+    u64 text_storage[8] = {0};
+    string_ncopy((char*)text_storage, "version = 2\n", sizeof(text_storage));
+    expect_to_be_false(bson_binary_reader_open(text_storage, sizeof(text_storage), &reader));
+
+    // Misaligned
+    u8* shifted = ballocate(size + 1, MEMORY_TAG_ARRAY);
+    bcopy_memory(shifted + 1, data, size);
+    expect_to_be_false(bson_binary_reader_open(shifted + 1, size, &reader));
+    bfree(shifted, size + 1, MEMORY_TAG_ARRAY);
+
+    // Children pointing back at their own container or an ancestor, which would otherwise recurse forever.
+    // NOTE: Records are 16 bytes with the payload last, and each container starts with an 8 byte header
+    expect_to_be_true(bson_binary_reader_open(data, size, &reader));
+    bson_binary_object root;
+    expect_to_be_true(bson_binary_reader_root_get(&reader, &root));
+    u64 root_offset = (u64)((const u8*)root.records - (const u8*)data) - 8;
+    bson_binary_value value;
+    for (u32 i = 0; i < root.count; ++i)
+    {
+        expect_to_be_true(bson_binary_object_property_at(&root, i, &value));
+        if (value.type != BSON_PROPERTY_TYPE_OBJECT && value.type != BSON_PROPERTY_TYPE_ARRAY)
+            continue;
+
+        // Each of the root's containers in turn, then the first container nested in it
+        const bson_binary_object child = value.value.o;
+        u64* payloads[2] = {(u64*)((u8*)root.records + i * 16 + 8), 0};
+        for (u32 c = 0; c < child.count && !payloads[1]; ++c)
+        {
+            expect_to_be_true(bson_binary_object_property_at(&child, c, &value));
+            if (value.type == BSON_PROPERTY_TYPE_OBJECT || value.type == BSON_PROPERTY_TYPE_ARRAY)
+                payloads[1] = (u64*)((u8*)child.records + c * 16 + 8);
+        }
+        for (u32 p = 0; p < 2 && payloads[p]; ++p)
+        {
+            u64 original = *payloads[p];
+            *payloads[p] = root_offset;
+            bson_tree corrupt;
+            expect_to_be_false(bson_tree_from_binary(data, size, &corrupt));
+            *payloads[p] = original;
+        }
+    }
+    expect_to_be_true(bson_tree_from_binary(data, size, &tree));
+    bson_tree_cleanup(&tree);
+
+    // A corrupt string terminator
+    u8* bytes = data;
+    u8 last = bytes[size - 1];
+    bytes[size - 1] = 'x';
+    b8 last_is_terminator = last == 0;
+    expect_to_be_true(last_is_terminator);
+    expect_to_be_false(bson_binary_reader_open(data, size, &reader));
+
+    bfree(data, size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+// Visits every property in the object and its children, as a loader would
+static u64 binary_object_walk(const bson_binary_object* object)
+{
+    u64 visited = 0;
+    for (u32 i = 0; i < object->count; ++i)
+    {
+        bson_binary_value value;
+        if (!bson_binary_object_property_at(object, i, &value))
+            break;
+        visited++;
+        if (value.type == BSON_PROPERTY_TYPE_OBJECT || value.type == BSON_PROPERTY_TYPE_ARRAY)
+            visited += binary_object_walk(&value.value.o);
+    }
+    return visited;
+}
+
+static void bson_binary_benchmark_source(const char* label, const char* source, u32 iterations)
+{
+    bclock clock;
+    u64 source_size = string_length(source);
+
+    bson_tree tree;
+    if (!bson_tree_from_string(source, &tree))
+    {
+        BERROR("Failed to parse benchmark source '%s'", label);
+        return;
+    }
+    u64 size = 0;
+    void* data = 0;
+    bson_tree_to_binary(&tree, &size, &data);
+    bson_tree_cleanup(&tree);
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        bson_tree_from_string(source, &tree);
+        bson_tree_cleanup(&tree);
+    }
+    bclock_update(&clock);
+    f64 text_time = clock.elapsed / iterations;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        bson_tree_from_binary(data, size, &tree);
+        bson_tree_cleanup(&tree);
+    }
+    bclock_update(&clock);
+    f64 tree_time = clock.elapsed / iterations;
+
+    u64 visited = 0;
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        bson_binary_reader reader;
+        bson_binary_object root;
+        bson_binary_reader_open(data, size, &reader);
+        bson_binary_reader_root_get(&reader, &root);
+        visited = binary_object_walk(&root);
+    }
+    bclock_update(&clock);
+    f64 reader_time = clock.elapsed / iterations;
+
+    BINFO("bson %s: text %lluB, binary %lluB, %llu properties. Text parse %.1fus, binary to tree %.1fus, binary read in place %.1fus",
+          label, source_size, size, visited, text_time * 1000000.0, tree_time * 1000000.0, reader_time * 1000000.0);
+    bfree(data, size, MEMORY_TAG_ARRAY);
+}
+
+u8 bson_binary_benchmark(void)
+{
+    const char* scene_paths[] = {
+        "../testbed.bapp/assets/scenes/test_scene.bsn",
+        "../voidpulse.bapp/assets/scenes/track_00.bsn",
+        "../bismuth.core.tests/src/parsers/test_scene2.bsn"};
+    for (u32 i = 0; i < 3; ++i)
+    {
+        const char* source = filesystem_read_entire_text_file(scene_paths[i]);
+        if (!source)
+        {
+            BWARN("Unable to read '%s', skipping", scene_paths[i]);
+            continue;
+        }
+        bson_binary_benchmark_source(scene_paths[i], source, 200);
+        string_free(source);
+    }
+
+    // A large generated scene, for something closer to a full level
+    bson_tree large = {0};
+    large.root = bson_object_create();
+    bson_object_value_add_int(&large.root, "version", 2);
+    bson_array nodes = bson_array_create();
+    for (u32 i = 0; i < 500; ++i)
+    {
+        bson_object node = bson_object_create();
+        char name[32];
+        string_format_to(name, sizeof(name), "node_%u", i);
+        bson_object_value_add_string(&node, "name", name);
+        bson_object_value_add_string(&node, "xform", "21.480885 -4.243200 -15.837330 0.000000 0.000000 0.000000 1.000000 0.010000 0.010000 0.010000");
+        bson_array attachments = bson_array_create();
+        bson_object attachment = bson_object_create();
+        bson_object_value_add_string(&attachment, "type", "static_mesh");
+        bson_object_value_add_string(&attachment, "asset_name", "sponza");
+        bson_object_value_add_float(&attachment, "shadow_distance", 100.0f);
+        bson_array_value_add_object(&attachments, attachment);
+        bson_object_value_add_array(&node, "attachments", attachments);
+        bson_array_value_add_object(&nodes, node);
+    }
+    bson_object_value_add_array(&large.root, "nodes", nodes);
+    const char* large_source = bson_tree_to_string(&large);
+    bson_tree_cleanup(&large);
+    bson_binary_benchmark_source("generated (500 nodes)", large_source, 5);
+    string_free(large_source);
+
+    return true;
+}
+
+void bson_binary_register_tests(void)
+{
+    test_manager_register_test(bson_binary_should_round_trip, "Binary bson should round trip and read in place");
+    test_manager_register_test(bson_binary_should_reject_bad_data, "Binary bson reader should reject bad data");
+    test_manager_register_test(bson_binary_benchmark, "Binary bson load benchmark against text");
+}
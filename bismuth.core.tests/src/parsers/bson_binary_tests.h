@@ -0,0 +1,3 @@
+#pragma once
+
+void bson_binary_register_tests(void);
@@ -5,6 +5,8 @@
 #include <parsers/bson_parser.h>
 #include <platform/filesystem.h>
 #include <strings/bstring.h>
+#include <strings/bstring_id.h>
+#include <time/bclock.h>
 
 #include "../expect.h"
 #include "../test_manager.h"
@@ -47,7 +49,8 @@ u8 bson_parser_should_tokenize_file_content(void)
         return false;
     }
 
-    char* test_file_content = ballocate(sizeof(char) * file_size, MEMORY_TAG_ARRAY);
+    // NOTE: One extra for the null terminator, which reading the file does not add
+    char* test_file_content = ballocate(sizeof(char) * (file_size + 1), MEMORY_TAG_ARRAY);
     u64 read_size = 0;
     if (!filesystem_read_all_text(&f, test_file_content, &read_size))
     {
@@ -57,6 +60,7 @@ u8 bson_parser_should_tokenize_file_content(void)
     }
 
     filesystem_close(&f);
+    test_file_content[read_size] = 0;
 
     bson_parser parser;
     bson_parser_create(&parser);
@@ -77,6 +81,449 @@ u8 bson_parser_should_tokenize_file_content(void)
 
     const char* str = bson_tree_to_string(&tree);
     BINFO(str);
+    string_free(str);
+    bson_tree_cleanup(&tree);
+    bfree(test_file_content, sizeof(char) * (file_size + 1), MEMORY_TAG_ARRAY);
+
+    return true;
+}
+
+u8 bson_object_should_index_properties(void)
+{
+    // Small objects are just scanned
+    bson_object small = bson_object_create();
+    expect_to_be_true(bson_object_value_add_int(&small, "a", 1));
+    expect_to_be_true(bson_object_value_add_int(&small, "b", 2));
+    expect_should_be(0, small.index);
+    i64 i = 0;
+    expect_to_be_true(bson_object_property_value_get_int(&small, "b", &i));
+    expect_should_be(2, i);
+    bson_object_cleanup(&small);
+
+    bson_object obj = bson_object_create();
+    char name[32];
+    for (u32 p = 0; p < 40; ++p)
+    {
+        string_format_to(name, sizeof(name), "prop_%u", p);
+        expect_to_be_true(bson_object_value_add_int(&obj, name, p));
+    }
+    expect_should_not_be(0, obj.index);
+
+    for (u32 p = 0; p < 40; ++p)
+    {
+        string_format_to(name, sizeof(name), "prop_%u", p);
+        expect_to_be_true(bson_object_property_value_get_int(&obj, name, &i));
+        expect_should_be(p, i);
+        expect_to_be_true(bson_object_property_value_get_int_by_id(&obj, bson_property_name_id(name), &i));
+        expect_should_be(p, i);
+    }
+    expect_to_be_false(bson_object_property_value_get_int(&obj, "missing", &i));
+    expect_to_be_false(bson_object_property_value_get_int_by_id(&obj, INVALID_BSTRING_ID, &i));
+    expect_should_be(bstring_id_create("prop_7"), bson_property_name_id("prop_7"));
+
+    // Replacing a property keeps the count, and is seen by lookups
+    expect_to_be_true(bson_object_value_add_string(&obj, "prop_3", "three"));
+    u32 count = 0;
+    expect_to_be_true(bson_object_property_count_get(&obj, &count));
+    expect_should_be(40, count);
+    const char* s = 0;
+    expect_to_be_true(bson_object_property_value_get_string(&obj, "prop_3", &s));
+    expect_string_to_be("three", s);
+    string_free(s);
+
+    // Properties pushed directly onto the darray are picked up too
+    bson_property pushed = {0};
+    pushed.type = BSON_PROPERTY_TYPE_BOOLEAN;
+    pushed.name = bstring_id_create("pushed");
+    pushed.value.b = true;
+    darray_push(obj.properties, pushed);
+    b8 b = false;
+    expect_to_be_true(bson_object_property_value_get_bool(&obj, "pushed", &b));
+    expect_to_be_true(b);
+
+    // Copies share the index
+    bson_object copy = obj;
+    expect_to_be_true(bson_object_value_add_float(&obj, "added", 2.5f));
+    copy = obj;
+    f32 f = 0;
+    expect_to_be_true(bson_object_property_value_get_float(&copy, "added", &f));
+    expect_float_to_be(2.5f, f);
+    expect_should_be(obj.index, copy.index);
+
+    bson_object_cleanup(&obj);
+    expect_should_be(0, obj.index);
+
+    // Parsed objects get an index as well
+    bson_tree tree;
+    expect_to_be_true(bson_tree_from_string("a = 1\nb = 2\nc = 3\nd = 4\ne = 5\nf = 6\ng = 7\nh = 8\ni = 9\n", &tree));
+    expect_should_not_be(0, tree.root.index);
+    expect_to_be_true(bson_object_property_value_get_int(&tree.root, "i", &i));
+    expect_should_be(9, i);
+    bson_tree_cleanup(&tree);
+
+    return true;
+}
+
+// The lookup as it used to be done: register the name, then scan
+static i32 bson_benchmark_linear_index_get(const bson_object* object, const char* name)
+{
+    bstring_id id = bstring_id_create(name);
+    u32 count = darray_length(object->properties);
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (object->properties[i].name == id)
+            return i;
+    }
+    return -1;
+}
+
+// Looks up a set of names commonly used by the scene and material serializers in every object in the tree, as a loader would
+static u64 bson_benchmark_walk(const bson_object* object, const char** names, const bstring_id* ids, u32 name_count, u32 mode)
+{
+    u64 found = 0;
+    if (!object->properties)
+        return 0;
+
+    if (object->type == BSON_OBJECT_TYPE_OBJECT)
+    {
+        for (u32 n = 0; n < name_count; ++n)
+        {
+            bson_property_type type;
+            b8 hit;
+            if (mode == 0)
+                hit = bson_benchmark_linear_index_get(object, names[n]) != -1;
+            else if (mode == 1)
+                hit = bson_object_property_value_type_get(object, names[n], &type);
+            else
+                hit = bson_object_property_value_type_get_by_id(object, ids[n], &type);
+            found += hit;
+        }
+    }
+
+    u32 count = darray_length(object->properties);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const bson_property* p = &object->properties[i];
+        if (p->type == BSON_PROPERTY_TYPE_OBJECT || p->type == BSON_PROPERTY_TYPE_ARRAY)
+            found += bson_benchmark_walk(&p->value.o, names, ids, name_count, mode);
+    }
+    return found;
+}
+
+static void bson_benchmark_lookups(const char* label, const bson_tree* tree, u32 iterations)
+{
+    const char* names[] = {"name", "xform", "attachments", "children", "type", "asset_name", "package_name", "shadow_distance", "color", "missing"};
+    const u32 name_count = sizeof(names) / sizeof(names[0]);
+    bstring_id ids[sizeof(names) / sizeof(names[0])];
+    for (u32 n = 0; n < name_count; ++n)
+        ids[n] = bson_property_name_id(names[n]);
+
+    const char* mode_names[] = {"old linear", "by name", "by id"};
+    f64 times[3];
+    u64 found = 0;
+    for (u32 mode = 0; mode < 3; ++mode)
+    {
+        bclock clock;
+        bclock_start(&clock);
+        for (u32 i = 0; i < iterations; ++i)
+            found = bson_benchmark_walk(&tree->root, names, ids, name_count, mode);
+        bclock_update(&clock);
+        times[mode] = clock.elapsed / iterations;
+    }
+
+    BINFO("bson lookups %s (%llu found): %s %.1fus, %s %.1fus, %s %.1fus",
+          label, found, mode_names[0], times[0] * 1000000.0, mode_names[1], times[1] * 1000000.0, mode_names[2], times[2] * 1000000.0);
+}
+
+u8 bson_object_lookup_benchmark(void)
+{
+    const char* scene_path = "../testbed.bapp/assets/scenes/test_scene.bsn";
+    const char* source = filesystem_read_entire_text_file(scene_path);
+    if (source)
+    {
+        bson_tree tree;
+        if (bson_tree_from_string(source, &tree))
+        {
+            bson_benchmark_lookups(scene_path, &tree, 1000);
+            bson_tree_cleanup(&tree);
+        }
+        string_free(source);
+    }
+    else
+    {
+        BWARN("Unable to read '%s', skipping", scene_path);
+    }
+
+    // A large generated scene, with nodes wide enough to be indexed
+    bson_tree large = {0};
+    large.root = bson_object_create();
+    bson_array nodes = bson_array_create();
+    char name[32];
+    for (u32 i = 0; i < 1000; ++i)
+    {
+        bson_object node = bson_object_create();
+        string_format_to(name, sizeof(name), "node_%u", i);
+        bson_object_value_add_string(&node, "name", name);
+        bson_object_value_add_string(&node, "xform", "0 0 0 0 0 0 1 1 1 1");
+        for (u32 p = 0; p < 30; ++p)
+        {
+            string_format_to(name, sizeof(name), "custom_property_%u", p);
+            bson_object_value_add_float(&node, name, (f32)p);
+        }
+        bson_object_value_add_string(&node, "type", "static_mesh");
+        bson_object_value_add_string(&node, "asset_name", "sponza");
+        bson_array_value_add_object(&nodes, node);
+    }
+    bson_object_value_add_array(&large.root, "nodes", nodes);
+    bson_benchmark_lookups("generated (1000 nodes x 34 properties)", &large, 10);
+    bson_tree_cleanup(&large);
+
+    return true;
+}
+
+static const char* stream_test_source =
+    "// A comment before anything else\n"
+    "version = 3\n"
+    "name = \"streamed \\\"quoted\\\" name\"\n"
+    "empty = \"\"\n"
+    "enabled = true\n"
+    "disabled = FALSE\n"
+    "negative = -17\n"
+    "fraction = .25\n"
+    "negative_fraction = -.5\n"
+    "trailing_decimal = 2.\n"
+    "scale = 123.456 // A trailing comment\n"
+    "properties = {\n"
+    "    description = \"multi-byte \xc3\xa9\xe2\x82\xac text\"\n"
+    "    nested = {\n"
+    "        deeper = [\n"
+    "            1\n"
+    "            -2.5\n"
+    "            \"three\"\n"
+    "            false\n"
+    "            {\n"
+    "                inside = 4\n"
+    "            }\n"
+    "            [\n"
+    "            ]\n"
+    "        ]\n"
+    "    }\n"
+    "}\n"
+    "last = 42";
+
+// Parses the source by feeding it to a parser chunk_size characters at a time, returning the tree written back out as a string
+static const char* bson_parse_in_chunks(const char* source, u32 chunk_size)
+{
+    bson_parser parser;
+    bson_parser_create(&parser);
+    bson_tree tree;
+    if (!bson_parser_stream_begin(&parser, &tree))
+        return 0;
+
+    u32 length = string_length(source);
+    b8 fed = true;
+    for (u32 offset = 0; offset < length && fed; offset += chunk_size)
+        fed = bson_parser_stream_feed(&parser, source + offset, BMIN(chunk_size, length - offset));
+
+    b8 result = bson_parser_stream_end(&parser) && fed;
+    bson_parser_destroy(&parser);
+    if (!result)
+        return 0;
+
+    const char* str = bson_tree_to_string(&tree);
+    bson_tree_cleanup(&tree);
+    return str;
+}
+
+u8 bson_tree_should_parse_in_chunks(void)
+{
+    bson_tree tree;
+    expect_to_be_true(bson_tree_from_string(stream_test_source, &tree));
+
+    i64 i = 0;
+    f32 f = 0;
+    b8 b = false;
+    const char* s = 0;
+    expect_to_be_true(bson_object_property_value_get_string(&tree.root, "name", &s));
+    expect_string_to_be("streamed \\\"quoted\\\" name", s);
+    expect_to_be_true(bson_object_property_value_get_string(&tree.root, "empty", &s));
+    expect_string_to_be("", s);
+    expect_to_be_true(bson_object_property_value_get_bool(&tree.root, "disabled", &b));
+    expect_to_be_false(b);
+    expect_to_be_true(bson_object_property_value_get_int(&tree.root, "negative", &i));
+    expect_should_be(-17, i);
+    expect_to_be_true(bson_object_property_value_get_float(&tree.root, "fraction", &f));
+    expect_float_to_be(0.25f, f);
+    expect_to_be_true(bson_object_property_value_get_float(&tree.root, "negative_fraction", &f));
+    expect_float_to_be(-0.5f, f);
+    // The last value has no newline after it
+    expect_to_be_true(bson_object_property_value_get_int(&tree.root, "last", &i));
+    expect_should_be(42, i);
+
+    const char* expected = bson_tree_to_string(&tree);
+    bson_tree_cleanup(&tree);
+
+    // However the source is split up, the result should be the same
+    u32 chunk_sizes[] = {1, 2, 3, 5, 7, 16, 64, 4096};
+    for (u32 c = 0; c < sizeof(chunk_sizes) / sizeof(u32); ++c)
+    {
+        const char* actual = bson_parse_in_chunks(stream_test_source, chunk_sizes[c]);
+        expect_should_not_be(0, actual);
+        b8 same = strings_equal(expected, actual);
+        if (!same)
+            BERROR("Chunk size %u produced:\n%s", chunk_sizes[c], actual);
+        string_free(actual);
+        expect_to_be_true(same);
+    }
+
+    // Written text should parse back to the same tree
+    expect_to_be_true(bson_tree_from_string(expected, &tree));
+    const char* rewritten = bson_tree_to_string(&tree);
+    bson_tree_cleanup(&tree);
+    b8 same = strings_equal(expected, rewritten);
+    string_free(rewritten);
+    string_free(expected);
+    expect_to_be_true(same);
+
+    // Reading from a file in chunks should match reading it all up front
+    const char* path = "../bismuth.core.tests/src/parsers/test_scene2.bsn";
+    const char* file_text = filesystem_read_entire_text_file(path);
+    expect_should_not_be(0, file_text);
+    expect_to_be_true(bson_tree_from_string(file_text, &tree));
+    expected = bson_tree_to_string(&tree);
+    bson_tree_cleanup(&tree);
+    string_free(file_text);
+
+    file_handle file;
+    expect_to_be_true(filesystem_open(path, FILE_MODE_READ, false, &file));
+    expect_to_be_true(bson_tree_from_file(&file, &tree));
+    filesystem_close(&file);
+    const char* actual = bson_tree_to_string(&tree);
+    bson_tree_cleanup(&tree);
+    same = strings_equal(expected, actual);
+    string_free(expected);
+    string_free(actual);
+    expect_to_be_true(same);
+
+    return true;
+}
+
+u8 bson_tree_should_reject_incomplete_documents(void)
+{
+    BDEBUG("Note: The following errors are intentionally caused by this test");
+    const char* bad_sources[] = {
+        "unclosed = {\n    value = 1\n",
+        "unclosed = [\n    1\n",
+        "missing_value =",
+        "missing_operator",
+        "closed_too_often = 1\n}\n",
+        "subtraction = 1 - 2\n",
+        "dotted = sponza.name\n",
+        "bad = $\n"};
+    for (u32 i = 0; i < sizeof(bad_sources) / sizeof(const char*); ++i)
+    {
+        bson_tree tree;
+        b8 parsed = bson_tree_from_string(bad_sources[i], &tree);
+        if (parsed)
+            BERROR("Parsed bad source '%s'", bad_sources[i]);
+        expect_to_be_false(parsed);
+
+        // The same when streamed, however it is split up
+        for (u32 chunk_size = 1; chunk_size < 4; ++chunk_size)
+        {
+            const char* str = bson_parse_in_chunks(bad_sources[i], chunk_size);
+            expect_should_be(0, str);
+        }
+    }
+
+    return true;
+}
+
+static void bson_stream_benchmark_source(const char* label, const char* source, u32 iterations)
+{
+    u64 size = string_length(source);
+    f64 mb = (f64)size / (1024.0 * 1024.0);
+    bclock clock;
+    bson_tree tree;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        bson_tree_from_string(source, &tree);
+        bson_tree_cleanup(&tree);
+    }
+    bclock_update(&clock);
+    f64 parse_time = clock.elapsed / iterations;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        bson_parser parser;
+        bson_parser_create(&parser);
+        bson_parser_stream_begin(&parser, &tree);
+        for (u64 offset = 0; offset < size; offset += BSON_STREAM_CHUNK_SIZE)
+            bson_parser_stream_feed(&parser, source + offset, BMIN(BSON_STREAM_CHUNK_SIZE, size - offset));
+        bson_parser_stream_end(&parser);
+        bson_parser_destroy(&parser);
+        bson_tree_cleanup(&tree);
+    }
+    bclock_update(&clock);
+    f64 stream_time = clock.elapsed / iterations;
+
+    bson_tree_from_string(source, &tree);
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+        string_free(bson_tree_to_string(&tree));
+    bclock_update(&clock);
+    f64 write_time = clock.elapsed / iterations;
+    bson_tree_cleanup(&tree);
+
+    BINFO("bson %s (%.2fMiB): parse %.1fMB/s, parse in %lluKiB chunks %.1fMB/s, write %.1fMB/s",
+          label, mb, mb / parse_time, BSON_STREAM_CHUNK_SIZE / 1024, mb / stream_time, mb / write_time);
+}
+
+u8 bson_stream_benchmark(void)
+{
+    const char* scene_path = "../testbed.bapp/assets/scenes/test_scene.bsn";
+    const char* source = filesystem_read_entire_text_file(scene_path);
+    if (source)
+    {
+        bson_stream_benchmark_source(scene_path, source, 200);
+        string_free(source);
+    }
+    else
+    {
+        BWARN("Unable to read '%s', skipping", scene_path);
+    }
+
+    // A multi-megabyte generated scene
+    bson_tree large = {0};
+    large.root = bson_object_create();
+    bson_object_value_add_int(&large.root, "version", 2);
+    bson_array nodes = bson_array_create();
+    char name[32];
+    for (u32 i = 0; i < 20000; ++i)
+    {
+        bson_object node = bson_object_create();
+        string_format_to(name, sizeof(name), "node_%u", i);
+        bson_object_value_add_string(&node, "name", name);
+        bson_object_value_add_string(&node, "xform", "21.480885 -4.243200 -15.837330 0.000000 0.000000 0.000000 1.000000 0.010000 0.010000 0.010000");
+        bson_array attachments = bson_array_create();
+        bson_object attachment = bson_object_create();
+        bson_object_value_add_string(&attachment, "type", "static_mesh");
+        bson_object_value_add_string(&attachment, "asset_name", "sponza");
+        bson_object_value_add_float(&attachment, "shadow_distance", -100.5f);
+        bson_object_value_add_int(&attachment, "cascade_count", 4);
+        bson_object_value_add_boolean(&attachment, "enabled", true);
+        bson_array_value_add_object(&attachments, attachment);
+        bson_object_value_add_array(&node, "attachments", attachments);
+        bson_array_value_add_object(&nodes, node);
+    }
+    bson_object_value_add_array(&large.root, "nodes", nodes);
+    const char* large_source = bson_tree_to_string(&large);
+    bson_tree_cleanup(&large);
+    bson_stream_benchmark_source("generated (20000 nodes)", large_source, 3);
+    string_free(large_source);
 
     return true;
 }
@@ -85,4 +532,9 @@ void bson_parser_register_tests(void)
 {
     test_manager_register_test(bson_parser_should_create_and_destroy, "BSON parser should create and destroy");
     test_manager_register_test(bson_parser_should_tokenize_file_content, "BSON parser should tokenize file content");
+    test_manager_register_test(bson_object_should_index_properties, "BSON objects should index properties by name");
+    test_manager_register_test(bson_object_lookup_benchmark, "BSON property lookup benchmark");
+    test_manager_register_test(bson_tree_should_parse_in_chunks, "BSON trees should parse the same in chunks as all at once");
+    test_manager_register_test(bson_tree_should_reject_incomplete_documents, "BSON parser should reject incomplete documents");
+    test_manager_register_test(bson_stream_benchmark, "BSON parse and write throughput benchmark");
 }
@@ -0,0 +1,210 @@
+#include "bname_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <platform/platform.h>
+#include <strings/bname.h>
+#include <strings/bstring.h>
+#include <threads/batomic.h>
+#include <threads/bthread.h>
+#include <time/bclock.h>
+#include <utils/crc64.h>
+
+u8 bname_should_ignore_case(void)
+{
+    bname a = bname_create("Some_Test_Name");
+    bname b = bname_create("some_test_name");
+    bname c = bname_create("SOME_TEST_NAME");
+    expect_should_not_be(INVALID_BNAME, a);
+    expect_should_be(a, b);
+    expect_should_be(a, c);
+    expect_should_not_be(a, bname_create("some_other_name"));
+
+    // Empty strings never make a name
+    expect_should_be(INVALID_BNAME, bname_create(""));
+    expect_should_be(INVALID_BNAME, bname_create(0));
+
+    return true;
+}
+
+u8 bname_should_match_lowercase_copy_hash(void)
+{
+    // Names must hash the same as a lowercased copy of the string always has, so saved names stay valid
+    const char* strings[] = {"Hello World", "already_lower", "MiXeD_CaSe_123", "[punctuation]@`{}"};
+    for (u32 i = 0; i < 4; ++i)
+    {
+        char* copy = string_duplicate(strings[i]);
+        string_to_lower(copy);
+        u64 expected = crc64(0, (const u8*)copy, string_length(copy));
+        string_free(copy);
+        expect_should_be(expected, bname_create(strings[i]));
+    }
+
+    return true;
+}
+
+u8 bname_should_keep_first_string(void)
+{
+    char buffer[] = "Keep_This_Name";
+    bname name = bname_create(buffer);
+
+    // The string is copied, so the original can change without affecting the saved one
+    buffer[0] = 'X';
+    expect_string_to_be("Keep_This_Name", bname_string_get(name));
+
+    // Creating the same name again keeps the first string
+    expect_should_be(name, bname_create("KEEP_THIS_NAME"));
+    expect_string_to_be("Keep_This_Name", bname_string_get(name));
+
+    // Names which were never created have no string
+    expect_should_be(0, bname_string_get(0x1234));
+
+    // Long strings are saved too
+    char long_string[8192];
+    for (u32 i = 0; i < sizeof(long_string) - 1; ++i)
+        long_string[i] = 'a' + (i % 26);
+    long_string[sizeof(long_string) - 1] = 0;
+    expect_string_to_be(long_string, bname_string_get(bname_create(long_string)));
+
+    return true;
+}
+
+u8 bname_literal_should_match_create(void)
+{
+    bname expected = bname_create("literal_name");
+    for (u32 i = 0; i < 3; ++i)
+    {
+        bname name = BNAME_LITERAL("Literal_Name");
+        expect_should_be(expected, name);
+    }
+    expect_string_to_be("literal_name", bname_string_get(BNAME_LITERAL("LITERAL_NAME")));
+
+    return true;
+}
+
+typedef struct bname_thread_params
+{
+    u32 thread_index;
+    u32 name_count;
+    volatile u32* ready_count;
+    u32 thread_count;
+    volatile b8 failed;
+} bname_thread_params;
+
+static u32 bname_thread_run(void* params)
+{
+    bname_thread_params* typed = params;
+
+    // Start together, to make contention likely
+    batomic_fetch_add_u32(typed->ready_count, 1);
+    while (batomic_load_u32(typed->ready_count) < typed->thread_count)
+        platform_sleep(0);
+
+    for (u32 i = 0; i < typed->name_count && !typed->failed; ++i)
+    {
+        // Half of the names are shared with every other thread, and half are this thread's own
+        char* str = (i % 2) ? string_format("threaded_name_%u_%u", typed->thread_index, i) : string_format("shared_name_%u", i);
+
+        bname name = bname_create(str);
+        const char* saved = bname_string_get(name);
+        if (!saved || !strings_equali(saved, str))
+            typed->failed = true;
+        string_free(str);
+    }
+    return 1;
+}
+
+u8 bname_should_create_from_threads(void)
+{
+    const u32 thread_count = 4;
+    const u32 name_count = 2000;
+    volatile u32 ready_count = 0;
+    bname_thread_params params[4] = {0};
+    bthread threads[4];
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        params[i].thread_index = i;
+        params[i].name_count = name_count;
+        params[i].ready_count = &ready_count;
+        params[i].thread_count = thread_count;
+        expect_to_be_true(bthread_create(bname_thread_run, &params[i], false, &threads[i]));
+    }
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        bthread_wait(&threads[i]);
+        bthread_destroy(&threads[i]);
+    }
+
+    for (u32 i = 0; i < thread_count; ++i)
+        expect_to_be_false(params[i].failed);
+
+    // Every name should be retrievable afterwards
+    for (u32 t = 0; t < thread_count; ++t)
+    {
+        for (u32 i = 1; i < name_count; i += 2)
+        {
+            char* str = string_format("threaded_name_%u_%u", t, i);
+            b8 found = strings_equal(str, bname_string_get(bname_create(str)));
+            string_free(str);
+            expect_to_be_true(found);
+        }
+    }
+
+    return true;
+}
+
+u8 bname_benchmark(void)
+{
+    const u32 name_count = 20000;
+    char** strings = platform_allocate(sizeof(char*) * name_count, false);
+    for (u32 i = 0; i < name_count; ++i)
+        strings[i] = string_format("Benchmark_Name_%u", i);
+
+    bclock clock = {0};
+    bclock_start(&clock);
+    for (u32 i = 0; i < name_count; ++i)
+        bname_create(strings[i]);
+    bclock_update(&clock);
+    f64 first_time = clock.elapsed;
+
+    // Existing names only need hashing and a lookup
+    bclock_start(&clock);
+    u64 sum = 0;
+    for (u32 i = 0; i < name_count; ++i)
+        sum += bname_create(strings[i]);
+    bclock_update(&clock);
+    f64 repeat_time = clock.elapsed;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < name_count; ++i)
+        sum += (u64)bname_string_get(bname_create(strings[i]));
+    bclock_update(&clock);
+    f64 lookup_time = clock.elapsed;
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < name_count; ++i)
+        sum += BNAME_LITERAL("benchmark_literal_name");
+    bclock_update(&clock);
+    f64 literal_time = clock.elapsed;
+
+    BINFO("bname x%u: first create %.3fms, repeat create %.3fms, create+string_get %.3fms, cached literal %.3fms (%llu)",
+          name_count, first_time * 1000.0, repeat_time * 1000.0, lookup_time * 1000.0, literal_time * 1000.0, sum & 1);
+
+    for (u32 i = 0; i < name_count; ++i)
+        string_free(strings[i]);
+    platform_free(strings, false);
+
+    return true;
+}
+
+void bname_register_tests(void)
+{
+    test_manager_register_test(bname_should_ignore_case, "bname should ignore case");
+    test_manager_register_test(bname_should_match_lowercase_copy_hash, "bname should hash the same as a lowercase copy");
+    test_manager_register_test(bname_should_keep_first_string, "bname should keep the first string it was created from");
+    test_manager_register_test(bname_literal_should_match_create, "bname literal should match bname_create");
+    test_manager_register_test(bname_should_create_from_threads, "bname should be created safely from several threads");
+    test_manager_register_test(bname_benchmark, "bname benchmark");
+}
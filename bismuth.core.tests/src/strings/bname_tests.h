@@ -0,0 +1,3 @@
+#pragma once
+
+void bname_register_tests(void);
@@ -0,0 +1,445 @@
+#include "string_float_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <strings/bstring.h>
+#include <time/bclock.h>
+
+#include <math.h>   // INFINITY, NAN
+#include <stdio.h>  // sscanf, snprintf
+#include <stdlib.h> // strtod, strtof
+#include <string.h> // memcmp
+
+// A small deterministic generator, so failures can be reproduced
+static u32 float_test_random(u32* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Checks that both float parsers agree with the C library to the bit, and consume the whole text
+static b8 float_parse_matches_library(const char* text)
+{
+    u64 length = string_length(text);
+    f64 d = 0;
+    f32 f = 0;
+    if (string_parse_f64(text, length, &d) != length || string_parse_f32(text, length, &f) != length)
+    {
+        BERROR("'%s' was not fully parsed", text);
+        return false;
+    }
+
+    f64 expected_d = strtod(text, 0);
+    f32 expected_f = strtof(text, 0);
+    if (memcmp(&d, &expected_d, sizeof(f64)) != 0 || memcmp(&f, &expected_f, sizeof(f32)) != 0)
+    {
+        BERROR("'%s' parsed as %.17g/%.9g, expected %.17g/%.9g", text, d, (f64)f, expected_d, (f64)expected_f);
+        return false;
+    }
+    return true;
+}
+
+u8 string_float_should_parse_exactly(void)
+{
+    const char* cases[] = {
+        "0", "-0", "0.0", "1", "-1", ".5", "-.5", "2.", "0.1", "0.2", "0.3", "3.14159265358979",
+        "123.456", "-0.000001", "1e10", "1E-10", "2.5e+3", "1e22", "1e23", "1e-22", "1e-23",
+        "16777216", "16777217", "16777219", "0.70710677", "0.7071067811865476", "33554431",
+        "9007199254740993", "123456789012345678901234567890", "0.000000000000000000000000000001",
+        "1.00000000000000000000000000001", "1e308", "1e-320", "1e400", "1e-400", "3.4028235e38",
+        "3.4028236e38", "1.17549435e-38", "1.4e-45", "7.038531e-26",
+        // Exactly halfway between two f32s, and either side of it
+        "1.000000059604644775390625", "1.000000059604644775390624", "1.000000059604644775390626",
+        "1.000000178813934326171875", "3.40282356779733661637539395458142568448e38",
+        // Exactly halfway between two f64s, and the largest and smallest of them
+        "9007199254740993.0", "9007199254740995", "1.7976931348623157e308", "1.7976931348623158e308",
+        "2.2250738585072011e-308", "2.2250738585072014e-308", "4.9406564584124654e-324", "2.4703282292062328e-324",
+        "2.4703282292062327e-324", "00000000000000000000000000000001.5", "0.000000000000000000000000000000000000000000000000000000000000000000000000000001e80"};
+    for (u32 i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+        expect_to_be_true(float_parse_matches_library(cases[i]));
+
+    // Far more digits than fit in the fast paths, which have to be taken into account to round correctly
+    char long_text[1024];
+    u32 seed = 1234;
+    for (u32 i = 0; i < 200; ++i)
+    {
+        u32 digit_count = 20 + float_test_random(&seed) % 900;
+        u32 n = 0;
+        for (u32 d = 0; d < digit_count; ++d)
+        {
+            if (d == 1)
+                long_text[n++] = '.';
+            long_text[n++] = (char)('0' + float_test_random(&seed) % 10);
+        }
+        n += string_format_to(long_text + n, sizeof(long_text) - n, "e%i", (i32)(float_test_random(&seed) % 700) - 350);
+        long_text[n] = 0;
+        expect_to_be_true(float_parse_matches_library(long_text));
+    }
+
+    // Random numbers, with anywhere from 1 to 20 significant digits, as written by hand or by printf
+    char text[64];
+    for (u32 i = 0; i < 20000; ++i)
+    {
+        u32 digit_count = 1 + float_test_random(&seed) % 20;
+        u32 point = float_test_random(&seed) % (digit_count + 1);
+        u32 n = 0;
+        if (float_test_random(&seed) & 1)
+            text[n++] = '-';
+        for (u32 d = 0; d < digit_count; ++d)
+        {
+            if (d == point)
+                text[n++] = '.';
+            text[n++] = (char)('0' + float_test_random(&seed) % 10);
+        }
+        if (float_test_random(&seed) % 4 == 0)
+            n += string_format_to(text + n, sizeof(text) - n, "e%i", (i32)(float_test_random(&seed) % 80) - 40);
+        text[n] = 0;
+        expect_to_be_true(float_parse_matches_library(text));
+    }
+
+    // Only as much as forms a number is consumed
+    f32 f = 0;
+    expect_should_be(3, string_parse_f32("1.5 2.5", 7, &f));
+    expect_float_to_be(1.5f, f);
+    expect_should_be(1, string_parse_f32("1e", 2, &f));
+    expect_should_be(1, string_parse_f32("1e+x", 4, &f));
+    expect_should_be(2, string_parse_f32("-2/3", 4, &f));
+    expect_float_to_be(-2.0f, f);
+    expect_should_be(4, string_parse_f32("0.25", 4, &f));
+    expect_float_to_be(0.25f, f);
+
+    // Not numbers at all
+    f = 7.0f;
+    expect_should_be(0, string_parse_f32("", 0, &f));
+    expect_should_be(0, string_parse_f32(".", 1, &f));
+    expect_should_be(0, string_parse_f32("-.", 2, &f));
+    expect_should_be(0, string_parse_f32("e5", 2, &f));
+    expect_should_be(0, string_parse_f32("nan", 3, &f));
+    expect_float_to_be(7.0f, f);
+
+    // Lists stop at the first value which is missing
+    f32 values[4] = {0};
+    expect_should_be(3, string_parse_f32_list(" 1.5\t-2 3e1 x 4", 15, values, 4));
+    expect_float_to_be(30.0f, values[2]);
+    expect_should_be(2, string_parse_f32_list("1 2 3", 5, values, 2));
+
+    // The string conversions skip leading whitespace, but reject anything else
+    expect_to_be_true(string_to_f32("  0.125", &f));
+    expect_float_to_be(0.125f, f);
+    expect_to_be_false(string_to_f32("abc", &f));
+    vec3 v;
+    expect_to_be_true(string_to_vec3("1 2.5 -3", &v));
+    expect_float_to_be(-3.0f, v.z);
+
+    return true;
+}
+
+// The number of significant digits in fixed notation text, i.e. 3 for "-0.0120"
+static u32 float_significant_digits(const char* text)
+{
+    u32 first = 0;
+    u32 last = 0;
+    u32 count = 0;
+    for (const char* c = text; *c; ++c)
+    {
+        if (*c < '0' || *c > '9')
+            continue;
+        count++;
+        if (*c != '0')
+        {
+            if (!first)
+                first = count;
+            last = count;
+        }
+    }
+    return first ? last - first + 1 : 1;
+}
+
+// The fewest significant digits with which printf writes text that parses back to the value
+static u32 float_library_shortest_f32(f32 value)
+{
+    char text[64];
+    for (i32 precision = 1; precision < 9; ++precision)
+    {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, (f64)value);
+        if (strtof(text, 0) == value)
+            return (u32)precision;
+    }
+    return 9;
+}
+
+static u32 float_library_shortest_f64(f64 value)
+{
+    char text[64];
+    for (i32 precision = 1; precision < 17; ++precision)
+    {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, 0) == value)
+            return (u32)precision;
+    }
+    return 17;
+}
+
+// Checks the value is printed with no more digits than it needs and that they parse back to it exactly, both here and in the C library
+static b8 float_print_round_trips_f32(f32 value)
+{
+    char text[STRING_F32_MAX_LENGTH + 1];
+    i32 length = string_format_f32(text, sizeof(text), value);
+    f32 parsed = 0;
+    f32 library = strtof(text, 0);
+    if (string_parse_f32(text, (u64)length, &parsed) != (u64)length || memcmp(&parsed, &value, sizeof(f32)) != 0 || memcmp(&library, &value, sizeof(f32)) != 0)
+    {
+        BERROR("%.9g was printed as '%s', which does not parse back to it", (f64)value, text);
+        return false;
+    }
+    u32 expected_digits = float_library_shortest_f32(value);
+    if (float_significant_digits(text) > expected_digits)
+    {
+        BERROR("%.9g was printed as '%s', but %u digits are enough", (f64)value, text, expected_digits);
+        return false;
+    }
+    return true;
+}
+
+static b8 float_print_round_trips_f64(f64 value)
+{
+    char text[STRING_F64_MAX_LENGTH + 1];
+    i32 length = string_format_f64(text, sizeof(text), value);
+    f64 parsed = 0;
+    f64 library = strtod(text, 0);
+    if (string_parse_f64(text, (u64)length, &parsed) != (u64)length || memcmp(&parsed, &value, sizeof(f64)) != 0 || memcmp(&library, &value, sizeof(f64)) != 0)
+    {
+        BERROR("%.17g was printed as '%s', which does not parse back to it", value, text);
+        return false;
+    }
+    u32 expected_digits = float_library_shortest_f64(value);
+    if (float_significant_digits(text) > expected_digits)
+    {
+        BERROR("%.17g was printed as '%s', but %u digits are enough", value, text, expected_digits);
+        return false;
+    }
+    return true;
+}
+
+u8 string_float_should_print_shortest_round_trip(void)
+{
+    char text[STRING_F64_MAX_LENGTH + 1];
+
+    // Always plain notation, with a digit either side of the point
+    string_format_f32(text, sizeof(text), 0.0f);
+    expect_string_to_be("0.0", text);
+    string_format_f32(text, sizeof(text), -0.0f);
+    expect_string_to_be("-0.0", text);
+    string_format_f32(text, sizeof(text), 1.0f);
+    expect_string_to_be("1.0", text);
+    string_format_f32(text, sizeof(text), 0.1f);
+    expect_string_to_be("0.1", text);
+    string_format_f32(text, sizeof(text), -100.0f);
+    expect_string_to_be("-100.0", text);
+    string_format_f32(text, sizeof(text), 123.456f);
+    expect_string_to_be("123.456", text);
+    string_format_f32(text, sizeof(text), 0.000015f);
+    expect_string_to_be("0.000015", text);
+    string_format_f32(text, sizeof(text), 16777216.0f);
+    expect_string_to_be("16777216.0", text);
+    string_format_f32(text, sizeof(text), 3.4028235e38f);
+    expect_string_to_be("340282350000000000000000000000000000000.0", text);
+    string_format_f32(text, sizeof(text), INFINITY);
+    expect_string_to_be("inf", text);
+    string_format_f32(text, sizeof(text), -INFINITY);
+    expect_string_to_be("-inf", text);
+    string_format_f32(text, sizeof(text), NAN);
+    expect_string_to_be("nan", text);
+    string_format_f64(text, sizeof(text), 0.1 + 0.2);
+    expect_string_to_be("0.30000000000000004", text);
+    string_format_f64(text, sizeof(text), 1e21);
+    expect_string_to_be("1000000000000000000000.0", text);
+
+    // The longest text each can produce
+    expect_should_be(STRING_F32_MAX_LENGTH, string_format_f32(text, sizeof(text), -1.4e-45f));
+    expect_should_be(STRING_F64_MAX_LENGTH, string_format_f64(text, sizeof(text), -4.9406564584124654e-324));
+
+    // Like string_format_to, the full length is returned even when truncated
+    char small[4];
+    expect_should_be(7, string_format_f32(small, sizeof(small), 123.456f));
+    expect_string_to_be("123", small);
+    expect_should_be(-1, string_format_f32(0, 0, 1.0f));
+
+    const f32 f32_cases[] = {1.0f, 0.3f, 1e-10f, 1.17549435e-38f, 1.4e-45f, 3.4028235e38f, 8388608.5f, 0.70710677f, 1.0e7f, 9.999999e-3f};
+    for (u32 i = 0; i < sizeof(f32_cases) / sizeof(f32_cases[0]); ++i)
+        expect_to_be_true(float_print_round_trips_f32(f32_cases[i]));
+    const f64 f64_cases[] = {1.0, 0.3, 1e-10, 2.2250738585072014e-308, 4.9406564584124654e-324, 1.7976931348623157e308, 9007199254740993.0, 5e-324, 1e23};
+    for (u32 i = 0; i < sizeof(f64_cases) / sizeof(f64_cases[0]); ++i)
+        expect_to_be_true(float_print_round_trips_f64(f64_cases[i]));
+
+    // Random bit patterns cover every exponent evenly, including subnormals
+    u32 seed = 4321;
+    for (u32 i = 0; i < 200000; ++i)
+    {
+        u32 bits = (float_test_random(&seed) << 8) ^ float_test_random(&seed);
+        f32 value;
+        bcopy_memory(&value, &bits, sizeof(f32));
+        if (!isfinite(value))
+            continue;
+        expect_to_be_true(float_print_round_trips_f32(value));
+    }
+    for (u32 i = 0; i < 20000; ++i)
+    {
+        u64 bits = ((u64)float_test_random(&seed) << 40) ^ ((u64)float_test_random(&seed) << 20) ^ float_test_random(&seed);
+        f64 value;
+        bcopy_memory(&value, &bits, sizeof(f64));
+        if (!isfinite(value))
+            continue;
+        expect_to_be_true(float_print_round_trips_f64(value));
+    }
+
+    // The string conversions round trip as well
+    vec4 v = {{0.1f, -2.5f, 1e-7f, 12345.678f}};
+    const char* v_text = vec4_to_string(v);
+    expect_string_to_be("0.1 -2.5 0.0000001 12345.678", v_text);
+    vec4 parsed;
+    expect_to_be_true(string_to_vec4(v_text, &parsed));
+    expect_to_be_true((memcmp(&v, &parsed, sizeof(vec4)) == 0));
+    string_free(v_text);
+
+    return true;
+}
+
+static void float_benchmark_report(const char* label, u64 bytes, u32 count, f64 seconds)
+{
+    if (seconds <= 0)
+        seconds = 1e-9;
+    BINFO("%s: %.1f MB/s, %.1f ns/value", label, ((f64)bytes / (1024.0 * 1024.0)) / seconds, (seconds * 1e9) / count);
+}
+
+u8 string_float_benchmark(void)
+{
+    // Values shaped like those in scenes and models: positions, rotations and small fractions
+    const u32 count = 200000;
+    f32* values = ballocate(sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    u32 seed = 99;
+    for (u32 i = 0; i < count; ++i)
+    {
+        switch (i % 3)
+        {
+        case 0:
+            values[i] = (f32)(float_test_random(&seed) % 2000000) / 1000.0f - 1000.0f;
+            break;
+        case 1:
+            values[i] = (f32)float_test_random(&seed) / (f32)(1 << 24);
+            break;
+        default:
+            values[i] = ((f32)float_test_random(&seed) - (f32)(1 << 23)) * 1e-9f;
+            break;
+        }
+    }
+
+    // All of them as %f would write them, and in shortest form, each terminated so the C library can parse them in place
+    u64 capacity = (u64)count * (STRING_F32_MAX_LENGTH + 1);
+    char* fixed_text = ballocate(capacity, MEMORY_TAG_STRING);
+    char* shortest_text = ballocate(capacity, MEMORY_TAG_STRING);
+    u64 fixed_length = 0;
+    u64 shortest_length = 0;
+
+    bclock clock;
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        fixed_length += (u64)string_format_to(fixed_text + fixed_length, capacity - fixed_length, "%f", (f64)values[i]) + 1;
+    bclock_update(&clock);
+    float_benchmark_report("print f32, %f", fixed_length, count, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        shortest_length += (u64)string_format_f32(shortest_text + shortest_length, capacity - shortest_length, values[i]) + 1;
+    bclock_update(&clock);
+    float_benchmark_report("print f32, shortest", shortest_length, count, clock.elapsed);
+
+    char f64_text[STRING_F64_MAX_LENGTH + 1];
+    u64 f64_length = 0;
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        f64_length += (u64)string_format_to(f64_text, sizeof(f64_text), "%.17g", (f64)values[i] / 3.0);
+    bclock_update(&clock);
+    float_benchmark_report("print f64, %.17g", f64_length, count, clock.elapsed);
+
+    f64_length = 0;
+    bclock_start(&clock);
+    for (u32 i = 0; i < count; ++i)
+        f64_length += (u64)string_format_f64(f64_text, sizeof(f64_text), (f64)values[i] / 3.0);
+    bclock_update(&clock);
+    float_benchmark_report("print f64, shortest", f64_length, count, clock.elapsed);
+
+    // Parsing it all back, each value checked against the one printed
+    f32 checksum = 0;
+    b8 exact = true;
+    bclock_start(&clock);
+    for (u64 i = 0; i < fixed_length;)
+    {
+        f32 v = 0;
+        sscanf(fixed_text + i, "%f", &v);
+        checksum += v;
+        i += string_length(fixed_text + i) + 1;
+    }
+    bclock_update(&clock);
+    float_benchmark_report("parse f32 (%f text), sscanf", fixed_length, count, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u64 i = 0; i < fixed_length;)
+    {
+        char* end;
+        checksum += strtof(fixed_text + i, &end);
+        i = (u64)(end - fixed_text) + 1;
+    }
+    bclock_update(&clock);
+    float_benchmark_report("parse f32 (%f text), strtof", fixed_length, count, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u64 i = 0; i < fixed_length;)
+    {
+        f32 v = 0;
+        i += string_parse_f32(fixed_text + i, fixed_length - i, &v) + 1;
+        checksum += v;
+    }
+    bclock_update(&clock);
+    float_benchmark_report("parse f32 (%f text), string_parse_f32", fixed_length, count, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u64 i = 0; i < shortest_length;)
+    {
+        char* end;
+        checksum += strtof(shortest_text + i, &end);
+        i = (u64)(end - shortest_text) + 1;
+    }
+    bclock_update(&clock);
+    float_benchmark_report("parse f32 (shortest text), strtof", shortest_length, count, clock.elapsed);
+
+    bclock_start(&clock);
+    u32 index = 0;
+    for (u64 i = 0; i < shortest_length; ++index)
+    {
+        f32 v = 0;
+        i += string_parse_f32(shortest_text + i, shortest_length - i, &v) + 1;
+        exact &= v == values[index];
+    }
+    bclock_update(&clock);
+    float_benchmark_report("parse f32 (shortest text), string_parse_f32", shortest_length, count, clock.elapsed);
+
+    BTRACE("Checksum: %f", (f64)checksum);
+    expect_to_be_true(exact);
+    expect_should_be(count, index);
+
+    bfree(shortest_text, capacity, MEMORY_TAG_STRING);
+    bfree(fixed_text, capacity, MEMORY_TAG_STRING);
+    bfree(values, sizeof(f32) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void string_float_register_tests(void)
+{
+    test_manager_register_test(string_float_should_parse_exactly, "String floats should parse exactly");
+    test_manager_register_test(string_float_should_print_shortest_round_trip, "String floats should print the shortest round trip");
+    test_manager_register_test(string_float_benchmark, "String float throughput benchmark");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void string_float_register_tests(void);
@@ -0,0 +1,231 @@
+#include "string_format_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <memory/frame_scratch.h>
+#include <strings/bstring.h>
+#include <time/bclock.h>
+
+static b8 string_format_memory_setup(void)
+{
+    memory_system_configuration config = {0};
+    config.total_alloc_size = MEBIBYTES(64);
+    return memory_system_initialize(config);
+}
+
+static void string_format_memory_teardown(void)
+{
+    memory_system_thread_release();
+    memory_system_shutdown();
+}
+
+// The total number of allocations made so far, across all tags
+static u64 allocations_made(void)
+{
+    memory_system_stats stats;
+    if (!memory_system_stats_get(&stats))
+        return 0;
+
+    u64 count = 0;
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
+        count += stats.tags[i].allocation_count;
+    return count;
+}
+
+u8 string_format_to_should_fit_and_truncate(void)
+{
+    char buffer[16];
+    expect_should_be(9, string_format_to(buffer, sizeof(buffer), "%s=%i", "value", 123));
+    expect_to_be_true(strings_equal("value=123", buffer));
+
+    // Too long, so cut short but still terminated, and the full length reported
+    expect_should_be(26, string_format_to(buffer, sizeof(buffer), "%s", "abcdefghijklmnopqrstuvwxyz"));
+    expect_should_be(15, string_length(buffer));
+    expect_to_be_true(strings_equal("abcdefghijklmno", buffer));
+
+    BDEBUG("Note: The following errors are intentionally caused by this test");
+    expect_should_be(-1, string_format_to(0, 16, "%i", 1));
+    expect_should_be(-1, string_format_to(buffer, 0, "%i", 1));
+    expect_should_be(0, string_format_with_allocator(0, "%i", 1));
+
+    return true;
+}
+
+u8 string_format_should_use_given_memory(void)
+{
+    expect_to_be_true(string_format_memory_setup());
+    expect_to_be_true(frame_scratch_initialize(KIBIBYTES(4)));
+
+    // Short and long results both come out whole from the heap version
+    char* short_str = string_format("%s %u", "short", 42u);
+    expect_to_be_true(strings_equal("short 42", short_str));
+    string_free(short_str);
+    char* long_str = string_format("%0300u", 7u);
+    expect_should_be(300, string_length(long_str));
+    expect_should_be('7', long_str[299]);
+    string_free(long_str);
+
+    // The thread's arenas are reserved on first use, so get that out of the way first
+    frame_scratch_allocate(1);
+    u64 before = allocations_made();
+    frame_allocator_int allocator = frame_scratch_allocator_get();
+    char* a = string_format_with_allocator(&allocator, "%s_%i", "name", 7);
+    char* b = string_format_scratch("%0400u", 9u);
+    expect_to_be_true(strings_equal("name_7", a));
+    expect_should_be(400, string_length(b));
+    // Neither touched the heap
+    expect_should_be(before, allocations_made());
+
+    frame_scratch_shutdown();
+    string_format_memory_teardown();
+    return true;
+}
+
+u8 bstring_should_build_without_allocating(void)
+{
+    expect_to_be_true(string_format_memory_setup());
+    u64 before = allocations_made();
+
+    // Short strings stay inline
+    bstring str;
+    bstring_create(&str);
+    expect_should_be(0, str.length);
+    expect_to_be_true(strings_equal("", str.data));
+    bstring_append_str(&str, "Hello");
+    bstring_append_char(&str, ',');
+    bstring_append_format(&str, " %s #%i", "world", 5);
+    expect_to_be_true(strings_equal("Hello, world #5", str.data));
+    expect_should_be(15, bstring_length(&str));
+    expect_to_be_false(str.owns_data);
+
+    // Fill the inline storage exactly
+    bstring_clear(&str);
+    for (u32 i = 0; i < BSTRING_INLINE_CAPACITY; ++i)
+        bstring_append_char(&str, 'a' + (i % 26));
+    expect_should_be(BSTRING_INLINE_CAPACITY, str.length);
+    expect_to_be_false(str.owns_data);
+    expect_should_be(before, allocations_made());
+
+    // One more moves it to the heap, keeping the contents
+    bstring_append_char(&str, '!');
+    expect_to_be_true(str.owns_data);
+    expect_should_be(BSTRING_INLINE_CAPACITY + 1, string_length(str.data));
+    expect_should_be('a', str.data[0]);
+    expect_should_be('!', str.data[BSTRING_INLINE_CAPACITY]);
+    bstring_destroy(&str);
+
+    // A caller-provided buffer is used until it is outgrown
+    before = allocations_made();
+    char buffer[128];
+    bstring_create_from_buffer(buffer, sizeof(buffer), &str);
+    expect_should_be(buffer, str.data);
+    bstring_append_format(&str, "%0100u", 1u);
+    expect_should_be(buffer, str.data);
+    expect_should_be(before, allocations_made());
+    // Formatting past the end grows and formats again
+    bstring_append_format(&str, "%050u", 2u);
+    expect_to_be_true(str.owns_data);
+    expect_should_be(150, str.length);
+    expect_should_be(150, string_length(str.data));
+    expect_should_be('1', str.data[99]);
+    expect_should_be('2', str.data[149]);
+
+    // Appending a string to itself
+    bstring_append_bstring(&str, &str);
+    expect_should_be(300, str.length);
+    expect_should_be('2', str.data[299]);
+    expect_to_be_true(strings_nequal(str.data, str.data + 150, 150));
+    bstring_destroy(&str);
+
+    bstring_from_cstring("from a c string", &str);
+    bstring_append_n(&str, "!!! not this", 3);
+    expect_to_be_true(strings_equal("from a c string!!!", str.data));
+    bstring_destroy(&str);
+
+    string_format_memory_teardown();
+    return true;
+}
+
+u8 string_format_benchmark(void)
+{
+    expect_to_be_true(string_format_memory_setup());
+    expect_to_be_true(frame_scratch_initialize(MEBIBYTES(4)));
+
+    // The kind of per-frame text a debug overlay or UI label is rebuilt from
+    const u32 iterations = 20000;
+    const char* format = "Drawn: %-5u (%-5u shadow pass) Pos=[%7.3f %7.3f %7.3f] Hovered: %s";
+    bclock clock;
+    u64 checksum = 0;
+
+    u64 allocations = allocations_made();
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        char* text = string_format(format, i, i / 2, i * 0.5f, 1.0f, -2.0f, "none");
+        checksum += text[7];
+        string_free(text);
+    }
+    bclock_update(&clock);
+    BINFO("string_format x%u: %.3fms, %llu allocations", iterations, clock.elapsed * 1000.0, allocations_made() - allocations);
+
+    allocations = allocations_made();
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        char text[256];
+        string_format_to(text, sizeof(text), format, i, i / 2, i * 0.5f, 1.0f, -2.0f, "none");
+        checksum += text[7];
+    }
+    bclock_update(&clock);
+    BINFO("string_format_to x%u: %.3fms, %llu allocations", iterations, clock.elapsed * 1000.0, allocations_made() - allocations);
+
+    // Reserve this thread's arenas up front, as would have happened on its first frame
+    frame_scratch_allocate(1);
+    allocations = allocations_made();
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        // Scratch memory is normally reclaimed every other frame
+        if (i % 1000 == 0)
+        {
+            frame_scratch_frame_advance();
+            frame_scratch_frame_advance();
+        }
+        char* text = string_format_scratch(format, i, i / 2, i * 0.5f, 1.0f, -2.0f, "none");
+        checksum += text[7];
+    }
+    bclock_update(&clock);
+    BINFO("string_format_scratch x%u: %.3fms, %llu allocations", iterations, clock.elapsed * 1000.0, allocations_made() - allocations);
+
+    allocations = allocations_made();
+    bclock_start(&clock);
+    for (u32 i = 0; i < iterations; ++i)
+    {
+        // Built up piece by piece, like a log line
+        char buffer[256];
+        bstring text;
+        bstring_create_from_buffer(buffer, sizeof(buffer), &text);
+        bstring_append_str(&text, "[INFO]:  ");
+        bstring_append_format(&text, format, i, i / 2, i * 0.5f, 1.0f, -2.0f, "none");
+        bstring_append_char(&text, '\n');
+        checksum += text.data[7];
+        bstring_destroy(&text);
+    }
+    bclock_update(&clock);
+    BINFO("bstring builder x%u: %.3fms, %llu allocations (%llu)", iterations, clock.elapsed * 1000.0, allocations_made() - allocations, checksum & 1);
+
+    frame_scratch_shutdown();
+    string_format_memory_teardown();
+    return true;
+}
+
+void string_format_register_tests(void)
+{
+    test_manager_register_test(string_format_to_should_fit_and_truncate, "string_format_to should fit or truncate safely");
+    test_manager_register_test(string_format_should_use_given_memory, "string_format variants should use the given memory");
+    test_manager_register_test(bstring_should_build_without_allocating, "bstring should only allocate once it outgrows its storage");
+    test_manager_register_test(string_format_benchmark, "string formatting allocation benchmark");
+}
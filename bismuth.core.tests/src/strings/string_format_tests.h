@@ -0,0 +1,3 @@
+#pragma once
+
+void string_format_register_tests(void);
@@ -0,0 +1,284 @@
+#include "string_scan_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <strings/bstring.h>
+#include <strings/bstring_scan.h>
+#include <time/bclock.h>
+
+#include <stdio.h> // sscanf
+
+// A small deterministic generator, so failures can be reproduced
+static u32 scan_test_random(u32* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Straightforward versions of each primitive, to check the vectorized ones against
+static u64 reference_find_any_of(const char* str, u64 length, const char* set, u32 set_count)
+{
+    for (u64 i = 0; i < length; ++i)
+    {
+        for (u32 s = 0; s < set_count; ++s)
+        {
+            if (str[i] == set[s])
+                return i;
+        }
+    }
+    return length;
+}
+
+static u64 reference_skip_any_of(const char* str, u64 length, const char* set, u32 set_count)
+{
+    for (u64 i = 0; i < length; ++i)
+    {
+        b8 found = false;
+        for (u32 s = 0; s < set_count; ++s)
+            found |= str[i] == set[s];
+        if (!found)
+            return i;
+    }
+    return length;
+}
+
+u8 string_scan_should_match_scalar_search(void)
+{
+    // Mostly characters from a small alphabet, so runs and matches of every length turn up. High bytes are included to
+    // make sure nothing treats characters as signed
+    const char alphabet[] = {' ', ' ', '\t', '\r', '\n', '0', '5', '9', 'a', '"', '\\', '/', '\0', (char)0xC3, (char)0xA9, '\v'};
+    const char* whitespace = " \t\n\v\f\r";
+    const char* digits = "0123456789";
+    const char* quote_set = "\"\\";
+    const char* large_set = "abcdefghijklmnopqrstuvwxyz\"/";
+    char buffer[160];
+    u32 seed = 1234;
+
+    for (u32 iteration = 0; iteration < 2000; ++iteration)
+    {
+        u32 length = scan_test_random(&seed) % sizeof(buffer);
+        // Longer runs of the same character are far more likely than chance
+        for (u32 i = 0; i < length;)
+        {
+            char c = alphabet[scan_test_random(&seed) % sizeof(alphabet)];
+            u32 run = 1 + scan_test_random(&seed) % 24;
+            for (u32 r = 0; r < run && i < length; ++r)
+                buffer[i++] = c;
+        }
+
+        // Start at different offsets so that loads are misaligned in every way
+        for (u32 offset = 0; offset < 4 && offset <= length; ++offset)
+        {
+            const char* str = buffer + offset;
+            u64 n = length - offset;
+            expect_should_be(reference_find_any_of(str, n, "\"", 1), string_scan_find_char(str, n, '"'));
+            expect_should_be(reference_find_any_of(str, n, "\0", 1), string_scan_find_char(str, n, '\0'));
+            expect_should_be(reference_find_any_of(str, n, "\n\r", 2), string_scan_find_newline(str, n));
+            expect_should_be(reference_find_any_of(str, n, quote_set, 2), string_scan_find_any_of(str, n, quote_set, 2));
+            expect_should_be(reference_find_any_of(str, n, "\n\0", 2), string_scan_find_any_of(str, n, "\n\0", 2));
+            expect_should_be(reference_find_any_of(str, n, large_set, 28), string_scan_find_any_of(str, n, large_set, 28));
+            expect_should_be(reference_skip_any_of(str, n, " \t\r", 3), string_scan_skip_any_of(str, n, " \t\r", 3));
+            expect_should_be(reference_skip_any_of(str, n, large_set, 28), string_scan_skip_any_of(str, n, large_set, 28));
+            expect_should_be(reference_skip_any_of(str, n, whitespace, 6), string_scan_skip_whitespace(str, n));
+            expect_should_be(reference_skip_any_of(str, n, digits, 10), string_scan_skip_digits(str, n));
+        }
+    }
+
+    // Empty sets and empty text
+    expect_should_be(5, string_scan_find_any_of("abcde", 5, "", 0));
+    expect_should_be(0, string_scan_skip_any_of("abcde", 5, "", 0));
+    expect_should_be(0, string_scan_find_char("", 0, 'a'));
+    expect_should_be(0, string_scan_skip_whitespace("", 0));
+
+    return true;
+}
+
+u8 string_scan_should_parse_integers(void)
+{
+    i64 value = 0;
+    expect_should_be(1, string_scan_parse_i64("0", 1, &value));
+    expect_should_be(0, value);
+    expect_should_be(3, string_scan_parse_i64("-17", 3, &value));
+    expect_should_be(-17, value);
+    expect_should_be(3, string_scan_parse_i64("+42", 3, &value));
+    expect_should_be(42, value);
+
+    // Stops at anything that isn't part of the number, including the end of the given length
+    expect_should_be(3, string_scan_parse_i64("123/456/789", 11, &value));
+    expect_should_be(123, value);
+    expect_should_be(2, string_scan_parse_i64("12345", 2, &value));
+    expect_should_be(12, value);
+
+    // Long enough to be read 8 digits at a time
+    expect_should_be(18, string_scan_parse_i64("123456789012345678 ", 19, &value));
+    expect_should_be(123456789012345678ll, value);
+    expect_should_be(19, string_scan_parse_i64("9223372036854775807", 19, &value));
+    expect_should_be(I64_MAX, value);
+    expect_should_be(20, string_scan_parse_i64("-9223372036854775808", 20, &value));
+    expect_to_be_true((value == I64_MIN));
+    expect_should_be(25, string_scan_parse_i64("0000000000000000000000042", 25, &value));
+    expect_should_be(42, value);
+
+    // Nothing to parse, or too large, leaves the value alone
+    value = 7;
+    expect_should_be(0, string_scan_parse_i64("", 0, &value));
+    expect_should_be(0, string_scan_parse_i64("-", 1, &value));
+    expect_should_be(0, string_scan_parse_i64("x1", 2, &value));
+    expect_should_be(0, string_scan_parse_i64("9223372036854775808", 19, &value));
+    expect_should_be(0, string_scan_parse_i64("-9223372036854775809", 20, &value));
+    expect_should_be(0, string_scan_parse_i64("99999999999999999999999", 23, &value));
+    expect_should_be(7, value);
+
+    return true;
+}
+
+static void scan_benchmark_report(const char* label, u64 bytes, f64 seconds)
+{
+    BINFO("%s: %.1f MB/s", label, ((f64)bytes / (1024.0 * 1024.0)) / (seconds > 0 ? seconds : 1e-9));
+}
+
+u8 string_scan_benchmark(void)
+{
+    // Text shaped like an OBJ file: vertex positions, normals and texture coordinates, then faces
+    const u32 line_count = 100000;
+    u64 capacity = (u64)line_count * 64;
+    char* text = ballocate(capacity, MEMORY_TAG_STRING);
+    u64 length = 0;
+    u32 seed = 42;
+    for (u32 i = 0; i < line_count; ++i)
+    {
+        f32 x = (f32)(scan_test_random(&seed) % 200000) / 1000.0f - 100.0f;
+        f32 y = (f32)(scan_test_random(&seed) % 200000) / 1000.0f - 100.0f;
+        f32 z = (f32)(scan_test_random(&seed) % 1000000) / 1000000.0f;
+        if (i % 4 == 3)
+            length += string_format_to(text + length, capacity - length, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", i, i, i, i + 1, i + 1, i + 1, i + 2, i + 2, i + 2);
+        else
+            length += string_format_to(text + length, capacity - length, "v %f %f %f\n", x, y, z);
+    }
+
+    bclock clock;
+    u64 lines = 0;
+    u64 checksum = 0;
+    const u32 passes = 10;
+
+    // Finding line ends, one character at a time and with the scanner
+    bclock_start(&clock);
+    for (u32 pass = 0; pass < passes; ++pass)
+    {
+        for (u64 i = 0; i < length; ++i)
+            lines += text[i] == '\n' || text[i] == '\r';
+    }
+    bclock_update(&clock);
+    scan_benchmark_report("find newline, scalar", length * passes, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u32 pass = 0; pass < passes; ++pass)
+    {
+        for (u64 i = 0; i < length; ++i)
+        {
+            i += string_scan_find_newline(text + i, length - i);
+            lines += i < length;
+        }
+    }
+    bclock_update(&clock);
+    scan_benchmark_report("find newline, scanner", length * passes, clock.elapsed);
+
+    // Long whitespace runs, as in indented text
+    u64 space_length = MEBIBYTES(1);
+    char* spaces = ballocate(space_length, MEMORY_TAG_STRING);
+    for (u64 i = 0; i < space_length; ++i)
+        spaces[i] = (i % 64 == 63) ? 'x' : ((i % 7) ? ' ' : '\t');
+    bclock_start(&clock);
+    for (u32 pass = 0; pass < passes; ++pass)
+    {
+        for (u64 i = 0; i < space_length; ++i)
+        {
+            while (i < space_length && (spaces[i] == ' ' || spaces[i] == '\t'))
+                i++;
+            checksum += i;
+        }
+    }
+    bclock_update(&clock);
+    scan_benchmark_report("skip whitespace (63 character runs), scalar", space_length * passes, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u32 pass = 0; pass < passes; ++pass)
+    {
+        for (u64 i = 0; i < space_length; ++i)
+            i += string_scan_skip_whitespace(spaces + i, space_length - i);
+    }
+    bclock_update(&clock);
+    scan_benchmark_report("skip whitespace (63 character runs), scanner", space_length * passes, clock.elapsed);
+    bfree(spaces, space_length, MEMORY_TAG_STRING);
+
+    // Parsing every number in the text, first through sscanf a line at a time as the OBJ importer used to
+    bclock_start(&clock);
+    char line[128];
+    for (u64 i = 0; i < length;)
+    {
+        u64 end = i + string_scan_find_newline(text + i, length - i);
+        u64 line_length = BMIN(end - i, sizeof(line) - 1);
+        bcopy_memory(line, text + i, line_length);
+        line[line_length] = 0;
+        if (line[0] == 'v')
+        {
+            char t[2];
+            f32 v[3];
+            sscanf(line, "%s %f %f %f", t, &v[0], &v[1], &v[2]);
+            checksum += (u64)v[0];
+        }
+        else
+        {
+            char t[2];
+            i32 f[9];
+            sscanf(line, "%s %d/%d/%d %d/%d/%d %d/%d/%d", t, &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8]);
+            checksum += f[0];
+        }
+        i = end + 1;
+    }
+    bclock_update(&clock);
+    scan_benchmark_report("OBJ-style numbers, sscanf", length, clock.elapsed);
+
+    bclock_start(&clock);
+    for (u64 i = 0; i < length;)
+    {
+        u64 end = i + string_scan_find_newline(text + i, length - i);
+        b8 vertex = text[i] == 'v';
+        u64 p = i + 1;
+        for (u32 n = 0; n < (vertex ? 3u : 9u) && p < end; ++n)
+        {
+            p += string_scan_skip_any_of(text + p, end - p, vertex ? " " : " /", vertex ? 1 : 2);
+            if (vertex)
+            {
+                f32 v = 0;
+                p += string_parse_f32(text + p, end - p, &v);
+                checksum += (u64)v;
+            }
+            else
+            {
+                i64 f = 0;
+                p += string_scan_parse_i64(text + p, end - p, &f);
+                checksum += (u64)f;
+            }
+        }
+        i = end + 1;
+    }
+    bclock_update(&clock);
+    scan_benchmark_report("OBJ-style numbers, scanner", length, clock.elapsed);
+
+    BTRACE("Checksum: %llu, lines: %llu", checksum, lines);
+    expect_should_be(line_count * passes * 2, lines);
+
+    bfree(text, capacity, MEMORY_TAG_STRING);
+    return true;
+}
+
+void string_scan_register_tests(void)
+{
+    test_manager_register_test(string_scan_should_match_scalar_search, "String scanning should match a scalar search");
+    test_manager_register_test(string_scan_should_parse_integers, "String scanning should parse integers");
+    test_manager_register_test(string_scan_benchmark, "String scanning throughput benchmark");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void string_scan_register_tests(void);
@@ -0,0 +1,645 @@
+#include "job_system_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <math/geometry.h>
+#include <math/bmath.h>
+#include <memory/bmemory.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+#include <threads/batomic.h>
+#include <threads/bparallel.h>
+#include <threads/bthread.h>
+#include <time/bclock.h>
+
+static void* job_system_state_block;
+static u64 job_system_state_size;
+
+static b8 test_job_system_start(u8 thread_count, u32* type_masks)
+{
+    job_system_config config = {0};
+    config.max_job_thread_count = thread_count;
+    config.type_masks = type_masks;
+    job_system_initialize(&job_system_state_size, 0, &config);
+    job_system_state_block = ballocate(job_system_state_size, MEMORY_TAG_ENGINE);
+    return job_system_initialize(&job_system_state_size, job_system_state_block, &config);
+}
+
+static void test_job_system_stop(void)
+{
+    job_system_shutdown(job_system_state_block);
+    bfree(job_system_state_block, job_system_state_size, MEMORY_TAG_ENGINE);
+    job_system_state_block = 0;
+}
+
+// Spins on the calling thread until the counter hits the target or the timeout passes
+static b8 wait_for_count(volatile u32* counter, u32 target, f64 timeout_seconds)
+{
+    bclock clock;
+    bclock_start(&clock);
+    while (batomic_load_u32(counter) < target)
+    {
+        bclock_update(&clock);
+        if (clock.elapsed > timeout_seconds)
+            return false;
+        platform_sleep(0);
+    }
+    return true;
+}
+
+static volatile u32 counter;
+
+static b8 job_increment(void* params, void* result)
+{
+    batomic_fetch_add_u32(&counter, 1);
+    return true;
+}
+
+typedef struct thread_record_params
+{
+    volatile u64* out_thread_id;
+} thread_record_params;
+
+static b8 job_record_thread(void* params, void* result)
+{
+    thread_record_params* typed = params;
+    *typed->out_thread_id = platform_current_thread_id();
+    batomic_fetch_add_u32(&counter, 1);
+    return true;
+}
+
+u8 job_system_should_run_all_jobs(void)
+{
+    u32 masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+
+    counter = 0;
+    const u32 job_count = 1000;
+    for (u32 i = 0; i < job_count; ++i)
+    {
+        job_priority priority = (job_priority)(i % 3);
+        job_system_submit(job_create_priority(job_increment, 0, 0, 0, 0, 0, JOB_TYPE_GENERAL, priority));
+    }
+
+    // No job_system_update needed: threads pick up work on their own
+    expect_to_be_true(wait_for_count(&counter, job_count, 10.0));
+    expect_should_be(job_count, batomic_load_u32(&counter));
+
+    test_job_system_stop();
+    return true;
+}
+
+u8 job_system_should_honor_type_masks(void)
+{
+    // Only the first thread may run GPU work, all others take general work only
+    u32 masks[4] = {JOB_TYPE_GPU_RESOURCE, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+
+    counter = 0;
+    const u32 job_count = 256;
+    volatile u64 thread_ids[256] = {0};
+    for (u32 i = 0; i < job_count; ++i)
+    {
+        thread_record_params params = {&thread_ids[i]};
+        job_type type = (i & 1) ? JOB_TYPE_GPU_RESOURCE : JOB_TYPE_GENERAL;
+        job_system_submit(job_create_type(job_record_thread, 0, 0, &params, sizeof(thread_record_params), 0, type));
+    }
+    expect_to_be_true(wait_for_count(&counter, job_count, 10.0));
+
+    // Every GPU job ran on the same thread, and no general job ran there
+    u64 gpu_thread = thread_ids[1];
+    expect_should_not_be(0, gpu_thread);
+    for (u32 i = 0; i < job_count; ++i)
+    {
+        if (i & 1)
+        {
+            expect_should_be(gpu_thread, thread_ids[i]);
+        }
+        else
+        {
+            expect_should_not_be(gpu_thread, thread_ids[i]);
+        }
+    }
+
+    test_job_system_stop();
+    return true;
+}
+
+typedef struct dependency_params
+{
+    job_handle dependency;
+    volatile u32* out_dependency_was_complete;
+} dependency_params;
+
+static b8 job_slow(void* params, void* result)
+{
+    platform_sleep(20);
+    batomic_fetch_add_u32(&counter, 1);
+    return true;
+}
+
+static b8 job_check_dependency(void* params, void* result)
+{
+    dependency_params* typed = params;
+    batomic_store_u32(typed->out_dependency_was_complete, job_system_query_job_complete(typed->dependency));
+    batomic_fetch_add_u32(&counter, 1);
+    return true;
+}
+
+u8 job_system_should_wait_for_dependencies(void)
+{
+    u32 masks[2] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(2, masks));
+
+    counter = 0;
+    volatile u32 dependency_was_complete = false;
+    job_info first = job_create(job_slow, 0, 0, 0, 0, 0);
+    dependency_params params = {first.handle, &dependency_was_complete};
+    job_info second = job_create_with_dependencies(job_check_dependency, 0, 0, &params, sizeof(dependency_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_HIGH, 1, &first.handle);
+
+    // Submit the dependent job first so it is definitely picked up before its dependency completes
+    job_system_submit(second);
+    job_system_submit(first);
+    expect_to_be_true(wait_for_count(&counter, 2, 10.0));
+    expect_to_be_true(batomic_load_u32(&dependency_was_complete));
+    // The counter is bumped from inside the job, so it may not be marked complete just yet
+    expect_to_be_true(job_system_wait_for_jobs(1, &second.handle));
+    expect_to_be_true(job_system_query_job_complete(first.handle));
+    expect_to_be_true(job_system_query_job_complete(second.handle));
+
+    test_job_system_stop();
+    return true;
+}
+
+typedef struct stage_params
+{
+    volatile u32* previous_stage_done;
+    u32 previous_stage_expected;
+    volatile u32* stage_done;
+    volatile u32* order_violations;
+} stage_params;
+
+// Checks that the whole previous stage finished before this one started
+static b8 job_stage(void* params, void* result)
+{
+    stage_params* typed = params;
+    if (typed->previous_stage_done && batomic_load_u32(typed->previous_stage_done) != typed->previous_stage_expected)
+        batomic_fetch_add_u32(typed->order_violations, 1);
+    batomic_fetch_add_u32(typed->stage_done, 1);
+    return true;
+}
+
+u8 job_system_should_run_dependency_graph(void)
+{
+    u32 masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+
+    // cull (many) -> sort (one) -> build (many), expressed purely as dependencies
+    const u32 cull_count = 64;
+    const u32 build_count = 32;
+    volatile u32 cull_done = 0, sort_done = 0, build_done = 0, violations = 0;
+    job_counter counter = {0};
+
+    job_handle cull_handles[64];
+    job_info cull_jobs[64];
+    stage_params cull_params = {0, 0, &cull_done, &violations};
+    for (u32 i = 0; i < cull_count; ++i)
+    {
+        cull_jobs[i] = job_create(job_stage, 0, 0, &cull_params, sizeof(stage_params), 0);
+        cull_handles[i] = cull_jobs[i].handle;
+    }
+
+    stage_params sort_params = {&cull_done, cull_count, &sort_done, &violations};
+    job_info sort_job = job_create_with_dependencies(job_stage, 0, 0, &sort_params, sizeof(stage_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_NORMAL, (u8)cull_count, cull_handles);
+
+    // Submit the later stages first to make sure they really are held back
+    stage_params build_params = {&sort_done, 1, &build_done, &violations};
+    for (u32 i = 0; i < build_count; ++i)
+        job_system_submit_with_counter(job_create_with_dependencies(job_stage, 0, 0, &build_params, sizeof(stage_params), 0, JOB_TYPE_GENERAL, JOB_PRIORITY_NORMAL, 1, &sort_job.handle), &counter);
+    job_system_submit_with_counter(sort_job, &counter);
+    for (u32 i = 0; i < cull_count; ++i)
+        job_system_submit_with_counter(cull_jobs[i], &counter);
+
+    job_system_wait_for_counter(&counter);
+    expect_should_be(0, counter.value);
+    expect_should_be(cull_count, cull_done);
+    expect_should_be(1, sort_done);
+    expect_should_be(build_count, build_done);
+    expect_should_be(0, violations);
+
+    test_job_system_stop();
+    return true;
+}
+
+static volatile u32 blocker_release;
+
+static b8 job_blocker(void* params, void* result)
+{
+    while (!batomic_load_u32(&blocker_release))
+        platform_sleep(0);
+    return true;
+}
+
+typedef struct nested_params
+{
+    u32 children;
+    volatile u32* out_children_done;
+} nested_params;
+
+// Waits on its own children from inside a job. With a single job thread this only completes if the wait helps
+static b8 job_wait_on_children(void* params, void* result)
+{
+    nested_params* typed = params;
+    job_counter children = {0};
+    for (u32 i = 0; i < typed->children; ++i)
+        job_system_submit_with_counter(job_create(job_increment, 0, 0, 0, 0, 0), &children);
+    job_system_wait_for_counter(&children);
+    batomic_store_u32(typed->out_children_done, batomic_load_u32(&counter));
+    return true;
+}
+
+u8 job_system_wait_should_help(void)
+{
+    u32 masks[1] = {JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(1, masks));
+
+    // Occupy the only job thread, then wait on more work from the main thread, which must run it itself
+    blocker_release = 0;
+    counter = 0;
+    job_info blocker = job_create(job_blocker, 0, 0, 0, 0, 0);
+    job_system_submit(blocker);
+    platform_sleep(10);
+    job_counter group = {0};
+    for (u32 i = 0; i < 100; ++i)
+        job_system_submit_with_counter(job_create(job_increment, 0, 0, 0, 0, 0), &group);
+    job_system_wait_for_counter(&group);
+    expect_should_be(100, counter);
+
+    batomic_store_u32(&blocker_release, 1);
+    expect_to_be_true(job_system_wait_for_jobs(1, &blocker.handle));
+
+    // A job waiting on children it spawned on its own thread
+    counter = 0;
+    volatile u32 children_done = 0;
+    nested_params params = {50, &children_done};
+    job_info parent = job_create(job_wait_on_children, 0, 0, &params, sizeof(nested_params), 0);
+    job_system_submit(parent);
+    expect_to_be_true(job_system_wait_for_jobs(1, &parent.handle));
+    expect_should_be(50, children_done);
+
+    test_job_system_stop();
+    return true;
+}
+
+typedef struct spawn_params
+{
+    u32 children;
+} spawn_params;
+
+// Submits more jobs from inside a job, which land on the running thread's own queue
+static b8 job_spawn(void* params, void* result)
+{
+    spawn_params* typed = params;
+    for (u32 i = 0; i < typed->children; ++i)
+        job_system_submit(job_create(job_increment, 0, 0, 0, 0, 0));
+    batomic_fetch_add_u32(&counter, 1);
+    return true;
+}
+
+u8 job_system_throughput_benchmark(void)
+{
+    const u32 job_count = 20000;
+    i32 processor_count = platform_get_processor_count();
+    // NOTE: Always run at least 4 threads, even on machines with fewer cores, so stealing actually gets exercised
+    u32 max_threads = (u32)BCLAMP(processor_count, 4, 15);
+    u32 masks[15];
+    for (u32 i = 0; i < 15; ++i)
+        masks[i] = JOB_TYPE_GENERAL;
+
+    for (u32 thread_count = 1;; thread_count = BMIN(thread_count * 2, max_threads))
+    {
+        expect_to_be_true(test_job_system_start((u8)thread_count, masks));
+
+        // Tiny jobs submitted from the main thread
+        counter = 0;
+        bclock clock;
+        bclock_start(&clock);
+        for (u32 i = 0; i < job_count; ++i)
+            job_system_submit(job_create(job_increment, 0, 0, 0, 0, 0));
+        expect_to_be_true(wait_for_count(&counter, job_count, 60.0));
+        bclock_update(&clock);
+        f64 main_submit_time = clock.elapsed;
+
+        // Tiny jobs fanned out from within jobs, so they must be stolen to spread across threads
+        counter = 0;
+        const u32 spawners = 16;
+        spawn_params params = {(job_count / spawners) - 1};
+        bclock_start(&clock);
+        for (u32 i = 0; i < spawners; ++i)
+            job_system_submit(job_create(job_spawn, 0, 0, &params, sizeof(spawn_params), 0));
+        expect_to_be_true(wait_for_count(&counter, job_count, 60.0));
+        bclock_update(&clock);
+        f64 nested_time = clock.elapsed;
+
+        BINFO("Job throughput (%u threads): main-submitted %.0f jobs/s, job-spawned %.0f jobs/s",
+              thread_count, job_count / main_submit_time, job_count / nested_time);
+
+        test_job_system_stop();
+        if (thread_count == max_threads)
+            break;
+    }
+
+    return true;
+}
+
+u8 job_system_handles_should_recycle(void)
+{
+    u32 masks[2] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(2, masks));
+
+    // Well past what a 16-bit id could ever count to
+    counter = 0;
+    const u32 job_count = 200000;
+    job_handle first = job_handle_invalid();
+    job_handle last = job_handle_invalid();
+    for (u32 i = 0; i < job_count; ++i)
+    {
+        job_info info = job_create(job_increment, 0, 0, 0, 0, 0);
+        if (i == 0)
+            first = info.handle;
+        last = info.handle;
+        job_system_submit(info);
+    }
+    expect_to_be_true(wait_for_count(&counter, job_count, 60.0));
+    expect_to_be_true(job_system_wait_for_jobs(1, &last));
+    expect_to_be_true(job_system_query_job_complete(first));
+
+    // Once complete, a slot is reused under a new generation. The old handle must stay complete
+    job_info blocker = job_create(job_blocker, 0, 0, 0, 0, 0);
+    blocker_release = false;
+    job_system_submit(blocker);
+    expect_to_be_true(job_system_query_job_complete(first));
+    expect_to_be_false(job_system_query_job_complete(blocker.handle));
+    batomic_store_u32(&blocker_release, true);
+    expect_to_be_true(job_system_wait_for_jobs(1, &blocker.handle));
+
+    // Invalid handles never hold anything up
+    job_handle invalid = job_handle_invalid();
+    expect_to_be_true(job_system_query_job_complete(invalid));
+
+    test_job_system_stop();
+    return true;
+}
+
+typedef struct result_payload
+{
+    u32 value;
+    // Pads results past the inline size on request, so both storage paths get used
+    u8 padding[120];
+} result_payload;
+
+static volatile u32 result_callback_count;
+static volatile u64 result_callback_sum;
+
+static b8 job_produce_result(void* params, void* result)
+{
+    u32 value = *(u32*)params;
+    ((result_payload*)result)->value = value;
+    return (value % 5) != 0;
+}
+
+static void job_result_callback(void* params)
+{
+    result_payload* typed = params;
+    result_callback_count++;
+    result_callback_sum += typed->value;
+}
+
+u8 job_system_should_run_completion_callbacks(void)
+{
+    u32 masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+
+    // More results than the completion ring holds, so some spill into overflow before the update runs
+    const u32 job_count = 3000;
+    job_counter jobs = {0};
+    result_callback_count = 0;
+    result_callback_sum = 0;
+    u64 expected_sum = 0;
+    for (u32 i = 0; i < job_count; ++i)
+    {
+        u32 value = i + 1;
+        expected_sum += value;
+        u32 result_size = (i & 1) ? sizeof(result_payload) : sizeof(u32);
+        job_system_submit_with_counter(job_create(job_produce_result, job_result_callback, job_result_callback, &value, sizeof(u32), result_size), &jobs);
+    }
+    job_system_wait_for_counter(&jobs);
+
+    // Callbacks only ever run from the update
+    expect_should_be(0, result_callback_count);
+    expect_to_be_true(job_system_update(job_system_state_block, 0));
+    expect_should_be(job_count, result_callback_count);
+    expect_should_be(expected_sum, result_callback_sum);
+
+    // Nothing left over, so another update does nothing
+    expect_to_be_true(job_system_update(job_system_state_block, 0));
+    expect_should_be(job_count, result_callback_count);
+
+    test_job_system_stop();
+    return true;
+}
+
+typedef struct range_hits
+{
+    volatile u32* hits;
+    volatile u32 calls;
+} range_hits;
+
+static void range_record_hits(u32 begin, u32 end, void* user)
+{
+    range_hits* typed = user;
+    batomic_fetch_add_u32(&typed->calls, 1);
+    for (u32 i = begin; i < end; ++i)
+        batomic_fetch_add_u32(&typed->hits[i], 1);
+}
+
+// Runs a parallel-for over count items and checks every item was visited exactly once
+static b8 parallel_for_covers_range(u32 count, u32 grain, u32 expected_calls)
+{
+    range_hits context = {0};
+    context.hits = ballocate(sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    job_system_parallel_for(count, grain, range_record_hits, &context);
+
+    b8 result = true;
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (context.hits[i] != 1)
+        {
+            BERROR("Item %u of %u visited %u times (grain %u)", i, count, context.hits[i], grain);
+            result = false;
+            break;
+        }
+    }
+    if (expected_calls && context.calls != expected_calls)
+    {
+        BERROR("Expected %u chunks but got %u (count %u, grain %u)", expected_calls, context.calls, count, grain);
+        result = false;
+    }
+
+    bfree((void*)context.hits, sizeof(u32) * count, MEMORY_TAG_ARRAY);
+    return result;
+}
+
+u8 job_system_parallel_for_should_cover_range(void)
+{
+    // Without a running job system everything runs on the calling thread, in one go
+    expect_to_be_true(parallel_for_covers_range(1000, 10, 1));
+
+    u32 masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_RESOURCE_LOAD, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+
+    expect_to_be_true(parallel_for_covers_range(10007, 1, 10007));
+    expect_to_be_true(parallel_for_covers_range(10007, 64, 157));
+    expect_to_be_true(parallel_for_covers_range(10007, 10006, 2));
+    // A range that fits in a single chunk is not split up
+    expect_to_be_true(parallel_for_covers_range(10007, 10007, 1));
+    expect_to_be_true(parallel_for_covers_range(10007, 0, 10007));
+    expect_to_be_true(parallel_for_covers_range(1, 64, 1));
+
+    test_job_system_stop();
+    return true;
+}
+
+typedef struct nested_range_context
+{
+    volatile u32 total;
+} nested_range_context;
+
+static void range_count_items(u32 begin, u32 end, void* user)
+{
+    nested_range_context* typed = user;
+    batomic_fetch_add_u32(&typed->total, end - begin);
+}
+
+static void range_spawn_inner(u32 begin, u32 end, void* user)
+{
+    for (u32 i = begin; i < end; ++i)
+        job_system_parallel_for(100, 7, range_count_items, user);
+}
+
+u8 job_system_parallel_for_should_nest(void)
+{
+    u32 masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+
+    // Workers running the outer loop help with the inner loops rather than blocking on them
+    nested_range_context context = {0};
+    job_system_parallel_for(64, 1, range_spawn_inner, &context);
+    expect_should_be(64 * 100, context.total);
+
+    test_job_system_stop();
+    return true;
+}
+
+// Builds a grid of quads with varied texture coordinates so tangents differ between triangles
+static void tangent_test_mesh_create(u32 quads_per_side, vertex_3d** out_vertices, u32* out_vertex_count, u32** out_indices, u32* out_index_count)
+{
+    u32 side = quads_per_side + 1;
+    *out_vertex_count = side * side;
+    *out_index_count = quads_per_side * quads_per_side * 6;
+    vertex_3d* vertices = ballocate(sizeof(vertex_3d) * (*out_vertex_count), MEMORY_TAG_ARRAY);
+    u32* indices = ballocate(sizeof(u32) * (*out_index_count), MEMORY_TAG_ARRAY);
+    for (u32 z = 0; z < side; ++z)
+    {
+        for (u32 x = 0; x < side; ++x)
+        {
+            vertex_3d* v = &vertices[z * side + x];
+            v->position = (vec3){(f32)x, bsin((f32)(x * z) * 0.1f), (f32)z};
+            v->texcoord = (vec2){(f32)x * 0.5f + bcos((f32)z), (f32)z * 0.25f};
+        }
+    }
+    for (u32 z = 0, i = 0; z < quads_per_side; ++z)
+    {
+        for (u32 x = 0; x < quads_per_side; ++x, i += 6)
+        {
+            u32 v0 = z * side + x;
+            indices[i + 0] = v0 + side;
+            indices[i + 1] = v0 + 1;
+            indices[i + 2] = v0;
+            indices[i + 3] = v0 + side + 1;
+            indices[i + 4] = v0 + 1;
+            indices[i + 5] = v0 + side;
+        }
+    }
+    *out_vertices = vertices;
+    *out_indices = indices;
+}
+
+u8 job_system_parallel_tangents_should_match_serial(void)
+{
+    u32 masks[4] = {JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL, JOB_TYPE_GENERAL};
+    expect_to_be_true(test_job_system_start(4, masks));
+    expect_to_be_true(bparallel_for_available());
+
+    vertex_3d* serial;
+    vertex_3d* parallel;
+    u32* indices;
+    u32* parallel_indices;
+    u32 vertex_count;
+    u32 index_count;
+    tangent_test_mesh_create(256, &serial, &vertex_count, &indices, &index_count);
+    tangent_test_mesh_create(256, &parallel, &vertex_count, &parallel_indices, &index_count);
+
+    bclock clock;
+    bclock_start(&clock);
+    geometry_generate_tangents(vertex_count, serial, index_count, indices);
+    bclock_update(&clock);
+    f64 serial_time = clock.elapsed;
+
+    bclock_start(&clock);
+    geometry_generate_tangents_parallel(vertex_count, parallel, index_count, parallel_indices);
+    bclock_update(&clock);
+    f64 parallel_time = clock.elapsed;
+
+    BINFO("Tangents for %u triangles: serial %.3fms, parallel %.3fms", index_count / 3, serial_time * 1000.0, parallel_time * 1000.0);
+
+    // Same math in the same order per vertex, so results should be bit for bit identical
+    b8 identical = true;
+    for (u32 i = 0; i < vertex_count; ++i)
+    {
+        vec4 a = serial[i].tangent;
+        vec4 b = parallel[i].tangent;
+        if (a.x != b.x || a.y != b.y || a.z != b.z || a.w != b.w)
+        {
+            identical = false;
+            break;
+        }
+    }
+    expect_to_be_true(identical);
+
+    bfree(serial, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    bfree(parallel, sizeof(vertex_3d) * vertex_count, MEMORY_TAG_ARRAY);
+    bfree(indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+    bfree(parallel_indices, sizeof(u32) * index_count, MEMORY_TAG_ARRAY);
+
+    test_job_system_stop();
+    expect_to_be_false(bparallel_for_available());
+    return true;
+}
+
+void job_system_register_tests(void)
+{
+    test_manager_register_test(job_system_should_run_all_jobs, "Job system should run all submitted jobs without an update");
+    test_manager_register_test(job_system_should_honor_type_masks, "Job system should only run jobs on threads with a matching type mask");
+    test_manager_register_test(job_system_should_wait_for_dependencies, "Job system should not start a job before its dependencies complete");
+    test_manager_register_test(job_system_should_run_dependency_graph, "Job system should run a dependency graph as continuations");
+    test_manager_register_test(job_system_wait_should_help, "Job system waits should run other jobs while waiting");
+    test_manager_register_test(job_system_throughput_benchmark, "Job system throughput benchmark");
+    test_manager_register_test(job_system_handles_should_recycle, "Job system handles should recycle without running out");
+    test_manager_register_test(job_system_should_run_completion_callbacks, "Job system should run every completion callback on update");
+    test_manager_register_test(job_system_parallel_for_should_cover_range, "Job system parallel-for should visit every item exactly once");
+    test_manager_register_test(job_system_parallel_for_should_nest, "Job system parallel-for should work when nested");
+    test_manager_register_test(job_system_parallel_tangents_should_match_serial, "Parallel tangent generation should match serial");
+}
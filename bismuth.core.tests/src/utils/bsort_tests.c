@@ -0,0 +1,278 @@
+#include "bsort_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <time/bclock.h>
+#include <utils/bsort.h>
+
+typedef struct sort_item
+{
+    u32 key;
+    u32 original_index;
+    f32 padding[6];
+} sort_item;
+
+#define SORT_ITEM_BEFORE(a, b) ((a)->key < (b)->key)
+
+BSORT_DEFINE(sort_items, sort_item, SORT_ITEM_BEFORE)
+BSORT_DEFINE(sort_u32_ascending, u32, BSORT_ASCENDING)
+BSORT_DEFINE(sort_u32_descending, u32, BSORT_DESCENDING)
+
+static i32 sort_item_compare(void* a, void* b)
+{
+    u32 a_key = ((sort_item*)a)->key;
+    u32 b_key = ((sort_item*)b)->key;
+    // Positive means a goes first
+    return a_key < b_key ? 1 : (a_key > b_key ? -1 : 0);
+}
+
+// The input orders which break naive quicksorts, plus a random one
+typedef enum sort_pattern
+{
+    SORT_PATTERN_RANDOM,
+    SORT_PATTERN_SORTED,
+    SORT_PATTERN_REVERSED,
+    SORT_PATTERN_ALL_EQUAL,
+    SORT_PATTERN_FEW_UNIQUE,
+    SORT_PATTERN_ORGAN_PIPE,
+    SORT_PATTERN_COUNT
+} sort_pattern;
+
+static const char* sort_pattern_names[SORT_PATTERN_COUNT] = {"random", "sorted", "reversed", "all equal", "few unique", "organ pipe"};
+
+static u32 pattern_value(sort_pattern pattern, u32 i, u32 count, u32* seed)
+{
+    switch (pattern)
+    {
+    case SORT_PATTERN_SORTED:
+        return i;
+    case SORT_PATTERN_REVERSED:
+        return count - i;
+    case SORT_PATTERN_ALL_EQUAL:
+        return 7;
+    case SORT_PATTERN_FEW_UNIQUE:
+        *seed = *seed * 1664525u + 1013904223u;
+        return (*seed >> 16) % 4;
+    case SORT_PATTERN_ORGAN_PIPE:
+        return i < count / 2 ? i : count - i;
+    default:
+        *seed = *seed * 1664525u + 1013904223u;
+        return *seed;
+    }
+}
+
+static void items_fill(sort_item* items, u32 count, sort_pattern pattern)
+{
+    u32 seed = 12345;
+    for (u32 i = 0; i < count; ++i)
+    {
+        items[i].key = pattern_value(pattern, i, count, &seed);
+        items[i].original_index = i;
+    }
+}
+
+// Sorted by key, and still holding each original element exactly once
+static b8 items_sorted(const sort_item* items, u32 count)
+{
+    u64 index_sum = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (i > 0 && items[i - 1].key > items[i].key)
+            return false;
+        index_sum += items[i].original_index;
+    }
+    return index_sum == ((u64)count * (count - 1)) / 2;
+}
+
+u8 bquick_sort_should_sort_all_patterns(void)
+{
+    const u32 counts[] = {0, 1, 2, 3, 16, 17, 100, 5000};
+    sort_item* items = ballocate(sizeof(sort_item) * 5000, MEMORY_TAG_ARRAY);
+    for (u32 c = 0; c < 8; ++c)
+    {
+        for (u32 p = 0; p < SORT_PATTERN_COUNT; ++p)
+        {
+            items_fill(items, counts[c], p);
+            bquick_sort(sizeof(sort_item), items, 0, (i32)counts[c] - 1, sort_item_compare);
+            if (!items_sorted(items, counts[c]))
+            {
+                BERROR("bquick_sort failed on %u %s elements", counts[c], sort_pattern_names[p]);
+                return false;
+            }
+        }
+    }
+
+    // Only the given range is touched
+    items_fill(items, 100, SORT_PATTERN_REVERSED);
+    bquick_sort(sizeof(sort_item), items, 10, 89, sort_item_compare);
+    expect_should_be(100, items[0].key);
+    expect_should_be(91, items[9].key);
+    expect_should_be(11, items[10].key);
+    expect_should_be(90, items[89].key);
+    expect_should_be(10, items[90].key);
+
+    // The existing u32 comparators
+    u32 values[5] = {3, 1, 4, 1, 5};
+    bquick_sort(sizeof(u32), values, 0, 4, bquicksort_compare_u32);
+    expect_should_be(1, values[0]);
+    expect_should_be(5, values[4]);
+    bquick_sort(sizeof(u32), values, 0, 4, bquicksort_compare_u32_desc);
+    expect_should_be(5, values[0]);
+    expect_should_be(1, values[4]);
+
+    bfree(items, sizeof(sort_item) * 5000, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 bsort_define_should_sort_all_patterns(void)
+{
+    const u32 counts[] = {0, 1, 2, 3, 16, 17, 100, 5000};
+    sort_item* items = ballocate(sizeof(sort_item) * 5000, MEMORY_TAG_ARRAY);
+    for (u32 c = 0; c < 8; ++c)
+    {
+        for (u32 p = 0; p < SORT_PATTERN_COUNT; ++p)
+        {
+            items_fill(items, counts[c], p);
+            sort_items(items, counts[c]);
+            if (!items_sorted(items, counts[c]))
+            {
+                BERROR("BSORT_DEFINE sort failed on %u %s elements", counts[c], sort_pattern_names[p]);
+                return false;
+            }
+        }
+    }
+    bfree(items, sizeof(sort_item) * 5000, MEMORY_TAG_ARRAY);
+
+    u32 values[6] = {9, 2, 7, 2, 0, 5};
+    sort_u32_ascending(values, 6);
+    expect_should_be(0, values[0]);
+    expect_should_be(2, values[1]);
+    expect_should_be(2, values[2]);
+    expect_should_be(9, values[5]);
+    sort_u32_descending(values, 6);
+    expect_should_be(9, values[0]);
+    expect_should_be(0, values[5]);
+
+    return true;
+}
+
+u8 bradix_sort_should_sort_stably(void)
+{
+    const u32 count = 5000;
+    bsort_key_u32* keys = ballocate(sizeof(bsort_key_u32) * count, MEMORY_TAG_ARRAY);
+    bsort_key_u64* keys64 = ballocate(sizeof(bsort_key_u64) * count, MEMORY_TAG_ARRAY);
+    for (u32 p = 0; p < SORT_PATTERN_COUNT; ++p)
+    {
+        u32 seed = 999;
+        for (u32 i = 0; i < count; ++i)
+        {
+            keys[i].key = pattern_value(p, i, count, &seed);
+            keys[i].index = i;
+            // Spread across the upper half too, so every digit gets used
+            keys64[i].key = ((u64)keys[i].key << 32) | (keys[i].key % 3);
+            keys64[i].index = i;
+        }
+        bradix_sort_u32(keys, count, 0);
+        bradix_sort_u64(keys64, count, 0);
+
+        for (u32 i = 1; i < count; ++i)
+        {
+            // Equal keys keep their original order
+            b8 ordered = keys[i - 1].key < keys[i].key || (keys[i - 1].key == keys[i].key && keys[i - 1].index < keys[i].index);
+            b8 ordered64 = keys64[i - 1].key < keys64[i].key || (keys64[i - 1].key == keys64[i].key && keys64[i - 1].index < keys64[i].index);
+            if (!ordered || !ordered64)
+            {
+                BERROR("bradix_sort failed on %s keys at index %u", sort_pattern_names[p], i);
+                return false;
+            }
+        }
+    }
+
+    // Caller-provided scratch gives the same result
+    bsort_key_u32 scratch[4];
+    bsort_key_u32 small[4] = {{0x300, 0}, {0x1, 1}, {0x300, 2}, {0x20000, 3}};
+    bradix_sort_u32(small, 4, scratch);
+    expect_should_be(1, small[0].index);
+    expect_should_be(0, small[1].index);
+    expect_should_be(2, small[2].index);
+    expect_should_be(3, small[3].index);
+
+    bfree(keys, sizeof(bsort_key_u32) * count, MEMORY_TAG_ARRAY);
+    bfree(keys64, sizeof(bsort_key_u64) * count, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+u8 bsort_f32_keys_should_keep_order(void)
+{
+    f32 values[] = {-1000.0f, -2.5f, -0.0001f, 0.0f, 0.0001f, 1.0f, 3.5f, 1e20f};
+    for (u32 i = 1; i < 8; ++i)
+    {
+        expect_to_be_true(bsort_key_from_f32(values[i - 1]) < bsort_key_from_f32(values[i]));
+        // Inverted keys sort the other way
+        expect_to_be_true(~bsort_key_from_f32(values[i - 1]) > ~bsort_key_from_f32(values[i]));
+    }
+    return true;
+}
+
+u8 bsort_benchmark(void)
+{
+    const u32 max_count = 1000000;
+    sort_item* items = ballocate(sizeof(sort_item) * max_count, MEMORY_TAG_ARRAY);
+    bsort_key_u32* keys = ballocate(sizeof(bsort_key_u32) * max_count * 2, MEMORY_TAG_ARRAY);
+    bclock clock;
+
+    for (u32 count = 10000; count <= max_count; count *= 10)
+    {
+        for (u32 p = 0; p < SORT_PATTERN_COUNT; ++p)
+        {
+            items_fill(items, count, p);
+            bclock_start(&clock);
+            bquick_sort(sizeof(sort_item), items, 0, (i32)count - 1, sort_item_compare);
+            bclock_update(&clock);
+            f64 generic_time = clock.elapsed;
+            expect_to_be_true(items_sorted(items, count));
+
+            items_fill(items, count, p);
+            bclock_start(&clock);
+            sort_items(items, count);
+            bclock_update(&clock);
+            f64 typed_time = clock.elapsed;
+            expect_to_be_true(items_sorted(items, count));
+
+            // Radix sort of the keys, followed by visiting the items in order as a caller would
+            items_fill(items, count, p);
+            bclock_start(&clock);
+            for (u32 i = 0; i < count; ++i)
+            {
+                keys[i].key = items[i].key;
+                keys[i].index = i;
+            }
+            bradix_sort_u32(keys, count, keys + count);
+            u64 checksum = 0;
+            for (u32 i = 0; i < count; ++i)
+                checksum += items[keys[i].index].original_index;
+            bclock_update(&clock);
+            f64 radix_time = clock.elapsed;
+            expect_should_be(((u64)count * (count - 1)) / 2, checksum);
+
+            BINFO("sort x%u %s: bquick_sort %.3fms, BSORT_DEFINE %.3fms, bradix_sort_u32 %.3fms",
+                  count, sort_pattern_names[p], generic_time * 1000.0, typed_time * 1000.0, radix_time * 1000.0);
+        }
+    }
+
+    bfree(items, sizeof(sort_item) * max_count, MEMORY_TAG_ARRAY);
+    bfree(keys, sizeof(bsort_key_u32) * max_count * 2, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void bsort_register_tests(void)
+{
+    test_manager_register_test(bquick_sort_should_sort_all_patterns, "bquick_sort should sort degenerate inputs");
+    test_manager_register_test(bsort_define_should_sort_all_patterns, "BSORT_DEFINE sort should sort degenerate inputs");
+    test_manager_register_test(bradix_sort_should_sort_stably, "bradix_sort should sort stably");
+    test_manager_register_test(bsort_f32_keys_should_keep_order, "bsort f32 keys should keep float order");
+    test_manager_register_test(bsort_benchmark, "bsort benchmark");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void bsort_register_tests(void);
@@ -0,0 +1,200 @@
+#include "hash_tests.h"
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <defines.h>
+
+#include <memory/bmemory.h>
+#include <strings/bstring.h>
+#include <time/bclock.h>
+#include <utils/bhash.h>
+#include <utils/crc64.h>
+
+// Bit-at-a-time crc64 (Jones polynomial, reflected), to check the table-driven versions against
+static u64 crc64_reference(u64 crc, const u8* data, u64 length)
+{
+    for (u64 i = 0; i < length; ++i)
+    {
+        crc ^= data[i];
+        for (u32 bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? (crc >> 1) ^ 0x95AC9329AC4BC9B5ULL : (crc >> 1);
+    }
+    return crc;
+}
+
+static void test_data_fill(u8* data, u64 length)
+{
+    u32 seed = 4242;
+    for (u64 i = 0; i < length; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (u8)(seed >> 24);
+    }
+}
+
+u8 crc64_should_match_reference(void)
+{
+    // The check value from the crc-64-jones specification
+    expect_should_be(0xe9c6d914c4b8d9caULL, crc64(0, (const u8*)"123456789", 9));
+
+    // Every length and alignment, so both the 8-byte and single-byte paths are covered
+    u8 data[300];
+    test_data_fill(data, sizeof(data));
+    for (u64 offset = 0; offset < 8; ++offset)
+    {
+        for (u64 length = 0; length < 200; ++length)
+        {
+            if (crc64(0, data + offset, length) != crc64_reference(0, data + offset, length))
+            {
+                BERROR("crc64 mismatch at offset %llu, length %llu", offset, length);
+                return false;
+            }
+        }
+    }
+
+    // Continuing a crc gives the same result as doing it all at once
+    u64 split = crc64(crc64(0, data, 37), data + 37, 100);
+    expect_should_be(crc64(0, data, 137), split);
+
+    return true;
+}
+
+u8 crc64_lowercase_should_match_lowercase_copy(void)
+{
+    const char* strings[] = {
+        "",
+        "A",
+        "Already lowercase and long enough for words",
+        "MiXeD_CaSe_NaMe_1234567890_@[`{",
+        "\xC0\xC1\xDA\xDB ABCDEFGHIJKLMNOPQRSTUVWXYZ \x80\xFF"};
+    for (u32 i = 0; i < 5; ++i)
+    {
+        u64 length = string_length(strings[i]);
+        char* copy = string_duplicate(strings[i]);
+        string_to_lower(copy);
+        u64 expected = crc64(0, (const u8*)copy, length);
+        string_free(copy);
+        expect_should_be(expected, crc64_lowercase(0, (const u8*)strings[i], length));
+    }
+
+    // Every byte value, in every position of a word
+    u8 data[16];
+    u8 lowered[16];
+    for (u32 value = 0; value < 256; ++value)
+    {
+        for (u32 i = 0; i < 16; ++i)
+        {
+            data[i] = (u8)(value + i * 17);
+            lowered[i] = (data[i] >= 'A' && data[i] <= 'Z') ? data[i] + ('a' - 'A') : data[i];
+        }
+        if (crc64_lowercase(0, data, 16) != crc64(0, lowered, 16))
+        {
+            BERROR("crc64_lowercase mismatch for byte value %u", value);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+u8 bhash64_should_be_consistent_and_spread(void)
+{
+    u8 data[256];
+    test_data_fill(data, sizeof(data));
+
+    // Same input, same hash. Different seed, different hash
+    expect_should_be(bhash64(data, 100, 0), bhash64(data, 100, 0));
+    expect_should_not_be(bhash64(data, 100, 0), bhash64(data, 100, 1));
+
+    // Every length gives a different hash, including prefixes of the same data
+    u64 hashes[257];
+    for (u32 length = 0; length <= 256; ++length)
+    {
+        hashes[length] = bhash64(data, length, 0);
+        for (u32 k = 0; k < length; ++k)
+        {
+            if (hashes[k] == hashes[length])
+            {
+                BERROR("bhash64 collision between lengths %u and %u", k, length);
+                return false;
+            }
+        }
+    }
+
+    // Flipping any single bit changes roughly half of the hash's bits
+    u64 total_changed = 0;
+    u32 flips = 0;
+    for (u32 length = 1; length <= 64; length += 7)
+    {
+        u64 base = bhash64(data, length, 0);
+        for (u32 bit = 0; bit < length * 8; ++bit)
+        {
+            data[bit / 8] ^= (u8)(1 << (bit % 8));
+            total_changed += __builtin_popcountll(base ^ bhash64(data, length, 0));
+            data[bit / 8] ^= (u8)(1 << (bit % 8));
+            flips++;
+        }
+    }
+    f64 average_changed = (f64)total_changed / flips;
+    expect_to_be_true((average_changed > 30.0));
+    expect_to_be_true((average_changed < 34.0));
+
+    return true;
+}
+
+u8 hash_benchmark(void)
+{
+    // Lengths typical of property names, asset names and full asset paths
+    const u32 lengths[] = {4, 8, 12, 16, 24, 32, 48, 64, 128, 256};
+    const u32 data_size = KIBIBYTES(64);
+    u8* data = ballocate(data_size, MEMORY_TAG_ARRAY);
+    test_data_fill(data, data_size);
+    bclock clock;
+
+    for (u32 l = 0; l < 10; ++l)
+    {
+        u32 length = lengths[l];
+        // Hash a different slice of the buffer each time, so the results can't be reused
+        u32 count = (data_size - 256) / 4;
+        u64 sum = 0;
+
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            sum += crc64_reference(0, data + i * 4, length);
+        bclock_update(&clock);
+        f64 bitwise_time = clock.elapsed;
+
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            sum += crc64(0, data + i * 4, length);
+        bclock_update(&clock);
+        f64 crc_time = clock.elapsed;
+
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            sum += crc64_lowercase(0, data + i * 4, length);
+        bclock_update(&clock);
+        f64 lowercase_time = clock.elapsed;
+
+        bclock_start(&clock);
+        for (u32 i = 0; i < count; ++i)
+            sum += bhash64(data + i * 4, length, 0);
+        bclock_update(&clock);
+        f64 fast_time = clock.elapsed;
+
+        f64 megabytes = ((f64)count * length) / (1024.0 * 1024.0);
+        BINFO("hash %3uB x%u: bitwise crc64 %.1fMB/s, crc64 %.1fMB/s, crc64_lowercase %.1fMB/s, bhash64 %.1fMB/s (%llu)",
+              length, count, megabytes / bitwise_time, megabytes / crc_time, megabytes / lowercase_time, megabytes / fast_time, sum & 1);
+    }
+
+    bfree(data, data_size, MEMORY_TAG_ARRAY);
+    return true;
+}
+
+void hash_register_tests(void)
+{
+    test_manager_register_test(crc64_should_match_reference, "crc64 should match the bitwise reference");
+    test_manager_register_test(crc64_lowercase_should_match_lowercase_copy, "crc64_lowercase should match crc64 of a lowercase copy");
+    test_manager_register_test(bhash64_should_be_consistent_and_spread, "bhash64 should be consistent and well spread");
+    test_manager_register_test(hash_benchmark, "crc64 and bhash64 throughput benchmark");
+}
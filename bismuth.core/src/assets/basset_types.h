@@ -193,6 +193,13 @@ typedef struct basset_static_mesh_geometry
     vec3 center;
 } basset_static_mesh_geometry;
 
+/** @brief Options for importing a static mesh, passed as the import params. Everything is off by default */
+typedef struct basset_static_mesh_import_options
+{
+    /** @brief Generate tangents across threads. Gives identical results; only worth it for large meshes */
+    b8 parallel_tangents;
+} basset_static_mesh_import_options;
+
 /** @brief Represents a static mesh asset */
 typedef struct basset_static_mesh
 {
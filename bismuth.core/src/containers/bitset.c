@@ -0,0 +1,112 @@
+#include "bitset.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+
+static u32 word_count_for(u32 bit_count)
+{
+    return (u32)(((u64)bit_count + 63) / 64);
+}
+
+b8 bitset_create(u32 bit_count, bitset* out_bitset)
+{
+    if (!out_bitset)
+    {
+        BERROR("bitset_create requires a valid pointer to out_bitset");
+        return false;
+    }
+
+    bzero_memory(out_bitset, sizeof(bitset));
+    return bitset_resize(out_bitset, bit_count);
+}
+
+void bitset_destroy(bitset* set)
+{
+    if (set)
+    {
+        if (set->words)
+            bfree(set->words, sizeof(u64) * set->word_count, MEMORY_TAG_ARRAY);
+        bzero_memory(set, sizeof(bitset));
+    }
+}
+
+b8 bitset_resize(bitset* set, u32 bit_count)
+{
+    u32 word_count = word_count_for(bit_count);
+    if (word_count != set->word_count)
+    {
+        if (word_count == 0)
+        {
+            bfree(set->words, sizeof(u64) * set->word_count, MEMORY_TAG_ARRAY);
+            set->words = 0;
+        }
+        else
+        {
+            // NOTE: New words come back zeroed
+            u64* words = breallocate(set->words, sizeof(u64) * set->word_count, sizeof(u64) * word_count, MEMORY_TAG_ARRAY);
+            if (!words)
+            {
+                BERROR("Failed to resize bitset to %u bits", bit_count);
+                return false;
+            }
+            set->words = words;
+        }
+        set->word_count = word_count;
+    }
+
+    // Bits beyond the end are always kept clear, so counting and searching don't need to mask them.
+    // When shrinking, that means clearing what's left of the old bits in the last word
+    if (bit_count < set->bit_count && (bit_count & 63))
+        set->words[word_count - 1] &= (1ULL << (bit_count & 63)) - 1;
+    set->bit_count = bit_count;
+    return true;
+}
+
+void bitset_clear_all(bitset* set)
+{
+    if (set->words)
+        bzero_memory(set->words, sizeof(u64) * set->word_count);
+}
+
+u32 bitset_count(const bitset* set)
+{
+    u32 count = 0;
+    for (u32 i = 0; i < set->word_count; ++i)
+        count += (u32)__builtin_popcountll(set->words[i]);
+    return count;
+}
+
+u32 bitset_find_next_set(const bitset* set, u32 start)
+{
+    if (start >= set->bit_count)
+        return INVALID_ID;
+
+    u32 word_index = start >> 6;
+    // Ignore the bits before start in the first word
+    u64 word = set->words[word_index] & (~0ULL << (start & 63));
+    while (!word)
+    {
+        if (++word_index == set->word_count)
+            return INVALID_ID;
+        word = set->words[word_index];
+    }
+    return (word_index << 6) + (u32)__builtin_ctzll(word);
+}
+
+u32 bitset_find_next_clear(const bitset* set, u32 start)
+{
+    if (start >= set->bit_count)
+        return INVALID_ID;
+
+    u32 word_index = start >> 6;
+    u64 word = ~set->words[word_index] & (~0ULL << (start & 63));
+    while (!word)
+    {
+        if (++word_index == set->word_count)
+            return INVALID_ID;
+        word = ~set->words[word_index];
+    }
+    u32 index = (word_index << 6) + (u32)__builtin_ctzll(word);
+    // The clear bits past the end don't count
+    return index < set->bit_count ? index : INVALID_ID;
+}
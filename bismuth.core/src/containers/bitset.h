@@ -0,0 +1,96 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A fixed-size set of bits, packed 64 to a word. Setting, clearing and testing a bit are
+ * O(1), and counting or finding set bits works a whole word at a time, so walking a sparse set
+ * of flags skips over empty stretches 64 bits at once. Useful for membership and "is active"
+ * flags indexed by slot. A zeroed structure is a valid, empty bitset with no bits.
+ * Members of this structure should not be modified outside the functions associated with it.
+ */
+typedef struct bitset
+{
+    // The number of bits in the set
+    u32 bit_count;
+    // The number of 64-bit words allocated
+    u32 word_count;
+    u64* words;
+} bitset;
+
+/**
+ * @brief Creates a bitset with every bit clear.
+ *
+ * @param bit_count The number of bits. May be 0.
+ * @param out_bitset A pointer to hold the created bitset.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 bitset_create(u32 bit_count, bitset* out_bitset);
+
+/**
+ * @brief Destroys the given bitset and releases its memory.
+ *
+ * @param set A pointer to the bitset to be destroyed.
+ */
+BAPI void bitset_destroy(bitset* set);
+
+/**
+ * @brief Changes the number of bits in the set. Existing bits are kept, and new bits start clear.
+ *
+ * @param set A pointer to the bitset. Required.
+ * @param bit_count The new number of bits.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 bitset_resize(bitset* set, u32 bit_count);
+
+/**
+ * @brief Clears every bit in the set.
+ *
+ * @param set A pointer to the bitset. Required.
+ */
+BAPI void bitset_clear_all(bitset* set);
+
+/**
+ * @brief Counts the bits which are set.
+ *
+ * @param set A constant pointer to the bitset. Required.
+ * @return The number of set bits.
+ */
+BAPI u32 bitset_count(const bitset* set);
+
+/**
+ * @brief Finds the first set bit at or after the given index. Call again with the result + 1 to
+ * walk every set bit in order.
+ *
+ * @param set A constant pointer to the bitset. Required.
+ * @param start The index to start searching from.
+ * @return The index of the bit, or INVALID_ID if no bits from start onwards are set.
+ */
+BAPI u32 bitset_find_next_set(const bitset* set, u32 start);
+
+/**
+ * @brief Finds the first clear bit at or after the given index.
+ *
+ * @param set A constant pointer to the bitset. Required.
+ * @param start The index to start searching from.
+ * @return The index of the bit, or INVALID_ID if no bits from start onwards are clear.
+ */
+BAPI u32 bitset_find_next_clear(const bitset* set, u32 start);
+
+/** @brief Sets the bit at the given index, which must be less than the set's bit_count. */
+BINLINE void bitset_set(bitset* set, u32 index)
+{
+    set->words[index >> 6] |= 1ULL << (index & 63);
+}
+
+/** @brief Clears the bit at the given index, which must be less than the set's bit_count. */
+BINLINE void bitset_clear(bitset* set, u32 index)
+{
+    set->words[index >> 6] &= ~(1ULL << (index & 63));
+}
+
+/** @brief Indicates if the bit at the given index is set. The index must be less than the set's bit_count. */
+BINLINE b8 bitset_test(const bitset* set, u32 index)
+{
+    return (set->words[index >> 6] >> (index & 63)) & 1;
+}
@@ -0,0 +1,156 @@
+#include "chunked_array.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+
+// The size chunks are made to fit when no element count is given
+#define CHUNKED_ARRAY_DEFAULT_CHUNK_SIZE KIBIBYTES(4)
+// The smallest the chunks table is allocated with
+#define CHUNKED_ARRAY_MIN_TABLE_CAPACITY 8
+
+// Adds chunks until there are at least chunk_count of them. Existing chunks never move; only the table of pointers does
+static b8 chunks_ensure(chunked_array* array, u32 chunk_count)
+{
+    if (chunk_count > array->chunk_table_capacity)
+    {
+        u32 new_capacity = array->chunk_table_capacity ? array->chunk_table_capacity * 2 : CHUNKED_ARRAY_MIN_TABLE_CAPACITY;
+        while (new_capacity < chunk_count)
+            new_capacity *= 2;
+
+        u8** new_chunks = 0;
+        if (array->chunks)
+            new_chunks = breallocate(array->chunks, sizeof(u8*) * array->chunk_table_capacity, sizeof(u8*) * new_capacity, MEMORY_TAG_ARRAY);
+        else
+            new_chunks = ballocate(sizeof(u8*) * new_capacity, MEMORY_TAG_ARRAY);
+        if (!new_chunks)
+        {
+            BERROR("Failed to grow chunked array table to %u chunks", new_capacity);
+            return false;
+        }
+        array->chunks = new_chunks;
+        array->chunk_table_capacity = new_capacity;
+    }
+
+    u64 chunk_size = ((u64)array->element_size) << array->chunk_shift;
+    while (array->chunk_count < chunk_count)
+    {
+        u8* chunk = ballocate_uninitialized(chunk_size, MEMORY_TAG_ARRAY);
+        if (!chunk)
+        {
+            BERROR("Failed to allocate chunked array chunk of %llu bytes", chunk_size);
+            return false;
+        }
+        array->chunks[array->chunk_count++] = chunk;
+    }
+    return true;
+}
+
+b8 chunked_array_create(u32 element_size, u32 elements_per_chunk, chunked_array* out_array)
+{
+    if (!out_array)
+    {
+        BERROR("chunked_array_create requires a valid pointer to out_array");
+        return false;
+    }
+    if (element_size == 0)
+    {
+        BERROR("chunked_array_create requires a nonzero element_size");
+        return false;
+    }
+
+    if (elements_per_chunk == 0)
+    {
+        elements_per_chunk = CHUNKED_ARRAY_DEFAULT_CHUNK_SIZE / element_size;
+        if (elements_per_chunk == 0)
+            elements_per_chunk = 1;
+        // Round down, so a chunk doesn't go over the default size
+        elements_per_chunk = 1u << (31 - __builtin_clz(elements_per_chunk));
+    }
+
+    u32 shift = 0;
+    while ((1u << shift) < elements_per_chunk)
+    {
+        shift++;
+        if (shift == 31)
+        {
+            BERROR("chunked_array_create - elements_per_chunk of %u is too large", elements_per_chunk);
+            return false;
+        }
+    }
+
+    bzero_memory(out_array, sizeof(chunked_array));
+    out_array->element_size = element_size;
+    out_array->chunk_shift = shift;
+    return true;
+}
+
+void chunked_array_destroy(chunked_array* array)
+{
+    if (array)
+    {
+        u64 chunk_size = ((u64)array->element_size) << array->chunk_shift;
+        for (u32 i = 0; i < array->chunk_count; ++i)
+            bfree(array->chunks[i], chunk_size, MEMORY_TAG_ARRAY);
+        if (array->chunks)
+            bfree(array->chunks, sizeof(u8*) * array->chunk_table_capacity, MEMORY_TAG_ARRAY);
+        bzero_memory(array, sizeof(chunked_array));
+    }
+}
+
+void* chunked_array_push(chunked_array* array, const void* value)
+{
+    u32 index = array->length;
+    u32 chunk_index = index >> array->chunk_shift;
+    if (chunk_index >= array->chunk_count && !chunks_ensure(array, chunk_index + 1))
+        return 0;
+
+    void* element = chunked_array_get(array, index);
+    if (value)
+        bcopy_memory(element, value, array->element_size);
+    else
+        bzero_memory(element, array->element_size);
+    array->length++;
+    return element;
+}
+
+b8 chunked_array_pop(chunked_array* array, void* out_value)
+{
+    if (array->length == 0)
+        return false;
+
+    array->length--;
+    if (out_value)
+        bcopy_memory(out_value, chunked_array_get(array, array->length), array->element_size);
+    return true;
+}
+
+void chunked_array_clear(chunked_array* array)
+{
+    array->length = 0;
+}
+
+b8 chunked_array_reserve(chunked_array* array, u32 capacity)
+{
+    u32 chunk_count = (u32)(((u64)capacity + (1u << array->chunk_shift) - 1) >> array->chunk_shift);
+    return chunks_ensure(array, chunk_count);
+}
+
+void chunked_array_shrink(chunked_array* array)
+{
+    u32 needed = chunked_array_chunk_count(array);
+    u64 chunk_size = ((u64)array->element_size) << array->chunk_shift;
+    while (array->chunk_count > needed)
+        bfree(array->chunks[--array->chunk_count], chunk_size, MEMORY_TAG_ARRAY);
+
+    if (needed == 0 && array->chunks)
+    {
+        bfree(array->chunks, sizeof(u8*) * array->chunk_table_capacity, MEMORY_TAG_ARRAY);
+        array->chunks = 0;
+        array->chunk_table_capacity = 0;
+    }
+}
+
+u32 chunked_array_capacity(const chunked_array* array)
+{
+    return array->chunk_count << array->chunk_shift;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A growable array whose elements never move once pushed, so pointers to them stay valid
+ * for as long as the element exists. Elements are stored in fixed-size chunks, and growing only
+ * adds chunks, never copying existing elements, so pushing is O(1) even for large arrays.
+ * Elements are still addressable by index, and can be visited chunk by chunk as plain arrays.
+ * Members of this structure should not be modified outside the functions associated with it.
+ */
+typedef struct chunked_array
+{
+    // Size of each element in bytes
+    u32 element_size;
+    // Number of elements in each chunk, as a power of two
+    u32 chunk_shift;
+    // Number of elements currently in the array
+    u32 length;
+    // Number of chunks allocated. Chunks beyond those in use are kept for reuse until shrunk
+    u32 chunk_count;
+    // Number of entries the chunks table has room for
+    u32 chunk_table_capacity;
+    // Table of pointers to each chunk
+    u8** chunks;
+} chunked_array;
+
+/**
+ * @brief Creates a chunked array.
+ *
+ * @param element_size The size of each element in bytes.
+ * @param elements_per_chunk The number of elements in each chunk, rounded up to a power of two. Pass 0 to fit about 4KiB per chunk.
+ * @param out_array A pointer to hold the created array.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 chunked_array_create(u32 element_size, u32 elements_per_chunk, chunked_array* out_array);
+
+/**
+ * @brief Destroys the given array and releases its memory. Any pointers to its elements become invalid.
+ *
+ * @param array A pointer to the array to be destroyed.
+ */
+BAPI void chunked_array_destroy(chunked_array* array);
+
+/**
+ * @brief Adds an element to the end of the array.
+ *
+ * @param array A pointer to the array. Required.
+ * @param value A pointer to element_size bytes to be copied in. If 0, the new element is zeroed.
+ * @return A pointer to the new element, which stays valid until the element is popped or the array is cleared or destroyed. 0 on failure.
+ */
+BAPI void* chunked_array_push(chunked_array* array, const void* value);
+
+/**
+ * @brief Removes the last element of the array.
+ *
+ * @param array A pointer to the array. Required.
+ * @param out_value A pointer to hold a copy of the removed element. Optional.
+ * @return True if an element was removed; false if the array was empty.
+ */
+BAPI b8 chunked_array_pop(chunked_array* array, void* out_value);
+
+/**
+ * @brief Removes all elements, keeping the chunks to be reused.
+ *
+ * @param array A pointer to the array. Required.
+ */
+BAPI void chunked_array_clear(chunked_array* array);
+
+/**
+ * @brief Makes sure the array can hold at least the given number of elements without allocating again.
+ *
+ * @param array A pointer to the array. Required.
+ * @param capacity The number of elements to make room for.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 chunked_array_reserve(chunked_array* array, u32 capacity);
+
+/**
+ * @brief Releases any chunks not holding elements. Never moves elements.
+ *
+ * @param array A pointer to the array. Required.
+ */
+BAPI void chunked_array_shrink(chunked_array* array);
+
+/** @brief Returns the number of elements the array can hold before it needs to allocate another chunk. */
+BAPI u32 chunked_array_capacity(const chunked_array* array);
+
+/**
+ * @brief Obtains a pointer to the element at the given index. No bounds checking is done.
+ *
+ * @param array A pointer to the array. Required.
+ * @param index The index of the element. Must be less than the array's length.
+ * @return A pointer to the element.
+ */
+BINLINE void* chunked_array_get(const chunked_array* array, u32 index)
+{
+    u32 mask = (1u << array->chunk_shift) - 1;
+    return array->chunks[index >> array->chunk_shift] + (u64)(index & mask) * array->element_size;
+}
+
+/** @brief Returns the number of chunks which hold elements, for use with chunked_array_chunk_get(). */
+BINLINE u32 chunked_array_chunk_count(const chunked_array* array)
+{
+    return (array->length + (1u << array->chunk_shift) - 1) >> array->chunk_shift;
+}
+
+/**
+ * @brief Obtains the elements held in the given chunk, which are contiguous. Visiting each chunk
+ * in turn is the fastest way to iterate over all elements.
+ *
+ * @param array A pointer to the array. Required.
+ * @param chunk_index The index of the chunk. Must be less than chunked_array_chunk_count().
+ * @param out_count A pointer to hold the number of elements in the chunk. Required.
+ * @return A pointer to the first element in the chunk.
+ */
+BINLINE void* chunked_array_chunk_get(const chunked_array* array, u32 chunk_index, u32* out_count)
+{
+    u32 first = chunk_index << array->chunk_shift;
+    u32 remaining = array->length - first;
+    u32 per_chunk = 1u << array->chunk_shift;
+    *out_count = remaining < per_chunk ? remaining : per_chunk;
+    return array->chunks[chunk_index];
+}
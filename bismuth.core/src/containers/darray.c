@@ -7,6 +7,9 @@
 
 void* _darray_create(u64 length, u64 stride, frame_allocator_int* allocator)
 {
+    // Callers often reserve an estimate, which may come out as 0
+    if (length == 0)
+        length = DARRAY_DEFAULT_CAPACITY;
     u64 header_size = sizeof(darray_header);
     u64 array_size = length * stride;
     void* new_array = 0;
@@ -15,8 +18,6 @@ void* _darray_create(u64 length, u64 stride, frame_allocator_int* allocator)
     else
         new_array = ballocate(header_size + array_size, MEMORY_TAG_DARRAY);
     bset_memory(new_array, 0, header_size + array_size);
-    if (length == 0)
-        BFATAL("_darray_create called with length of 0");
     darray_header* header = new_array;
     header->capacity = length;
     header->length = 0;
@@ -40,6 +41,14 @@ void darray_destroy(void* array)
     }
 }
 
+// The capacity to grow to from the given one
+static u64 darray_grown_capacity(u64 capacity, u64 stride)
+{
+    u64 new_capacity = capacity * DARRAY_RESIZE_FACTOR;
+    u64 min_capacity = (DARRAY_MIN_GROWTH_BYTES + stride - 1) / stride;
+    return new_capacity > min_capacity ? new_capacity : min_capacity;
+}
+
 void* _darray_resize(void* array)
 {
     u64 header_size = sizeof(darray_header);
@@ -49,7 +58,21 @@ void* _darray_resize(void* array)
         BFATAL("_darray_resize called on an array with 0 capacity. This should not be possible");
         return 0;
     }
-    void* temp = _darray_create((DARRAY_RESIZE_FACTOR * header->capacity), header->stride, header->allocator);
+    u64 old_capacity = header->capacity;
+    u64 new_capacity = darray_grown_capacity(old_capacity, header->stride);
+
+    if (!header->allocator)
+    {
+        // Heap arrays are reallocated, which can often grow the block in place rather than copying it.
+        // NOTE: The new elements are zeroed by breallocate, as they would be by _darray_create
+        u64 old_size = header_size + old_capacity * header->stride;
+        u64 new_size = header_size + new_capacity * header->stride;
+        darray_header* new_header = breallocate(header, old_size, new_size, MEMORY_TAG_DARRAY);
+        new_header->capacity = new_capacity;
+        return (void*)((u8*)new_header + header_size);
+    }
+
+    void* temp = _darray_create(new_capacity, header->stride, header->allocator);
 
     darray_header* new_header = (darray_header*)((u8*)temp - header_size);
     new_header->length = header->length;
@@ -18,6 +18,8 @@ BAPI void* _darray_duplicate(u64 stride, void* array);
 
 #define DARRAY_DEFAULT_CAPACITY 1
 #define DARRAY_RESIZE_FACTOR 2
+// When growing, room is made for at least this many bytes of elements, so small arrays skip the first few doublings
+#define DARRAY_MIN_GROWTH_BYTES 128
 
 #define darray_create(type) \
     (type*)_darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type), 0)
@@ -25,11 +27,12 @@ BAPI void* _darray_duplicate(u64 stride, void* array);
 #define darray_create_with_allocator(type, allocator) \
     _darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type), allocator)
 
+// Creates a darray with room for capacity elements up front. Prefer this over darray_create() whenever the final size is known or can be estimated
 #define darray_reserve(type, capacity) \
-    _darray_create(capacity, sizeof(type), 0)
+    (type*)_darray_create(capacity, sizeof(type), 0)
 
 #define darray_reserve_with_allocator(type, capacity, allocator) \
-    _darray_create(capacity, sizeof(type), allocator)
+    (type*)_darray_create(capacity, sizeof(type), allocator)
 
 BAPI void darray_destroy(void* array);
 
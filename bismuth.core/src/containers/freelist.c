@@ -12,17 +12,79 @@ typedef struct freelist_node
 
 typedef struct internal_state
 {
+    // NOTE: Must be first, shared with segregated_state
+    freelist_mode mode;
     u64 total_size;
     u64 max_entries;
     freelist_node* head;
     freelist_node* nodes;
 } internal_state;
 
+// Segregated-fit configuration. Each power-of-two range is split into SEG_SL_COUNT linear bins
+#define SEG_SL_LOG2 4
+#define SEG_SL_COUNT (1 << SEG_SL_LOG2)
+#define SEG_FL_COUNT (64 - SEG_SL_LOG2 + 1)
+#define SEG_INVALID INVALID_ID
+
+typedef struct segregated_node
+{
+    u64 offset;
+    // 0 when the node is not in use
+    u64 size;
+    // Links within the node's size bin, or the pool of unused nodes
+    u32 prev;
+    u32 next;
+} segregated_node;
+
+typedef struct segregated_state
+{
+    // NOTE: Must be first, shared with internal_state
+    freelist_mode mode;
+    u64 total_size;
+    u64 memory_requirement;
+    u64 free_space;
+    u32 max_entries;
+    // Head of the pool of unused nodes
+    u32 unused_head;
+
+    // Bit per first-level bin that has any free range
+    u64 fl_bitmap;
+    // Bit per second-level bin that has any free range
+    u32 sl_bitmaps[SEG_FL_COUNT];
+    u32 bins[SEG_FL_COUNT][SEG_SL_COUNT];
+
+    // Open-addressed (linear probing) tables of node indices, keyed by range start and range end
+    u32 table_mask;
+    u32 table_shift;
+    u32* starts;
+    u32* ends;
+    segregated_node* nodes;
+} segregated_state;
+
 static freelist_node* get_node(freelist* list);
 static void return_node(freelist_node* node);
 
+static b8 is_segregated(freelist* list);
+static void segregated_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list);
+static b8 segregated_allocate_block(freelist* list, u64 size, u64* out_offset);
+static b8 segregated_allocate_block_at(freelist* list, u64 size, u64 offset);
+static b8 segregated_free_block(freelist* list, u64 size, u64 offset);
+static b8 segregated_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory);
+static void segregated_clear(freelist* list);
+
 void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list)
 {
+    freelist_create_mode(total_size, FREELIST_MODE_FIRST_FIT, memory_requirement, memory, out_list);
+}
+
+void freelist_create_mode(u64 total_size, freelist_mode mode, u64* memory_requirement, void* memory, freelist* out_list)
+{
+    if (mode == FREELIST_MODE_SEGREGATED_FIT)
+    {
+        segregated_create(total_size, memory_requirement, memory, out_list);
+        return;
+    }
+
     // Enough space to hold state, plus array for all nodes
     u64 max_entries = (total_size / (sizeof(void*) * sizeof(freelist_node)));
 
@@ -46,6 +108,7 @@ void freelist_create(u64 total_size, u64* memory_requirement, void* memory, free
     // The block's layout is head* first, then array of available nodes
     bzero_memory(out_list->memory, *memory_requirement);
     internal_state* state = out_list->memory;
+    state->mode = FREELIST_MODE_FIRST_FIT;
     state->nodes = (void*)(out_list->memory + sizeof(internal_state));
     state->max_entries = max_entries;
     state->total_size = total_size;
@@ -63,8 +126,16 @@ void freelist_destroy(freelist* list)
     if (list && list->memory)
     {
         // Zero out memory before giving it back
-        internal_state* state = list->memory;
-        bzero_memory(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+        if (is_segregated(list))
+        {
+            segregated_state* state = list->memory;
+            bzero_memory(list->memory, state->memory_requirement);
+        }
+        else
+        {
+            internal_state* state = list->memory;
+            bzero_memory(list->memory, sizeof(internal_state) + sizeof(freelist_node) * state->max_entries);
+        }
         list->memory = 0;
     }
 }
@@ -73,6 +144,8 @@ b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset)
 {
     if (!list || !out_offset || !list->memory)
         return false;
+    if (is_segregated(list))
+        return segregated_allocate_block(list, size, out_offset);
     internal_state* state = list->memory;
     freelist_node* node = state->head;
     freelist_node* previous = 0;
@@ -115,10 +188,52 @@ b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset)
     return false;
 }
 
+b8 freelist_allocate_block_at(freelist* list, u64 size, u64 offset)
+{
+    if (!list || !list->memory || !size)
+        return false;
+    if (is_segregated(list))
+        return segregated_allocate_block_at(list, size, offset);
+    internal_state* state = list->memory;
+    freelist_node* node = state->head;
+    freelist_node* previous = 0;
+    // Nodes are sorted by offset, so stop once past the requested one
+    while (node && node->offset <= offset)
+    {
+        if (node->offset == offset)
+        {
+            if (node->size < size)
+                return false;
+
+            if (node->size == size)
+            {
+                if (previous)
+                    previous->next = node->next;
+                else
+                    state->head = node->next;
+                return_node(node);
+            }
+            else
+            {
+                node->size -= size;
+                node->offset += size;
+            }
+            return true;
+        }
+
+        previous = node;
+        node = node->next;
+    }
+
+    return false;
+}
+
 b8 freelist_free_block(freelist* list, u64 size, u64 offset)
 {
     if (!list || !list->memory || !size)
         return false;
+    if (is_segregated(list))
+        return segregated_free_block(list, size, offset);
     internal_state* state = list->memory;
     freelist_node* node = state->head;
     freelist_node* previous = 0;
@@ -226,6 +341,8 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
 {
     if (!list || !memory_requirement || ((internal_state*)list->memory)->total_size > new_size)
         return false;
+    if (is_segregated(list))
+        return segregated_resize(list, memory_requirement, new_memory, new_size, out_old_memory);
 
     // Enough space to hold state, plus array for all nodes
     u64 max_entries = (new_size / sizeof(void*));
@@ -254,6 +371,7 @@ b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memory, u6
 
     // Setup new state
     internal_state* state = (internal_state*)list->memory;
+    state->mode = FREELIST_MODE_FIRST_FIT;
     state->nodes = (void*)(list->memory + sizeof(internal_state));
     state->max_entries = max_entries;
     state->total_size = new_size;
@@ -322,6 +440,11 @@ void freelist_clear(freelist* list)
 {
     if (!list || !list->memory)
         return;
+    if (is_segregated(list))
+    {
+        segregated_clear(list);
+        return;
+    }
 
     internal_state* state = list->memory;
     // Invalidate offset for all but the first node
@@ -337,6 +460,8 @@ u64 freelist_free_space(freelist* list)
 {
     if (!list || !list->memory)
         return 0;
+    if (is_segregated(list))
+        return ((segregated_state*)list->memory)->free_space;
 
     u64 running_total = 0;
     internal_state* state = list->memory;
@@ -373,3 +498,384 @@ static void return_node(freelist_node* node)
     node->size = 0;
     node->next = 0;
 }
+
+static b8 is_segregated(freelist* list)
+{
+    return ((internal_state*)list->memory)->mode == FREELIST_MODE_SEGREGATED_FIT;
+}
+
+// Maps a size to its first/second-level bin
+static void segregated_mapping(u64 size, u32* out_fl, u32* out_sl)
+{
+    if (size < SEG_SL_COUNT)
+    {
+        *out_fl = 0;
+        *out_sl = (u32)size;
+    }
+    else
+    {
+        u32 msb = 63 - (u32)__builtin_clzll(size);
+        *out_sl = (u32)((size >> (msb - SEG_SL_LOG2)) ^ SEG_SL_COUNT);
+        *out_fl = msb - SEG_SL_LOG2 + 1;
+    }
+}
+
+static u32 segregated_hash(segregated_state* state, u64 key)
+{
+    return (u32)((key * 0x9E3779B97F4A7C15ULL) >> state->table_shift);
+}
+
+static u64 segregated_start_key(segregated_state* state, u32 node) { return state->nodes[node].offset; }
+static u64 segregated_end_key(segregated_state* state, u32 node) { return state->nodes[node].offset + state->nodes[node].size; }
+
+typedef u64 (*pfn_segregated_key)(segregated_state* state, u32 node);
+
+static u32 segregated_table_find(segregated_state* state, u32* table, pfn_segregated_key key_of, u64 key)
+{
+    u32 i = segregated_hash(state, key);
+    while (table[i] != SEG_INVALID)
+    {
+        if (key_of(state, table[i]) == key)
+            return i;
+        i = (i + 1) & state->table_mask;
+    }
+    return SEG_INVALID;
+}
+
+static void segregated_table_insert(segregated_state* state, u32* table, pfn_segregated_key key_of, u32 node)
+{
+    u32 i = segregated_hash(state, key_of(state, node));
+    while (table[i] != SEG_INVALID)
+        i = (i + 1) & state->table_mask;
+    table[i] = node;
+}
+
+// Removes by key using backward-shift deletion, so no tombstones are ever needed
+static void segregated_table_remove(segregated_state* state, u32* table, pfn_segregated_key key_of, u64 key)
+{
+    u32 i = segregated_table_find(state, table, key_of, key);
+    if (i == SEG_INVALID)
+        return;
+
+    u32 j = i;
+    while (true)
+    {
+        j = (j + 1) & state->table_mask;
+        if (table[j] == SEG_INVALID)
+            break;
+        u32 home = segregated_hash(state, key_of(state, table[j]));
+        // If the entry's home lies cyclically within (i, j], it is still reachable and stays put
+        b8 reachable = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (reachable)
+            continue;
+        table[i] = table[j];
+        i = j;
+    }
+    table[i] = SEG_INVALID;
+}
+
+static void segregated_bin_insert(segregated_state* state, u32 node)
+{
+    u32 fl, sl;
+    segregated_mapping(state->nodes[node].size, &fl, &sl);
+    u32 head = state->bins[fl][sl];
+    state->nodes[node].prev = SEG_INVALID;
+    state->nodes[node].next = head;
+    if (head != SEG_INVALID)
+        state->nodes[head].prev = node;
+    state->bins[fl][sl] = node;
+    state->fl_bitmap |= (1ULL << fl);
+    state->sl_bitmaps[fl] |= (1U << sl);
+}
+
+static void segregated_bin_remove(segregated_state* state, u32 node)
+{
+    u32 fl, sl;
+    segregated_mapping(state->nodes[node].size, &fl, &sl);
+    segregated_node* n = &state->nodes[node];
+    if (n->prev != SEG_INVALID)
+        state->nodes[n->prev].next = n->next;
+    else
+        state->bins[fl][sl] = n->next;
+    if (n->next != SEG_INVALID)
+        state->nodes[n->next].prev = n->prev;
+
+    if (state->bins[fl][sl] == SEG_INVALID)
+    {
+        state->sl_bitmaps[fl] &= ~(1U << sl);
+        if (!state->sl_bitmaps[fl])
+            state->fl_bitmap &= ~(1ULL << fl);
+    }
+}
+
+static u32 segregated_node_acquire(segregated_state* state)
+{
+    u32 node = state->unused_head;
+    if (node != SEG_INVALID)
+        state->unused_head = state->nodes[node].next;
+    return node;
+}
+
+static void segregated_node_release(segregated_state* state, u32 node)
+{
+    state->nodes[node].offset = 0;
+    state->nodes[node].size = 0;
+    state->nodes[node].prev = SEG_INVALID;
+    state->nodes[node].next = state->unused_head;
+    state->unused_head = node;
+}
+
+// Adds a brand new free range that is known not to touch any other free range
+static b8 segregated_add_range(segregated_state* state, u64 offset, u64 size)
+{
+    u32 node = segregated_node_acquire(state);
+    if (node == SEG_INVALID)
+        return false;
+    state->nodes[node].offset = offset;
+    state->nodes[node].size = size;
+    segregated_table_insert(state, state->starts, segregated_start_key, node);
+    segregated_table_insert(state, state->ends, segregated_end_key, node);
+    segregated_bin_insert(state, node);
+    state->free_space += size;
+    return true;
+}
+
+static void segregated_reset(segregated_state* state)
+{
+    state->free_space = 0;
+    state->fl_bitmap = 0;
+    bzero_memory(state->sl_bitmaps, sizeof(state->sl_bitmaps));
+    bset_memory(state->bins, 0xFF, sizeof(state->bins));
+    bset_memory(state->starts, 0xFF, sizeof(u32) * ((u64)state->table_mask + 1));
+    bset_memory(state->ends, 0xFF, sizeof(u32) * ((u64)state->table_mask + 1));
+
+    // Chain all nodes into the unused pool
+    bzero_memory(state->nodes, sizeof(segregated_node) * state->max_entries);
+    state->unused_head = SEG_INVALID;
+    for (u32 i = state->max_entries; i > 0; --i)
+        segregated_node_release(state, i - 1);
+}
+
+static void segregated_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list)
+{
+    // NOTE: Every free range needs a node. Budget one per 512 bytes tracked on average, which keeps
+    // the metadata well below that of the first-fit list while leaving plenty of room for fragmentation
+    u64 max_entries = total_size / 512;
+    if (max_entries < 64)
+        max_entries = 64;
+    if (max_entries > (U32_MAX / 4))
+        max_entries = U32_MAX / 4;
+
+    // Keep the boundary tables at most ~2/3 full so probe sequences stay short
+    u32 table_bits = 1;
+    while ((1ULL << table_bits) < max_entries + (max_entries / 2))
+        table_bits++;
+    u64 table_capacity = 1ULL << table_bits;
+
+    *memory_requirement = sizeof(segregated_state) + (sizeof(segregated_node) * max_entries) + (sizeof(u32) * table_capacity * 2);
+    if (!memory)
+        return;
+
+    // Layout: state, nodes, start table, end table
+    out_list->memory = memory;
+    segregated_state* state = memory;
+    bzero_memory(state, sizeof(segregated_state));
+    state->mode = FREELIST_MODE_SEGREGATED_FIT;
+    state->total_size = total_size;
+    state->memory_requirement = *memory_requirement;
+    state->max_entries = (u32)max_entries;
+    state->table_mask = (u32)(table_capacity - 1);
+    state->table_shift = 64 - table_bits;
+    state->nodes = (segregated_node*)((u8*)memory + sizeof(segregated_state));
+    state->starts = (u32*)(state->nodes + max_entries);
+    state->ends = state->starts + table_capacity;
+
+    segregated_reset(state);
+    segregated_add_range(state, 0, total_size);
+}
+
+static u32 segregated_find(segregated_state* state, u64 size)
+{
+    // Round up to the next bin boundary so that any range in the found bin is large enough
+    u64 search_size = size;
+    if (size >= SEG_SL_COUNT)
+    {
+        u32 msb = 63 - (u32)__builtin_clzll(size);
+        u64 round = (1ULL << (msb - SEG_SL_LOG2)) - 1;
+        if (size <= U64_MAX - round)
+            search_size += round;
+    }
+
+    u32 fl, sl;
+    segregated_mapping(search_size, &fl, &sl);
+    u32 sl_map = state->sl_bitmaps[fl] & (~0U << sl);
+    if (!sl_map)
+    {
+        u64 fl_map = (fl + 1 < 64) ? (state->fl_bitmap & (~0ULL << (fl + 1))) : 0;
+        if (fl_map)
+        {
+            fl = (u32)__builtin_ctzll(fl_map);
+            sl_map = state->sl_bitmaps[fl];
+        }
+    }
+    if (sl_map)
+        return state->bins[fl][(u32)__builtin_ctz(sl_map)];
+
+    // Nothing strictly larger exists. A range in the request's own bin may still fit
+    segregated_mapping(size, &fl, &sl);
+    for (u32 node = state->bins[fl][sl]; node != SEG_INVALID; node = state->nodes[node].next)
+    {
+        if (state->nodes[node].size >= size)
+            return node;
+    }
+    return SEG_INVALID;
+}
+
+// Removes size bytes from the front of the given free range
+static void segregated_take_front(segregated_state* state, u32 node, u64 size)
+{
+    segregated_node* n = &state->nodes[node];
+    segregated_bin_remove(state, node);
+    segregated_table_remove(state, state->starts, segregated_start_key, n->offset);
+    if (n->size == size)
+    {
+        // Exact fit, range is gone entirely
+        segregated_table_remove(state, state->ends, segregated_end_key, n->offset + n->size);
+        segregated_node_release(state, node);
+    }
+    else
+    {
+        // The end is unchanged, so only the start table and bin need updating
+        n->offset += size;
+        n->size -= size;
+        segregated_table_insert(state, state->starts, segregated_start_key, node);
+        segregated_bin_insert(state, node);
+    }
+    state->free_space -= size;
+}
+
+static b8 segregated_allocate_block(freelist* list, u64 size, u64* out_offset)
+{
+    segregated_state* state = list->memory;
+    u32 node = size ? segregated_find(state, size) : SEG_INVALID;
+    if (node == SEG_INVALID)
+    {
+        BWARN("freelist_allocate_block, no block with enough free space found (requested: %lluB, available: %lluB)", size, state->free_space);
+        return false;
+    }
+
+    *out_offset = state->nodes[node].offset;
+    segregated_take_front(state, node, size);
+    return true;
+}
+
+static b8 segregated_allocate_block_at(freelist* list, u64 size, u64 offset)
+{
+    segregated_state* state = list->memory;
+    u32 slot = segregated_table_find(state, state->starts, segregated_start_key, offset);
+    if (slot == SEG_INVALID || state->nodes[state->starts[slot]].size < size)
+        return false;
+
+    segregated_take_front(state, state->starts[slot], size);
+    return true;
+}
+
+static b8 segregated_free_block(freelist* list, u64 size, u64 offset)
+{
+    segregated_state* state = list->memory;
+    if (offset + size > state->total_size)
+    {
+        BWARN("freelist_free_block, range (offset=%llu, size=%llu) is outside of the list (size=%llu)", offset, size, state->total_size);
+        return false;
+    }
+    if (segregated_table_find(state, state->starts, segregated_start_key, offset) != SEG_INVALID)
+    {
+        BFATAL("Attempting to free already-freed block of memory at offset %llu", offset);
+        return false;
+    }
+
+    // Find free neighbours touching either side of the range
+    u32 left_slot = segregated_table_find(state, state->ends, segregated_end_key, offset);
+    u32 right_slot = segregated_table_find(state, state->starts, segregated_start_key, offset + size);
+    u32 left = left_slot == SEG_INVALID ? SEG_INVALID : state->ends[left_slot];
+    u32 right = right_slot == SEG_INVALID ? SEG_INVALID : state->starts[right_slot];
+
+    if (left != SEG_INVALID)
+    {
+        // Grow the left neighbour to the right. Its start is unchanged
+        segregated_bin_remove(state, left);
+        segregated_table_remove(state, state->ends, segregated_end_key, offset);
+        state->nodes[left].size += size;
+        if (right != SEG_INVALID)
+        {
+            // Swallow the right neighbour as well
+            segregated_bin_remove(state, right);
+            segregated_table_remove(state, state->starts, segregated_start_key, offset + size);
+            segregated_table_remove(state, state->ends, segregated_end_key, segregated_end_key(state, right));
+            state->nodes[left].size += state->nodes[right].size;
+            segregated_node_release(state, right);
+        }
+        segregated_table_insert(state, state->ends, segregated_end_key, left);
+        segregated_bin_insert(state, left);
+    }
+    else if (right != SEG_INVALID)
+    {
+        // Grow the right neighbour to the left. Its end is unchanged
+        segregated_bin_remove(state, right);
+        segregated_table_remove(state, state->starts, segregated_start_key, offset + size);
+        state->nodes[right].offset = offset;
+        state->nodes[right].size += size;
+        segregated_table_insert(state, state->starts, segregated_start_key, right);
+        segregated_bin_insert(state, right);
+    }
+    else
+    {
+        // Isolated range
+        if (!segregated_add_range(state, offset, size))
+        {
+            BERROR("freelist_free_block, out of free list nodes (max=%u). Range (offset=%llu, size=%llu) is lost", state->max_entries, offset, size);
+            return false;
+        }
+        return true;
+    }
+
+    state->free_space += size;
+    return true;
+}
+
+static b8 segregated_resize(freelist* list, u64* memory_requirement, void* new_memory, u64 new_size, void** out_old_memory)
+{
+    segregated_create(new_size, memory_requirement, 0, 0);
+    if (!new_memory)
+        return true;
+
+    segregated_state* old_state = list->memory;
+    *out_old_memory = list->memory;
+
+    // Setup new state with nothing free, then carry over existing free ranges
+    freelist new_list;
+    segregated_create(new_size, memory_requirement, new_memory, &new_list);
+    segregated_state* state = new_list.memory;
+    segregated_reset(state);
+    for (u32 i = 0; i < old_state->max_entries; ++i)
+    {
+        segregated_node* n = &old_state->nodes[i];
+        if (n->size && !segregated_add_range(state, n->offset, n->size))
+        {
+            BERROR("freelist_resize ran out of nodes while copying free ranges");
+            list->memory = old_state;
+            return false;
+        }
+    }
+    list->memory = new_memory;
+
+    // The newly added space joins up with the old tail if that was free
+    return segregated_free_block(list, new_size - old_state->total_size, old_state->total_size);
+}
+
+static void segregated_clear(freelist* list)
+{
+    segregated_state* state = list->memory;
+    segregated_reset(state);
+    segregated_add_range(state, 0, state->total_size);
+}
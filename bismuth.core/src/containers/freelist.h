@@ -2,6 +2,26 @@
 
 #include "defines.h"
 
+/**
+ * @brief The strategy a freelist uses to track free ranges.
+ */
+typedef enum freelist_mode
+{
+    /**
+     * @brief Free ranges are kept in a single offset-ordered linked list. Allocation
+     * is first-fit and both allocation and free are O(n) in the number of free ranges.
+     */
+    FREELIST_MODE_FIRST_FIT = 0,
+    /**
+     * @brief Free ranges are kept in TLSF-style segregated size bins, indexed by a
+     * two-level bitmap, with hashed lookups of range boundaries for coalescing.
+     * Allocation and free are O(1) regardless of fragmentation. Allocation picks a
+     * range from the smallest non-empty bin that is guaranteed to fit (good-fit),
+     * only falling back to scanning the request's own bin when nothing larger exists.
+     */
+    FREELIST_MODE_SEGREGATED_FIT = 1
+} freelist_mode;
+
 /**
  * @brief A data structure to be used alongside an allocator for dynamic memory
  * allocation. Tracks free ranges of memory.
@@ -24,6 +44,19 @@ typedef struct freelist
  */
 BAPI void freelist_create(u64 total_size, u64* memory_requirement, void* memory, freelist* out_list);
 
+/**
+ * @brief Creates a new freelist using the given mode, or obtains the memory requirement for one.
+ * Call twice; once passing 0 to memory to obtain memory requirement, and a second
+ * time passing an allocated block to memory. freelist_create() is the same as passing FREELIST_MODE_FIRST_FIT.
+ *
+ * @param total_size The total size in bytes that the free list should track.
+ * @param mode The strategy used to track free ranges.
+ * @param memory_requirement A pointer to hold memory requirement for the free list itself.
+ * @param memory 0, or a pre-allocated block of memory for the free list to use.
+ * @param out_list A pointer to hold the created free list.
+ */
+BAPI void freelist_create_mode(u64 total_size, freelist_mode mode, u64* memory_requirement, void* memory, freelist* out_list);
+
 /**
  * @brief Destroys provided list.
  * 
@@ -41,6 +74,18 @@ BAPI void freelist_destroy(freelist* list);
  */
 BAPI b8 freelist_allocate_block(freelist* list, u64 size, u64* out_offset);
 
+/**
+ * @brief Attempts to allocate a block of the given size at exactly the given offset. Only
+ * succeeds if a free range starts at that offset and is large enough. Typically used to
+ * grow an existing allocation in place by claiming the free space directly after it.
+ * 
+ * @param list A pointer to the list.
+ * @param size The size to allocate.
+ * @param offset The offset the block must start at.
+ * @return b8 True if the block was allocated; otherwise false.
+ */
+BAPI b8 freelist_allocate_block_at(freelist* list, u64 size, u64 offset);
+
 /**
  * @brief Attempts to free a block of memory at the given offset, and of the given
  * size. Can fail if invalid data is passed.
@@ -76,9 +121,9 @@ BAPI b8 freelist_resize(freelist* list, u64* memory_requirement, void* new_memor
 BAPI void freelist_clear(freelist* list);
 
 /**
- * @brief Returns the amount of free space in this list. NOTE: Since this has
- * to iterate the entire internal list, this can be an expensive operation.
- * Use carefully.
+ * @brief Returns the amount of free space in this list. NOTE: In first-fit mode this has
+ * to iterate the entire internal list, so it can be an expensive operation.
+ * Use carefully. Segregated-fit lists keep a running total.
  * 
  * @param list A pointer to the list to obtain from.
  * @return The amount of free space in bytes.
@@ -2,17 +2,13 @@
 
 #include "memory/bmemory.h"
 #include "logger.h"
+#include "strings/bstring.h"
+#include "utils/bhash.h"
 
 static u64 hash_name(const char* name, u32 element_count)
 {
-    // A multipler to use when generating a hash. Prime number to avoid collisions
-    static const u64 multiplier = 97;
-
-    unsigned const char* us;
-    u64 hash = 0;
-
-    for (us = (unsigned const char*)name; *us; us++)
-        hash = hash * multiplier + *us;
+    // NOTE: Hashes are only ever used in memory, so the fast hash is fine here
+    u64 hash = bhash64(name, string_length(name), 0);
 
     // Mod it against the size of the table
     hash %= element_count;
@@ -0,0 +1,190 @@
+#include "slot_map.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+
+// The smallest number of slots the map grows to
+#define SLOT_MAP_MIN_CAPACITY 8
+
+// Handle ids hold the slot's generation in the upper half and its index in the lower half, so every
+// handle handed out differs from every other, even between slots
+static u64 handle_id_make(u32 index, u32 generation)
+{
+    return ((u64)generation << 32) | index;
+}
+
+// Resolves a handle to its slot, or INVALID_ID if the handle isn't live
+static u32 slot_from_handle(const slot_map* map, bhandle handle)
+{
+    u32 index = handle.handle_index;
+    if (index >= map->capacity)
+        return INVALID_ID;
+
+    u32 generation = map->generations[index];
+    // Odd generations are in use. A free slot never matches, even for a forged handle
+    if (!(generation & 1) || handle.unique_id.uniqueid != handle_id_make(index, generation))
+        return INVALID_ID;
+    return index;
+}
+
+static b8 slot_map_grow(slot_map* map, u32 new_capacity)
+{
+    u32 old_capacity = map->capacity;
+    map->generations = breallocate(map->generations, sizeof(u32) * old_capacity, sizeof(u32) * new_capacity, MEMORY_TAG_ARRAY);
+    map->slot_links = breallocate(map->slot_links, sizeof(u32) * old_capacity, sizeof(u32) * new_capacity, MEMORY_TAG_ARRAY);
+    map->dense_slots = breallocate(map->dense_slots, sizeof(u32) * old_capacity, sizeof(u32) * new_capacity, MEMORY_TAG_ARRAY);
+    if (map->element_size)
+        map->values = breallocate(map->values, (u64)map->element_size * old_capacity, (u64)map->element_size * new_capacity, MEMORY_TAG_ARRAY);
+    if (!map->generations || !map->slot_links || !map->dense_slots || (map->element_size && !map->values))
+    {
+        BERROR("Failed to grow slot map to %u slots", new_capacity);
+        return false;
+    }
+
+    // Chain the new slots onto the free list in order, so they're handed out lowest first
+    for (u32 i = old_capacity; i < new_capacity; ++i)
+    {
+        map->generations[i] = 0;
+        map->slot_links[i] = i + 1 < new_capacity ? i + 1 : map->free_head;
+    }
+    map->free_head = old_capacity;
+    map->capacity = new_capacity;
+    return true;
+}
+
+b8 slot_map_create(u32 element_size, u32 initial_capacity, slot_map* out_map)
+{
+    if (!out_map)
+    {
+        BERROR("slot_map_create requires a valid pointer to out_map");
+        return false;
+    }
+
+    bzero_memory(out_map, sizeof(slot_map));
+    out_map->element_size = element_size;
+    out_map->free_head = INVALID_ID;
+    if (initial_capacity && !slot_map_grow(out_map, initial_capacity))
+    {
+        slot_map_destroy(out_map);
+        return false;
+    }
+    return true;
+}
+
+void slot_map_destroy(slot_map* map)
+{
+    if (map)
+    {
+        if (map->generations)
+            bfree(map->generations, sizeof(u32) * map->capacity, MEMORY_TAG_ARRAY);
+        if (map->slot_links)
+            bfree(map->slot_links, sizeof(u32) * map->capacity, MEMORY_TAG_ARRAY);
+        if (map->dense_slots)
+            bfree(map->dense_slots, sizeof(u32) * map->capacity, MEMORY_TAG_ARRAY);
+        if (map->values)
+            bfree(map->values, (u64)map->element_size * map->capacity, MEMORY_TAG_ARRAY);
+        bzero_memory(map, sizeof(slot_map));
+        map->free_head = INVALID_ID;
+    }
+}
+
+b8 slot_map_add(slot_map* map, const void* value, bhandle* out_handle)
+{
+    if (!map || !out_handle)
+    {
+        BERROR("slot_map_add requires valid pointers to map and out_handle");
+        return false;
+    }
+
+    if (map->free_head == INVALID_ID)
+    {
+        u32 new_capacity = map->capacity ? map->capacity * 2 : SLOT_MAP_MIN_CAPACITY;
+        if (new_capacity <= map->capacity || new_capacity == INVALID_ID)
+        {
+            BERROR("slot_map_add - the map is full and cannot grow any further");
+            return false;
+        }
+        if (!slot_map_grow(map, new_capacity))
+            return false;
+    }
+
+    // Take the first free slot, and put its entry on the end of the dense arrays
+    u32 index = map->free_head;
+    map->free_head = map->slot_links[index];
+    u32 dense_index = map->count++;
+    map->slot_links[index] = dense_index;
+    map->dense_slots[dense_index] = index;
+    if (map->element_size)
+    {
+        u8* dest = map->values + (u64)dense_index * map->element_size;
+        if (value)
+            bcopy_memory(dest, value, map->element_size);
+        else
+            bzero_memory(dest, map->element_size);
+    }
+
+    // Becomes odd, marking the slot as in use
+    u32 generation = ++map->generations[index];
+
+    *out_handle = bhandle_create_with_u64_identifier(index, handle_id_make(index, generation));
+    return true;
+}
+
+b8 slot_map_remove(slot_map* map, bhandle handle, void* out_value)
+{
+    u32 index = slot_from_handle(map, handle);
+    if (index == INVALID_ID)
+        return false;
+
+    // Move the last entry into the removed one's place, to keep the dense arrays packed
+    u32 dense_index = map->slot_links[index];
+    u32 last = --map->count;
+    if (map->element_size)
+    {
+        u8* removed = map->values + (u64)dense_index * map->element_size;
+        if (out_value)
+            bcopy_memory(out_value, removed, map->element_size);
+        if (dense_index != last)
+            bcopy_memory(removed, map->values + (u64)last * map->element_size, map->element_size);
+    }
+    if (dense_index != last)
+    {
+        u32 moved_slot = map->dense_slots[last];
+        map->dense_slots[dense_index] = moved_slot;
+        map->slot_links[moved_slot] = dense_index;
+    }
+
+    // Becomes even, marking the slot as free and leaving every handle to it stale
+    map->generations[index]++;
+    map->slot_links[index] = map->free_head;
+    map->free_head = index;
+    return true;
+}
+
+b8 slot_map_is_valid(const slot_map* map, bhandle handle)
+{
+    return slot_from_handle(map, handle) != INVALID_ID;
+}
+
+void* slot_map_get(const slot_map* map, bhandle handle)
+{
+    if (!map->element_size)
+        return 0;
+
+    u32 index = slot_from_handle(map, handle);
+    if (index == INVALID_ID)
+        return 0;
+    return map->values + (u64)map->slot_links[index] * map->element_size;
+}
+
+bhandle slot_map_handle_at(const slot_map* map, u32 dense_index)
+{
+    u32 index = map->dense_slots[dense_index];
+    return bhandle_create_with_u64_identifier(index, handle_id_make(index, map->generations[index]));
+}
+
+void slot_map_clear(slot_map* map)
+{
+    while (map->count > 0)
+        slot_map_remove(map, slot_map_handle_at(map, map->count - 1), 0);
+}
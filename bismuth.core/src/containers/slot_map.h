@@ -0,0 +1,109 @@
+#pragma once
+
+#include "defines.h"
+#include "identifiers/bhandle.h"
+
+/**
+ * @brief Hands out bhandles for objects stored in slots, for systems which refer to their objects
+ * by handle. Free slots are chained into a list, so creating and destroying handles is O(1) however
+ * many objects exist, and each slot has a generation counter, so handles to destroyed objects are
+ * reliably detected as stale even once the slot is reused. Live entries are also packed into a dense
+ * array for fast iteration.
+ *
+ * Optionally stores a value of element_size bytes with each entry. Values are kept densely, so
+ * they move when other entries are removed. Systems which keep their own per-slot arrays (indexed
+ * by handle_index) can pass an element_size of 0 to only manage handles, growing their arrays
+ * whenever the map's capacity grows.
+ * Members of this structure should not be modified outside the functions associated with it.
+ */
+typedef struct slot_map
+{
+    // Size of each value in bytes. 0 if only handles are managed
+    u32 element_size;
+    // Number of live entries, which are the first count entries of the dense arrays
+    u32 count;
+    // Number of slots
+    u32 capacity;
+    // The first free slot, or INVALID_ID if there are none
+    u32 free_head;
+    // Generation of each slot. Odd while the slot is in use, even while it is free
+    u32* generations;
+    // For each slot: the index of its entry in the dense arrays while in use, or the next free slot while free
+    u32* slot_links;
+    // The slot of each live entry, in dense order
+    u32* dense_slots;
+    // The value of each live entry, in dense order, element_size bytes apiece. 0 if element_size is 0
+    u8* values;
+} slot_map;
+
+/**
+ * @brief Creates a slot map.
+ *
+ * @param element_size The size of the value stored with each entry. May be 0 to only manage handles.
+ * @param initial_capacity The number of slots to create up front. May be 0.
+ * @param out_map A pointer to hold the created map.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 slot_map_create(u32 element_size, u32 initial_capacity, slot_map* out_map);
+
+/**
+ * @brief Destroys the given map and releases its memory. All handles from it become invalid.
+ *
+ * @param map A pointer to the map to be destroyed.
+ */
+BAPI void slot_map_destroy(slot_map* map);
+
+/**
+ * @brief Takes a free slot, growing the map if there are none, and returns a handle to it.
+ *
+ * @param map A pointer to the map. Required.
+ * @param value A pointer to element_size bytes to be copied in. If 0, the value is zeroed. Ignored if element_size is 0.
+ * @param out_handle A pointer to hold the new handle. Required.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 slot_map_add(slot_map* map, const void* value, bhandle* out_handle);
+
+/**
+ * @brief Frees the slot the given handle refers to. The handle, and any copies of it, become stale.
+ *
+ * @param map A pointer to the map. Required.
+ * @param handle The handle to remove.
+ * @param out_value A pointer to hold a copy of the removed value. Optional.
+ * @return True if the handle was valid and has been removed; otherwise false.
+ */
+BAPI b8 slot_map_remove(slot_map* map, bhandle handle, void* out_value);
+
+/**
+ * @brief Indicates if the given handle refers to a live entry in the map (i.e. isn't invalid, stale or from elsewhere).
+ *
+ * @param map A pointer to the map. Required.
+ * @param handle The handle to check.
+ * @return True if the handle is valid; otherwise false.
+ */
+BAPI b8 slot_map_is_valid(const slot_map* map, bhandle handle);
+
+/**
+ * @brief Obtains a pointer to the value stored with the given handle.
+ * NOTE: Only valid until the next entry is added to or removed from the map.
+ *
+ * @param map A pointer to the map. Required.
+ * @param handle The handle to look up.
+ * @return A pointer to the value if the handle is valid and the map stores values; otherwise 0.
+ */
+BAPI void* slot_map_get(const slot_map* map, bhandle handle);
+
+/**
+ * @brief Obtains a handle to the live entry at the given position in the dense arrays.
+ *
+ * @param map A pointer to the map. Required.
+ * @param dense_index The position of the entry. Must be less than the map's count.
+ * @return A handle to the entry.
+ */
+BAPI bhandle slot_map_handle_at(const slot_map* map, u32 dense_index);
+
+/**
+ * @brief Removes all entries, making every existing handle stale. Keeps the slots for reuse.
+ *
+ * @param map A pointer to the map. Required.
+ */
+BAPI void slot_map_clear(slot_map* map);
@@ -0,0 +1,96 @@
+#include "sparse_set.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+
+b8 sparse_set_create(u32 universe, sparse_set* out_set)
+{
+    if (!out_set)
+    {
+        BERROR("sparse_set_create requires a valid pointer to out_set");
+        return false;
+    }
+
+    bzero_memory(out_set, sizeof(sparse_set));
+    return sparse_set_resize(out_set, universe);
+}
+
+void sparse_set_destroy(sparse_set* set)
+{
+    if (set)
+    {
+        if (set->sparse)
+            bfree(set->sparse, sizeof(u32) * set->universe, MEMORY_TAG_ARRAY);
+        if (set->dense)
+            bfree(set->dense, sizeof(u32) * set->universe, MEMORY_TAG_ARRAY);
+        bzero_memory(set, sizeof(sparse_set));
+    }
+}
+
+b8 sparse_set_resize(sparse_set* set, u32 universe)
+{
+    if (universe == set->universe)
+        return true;
+
+    if (universe < set->universe)
+    {
+        // Drop the members which no longer fit before the arrays shrink.
+        // Walk backwards, since removing swaps the last member into the gap
+        for (u32 i = set->count; i > 0; --i)
+        {
+            if (set->dense[i - 1] >= universe)
+                sparse_set_remove(set, set->dense[i - 1]);
+        }
+    }
+
+    if (universe == 0)
+    {
+        sparse_set_destroy(set);
+        return true;
+    }
+
+    // The dense array can hold the whole universe, so inserting never needs to grow it
+    u32* sparse = breallocate(set->sparse, sizeof(u32) * set->universe, sizeof(u32) * universe, MEMORY_TAG_ARRAY);
+    if (sparse)
+        set->sparse = sparse;
+    u32* dense = breallocate(set->dense, sizeof(u32) * set->universe, sizeof(u32) * universe, MEMORY_TAG_ARRAY);
+    if (dense)
+        set->dense = dense;
+    if (!sparse || !dense)
+    {
+        BERROR("Failed to resize sparse set to a universe of %u", universe);
+        return false;
+    }
+
+    set->universe = universe;
+    return true;
+}
+
+b8 sparse_set_insert(sparse_set* set, u32 value)
+{
+    if (value >= set->universe)
+    {
+        BERROR("sparse_set_insert - value %u is outside of the set's universe of %u", value, set->universe);
+        return false;
+    }
+    if (sparse_set_contains(set, value))
+        return false;
+
+    set->sparse[value] = set->count;
+    set->dense[set->count] = value;
+    set->count++;
+    return true;
+}
+
+b8 sparse_set_remove(sparse_set* set, u32 value)
+{
+    if (!sparse_set_contains(set, value))
+        return false;
+
+    // Move the last member into the removed one's place
+    u32 position = set->sparse[value];
+    u32 last = set->dense[--set->count];
+    set->dense[position] = last;
+    set->sparse[last] = position;
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A set of u32 values below a fixed limit (the universe), i.e. slot or handle indices.
+ * Inserting, removing and checking for a value are all O(1), clearing is O(1), and the members
+ * are packed into a dense array for fast iteration. Unlike a bitset, iterating only touches the
+ * members, however large the universe. Members are not kept in any particular order.
+ * A zeroed structure is a valid, empty set with a universe of 0.
+ * Members of this structure should not be modified outside the functions associated with it.
+ */
+typedef struct sparse_set
+{
+    // The number of members, which are the first count entries of dense
+    u32 count;
+    // Values must be less than this
+    u32 universe;
+    // For each value, its position in dense. Only meaningful for members
+    u32* sparse;
+    // The members, in no particular order
+    u32* dense;
+} sparse_set;
+
+/**
+ * @brief Creates an empty sparse set.
+ *
+ * @param universe The number of possible values, which must all be less than this. May be 0.
+ * @param out_set A pointer to hold the created set.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 sparse_set_create(u32 universe, sparse_set* out_set);
+
+/**
+ * @brief Destroys the given set and releases its memory.
+ *
+ * @param set A pointer to the set to be destroyed.
+ */
+BAPI void sparse_set_destroy(sparse_set* set);
+
+/**
+ * @brief Changes the number of possible values. Members are kept; when shrinking, any members
+ * which no longer fit are removed.
+ *
+ * @param set A pointer to the set. Required.
+ * @param universe The new number of possible values.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 sparse_set_resize(sparse_set* set, u32 universe);
+
+/**
+ * @brief Adds the given value to the set, if it isn't already a member.
+ *
+ * @param set A pointer to the set. Required.
+ * @param value The value to add. Must be less than the set's universe.
+ * @return True if the value was added; false if it was already a member or out of range.
+ */
+BAPI b8 sparse_set_insert(sparse_set* set, u32 value);
+
+/**
+ * @brief Removes the given value from the set. The last member takes its place in the dense array.
+ *
+ * @param set A pointer to the set. Required.
+ * @param value The value to remove.
+ * @return True if the value was removed; false if it wasn't a member.
+ */
+BAPI b8 sparse_set_remove(sparse_set* set, u32 value);
+
+/** @brief Indicates if the given value is a member of the set. Values outside the universe never are. */
+BINLINE b8 sparse_set_contains(const sparse_set* set, u32 value)
+{
+    if (value >= set->universe)
+        return false;
+    u32 position = set->sparse[value];
+    return position < set->count && set->dense[position] == value;
+}
+
+/** @brief Removes every member. O(1), as stale entries are never trusted. */
+BINLINE void sparse_set_clear(sparse_set* set)
+{
+    set->count = 0;
+}
@@ -0,0 +1,532 @@
+#include "u64_btree.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+
+// The most keys a node can hold. Odd, so two minimal nodes and their separator fit in one when merged
+#define U64_BTREE_MAX_KEYS 31
+// The fewest keys any node other than the root may hold
+#define U64_BTREE_MIN_KEYS (U64_BTREE_MAX_KEYS / 2)
+
+/*
+ * NOTE: Entries are only stored in leaves, which are linked in key order for range iteration.
+ * Interior nodes hold separator keys: every key in children[i] is less than keys[i], and
+ * every key in children[i + 1] is greater than or equal to it.
+ */
+typedef struct u64_btree_node
+{
+    u32 count;
+    b8 leaf;
+    u64 keys[U64_BTREE_MAX_KEYS];
+    union
+    {
+        struct
+        {
+            bt_node_value values[U64_BTREE_MAX_KEYS];
+            struct u64_btree_node* next;
+        };
+        struct u64_btree_node* children[U64_BTREE_MAX_KEYS + 1];
+    };
+} u64_btree_node;
+
+static u64_btree_node* node_create(b8 leaf)
+{
+    u64_btree_node* node = ballocate(sizeof(u64_btree_node), MEMORY_TAG_BST);
+    if (node)
+        node->leaf = leaf;
+    return node;
+}
+
+static void node_destroy(u64_btree_node* node)
+{
+    bfree(node, sizeof(u64_btree_node), MEMORY_TAG_BST);
+}
+
+// Index of the first key not less than the given one
+static u32 lower_bound(const u64_btree_node* node, u64 key)
+{
+    u32 low = 0;
+    u32 high = node->count;
+    while (low < high)
+    {
+        u32 mid = (low + high) / 2;
+        if (node->keys[mid] < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Index of the child which would hold the given key
+static u32 child_index(const u64_btree_node* node, u64 key)
+{
+    u32 low = 0;
+    u32 high = node->count;
+    while (low < high)
+    {
+        u32 mid = (low + high) / 2;
+        if (node->keys[mid] <= key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// NOTE: The shifts below overlap, so they copy in whichever direction leaves the source intact
+#define ARRAY_SHIFT(array, from, end, offset)                 \
+    if ((offset) > 0)                                         \
+    {                                                         \
+        for (u32 i = (end); i > (from); --i)                  \
+            (array)[i - 1 + (offset)] = (array)[i - 1];       \
+    }                                                         \
+    else                                                      \
+    {                                                         \
+        for (u32 i = (from); i < (end); ++i)                  \
+            (array)[i + (offset)] = (array)[i];               \
+    }
+
+static void keys_shift(u64_btree_node* node, u32 from, i32 offset)
+{
+    ARRAY_SHIFT(node->keys, from, node->count, offset);
+}
+
+static void values_shift(u64_btree_node* node, u32 from, i32 offset)
+{
+    ARRAY_SHIFT(node->values, from, node->count, offset);
+}
+
+static void children_shift(u64_btree_node* node, u32 from, i32 offset)
+{
+    ARRAY_SHIFT(node->children, from, node->count + 1, offset);
+}
+
+// Splits the full child at the given index in two, adding the new right half to the parent
+static b8 child_split(u64_btree_node* parent, u32 index)
+{
+    u64_btree_node* left = parent->children[index];
+    u64_btree_node* right = node_create(left->leaf);
+    if (!right)
+        return false;
+
+    u64 separator;
+    if (left->leaf)
+    {
+        // Leaves keep every key, so the separator is a copy of the right half's first one
+        u32 keep = U64_BTREE_MAX_KEYS / 2;
+        right->count = left->count - keep;
+        bcopy_memory(right->keys, &left->keys[keep], sizeof(u64) * right->count);
+        bcopy_memory(right->values, &left->values[keep], sizeof(bt_node_value) * right->count);
+        left->count = keep;
+        right->next = left->next;
+        left->next = right;
+        separator = right->keys[0];
+    }
+    else
+    {
+        // The middle key moves up to the parent
+        u32 keep = U64_BTREE_MAX_KEYS / 2;
+        separator = left->keys[keep];
+        right->count = left->count - keep - 1;
+        bcopy_memory(right->keys, &left->keys[keep + 1], sizeof(u64) * right->count);
+        bcopy_memory(right->children, &left->children[keep + 1], sizeof(u64_btree_node*) * (right->count + 1));
+        left->count = keep;
+    }
+
+    keys_shift(parent, index, 1);
+    children_shift(parent, index + 1, 1);
+    parent->keys[index] = separator;
+    parent->children[index + 1] = right;
+    parent->count++;
+    return true;
+}
+
+b8 u64_btree_insert(u64_btree* tree, u64 key, bt_node_value value)
+{
+    if (!tree)
+        return false;
+
+    if (!tree->root)
+    {
+        tree->root = node_create(true);
+        if (!tree->root)
+        {
+            BERROR("u64_btree_insert failed to allocate a node");
+            return false;
+        }
+        tree->height = 1;
+    }
+
+    // Split a full root first, so there is always room to split its children on the way down
+    if (tree->root->count == U64_BTREE_MAX_KEYS)
+    {
+        u64_btree_node* root = node_create(false);
+        if (!root)
+        {
+            BERROR("u64_btree_insert failed to allocate a node");
+            return false;
+        }
+        root->children[0] = tree->root;
+        if (!child_split(root, 0))
+        {
+            node_destroy(root);
+            BERROR("u64_btree_insert failed to allocate a node");
+            return false;
+        }
+        tree->root = root;
+        tree->height++;
+    }
+
+    u64_btree_node* node = tree->root;
+    while (!node->leaf)
+    {
+        u32 index = child_index(node, key);
+        if (node->children[index]->count == U64_BTREE_MAX_KEYS)
+        {
+            if (!child_split(node, index))
+            {
+                BERROR("u64_btree_insert failed to allocate a node");
+                return false;
+            }
+            if (key >= node->keys[index])
+                index++;
+        }
+        node = node->children[index];
+    }
+
+    u32 index = lower_bound(node, key);
+    if (index < node->count && node->keys[index] == key)
+        return false;
+
+    keys_shift(node, index, 1);
+    values_shift(node, index, 1);
+    node->keys[index] = key;
+    node->values[index] = value;
+    node->count++;
+    tree->count++;
+    return true;
+}
+
+// Merges the child to the right of the separator at the given index into the one on its left
+static void children_merge(u64_btree_node* parent, u32 index)
+{
+    u64_btree_node* left = parent->children[index];
+    u64_btree_node* right = parent->children[index + 1];
+
+    if (left->leaf)
+    {
+        bcopy_memory(&left->keys[left->count], right->keys, sizeof(u64) * right->count);
+        bcopy_memory(&left->values[left->count], right->values, sizeof(bt_node_value) * right->count);
+        left->count += right->count;
+        left->next = right->next;
+    }
+    else
+    {
+        // The separator comes back down between the two halves
+        left->keys[left->count] = parent->keys[index];
+        bcopy_memory(&left->keys[left->count + 1], right->keys, sizeof(u64) * right->count);
+        bcopy_memory(&left->children[left->count + 1], right->children, sizeof(u64_btree_node*) * (right->count + 1));
+        left->count += right->count + 1;
+    }
+
+    keys_shift(parent, index + 1, -1);
+    children_shift(parent, index + 2, -1);
+    parent->count--;
+    node_destroy(right);
+}
+
+// Makes sure the child at the given index has more than the minimum number of keys, so one can be deleted from it
+static void child_fill(u64_btree_node* parent, u32 index)
+{
+    u64_btree_node* child = parent->children[index];
+    u64_btree_node* left = index > 0 ? parent->children[index - 1] : 0;
+    u64_btree_node* right = index < parent->count ? parent->children[index + 1] : 0;
+
+    if (left && left->count > U64_BTREE_MIN_KEYS)
+    {
+        // Borrow the last entry of the left sibling
+        keys_shift(child, 0, 1);
+        if (child->leaf)
+        {
+            values_shift(child, 0, 1);
+            child->keys[0] = left->keys[left->count - 1];
+            child->values[0] = left->values[left->count - 1];
+            parent->keys[index - 1] = child->keys[0];
+        }
+        else
+        {
+            children_shift(child, 0, 1);
+            child->keys[0] = parent->keys[index - 1];
+            child->children[0] = left->children[left->count];
+            parent->keys[index - 1] = left->keys[left->count - 1];
+        }
+        left->count--;
+        child->count++;
+    }
+    else if (right && right->count > U64_BTREE_MIN_KEYS)
+    {
+        // Borrow the first entry of the right sibling
+        if (child->leaf)
+        {
+            child->keys[child->count] = right->keys[0];
+            child->values[child->count] = right->values[0];
+            keys_shift(right, 1, -1);
+            values_shift(right, 1, -1);
+            right->count--;
+            parent->keys[index] = right->keys[0];
+        }
+        else
+        {
+            child->keys[child->count] = parent->keys[index];
+            child->children[child->count + 1] = right->children[0];
+            parent->keys[index] = right->keys[0];
+            keys_shift(right, 1, -1);
+            children_shift(right, 1, -1);
+            right->count--;
+        }
+        child->count++;
+    }
+    else if (left)
+    {
+        children_merge(parent, index - 1);
+    }
+    else
+    {
+        children_merge(parent, index);
+    }
+}
+
+b8 u64_btree_delete(u64_btree* tree, u64 key, bt_node_value* out_value)
+{
+    if (!tree || !tree->root)
+        return false;
+
+    u64_btree_node* node = tree->root;
+    while (!node->leaf)
+    {
+        u32 index = child_index(node, key);
+        if (node->children[index]->count <= U64_BTREE_MIN_KEYS)
+        {
+            child_fill(node, index);
+            // A merge may have emptied the root, in which case its only child takes over
+            if (node == tree->root && node->count == 0)
+            {
+                tree->root = node->children[0];
+                tree->height--;
+                node_destroy(node);
+                node = tree->root;
+                continue;
+            }
+            index = child_index(node, key);
+        }
+        node = node->children[index];
+    }
+
+    u32 index = lower_bound(node, key);
+    if (index >= node->count || node->keys[index] != key)
+        return false;
+
+    if (out_value)
+        *out_value = node->values[index];
+    keys_shift(node, index + 1, -1);
+    values_shift(node, index + 1, -1);
+    node->count--;
+    tree->count--;
+
+    if (tree->count == 0)
+        u64_btree_cleanup(tree);
+    return true;
+}
+
+const bt_node_value* u64_btree_find(const u64_btree* tree, u64 key)
+{
+    if (!tree || !tree->root)
+        return 0;
+
+    const u64_btree_node* node = tree->root;
+    while (!node->leaf)
+        node = node->children[child_index(node, key)];
+
+    u32 index = lower_bound(node, key);
+    if (index < node->count && node->keys[index] == key)
+        return &node->values[index];
+    return 0;
+}
+
+static void node_destroy_recursive(u64_btree_node* node);
+
+// Destroys the subtrees held by a partially built level: the first built_count slots, and the slots from offset up to
+// node_count which no parent has taken yet
+static void level_destroy(u64_btree_node** level, u32 built_count, u32 offset, u32 node_count)
+{
+    for (u32 i = 0; i < built_count; ++i)
+        node_destroy_recursive(level[i]);
+    for (u32 i = offset; i < node_count; ++i)
+        node_destroy_recursive(level[i]);
+}
+
+b8 u64_btree_build(u64_btree* tree, u32 count, const u64* keys, const bt_node_value* values)
+{
+    if (!tree || (count && (!keys || !values)))
+    {
+        BERROR("u64_btree_build requires a valid pointer to a tree, and keys and values when count is nonzero");
+        return false;
+    }
+
+    u64_btree_cleanup(tree);
+    if (!count)
+        return true;
+
+    for (u32 i = 1; i < count; ++i)
+    {
+        if (keys[i] <= keys[i - 1])
+        {
+            BERROR("u64_btree_build requires keys in strictly increasing order");
+            return false;
+        }
+    }
+
+    // Nodes of the level being built, along with the lowest key beneath each
+    u32 node_count = (count + U64_BTREE_MAX_KEYS - 1) / U64_BTREE_MAX_KEYS;
+    u64 level_memory_size = (sizeof(u64_btree_node*) + sizeof(u64)) * node_count;
+    u64_btree_node** level = ballocate(level_memory_size, MEMORY_TAG_BST);
+    if (!level)
+    {
+        BERROR("u64_btree_build failed to allocate memory");
+        return false;
+    }
+    u64* level_keys = (u64*)(level + node_count);
+
+    // Leaves first. Entries are spread evenly, so no leaf ends up below the minimum
+    u64_btree_node* previous = 0;
+    u32 offset = 0;
+    for (u32 i = 0; i < node_count; ++i)
+    {
+        u32 take = (count - offset) / (node_count - i);
+        u64_btree_node* leaf = node_create(true);
+        if (!leaf)
+        {
+            level_destroy(level, i, 0, 0);
+            bfree(level, level_memory_size, MEMORY_TAG_BST);
+            BERROR("u64_btree_build failed to allocate a node");
+            return false;
+        }
+        bcopy_memory(leaf->keys, &keys[offset], sizeof(u64) * take);
+        bcopy_memory(leaf->values, &values[offset], sizeof(bt_node_value) * take);
+        leaf->count = take;
+        if (previous)
+            previous->next = leaf;
+        previous = leaf;
+        level[i] = leaf;
+        level_keys[i] = keys[offset];
+        offset += take;
+    }
+    tree->height = 1;
+
+    // Then each level of interior nodes above, until a single node remains
+    while (node_count > 1)
+    {
+        u32 parent_count = (node_count + U64_BTREE_MAX_KEYS) / (U64_BTREE_MAX_KEYS + 1);
+        offset = 0;
+        for (u32 i = 0; i < parent_count; ++i)
+        {
+            u32 take = (node_count - offset) / (parent_count - i);
+            u64_btree_node* parent = node_create(false);
+            if (!parent)
+            {
+                level_destroy(level, i, offset, node_count);
+                bfree(level, level_memory_size, MEMORY_TAG_BST);
+                tree->height = 0;
+                BERROR("u64_btree_build failed to allocate a node");
+                return false;
+            }
+            for (u32 c = 0; c < take; ++c)
+            {
+                parent->children[c] = level[offset + c];
+                if (c > 0)
+                    parent->keys[c - 1] = level_keys[offset + c];
+            }
+            parent->count = take - 1;
+            // NOTE: Parents are written over the level's earlier slots, which have already been read
+            u64 lowest_key = level_keys[offset];
+            level[i] = parent;
+            level_keys[i] = lowest_key;
+            offset += take;
+        }
+        node_count = parent_count;
+        tree->height++;
+    }
+
+    tree->root = level[0];
+    tree->count = count;
+    bfree(level, level_memory_size, MEMORY_TAG_BST);
+    return true;
+}
+
+u64_btree_iterator u64_btree_range(const u64_btree* tree, u64 min_key, u64 max_key)
+{
+    u64_btree_iterator iterator = {0};
+    iterator.max_key = max_key;
+    if (!tree || !tree->root || min_key > max_key)
+        return iterator;
+
+    const u64_btree_node* node = tree->root;
+    while (!node->leaf)
+        node = node->children[child_index(node, min_key)];
+
+    iterator.node = node;
+    iterator.index = lower_bound(node, min_key);
+    return iterator;
+}
+
+b8 u64_btree_iterator_next(u64_btree_iterator* iterator, u64* out_key, bt_node_value* out_value)
+{
+    if (!iterator)
+        return false;
+
+    // Skip past the end of this leaf (and any others which may have been left empty)
+    while (iterator->node && iterator->index >= iterator->node->count)
+    {
+        iterator->node = iterator->node->next;
+        iterator->index = 0;
+    }
+    if (!iterator->node)
+        return false;
+
+    u64 key = iterator->node->keys[iterator->index];
+    if (key > iterator->max_key)
+    {
+        iterator->node = 0;
+        return false;
+    }
+
+    if (out_key)
+        *out_key = key;
+    if (out_value)
+        *out_value = iterator->node->values[iterator->index];
+    iterator->index++;
+    return true;
+}
+
+static void node_destroy_recursive(u64_btree_node* node)
+{
+    if (!node->leaf)
+    {
+        for (u32 i = 0; i <= node->count; ++i)
+            node_destroy_recursive(node->children[i]);
+    }
+    node_destroy(node);
+}
+
+void u64_btree_cleanup(u64_btree* tree)
+{
+    if (tree)
+    {
+        if (tree->root)
+            node_destroy_recursive(tree->root);
+        tree->root = 0;
+        tree->count = 0;
+        tree->height = 0;
+    }
+}
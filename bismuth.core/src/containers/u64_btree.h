@@ -0,0 +1,118 @@
+#pragma once
+
+#include "defines.h"
+
+// Represents the value of a tree entry
+typedef union bt_node_value
+{
+    void* p;
+    const char* str;
+    u64 u64;
+    i64 i64;
+    u32 u32;
+    i32 i32;
+    u16 u16;
+    i16 i16;
+    u8 u8;
+    i8 i8;
+    b8 b8;
+    f32 f32;
+} bt_node_value;
+
+struct u64_btree_node;
+
+/**
+ * @brief An ordered map of u64 keys to bt_node_values, stored as a B+ tree. Many entries are
+ * packed into each node, so the tree stays shallow and lookups touch few cache lines, and it
+ * stays balanced however keys are inserted (i.e. in increasing order). A zeroed structure is
+ * a valid, empty tree. Members of this structure should not be modified outside the functions
+ * associated with it.
+ */
+typedef struct u64_btree
+{
+    struct u64_btree_node* root;
+    // The number of entries in the tree
+    u32 count;
+    // The number of levels in the tree. 0 when empty, 1 when the root holds entries directly
+    u32 height;
+} u64_btree;
+
+/**
+ * @brief Used to step through a range of entries in key order. Obtained from u64_btree_range().
+ * Only valid until the tree is next changed.
+ */
+typedef struct u64_btree_iterator
+{
+    const struct u64_btree_node* node;
+    u32 index;
+    u64 max_key;
+} u64_btree_iterator;
+
+/**
+ * Inserts an entry into the given tree. If an entry with the key already exists, it is left as-is.
+ *
+ * @param tree A pointer to the tree.
+ * @param key The key to be inserted.
+ * @param value The value to be inserted. NOTE: The tree does NOT take its own copy of any data pointed to.
+ * @returns True if the entry was inserted; false if the key already existed or on error.
+ */
+BAPI b8 u64_btree_insert(u64_btree* tree, u64 key, bt_node_value value);
+
+/**
+ * Attempts to delete the entry with the given key from the tree.
+ *
+ * @param tree A pointer to the tree.
+ * @param key The key to be deleted.
+ * @param out_value A pointer to hold the deleted entry's value, so it can be cleaned up by the caller. Optional.
+ * @returns True if the entry was found and deleted; otherwise false.
+ */
+BAPI b8 u64_btree_delete(u64_btree* tree, u64 key, bt_node_value* out_value);
+
+/**
+ * Attempts to find the entry with the given key.
+ *
+ * @param tree A constant pointer to the tree.
+ * @param key The key to search for.
+ * @returns A constant pointer to the entry's value, if found; otherwise 0/null. Only valid until the tree is next changed.
+ */
+BAPI const bt_node_value* u64_btree_find(const u64_btree* tree, u64 key);
+
+/**
+ * Replaces the contents of the tree with the given entries, building it directly rather than
+ * inserting them one at a time. Much faster than inserting when many entries are known up front.
+ *
+ * @param tree A pointer to the tree.
+ * @param count The number of entries.
+ * @param keys An array of count keys, in strictly increasing order.
+ * @param values An array of count values, matching the keys.
+ * @returns True on success; otherwise false (i.e. if the keys were not in order), in which case the tree is left empty.
+ */
+BAPI b8 u64_btree_build(u64_btree* tree, u32 count, const u64* keys, const bt_node_value* values);
+
+/**
+ * Obtains an iterator over all entries with keys in the range [min_key, max_key], in key order.
+ * Pass 0 and U64_MAX to iterate the whole tree.
+ *
+ * @param tree A constant pointer to the tree.
+ * @param min_key The lowest key to include.
+ * @param max_key The highest key to include.
+ * @returns The iterator, to be passed to u64_btree_iterator_next().
+ */
+BAPI u64_btree_iterator u64_btree_range(const u64_btree* tree, u64 min_key, u64 max_key);
+
+/**
+ * Steps to the next entry in the iterator's range.
+ *
+ * @param iterator A pointer to the iterator.
+ * @param out_key A pointer to hold the entry's key. Optional.
+ * @param out_value A pointer to hold the entry's value. Optional.
+ * @returns True if an entry was returned; false once the range is exhausted.
+ */
+BAPI b8 u64_btree_iterator_next(u64_btree_iterator* iterator, u64* out_key, bt_node_value* out_value);
+
+/**
+ * Releases all memory held by the tree, leaving it empty.
+ *
+ * @param tree A pointer to the tree to cleanup.
+ */
+BAPI void u64_btree_cleanup(u64_btree* tree);
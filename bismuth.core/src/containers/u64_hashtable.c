@@ -0,0 +1,347 @@
+#include "u64_hashtable.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+
+// The smallest number of slots a table is given
+#define U64_HASHTABLE_MIN_CAPACITY 16
+// Fibonacci hashing multiplier. Spreads sequential keys (i.e. ids) across the table as well as hashed ones
+#define U64_HASHTABLE_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+/*
+ * NOTE: Each table has one slot more than its capacity. The extra "spare" slot holds the entry
+ * being inserted, and is where entries are swapped through as they are displaced.
+ */
+
+static u32 slot_home(const u64_hashtable* table, u64 key)
+{
+    return (u32)((key * U64_HASHTABLE_MULTIPLIER) >> table->shift);
+}
+
+// Robin Hood probing keeps lookups short at high load, so the table is allowed to fill to 7/8
+static b8 load_exceeded(u32 count, u32 capacity)
+{
+    return (u64)count * 8 > (u64)capacity * 7;
+}
+
+static u32 capacity_for(u32 count)
+{
+    u32 capacity = U64_HASHTABLE_MIN_CAPACITY;
+    while (load_exceeded(count, capacity))
+        capacity *= 2;
+    return capacity;
+}
+
+static u64 table_memory_size(u32 element_size, u32 capacity)
+{
+    u64 slots = (u64)capacity + 1;
+    return slots * (sizeof(u64) + element_size + sizeof(u8));
+}
+
+static b8 table_allocate(u64_hashtable* table, u32 capacity)
+{
+    u64 slots = (u64)capacity + 1;
+    u8* block = ballocate(table_memory_size(table->element_size, capacity), MEMORY_TAG_HASHTABLE);
+    if (!block)
+        return false;
+
+    // Keys first, so they stay 8-byte aligned
+    table->keys = (u64*)block;
+    table->values = block + (slots * sizeof(u64));
+    table->distances = table->values + (slots * table->element_size);
+    table->capacity = capacity;
+    table->shift = 64 - (u32)__builtin_ctz(capacity);
+    return true;
+}
+
+static void table_free(u64_hashtable* table)
+{
+    if (table->keys)
+        bfree(table->keys, table_memory_size(table->element_size, table->capacity), MEMORY_TAG_HASHTABLE);
+    table->keys = 0;
+    table->values = 0;
+    table->distances = 0;
+}
+
+static void* slot_value(const u64_hashtable* table, u32 index)
+{
+    return table->values + ((u64)index * table->element_size);
+}
+
+static void slot_move(u64_hashtable* table, u32 dest, u32 source)
+{
+    table->keys[dest] = table->keys[source];
+    table->distances[dest] = table->distances[source];
+    bcopy_memory(slot_value(table, dest), slot_value(table, source), table->element_size);
+}
+
+static void slot_swap(u64_hashtable* table, u32 a, u32 b)
+{
+    u64 key = table->keys[a];
+    table->keys[a] = table->keys[b];
+    table->keys[b] = key;
+    u8 distance = table->distances[a];
+    table->distances[a] = table->distances[b];
+    table->distances[b] = distance;
+
+    u8* value_a = slot_value(table, a);
+    u8* value_b = slot_value(table, b);
+    u32 i = 0;
+    for (; i + sizeof(u64) <= table->element_size; i += sizeof(u64))
+    {
+        u64 temp;
+        bcopy_memory(&temp, value_a + i, sizeof(u64));
+        bcopy_memory(value_a + i, value_b + i, sizeof(u64));
+        bcopy_memory(value_b + i, &temp, sizeof(u64));
+    }
+    for (; i < table->element_size; ++i)
+    {
+        u8 temp = value_a[i];
+        value_a[i] = value_b[i];
+        value_b[i] = temp;
+    }
+}
+
+/**
+ * Places a new entry, displacing any entry that sits closer to its home slot than the new one would
+ * (and carrying that one onwards instead). Returns false if an entry would end up too far from home
+ * to record, in which case the entry left in the spare slot still needs a place.
+ */
+static b8 entry_place(u64_hashtable* table, u64 key, const void* value)
+{
+    u32 mask = table->capacity - 1;
+    u32 spare = table->capacity;
+    u32 index = slot_home(table, key);
+
+    // Probe for either a free slot or an entry to displace. The new entry only goes through the spare slot in the latter case
+    u32 distance = 1;
+    for (; table->distances[index] >= distance; ++distance)
+    {
+        if (distance == U8_MAX)
+            break;
+        index = (index + 1) & mask;
+    }
+    if (distance < U8_MAX && !table->distances[index])
+    {
+        table->keys[index] = key;
+        table->distances[index] = (u8)distance;
+        bcopy_memory(slot_value(table, index), value, table->element_size);
+        return true;
+    }
+
+    table->keys[spare] = key;
+    table->distances[spare] = (u8)distance;
+    bcopy_memory(slot_value(table, spare), value, table->element_size);
+    for (;;)
+    {
+        u8 slot_distance = table->distances[index];
+        if (!slot_distance)
+        {
+            slot_move(table, index, spare);
+            return true;
+        }
+        if (slot_distance < table->distances[spare])
+            slot_swap(table, index, spare);
+        if (table->distances[spare] == U8_MAX)
+            return false;
+        table->distances[spare]++;
+        index = (index + 1) & mask;
+    }
+}
+
+// Moves everything over to a table with (at least) the given capacity, including the spare slot's entry if requested
+static b8 table_resize(u64_hashtable* table, u32 new_capacity, b8 carry_spare)
+{
+    u64_hashtable old = *table;
+    for (;;)
+    {
+        if (!table_allocate(table, new_capacity))
+        {
+            BERROR("u64_hashtable failed to allocate memory for %u slots", new_capacity);
+            *table = old;
+            return false;
+        }
+
+        b8 placed = true;
+        for (u32 i = 0; i <= old.capacity && placed; ++i)
+        {
+            if (i == old.capacity ? !carry_spare : !old.distances[i])
+                continue;
+            placed = entry_place(table, old.keys[i], slot_value(&old, i));
+        }
+        if (placed)
+            break;
+
+        // Pathological clustering. Try again with more room
+        table_free(table);
+        new_capacity *= 2;
+    }
+
+    table_free(&old);
+    return true;
+}
+
+static u32 slot_find(const u64_hashtable* table, u64 key)
+{
+    u32 mask = table->capacity - 1;
+    u32 index = slot_home(table, key);
+    // Entries are ordered by distance from home, so the key can't be any further along than this
+    for (u32 distance = 1; table->distances[index] >= distance; ++distance)
+    {
+        if (table->keys[index] == key)
+            return index;
+        index = (index + 1) & mask;
+    }
+    return INVALID_ID;
+}
+
+b8 u64_hashtable_create(u32 element_size, u32 initial_capacity, u64_hashtable* out_table)
+{
+    if (!out_table || !element_size)
+    {
+        BERROR("u64_hashtable_create requires a nonzero element_size and a pointer to hold the table");
+        return false;
+    }
+
+    bzero_memory(out_table, sizeof(u64_hashtable));
+    out_table->element_size = element_size;
+    if (!table_allocate(out_table, capacity_for(initial_capacity)))
+    {
+        BERROR("u64_hashtable_create failed to allocate memory");
+        return false;
+    }
+    return true;
+}
+
+void u64_hashtable_destroy(u64_hashtable* table)
+{
+    if (table)
+    {
+        table_free(table);
+        bzero_memory(table, sizeof(u64_hashtable));
+    }
+}
+
+b8 u64_hashtable_set(u64_hashtable* table, u64 key, const void* value)
+{
+    if (!table || !table->keys || !value)
+    {
+        BERROR("u64_hashtable_set requires a valid table and value");
+        return false;
+    }
+
+    u32 index = slot_find(table, key);
+    if (index != INVALID_ID)
+    {
+        bcopy_memory(slot_value(table, index), value, table->element_size);
+        return true;
+    }
+
+    if (load_exceeded(table->count + 1, table->capacity) && !table_resize(table, table->capacity * 2, false))
+        return false;
+
+    if (!entry_place(table, key, value) && !table_resize(table, table->capacity * 2, true))
+        return false;
+
+    table->count++;
+    return true;
+}
+
+b8 u64_hashtable_get(const u64_hashtable* table, u64 key, void* out_value)
+{
+    if (!table || !table->keys || !out_value)
+    {
+        BERROR("u64_hashtable_get requires a valid table and a pointer to hold the value");
+        return false;
+    }
+
+    u32 index = slot_find(table, key);
+    if (index == INVALID_ID)
+        return false;
+
+    bcopy_memory(out_value, slot_value(table, index), table->element_size);
+    return true;
+}
+
+void* u64_hashtable_get_ptr(const u64_hashtable* table, u64 key)
+{
+    if (!table || !table->keys)
+        return 0;
+
+    u32 index = slot_find(table, key);
+    return index == INVALID_ID ? 0 : slot_value(table, index);
+}
+
+b8 u64_hashtable_contains(const u64_hashtable* table, u64 key)
+{
+    return table && table->keys && slot_find(table, key) != INVALID_ID;
+}
+
+b8 u64_hashtable_remove(u64_hashtable* table, u64 key)
+{
+    if (!table || !table->keys)
+        return false;
+
+    u32 index = slot_find(table, key);
+    if (index == INVALID_ID)
+        return false;
+
+    // Shift the rest of the run back a slot, so no tombstone is needed
+    u32 mask = table->capacity - 1;
+    u32 next = (index + 1) & mask;
+    while (table->distances[next] > 1)
+    {
+        slot_move(table, index, next);
+        table->distances[index]--;
+        index = next;
+        next = (next + 1) & mask;
+    }
+    table->distances[index] = 0;
+    table->count--;
+    return true;
+}
+
+void u64_hashtable_clear(u64_hashtable* table)
+{
+    if (table && table->distances)
+    {
+        bzero_memory(table->distances, (u64)table->capacity + 1);
+        table->count = 0;
+    }
+}
+
+b8 u64_hashtable_reserve(u64_hashtable* table, u32 count)
+{
+    if (!table || !table->keys)
+        return false;
+
+    u32 capacity = capacity_for(count);
+    if (capacity <= table->capacity)
+        return true;
+    return table_resize(table, capacity, false);
+}
+
+b8 u64_hashtable_fits(const u64_hashtable* table, u32 count)
+{
+    return table && table->keys && !load_exceeded(count, table->capacity);
+}
+
+b8 u64_hashtable_iterate(const u64_hashtable* table, u32* iterator, u64* out_key, void** out_value)
+{
+    if (!table || !table->keys || !iterator)
+        return false;
+
+    while (*iterator < table->capacity)
+    {
+        u32 index = (*iterator)++;
+        if (table->distances[index])
+        {
+            if (out_key)
+                *out_key = table->keys[index];
+            if (out_value)
+                *out_value = slot_value(table, index);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief A hashtable keyed directly by u64 values (i.e. bnames or bstring_ids, which are
+ * already hashes, so no strings need to be hashed again). Uses open addressing with Robin Hood
+ * probing, so lookups stay short even when the table is fairly full. Grows automatically, and
+ * removal shifts later entries back instead of leaving tombstones. Values are copied in.
+ * Members of this structure should not be modified outside the functions associated with it.
+ */
+typedef struct u64_hashtable
+{
+    // Size of each value in bytes
+    u32 element_size;
+    // Number of entries currently stored
+    u32 count;
+    // Number of slots. Always a power of two
+    u32 capacity;
+    // Right shift which maps a mixed key onto a slot index
+    u32 shift;
+    // Probe distance of each slot's entry, plus one. 0 means the slot is empty
+    u8* distances;
+    // Key of each slot
+    u64* keys;
+    // Value of each slot, element_size bytes apiece
+    u8* values;
+} u64_hashtable;
+
+/**
+ * @brief Creates a hashtable.
+ *
+ * @param element_size The size of each value in bytes.
+ * @param initial_capacity The number of entries to make room for up front. May be 0.
+ * @param out_table A pointer to hold the created table.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 u64_hashtable_create(u32 element_size, u32 initial_capacity, u64_hashtable* out_table);
+
+/**
+ * @brief Destroys the given table and releases its memory.
+ *
+ * @param table A pointer to the table to be destroyed.
+ */
+BAPI void u64_hashtable_destroy(u64_hashtable* table);
+
+/**
+ * @brief Stores a copy of value under the given key, replacing any existing value. May grow the table.
+ *
+ * @param table A pointer to the table. Required.
+ * @param key The key to store the value under.
+ * @param value A pointer to element_size bytes to be copied in. Required.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 u64_hashtable_set(u64_hashtable* table, u64 key, const void* value);
+
+/**
+ * @brief Obtains a copy of the value stored under the given key.
+ *
+ * @param table A pointer to the table. Required.
+ * @param key The key to look up.
+ * @param out_value A pointer to hold a copy of the value. Required.
+ * @return True if the key was found; otherwise false.
+ */
+BAPI b8 u64_hashtable_get(const u64_hashtable* table, u64 key, void* out_value);
+
+/**
+ * @brief Obtains a pointer to the value stored under the given key, to be read or modified in place.
+ * NOTE: Only valid until the table is next changed by a set or remove.
+ *
+ * @param table A pointer to the table. Required.
+ * @param key The key to look up.
+ * @return A pointer to the stored value if the key was found; otherwise 0.
+ */
+BAPI void* u64_hashtable_get_ptr(const u64_hashtable* table, u64 key);
+
+/**
+ * @brief Indicates if the given key is present in the table.
+ *
+ * @param table A pointer to the table. Required.
+ * @param key The key to look up.
+ * @return True if the key was found; otherwise false.
+ */
+BAPI b8 u64_hashtable_contains(const u64_hashtable* table, u64 key);
+
+/**
+ * @brief Removes the given key and its value from the table.
+ *
+ * @param table A pointer to the table. Required.
+ * @param key The key to be removed.
+ * @return True if the key was found and removed; otherwise false.
+ */
+BAPI b8 u64_hashtable_remove(u64_hashtable* table, u64 key);
+
+/**
+ * @brief Removes all entries from the table, keeping its memory.
+ *
+ * @param table A pointer to the table. Required.
+ */
+BAPI void u64_hashtable_clear(u64_hashtable* table);
+
+/**
+ * @brief Grows the table if needed, so that the given number of entries fit without any further growth.
+ *
+ * @param table A pointer to the table. Required.
+ * @param count The number of entries to make room for.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 u64_hashtable_reserve(u64_hashtable* table, u32 count);
+
+/**
+ * @brief Checks whether the table holds the given number of entries without having to grow.
+ *
+ * @param table A pointer to the table.
+ * @param count The number of entries.
+ * @return True if the table exists and has room; otherwise false.
+ */
+BAPI b8 u64_hashtable_fits(const u64_hashtable* table, u32 count);
+
+/**
+ * @brief Steps through all entries in the table, in no particular order. Start with *iterator set to 0,
+ * and call until false is returned. The table must not be changed while iterating.
+ *
+ * @param table A pointer to the table. Required.
+ * @param iterator A pointer to the iteration state. Required.
+ * @param out_key A pointer to hold the entry's key. Optional.
+ * @param out_value A pointer to hold a pointer to the entry's value. Optional.
+ * @return True if an entry was returned; false once all entries have been visited.
+ */
+BAPI b8 u64_hashtable_iterate(const u64_hashtable* table, u32* iterator, u64* out_key, void** out_value);
@@ -136,6 +136,17 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 #define BNOINLINE
 #endif
 
+// Thread-local storage
+#if defined(__clang__) || defined(__gcc__)
+/** @brief Marks a static/global variable as having one instance per thread */
+#define BTHREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+/** @brief Marks a static/global variable as having one instance per thread */
+#define BTHREAD_LOCAL __declspec(thread)
+#else
+#error "Unsupported compiler - don't know how to define thread-local storage!"
+#endif
+
 // Deprecation
 #if defined(__clang__) || defined(__gcc__)
 /** @brief Mark something (i.e. a function) as deprecated */
@@ -1,23 +1,61 @@
 #include "identifiers/identifier.h"
 
-#include "containers/darray.h"
-#include "logger.h"
-#include "math/mtwister.h"
+#include "threads/batomic.h"
 
 #include <time.h>
 
-static b8 generator_created = false;
-static mtrand_state generator;
+// The number of ids each thread reserves from the shared counter at once. Threads only touch shared state once per block
+#define IDENTIFIER_BLOCK_SIZE 4096
 
-identifier identifier_create(void)
+// The next unreserved value of the shared counter
+static volatile u64 next_block_start = 0;
+// Chosen once per run and added to every counter value, so ids differ between runs. Never 0 once set
+static volatile u64 sequence_offset = 0;
+
+// The block of counter values the current thread is handing out ids from
+static BTHREAD_LOCAL u64 thread_next = 0;
+static BTHREAD_LOCAL u64 thread_end = 0;
+static BTHREAD_LOCAL u64 thread_offset = 0;
+
+// The splitmix64 finalizer. Every step can be undone, so different inputs always give different outputs
+static u64 identifier_mix(u64 value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+static u64 sequence_offset_get(void)
 {
-    if (!generator_created)
+    u64 offset = batomic_load_u64(&sequence_offset);
+    if (offset == 0)
     {
-        generator = mtrand_create(time(0));
-        generator_created = true;
+        // The first thread to get here decides. Others racing it just take its value
+        u64 local = 0;
+        u64 candidate = identifier_mix((u64)time(0) ^ (u64)&local) | 1;
+        u64 expected = 0;
+        if (!batomic_compare_exchange_u64(&sequence_offset, &expected, candidate))
+            candidate = expected;
+        offset = candidate;
     }
+    return offset;
+}
+
+identifier identifier_create(void)
+{
     identifier id;
-    id.uniqueid = mtrand_generate(&generator);
+    do
+    {
+        if (thread_next == thread_end)
+        {
+            thread_next = batomic_fetch_add_u64(&next_block_start, IDENTIFIER_BLOCK_SIZE);
+            thread_end = thread_next + IDENTIFIER_BLOCK_SIZE;
+            thread_offset = sequence_offset_get();
+        }
+        // Each counter value is handed out exactly once across all threads, and mixing keeps that true
+        // while spreading the bits, so ids are unique but still look random (i.e. for use as hash keys)
+        id.uniqueid = identifier_mix(thread_next++ + thread_offset);
+    } while (id.uniqueid == 0 || id.uniqueid == INVALID_ID_U64);
     return id;
 }
 
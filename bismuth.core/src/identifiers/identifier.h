@@ -8,6 +8,12 @@ typedef struct identifier
     u64 uniqueid;
 } identifier;
 
+/**
+ * @brief Creates a new identifier, unique within this run of the application. Ids are never
+ * 0 or INVALID_ID_U64, and their bits are well spread, so they make good hash keys. Safe to
+ * call from any thread, and lock-free: each thread reserves ids in blocks, so threads only
+ * touch shared state once every few thousand calls.
+ */
 BAPI identifier identifier_create(void);
 BAPI identifier identifier_from_u64(u64 uniqueid);
 BAPI b8 identifiers_equal(identifier a, identifier b);
@@ -20,24 +20,27 @@ void _log_output(log_level level, const char* message, ...)
 {
     const char* level_strs[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
 
-    // Format original message
+    // Build the message on the stack, so logging only allocates for unusually long messages
+    char stack_buffer[1024];
+    bstring out_message;
+    bstring_create_from_buffer(stack_buffer, sizeof(stack_buffer), &out_message);
+
+    // Add level and newline around message
+    bstring_append_str(&out_message, level_strs[level]);
     __builtin_va_list arg_ptr;
     va_start(arg_ptr, message);
-    char* formatted = string_format_v(message, arg_ptr);
+    bstring_append_format_v(&out_message, message, arg_ptr);
     va_end(arg_ptr);
-
-    // Add level and newline around message
-    char* out_message = string_format("%s%s\n", level_strs[level], formatted);
-    string_free(formatted);
+    bstring_append_char(&out_message, '\n');
 
     // If the console hook is defined, make sure to forward messages to it, and it will pass along to consumers.
     // Otherwise the platform layer will be used directly
     if (console_hook)
-        console_hook(level, out_message);
+        console_hook(level, out_message.data);
     else
-        platform_console_write(0, level, out_message);
+        platform_console_write(0, level, out_message.data);
 
-    string_free(out_message);
+    bstring_destroy(&out_message);
 
     // Trigger "debug break" for fatal errors
     if (level == LOG_LEVEL_FATAL)
@@ -8,6 +8,7 @@
 #include "math/math_types.h"
 #include "memory/bmemory.h"
 #include "strings/bname.h"
+#include "threads/bparallel.h"
 
 void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices)
 {
@@ -28,6 +29,36 @@ void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 index_
     }
 }
 
+// Calculates the tangent of a single triangle, with handedness encoded into w
+static vec4 triangle_tangent(const vertex_3d* vertices, u32 i0, u32 i1, u32 i2)
+{
+    vec3 edge1 = vec3_sub(vertices[i1].position, vertices[i0].position);
+    vec3 edge2 = vec3_sub(vertices[i2].position, vertices[i0].position);
+
+    f32 deltaU1 = vertices[i1].texcoord.x - vertices[i0].texcoord.x;
+    f32 deltaV1 = vertices[i1].texcoord.y - vertices[i0].texcoord.y;
+
+    f32 deltaU2 = vertices[i2].texcoord.x - vertices[i0].texcoord.x;
+    f32 deltaV2 = vertices[i2].texcoord.y - vertices[i0].texcoord.y;
+
+    f32 dividend = (deltaU1 * deltaV2 - deltaU2 * deltaV1);
+    f32 fc = 1.0f / dividend;
+
+    vec3 tangent = (vec3){(fc * (deltaV2 * edge1.x - deltaV1 * edge2.x)),
+                          (fc * (deltaV2 * edge1.y - deltaV1 * edge2.y)),
+                          (fc * (deltaV2 * edge1.z - deltaV1 * edge2.z))};
+
+    tangent = vec3_normalized(tangent);
+
+    f32 sx = deltaU1, sy = deltaU2;
+    f32 tx = deltaV1, ty = deltaV2;
+    f32 handedness = ((tx * sy - ty * sx) < 0.0f) ? -1.0f : 1.0f;
+
+    vec3 t4 = vec3_mul_scalar(tangent, handedness);
+    // Encode handedness into w
+    return vec4_from_vec3(t4, handedness);
+}
+
 void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices)
 {
     for (u32 i = 0; i < index_count; i += 3)
@@ -36,34 +67,61 @@ void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index
         u32 i1 = indices[i + 1];
         u32 i2 = indices[i + 2];
 
-        vec3 edge1 = vec3_sub(vertices[i1].position, vertices[i0].position);
-        vec3 edge2 = vec3_sub(vertices[i2].position, vertices[i0].position);
+        vec4 tangent = triangle_tangent(vertices, i0, i1, i2);
+        vertices[i0].tangent = tangent;
+        vertices[i1].tangent = tangent;
+        vertices[i2].tangent = tangent;
+    }
+}
 
-        f32 deltaU1 = vertices[i1].texcoord.x - vertices[i0].texcoord.x;
-        f32 deltaV1 = vertices[i1].texcoord.y - vertices[i0].texcoord.y;
+// Triangles handed to each thread at a time when generating tangents in parallel
+#define GEOMETRY_TANGENT_GRAIN 2048
 
-        f32 deltaU2 = vertices[i2].texcoord.x - vertices[i0].texcoord.x;
-        f32 deltaV2 = vertices[i2].texcoord.y - vertices[i0].texcoord.y;
+typedef struct tangent_range_context
+{
+    const vertex_3d* vertices;
+    const u32* indices;
+    vec4* triangle_tangents;
+} tangent_range_context;
 
-        f32 dividend = (deltaU1 * deltaV2 - deltaU2 * deltaV1);
-        f32 fc = 1.0f / dividend;
+static void tangent_range(u32 begin, u32 end, void* user)
+{
+    tangent_range_context* context = user;
+    for (u32 t = begin; t < end; ++t)
+    {
+        const u32* tri = &context->indices[t * 3];
+        context->triangle_tangents[t] = triangle_tangent(context->vertices, tri[0], tri[1], tri[2]);
+    }
+}
 
-        vec3 tangent = (vec3){(fc * (deltaV2 * edge1.x - deltaV1 * edge2.x)),
-                              (fc * (deltaV2 * edge1.y - deltaV1 * edge2.y)),
-                              (fc * (deltaV2 * edge1.z - deltaV1 * edge2.z))};
+void geometry_generate_tangents_parallel(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices)
+{
+    u32 triangle_count = index_count / 3;
+    if (triangle_count <= GEOMETRY_TANGENT_GRAIN || !bparallel_for_available())
+    {
+        geometry_generate_tangents(vertex_count, vertices, index_count, indices);
+        return;
+    }
 
-        tangent = vec3_normalized(tangent);
+    // Vertices are shared between triangles, so triangles can't write them directly without racing.
+    // Calculate per triangle in parallel instead, then scatter in triangle order so the last
+    // triangle touching a vertex wins, exactly as in the serial version
+    tangent_range_context context;
+    context.vertices = vertices;
+    context.indices = indices;
+    context.triangle_tangents = ballocate_uninitialized(sizeof(vec4) * triangle_count, MEMORY_TAG_ARRAY);
 
-        f32 sx = deltaU1, sy = deltaU2;
-        f32 tx = deltaV1, ty = deltaV2;
-        f32 handedness = ((tx * sy - ty * sx) < 0.0f) ? -1.0f : 1.0f;
+    bparallel_for(triangle_count, GEOMETRY_TANGENT_GRAIN, tangent_range, &context);
 
-        vec3 t4 = vec3_mul_scalar(tangent, handedness);
-        // Encode handedness into w
-        vertices[i0].tangent = vec4_from_vec3(t4, handedness);
-        vertices[i1].tangent = vec4_from_vec3(t4, handedness);
-        vertices[i2].tangent = vec4_from_vec3(t4, handedness);
+    for (u32 t = 0; t < triangle_count; ++t)
+    {
+        vec4 tangent = context.triangle_tangents[t];
+        vertices[indices[t * 3 + 0]].tangent = tangent;
+        vertices[indices[t * 3 + 1]].tangent = tangent;
+        vertices[indices[t * 3 + 2]].tangent = tangent;
     }
+
+    bfree(context.triangle_tangents, sizeof(vec4) * triangle_count, MEMORY_TAG_ARRAY);
 }
 
 b8 vertex3d_equal(vertex_3d vert_0, vertex_3d vert_1)
@@ -97,6 +97,17 @@ BAPI void geometry_generate_normals(u32 vertex_count, vertex_3d* vertices, u32 i
  */
 BAPI void geometry_generate_tangents(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
 
+/**
+ * @brief Same as geometry_generate_tangents, but spreads the work across threads via bparallel_for.
+ * Gives identical results. Only worth it for large meshes; small ones just run serially
+ *
+ * @param vertex_count The number of vertices.
+ * @param vertices An array of vertices.
+ * @param index_count The number of indices.
+ * @param indices An array of vertices.
+ */
+BAPI void geometry_generate_tangents_parallel(u32 vertex_count, vertex_3d* vertices, u32 index_count, u32* indices);
+
 /**
  * @brief De-duplicates vertices, leaving only unique ones. Leaves the original
  * vertices array intact. Allocates a new array in out_vertices. Modifies
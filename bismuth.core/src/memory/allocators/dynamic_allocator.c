@@ -23,6 +23,11 @@ typedef struct alloc_header
 #define BSIZE_STORAGE sizeof(u32)
 
 b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator)
+{
+    return dynamic_allocator_create_mode(total_size, FREELIST_MODE_FIRST_FIT, memory_requirement, memory, out_allocator);
+}
+
+b8 dynamic_allocator_create_mode(u64 total_size, freelist_mode mode, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator)
 {
     if (total_size < 1)
     {
@@ -36,7 +41,7 @@ b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memor
     }
     u64 freelist_requirement = 0;
     // Grab memory requirement for the free list first
-    freelist_create(total_size, &freelist_requirement, 0, 0);
+    freelist_create_mode(total_size, mode, &freelist_requirement, 0, 0);
 
     *memory_requirement = freelist_requirement + sizeof(dynamic_allocator_state) + total_size;
 
@@ -55,7 +60,7 @@ b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memor
     state->memory_block = (void*)(state->freelist_block + freelist_requirement);
 
     // Create freelist
-    freelist_create(total_size, &freelist_requirement, state->freelist_block, &state->list);
+    freelist_create_mode(total_size, mode, &freelist_requirement, state->freelist_block, &state->list);
 
     bzero_memory(state->memory_block, total_size);
     return true;
@@ -162,6 +167,52 @@ b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block)
     return true;
 }
 
+b8 dynamic_allocator_resize_in_place(dynamic_allocator* allocator, void* block, u64 new_size)
+{
+    if (!allocator || !block || !new_size)
+    {
+        BERROR("dynamic_allocator_resize_in_place requires a valid allocator, block and size");
+        return false;
+    }
+
+    dynamic_allocator_state* state = allocator->memory;
+    if (block < state->memory_block || block >= state->memory_block + state->total_size)
+        return false;
+
+    u32* block_size = (u32*)((u64)block - BSIZE_STORAGE);
+    alloc_header* header = (alloc_header*)((u64)block + *block_size);
+    u64 old_size = *block_size;
+    if (new_size == old_size)
+        return true;
+
+    u64 overhead = header->alignment + sizeof(alloc_header) + BSIZE_STORAGE;
+    u64 old_required = overhead + old_size;
+    u64 new_required = overhead + new_size;
+    if (new_required >= 4294967295U)
+        return false;
+    u64 offset = (u64)header->start - (u64)state->memory_block;
+
+    if (new_size > old_size)
+    {
+        // Can only grow if the range directly after this one is free and big enough
+        if (!freelist_allocate_block_at(&state->list, new_required - old_required, offset + old_required))
+            return false;
+    }
+    else
+    {
+        // Give the tail back
+        if (!freelist_free_block(&state->list, old_required - new_required, offset + new_required))
+            return false;
+    }
+
+    // Move the header to the new end of the user block
+    alloc_header moved = *header;
+    *block_size = (u32)new_size;
+    header = (alloc_header*)((u64)block + new_size);
+    *header = moved;
+    return true;
+}
+
 b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* block, u64* out_size, u16* out_alignment)
 {
     dynamic_allocator_state* state = allocator->memory;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "containers/freelist.h"
 
 typedef struct dynamic_allocator
 {
@@ -8,6 +9,8 @@ typedef struct dynamic_allocator
 } dynamic_allocator;
 
 BAPI b8 dynamic_allocator_create(u64 total_size, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
+// Same as dynamic_allocator_create, but with control over the strategy used to track free space
+BAPI b8 dynamic_allocator_create_mode(u64 total_size, freelist_mode mode, u64* memory_requirement, void* memory, dynamic_allocator* out_allocator);
 BAPI b8 dynamic_allocator_destroy(dynamic_allocator* allocator);
 
 BAPI void* dynamic_allocator_allocate(dynamic_allocator* allocator, u64 size);
@@ -16,6 +19,10 @@ BAPI void* dynamic_allocator_allocate_aligned(dynamic_allocator* allocator, u64
 BAPI b8 dynamic_allocator_free(dynamic_allocator* allocator, void* block, u64 size);
 BAPI b8 dynamic_allocator_free_aligned(dynamic_allocator* allocator, void* block);
 
+// Attempts to grow or shrink the given block without moving it. Growing only succeeds if the space
+// directly after the block is free. Contents beyond the old size are undefined
+BAPI b8 dynamic_allocator_resize_in_place(dynamic_allocator* allocator, void* block, u64 new_size);
+
 BAPI b8 dynamic_allocator_get_size_alignment(dynamic_allocator* allocator, void* block, u64* out_size, u16* out_alignment);
 
 BAPI u64 dynamic_allocator_free_space(dynamic_allocator* allocator);
@@ -0,0 +1,349 @@
+#include "memory/allocators/small_allocator.h"
+
+#include "debug/bassert.h"
+#include "logger.h"
+#include "memory/bmemory.h"
+#include "threads/batomic.h"
+#include "threads/bspinlock.h"
+
+// Marks a page which has not yet been assigned a size class
+#define PAGE_CLASS_UNASSIGNED 0xFF
+
+// Size of a cache line, used to keep the per-class shared state from false sharing
+#define CACHE_LINE_SIZE 64
+
+static const u32 class_sizes[SMALL_ALLOCATOR_CLASS_COUNT] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+    1280, 1536, 1792, 2048};
+
+STATIC_ASSERT(SMALL_ALLOCATOR_MAX_SIZE == 2048, "Small allocator class table does not match SMALL_ALLOCATOR_MAX_SIZE");
+
+/**
+ * @brief Free blocks are linked through their first bytes. The head block of
+ * a full batch additionally links to the next full batch, which allows whole
+ * batches to be moved in and out of the shared pool in O(1).
+ */
+typedef struct free_block
+{
+    struct free_block* next;
+    struct free_block* next_batch;
+} free_block;
+
+// Shared state for a single size class
+typedef struct size_class_state
+{
+    bspinlock lock;
+    // Number of blocks moved between a cache and the shared pool at once
+    u32 batch_size;
+    // Stack of full batches, each exactly batch_size blocks long
+    free_block* batches;
+    // Loose blocks that do not form a full batch
+    free_block* loose;
+    u32 loose_count;
+    u8 padding[CACHE_LINE_SIZE - sizeof(bspinlock) - sizeof(u32) * 2 - sizeof(free_block*) * 2];
+} size_class_state;
+
+STATIC_ASSERT(sizeof(size_class_state) == CACHE_LINE_SIZE, "size_class_state should occupy exactly one cache line");
+
+typedef struct small_allocator_state
+{
+    size_class_state classes[SMALL_ALLOCATOR_CLASS_COUNT];
+    // Maps (size + 15) / 16 to a size class index
+    u8 class_lookup[(SMALL_ALLOCATOR_MAX_SIZE / SMALL_ALLOCATOR_ALIGNMENT) + 1];
+    u32 page_count;
+    // Index of the next never-used page. Bumped atomically
+    volatile u32 next_page;
+    // One entry per page, holding the size class the page was carved into
+    u8* page_classes;
+    u8* region;
+} small_allocator_state;
+
+static u32 size_to_class(small_allocator_state* state, u64 size)
+{
+    return state->class_lookup[(size + (SMALL_ALLOCATOR_ALIGNMENT - 1)) / SMALL_ALLOCATOR_ALIGNMENT];
+}
+
+b8 small_allocator_create(u64 total_size, u64* memory_requirement, void* memory, small_allocator* out_allocator)
+{
+    if (!memory_requirement)
+    {
+        BERROR("small_allocator_create requires memory_requirement to exist. Create failed");
+        return false;
+    }
+
+    u64 page_count = total_size / SMALL_ALLOCATOR_PAGE_SIZE;
+    if (page_count < 1 || page_count >= U32_MAX)
+    {
+        BERROR("small_allocator_create requires a total_size of at least %llu bytes and less than 4G pages. Create failed", SMALL_ALLOCATOR_PAGE_SIZE);
+        return false;
+    }
+
+    // Memory layout:
+    // state
+    // page class array
+    // slab region (aligned to a cache line)
+    u64 header_size = get_aligned(sizeof(small_allocator_state) + page_count, CACHE_LINE_SIZE);
+    *memory_requirement = header_size + (page_count * SMALL_ALLOCATOR_PAGE_SIZE) + CACHE_LINE_SIZE;
+
+    // If only obtaining requirement, boot out
+    if (!memory)
+        return true;
+
+    out_allocator->memory = memory;
+    small_allocator_state* state = memory;
+    bzero_memory(state, sizeof(small_allocator_state));
+    state->page_count = (u32)page_count;
+    state->next_page = 0;
+    state->page_classes = (u8*)memory + sizeof(small_allocator_state);
+    bset_memory(state->page_classes, PAGE_CLASS_UNASSIGNED, page_count);
+    state->region = (u8*)get_aligned((u64)memory + header_size, CACHE_LINE_SIZE);
+
+    for (u32 i = 0; i < SMALL_ALLOCATOR_CLASS_COUNT; ++i)
+    {
+        size_class_state* c = &state->classes[i];
+        bspinlock_create(&c->lock);
+        u32 batch = (u32)((SMALL_ALLOCATOR_PAGE_SIZE / 2) / class_sizes[i]);
+        c->batch_size = BCLAMP(batch, 8, 128);
+    }
+
+    // Build the size lookup
+    u32 class_index = 0;
+    for (u32 i = 0; i <= SMALL_ALLOCATOR_MAX_SIZE / SMALL_ALLOCATOR_ALIGNMENT; ++i)
+    {
+        while (class_sizes[class_index] < i * SMALL_ALLOCATOR_ALIGNMENT)
+            class_index++;
+        state->class_lookup[i] = (u8)class_index;
+    }
+
+    return true;
+}
+
+void small_allocator_destroy(small_allocator* allocator)
+{
+    if (allocator && allocator->memory)
+    {
+        small_allocator_state* state = allocator->memory;
+        state->page_count = 0;
+        state->region = 0;
+        allocator->memory = 0;
+    }
+}
+
+b8 small_allocator_accepts(u64 size, u16 alignment)
+{
+    return size && size <= SMALL_ALLOCATOR_MAX_SIZE && alignment <= SMALL_ALLOCATOR_ALIGNMENT;
+}
+
+// Detaches count blocks from the head of the bin and returns them as a chain
+static free_block* bin_detach(small_allocator_bin* bin, u32 count)
+{
+    free_block* head = bin->head;
+    free_block* tail = head;
+    for (u32 i = 1; i < count; ++i)
+        tail = tail->next;
+    bin->head = tail->next;
+    bin->count -= count;
+    tail->next = 0;
+    return head;
+}
+
+// Carves a fresh page for the given class. The first batch goes to the bin, the remainder to the shared pool
+static b8 carve_page(small_allocator_state* state, u32 class_index, small_allocator_bin* bin)
+{
+    u32 page = batomic_fetch_add_u32(&state->next_page, 1);
+    if (page >= state->page_count)
+    {
+        // Keep the counter pinned so it can't wrap around after many failed attempts
+        batomic_store_u32(&state->next_page, state->page_count);
+        return false;
+    }
+
+    size_class_state* c = &state->classes[class_index];
+    state->page_classes[page] = (u8)class_index;
+
+    u32 block_size = class_sizes[class_index];
+    u32 block_count = (u32)(SMALL_ALLOCATOR_PAGE_SIZE / block_size);
+    u8* base = state->region + ((u64)page * SMALL_ALLOCATOR_PAGE_SIZE);
+
+    // Link all blocks in address order
+    for (u32 i = 0; i < block_count - 1; ++i)
+        ((free_block*)(base + (u64)i * block_size))->next = (free_block*)(base + (u64)(i + 1) * block_size);
+    ((free_block*)(base + (u64)(block_count - 1) * block_size))->next = 0;
+
+    bin->head = (free_block*)base;
+    bin->count = block_count;
+    if (block_count <= c->batch_size)
+        return true;
+
+    // Keep one batch, hand the rest over in batch-sized chains
+    small_allocator_bin rest = *bin;
+    *bin = (small_allocator_bin){0};
+    free_block* own = bin_detach(&rest, c->batch_size);
+    bin->head = own;
+    bin->count = c->batch_size;
+
+    bspinlock_lock(&c->lock);
+    while (rest.count >= c->batch_size)
+    {
+        free_block* chain = bin_detach(&rest, c->batch_size);
+        chain->next_batch = c->batches;
+        c->batches = chain;
+    }
+    if (rest.count)
+    {
+        // Splice the leftover onto the loose list
+        free_block* tail = rest.head;
+        while (tail->next)
+            tail = tail->next;
+        tail->next = c->loose;
+        c->loose = rest.head;
+        c->loose_count += rest.count;
+    }
+    bspinlock_unlock(&c->lock);
+    return true;
+}
+
+static b8 refill(small_allocator_state* state, u32 class_index, small_allocator_bin* bin)
+{
+    size_class_state* c = &state->classes[class_index];
+
+    bspinlock_lock(&c->lock);
+    if (c->batches)
+    {
+        free_block* chain = c->batches;
+        c->batches = chain->next_batch;
+        bspinlock_unlock(&c->lock);
+        bin->head = chain;
+        bin->count = c->batch_size;
+        return true;
+    }
+    if (c->loose)
+    {
+        small_allocator_bin loose = {c->loose, c->loose_count};
+        u32 take = BMIN(loose.count, c->batch_size);
+        free_block* chain = bin_detach(&loose, take);
+        c->loose = loose.head;
+        c->loose_count = loose.count;
+        bspinlock_unlock(&c->lock);
+        bin->head = chain;
+        bin->count = take;
+        return true;
+    }
+    bspinlock_unlock(&c->lock);
+
+    return carve_page(state, class_index, bin);
+}
+
+void* small_allocator_allocate(small_allocator* allocator, small_allocator_cache* cache, u64 size, u64* out_block_size)
+{
+    small_allocator_state* state = allocator->memory;
+    BASSERT_DEBUG(small_allocator_accepts(size, 1));
+
+    u32 class_index = size_to_class(state, size);
+    small_allocator_bin* bin = &cache->bins[class_index];
+    if (!bin->head && !refill(state, class_index, bin))
+        return 0;
+
+    free_block* block = bin->head;
+    bin->head = block->next;
+    bin->count--;
+
+    if (out_block_size)
+        *out_block_size = class_sizes[class_index];
+    return block;
+}
+
+b8 small_allocator_free(small_allocator* allocator, small_allocator_cache* cache, void* block, u64* out_block_size)
+{
+    small_allocator_state* state = allocator->memory;
+    if (!small_allocator_owns(allocator, block))
+        return false;
+
+    u32 page = (u32)(((u8*)block - state->region) / SMALL_ALLOCATOR_PAGE_SIZE);
+    u32 class_index = state->page_classes[page];
+    BASSERT_MSG(class_index != PAGE_CLASS_UNASSIGNED, "small_allocator_free called on a block from an unused page. Memory corruption likely");
+
+    small_allocator_bin* bin = &cache->bins[class_index];
+    free_block* b = block;
+    b->next = bin->head;
+    bin->head = b;
+    bin->count++;
+
+    // Hand a batch back to the shared pool if this cache is hoarding blocks
+    size_class_state* c = &state->classes[class_index];
+    if (bin->count >= c->batch_size * 2)
+    {
+        free_block* chain = bin_detach(bin, c->batch_size);
+        bspinlock_lock(&c->lock);
+        chain->next_batch = c->batches;
+        c->batches = chain;
+        bspinlock_unlock(&c->lock);
+    }
+
+    if (out_block_size)
+        *out_block_size = class_sizes[class_index];
+    return true;
+}
+
+void small_allocator_cache_flush(small_allocator* allocator, small_allocator_cache* cache)
+{
+    if (!allocator || !allocator->memory || !cache)
+        return;
+
+    small_allocator_state* state = allocator->memory;
+    for (u32 i = 0; i < SMALL_ALLOCATOR_CLASS_COUNT; ++i)
+    {
+        small_allocator_bin* bin = &cache->bins[i];
+        if (!bin->head)
+            continue;
+
+        free_block* tail = bin->head;
+        while (tail->next)
+            tail = tail->next;
+
+        size_class_state* c = &state->classes[i];
+        bspinlock_lock(&c->lock);
+        tail->next = c->loose;
+        c->loose = bin->head;
+        c->loose_count += bin->count;
+        bspinlock_unlock(&c->lock);
+
+        bin->head = 0;
+        bin->count = 0;
+    }
+}
+
+b8 small_allocator_owns(small_allocator* allocator, void* block)
+{
+    if (!allocator || !allocator->memory)
+        return false;
+    small_allocator_state* state = allocator->memory;
+    u8* b = block;
+    return b >= state->region && b < state->region + ((u64)state->page_count * SMALL_ALLOCATOR_PAGE_SIZE);
+}
+
+u64 small_allocator_block_size(small_allocator* allocator, void* block)
+{
+    if (!small_allocator_owns(allocator, block))
+        return 0;
+    small_allocator_state* state = allocator->memory;
+    u32 page = (u32)(((u8*)block - state->region) / SMALL_ALLOCATOR_PAGE_SIZE);
+    u8 class_index = state->page_classes[page];
+    return class_index == PAGE_CLASS_UNASSIGNED ? 0 : class_sizes[class_index];
+}
+
+u64 small_allocator_total_space(small_allocator* allocator)
+{
+    small_allocator_state* state = allocator->memory;
+    return (u64)state->page_count * SMALL_ALLOCATOR_PAGE_SIZE;
+}
+
+u64 small_allocator_page_space(small_allocator* allocator)
+{
+    small_allocator_state* state = allocator->memory;
+    u32 used = batomic_load_relaxed_u32(&state->next_page);
+    return (u64)BMIN(used, state->page_count) * SMALL_ALLOCATOR_PAGE_SIZE;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief The largest allocation size in bytes that will be served by the small allocator.
+ * Anything larger should go to a general-purpose allocator.
+ */
+#define SMALL_ALLOCATOR_MAX_SIZE 2048
+
+/** @brief The alignment guaranteed for every block handed out by the small allocator */
+#define SMALL_ALLOCATOR_ALIGNMENT 16
+
+/** @brief The size of a single slab page. Each page is carved into blocks of one size class */
+#define SMALL_ALLOCATOR_PAGE_SIZE KIBIBYTES(64)
+
+/** @brief The number of segregated size classes */
+#define SMALL_ALLOCATOR_CLASS_COUNT 24
+
+/**
+ * @brief A per-class list of free blocks owned by a single cache.
+ */
+typedef struct small_allocator_bin
+{
+    // Singly-linked list of free blocks, linked through the first bytes of each block
+    void* head;
+    // Number of blocks in the list
+    u32 count;
+} small_allocator_bin;
+
+/**
+ * @brief A cache of free blocks for each size class. Intended to be owned by
+ * exactly one thread, which means no locking is required to allocate from or
+ * free into it. Blocks are moved between the cache and the shared allocator
+ * in batches, which is the only time a lock is taken.
+ */
+typedef struct small_allocator_cache
+{
+    small_allocator_bin bins[SMALL_ALLOCATOR_CLASS_COUNT];
+} small_allocator_cache;
+
+/**
+ * @brief A slab allocator with segregated size classes for small allocations.
+ * A contiguous region is split into fixed-size pages, each of which is carved
+ * into equally-sized blocks of a single class on first use. Pages are never
+ * handed back to the region, which keeps the owner lookup to a single range check.
+ */
+typedef struct small_allocator
+{
+    // Internal state of the allocator
+    void* memory;
+} small_allocator;
+
+/**
+ * @brief Creates a new small allocator or obtains the memory requirement for one. Call
+ * twice; once passing 0 to memory to obtain memory requirement, and a second
+ * time passing an allocated block to memory.
+ *
+ * @param total_size The total size in bytes of the slab region. Rounded down to a multiple of SMALL_ALLOCATOR_PAGE_SIZE.
+ * @param memory_requirement A pointer to hold memory requirement for the allocator, including the slab region.
+ * @param memory 0, or a pre-allocated block of memory for the allocator to use.
+ * @param out_allocator A pointer to hold the created allocator.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 small_allocator_create(u64 total_size, u64* memory_requirement, void* memory, small_allocator* out_allocator);
+
+/**
+ * @brief Destroys the provided allocator. Any outstanding blocks become invalid.
+ *
+ * @param allocator A pointer to the allocator to be destroyed.
+ */
+BAPI void small_allocator_destroy(small_allocator* allocator);
+
+/**
+ * @brief Indicates if an allocation of the given size and alignment can be served by a small allocator.
+ *
+ * @param size The size of the allocation in bytes.
+ * @param alignment The alignment of the allocation in bytes.
+ * @return True if the allocation qualifies; otherwise false.
+ */
+BAPI b8 small_allocator_accepts(u64 size, u16 alignment);
+
+/**
+ * @brief Allocates a block from the given cache, refilling the cache from the shared
+ * pool if required. The block is NOT zeroed.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param cache A pointer to the cache owned by the calling thread.
+ * @param size The size of the allocation. Must satisfy small_allocator_accepts().
+ * @param out_block_size A pointer to hold the actual size of the block handed out (the size class). Optional.
+ * @return A pointer to the block on success; 0 if the slab region is exhausted.
+ */
+BAPI void* small_allocator_allocate(small_allocator* allocator, small_allocator_cache* cache, u64 size, u64* out_block_size);
+
+/**
+ * @brief Returns a block to the given cache, handing a batch back to the shared pool if the cache has grown too large.
+ * The block may have been allocated by any thread.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param cache A pointer to the cache owned by the calling thread.
+ * @param block The block to be freed. Must be owned by this allocator.
+ * @param out_block_size A pointer to hold the size class of the freed block. Optional.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 small_allocator_free(small_allocator* allocator, small_allocator_cache* cache, void* block, u64* out_block_size);
+
+/**
+ * @brief Returns every block held by the given cache to the shared pool. Should be called
+ * before the owning thread exits so its blocks are not stranded.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param cache A pointer to the cache to be flushed.
+ */
+BAPI void small_allocator_cache_flush(small_allocator* allocator, small_allocator_cache* cache);
+
+/**
+ * @brief Indicates if the given block lives within the allocator's slab region.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block to check.
+ * @return True if owned by this allocator; otherwise false.
+ */
+BAPI b8 small_allocator_owns(small_allocator* allocator, void* block);
+
+/**
+ * @brief Obtains the size class (the usable size) of the given block.
+ *
+ * @param allocator A pointer to the allocator.
+ * @param block The block to check. Must be owned by this allocator.
+ * @return The usable size of the block in bytes, or 0 if not owned by this allocator.
+ */
+BAPI u64 small_allocator_block_size(small_allocator* allocator, void* block);
+
+/**
+ * @brief Obtains the total size in bytes of the slab region.
+ */
+BAPI u64 small_allocator_total_space(small_allocator* allocator);
+
+/**
+ * @brief Obtains the number of bytes of the slab region which have been carved into pages so far.
+ */
+BAPI u64 small_allocator_page_space(small_allocator* allocator);
@@ -1,11 +1,17 @@
+// Keeps the call-site tracking macros from wrapping the definitions below
+#define BMEMORY_IMPLEMENTATION
 #include "memory/bmemory.h"
 
 #include "debug/bassert.h"
 #include "logger.h"
 #include "strings/bstring.h"
+#include "threads/batomic.h"
 #include "threads/bmutex.h"
+#include "threads/bspinlock.h"
 #include "platform/platform.h"
 #include "memory/allocators/dynamic_allocator.h"
+#include "memory/allocators/small_allocator.h"
+#include "memory/frame_scratch.h"
 
 // TODO: Custom string lib
 #include <string.h>
@@ -25,66 +31,175 @@
 #endif
 #endif
 
-struct memory_stats
-{
-    u64 total_allocated;
-    u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
-    u64 new_tagged_allocations[MEMORY_TAG_MAX_TAGS];
-    u64 new_tagged_deallocations[MEMORY_TAG_MAX_TAGS];
-};
-
 static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] =
 {
-    "UNKNOWN     ",
-    "ARRAY       ",
+    "UNKNOWN",
+    "ARRAY",
     "LINEAR_ALLOC",
-    "DARRAY      ",
-    "DICT        ",
-    "RING_QUEUE  ",
-    "BST         ",
-    "STRING      ",
-    "ENGINE      ",
-    "JOB         ",
-    "TEXTURE     ",
-    "MAT_INST    ",
-    "RENDERER    ",
-    "GAME        ",
-    "TRANSFORM   ",
-    "ENTITY      ",
-    "ENTITY_NODE ",
-    "SCENE       ",
-    "RESOURCE    ",
-    "VULKAN      ",
-    "VULKAN_EXT  ",
-    "DIRECT3D    ",
-    "OPENGL      ",
-    "GPU_LOCAL   ",
-    "BITMAP_FONT ",
-    "SYSTEM_FONT ",
-    "KEYMAP      ",
-    "HASHTABLE   ",
-    "UI          ",
-    "AUDIO       ",
-    "REGISTRY    ",
-    "PLUGIN      ",
-    "PLATFORM    ",
-    "SERIALIZER  ",
-    "ASSET       "
+    "DARRAY",
+    "DICT",
+    "RING_QUEUE",
+    "BST",
+    "STRING",
+    "ENGINE",
+    "JOB",
+    "TEXTURE",
+    "MAT_INST",
+    "RENDERER",
+    "GAME",
+    "TRANSFORM",
+    "ENTITY",
+    "ENTITY_NODE",
+    "SCENE",
+    "RESOURCE",
+    "VULKAN",
+    "VULKAN_EXT",
+    "DIRECT3D",
+    "OPENGL",
+    "GPU_LOCAL",
+    "BITMAP_FONT",
+    "SYSTEM_FONT",
+    "KEYMAP",
+    "HASHTABLE",
+    "UI",
+    "AUDIO",
+    "REGISTRY",
+    "PLUGIN",
+    "PLATFORM",
+    "SERIALIZER",
+    "ASSET"
 };
 
+// The largest allocation counted by the first size histogram bucket
+#define MEMORY_SIZE_HISTOGRAM_MIN 16
+
+/** @brief A thread's allocation counters for a single tag */
+typedef struct memory_tag_counters
+{
+    // Running delta of live bytes. See the note on memory_thread_record
+    u64 allocated;
+    u64 allocation_count;
+    u64 allocated_bytes;
+    u64 free_count;
+    u64 freed_bytes;
+    u64 size_histogram[MEMORY_SIZE_HISTOGRAM_BUCKETS];
+} memory_tag_counters;
+
+#if BMEMORY_TRACK_CALL_SITES
+// The maximum number of distinct call sites. Allocations from any further sites are counted as unknown
+#define CALL_SITE_CAPACITY 8192
+// The initial number of live blocks which can be tracked. Grows as needed
+#define CALL_SITE_BLOCK_INITIAL_CAPACITY 65536
+// The number of call sites listed in each section of the report at shutdown
+#define CALL_SITE_SHUTDOWN_REPORT_COUNT 20
+
+/** @brief A live block, and the call site it was allocated from */
+typedef struct call_site_block
+{
+    void* block;
+    u64 size;
+    u32 site;
+} call_site_block;
+
+/**
+ * @brief Allocation call-site tracking. Both tables are open-addressed with linear probing, and kept
+ * in platform memory so tracking never recurses into the allocator. Guarded by a single lock, which
+ * is fine for a diagnostic build.
+ */
+typedef struct call_site_tracking
+{
+    bspinlock lock;
+    // Indexed by hash of file/line. The extra entry at the end is the unknown site
+    memory_call_site_stats* sites;
+    u32 site_count;
+    call_site_block* blocks;
+    u64 block_capacity;
+    u64 block_count;
+    f64 start_time;
+} call_site_tracking;
+#endif
+
+// The maximum number of threads which can own a small allocation cache at once
+#define MEMORY_MAX_THREAD_RECORDS 64
+
+/**
+ * @brief Per-thread memory state. Only ever written by the owning thread (or under
+ * the overflow lock for the shared overflow record), and read when stats are gathered.
+ * Every allocation is counted here, so the allocation path never contends on stats.
+ * NOTE: allocated is a running delta. A block freed on a different thread than the one
+ * that allocated it drives that thread's counter "negative" (wrapping), but the sum
+ * across all records is always exact. All other counters are cumulative and never reset.
+ */
+typedef struct memory_thread_record
+{
+    small_allocator_cache cache;
+    memory_tag_counters tags[MEMORY_TAG_MAX_TAGS];
+    volatile u32 in_use;
+} memory_thread_record;
+
 typedef struct memory_system_state
 {
     memory_system_configuration config;
-    struct memory_stats stats;
-    u64 alloc_count;
     u64 allocator_memory_requirement;
     dynamic_allocator allocator;
     void* allocator_block;
     bmutex allocation_mutex;
+
+    // Front-end for small allocations
+    small_allocator small_allocator;
+    u64 small_allocator_memory_requirement;
+    void* small_allocator_block;
+    // Identifies this initialization of the memory system, so stale thread-local pointers can be detected
+    u32 generation;
+    memory_thread_record thread_records[MEMORY_MAX_THREAD_RECORDS];
+    // One past the highest record ever claimed. Records beyond this have never been used
+    volatile u32 thread_records_used;
+    // Used by threads that could not get a record of their own
+    memory_thread_record overflow_record;
+    bspinlock overflow_lock;
+
+    // Guards everything below. Only taken when stats are gathered, never when allocating
+    bspinlock stats_lock;
+    u64 frame_number;
+    // Cumulative per-tag counts at the last frame mark
+    u64 frame_start_allocation_counts[MEMORY_TAG_MAX_TAGS];
+    u64 frame_start_allocated_bytes[MEMORY_TAG_MAX_TAGS];
+    // Allocations made between the last two frame marks
+    u64 frame_allocation_counts[MEMORY_TAG_MAX_TAGS];
+    u64 frame_allocated_bytes[MEMORY_TAG_MAX_TAGS];
+    u64 peak_allocated[MEMORY_TAG_MAX_TAGS];
+    u64 peak_total_allocated;
+    // Cumulative per-tag byte counts at the time of the last usage report
+    u64 reported_allocated_bytes[MEMORY_TAG_MAX_TAGS];
+    u64 reported_freed_bytes[MEMORY_TAG_MAX_TAGS];
+
+#if BMEMORY_TRACK_CALL_SITES
+    call_site_tracking call_sites;
+#endif
 } memory_system_state;
 
 // Pointer to system state
 static memory_system_state* state_ptr;
+// Bumped each time the memory system is initialized
+static u32 memory_generation = 0;
+
+// The calling thread's record, valid only if thread_record_generation matches the state's generation
+static BTHREAD_LOCAL memory_thread_record* thread_record;
+static BTHREAD_LOCAL u32 thread_record_generation;
+
+static memory_thread_record* thread_record_get(void);
+static void* allocate(u64 size, u16 alignment, memory_tag tag, b8 zero);
+static void* small_allocate(u64 size, memory_tag tag);
+static b8 small_free(void* block, u64 size, memory_tag tag);
+static void memory_stats_record(memory_tag tag, u64 allocated, u64 freed);
+static void memory_counters_gather(memory_tag_counters* out_tags, b8 include_histograms);
+#if BMEMORY_TRACK_CALL_SITES
+static b8 call_site_tracking_initialize(call_site_tracking* tracking);
+static void call_site_tracking_shutdown(call_site_tracking* tracking);
+static void call_site_track_allocate(void* block, u64 size, memory_tag tag);
+static void call_site_track_resize(void* block, u64 new_size);
+static void call_site_track_free(void* block);
+#endif
 
 b8 memory_system_initialize(memory_system_configuration config)
 {
@@ -92,13 +207,22 @@ b8 memory_system_initialize(memory_system_configuration config)
     // Amount needed by the system state
     u64 state_memory_requirement = sizeof(memory_system_state);
 
-    // Figure out how much space dynamic allocator needs
+    // Figure out how much space dynamic allocator needs. Segregated-fit keeps allocation and
+    // free time independent of how fragmented the heap gets over a long session
     u64 alloc_requirement = 0;
-    dynamic_allocator_create(config.total_alloc_size, &alloc_requirement, 0, 0);
+    dynamic_allocator_create_mode(config.total_alloc_size, FREELIST_MODE_SEGREGATED_FIT, &alloc_requirement, 0, 0);
+
+    // Figure out how much space the small allocator needs
+    if (!config.small_alloc_size)
+        config.small_alloc_size = config.total_alloc_size / 16;
+    if (config.small_alloc_size < SMALL_ALLOCATOR_PAGE_SIZE)
+        config.small_alloc_size = SMALL_ALLOCATOR_PAGE_SIZE;
+    u64 small_alloc_requirement = 0;
+    small_allocator_create(config.small_alloc_size, &small_alloc_requirement, 0, 0);
 
     // Call platform allocator to get memory for the whole system, including state
     // TODO: memory alignment
-    void* block = platform_allocate(state_memory_requirement + alloc_requirement, true);
+    void* block = platform_allocate(state_memory_requirement + alloc_requirement + small_alloc_requirement, true);
     if (!block)
     {
         BFATAL("Memory system allocation failed and the system cannot continue");
@@ -107,15 +231,15 @@ b8 memory_system_initialize(memory_system_configuration config)
     
     // State is in the first part of massive block of memory
     state_ptr = (memory_system_state*)block;
+    platform_zero_memory(state_ptr, sizeof(memory_system_state));
     state_ptr->config = config;
-    state_ptr->alloc_count = 0;
     state_ptr->allocator_memory_requirement = alloc_requirement;
-    platform_zero_memory(&state_ptr->stats, sizeof(state_ptr->stats));
     // Allocator block is in the same block of memory, but after the state
     state_ptr->allocator_block = ((void*)block + state_memory_requirement);
 
-    if (!dynamic_allocator_create(
+    if (!dynamic_allocator_create_mode(
             config.total_alloc_size,
+            FREELIST_MODE_SEGREGATED_FIT,
             &state_ptr->allocator_memory_requirement,
             state_ptr->allocator_block,
             &state_ptr->allocator))
@@ -123,13 +247,38 @@ b8 memory_system_initialize(memory_system_configuration config)
         BFATAL("Memory system is unable to setup internal allocator. Application cannot continue");
         return false;
     }
+
+    // Small allocator block comes after the dynamic allocator block
+    state_ptr->small_allocator_memory_requirement = small_alloc_requirement;
+    state_ptr->small_allocator_block = ((u8*)state_ptr->allocator_block + alloc_requirement);
+    if (!small_allocator_create(
+            config.small_alloc_size,
+            &state_ptr->small_allocator_memory_requirement,
+            state_ptr->small_allocator_block,
+            &state_ptr->small_allocator))
+    {
+        BFATAL("Memory system is unable to setup small allocator. Application cannot continue");
+        return false;
+    }
 #else
     state_ptr = baligned_alloc(sizeof(memory_system_state), 16);
+    platform_zero_memory(state_ptr, sizeof(memory_system_state));
     state_ptr->config = config;
-    state_ptr->alloc_count = 0;
     state_ptr->allocator_memory_requirement = 0;
 #endif
 
+    bspinlock_create(&state_ptr->overflow_lock);
+    bspinlock_create(&state_ptr->stats_lock);
+    state_ptr->generation = ++memory_generation;
+
+#if BMEMORY_TRACK_CALL_SITES
+    if (!call_site_tracking_initialize(&state_ptr->call_sites))
+    {
+        BFATAL("Unable to set up allocation call-site tracking");
+        return false;
+    }
+#endif
+
     // Create allocation mutex
     if (!bmutex_create(&state_ptr->allocation_mutex))
     {
@@ -145,13 +294,20 @@ void memory_system_shutdown(void)
 {
     if (state_ptr)
     {
+#if BMEMORY_TRACK_CALL_SITES
+        // Anything still outstanding at this point is a leak
+        memory_call_sites_report(CALL_SITE_SHUTDOWN_REPORT_COUNT);
+        call_site_tracking_shutdown(&state_ptr->call_sites);
+#endif
+
         // Destroy allocation mutex
         bmutex_destroy(&state_ptr->allocation_mutex);
 
 #if B_USE_CUSTOM_MEMORY_ALLOCATOR
+        small_allocator_destroy(&state_ptr->small_allocator);
         dynamic_allocator_destroy(&state_ptr->allocator);
         // Free entire block
-        platform_free(state_ptr, state_ptr->allocator_memory_requirement + sizeof(memory_system_state));
+        platform_free(state_ptr, state_ptr->allocator_memory_requirement + state_ptr->small_allocator_memory_requirement + sizeof(memory_system_state));
 #else
         baligned_free(state_ptr);
 #endif
@@ -159,6 +315,22 @@ void memory_system_shutdown(void)
     state_ptr = 0;
 }
 
+void memory_system_thread_release(void)
+{
+    if (!state_ptr || thread_record_generation != state_ptr->generation || !thread_record)
+        return;
+
+#if B_USE_CUSTOM_MEMORY_ALLOCATOR
+    small_allocator_cache_flush(&state_ptr->small_allocator, &thread_record->cache);
+#endif
+
+    // NOTE: Stats are left in place so the totals across all records still add up
+    batomic_store_u32(&thread_record->in_use, 0);
+
+    thread_record = 0;
+    thread_record_generation = 0;
+}
+
 void* ballocate(u64 size, memory_tag tag)
 {
     return ballocate_aligned(size, 1, tag);
@@ -166,64 +338,22 @@ void* ballocate(u64 size, memory_tag tag)
 
 void* ballocate_aligned(u64 size, u16 alignment, memory_tag tag)
 {
-    BASSERT_MSG(size, "ballocate_aligned requires a nonzero size");
-    if (tag == MEMORY_TAG_UNKNOWN)
-        BWARN("ballocate_aligned called using MEMORY_TAG_UNKNOWN. Re-class this allocation");
-
-    // Either allocate from the system's allocator or the OS
-    void* block = 0;
-    if (state_ptr)
-    {
-        // Make sure multithreaded requests don't violate each other
-        if (!bmutex_lock(&state_ptr->allocation_mutex))
-        {
-            BFATAL("Error obtaining mutex lock during allocation");
-            return 0;
-        }
-
-        state_ptr->stats.total_allocated += size;
-        state_ptr->stats.tagged_allocations[tag] += size;
-        state_ptr->stats.new_tagged_allocations[tag] += size;
-        state_ptr->alloc_count++;
-
-#if B_USE_CUSTOM_MEMORY_ALLOCATOR
-        block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
-#else
-        block = baligned_alloc(size, alignment);
-#endif
-        bmutex_unlock(&state_ptr->allocation_mutex);
-    }
-    else
-    {
-        // If system is not up yet, warn about it but give memory for now
-        // BWARN("ballocate_aligned called before the memory system is initialized");
-        // TODO: Memory alignment
-        block = platform_allocate(size, false);
-    }
+    return allocate(size, alignment, tag, true);
+}
 
-    if (block)
-    {
-        platform_zero_memory(block, size);
-        return block;
-    }
+void* ballocate_uninitialized(u64 size, memory_tag tag)
+{
+    return allocate(size, 1, tag, false);
+}
 
-    BFATAL("ballocate_aligned failed to allocate");
-    return 0;
+void* ballocate_aligned_uninitialized(u64 size, u16 alignment, memory_tag tag)
+{
+    return allocate(size, alignment, tag, false);
 }
 
 void ballocate_report(u64 size, memory_tag tag)
 {
-    // Make sure multithreaded requests don't trample each other
-    if (!bmutex_lock(&state_ptr->allocation_mutex))
-    {
-        BFATAL("Error obtaining mutex lock during allocation reporting");
-        return;
-    }
-    state_ptr->stats.total_allocated += size;
-    state_ptr->stats.tagged_allocations[tag] += size;
-    state_ptr->stats.new_tagged_allocations[tag] += size;
-    state_ptr->alloc_count++;
-    bmutex_unlock(&state_ptr->allocation_mutex);
+    memory_stats_record(tag, size, 0);
 }
 
 void* breallocate(void* block, u64 old_size, u64 new_size, memory_tag tag)
@@ -233,10 +363,63 @@ void* breallocate(void* block, u64 old_size, u64 new_size, memory_tag tag)
 
 void* breallocate_aligned(void* block, u64 old_size, u64 new_size, u16 alignment, memory_tag tag)
 {
-    void* new_block = ballocate_aligned(new_size, alignment, tag);
-    if (block && new_block)
+    if (!block)
+        return ballocate_aligned(new_size, alignment, tag);
+
+    if (state_ptr)
+    {
+#if B_USE_CUSTOM_MEMORY_ALLOCATOR
+        if (small_allocator_owns(&state_ptr->small_allocator, block))
+        {
+            // Small blocks are tracked by their size class, so the block can be kept as-is while it still fits
+            if (small_allocator_accepts(new_size, alignment) && new_size <= small_allocator_block_size(&state_ptr->small_allocator, block))
+            {
+                if (new_size > old_size)
+                    platform_zero_memory((u8*)block + old_size, new_size - old_size);
+#if BMEMORY_TRACK_CALL_SITES
+                call_site_track_resize(block, new_size);
+#endif
+                return block;
+            }
+        }
+        else
+        {
+            if (!bmutex_lock(&state_ptr->allocation_mutex))
+            {
+                BFATAL("Error obtaining mutex lock during reallocation");
+                return 0;
+            }
+            u64 osize = 0;
+            u16 oalignment = 0;
+            b8 resized = dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, &osize, &oalignment) &&
+                         oalignment == alignment &&
+                         dynamic_allocator_resize_in_place(&state_ptr->allocator, block, new_size);
+            bmutex_unlock(&state_ptr->allocation_mutex);
+
+            if (resized)
+            {
+                // Counted as a free of the old size and an allocation of the new one
+                memory_stats_record(tag, new_size, old_size);
+                // Only the newly-exposed tail needs clearing
+                if (new_size > old_size)
+                    platform_zero_memory((u8*)block + old_size, new_size - old_size);
+#if BMEMORY_TRACK_CALL_SITES
+                call_site_track_resize(block, new_size);
+#endif
+                return block;
+            }
+        }
+#endif
+    }
+
+    // Couldn't resize in place. Move it, but only clear the part that isn't copied over
+    void* new_block = ballocate_aligned_uninitialized(new_size, alignment, tag);
+    if (new_block)
     {
-        bcopy_memory(new_block, block, old_size);
+        u64 copy_size = BMIN(old_size, new_size);
+        bcopy_memory(new_block, block, copy_size);
+        if (new_size > copy_size)
+            platform_zero_memory((u8*)new_block + copy_size, new_size - copy_size);
         bfree_aligned(block, old_size, alignment, tag);
     }
     return new_block;
@@ -260,6 +443,16 @@ void bfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag)
 
     if (state_ptr)
     {
+#if BMEMORY_TRACK_CALL_SITES
+        call_site_track_free(block);
+#endif
+
+#if B_USE_CUSTOM_MEMORY_ALLOCATOR
+        // Blocks from the small allocator go back to the calling thread's cache
+        if (small_free(block, size, tag))
+            return;
+#endif
+
         // Make sure multithreaded requests don't violate each other
         if (!bmutex_lock(&state_ptr->allocation_mutex))
         {
@@ -277,10 +470,6 @@ void bfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag)
             printf("Free alignment mismatch! (original=%hu, requested=%hu)\n", oalignment, alignment);
 #endif
 
-        state_ptr->stats.total_allocated -= size;
-        state_ptr->stats.tagged_allocations[tag] -= size;
-        state_ptr->stats.new_tagged_deallocations[tag] += size;
-        state_ptr->alloc_count--;
 #if B_USE_CUSTOM_MEMORY_ALLOCATOR
         b8 result = dynamic_allocator_free_aligned(&state_ptr->allocator, block);
 #else
@@ -290,6 +479,8 @@ void bfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag)
 
         bmutex_unlock(&state_ptr->allocation_mutex);
 
+        memory_stats_record(tag, 0, size);
+
         if (!result)
         {
             // TODO: Memory alignment
@@ -305,17 +496,7 @@ void bfree_aligned(void* block, u64 size, u16 alignment, memory_tag tag)
 
 void bfree_report(u64 size, memory_tag tag)
 {
-    // Make sure multithreaded requests don't trample each other
-    if (!bmutex_lock(&state_ptr->allocation_mutex))
-    {
-        BFATAL("Error obtaining mutex lock during allocation reporting");
-        return;
-    }
-    state_ptr->stats.total_allocated -= size;
-    state_ptr->stats.tagged_allocations[tag] -= size;
-    state_ptr->stats.new_tagged_deallocations[tag] += size;
-    state_ptr->alloc_count--;
-    bmutex_unlock(&state_ptr->allocation_mutex);
+    memory_stats_record(tag, 0, size);
 }
 
 b8 bmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment)
@@ -326,6 +507,14 @@ b8 bmemory_get_size_alignment(void* block, u64* out_size, u16* out_alignment)
         return false;
     }
 #if B_USE_CUSTOM_MEMORY_ALLOCATOR
+    if (small_allocator_owns(&state_ptr->small_allocator, block))
+    {
+        bmutex_unlock(&state_ptr->allocation_mutex);
+        // NOTE: Small blocks report their size class, which is also what is tracked in the stats
+        *out_size = small_allocator_block_size(&state_ptr->small_allocator, block);
+        *out_alignment = SMALL_ALLOCATOR_ALIGNMENT;
+        return *out_size != 0;
+    }
     b8 result = dynamic_allocator_get_size_alignment(&state_ptr->allocator, block, out_size, out_alignment);
 #else
     *out_size = 0;
@@ -373,23 +562,38 @@ char* get_memory_usage_str(void)
 {
     char buffer[8000] = "System memory use (tagged):\n";
     u64 offset = strlen(buffer);
+
+    memory_system_stats stats;
+    memory_system_stats_get(&stats);
+
+    // The "new" amounts are since the last report. The counters themselves are never reset, so take a baseline instead
+    u64 new_allocated[MEMORY_TAG_MAX_TAGS];
+    u64 new_freed[MEMORY_TAG_MAX_TAGS];
+    bspinlock_lock(&state_ptr->stats_lock);
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
+    {
+        new_allocated[i] = stats.tags[i].allocated_bytes - state_ptr->reported_allocated_bytes[i];
+        new_freed[i] = stats.tags[i].freed_bytes - state_ptr->reported_freed_bytes[i];
+        state_ptr->reported_allocated_bytes[i] = stats.tags[i].allocated_bytes;
+        state_ptr->reported_freed_bytes[i] = stats.tags[i].freed_bytes;
+    }
+    bspinlock_unlock(&state_ptr->stats_lock);
+
     for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
     {
-        f32 amounts[3] = {1.0f, 1.0f, 1.0f};
-        const char* units[3] = {
-            get_unit_for_size(state_ptr->stats.tagged_allocations[i], &amounts[0]),
-            get_unit_for_size(state_ptr->stats.new_tagged_allocations[i], &amounts[1]),
-            get_unit_for_size(state_ptr->stats.new_tagged_deallocations[i], &amounts[2])
+        f32 amounts[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        const char* units[4] = {
+            get_unit_for_size(stats.tags[i].allocated, &amounts[0]),
+            get_unit_for_size(new_allocated[i], &amounts[1]),
+            get_unit_for_size(new_freed[i], &amounts[2]),
+            get_unit_for_size(stats.tags[i].peak_allocated, &amounts[3])
         };
 
-        i32 length = snprintf(buffer + offset, 8000, "  %s: %-7.2f %-3s [+ %-7.2f %-3s | - %-7.2f%-3s]\n",
-                              memory_tag_strings[i], amounts[0], units[0], amounts[1], units[1], amounts[2], units[2]);
+        i32 length = snprintf(buffer + offset, 8000 - offset, "  %-12s: %-7.2f %-3s [+ %-7.2f %-3s | - %-7.2f%-3s] peak %.2f%s\n",
+                              memory_tag_strings[i], amounts[0], units[0], amounts[1], units[1], amounts[2], units[2], amounts[3], units[3]);
         offset += length;
     }
 
-    bzero_memory(&state_ptr->stats.new_tagged_allocations, sizeof(state_ptr->stats.new_tagged_allocations));
-    bzero_memory(&state_ptr->stats.new_tagged_deallocations, sizeof(state_ptr->stats.new_tagged_deallocations));
-
     {
         // Compute total usage
 #if B_USE_CUSTOM_MEMORY_ALLOCATOR
@@ -410,9 +614,39 @@ char* get_memory_usage_str(void)
 
         f64 percent_used = (f64)(used_space) / total_space;
 
-        i32 length = snprintf(buffer + offset, 8000, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        i32 length = snprintf(buffer + offset, 8000 - offset, "Total memory usage: %.2f%s of %.2f%s (%.2f%%)\n", used_amount, used_unit, total_amount, total_unit, percent_used);
+        offset += length;
+    }
+
+#if B_USE_CUSTOM_MEMORY_ALLOCATOR
+    {
+        // Small allocator pages are carved on demand and never handed back, so this is a high-water mark
+        f32 page_amount = 1.0f;
+        const char* page_unit = get_unit_for_size(small_allocator_page_space(&state_ptr->small_allocator), &page_amount);
+        f32 region_amount = 1.0f;
+        const char* region_unit = get_unit_for_size(small_allocator_total_space(&state_ptr->small_allocator), &region_amount);
+
+        i32 length = snprintf(buffer + offset, 8000 - offset, "Small allocation pages: %.2f%s of %.2f%s\n", page_amount, page_unit, region_amount, region_unit);
         offset += length;
     }
+#endif
+
+    {
+        // Per-thread scratch arenas. High-water marks show how close each thread has come to running out
+        frame_scratch_thread_stats scratch_stats[16];
+        u32 scratch_count = frame_scratch_stats_get(16, scratch_stats);
+        for (u32 i = 0; i < scratch_count && i < 16; ++i)
+        {
+            f32 high_amount = 1.0f;
+            const char* high_unit = get_unit_for_size(scratch_stats[i].high_water, &high_amount);
+            f32 capacity_amount = 1.0f;
+            const char* capacity_unit = get_unit_for_size(scratch_stats[i].capacity, &capacity_amount);
+
+            i32 length = snprintf(buffer + offset, 8000 - offset, "Frame scratch (thread %#llx): high-water %.2f%s of %.2f%s, %llu failed\n",
+                                  scratch_stats[i].thread_id, high_amount, high_unit, capacity_amount, capacity_unit, scratch_stats[i].failed_allocations);
+            offset += length;
+        }
+    }
 
     char* out_string = string_duplicate(buffer);
     return out_string;
@@ -421,7 +655,14 @@ char* get_memory_usage_str(void)
 u64 get_memory_alloc_count(void)
 {
     if (state_ptr)
-        return state_ptr->alloc_count;
+    {
+        memory_tag_counters tags[MEMORY_TAG_MAX_TAGS];
+        memory_counters_gather(tags, false);
+        u64 alloc_count = 0;
+        for (u32 t = 0; t < MEMORY_TAG_MAX_TAGS; ++t)
+            alloc_count += tags[t].allocation_count - tags[t].free_count;
+        return alloc_count;
+    }
     return 0;
 }
 
@@ -442,3 +683,627 @@ b8 unpack_u8_from_u32(u32 n, u8* x, u8* y, u8* z, u8* w)
     
     return true;
 }
+
+static memory_thread_record* thread_record_get(void)
+{
+    if (thread_record_generation == state_ptr->generation)
+        return thread_record;
+
+    // First use on this thread (for this initialization of the memory system). Claim a free record
+    memory_thread_record* record = 0;
+    for (u32 i = 0; i < MEMORY_MAX_THREAD_RECORDS; ++i)
+    {
+        u32 expected = 0;
+        if (batomic_load_relaxed_u32(&state_ptr->thread_records[i].in_use) == 0 && batomic_compare_exchange_u32(&state_ptr->thread_records[i].in_use, &expected, 1))
+        {
+            record = &state_ptr->thread_records[i];
+            // Raise the high-water mark so stats gathering covers this record
+            u32 used = batomic_load_u32(&state_ptr->thread_records_used);
+            while (used < i + 1 && !batomic_compare_exchange_u32(&state_ptr->thread_records_used, &used, i + 1))
+                ;
+            break;
+        }
+    }
+
+    // NOTE: If no record was available, this is cached as well so the search isn't repeated on every call
+    thread_record = record;
+    thread_record_generation = state_ptr->generation;
+    return record;
+}
+
+// Bucket n holds sizes in (16 << (n - 1), 16 << n], with the last taking everything larger
+static u32 size_histogram_bucket(u64 size)
+{
+    if (size <= MEMORY_SIZE_HISTOGRAM_MIN)
+        return 0;
+    u32 bucket = (64 - (u32)__builtin_clzll(size - 1)) - 4;
+    return BMIN(bucket, MEMORY_SIZE_HISTOGRAM_BUCKETS - 1);
+}
+
+// Only the owner of a record (or the holder of the overflow lock) writes to it, so a plain
+// read-modify-write is enough. The relaxed store keeps concurrent readers from seeing a torn value
+static void counter_add(u64* counter, u64 amount)
+{
+    batomic_store_relaxed_u64((volatile u64*)counter, *counter + amount);
+}
+
+static void record_allocation(memory_thread_record* record, memory_tag tag, u64 size)
+{
+    memory_tag_counters* counters = &record->tags[tag];
+    counter_add(&counters->allocated, size);
+    counter_add(&counters->allocation_count, 1);
+    counter_add(&counters->allocated_bytes, size);
+    counter_add(&counters->size_histogram[size_histogram_bucket(size)], 1);
+}
+
+static void record_free(memory_thread_record* record, memory_tag tag, u64 size)
+{
+    memory_tag_counters* counters = &record->tags[tag];
+    counter_add(&counters->allocated, (u64)0 - size);
+    counter_add(&counters->free_count, 1);
+    counter_add(&counters->freed_bytes, size);
+}
+
+// Counts an allocation and/or free on the calling thread's record. Either size may be 0 to skip that half
+static void memory_stats_record(memory_tag tag, u64 allocated, u64 freed)
+{
+    if (!state_ptr)
+        return;
+
+    memory_thread_record* record = thread_record_get();
+    b8 overflow = record == 0;
+    if (overflow)
+    {
+        record = &state_ptr->overflow_record;
+        bspinlock_lock(&state_ptr->overflow_lock);
+    }
+
+    if (freed)
+        record_free(record, tag, freed);
+    if (allocated)
+        record_allocation(record, tag, allocated);
+
+    if (overflow)
+        bspinlock_unlock(&state_ptr->overflow_lock);
+}
+
+static void* allocate(u64 size, u16 alignment, memory_tag tag, b8 zero)
+{
+    BASSERT_MSG(size, "ballocate requires a nonzero size");
+    if (tag == MEMORY_TAG_UNKNOWN)
+        BWARN("ballocate called using MEMORY_TAG_UNKNOWN. Re-class this allocation");
+
+    // Either allocate from the system's allocator or the OS
+    void* block = 0;
+    if (state_ptr)
+    {
+#if B_USE_CUSTOM_MEMORY_ALLOCATOR
+        // Small requests are served from the calling thread's cache without taking the global lock
+        if (small_allocator_accepts(size, alignment))
+        {
+            block = small_allocate(size, tag);
+            if (block)
+            {
+                if (zero)
+                    platform_zero_memory(block, size);
+#if BMEMORY_TRACK_CALL_SITES
+                call_site_track_allocate(block, size, tag);
+#endif
+                return block;
+            }
+        }
+#endif
+
+        // Make sure multithreaded requests don't violate each other
+        if (!bmutex_lock(&state_ptr->allocation_mutex))
+        {
+            BFATAL("Error obtaining mutex lock during allocation");
+            return 0;
+        }
+
+#if B_USE_CUSTOM_MEMORY_ALLOCATOR
+        block = dynamic_allocator_allocate_aligned(&state_ptr->allocator, size, alignment);
+#else
+        block = baligned_alloc(size, alignment);
+#endif
+        bmutex_unlock(&state_ptr->allocation_mutex);
+
+        if (block)
+        {
+            memory_stats_record(tag, size, 0);
+#if BMEMORY_TRACK_CALL_SITES
+            call_site_track_allocate(block, size, tag);
+#endif
+        }
+    }
+    else
+    {
+        // If system is not up yet, warn about it but give memory for now
+        // BWARN("ballocate_aligned called before the memory system is initialized");
+        // TODO: Memory alignment
+        block = platform_allocate(size, false);
+    }
+
+    if (block)
+    {
+        if (zero)
+            platform_zero_memory(block, size);
+        return block;
+    }
+
+    BFATAL("ballocate failed to allocate");
+    return 0;
+}
+
+static void* small_allocate(u64 size, memory_tag tag)
+{
+    memory_thread_record* record = thread_record_get();
+    b8 overflow = record == 0;
+    if (overflow)
+    {
+        record = &state_ptr->overflow_record;
+        bspinlock_lock(&state_ptr->overflow_lock);
+    }
+
+    u64 block_size = 0;
+    void* block = small_allocator_allocate(&state_ptr->small_allocator, &record->cache, size, &block_size);
+    if (block)
+    {
+        // NOTE: Small allocations are tracked by their size class, so the free always balances regardless of the size passed in
+        record_allocation(record, tag, block_size);
+    }
+
+    if (overflow)
+        bspinlock_unlock(&state_ptr->overflow_lock);
+    return block;
+}
+
+static b8 small_free(void* block, u64 size, memory_tag tag)
+{
+    if (!small_allocator_owns(&state_ptr->small_allocator, block))
+        return false;
+
+    memory_thread_record* record = thread_record_get();
+    b8 overflow = record == 0;
+    if (overflow)
+    {
+        record = &state_ptr->overflow_record;
+        bspinlock_lock(&state_ptr->overflow_lock);
+    }
+
+    u64 block_size = 0;
+    b8 result = small_allocator_free(&state_ptr->small_allocator, &record->cache, block, &block_size);
+    if (result)
+    {
+        record_free(record, tag, block_size);
+    }
+
+    if (overflow)
+        bspinlock_unlock(&state_ptr->overflow_lock);
+
+    if (size > block_size)
+        BWARN("bfree size mismatch! (size class=%llu, requested=%llu)", block_size, size);
+    return result;
+}
+
+static void thread_record_accumulate(memory_thread_record* record, memory_tag_counters* sums, b8 include_histograms)
+{
+    // NOTE: Relaxed loads, since the owning thread may be writing concurrently
+    for (u32 t = 0; t < MEMORY_TAG_MAX_TAGS; ++t)
+    {
+        memory_tag_counters* counters = &record->tags[t];
+        sums[t].allocated += batomic_load_relaxed_u64(&counters->allocated);
+        sums[t].allocation_count += batomic_load_relaxed_u64(&counters->allocation_count);
+        sums[t].allocated_bytes += batomic_load_relaxed_u64(&counters->allocated_bytes);
+        sums[t].free_count += batomic_load_relaxed_u64(&counters->free_count);
+        sums[t].freed_bytes += batomic_load_relaxed_u64(&counters->freed_bytes);
+        if (include_histograms)
+        {
+            for (u32 b = 0; b < MEMORY_SIZE_HISTOGRAM_BUCKETS; ++b)
+                sums[t].size_histogram[b] += batomic_load_relaxed_u64(&counters->size_histogram[b]);
+        }
+    }
+}
+
+static void memory_counters_gather(memory_tag_counters* out_tags, b8 include_histograms)
+{
+    bzero_memory(out_tags, sizeof(memory_tag_counters) * MEMORY_TAG_MAX_TAGS);
+
+    u32 used = batomic_load_u32(&state_ptr->thread_records_used);
+    for (u32 i = 0; i < used; ++i)
+        thread_record_accumulate(&state_ptr->thread_records[i], out_tags, include_histograms);
+    bspinlock_lock(&state_ptr->overflow_lock);
+    thread_record_accumulate(&state_ptr->overflow_record, out_tags, include_histograms);
+    bspinlock_unlock(&state_ptr->overflow_lock);
+}
+
+// NOTE: Peaks are sampled whenever stats are gathered, so short spikes between samples are missed. Must hold the stats lock
+static u64 memory_peaks_update(const memory_tag_counters* tags)
+{
+    u64 total = 0;
+    for (u32 t = 0; t < MEMORY_TAG_MAX_TAGS; ++t)
+    {
+        total += tags[t].allocated;
+        if (tags[t].allocated > state_ptr->peak_allocated[t])
+            state_ptr->peak_allocated[t] = tags[t].allocated;
+    }
+    if (total > state_ptr->peak_total_allocated)
+        state_ptr->peak_total_allocated = total;
+    return total;
+}
+
+b8 memory_system_stats_get(memory_system_stats* out_stats)
+{
+    if (!state_ptr || !out_stats)
+        return false;
+
+    memory_tag_counters tags[MEMORY_TAG_MAX_TAGS];
+    memory_counters_gather(tags, true);
+
+    bzero_memory(out_stats, sizeof(memory_system_stats));
+    bspinlock_lock(&state_ptr->stats_lock);
+    out_stats->total_allocated = memory_peaks_update(tags);
+    out_stats->peak_total_allocated = state_ptr->peak_total_allocated;
+    out_stats->frame_number = state_ptr->frame_number;
+    for (u32 t = 0; t < MEMORY_TAG_MAX_TAGS; ++t)
+    {
+        memory_tag_stats* tag = &out_stats->tags[t];
+        tag->allocated = tags[t].allocated;
+        tag->peak_allocated = state_ptr->peak_allocated[t];
+        tag->allocation_count = tags[t].allocation_count;
+        tag->allocated_bytes = tags[t].allocated_bytes;
+        tag->free_count = tags[t].free_count;
+        tag->freed_bytes = tags[t].freed_bytes;
+        tag->frame_allocation_count = state_ptr->frame_allocation_counts[t];
+        tag->frame_allocated_bytes = state_ptr->frame_allocated_bytes[t];
+        bcopy_memory(tag->size_histogram, tags[t].size_histogram, sizeof(tag->size_histogram));
+
+        out_stats->live_allocation_count += tag->allocation_count - tag->free_count;
+        out_stats->frame_allocation_count += tag->frame_allocation_count;
+        out_stats->frame_allocated_bytes += tag->frame_allocated_bytes;
+    }
+    bspinlock_unlock(&state_ptr->stats_lock);
+    return true;
+}
+
+void memory_system_frame_mark(void)
+{
+    if (!state_ptr)
+        return;
+
+    memory_tag_counters tags[MEMORY_TAG_MAX_TAGS];
+    memory_counters_gather(tags, false);
+
+    bspinlock_lock(&state_ptr->stats_lock);
+    for (u32 t = 0; t < MEMORY_TAG_MAX_TAGS; ++t)
+    {
+        state_ptr->frame_allocation_counts[t] = tags[t].allocation_count - state_ptr->frame_start_allocation_counts[t];
+        state_ptr->frame_allocated_bytes[t] = tags[t].allocated_bytes - state_ptr->frame_start_allocated_bytes[t];
+        state_ptr->frame_start_allocation_counts[t] = tags[t].allocation_count;
+        state_ptr->frame_start_allocated_bytes[t] = tags[t].allocated_bytes;
+    }
+    memory_peaks_update(tags);
+    state_ptr->frame_number++;
+    bspinlock_unlock(&state_ptr->stats_lock);
+}
+
+const char* memory_tag_name(memory_tag tag)
+{
+    if (tag >= MEMORY_TAG_MAX_TAGS)
+        return "INVALID";
+    return memory_tag_strings[tag];
+}
+
+u64 memory_size_histogram_bucket_limit(u32 bucket)
+{
+    if (bucket >= MEMORY_SIZE_HISTOGRAM_BUCKETS - 1)
+        return U64_MAX;
+    return (u64)MEMORY_SIZE_HISTOGRAM_MIN << bucket;
+}
+
+#if BMEMORY_TRACK_CALL_SITES
+// The calling thread's next call site, noted by the allocation macros and taken by the allocation itself
+static BTHREAD_LOCAL const char* pending_site_file;
+static BTHREAD_LOCAL u32 pending_site_line;
+
+void bmemory_call_site_set(const char* file, u32 line)
+{
+    pending_site_file = file;
+    pending_site_line = line;
+}
+
+static u64 call_site_block_hash(void* block)
+{
+    // Blocks are at least 8-byte aligned, so the low bits carry nothing
+    return ((u64)block >> 3) * 0x9E3779B97F4A7C15ULL;
+}
+
+static b8 call_site_tracking_initialize(call_site_tracking* tracking)
+{
+    bspinlock_create(&tracking->lock);
+    u64 sites_size = sizeof(memory_call_site_stats) * (CALL_SITE_CAPACITY + 1);
+    u64 blocks_size = sizeof(call_site_block) * CALL_SITE_BLOCK_INITIAL_CAPACITY;
+    tracking->sites = platform_allocate(sites_size, false);
+    tracking->blocks = platform_allocate(blocks_size, false);
+    if (!tracking->sites || !tracking->blocks)
+        return false;
+
+    platform_zero_memory(tracking->sites, sites_size);
+    platform_zero_memory(tracking->blocks, blocks_size);
+    tracking->block_capacity = CALL_SITE_BLOCK_INITIAL_CAPACITY;
+    tracking->start_time = platform_get_absolute_time();
+    return true;
+}
+
+static void call_site_tracking_shutdown(call_site_tracking* tracking)
+{
+    platform_free(tracking->sites, false);
+    platform_free(tracking->blocks, false);
+    tracking->sites = 0;
+    tracking->blocks = 0;
+}
+
+// Finds or adds the entry for the given call site. Must hold the tracking lock
+static u32 call_site_get(call_site_tracking* tracking, const char* file, u32 line, memory_tag tag)
+{
+    if (!file)
+        return CALL_SITE_CAPACITY;
+
+    // NOTE: Keyed on the file string's address. Literals are pooled per translation unit, so this is stable
+    u64 hash = (((u64)file >> 3) ^ ((u64)line << 32)) * 0x9E3779B97F4A7C15ULL;
+    u32 mask = CALL_SITE_CAPACITY - 1;
+    for (u32 probe = 0; probe < CALL_SITE_CAPACITY; ++probe)
+    {
+        u32 index = (u32)((hash >> 32) + probe) & mask;
+        memory_call_site_stats* site = &tracking->sites[index];
+        if (site->file == file && site->line == line)
+            return index;
+        if (!site->file)
+        {
+            // Leave some headroom so probes stay short
+            if (tracking->site_count >= (CALL_SITE_CAPACITY / 4) * 3)
+                break;
+            site->file = file;
+            site->line = line;
+            site->tag = tag;
+            tracking->site_count++;
+            return index;
+        }
+    }
+    return CALL_SITE_CAPACITY;
+}
+
+// Returns the slot holding the given block, or the empty slot where it would go. Must hold the tracking lock
+static u64 call_site_block_find(call_site_tracking* tracking, void* block)
+{
+    u64 mask = tracking->block_capacity - 1;
+    u64 index = call_site_block_hash(block) & mask;
+    while (tracking->blocks[index].block && tracking->blocks[index].block != block)
+        index = (index + 1) & mask;
+    return index;
+}
+
+static b8 call_site_blocks_grow(call_site_tracking* tracking)
+{
+    u64 new_capacity = tracking->block_capacity * 2;
+    call_site_block* new_blocks = platform_allocate(sizeof(call_site_block) * new_capacity, false);
+    if (!new_blocks)
+        return false;
+    platform_zero_memory(new_blocks, sizeof(call_site_block) * new_capacity);
+
+    call_site_block* old_blocks = tracking->blocks;
+    u64 old_capacity = tracking->block_capacity;
+    tracking->blocks = new_blocks;
+    tracking->block_capacity = new_capacity;
+    for (u64 i = 0; i < old_capacity; ++i)
+    {
+        if (old_blocks[i].block)
+            tracking->blocks[call_site_block_find(tracking, old_blocks[i].block)] = old_blocks[i];
+    }
+    platform_free(old_blocks, false);
+    return true;
+}
+
+static void call_site_track_allocate(void* block, u64 size, memory_tag tag)
+{
+    const char* file = pending_site_file;
+    u32 line = pending_site_line;
+    pending_site_file = 0;
+
+    call_site_tracking* tracking = &state_ptr->call_sites;
+    bspinlock_lock(&tracking->lock);
+    u32 site_index = call_site_get(tracking, file, line, tag);
+    memory_call_site_stats* site = &tracking->sites[site_index];
+    site->allocation_count++;
+    site->allocated_bytes += size;
+
+    // Keep the load at or below half, so lookups on free stay cheap
+    if ((tracking->block_count + 1) * 2 <= tracking->block_capacity || call_site_blocks_grow(tracking))
+    {
+        call_site_block* entry = &tracking->blocks[call_site_block_find(tracking, block)];
+        entry->block = block;
+        entry->size = size;
+        entry->site = site_index;
+        tracking->block_count++;
+        site->live_count++;
+        site->live_bytes += size;
+    }
+    bspinlock_unlock(&tracking->lock);
+}
+
+static void call_site_track_resize(void* block, u64 new_size)
+{
+    const char* file = pending_site_file;
+    u32 line = pending_site_line;
+    pending_site_file = 0;
+
+    // NOTE: Counted as a free from the block's original site and an allocation from this one
+    call_site_tracking* tracking = &state_ptr->call_sites;
+    bspinlock_lock(&tracking->lock);
+    call_site_block* entry = &tracking->blocks[call_site_block_find(tracking, block)];
+    if (entry->block)
+    {
+        memory_call_site_stats* old_site = &tracking->sites[entry->site];
+        old_site->free_count++;
+        old_site->freed_bytes += entry->size;
+        old_site->live_count--;
+        old_site->live_bytes -= entry->size;
+
+        u32 site_index = call_site_get(tracking, file, line, old_site->tag);
+        memory_call_site_stats* site = &tracking->sites[site_index];
+        site->allocation_count++;
+        site->allocated_bytes += new_size;
+        site->live_count++;
+        site->live_bytes += new_size;
+        entry->size = new_size;
+        entry->site = site_index;
+    }
+    bspinlock_unlock(&tracking->lock);
+}
+
+static void call_site_track_free(void* block)
+{
+    call_site_tracking* tracking = &state_ptr->call_sites;
+    bspinlock_lock(&tracking->lock);
+    u64 mask = tracking->block_capacity - 1;
+    u64 hole = call_site_block_find(tracking, block);
+    call_site_block* entry = &tracking->blocks[hole];
+    if (entry->block)
+    {
+        memory_call_site_stats* site = &tracking->sites[entry->site];
+        site->free_count++;
+        site->freed_bytes += entry->size;
+        site->live_count--;
+        site->live_bytes -= entry->size;
+        tracking->block_count--;
+
+        // Backward-shift deletion, so no tombstones are needed: pull later entries of the run
+        // into the hole unless that would move them in front of their home slot
+        u64 index = (hole + 1) & mask;
+        while (tracking->blocks[index].block)
+        {
+            u64 home = call_site_block_hash(tracking->blocks[index].block) & mask;
+            if (((index - home) & mask) >= ((index - hole) & mask))
+            {
+                tracking->blocks[hole] = tracking->blocks[index];
+                hole = index;
+            }
+            index = (index + 1) & mask;
+        }
+        tracking->blocks[hole].block = 0;
+    }
+    bspinlock_unlock(&tracking->lock);
+}
+
+u32 memory_call_sites_get(u32 max_count, memory_call_site_stats* out_sites)
+{
+    if (!state_ptr)
+        return 0;
+
+    call_site_tracking* tracking = &state_ptr->call_sites;
+    u32 count = 0;
+    bspinlock_lock(&tracking->lock);
+    for (u32 i = 0; i <= CALL_SITE_CAPACITY; ++i)
+    {
+        memory_call_site_stats* site = &tracking->sites[i];
+        if (!site->allocation_count)
+            continue;
+        if (out_sites && count < max_count)
+            out_sites[count] = *site;
+        count++;
+    }
+    bspinlock_unlock(&tracking->lock);
+    return count;
+}
+
+// Key functions for the report sections
+static f64 call_site_key_bytes(const memory_call_site_stats* site) { return (f64)site->allocated_bytes; }
+static f64 call_site_key_count(const memory_call_site_stats* site) { return (f64)site->allocation_count; }
+static f64 call_site_key_live(const memory_call_site_stats* site) { return (f64)site->live_bytes; }
+
+// Moves the top_count sites with the largest keys to the front of the array, in descending order
+static u32 call_sites_select_top(memory_call_site_stats* sites, u32 count, u32 top_count, f64 (*key)(const memory_call_site_stats*))
+{
+    u32 selected = BMIN(count, top_count);
+    for (u32 i = 0; i < selected; ++i)
+    {
+        u32 best = i;
+        for (u32 j = i + 1; j < count; ++j)
+        {
+            if (key(&sites[j]) > key(&sites[best]))
+                best = j;
+        }
+        memory_call_site_stats temp = sites[i];
+        sites[i] = sites[best];
+        sites[best] = temp;
+    }
+    return selected;
+}
+
+void memory_call_sites_report(u32 top_count)
+{
+    if (!state_ptr || !top_count)
+        return;
+
+    // Copy out, so nothing is held while logging (which allocates)
+    u32 count = memory_call_sites_get(0, 0);
+    if (!count)
+        return;
+    u64 sites_size = sizeof(memory_call_site_stats) * count;
+    memory_call_site_stats* sites = platform_allocate(sites_size, false);
+    count = BMIN(count, memory_call_sites_get(count, sites));
+
+    f64 elapsed = platform_get_absolute_time() - state_ptr->call_sites.start_time;
+    if (elapsed <= 0.0)
+        elapsed = 1.0;
+    bspinlock_lock(&state_ptr->stats_lock);
+    u64 frames = state_ptr->frame_number ? state_ptr->frame_number : 1;
+    bspinlock_unlock(&state_ptr->stats_lock);
+
+    BINFO("Allocation call sites (%u sites over %.2fs, %llu frames):", count, elapsed, frames);
+
+    BINFO("  Top call sites by bytes/sec:");
+    u32 shown = call_sites_select_top(sites, count, top_count, call_site_key_bytes);
+    for (u32 i = 0; i < shown; ++i)
+    {
+        BINFO("    %12.0f B/s  %-12s %s:%u", sites[i].allocated_bytes / elapsed, memory_tag_name(sites[i].tag), sites[i].file ? sites[i].file : "<unknown>", sites[i].line);
+    }
+
+    BINFO("  Top call sites by allocations/frame:");
+    shown = call_sites_select_top(sites, count, top_count, call_site_key_count);
+    for (u32 i = 0; i < shown; ++i)
+    {
+        BINFO("    %12.2f /frame  %-12s %s:%u", (f64)sites[i].allocation_count / frames, memory_tag_name(sites[i].tag), sites[i].file ? sites[i].file : "<unknown>", sites[i].line);
+    }
+
+    u64 live_count = 0;
+    u64 live_bytes = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+        live_count += sites[i].live_count;
+        live_bytes += sites[i].live_bytes;
+    }
+    BINFO("  Outstanding allocations: %llu blocks, %llu bytes", live_count, live_bytes);
+    shown = call_sites_select_top(sites, count, top_count, call_site_key_live);
+    for (u32 i = 0; i < shown && sites[i].live_count; ++i)
+    {
+        BINFO("    %8llu blocks %12llu B  %-12s %s:%u", sites[i].live_count, sites[i].live_bytes, memory_tag_name(sites[i].tag), sites[i].file ? sites[i].file : "<unknown>", sites[i].line);
+    }
+
+    platform_free(sites, false);
+}
+#else
+u32 memory_call_sites_get(u32 max_count, memory_call_site_stats* out_sites)
+{
+    return 0;
+}
+
+void memory_call_sites_report(u32 top_count)
+{
+    BWARN("Allocation call-site tracking is not enabled. Rebuild with BMEMORY_TRACK_CALL_SITES=1 (make TRACK_ALLOCATIONS=yes)");
+}
+
+void bmemory_call_site_set(const char* file, u32 line)
+{
+}
+#endif
@@ -2,6 +2,12 @@
 
 #include "defines.h"
 
+// Allocation call-site tracking. Compiled out entirely unless the build defines BMEMORY_TRACK_CALL_SITES=1
+// (i.e. make TRACK_ALLOCATIONS=yes). See memory_call_sites_report()
+#ifndef BMEMORY_TRACK_CALL_SITES
+#define BMEMORY_TRACK_CALL_SITES 0
+#endif
+
 // Interface for a frame allocator
 typedef struct frame_allocator_int
 {
@@ -59,11 +65,66 @@ typedef struct memory_system_configuration
 {
     // Total memory size in bytes used by the internal allocator for this system
     u64 total_alloc_size;
+    // Size in bytes of the region reserved for small allocations, which are served from per-thread
+    // caches without taking the global allocation lock. If 0, total_alloc_size / 16 is used
+    u64 small_alloc_size;
 } memory_system_configuration;
 
+// The number of buckets in each tag's allocation size histogram
+#define MEMORY_SIZE_HISTOGRAM_BUCKETS 16
+
+/** @brief Allocation statistics for a single memory tag */
+typedef struct memory_tag_stats
+{
+    /** @brief The number of bytes currently allocated */
+    u64 allocated;
+    /** @brief The highest value of allocated seen at a frame mark or stats query */
+    u64 peak_allocated;
+    /** @brief The number of allocations made since startup */
+    u64 allocation_count;
+    /** @brief The number of bytes allocated since startup */
+    u64 allocated_bytes;
+    /** @brief The number of frees made since startup */
+    u64 free_count;
+    /** @brief The number of bytes freed since startup */
+    u64 freed_bytes;
+    /** @brief The number of allocations made during the last complete frame */
+    u64 frame_allocation_count;
+    /** @brief The number of bytes allocated during the last complete frame */
+    u64 frame_allocated_bytes;
+    /** @brief Allocation counts by size since startup. See memory_size_histogram_bucket_limit() for bucket ranges */
+    u64 size_histogram[MEMORY_SIZE_HISTOGRAM_BUCKETS];
+} memory_tag_stats;
+
+/** @brief A snapshot of the memory system's allocation statistics */
+typedef struct memory_system_stats
+{
+    /** @brief The number of bytes currently allocated across all tags */
+    u64 total_allocated;
+    /** @brief The highest value of total_allocated seen at a frame mark or stats query */
+    u64 peak_total_allocated;
+    /** @brief The number of allocations which have not yet been freed */
+    u64 live_allocation_count;
+    /** @brief The number of frames marked so far */
+    u64 frame_number;
+    /** @brief The number of allocations made during the last complete frame, across all tags */
+    u64 frame_allocation_count;
+    /** @brief The number of bytes allocated during the last complete frame, across all tags */
+    u64 frame_allocated_bytes;
+    /** @brief Per-tag statistics, indexed by memory_tag */
+    memory_tag_stats tags[MEMORY_TAG_MAX_TAGS];
+} memory_system_stats;
+
 BAPI b8 memory_system_initialize(memory_system_configuration config);
 BAPI void memory_system_shutdown(void);
 
+/**
+ * @brief Returns the calling thread's cached small-allocation blocks to the shared pool
+ * and releases its per-thread record so it can be reused. Threads that allocate should
+ * call this just before they exit. Safe to call from threads that never allocated.
+ */
+BAPI void memory_system_thread_release(void);
+
 BAPI void* ballocate(u64 size, memory_tag tag);
 
 #define BALLOC_TYPE(type, mem_tag) (type*)ballocate(sizeof(type), mem_tag)
@@ -72,8 +133,21 @@ BAPI void* ballocate(u64 size, memory_tag tag);
 #define BFREE_TYPE_CARRAY(block, type, count) bfree(block, sizeof(type) * count, MEMORY_TAG_ARRAY)
 
 BAPI void* ballocate_aligned(u64 size, u16 alignment, memory_tag tag);
+
+/**
+ * @brief Same as ballocate, but the contents of the block are left undefined rather than zeroed.
+ * Use for hot paths where the caller is about to overwrite the whole block anyway.
+ */
+BAPI void* ballocate_uninitialized(u64 size, memory_tag tag);
+/** @brief Same as ballocate_aligned, but the contents of the block are left undefined rather than zeroed. */
+BAPI void* ballocate_aligned_uninitialized(u64 size, u16 alignment, memory_tag tag);
 BAPI void ballocate_report(u64 size, memory_tag tag);
 
+/**
+ * @brief Resizes the given block, growing or shrinking it in place where possible and moving it otherwise.
+ * Existing contents up to the smaller of the two sizes are kept, and any newly-exposed bytes are zeroed.
+ * Returns the (possibly unchanged) block pointer.
+ */
 BAPI void* breallocate(void* block, u64 old_size, u64 new_size, memory_tag tag);
 #define BREALLOC_TYPE_CARRAY(block, type, old_count, new_count) (type*)breallocate(block, sizeof(type) * old_count, sizeof(type) * new_count, MEMORY_TAG_ARRAY)
 
@@ -94,8 +168,90 @@ BAPI void* bcopy_memory(void* dest, const void* source, u64 size);
 
 BAPI void* bset_memory(void* dest, i32 value, u64 size);
 
+/** @brief Returns the largest binary unit (B, KiB, MiB, GiB) for the given size, and the size in that unit via out_amount */
+BAPI const char* get_unit_for_size(u64 size_bytes, f32* out_amount);
+
 BAPI char* get_memory_usage_str(void);
 BAPI u64 get_memory_alloc_count(void);
 
+/**
+ * @brief Obtains a snapshot of allocation statistics. Allocations only ever touch counters owned by
+ * the allocating thread, so these are summed here on demand. Cheap enough to call every frame.
+ *
+ * @param out_stats A pointer to hold the stats.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 memory_system_stats_get(memory_system_stats* out_stats);
+
+/**
+ * @brief Marks a frame boundary. The allocations made since the previous mark become the per-frame
+ * counts in memory_system_stats, and peaks are sampled. Should be called once per frame from the main thread.
+ */
+BAPI void memory_system_frame_mark(void);
+
+/** @brief Usage of a single allocation call site. Only gathered when BMEMORY_TRACK_CALL_SITES is enabled */
+typedef struct memory_call_site_stats
+{
+    /** @brief The source file of the call, or 0 for allocations made without a known call site */
+    const char* file;
+    /** @brief The line of the call */
+    u32 line;
+    /** @brief The tag of the first allocation made from this site */
+    memory_tag tag;
+    /** @brief The number of allocations made from this site */
+    u64 allocation_count;
+    /** @brief The number of bytes allocated from this site */
+    u64 allocated_bytes;
+    /** @brief The number of blocks from this site which have since been freed */
+    u64 free_count;
+    /** @brief The number of bytes from this site which have since been freed */
+    u64 freed_bytes;
+    /** @brief The number of blocks from this site which are still allocated */
+    u64 live_count;
+    /** @brief The number of bytes from this site which are still allocated */
+    u64 live_bytes;
+} memory_call_site_stats;
+
+/**
+ * @brief Obtains usage for every call site which has allocated so far, in no particular order.
+ * Always returns 0 unless BMEMORY_TRACK_CALL_SITES is enabled.
+ *
+ * @param max_count The number of entries out_sites can hold.
+ * @param out_sites An array to be filled with call site stats. May be 0 to just get the count.
+ * @return The number of call sites which have allocated.
+ */
+BAPI u32 memory_call_sites_get(u32 max_count, memory_call_site_stats* out_sites);
+
+/**
+ * @brief Logs the top call sites by bytes allocated per second and by allocations per frame, followed by
+ * the sites with outstanding allocations. Also run automatically at shutdown, where anything outstanding
+ * is a leak. Only logs a warning unless BMEMORY_TRACK_CALL_SITES is enabled.
+ *
+ * @param top_count The number of call sites to list in each section.
+ */
+BAPI void memory_call_sites_report(u32 top_count);
+
+/** @brief Used by the allocation macros to note the call site of the next allocation on the calling thread */
+BAPI void bmemory_call_site_set(const char* file, u32 line);
+
+/** @brief Returns the name of the given memory tag */
+BAPI const char* memory_tag_name(memory_tag tag);
+
+/**
+ * @brief Returns the largest allocation size counted by the given size histogram bucket. Bucket 0 holds
+ * allocations of up to 16 bytes, and each bucket after doubles that. The last bucket holds everything larger.
+ */
+BAPI u64 memory_size_histogram_bucket_limit(u32 bucket);
+
 BAPI u32 pack_u8_into_u32(u8 x, u8 y, u8 z, u8 w);
 BAPI b8 unpack_u8_from_u32(u32 n, u8* x, u8* y, u8* z, u8* w);
+
+#if BMEMORY_TRACK_CALL_SITES && !defined(BMEMORY_IMPLEMENTATION)
+// NOTE: A function-like macro isn't expanded again within its own expansion, so each of these still calls the real function
+#define ballocate(size, tag) (bmemory_call_site_set(__FILE__, __LINE__), ballocate(size, tag))
+#define ballocate_aligned(size, alignment, tag) (bmemory_call_site_set(__FILE__, __LINE__), ballocate_aligned(size, alignment, tag))
+#define ballocate_uninitialized(size, tag) (bmemory_call_site_set(__FILE__, __LINE__), ballocate_uninitialized(size, tag))
+#define ballocate_aligned_uninitialized(size, alignment, tag) (bmemory_call_site_set(__FILE__, __LINE__), ballocate_aligned_uninitialized(size, alignment, tag))
+#define breallocate(block, old_size, new_size, tag) (bmemory_call_site_set(__FILE__, __LINE__), breallocate(block, old_size, new_size, tag))
+#define breallocate_aligned(block, old_size, new_size, alignment, tag) (bmemory_call_site_set(__FILE__, __LINE__), breallocate_aligned(block, old_size, new_size, alignment, tag))
+#endif
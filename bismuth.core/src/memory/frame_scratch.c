@@ -0,0 +1,225 @@
+#include "frame_scratch.h"
+
+#include "logger.h"
+#include "memory/bmemory.h"
+#include "threads/batomic.h"
+#include "threads/bthread.h"
+
+// The maximum number of threads which can hold scratch arenas at once
+#define FRAME_SCRATCH_MAX_THREADS 64
+#define FRAME_SCRATCH_ALIGNMENT 16
+
+/**
+ * @brief A thread's pair of arenas. Only the owning thread allocates from it, so the offsets need
+ * no synchronization. Stats are read from other threads with relaxed loads.
+ */
+typedef struct frame_scratch_record
+{
+    volatile u32 in_use;
+    u64 thread_id;
+    // Both arenas, back to back. Kept when the record is released, so the next owner can reuse it
+    u8* memory;
+    // Offsets into each arena
+    u64 offsets[2];
+    // The arena currently being allocated from
+    u32 current;
+    // The frame the owner last allocated in
+    u64 frame;
+    volatile u64 high_water;
+    volatile u64 failed_allocations;
+} frame_scratch_record;
+
+typedef struct frame_scratch_state
+{
+    u64 arena_size;
+    // Incremented at each frame boundary
+    volatile u64 frame;
+    // Identifies this initialization, so stale thread-local pointers can be detected
+    u32 generation;
+    frame_scratch_record records[FRAME_SCRATCH_MAX_THREADS];
+} frame_scratch_state;
+
+static frame_scratch_state state;
+static u32 scratch_generation = 0;
+
+static BTHREAD_LOCAL frame_scratch_record* thread_scratch;
+static BTHREAD_LOCAL u32 thread_scratch_generation;
+
+b8 frame_scratch_initialize(u64 arena_size)
+{
+    if (state.generation)
+    {
+        BERROR("frame_scratch_initialize called more than once without a shutdown");
+        return false;
+    }
+    if (!arena_size)
+    {
+        BERROR("frame_scratch_initialize requires a nonzero arena size");
+        return false;
+    }
+
+    bzero_memory(&state, sizeof(frame_scratch_state));
+    state.arena_size = (arena_size + FRAME_SCRATCH_ALIGNMENT - 1) & ~((u64)FRAME_SCRATCH_ALIGNMENT - 1);
+    state.generation = ++scratch_generation;
+    return true;
+}
+
+void frame_scratch_shutdown(void)
+{
+    if (!state.generation)
+        return;
+
+    for (u32 i = 0; i < FRAME_SCRATCH_MAX_THREADS; ++i)
+    {
+        frame_scratch_record* record = &state.records[i];
+        if (record->memory)
+            bfree_aligned(record->memory, state.arena_size * 2, FRAME_SCRATCH_ALIGNMENT, MEMORY_TAG_LINEAR_ALLOCATOR);
+    }
+    bzero_memory(&state, sizeof(frame_scratch_state));
+}
+
+void frame_scratch_frame_advance(void)
+{
+    batomic_fetch_add_u64(&state.frame, 1);
+}
+
+// Gets the calling thread's record, claiming a free one on first use
+static frame_scratch_record* frame_scratch_record_get(void)
+{
+    if (thread_scratch_generation == state.generation)
+        return thread_scratch;
+
+    frame_scratch_record* record = 0;
+    for (u32 i = 0; i < FRAME_SCRATCH_MAX_THREADS; ++i)
+    {
+        u32 expected = 0;
+        if (batomic_load_relaxed_u32(&state.records[i].in_use) == 0 && batomic_compare_exchange_u32(&state.records[i].in_use, &expected, 1))
+        {
+            record = &state.records[i];
+            break;
+        }
+    }
+
+    if (record)
+    {
+        if (!record->memory)
+            record->memory = ballocate_aligned_uninitialized(state.arena_size * 2, FRAME_SCRATCH_ALIGNMENT, MEMORY_TAG_LINEAR_ALLOCATOR);
+        record->thread_id = platform_current_thread_id();
+        record->offsets[0] = 0;
+        record->offsets[1] = 0;
+        record->current = 0;
+        record->frame = batomic_load_u64(&state.frame);
+        batomic_store_relaxed_u64(&record->high_water, 0);
+        batomic_store_relaxed_u64(&record->failed_allocations, 0);
+    }
+    else
+    {
+        BWARN("No frame scratch arenas left for thread %#llx. Scratch allocations on it will fail", platform_current_thread_id());
+    }
+
+    // NOTE: Cached even if none was available, so the search isn't repeated on every call
+    thread_scratch = record;
+    thread_scratch_generation = state.generation;
+    return record;
+}
+
+void* frame_scratch_allocate(u64 size)
+{
+    if (!state.generation || !size)
+        return 0;
+
+    frame_scratch_record* record = frame_scratch_record_get();
+    if (!record)
+        return 0;
+
+    // Catch up on any frame boundaries since this thread last allocated
+    u64 frame = batomic_load_u64(&state.frame);
+    if (record->frame != frame)
+    {
+        if (frame - record->frame == 1)
+        {
+            // Switch arenas. The other one keeps last frame's allocations alive for one more frame
+            record->current ^= 1;
+            record->offsets[record->current] = 0;
+        }
+        else
+        {
+            // Both arenas hold allocations from at least two frames ago
+            record->offsets[0] = 0;
+            record->offsets[1] = 0;
+        }
+        record->frame = frame;
+    }
+
+    u64 aligned_size = (size + FRAME_SCRATCH_ALIGNMENT - 1) & ~((u64)FRAME_SCRATCH_ALIGNMENT - 1);
+    u64 offset = record->offsets[record->current];
+    if (aligned_size > state.arena_size - offset)
+    {
+        batomic_fetch_add_u64(&record->failed_allocations, 1);
+        BERROR("frame_scratch_allocate - Tried to allocate %lluB, only %lluB remaining in this thread's arena", size, state.arena_size - offset);
+        return 0;
+    }
+
+    record->offsets[record->current] = offset + aligned_size;
+    if (offset + aligned_size > batomic_load_relaxed_u64(&record->high_water))
+        batomic_store_relaxed_u64(&record->high_water, offset + aligned_size);
+
+    return record->memory + (state.arena_size * record->current) + offset;
+}
+
+void frame_scratch_thread_release(void)
+{
+    if (!state.generation || thread_scratch_generation != state.generation || !thread_scratch)
+        return;
+
+    batomic_store_u32(&thread_scratch->in_use, 0);
+    thread_scratch = 0;
+    thread_scratch_generation = 0;
+}
+
+static void frame_scratch_interface_free(void* block, u64 size)
+{
+    // NOTE: Scratch memory is reclaimed at frame boundaries, so this is a no-op
+}
+
+static void frame_scratch_interface_free_all(void)
+{
+    // Only the calling thread's current arena. Other threads' arenas are never touched
+    frame_scratch_record* record = state.generation ? frame_scratch_record_get() : 0;
+    if (record)
+        record->offsets[record->current] = 0;
+}
+
+frame_allocator_int frame_scratch_allocator_get(void)
+{
+    frame_allocator_int allocator;
+    allocator.allocate = frame_scratch_allocate;
+    allocator.free = frame_scratch_interface_free;
+    allocator.free_all = frame_scratch_interface_free_all;
+    return allocator;
+}
+
+u32 frame_scratch_stats_get(u32 max_count, frame_scratch_thread_stats* out_stats)
+{
+    if (!state.generation)
+        return 0;
+
+    u32 count = 0;
+    for (u32 i = 0; i < FRAME_SCRATCH_MAX_THREADS; ++i)
+    {
+        frame_scratch_record* record = &state.records[i];
+        if (!batomic_load_u32(&record->in_use))
+            continue;
+
+        if (out_stats && count < max_count)
+        {
+            frame_scratch_thread_stats* stats = &out_stats[count];
+            stats->thread_id = record->thread_id;
+            stats->capacity = state.arena_size;
+            stats->high_water = batomic_load_relaxed_u64(&record->high_water);
+            stats->failed_allocations = batomic_load_relaxed_u64(&record->failed_allocations);
+        }
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+#include "memory/bmemory.h"
+
+/**
+ * @brief Per-thread scratch memory for temporaries which only need to live for about a frame.
+ * Each thread gets its own pair of linear arenas, so allocating is a pointer bump with no locking,
+ * and is safe from job entry points. Arenas are double-buffered: anything allocated during a frame
+ * stays valid through the following frame (i.e. for job completion callbacks), and is reclaimed
+ * the frame after that. Threads switch arenas lazily on their next allocation after a frame boundary.
+ */
+
+/** @brief Usage of a single thread's scratch arenas */
+typedef struct frame_scratch_thread_stats
+{
+    /** @brief The id of the owning thread */
+    u64 thread_id;
+    /** @brief The size of each of the thread's two arenas */
+    u64 capacity;
+    /** @brief The most ever allocated from one arena during a single frame */
+    u64 high_water;
+    /** @brief The number of allocations which did not fit */
+    u64 failed_allocations;
+} frame_scratch_thread_stats;
+
+/**
+ * @brief Sets up the scratch arenas. Arena memory is only reserved once a thread first allocates.
+ *
+ * @param arena_size The size of each arena. Each thread that uses scratch memory gets two of these.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 frame_scratch_initialize(u64 arena_size);
+
+/** @brief Releases all scratch arenas. Nothing may be using scratch memory at this point. */
+BAPI void frame_scratch_shutdown(void);
+
+/** @brief Marks a frame boundary. Should be called once per frame from the main thread, before anything else allocates. */
+BAPI void frame_scratch_frame_advance(void);
+
+/**
+ * @brief Allocates from the calling thread's current arena. The block is 16-byte aligned, not zeroed,
+ * and valid until the end of the next frame. Returns 0 if the arena is full or scratch memory isn't set up.
+ */
+BAPI void* frame_scratch_allocate(u64 size);
+
+/** @brief Gives up the calling thread's arenas so another thread can use them. Threads should call this just before they exit. */
+BAPI void frame_scratch_thread_release(void);
+
+/** @brief Returns an allocator interface over frame_scratch_allocate, which may be passed to darrays and the like. */
+BAPI frame_allocator_int frame_scratch_allocator_get(void);
+
+/**
+ * @brief Obtains usage stats for every thread which currently holds scratch arenas.
+ *
+ * @param max_count The number of entries out_stats can hold.
+ * @param out_stats An array to be filled with per-thread stats. May be 0 to just get the count.
+ * @return The number of threads holding scratch arenas.
+ */
+BAPI u32 frame_scratch_stats_get(u32 max_count, frame_scratch_thread_stats* out_stats);
@@ -0,0 +1,569 @@
+#include "bson_binary.h"
+
+#include "containers/darray.h"
+#include "containers/u64_hashtable.h"
+#include "logger.h"
+#include "memory/bmemory.h"
+#include "strings/bname.h"
+#include "strings/bstring.h"
+#include "utils/crc64.h"
+
+// Everything in the buffer starts on an 8-byte boundary, so records can be read in place
+#define BSON_BINARY_ALIGNMENT 8
+
+typedef struct bson_binary_header
+{
+    u32 magic;
+    u16 version;
+    u16 reserved;
+    // The size of the whole buffer
+    u32 size;
+    u32 root_offset;
+    u32 string_count;
+    // Where the array of string_count bson_binary_strings starts
+    u32 strings_offset;
+    u32 string_data_offset;
+    u32 string_data_size;
+} bson_binary_header;
+
+typedef struct bson_binary_string
+{
+    // The bstring_id of the string
+    u64 id;
+    // Where the string starts, relative to the start of the string data
+    u32 offset;
+    // The length of the string, not including its null terminator
+    u32 length;
+} bson_binary_string;
+
+// Starts every object and array, and is followed by count records
+typedef struct bson_binary_container
+{
+    u32 type;
+    u32 count;
+} bson_binary_container;
+
+typedef struct bson_binary_record
+{
+    // A bson_property_type
+    u8 type;
+    u8 reserved[3];
+    // The index of the name in the string table, or INVALID_ID for array elements
+    u32 name;
+    // Int, float and boolean values are stored directly. Strings store their string index,
+    // and objects and arrays the offset of their container
+    u64 payload;
+} bson_binary_record;
+
+typedef struct bson_binary_writer
+{
+    u8* data;
+    u64 size;
+    u64 capacity;
+
+    // darray of strings, in the order they were first written
+    bson_binary_string* strings;
+    // darray of where each string's contents come from
+    const char** string_sources;
+    // Maps each string's id to its index, so each is only stored once
+    u64_hashtable string_lookup;
+    u64 string_data_size;
+} bson_binary_writer;
+
+// Reserves size bytes (rounded up to the alignment) at the end of the buffer, returning their offset.
+// NOTE: The buffer may move, so only hold on to offsets across calls
+static u64 writer_reserve(bson_binary_writer* writer, u64 size)
+{
+    size = (size + BSON_BINARY_ALIGNMENT - 1) & ~(u64)(BSON_BINARY_ALIGNMENT - 1);
+    if (writer->size + size > writer->capacity)
+    {
+        u64 new_capacity = writer->capacity ? writer->capacity * 2 : KIBIBYTES(4);
+        while (new_capacity < writer->size + size)
+            new_capacity *= 2;
+        // NOTE: The new space comes back zeroed, which keeps padding deterministic
+        writer->data = breallocate(writer->data, writer->capacity, new_capacity, MEMORY_TAG_ARRAY);
+        writer->capacity = new_capacity;
+    }
+    u64 offset = writer->size;
+    writer->size += size;
+    return offset;
+}
+
+// Adds the string to the string table if it isn't already there, returning its index
+static u32 writer_string_add(bson_binary_writer* writer, bstring_id id, const char* str)
+{
+    u32 index;
+    if (u64_hashtable_get(&writer->string_lookup, id, &index))
+        return index;
+
+    bson_binary_string entry = {0};
+    entry.id = id;
+    entry.offset = (u32)writer->string_data_size;
+    entry.length = string_length(str);
+    writer->string_data_size += entry.length + 1;
+
+    index = darray_length(writer->strings);
+    darray_push(writer->strings, entry);
+    darray_push(writer->string_sources, str);
+    u64_hashtable_set(&writer->string_lookup, id, &index);
+    return index;
+}
+
+// Writes the object and everything beneath it, returning the offset of its container or 0 on failure
+static u64 writer_object_write(bson_binary_writer* writer, const bson_object* obj)
+{
+    u32 count = obj->properties ? darray_length(obj->properties) : 0;
+    u64 offset = writer_reserve(writer, sizeof(bson_binary_container) + sizeof(bson_binary_record) * count);
+    bson_binary_container* container = (bson_binary_container*)(writer->data + offset);
+    container->type = obj->type;
+    container->count = count;
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        const bson_property* p = &obj->properties[i];
+        bson_binary_record record = {0};
+        record.type = (u8)p->type;
+        record.name = INVALID_ID;
+        if (p->name != INVALID_BSTRING_ID)
+        {
+            // Names may have come from either a bstring_id or a bname
+            const char* name_str = bstring_id_string_get(p->name);
+            if (!name_str)
+                name_str = bname_string_get(p->name);
+            record.name = writer_string_add(writer, p->name, name_str ? name_str : "");
+        }
+
+        switch (p->type)
+        {
+        case BSON_PROPERTY_TYPE_INT:
+            record.payload = (u64)p->value.i;
+            break;
+        case BSON_PROPERTY_TYPE_FLOAT:
+            bcopy_memory(&record.payload, &p->value.f, sizeof(f32));
+            break;
+        case BSON_PROPERTY_TYPE_BOOLEAN:
+            record.payload = p->value.b ? 1 : 0;
+            break;
+        case BSON_PROPERTY_TYPE_STRING:
+        {
+            const char* str = p->value.s ? p->value.s : "";
+            record.payload = writer_string_add(writer, crc64(0, (const u8*)str, string_length(str)), str);
+        } break;
+        case BSON_PROPERTY_TYPE_OBJECT:
+        case BSON_PROPERTY_TYPE_ARRAY:
+            record.payload = writer_object_write(writer, &p->value.o);
+            if (!record.payload)
+                return 0;
+            break;
+        default:
+        case BSON_PROPERTY_TYPE_UNKNOWN:
+            BERROR("bson_tree_to_binary encountered an unknown property type");
+            return 0;
+        }
+
+        // Written last, as the buffer may have moved while writing children
+        bson_binary_record* records = (bson_binary_record*)(writer->data + offset + sizeof(bson_binary_container));
+        records[i] = record;
+    }
+
+    if (writer->size > U32_MAX)
+    {
+        BERROR("bson_tree_to_binary - tree is too large for the binary format (over 4GiB)");
+        return 0;
+    }
+    return offset;
+}
+
+b8 bson_tree_to_binary(const bson_tree* tree, u64* out_size, void** out_data)
+{
+    if (!tree || !out_size || !out_data)
+    {
+        BERROR("bson_tree_to_binary requires valid pointers to tree, out_size and out_data");
+        return false;
+    }
+
+    bson_binary_writer writer = {0};
+    writer.strings = darray_create(bson_binary_string);
+    writer.string_sources = darray_create(const char*);
+    if (!u64_hashtable_create(sizeof(u32), 0, &writer.string_lookup))
+    {
+        BERROR("bson_tree_to_binary - failed to create string lookup");
+        darray_destroy(writer.strings);
+        darray_destroy(writer.string_sources);
+        return false;
+    }
+
+    b8 result = false;
+    writer_reserve(&writer, sizeof(bson_binary_header));
+    u64 root_offset = writer_object_write(&writer, &tree->root);
+    if (root_offset)
+    {
+        u32 string_count = darray_length(writer.strings);
+        u64 strings_offset = writer_reserve(&writer, sizeof(bson_binary_string) * string_count);
+        bcopy_memory(writer.data + strings_offset, writer.strings, sizeof(bson_binary_string) * string_count);
+
+        u64 string_data_offset = writer_reserve(&writer, writer.string_data_size);
+        for (u32 i = 0; i < string_count; ++i)
+        {
+            // NOTE: The buffer is zeroed, so each string is already null-terminated
+            bcopy_memory(writer.data + string_data_offset + writer.strings[i].offset, writer.string_sources[i], writer.strings[i].length);
+        }
+        // The string data comes last, so there is no need to keep its padding
+        writer.size = string_data_offset + writer.string_data_size;
+
+        if (writer.size > U32_MAX)
+        {
+            BERROR("bson_tree_to_binary - tree is too large for the binary format (over 4GiB)");
+        }
+        else
+        {
+            bson_binary_header* header = (bson_binary_header*)writer.data;
+            header->magic = BSON_BINARY_MAGIC;
+            header->version = BSON_BINARY_VERSION;
+            header->size = (u32)writer.size;
+            header->root_offset = (u32)root_offset;
+            header->string_count = string_count;
+            header->strings_offset = (u32)strings_offset;
+            header->string_data_offset = (u32)string_data_offset;
+            header->string_data_size = (u32)writer.string_data_size;
+
+            // Hand back a block of exactly the right size
+            *out_size = writer.size;
+            *out_data = ballocate(writer.size, MEMORY_TAG_ARRAY);
+            bcopy_memory(*out_data, writer.data, writer.size);
+            result = true;
+        }
+    }
+
+    if (writer.data)
+        bfree(writer.data, writer.capacity, MEMORY_TAG_ARRAY);
+    darray_destroy(writer.strings);
+    darray_destroy(writer.string_sources);
+    u64_hashtable_destroy(&writer.string_lookup);
+    return result;
+}
+
+b8 bson_binary_is_binary(const void* data, u64 size)
+{
+    if (!data || size < sizeof(bson_binary_header))
+        return false;
+    u32 magic;
+    bcopy_memory(&magic, data, sizeof(u32));
+    return magic == BSON_BINARY_MAGIC;
+}
+
+b8 bson_binary_reader_open(const void* data, u64 size, bson_binary_reader* out_reader)
+{
+    if (!data || !out_reader)
+    {
+        BERROR("bson_binary_reader_open requires valid pointers to data and out_reader");
+        return false;
+    }
+    if ((u64)data & (BSON_BINARY_ALIGNMENT - 1))
+    {
+        BERROR("bson_binary_reader_open - data must be %u-byte aligned", BSON_BINARY_ALIGNMENT);
+        return false;
+    }
+    if (!bson_binary_is_binary(data, size))
+    {
+        BERROR("bson_binary_reader_open - data is not binary bson");
+        return false;
+    }
+
+    const bson_binary_header* header = data;
+    if (header->version != BSON_BINARY_VERSION)
+    {
+        BERROR("bson_binary_reader_open - unsupported version %u (expected %u)", header->version, BSON_BINARY_VERSION);
+        return false;
+    }
+    if (header->size > size ||
+        (header->strings_offset & (BSON_BINARY_ALIGNMENT - 1)) ||
+        (u64)header->strings_offset + (u64)header->string_count * sizeof(bson_binary_string) > header->size ||
+        (u64)header->string_data_offset + header->string_data_size > header->size)
+    {
+        BERROR("bson_binary_reader_open - data is truncated or corrupt");
+        return false;
+    }
+
+    const u8* bytes = data;
+    const bson_binary_string* strings = (const bson_binary_string*)(bytes + header->strings_offset);
+    const char* string_data = (const char*)(bytes + header->string_data_offset);
+    // Check every string once up front, so strings can be handed out without checks later
+    for (u32 i = 0; i < header->string_count; ++i)
+    {
+        if ((u64)strings[i].offset + strings[i].length >= header->string_data_size || string_data[strings[i].offset + strings[i].length] != 0)
+        {
+            BERROR("bson_binary_reader_open - string %u is corrupt", i);
+            return false;
+        }
+    }
+
+    out_reader->data = bytes;
+    out_reader->size = header->size;
+    out_reader->string_count = header->string_count;
+    out_reader->strings = strings;
+    out_reader->string_data = string_data;
+    out_reader->root_offset = header->root_offset;
+    return true;
+}
+
+// Obtains the container at the given offset, checking that it lies within the buffer
+static b8 reader_container_get(const bson_binary_reader* reader, u64 offset, bson_binary_object* out_object)
+{
+    if ((offset & (BSON_BINARY_ALIGNMENT - 1)) || offset + sizeof(bson_binary_container) > reader->size)
+    {
+        BERROR("bson binary container offset %llu is out of range", offset);
+        return false;
+    }
+    const bson_binary_container* container = (const bson_binary_container*)(reader->data + offset);
+    if (container->type > BSON_OBJECT_TYPE_ARRAY ||
+        offset + sizeof(bson_binary_container) + (u64)container->count * sizeof(bson_binary_record) > reader->size)
+    {
+        BERROR("bson binary container at offset %llu is corrupt", offset);
+        return false;
+    }
+
+    out_object->reader = reader;
+    out_object->type = container->type;
+    out_object->count = container->count;
+    out_object->records = (const bson_binary_record*)(container + 1);
+    return true;
+}
+
+b8 bson_binary_reader_root_get(const bson_binary_reader* reader, bson_binary_object* out_root)
+{
+    if (!reader || !out_root)
+    {
+        BERROR("bson_binary_reader_root_get requires valid pointers to reader and out_root");
+        return false;
+    }
+    return reader_container_get(reader, reader->root_offset, out_root);
+}
+
+b8 bson_binary_object_property_at(const bson_binary_object* object, u32 index, bson_binary_value* out_value)
+{
+    if (!object || !out_value || index >= object->count)
+        return false;
+
+    const bson_binary_reader* reader = object->reader;
+    const bson_binary_record* record = &object->records[index];
+    out_value->type = record->type;
+    out_value->name = INVALID_BSTRING_ID;
+    if (record->name != INVALID_ID)
+    {
+        if (record->name >= reader->string_count)
+        {
+            BERROR("bson binary property name index %u is out of range", record->name);
+            return false;
+        }
+        out_value->name = reader->strings[record->name].id;
+    }
+
+    switch (record->type)
+    {
+    case BSON_PROPERTY_TYPE_INT:
+        out_value->value.i = (i64)record->payload;
+        return true;
+    case BSON_PROPERTY_TYPE_FLOAT:
+        bcopy_memory(&out_value->value.f, &record->payload, sizeof(f32));
+        return true;
+    case BSON_PROPERTY_TYPE_BOOLEAN:
+        out_value->value.b = record->payload != 0;
+        return true;
+    case BSON_PROPERTY_TYPE_STRING:
+        if (record->payload >= reader->string_count)
+        {
+            BERROR("bson binary string index %llu is out of range", record->payload);
+            return false;
+        }
+        out_value->value.s = reader->string_data + reader->strings[record->payload].offset;
+        return true;
+    case BSON_PROPERTY_TYPE_OBJECT:
+    case BSON_PROPERTY_TYPE_ARRAY:
+    {
+        // The writer always places children after their parent. Anything else could point back at the container
+        // itself or an ancestor, and send anything walking the tree into endless recursion
+        u64 parent_offset = (u64)((const u8*)object->records - reader->data) - sizeof(bson_binary_container);
+        if (record->payload <= parent_offset)
+        {
+            BERROR("bson binary container offset %llu does not follow its parent at %llu", record->payload, parent_offset);
+            return false;
+        }
+        if (!reader_container_get(reader, record->payload, &out_value->value.o))
+            return false;
+        bson_object_type expected = record->type == BSON_PROPERTY_TYPE_OBJECT ? BSON_OBJECT_TYPE_OBJECT : BSON_OBJECT_TYPE_ARRAY;
+        if (out_value->value.o.type != expected)
+        {
+            BERROR("bson binary property type does not match its container");
+            return false;
+        }
+        return true;
+    }
+    default:
+        BERROR("bson binary property has unknown type %u", record->type);
+        return false;
+    }
+}
+
+b8 bson_binary_object_property_find(const bson_binary_object* object, bstring_id name, bson_binary_value* out_value)
+{
+    if (!object || !out_value || name == INVALID_BSTRING_ID)
+        return false;
+
+    const bson_binary_reader* reader = object->reader;
+    for (u32 i = 0; i < object->count; ++i)
+    {
+        u32 name_index = object->records[i].name;
+        if (name_index < reader->string_count && reader->strings[name_index].id == name)
+            return bson_binary_object_property_at(object, i, out_value);
+    }
+    return false;
+}
+
+static b8 binary_property_find_by_name(const bson_binary_object* object, const char* name, bson_binary_value* out_value)
+{
+    return bson_binary_object_property_find(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_binary_object_value_get_int(const bson_binary_object* object, const char* name, i64* out_value)
+{
+    bson_binary_value value;
+    if (!out_value || !binary_property_find_by_name(object, name, &value))
+        return false;
+    if (value.type == BSON_PROPERTY_TYPE_INT)
+        *out_value = value.value.i;
+    else if (value.type == BSON_PROPERTY_TYPE_FLOAT)
+        *out_value = (i64)value.value.f;
+    else
+        return false;
+    return true;
+}
+
+b8 bson_binary_object_value_get_float(const bson_binary_object* object, const char* name, f32* out_value)
+{
+    bson_binary_value value;
+    if (!out_value || !binary_property_find_by_name(object, name, &value))
+        return false;
+    if (value.type == BSON_PROPERTY_TYPE_FLOAT)
+        *out_value = value.value.f;
+    else if (value.type == BSON_PROPERTY_TYPE_INT)
+        *out_value = (f32)value.value.i;
+    else
+        return false;
+    return true;
+}
+
+b8 bson_binary_object_value_get_bool(const bson_binary_object* object, const char* name, b8* out_value)
+{
+    bson_binary_value value;
+    if (!out_value || !binary_property_find_by_name(object, name, &value) || value.type != BSON_PROPERTY_TYPE_BOOLEAN)
+        return false;
+    *out_value = value.value.b;
+    return true;
+}
+
+b8 bson_binary_object_value_get_string(const bson_binary_object* object, const char* name, const char** out_value)
+{
+    bson_binary_value value;
+    if (!out_value || !binary_property_find_by_name(object, name, &value) || value.type != BSON_PROPERTY_TYPE_STRING)
+        return false;
+    *out_value = value.value.s;
+    return true;
+}
+
+b8 bson_binary_object_value_get_object(const bson_binary_object* object, const char* name, bson_binary_object* out_value)
+{
+    bson_binary_value value;
+    if (!out_value || !binary_property_find_by_name(object, name, &value))
+        return false;
+    if (value.type != BSON_PROPERTY_TYPE_OBJECT && value.type != BSON_PROPERTY_TYPE_ARRAY)
+        return false;
+    *out_value = value.value.o;
+    return true;
+}
+
+// Copies every property of the binary object into the (empty) tree object
+static b8 binary_object_to_tree(const bson_binary_object* source, bson_object* dest)
+{
+    const bson_binary_reader* reader = source->reader;
+    for (u32 i = 0; i < source->count; ++i)
+    {
+        bson_binary_value value;
+        if (!bson_binary_object_property_at(source, i, &value))
+            return false;
+
+        const char* name = 0;
+        if (dest->type == BSON_OBJECT_TYPE_OBJECT)
+        {
+            u32 name_index = source->records[i].name;
+            if (name_index >= reader->string_count)
+            {
+                BERROR("bson_tree_from_binary - object property %u has no name", i);
+                return false;
+            }
+            name = reader->string_data + reader->strings[name_index].offset;
+        }
+
+        b8 added = false;
+        switch (value.type)
+        {
+        case BSON_PROPERTY_TYPE_INT:
+            added = name ? bson_object_value_add_int(dest, name, value.value.i) : bson_array_value_add_int(dest, value.value.i);
+            break;
+        case BSON_PROPERTY_TYPE_FLOAT:
+            added = name ? bson_object_value_add_float(dest, name, value.value.f) : bson_array_value_add_float(dest, value.value.f);
+            break;
+        case BSON_PROPERTY_TYPE_BOOLEAN:
+            added = name ? bson_object_value_add_boolean(dest, name, value.value.b) : bson_array_value_add_boolean(dest, value.value.b);
+            break;
+        case BSON_PROPERTY_TYPE_STRING:
+            added = name ? bson_object_value_add_string(dest, name, value.value.s) : bson_array_value_add_string(dest, value.value.s);
+            break;
+        case BSON_PROPERTY_TYPE_OBJECT:
+        case BSON_PROPERTY_TYPE_ARRAY:
+        {
+            bson_object child = value.type == BSON_PROPERTY_TYPE_OBJECT ? bson_object_create() : bson_array_create();
+            if (!binary_object_to_tree(&value.value.o, &child))
+            {
+                bson_object_cleanup(&child);
+                return false;
+            }
+            if (value.type == BSON_PROPERTY_TYPE_OBJECT)
+                added = name ? bson_object_value_add_object(dest, name, child) : bson_array_value_add_object(dest, child);
+            else
+                added = name ? bson_object_value_add_array(dest, name, child) : bson_array_value_add_array(dest, child);
+            if (!added)
+                bson_object_cleanup(&child);
+        } break;
+        default:
+            break;
+        }
+
+        if (!added)
+            return false;
+    }
+    return true;
+}
+
+b8 bson_tree_from_binary(const void* data, u64 size, bson_tree* out_tree)
+{
+    if (!out_tree)
+    {
+        BERROR("bson_tree_from_binary requires a valid pointer to out_tree");
+        return false;
+    }
+
+    bson_binary_reader reader;
+    bson_binary_object root;
+    if (!bson_binary_reader_open(data, size, &reader) || !bson_binary_reader_root_get(&reader, &root))
+        return false;
+
+    out_tree->root = bson_object_create();
+    if (!binary_object_to_tree(&root, &out_tree->root))
+    {
+        BERROR("bson_tree_from_binary - failed to build tree. See logs for details");
+        bson_tree_cleanup(out_tree);
+        return false;
+    }
+    return true;
+}
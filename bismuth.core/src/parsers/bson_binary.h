@@ -0,0 +1,191 @@
+#pragma once
+
+#include "defines.h"
+#include "parsers/bson_parser.h"
+#include "strings/bstring_id.h"
+
+/**
+ * Binary bson is a compact form of a bson_tree, made to be read directly from the
+ * buffer it was loaded (or mapped) into, with no parsing and no allocation.
+ *
+ * Layout (little-endian, all offsets are from the start of the buffer):
+ * - A header, identifying the format and locating everything else.
+ * - Containers (objects and arrays): a type and property count, followed by one fixed-size,
+ *   type-tagged record per property. Records hold their value inline, or the index of a string,
+ *   or the offset of a child container.
+ * - A string table holding each unique name and string value once, along with its precomputed
+ *   bstring_id, so properties can be found by comparing ids rather than strings.
+ * - The string data itself, null-terminated so strings can be handed out in place.
+ */
+
+/** @brief Identifies a binary bson buffer. "BSNB" when read as bytes. */
+#define BSON_BINARY_MAGIC 0x424E5342
+/** @brief The current version of the binary bson format. */
+#define BSON_BINARY_VERSION 1
+
+struct bson_binary_string;
+struct bson_binary_record;
+
+/**
+ * @brief Reads a binary bson buffer in place. The buffer must outlive the reader and anything
+ * obtained from it, including strings. Obtained from bson_binary_reader_open(); nothing needs to be cleaned up.
+ */
+typedef struct bson_binary_reader
+{
+    const u8* data;
+    u64 size;
+    u32 string_count;
+    const struct bson_binary_string* strings;
+    const char* string_data;
+    u32 root_offset;
+} bson_binary_reader;
+
+/**
+ * @brief An object or array within a binary bson buffer. Just a view of the buffer, so it may be copied freely.
+ */
+typedef struct bson_binary_object
+{
+    const bson_binary_reader* reader;
+    bson_object_type type;
+    // The number of properties (or elements, for arrays)
+    u32 count;
+    const struct bson_binary_record* records;
+} bson_binary_object;
+
+/** @brief A single property read from a binary bson object or array. */
+typedef struct bson_binary_value
+{
+    bson_property_type type;
+    // The name of the property. INVALID_BSTRING_ID for array elements
+    bstring_id name;
+    union
+    {
+        i64 i;
+        f32 f;
+        b8 b;
+        // Points into the buffer. Never null; empty strings are ""
+        const char* s;
+        // Used for both objects and arrays
+        bson_binary_object o;
+    } value;
+} bson_binary_value;
+
+/**
+ * @brief Writes the given tree out in binary form.
+ *
+ * @param tree A constant pointer to the tree to write. Required.
+ * @param out_size A pointer to hold the size of the written data in bytes. Required.
+ * @param out_data A pointer to hold the written data. Free with bfree(data, size, MEMORY_TAG_ARRAY). Required.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 bson_tree_to_binary(const bson_tree* tree, u64* out_size, void** out_data);
+
+/**
+ * @brief Builds a bson_tree from binary data, for code which needs to modify it or works with trees.
+ * Reading through bson_binary_reader_open() instead avoids all parsing and allocation.
+ *
+ * @param data The binary data. Must be 8-byte aligned. Required.
+ * @param size The size of the data in bytes.
+ * @param out_tree A pointer to hold the built tree. Clean up with bson_tree_cleanup(). Required.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 bson_tree_from_binary(const void* data, u64 size, bson_tree* out_tree);
+
+/**
+ * @brief Indicates if the given data starts with a binary bson header, i.e. to tell binary files from text.
+ *
+ * @param data The data to check.
+ * @param size The size of the data in bytes.
+ * @return True if the data looks like binary bson; otherwise false.
+ */
+BAPI b8 bson_binary_is_binary(const void* data, u64 size);
+
+/**
+ * @brief Prepares to read the given binary data in place. Checks the header and string table,
+ * but does not parse or copy anything. Containers are bounds-checked as they are reached.
+ *
+ * @param data The binary data. Must be 8-byte aligned, as any buffer from ballocate() or a mapped file is. Required.
+ * @param size The size of the data in bytes.
+ * @param out_reader A pointer to hold the reader. Required.
+ * @return True if the data is valid binary bson; otherwise false.
+ */
+BAPI b8 bson_binary_reader_open(const void* data, u64 size, bson_binary_reader* out_reader);
+
+/**
+ * @brief Obtains the root object of the given reader.
+ *
+ * @param reader A constant pointer to the reader. Must remain valid while the object is used. Required.
+ * @param out_root A pointer to hold the root object. Required.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 bson_binary_reader_root_get(const bson_binary_reader* reader, bson_binary_object* out_root);
+
+/**
+ * @brief Reads the property (or array element) at the given index.
+ *
+ * @param object A constant pointer to the object or array. Required.
+ * @param index The index of the property. Must be less than the object's count.
+ * @param out_value A pointer to hold the property. Required.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 bson_binary_object_property_at(const bson_binary_object* object, u32 index, bson_binary_value* out_value);
+
+/**
+ * @brief Finds the property with the given name. Compares ids only, so no strings are touched.
+ *
+ * @param object A constant pointer to the object. Required.
+ * @param name The id of the name to look for, i.e. from bson_property_name_id() or bstring_id_create().
+ * @param out_value A pointer to hold the property. Required.
+ * @return True if found; otherwise false.
+ */
+BAPI b8 bson_binary_object_property_find(const bson_binary_object* object, bstring_id name, bson_binary_value* out_value);
+
+/**
+ * @brief Obtains the value of the named integer property. Floats are converted.
+ *
+ * @param object A constant pointer to the object. Required.
+ * @param name The name of the property. Required.
+ * @param out_value A pointer to hold the value. Required.
+ * @return True if found and of a compatible type; otherwise false.
+ */
+BAPI b8 bson_binary_object_value_get_int(const bson_binary_object* object, const char* name, i64* out_value);
+
+/**
+ * @brief Obtains the value of the named float property. Integers are converted.
+ *
+ * @param object A constant pointer to the object. Required.
+ * @param name The name of the property. Required.
+ * @param out_value A pointer to hold the value. Required.
+ * @return True if found and of a compatible type; otherwise false.
+ */
+BAPI b8 bson_binary_object_value_get_float(const bson_binary_object* object, const char* name, f32* out_value);
+
+/**
+ * @brief Obtains the value of the named boolean property.
+ *
+ * @param object A constant pointer to the object. Required.
+ * @param name The name of the property. Required.
+ * @param out_value A pointer to hold the value. Required.
+ * @return True if found and a boolean; otherwise false.
+ */
+BAPI b8 bson_binary_object_value_get_bool(const bson_binary_object* object, const char* name, b8* out_value);
+
+/**
+ * @brief Obtains the value of the named string property. The string points into the buffer; do not free it.
+ *
+ * @param object A constant pointer to the object. Required.
+ * @param name The name of the property. Required.
+ * @param out_value A pointer to hold the string. Required.
+ * @return True if found and a string; otherwise false.
+ */
+BAPI b8 bson_binary_object_value_get_string(const bson_binary_object* object, const char* name, const char** out_value);
+
+/**
+ * @brief Obtains the named object or array property.
+ *
+ * @param object A constant pointer to the object. Required.
+ * @param name The name of the property. Required.
+ * @param out_value A pointer to hold the object or array. Required.
+ * @return True if found and an object or array; otherwise false.
+ */
+BAPI b8 bson_binary_object_value_get_object(const bson_binary_object* object, const char* name, bson_binary_object* out_value);
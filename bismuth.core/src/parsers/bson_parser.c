@@ -2,12 +2,15 @@
 
 #include "containers/darray.h"
 #include "containers/stack.h"
+#include "containers/u64_hashtable.h"
 #include "debug/bassert.h"
 #include "logger.h"
 #include "memory/bmemory.h"
 #include "strings/bname.h"
 #include "strings/bstring.h"
 #include "strings/bstring_id.h"
+#include "strings/bstring_scan.h"
+#include "utils/crc64.h"
 
 const char* bson_property_type_to_string(bson_property_type type)
 {
@@ -31,6 +34,187 @@ const char* bson_property_type_to_string(bson_property_type type)
     }
 }
 
+typedef struct bson_object_index
+{
+    // The number of properties indexed so far. Properties are only ever appended, so any beyond this are added on the next lookup
+    u32 built_count;
+    // Maps property names to their index in the properties darray
+    u64_hashtable lookup;
+} bson_object_index;
+
+// Attaches an (unbuilt) index to the object if it has become big enough to need one
+static void bson_object_index_attach(bson_object* object)
+{
+    if (object->index || object->type != BSON_OBJECT_TYPE_OBJECT || !object->properties)
+        return;
+    if (darray_length(object->properties) < BSON_OBJECT_INDEX_MIN_PROPERTIES)
+        return;
+
+    bson_object_index* index = ballocate(sizeof(bson_object_index), MEMORY_TAG_HASHTABLE);
+    if (!u64_hashtable_create(sizeof(u32), BSON_OBJECT_INDEX_MIN_PROPERTIES * 2, &index->lookup))
+    {
+        BWARN("Failed to create bson object index, property lookups on this object will be linear");
+        bfree(index, sizeof(bson_object_index), MEMORY_TAG_HASHTABLE);
+        return;
+    }
+    object->index = index;
+}
+
+static void bson_object_index_destroy(bson_object* object)
+{
+    if (object->index)
+    {
+        u64_hashtable_destroy(&object->index->lookup);
+        bfree(object->index, sizeof(bson_object_index), MEMORY_TAG_HASHTABLE);
+        object->index = 0;
+    }
+}
+
+// Pushes a property onto an object, attaching an index once the object is big enough
+static void bson_object_property_push(bson_object* object, bson_property property)
+{
+    if (!object->properties)
+        object->properties = darray_create(bson_property);
+    darray_push(object->properties, property);
+    if (!object->index)
+        bson_object_index_attach(object);
+}
+
+// Brings the index up to date with the object's properties
+static void bson_object_index_update(bson_object_index* index, const bson_property* properties, u32 count)
+{
+    if (count < index->built_count)
+    {
+        // Properties were removed outside of the bson functions, so start over
+        u64_hashtable_clear(&index->lookup);
+        index->built_count = 0;
+    }
+
+    u64_hashtable_reserve(&index->lookup, count);
+    for (u32 i = index->built_count; i < count; ++i)
+    {
+        // If a name is repeated, the first property with it wins, same as a linear scan
+        if (properties[i].name != INVALID_BSTRING_ID && !u64_hashtable_contains(&index->lookup, properties[i].name))
+            u64_hashtable_set(&index->lookup, properties[i].name, &i);
+    }
+    index->built_count = count;
+}
+
+bstring_id bson_property_name_id(const char* name)
+{
+    if (!name)
+        return INVALID_BSTRING_ID;
+    // NOTE: Hashes the same way as bstring_id_create(), but without copying or registering the string
+    u64 length = string_length(name);
+    return length ? crc64(0, (const u8*)name, length) : INVALID_BSTRING_ID;
+}
+
+// Obtains a name for the given id for use in log messages
+static const char* bson_property_name_for_log(bstring_id name)
+{
+    const char* str = bstring_id_string_get(name);
+    return str ? str : "<unregistered>";
+}
+
+static i32 bson_object_property_index_get_by_id(const bson_object* object, bstring_id name)
+{
+    if (!object || !object->properties || name == INVALID_BSTRING_ID)
+        return -1;
+
+    u32 count = darray_length(object->properties);
+    bson_object_index* index = object->index;
+    if (index)
+    {
+        // NOTE: Properties may also be pushed directly onto the darray, so check the index is current rather than relying on the add functions
+        if (index->built_count != count)
+            bson_object_index_update(index, object->properties, count);
+
+        u32 property_index;
+        if (u64_hashtable_get(&index->lookup, name, &property_index))
+            return (i32)property_index;
+        return -1;
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (object->properties[i].name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+typedef enum bson_tokenize_mode
+{
+    BSON_TOKENIZE_MODE_UNKNOWN,
+    BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER,
+    BSON_TOKENIZE_MODE_WHITESPACE,
+    BSON_TOKENIZE_MODE_STRING_LITERAL,
+    BSON_TOKENIZE_MODE_NUMERIC_LITERAL,
+    BSON_TOKENIZE_MODE_BOOLEAN,
+    BSON_TOKENIZE_MODE_OPERATOR
+} bson_tokenize_mode;
+
+#define NUMERIC_LITERAL_STR_MAX_LENGTH 64
+#define IDENTIFIER_MAX_LENGTH 512
+
+// Everything needed to keep building a tree one token at a time
+typedef struct bson_parse_state
+{
+    bson_tree* tree;
+    // Stack of bson_object pointers. The top is the object currently being populated
+    stack scope;
+    bson_object* current_object;
+    bson_property* current_property;
+
+    b8 expect_identifier;
+    b8 expect_value;
+    b8 expect_operator;
+    b8 expect_numeric;
+
+    char numeric_literal_str[NUMERIC_LITERAL_STR_MAX_LENGTH];
+    u32 numeric_literal_str_pos;
+    i32 numeric_decimal_pos;
+
+    // The type of the last token which wasn't whitespace
+    bson_token_type last_type;
+    // A minus or dot which is only valid if a numeric literal comes next. Checked when the next token arrives
+    bson_token_type pending_type;
+    u32 pending_position;
+} bson_parse_state;
+
+// Turns text into tokens. Can be stopped at the end of any chunk of text and resumed with the next
+typedef struct bson_scanner
+{
+    bson_tokenize_mode mode;
+    // The token being built. Its start and end are offsets into the whole document
+    bson_token current;
+    // The previous two characters, used to find escaped quotes
+    char prev;
+    char prev2;
+    b8 in_comment;
+    b8 eof_reached;
+    // The document offset of the first character of the text being scanned
+    u32 base;
+    // The document offset of the next character to be scanned
+    u32 position;
+
+    // Where completed tokens go: either parsed straight away, or collected into the parser's tokens array
+    bson_parse_state* target;
+    bson_parser* parser;
+} bson_scanner;
+
+typedef struct bson_stream_state
+{
+    bson_scanner scanner;
+    bson_parse_state parse;
+    // The text still needed by the scanner: the unfinished token at the end of the last chunk, followed by anything not yet scanned
+    char* window;
+    u64 window_length;
+    u64 window_capacity;
+    b8 failed;
+} bson_stream_state;
+
 b8 bson_parser_create(bson_parser* out_parser)
 {
     if (!out_parser)
@@ -42,14 +226,38 @@ b8 bson_parser_create(bson_parser* out_parser)
     out_parser->position = 0;
     out_parser->tokens = darray_create(bson_token);
     out_parser->file_content = 0;
+    out_parser->stream = 0;
 
     return true;
 }
 
+#ifdef BISMUTH_DEBUG
+static void bson_parser_token_contents_free(bson_parser* parser)
+{
+    u32 token_count = darray_length(parser->tokens);
+    for (u32 i = 0; i < token_count; ++i)
+    {
+        if (parser->tokens[i].content)
+        {
+            string_free(parser->tokens[i].content);
+            parser->tokens[i].content = 0;
+        }
+    }
+}
+#endif
+
+static void bson_parser_stream_state_destroy(bson_parser* parser);
+
 void bson_parser_destroy(bson_parser* parser)
 {
     if (parser)
     {
+        if (parser->stream)
+        {
+            if (parser->stream->parse.tree)
+                bson_tree_cleanup(parser->stream->parse.tree);
+            bson_parser_stream_state_destroy(parser);
+        }
         if (parser->file_content)
         {
             string_free((char*)parser->file_content);
@@ -57,6 +265,9 @@ void bson_parser_destroy(bson_parser* parser)
         }
         if (parser->tokens)
         {
+#ifdef BISMUTH_DEBUG
+            bson_parser_token_contents_free(parser);
+#endif
             darray_destroy(parser->tokens);
             parser->tokens = 0;
         }
@@ -64,212 +275,604 @@ void bson_parser_destroy(bson_parser* parser)
     }
 }
 
-typedef enum bson_tokenize_mode
+// Makes a null-terminated copy of the given token text
+static char* bson_token_text_duplicate(const char* text, u32 length)
 {
-    BSON_TOKENIZE_MODE_UNKNOWN,
-    BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER,
-    BSON_TOKENIZE_MODE_WHITESPACE,
-    BSON_TOKENIZE_MODE_STRING_LITERAL,
-    BSON_TOKENIZE_MODE_NUMERIC_LITERAL,
-    BSON_TOKENIZE_MODE_BOOLEAN,
-    BSON_TOKENIZE_MODE_OPERATOR
-} bson_tokenize_mode;
+    char* str = ballocate(sizeof(char) * (length + 1), MEMORY_TAG_STRING);
+    bcopy_memory(str, text, length);
+    str[length] = 0;
+    return str;
+}
 
-// Resets both the current token type and the tokenize mode to unknown
-static void reset_current_token_and_mode(bson_token* current_token, bson_tokenize_mode* mode)
+static void bson_parse_state_begin(bson_parse_state* state, bson_tree* out_tree)
 {
-    current_token->type = BSON_TOKEN_TYPE_UNKNOWN;
-    current_token->start = 0;
-    current_token->end = 0;
-#ifdef BISMUTH_DEBUG
-    current_token->content = 0;
-#endif
+    bzero_memory(state, sizeof(bson_parse_state));
+    state->tree = out_tree;
+    stack_create(&state->scope, sizeof(bson_object*));
+
+    // Setup the tree
+    out_tree->root = (bson_object){0};
+    out_tree->root.type = BSON_OBJECT_TYPE_OBJECT;
+    out_tree->root.properties = darray_create(bson_property);
 
-    *mode = BSON_TOKENIZE_MODE_UNKNOWN;
+    // Set it as the current object
+    state->current_object = &out_tree->root;
+    stack_push(&state->scope, &state->current_object);
+
+    // The first thing expected is an identifier
+    state->expect_identifier = true;
+    state->numeric_decimal_pos = -1;
+    state->last_type = BSON_TOKEN_TYPE_UNKNOWN;
+    state->pending_type = BSON_TOKEN_TYPE_UNKNOWN;
 }
 
-#ifdef BISMUTH_DEBUG
-static void _populate_token_content(bson_token* t, const char* source)
-{
-    BASSERT_MSG(t->start <= t->end, "Token start comes after token end!");
-    char buffer[512] = {0};
-    BASSERT_MSG((t->end - t->start) < 512, "token won't fit in buffer");
-    string_mid(buffer, source, t->start, t->end - t->start);
-    t->content = string_duplicate(buffer);
-}
-#define POPULATE_TOKEN_CONTENT(t, source) _populate_token_content(t, source)
-#else
-// No-op
-#define POPULATE_TOKEN_CONTENT(t, source)
-#endif
+static void bson_parse_state_end(bson_parse_state* state)
+{
+    stack_destroy(&state->scope);
+    state->current_object = 0;
+    state->current_property = 0;
+}
 
-// Pushes the current token, if not of unknown type
-static void push_token(bson_token* t, bson_parser* parser)
+// Adds the value as a new element if the current object is an array, or assigns it to the current property otherwise
+static b8 bson_parse_value_set(bson_parse_state* state, bson_property_type type, bson_property_value value, u32 position)
 {
-    if (t->type != BSON_TOKEN_TYPE_UNKNOWN && (t->end - t->start > 0))
+    if (state->current_object->type == BSON_OBJECT_TYPE_ARRAY)
+    {
+        // Apply the value directly to a newly-created, non-named property that gets added to current_object
+        bson_property p = {0};
+        p.type = type;
+        p.value = value;
+        p.name = INVALID_BSTRING_ID;
+        darray_push(state->current_object->properties, p);
+    }
+    else
     {
-        POPULATE_TOKEN_CONTENT(t, parser->file_content);
-        darray_push(parser->tokens, *t);
+        if (!state->current_property)
+        {
+            BERROR("Found a value with no property to assign it to. Position: %u", position);
+            return false;
+        }
+        state->current_property->type = type;
+        state->current_property->value = value;
     }
+
+    return true;
 }
 
-b8 bson_parser_tokenize(bson_parser* parser, const char* source)
+// Converts the numeric literal built so far into an int or float, and sets it as the current value
+static b8 bson_parse_numeric_commit(bson_parse_state* state, u32 position)
 {
-    if (!parser)
+    bson_property_value value = {0};
+    bson_property_type type;
+    // Determine whether it is a float or a int
+    if (state->numeric_decimal_pos != -1)
     {
-        BERROR("bson_parser_tokenize requires valid pointer to out_parser!");
-        return false;
+        f32 f_value = 0;
+        if (string_parse_f32(state->numeric_literal_str, state->numeric_literal_str_pos, &f_value) != state->numeric_literal_str_pos)
+        {
+            BERROR("Failed to parse string to float: '%s', Position: %u", state->numeric_literal_str, position);
+            return false;
+        }
+        value.f = f_value;
+        type = BSON_PROPERTY_TYPE_FLOAT;
     }
-    if (!source)
+    else
     {
-        BERROR("bson_parser_tokenize requires valid pointer to source!");
+        i64 i_value = 0;
+        if (string_scan_parse_i64(state->numeric_literal_str, state->numeric_literal_str_pos, &i_value) != state->numeric_literal_str_pos)
+        {
+            BERROR("Failed to parse string to signed int: '%s', Position: %u", state->numeric_literal_str, position);
+            return false;
+        }
+        value.i = i_value;
+        type = BSON_PROPERTY_TYPE_INT;
+    }
+
+    if (!bson_parse_value_set(state, type, value, position))
+        return false;
+
+    // Reset the numeric parse string state
+    bzero_memory(state->numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
+    state->expect_numeric = false;
+    state->numeric_decimal_pos = -1;
+    state->numeric_literal_str_pos = 0;
+    return true;
+}
+
+// Appends the given text to the numeric literal being built
+static b8 bson_parse_numeric_append(bson_parse_state* state, const char* text, u32 length, u32 position)
+{
+    if (state->numeric_literal_str_pos + length >= NUMERIC_LITERAL_STR_MAX_LENGTH)
+    {
+        BERROR("Numeric literal is too long. Position: %u", position);
         return false;
     }
+    bcopy_memory(state->numeric_literal_str + state->numeric_literal_str_pos, text, length);
+    state->numeric_literal_str_pos += length;
+    return true;
+}
 
-    if (parser->file_content)
-        string_free((char*)parser->file_content);
-    parser->file_content = string_duplicate(source);
+// Starts a new object or array, either as the value of the current property or as an element of the current array
+static b8 bson_parse_object_open(bson_parse_state* state, bson_object_type type, u32 position)
+{
+    bson_object new_obj = {0};
+    new_obj.type = type;
+    new_obj.properties = darray_create(bson_property);
+    bson_property_type property_type = type == BSON_OBJECT_TYPE_OBJECT ? BSON_PROPERTY_TYPE_OBJECT : BSON_PROPERTY_TYPE_ARRAY;
+
+    if (state->current_object->type == BSON_OBJECT_TYPE_ARRAY)
+    {
+        // Apply the value directly to a newly-created, non-named property that gets added to current_object
+        bson_property unnamed_array_prop = {0};
+        unnamed_array_prop.type = property_type;
+        unnamed_array_prop.value.o = new_obj;
+        unnamed_array_prop.name = INVALID_BSTRING_ID;
+        darray_push(state->current_object->properties, unnamed_array_prop);
+        // The current object is now new_obj
+        u32 prop_length = darray_length(state->current_object->properties);
+        state->current_object = &state->current_object->properties[prop_length - 1].value.o;
+    }
+    else
+    {
+        if (!state->current_property)
+        {
+            darray_destroy(new_obj.properties);
+            BERROR("Found an object or array with no property to assign it to. Position: %u", position);
+            return false;
+        }
+        // The object becomes the value of the current property, which means it is now of type object/array
+        state->current_property->value.o = new_obj;
+        state->current_property->type = property_type;
+        state->current_object = &state->current_property->value.o;
+    }
 
-    // Ensure the parser's tokens array is empty
-    darray_clear(parser->tokens);
+    // Add the newly-updated current_object to the stack
+    stack_push(&state->scope, &state->current_object);
+    return true;
+}
 
-    u32 char_length = string_length(source);
+// Ends the current object or array, making its parent current again
+static b8 bson_parse_object_close(bson_parse_state* state)
+{
+    bson_object* popped_obj = 0;
+    if (state->scope.element_count < 2 || !stack_pop(&state->scope, &popped_obj))
+    {
+        BERROR("Failed to pop from scope stack");
+        return false;
+    }
 
-    bson_tokenize_mode mode = BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER;
-    bson_token current_token = {0};
-    // The previous codepoint
-    i32 prev_codepoint = 0;
-    // The codepoint from 2 iterations ago
-    i32 prev_codepoint2 = 0;
+    // Peek the next object on the stack and make it the current object
+    if (!stack_peek(&state->scope, &state->current_object))
+    {
+        BERROR("Failed to peek scope stack");
+        return false;
+    }
 
-    b8 eof_reached = false;
+    state->expect_value = state->current_object->type == BSON_OBJECT_TYPE_ARRAY;
+    return true;
+}
 
-    // Take the length in chars and get the correct codepoint from it
-    i32 codepoint = 0;
-    for (u32 c = 0; c < char_length; prev_codepoint2 = prev_codepoint, prev_codepoint = codepoint)
+static b8 ensure_identifier(b8 expect_identifier, const bson_token* current_token, const char* token_string)
+{
+    if (expect_identifier)
     {
-        if (eof_reached)
-            break;
+        BERROR("Expected identifier, instead found '%s'. Position: %u", token_string, current_token->start);
+        return false;
+    }
 
-        codepoint = source[c];
-        // How many bytes to advance
-        u8 advance = 1;
-        // NOTE: UTF-8 codepoint handling
-        if (!bytes_to_codepoint(source, c, &codepoint, &advance))
-        {
-            BWARN("Invalid UTF-8 found in string, using unknown codepoint of -1");
-            codepoint = -1;
-        }
+    return true;
+}
+
+// Applies a single token to the tree being built. text points to the token's contents, which are only valid during this call
+static b8 bson_parse_token(bson_parse_state* state, const bson_token* token, const char* text)
+{
+    u32 length = token->end - token->start;
+
+    if (token->type == BSON_TOKEN_TYPE_WHITESPACE || token->type == BSON_TOKEN_TYPE_COMMENT)
+        return true;
 
-        if (mode == BSON_TOKENIZE_MODE_STRING_LITERAL)
+    // NOTE: Negatives and leading decimals are only valid for the first character of a numeric literal
+    if (state->pending_type != BSON_TOKEN_TYPE_UNKNOWN)
+    {
+        b8 continues_numeric = token->type == BSON_TOKEN_TYPE_NUMERIC_LITERAL ||
+                               (state->pending_type == BSON_TOKEN_TYPE_OPERATOR_MINUS && token->type == BSON_TOKEN_TYPE_OPERATOR_DOT);
+        if (!continues_numeric)
         {
-            // Handle string literal parsing.
-            // End the string if only if the previous codepoint was NOT a backslash OR
-            // previous codepoint was a backslash AND the one before that was also a backslash.
-            // I.e. it needs to be confirmed that the backslash is NOT already escaped and that the quote is also not escaped.
-            if (codepoint == '"' && (prev_codepoint != '\\' || prev_codepoint2 == '\\'))
+            if (state->pending_type == BSON_TOKEN_TYPE_OPERATOR_MINUS)
             {
-                // Terminate the string, push the token onto the array, and revert modes
-                push_token(&current_token, parser);
-                reset_current_token_and_mode(&current_token, &mode);
+                // TODO: This should be treated as a subtraction operator. Ensure previous token is valid, etc.
+                BERROR("subtraction is not supported at this time");
             }
             else
             {
-                // Handle other characters as part of the string
-                current_token.end += advance;
+                // TODO: Support named object properties such as "sponza.name"
+                BERROR("Dot property operator not supported. Position: %u", state->pending_position);
             }
-            // TODO: Handle other escape sequences like \t, \n, etc.
-
-            // At this point, this codepoint has been handled so continue early
-            c += advance;
-            continue;
+            return false;
         }
+        state->pending_type = BSON_TOKEN_TYPE_UNKNOWN;
+    }
 
-        // Not part of a string, identifier, numeric, etc., so try to figure out what to do next
-        switch (codepoint)
+    switch (token->type)
+    {
+    case BSON_TOKEN_TYPE_CURLY_BRACE_OPEN:
+        // TODO: may be needed to verify object starts at correct place
+        if (!bson_parse_object_open(state, BSON_OBJECT_TYPE_OBJECT, token->start))
+            return false;
+        state->expect_identifier = true;
+        break;
+    case BSON_TOKEN_TYPE_CURLY_BRACE_CLOSE:
+        // TODO: may be needed to verify object ends at correct place
+        if (!bson_parse_object_close(state))
+            return false;
+        break;
+    case BSON_TOKEN_TYPE_BRACKET_OPEN:
+        // TODO: may be needed to verify array starts at correct place
+        if (!bson_parse_object_open(state, BSON_OBJECT_TYPE_ARRAY, token->start))
+            return false;
+        state->expect_value = true;
+        break;
+    case BSON_TOKEN_TYPE_BRACKET_CLOSE:
+        // TODO: may be needed to verify array ends at correct place
+        if (!bson_parse_object_close(state))
+            return false;
+        break;
+    case BSON_TOKEN_TYPE_IDENTIFIER:
+    {
+        if (length >= IDENTIFIER_MAX_LENGTH)
         {
-        case '\n':
+            BERROR("Identifier is too long. Position: %u", token->start);
+            return false;
+        }
+        char buf[IDENTIFIER_MAX_LENGTH];
+        bcopy_memory(buf, text, length);
+        buf[length] = 0;
+        if (!state->expect_identifier)
         {
-            push_token(&current_token, parser);
+            BERROR("Unexpected identifier '%s' at position %u", buf, token->start);
+            return false;
+        }
+        // Start a new property
+        bson_property prop = {0};
+        prop.type = BSON_PROPERTY_TYPE_UNKNOWN;
+        prop.name = bstring_id_create(buf);
+#ifdef BISMUTH_DEBUG
+        prop.name_str = string_duplicate(buf);
+#endif
 
-            // Just create a new token and insert it
-            bson_token newline_token = {BSON_TOKEN_TYPE_NEWLINE, c, c + advance};
+        // Push the new property and set the current property to it
+        bson_object_property_push(state->current_object, prop);
+        u32 prop_count = darray_length(state->current_object->properties);
+        state->current_property = &state->current_object->properties[prop_count - 1];
+
+        // No longer expecting an identifier
+        state->expect_identifier = false;
+        state->expect_operator = true;
+    } break;
+    case BSON_TOKEN_TYPE_OPERATOR_EQUAL:
+        if (!ensure_identifier(state->expect_identifier, token, "="))
+            return false;
 
-            push_token(&newline_token, parser);
+        // Previous token must be an identifier
+        if (state->last_type != BSON_TOKEN_TYPE_IDENTIFIER)
+        {
+            BERROR("Expected identifier before assignment operator. Position: %u", token->start);
+            return false;
+        }
 
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
-        case '\t':
-        case '\r':
-        case ' ':
+        state->expect_operator = false;
+
+        // The next non-whitespace token should be a value of some kind
+        state->expect_value = true;
+        break;
+    case BSON_TOKEN_TYPE_OPERATOR_MINUS:
+        if (state->expect_numeric)
+        {
+            BERROR("Already parsing a numeric, negatives are invalid within a numeric. Position: %u", token->start);
+            return false;
+        }
+
+        // Start of a numeric process, as long as the next token continues it
+        state->expect_numeric = true;
+        bzero_memory(state->numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
+        state->numeric_literal_str[0] = '-';
+        state->numeric_literal_str_pos = 1;
+        state->pending_type = BSON_TOKEN_TYPE_OPERATOR_MINUS;
+        state->pending_position = token->start;
+        break;
+    case BSON_TOKEN_TYPE_OPERATOR_PLUS:
+        BERROR("Addition is not supported at this time");
+        return false;
+    case BSON_TOKEN_TYPE_OPERATOR_DOT:
+        // This could be the first in a string of tokens of a numeric literal
+        if (!state->expect_numeric)
+        {
+            // Start a numeric literal. The next token must be a numeric for this to be part of it
+            // Whitespace in between is not supported
+            state->expect_numeric = true;
+            bzero_memory(state->numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
+            state->numeric_literal_str[0] = '.';
+            state->numeric_decimal_pos = 0;
+            state->numeric_literal_str_pos = 1;
+            state->pending_type = BSON_TOKEN_TYPE_OPERATOR_DOT;
+            state->pending_position = token->start;
+        }
+        else
         {
-            if (mode == BSON_TOKENIZE_MODE_WHITESPACE)
+            // Just verify that a decimal doesn't already exist
+            if (state->numeric_decimal_pos != -1)
             {
-                // Tack it onto the whitespace
-                current_token.end++;
+                BERROR("Cannot include more than once decimal in a numeric literal. First occurrance: %i, Position: %u", state->numeric_decimal_pos, token->start);
+                return false;
             }
-            else
+
+            // Append it to the string
+            state->numeric_decimal_pos = state->numeric_literal_str_pos;
+            if (!bson_parse_numeric_append(state, ".", 1, token->start))
+                return false;
+            // A negative with a leading decimal still needs digits to follow
+            if (state->numeric_literal_str_pos == 2 && state->numeric_literal_str[0] == '-')
             {
-                // Before switching to whitespace mode, push the current token
-                push_token(&current_token, parser);
-                mode = BSON_TOKENIZE_MODE_WHITESPACE;
-                current_token.type = BSON_TOKEN_TYPE_WHITESPACE;
-                current_token.start = c;
-                current_token.end = c + advance;
+                state->pending_type = BSON_TOKEN_TYPE_OPERATOR_DOT;
+                state->pending_position = token->start;
             }
-        } break;
-        case '{':
+        }
+        break;
+    case BSON_TOKEN_TYPE_OPERATOR_ASTERISK:
+    case BSON_TOKEN_TYPE_OPERATOR_SLASH:
+        BERROR("Unexpected token at position %u. Parse failed", token->start);
+        return false;
+    case BSON_TOKEN_TYPE_NUMERIC_LITERAL:
+        if (!state->expect_numeric)
         {
-            push_token(&current_token, parser);
+            state->expect_numeric = true;
+            bzero_memory(state->numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
+        }
+        if (!bson_parse_numeric_append(state, text, length, token->start))
+            return false;
+        break;
+    case BSON_TOKEN_TYPE_STRING_LITERAL:
+    {
+        if (!state->expect_value)
+        {
+            BERROR("Unexpected string token at position: %u", token->start);
+            return false;
+        }
 
-            // Create and push a new token for this
-            bson_token open_brace_token = {BSON_TOKEN_TYPE_CURLY_BRACE_OPEN, c, c + advance};
-            push_token(&open_brace_token, parser);
+        bson_property_value value = {0};
+        value.s = bson_token_text_duplicate(text, length);
+        if (!bson_parse_value_set(state, BSON_PROPERTY_TYPE_STRING, value, token->start))
+        {
+            string_free(value.s);
+            return false;
+        }
 
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
-        case '}':
+        state->expect_value = state->current_object->type == BSON_OBJECT_TYPE_ARRAY;
+    } break;
+    case BSON_TOKEN_TYPE_BOOLEAN:
+    {
+        if (!state->expect_value)
         {
-            push_token(&current_token, parser);
+            BERROR("Unexpected boolean token at position: %u", token->start);
+            return false;
+        }
 
-            // Create and push a new token for this
-            bson_token close_brace_token = {BSON_TOKEN_TYPE_CURLY_BRACE_CLOSE, c, c + advance};
-            push_token(&close_brace_token, parser);
+        // NOTE: Boolean tokens are only ever "true" or "false"
+        char token_string[8] = {0};
+        bcopy_memory(token_string, text, BMIN(length, 7));
+        bson_property_value value = {0};
+        if (!string_to_bool(token_string, &value.b))
+            BERROR("Failed to parse boolean from token. Position: %u", token->start);
 
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
-        case '[':
-        {
-            push_token(&current_token, parser);
+        if (!bson_parse_value_set(state, BSON_PROPERTY_TYPE_BOOLEAN, value, token->start))
+            return false;
 
-            // Create and push a new token for this
-            bson_token open_bracket_token = {BSON_TOKEN_TYPE_BRACKET_OPEN, c, c + advance};
-            push_token(&open_bracket_token, parser);
+        state->expect_value = state->current_object->type == BSON_OBJECT_TYPE_ARRAY;
+    } break;
+    case BSON_TOKEN_TYPE_NEWLINE:
+        // Terminate any numeric and set the current property's value to it
+        if (state->expect_numeric && !bson_parse_numeric_commit(state, token->start))
+            return false;
 
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
-        case ']':
+        // Don't expect a value after a newline
+        state->expect_value = state->current_object->type == BSON_OBJECT_TYPE_ARRAY;
+        state->expect_identifier = !state->expect_value;
+        break;
+    case BSON_TOKEN_TYPE_EOF:
+    {
+        // A numeric on the last line, with no newline after it
+        if (state->expect_numeric)
         {
-            push_token(&current_token, parser);
+            if (!bson_parse_numeric_commit(state, token->start))
+                return false;
+            state->expect_value = state->current_object->type == BSON_OBJECT_TYPE_ARRAY;
+        }
 
-            // Create and push a new token for this
-            bson_token close_bracket_token = {BSON_TOKEN_TYPE_BRACKET_CLOSE, c, c + advance};
-            push_token(&close_bracket_token, parser);
+        // Verify that we are not in the middle of assignment, and that the current depth is 1 (to account for the base object)
+        if (state->expect_value || state->expect_operator || state->scope.element_count > 1)
+        {
+            BERROR("Unexpected end of file at position: %u", token->start);
+            return false;
+        }
+    } break;
+    case BSON_TOKEN_TYPE_UNKNOWN:
+    default:
+        BERROR("Unexpected and unknown token found. Parse failed");
+        return false;
+    }
 
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
-        case '"':
+    state->last_type = token->type;
+    return true;
+}
+
+static void bson_scanner_init(bson_scanner* s, bson_parser* parser, bson_parse_state* target)
+{
+    bzero_memory(s, sizeof(bson_scanner));
+    s->mode = BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER;
+    s->current.type = BSON_TOKEN_TYPE_UNKNOWN;
+    s->parser = parser;
+    s->target = target;
+}
+
+// Resets both the current token type and the tokenize mode to unknown
+static void reset_current_token_and_mode(bson_scanner* s)
+{
+    s->current.type = BSON_TOKEN_TYPE_UNKNOWN;
+    s->current.start = 0;
+    s->current.end = 0;
+#ifdef BISMUTH_DEBUG
+    s->current.content = 0;
+#endif
+
+    s->mode = BSON_TOKENIZE_MODE_UNKNOWN;
+}
+
+// Hands off the given token, if not of unknown type or empty. text is the text being scanned
+static b8 push_token(bson_scanner* s, bson_token* t, const char* text)
+{
+    // NOTE: Empty string literals are still values, so they are kept
+    if (t->type == BSON_TOKEN_TYPE_UNKNOWN || (t->end <= t->start && t->type != BSON_TOKEN_TYPE_STRING_LITERAL))
+        return true;
+
+    // The end of file token has no text of its own
+    const char* token_text = t->type == BSON_TOKEN_TYPE_EOF ? "" : text + (t->start - s->base);
+    if (s->target)
+        return bson_parse_token(s->target, t, token_text);
+
+#ifdef BISMUTH_DEBUG
+    u32 content_length = t->type == BSON_TOKEN_TYPE_EOF ? 0 : t->end - t->start;
+    t->content = bson_token_text_duplicate(token_text, content_length);
+#endif
+    darray_push(s->parser->tokens, *t);
+    return true;
+}
+
+// Pushes whatever token is in progress, then a single-character token of the given type
+static b8 push_single_token(bson_scanner* s, bson_token_type type, u32 c, const char* text)
+{
+    if (!push_token(s, &s->current, text))
+        return false;
+
+    bson_token t = {type, c, c + 1};
+    if (!push_token(s, &t, text))
+        return false;
+
+    reset_current_token_and_mode(s);
+    return true;
+}
+
+// Keeps track of the last two characters scanned when moving past the given number of characters at i
+static void bson_scanner_advance(bson_scanner* s, const char* text, u64 i, u32 advance)
+{
+    s->prev2 = advance > 1 ? text[i + advance - 2] : s->prev;
+    s->prev = text[i + advance - 1];
+}
+
+/**
+ * Scans as much of the given text as possible, handing off each token once complete. Unless final, stops
+ * early wherever what comes next could change the current token, so scanning can resume once more text arrives.
+ * Returns how many characters from the start of text are no longer needed, or -1 on failure.
+ */
+static i64 bson_scan(bson_scanner* s, const char* text, u64 length, b8 final)
+{
+    u64 i = s->position - s->base;
+    while (i < length && !s->eof_reached)
+    {
+        char ch = text[i];
+        // The document position of this character
+        u32 c = s->base + (u32)i;
+        // How many characters to advance
+        u32 advance = 1;
+
+        if (s->in_comment)
         {
-            push_token(&current_token, parser);
+            // The rest of the line is a comment, which should be ignored rather than tokenized. The newline itself is processed as usual
+            if (ch != '\n' && ch != '\0')
+            {
+                i += string_scan_find_any_of(text + i, length - i, "\n\0", 2);
+                continue;
+            }
+            s->in_comment = false;
+        }
 
-            reset_current_token_and_mode(&current_token, &mode);
+        if (s->mode == BSON_TOKENIZE_MODE_STRING_LITERAL)
+        {
+            // Handle string literal parsing.
+            // End the string if only if the previous character was NOT a backslash OR
+            // previous character was a backslash AND the one before that was also a backslash.
+            // I.e. it needs to be confirmed that the backslash is NOT already escaped and that the quote is also not escaped.
+            // NOTE: Bytes of multi-byte UTF-8 characters never match either, so they are just taken as part of the string
+            if (ch == '"' && (s->prev != '\\' || s->prev2 == '\\'))
+            {
+                // Terminate the string, push the token, and revert modes
+                if (!push_token(s, &s->current, text))
+                    return -1;
+                reset_current_token_and_mode(s);
+            }
+            else
+            {
+                // Handle other characters as part of the string, along with everything up to the next quote
+                advance += (u32)string_scan_find_char(text + i + 1, length - i - 1, '"');
+                s->current.end += advance;
+            }
+            // TODO: Handle other escape sequences like \t, \n, etc.
+
+            bson_scanner_advance(s, text, i, advance);
+            i += advance;
+            continue;
+        }
+
+        // Not part of a string, identifier, numeric, etc., so try to figure out what to do next
+        switch (ch)
+        {
+        case '\n':
+            if (!push_single_token(s, BSON_TOKEN_TYPE_NEWLINE, c, text))
+                return -1;
+            break;
+        case '\t':
+        case '\r':
+        case ' ':
+            if (s->mode != BSON_TOKENIZE_MODE_WHITESPACE)
+            {
+                // Before switching to whitespace mode, push the current token
+                if (!push_token(s, &s->current, text))
+                    return -1;
+                s->mode = BSON_TOKENIZE_MODE_WHITESPACE;
+                s->current.type = BSON_TOKEN_TYPE_WHITESPACE;
+                s->current.start = c;
+                s->current.end = c;
+            }
+            // Tack it and the rest of the run onto the whitespace
+            advance += (u32)string_scan_skip_any_of(text + i + 1, length - i - 1, " \t\r", 3);
+            s->current.end += advance;
+            break;
+        case '{':
+            if (!push_single_token(s, BSON_TOKEN_TYPE_CURLY_BRACE_OPEN, c, text))
+                return -1;
+            break;
+        case '}':
+            if (!push_single_token(s, BSON_TOKEN_TYPE_CURLY_BRACE_CLOSE, c, text))
+                return -1;
+            break;
+        case '[':
+            if (!push_single_token(s, BSON_TOKEN_TYPE_BRACKET_OPEN, c, text))
+                return -1;
+            break;
+        case ']':
+            if (!push_single_token(s, BSON_TOKEN_TYPE_BRACKET_CLOSE, c, text))
+                return -1;
+            break;
+        case '"':
+            if (!push_token(s, &s->current, text))
+                return -1;
+            reset_current_token_and_mode(s);
 
             // Change to string parsing mode
-            mode = BSON_TOKENIZE_MODE_STRING_LITERAL;
-            current_token.type = BSON_TOKEN_TYPE_STRING_LITERAL;
-            current_token.start = c + advance;
-            current_token.end = c + advance;
-        } break;
+            s->mode = BSON_TOKENIZE_MODE_STRING_LITERAL;
+            s->current.type = BSON_TOKEN_TYPE_STRING_LITERAL;
+            s->current.start = c + 1;
+            s->current.end = c + 1;
+            break;
         case '0':
         case '1':
         case '2':
@@ -280,157 +883,110 @@ b8 bson_parser_tokenize(bson_parser* parser, const char* source)
         case '7':
         case '8':
         case '9':
-        {
-            if (mode == BSON_TOKENIZE_MODE_NUMERIC_LITERAL)
-            {
-                current_token.end++;
-            }
-            else
+            if (s->mode != BSON_TOKENIZE_MODE_NUMERIC_LITERAL)
             {
                 // Push the existing token
-                push_token(&current_token, parser);
+                if (!push_token(s, &s->current, text))
+                    return -1;
 
                 // Switch to numeric parsing mode
-                mode = BSON_TOKENIZE_MODE_NUMERIC_LITERAL;
-                current_token.type = BSON_TOKEN_TYPE_NUMERIC_LITERAL;
-                current_token.start = c;
-                current_token.end = c + advance;
+                s->mode = BSON_TOKENIZE_MODE_NUMERIC_LITERAL;
+                s->current.type = BSON_TOKEN_TYPE_NUMERIC_LITERAL;
+                s->current.start = c;
+                s->current.end = c;
             }
-        } break;
+            // Take the rest of the digits along with this one
+            advance += (u32)string_scan_skip_digits(text + i + 1, length - i - 1);
+            s->current.end += advance;
+            break;
         case '-':
-        {
-            push_token(&current_token, parser);
-
-            // Create and push a new token for this
-            bson_token minus_token = {BSON_TOKEN_TYPE_OPERATOR_MINUS, c, c + advance};
-            push_token(&minus_token, parser);
-
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
+            if (!push_single_token(s, BSON_TOKEN_TYPE_OPERATOR_MINUS, c, text))
+                return -1;
+            break;
         case '+':
-        {
-            push_token(&current_token, parser);
-
-            // Create and push a new token for this
-            bson_token plus_token = {BSON_TOKEN_TYPE_OPERATOR_PLUS, c, c + advance};
-            push_token(&plus_token, parser);
-
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
+            if (!push_single_token(s, BSON_TOKEN_TYPE_OPERATOR_PLUS, c, text))
+                return -1;
+            break;
         case '/':
-        {
-            push_token(&current_token, parser);
-            reset_current_token_and_mode(&current_token, &mode);
-
             // Look ahead and see if another slash follows. If so, the rest of the line is a comment.
-            // Skip forward until a newline is found.
-            if (source[c + 1] == '/')
+            if (i + 1 >= length && !final)
+                goto bson_scan_wait;
+            if (i + 1 < length && text[i + 1] == '/')
             {
-                i32 cm = c + 2;
-                char ch = source[cm];
-                while (ch != '\n' && ch != '\0')
-                {
-                    cm++;
-                    ch = source[cm];
-                }
-                if (cm > 0)
-                {
-                    // Skip to one char before the newline so the newline gets processed.
-                    // This is done because the comment shouldn't be tokenized, but should instead be ignored.
-                    c = cm;
-                }
-                continue;
+                if (!push_token(s, &s->current, text))
+                    return -1;
+                reset_current_token_and_mode(s);
+                s->in_comment = true;
+                advance = 2;
             }
             else
             {
                 // Otherwise it should be treated as a slash operator
-                bson_token slash_token = {BSON_TOKEN_TYPE_OPERATOR_SLASH, c, c + advance};
-                push_token(&slash_token, parser);
+                if (!push_single_token(s, BSON_TOKEN_TYPE_OPERATOR_SLASH, c, text))
+                    return -1;
             }
-
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
+            break;
         case '*':
-        {
-            push_token(&current_token, parser);
-
-            // Create and push a new token for this
-            bson_token asterisk_token = {BSON_TOKEN_TYPE_OPERATOR_ASTERISK, c, c + advance};
-            push_token(&asterisk_token, parser);
-
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
+            if (!push_single_token(s, BSON_TOKEN_TYPE_OPERATOR_ASTERISK, c, text))
+                return -1;
+            break;
         case '=':
-        {
-            push_token(&current_token, parser);
-
-            // Create and push a new token for this
-            bson_token equal_token = {BSON_TOKEN_TYPE_OPERATOR_EQUAL, c, c + advance};
-            push_token(&equal_token, parser);
-
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
+            if (!push_single_token(s, BSON_TOKEN_TYPE_OPERATOR_EQUAL, c, text))
+                return -1;
+            break;
         case '.':
-        {
-            push_token(&current_token, parser);
-
-            // Create and push a new token for this
-            bson_token dot_token = {BSON_TOKEN_TYPE_OPERATOR_DOT, c, c + advance};
-            push_token(&dot_token, parser);
-
-            reset_current_token_and_mode(&current_token, &mode);
-        } break;
+            if (!push_single_token(s, BSON_TOKEN_TYPE_OPERATOR_DOT, c, text))
+                return -1;
+            break;
         case '\0':
-        {
             // Reached the end of the file
-            push_token(&current_token, parser);
-
-            // Create and push a new token for this
-            bson_token eof_token = {BSON_TOKEN_TYPE_EOF, c, c + advance};
-            push_token(&eof_token, parser);
-
-            reset_current_token_and_mode(&current_token, &mode);
-
-            eof_reached = true;
-        } break;
-
+            if (!push_token(s, &s->current, text))
+                return -1;
+            reset_current_token_and_mode(s);
+            s->eof_reached = true;
+            break;
         default:
         {
             // Identifiers may be made up of upper/lowercase a-z, underscores and numbers (number cannot be the first character of an identifier).
             // NOTE: Number cases are handled above as numeric literals, and will be combined into identifiers if there are identifiers without whitespace next to numerics
-            if ((codepoint >= 'A' && codepoint <= 'z') || codepoint == '_')
+            if ((ch >= 'A' && ch <= 'z') || ch == '_')
             {
-                if (mode == BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER)
+                if (s->mode == BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER)
                 {
                     // Start a new identifier token
-                    if (current_token.type == BSON_TOKEN_TYPE_UNKNOWN)
+                    if (s->current.type == BSON_TOKEN_TYPE_UNKNOWN)
                     {
-                        current_token.type = BSON_TOKEN_TYPE_IDENTIFIER;
-                        current_token.start = c;
-                        current_token.end = c;
+                        s->current.type = BSON_TOKEN_TYPE_IDENTIFIER;
+                        s->current.start = c;
+                        s->current.end = c;
                     }
                     // Tack onto the existing identifier
-                    current_token.end += advance;
+                    s->current.end++;
                 }
                 else
                 {
-                    // Check first to see if it's possibly a boolean definition
-                    const char* str = source + c;
+                    // Check first to see if it's possibly a boolean definition, which needs the whole word to be seen
+                    u64 remaining = length - i;
+                    if (remaining < 5 && !final)
+                        goto bson_scan_wait;
+                    const char* str = text + i;
                     u8 bool_advance = 0;
-                    if (strings_nequali(str, "true", 4))
+                    if (remaining >= 4 && strings_nequali(str, "true", 4))
                         bool_advance = 4;
-                    else if (strings_nequali(str, "false", 5))
+                    else if (remaining >= 5 && strings_nequali(str, "false", 5))
                         bool_advance = 5;
 
                     if (bool_advance)
                     {
-                        push_token(&current_token, parser);
+                        if (!push_token(s, &s->current, text))
+                            return -1;
 
                         // Create and push boolean token
                         bson_token bool_token = {BSON_TOKEN_TYPE_BOOLEAN, c, c + bool_advance};
-                        push_token(&bool_token, parser);
+                        if (!push_token(s, &bool_token, text))
+                            return -1;
 
-                        reset_current_token_and_mode(&current_token, &mode);
+                        reset_current_token_and_mode(s);
 
                         // Move forward by the size of the token
                         advance = bool_advance;
@@ -439,13 +995,14 @@ b8 bson_parser_tokenize(bson_parser* parser, const char* source)
                     {
                         // Treat as the start of an identifier definition
                         // Push the existing token
-                        push_token(&current_token, parser);
+                        if (!push_token(s, &s->current, text))
+                            return -1;
 
                         // Switch to identifier parsing mode
-                        mode = BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER;
-                        current_token.type = BSON_TOKEN_TYPE_IDENTIFIER;
-                        current_token.start = c;
-                        current_token.end = c + advance;
+                        s->mode = BSON_TOKENIZE_MODE_DEFINING_IDENTIFIER;
+                        s->current.type = BSON_TOKEN_TYPE_IDENTIFIER;
+                        s->current.start = c;
+                        s->current.end = c + 1;
                     }
                 }
             }
@@ -453,530 +1010,211 @@ b8 bson_parser_tokenize(bson_parser* parser, const char* source)
             {
                 // If any other character is come across here that isn't part of a string, it's unknown what should happen here.
                 // Throw an error regarding this and boot if this is the case.
-                BERROR("Unexpected character '%c' at position %u. Tokenization failed", codepoint, c + advance);
-                // Clear the tokens array, as there is nothing that can be done with them in this case
-                darray_clear(parser->tokens);
-                return false;
+                BERROR("Unexpected character '%c' at position %u. Tokenization failed", ch, c + 1);
+                return -1;
             }
-
         } break;
         }
 
-        // Now advance c
-        c += advance;
+        bson_scanner_advance(s, text, i, advance);
+        i += advance;
     }
-    push_token(&current_token, parser);
-    // Create and push a new token for this
-    bson_token eof_token = {BSON_TOKEN_TYPE_EOF, char_length, char_length + 1};
-    push_token(&eof_token, parser);
 
-    return true;
-}
-
-#define NEXT_TOKEN()                            \
-    {                                           \
-        index++;                                \
-        current_token = &parser->tokens[index]; \
-    }
-
-static b8 ensure_identifier(b8 expect_identifier, bson_token* current_token, const char* token_string)
-{
-    if (expect_identifier)
-    {
-        BERROR("Expected identifier, instead found '%s'. Position: %u", token_string, current_token->start);
-        return false;
-    }
-
-    return  true;
-}
-
-static bson_token* get_last_non_whitespace_token(bson_parser* parser, u32 current_index)
-{
-    if (current_index == 0)
-        return 0;
-
-    bson_token* t = &parser->tokens[current_index - 1];
-    while (current_index > 0 && t && t->type == BSON_TOKEN_TYPE_WHITESPACE)
+    if (final)
     {
-        current_index--;
-        t = &parser->tokens[current_index];
+        if (!push_token(s, &s->current, text))
+            return -1;
+        reset_current_token_and_mode(s);
+        // Create and push a new token for this
+        bson_token eof_token = {BSON_TOKEN_TYPE_EOF, s->base + (u32)i, s->base + (u32)i + 1};
+        if (!push_token(s, &eof_token, text))
+            return -1;
+        s->position = s->base + (u32)i;
+        return (i64)length;
     }
 
-    // This means that the last token available in the file is whitespace.
-    // Impossible to return non-whitespace token
-    if (t->type == BSON_TOKEN_TYPE_WHITESPACE)
-        return 0;
-
-    return t;
-}
-
-#define NUMERIC_LITERAL_STR_MAX_LENGTH 25
-
-static char* string_from_bson_token(const char* file_content, const bson_token* token)
-{
-    i32 length = (i32)token->end - (i32)token->start;
-    BASSERT_MSG(length > 0, "Token length should be at one!");
-    char* mid = ballocate(sizeof(char) * (length + 1), MEMORY_TAG_STRING);
-    string_mid(mid, file_content, token->start, length);
-    mid[length] = 0;
-
-    return mid;
+bson_scan_wait:
+    s->position = s->base + (u32)i;
+    // The token in progress is still needed, as it may continue into the next chunk
+    if (s->current.type != BSON_TOKEN_TYPE_UNKNOWN)
+        return (i64)(s->current.start - s->base);
+    return (i64)i;
 }
 
-b8 bson_parser_parse(bson_parser* parser, bson_tree* out_tree)
+b8 bson_parser_tokenize(bson_parser* parser, const char* source)
 {
     if (!parser)
     {
-        BERROR("bson_parser_parse requires a valid pointer to a parser");
-        return false;
-    }
-    if (!out_tree)
-    {
-        BERROR("bson_parser_parse requires a valid pointer to a tree");
+        BERROR("bson_parser_tokenize requires valid pointer to out_parser!");
         return false;
     }
-
-    if (!parser->tokens)
+    if (!source)
     {
-        BERROR("Cannot parse an empty set of tokens");
+        BERROR("bson_parser_tokenize requires valid pointer to source!");
         return false;
     }
 
-    bson_token* current_token = 0;
-
-    stack scope;
-    stack_create(&scope, sizeof(bson_object*));
-
-    // The first thing expected is an identifier
-    b8 expect_identifier = true;
-    b8 expect_value = false;
-    b8 expect_operator = false;
-    b8 expect_numeric = false;
-
-    char numeric_literal_str[NUMERIC_LITERAL_STR_MAX_LENGTH] = {0};
-    u32 numeric_literal_str_pos = 0;
-    i32 numeric_decimal_pos = -1;
-
-    u32 index = 0;
-    current_token = &parser->tokens[index];
+    if (parser->file_content)
+        string_free((char*)parser->file_content);
+    parser->file_content = string_duplicate(source);
 
-    // Setup the tree
-    out_tree->root = (bson_object){0};
-    out_tree->root.type = BSON_OBJECT_TYPE_OBJECT;
-    out_tree->root.properties = darray_create(bson_property);
+    u32 char_length = string_length(source);
 
-    // Set it as the current object
-    bson_object* current_object = &out_tree->root;
-    if (!stack_push(&scope, &current_object))
+#ifdef BISMUTH_DEBUG
+    bson_parser_token_contents_free(parser);
+#endif
+    // Ensure the parser's tokens array is empty, and make room for roughly as many tokens as the source is likely to hold up front
+    u32 estimated_token_count = char_length / 8;
+    if (darray_capacity(parser->tokens) < estimated_token_count)
     {
-        BERROR("Failed to push base object onto stack");
-        return false;
+        darray_destroy(parser->tokens);
+        parser->tokens = darray_reserve(bson_token, estimated_token_count);
     }
-    bson_property* current_property = 0;
+    darray_clear(parser->tokens);
 
-    while (current_token && current_token->type != BSON_TOKEN_TYPE_EOF)
+    bson_scanner scanner;
+    bson_scanner_init(&scanner, parser, 0);
+    if (bson_scan(&scanner, parser->file_content, char_length, true) < 0)
     {
-        switch (current_token->type)
-        {
-        case BSON_TOKEN_TYPE_CURLY_BRACE_OPEN:
-        {
-            // TODO: may be needed to verify object starts at correct place
-            // ENSURE_IDENTIFIER("{")
-            // Starting a block
-            bson_object new_obj = {0};
-            new_obj.type = BSON_OBJECT_TYPE_OBJECT;
-            new_obj.properties = darray_create(bson_property);
-
-            if (current_object->type == BSON_OBJECT_TYPE_ARRAY)
-            {
-                // Apply the value directly to a newly-created, non-named property that gets added to current_object
-                bson_property unnamed_array_prop = {0};
-                unnamed_array_prop.type = BSON_PROPERTY_TYPE_OBJECT;
-                unnamed_array_prop.value.o = new_obj;
-                unnamed_array_prop.name = INVALID_BSTRING_ID;
-                // Add the array property to the current object
-                darray_push(current_object->properties, unnamed_array_prop);
-                // The current object is now new_obj
-                u32 prop_length = darray_length(current_object->properties);
-                current_object = &current_object->properties[prop_length - 1].value.o;
-            }
-            else
-            {
-                // The object becomes the value of the current property
-                current_property->value.o = new_obj;
-                // The current object is now new_obj
-                current_object = &current_property->value.o;
-
-                // This also means that the current property is being assigned an object as its value, so mark the property as type object
-                current_property->type = BSON_PROPERTY_TYPE_OBJECT;
-            }
-
-            // Add the newly-updated current_object to the stack.
-            stack_push(&scope, &current_object);
-
-            expect_identifier = true;
-        } break;
-        case BSON_TOKEN_TYPE_CURLY_BRACE_CLOSE:
-        {
-            // TODO: may be needed to verify object ends at correct place
-            // ENSURE_IDENTIFIER("}")
-            // Ending a block
-            bson_object* popped_obj = 0;
-            if (!stack_pop(&scope, &popped_obj))
-            {
-                BERROR("Failed to pop from scope stack");
-                return false;
-            }
-
-            // Peek the next object on the stack and make it the current object
-            if (!stack_peek(&scope, &current_object))
-            {
-                BERROR("Failed to peek scope stack");
-                return false;
-            }
-
-            expect_value = current_object->type == BSON_OBJECT_TYPE_ARRAY;
-        } break;
-        case BSON_TOKEN_TYPE_BRACKET_OPEN:
-        {
-            // TODO: may be needed to verify array starts at correct place
-            // ENSURE_IDENTIFIER("[")
-
-            // Starting an array
-            bson_object new_arr = {0};
-            new_arr.type = BSON_OBJECT_TYPE_ARRAY;
-            new_arr.properties = darray_create(bson_property);
-
-            if (current_object->type == BSON_OBJECT_TYPE_ARRAY)
-            {
-                // Apply the value directly to a newly-created, non-named property that gets added to current_object
-                bson_property unnamed_array_prop = {0};
-                unnamed_array_prop.type = BSON_PROPERTY_TYPE_ARRAY;
-                unnamed_array_prop.value.o = new_arr;
-                unnamed_array_prop.name = INVALID_BSTRING_ID;
-                // Add the property to the current object
-                darray_push(current_object->properties, unnamed_array_prop);
-                // The current object is now new_arr. This will always be the first entry in that array
-                u32 prop_length = darray_length(current_object->properties);
-                current_object = &current_object->properties[prop_length - 1].value.o;
-            }
-            else
-            {
-                // The object becomes the value of the current property
-                current_property->value.o = new_arr;
-                // The current object is now new_obj
-                current_object = &current_property->value.o;
-
-                // This also means that the current property is being assigned an array as its value, so mark the property as type array
-                current_property->type = BSON_PROPERTY_TYPE_ARRAY;
-            }
-
-            // Add the object to the stack
-            stack_push(&scope, &current_object);
-
-            expect_value = true;
-
-        } break;
-        case BSON_TOKEN_TYPE_BRACKET_CLOSE:
-        {
-            // TODO: may be needed to verify array ends at correct place
-            // ENSURE_IDENTIFIER("]")
-            // Ending an array
-            bson_object* popped_obj = 0;
-            if (!stack_pop(&scope, &popped_obj))
-            {
-                BERROR("Failed to pop from scope stack");
-                return false;
-            }
-
-            // Peek the next object on the stack and make it the current object
-            if (!stack_peek(&scope, &current_object))
-            {
-                BERROR("Failed to peek scope stack");
-                return false;
-            }
-
-            expect_value = current_object->type == BSON_OBJECT_TYPE_ARRAY;
-        } break;
-        case BSON_TOKEN_TYPE_IDENTIFIER:
-        {
-            char buf[512] = {0};
-            string_mid(buf, parser->file_content, current_token->start, current_token->end - current_token->start);
-            if (!expect_identifier)
-            {
-                BERROR("Unexpected identifier '%s' at position %u", buf, current_token->start);
-                return false;
-            }
-            // Start a new property
-            bson_property prop = {0};
-            prop.type = BSON_PROPERTY_TYPE_UNKNOWN;
-            prop.name = bstring_id_create(buf);
+        // Clear the tokens array, as there is nothing that can be done with them in this case
 #ifdef BISMUTH_DEBUG
-             prop.name_str = string_duplicate(buf);
+        bson_parser_token_contents_free(parser);
 #endif
+        darray_clear(parser->tokens);
+        return false;
+    }
 
-            // Push the new property and set the current property to it
-            if (!current_object->properties)
-                current_object->properties = darray_create(bson_property);
-
-            darray_push(current_object->properties, prop);
-            u32 prop_count = darray_length(current_object->properties);
-            current_property = &current_object->properties[prop_count - 1];
+    return true;
+}
 
-            // No longer expecting an identifier
-            expect_identifier = false;
-            expect_operator = true;
-        } break;
-        case BSON_TOKEN_TYPE_WHITESPACE:
-        case BSON_TOKEN_TYPE_COMMENT:
-        {
-            NEXT_TOKEN();
-            continue;
-        }
-        case BSON_TOKEN_TYPE_UNKNOWN:
-        default:
-        {
-            BERROR("Unexpected and unknown token found. Parse failed");
-            return false;
-        }
-        case BSON_TOKEN_TYPE_OPERATOR_EQUAL:
-        {
-            if (!ensure_identifier(expect_identifier, current_token, "="))
-                return false;
+b8 bson_parser_parse(bson_parser* parser, bson_tree* out_tree)
+{
+    if (!parser)
+    {
+        BERROR("bson_parser_parse requires a valid pointer to a parser");
+        return false;
+    }
+    if (!out_tree)
+    {
+        BERROR("bson_parser_parse requires a valid pointer to a tree");
+        return false;
+    }
 
-            // Previous token must be an identifier
-            bson_token* t = get_last_non_whitespace_token(parser, index);
-            if (!t)
-            {
-                BERROR("Unexpected token before assignment operator. Position: %u", current_token->start);
-                return false;
-            }
-            else if (t->type != BSON_TOKEN_TYPE_IDENTIFIER)
-            {
-                BERROR("Expected identifier before assignment operator. Position: %u", current_token->start);
-                return false;
-            }
+    if (!parser->tokens || !darray_length(parser->tokens) || !parser->file_content)
+    {
+        BERROR("Cannot parse an empty set of tokens");
+        return false;
+    }
 
-            expect_operator = false;
+    bson_parse_state state;
+    bson_parse_state_begin(&state, out_tree);
 
-            // The next non-whitespace token should be a value of some kind
-            expect_value = true;
-        } break;
-        case BSON_TOKEN_TYPE_OPERATOR_MINUS:
+    b8 result = true;
+    u32 token_count = darray_length(parser->tokens);
+    for (u32 i = 0; i < token_count; ++i)
+    {
+        const bson_token* t = &parser->tokens[i];
+        const char* text = t->type == BSON_TOKEN_TYPE_EOF ? "" : parser->file_content + t->start;
+        if (!bson_parse_token(&state, t, text))
         {
-            if (expect_numeric)
-            {
-                BERROR("Already parsing a numeric, negatives are invalid within a numeric. Position: %u", current_token->start);
-                return false;
-            }
-
-            // If the next token is a numeric literal, process this as a numeric
-            // NOTE: Negative is only valid for the first character of a numeric literal
-            if (parser->tokens[index + 1].type == BSON_TOKEN_TYPE_NUMERIC_LITERAL ||
-                (parser->tokens[index + 1].type == BSON_TOKEN_TYPE_OPERATOR_DOT && parser->tokens[index + 2].type == BSON_TOKEN_TYPE_NUMERIC_LITERAL))
-            {
-                // Start of a numeric process
-                expect_numeric = true;
-                bzero_memory(numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
-
-                numeric_literal_str[0] = '-';
-                numeric_literal_str_pos++;
-            }
-            else
-            {
-                // TODO: This should be treated as a subtraction operator. Ensure previous token is valid, etc.
-                BERROR("subtraction is not supported at this time");
-                return false;
-            }
-        } break;
-        case BSON_TOKEN_TYPE_OPERATOR_PLUS:
-            BERROR("Addition is not supported at this time");
-            return false;
+            result = false;
             break;
-        case BSON_TOKEN_TYPE_OPERATOR_DOT:
-            // This could be the first in a string of tokens of a numeric literal
-            if (!expect_numeric)
-            {
-                // Check the next token to see if it is a numeric. It must be in order for this to be part of it.
-                // Whitespace in between is not supported
-                if (parser->tokens[index + 1].type == BSON_TOKEN_TYPE_NUMERIC_LITERAL)
-                {
-                    // Start a numeric literal
-                    numeric_literal_str[0] = '.';
-                    expect_numeric = true;
-                    bzero_memory(numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
-                    numeric_decimal_pos = 0;
-                    numeric_literal_str_pos++;
-                }
-                else
-                {
-                    // TODO: Support named object properties such as "sponza.name"
-                    BERROR("Dot property operator not supported. Position: %u", current_token->start);
-                    return false;
-                }
-            }
-            else
-            {
-                // Just verify that a decimal doesn't already exist
-                if (numeric_decimal_pos != -1)
-                {
-                    BERROR("Cannot include more than once decimal in a numeric literal. First occurrance: %i, Position: %u", numeric_decimal_pos, current_token->start);
-                    return false;
-                }
-
-                // Append it to the string
-                numeric_literal_str[numeric_literal_str_pos] = '.';
-                numeric_decimal_pos = numeric_literal_str_pos;
-                numeric_literal_str_pos++;
-            }
+        }
+        if (t->type == BSON_TOKEN_TYPE_EOF)
             break;
-        case BSON_TOKEN_TYPE_OPERATOR_ASTERISK:
-        case BSON_TOKEN_TYPE_OPERATOR_SLASH:
-            BERROR("Unexpected token at position %u. Parse failed", current_token->start);
-            return false;
-        case BSON_TOKEN_TYPE_NUMERIC_LITERAL:
-        {
-            if (!expect_numeric)
-            {
-                expect_numeric = true;
-                bzero_memory(numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
-            }
-            u32 length = current_token->end - current_token->start;
-            string_ncopy(numeric_literal_str + numeric_literal_str_pos, parser->file_content + current_token->start, length);
-            numeric_literal_str_pos += length;
-        } break;
-        case BSON_TOKEN_TYPE_STRING_LITERAL:
-            if (!expect_value)
-            {
-                BERROR("Unexpected string token at position: %u", current_token->start);
-                return false;
-            }
-
-            if (current_object->type == BSON_OBJECT_TYPE_ARRAY)
-            {
-                // Apply the value directly to a newly-created, non-named property that gets added to current_object
-                bson_property p = {0};
-                p.type = BSON_PROPERTY_TYPE_STRING;
-                p.value.s = string_from_bson_token(parser->file_content, current_token);
-                p.name = INVALID_BSTRING_ID;
-                darray_push(current_object->properties, p);
-            }
-            else
-            {
-                current_property->type = BSON_PROPERTY_TYPE_STRING;
-                current_property->value.s = string_from_bson_token(parser->file_content, current_token);
-            }
+    }
 
-            expect_value = current_object->type == BSON_OBJECT_TYPE_ARRAY;
-            break;
-        case BSON_TOKEN_TYPE_BOOLEAN:
-        {
-            if (!expect_value)
-            {
-                BERROR("Unexpected boolean token at position: %u", current_token->start);
-                return false;
-            }
+    bson_parse_state_end(&state);
+    return result;
+}
 
-            char* token_string = string_from_bson_token(parser->file_content, current_token);
-            b8 bool_value = false;
-            if (!string_to_bool(token_string, &bool_value))
-                BERROR("Failed to parse boolean from token. Position: %u", current_token->start);
-            string_free(token_string);
+static void bson_parser_stream_state_destroy(bson_parser* parser)
+{
+    bson_stream_state* stream = parser->stream;
+    bson_parse_state_end(&stream->parse);
+    if (stream->window)
+        bfree(stream->window, stream->window_capacity, MEMORY_TAG_ARRAY);
+    bfree(stream, sizeof(bson_stream_state), MEMORY_TAG_ARRAY);
+    parser->stream = 0;
+}
 
-            if (current_object->type == BSON_OBJECT_TYPE_ARRAY)
-            {
-                // Apply the value directly to a newly-created, non-named property that gets added to current_object
-                bson_property p = {0};
-                p.type = BSON_PROPERTY_TYPE_BOOLEAN;
-                p.value.b = bool_value;
-                p.name = INVALID_BSTRING_ID;
-                darray_push(current_object->properties, p);
-            }
-            else
-            {
-                current_property->type = BSON_PROPERTY_TYPE_BOOLEAN;
-                current_property->value.b = bool_value;
-            }
+b8 bson_parser_stream_begin(bson_parser* parser, bson_tree* out_tree)
+{
+    if (!parser || !out_tree)
+    {
+        BERROR("bson_parser_stream_begin requires valid pointers to parser and out_tree");
+        return false;
+    }
+    if (parser->stream)
+    {
+        BERROR("bson_parser_stream_begin - parser is already streaming a document. Call bson_parser_stream_end() first");
+        return false;
+    }
 
-            expect_value = current_object->type == BSON_OBJECT_TYPE_ARRAY;
-        } break;
-        case BSON_TOKEN_TYPE_NEWLINE:
-            if (expect_numeric)
-            {
-                // Terminate the numeric and set the current property's value to it
-                bson_property p = {0};
-                p.name = INVALID_BSTRING_ID;
-                // Determine whether it is a float or a int
-                if (string_index_of(numeric_literal_str, '.') != -1)
-                {
-                    f32 f_value = 0;
-                    if (!string_to_f32(numeric_literal_str, &f_value))
-                    {
-                        BERROR("Failed to parse string to float: '%s', Position: %u", numeric_literal_str, current_token->start);
-                        return false;
-                    }
-                    p.value.f = f_value;
-                    p.type = BSON_PROPERTY_TYPE_FLOAT;
-                }
-                else
-                {
-                    i64 i_value = 0;
-                    if (!string_to_i64(numeric_literal_str, &i_value))
-                    {
-                        BERROR("Failed to parse string to signed int: '%s', Position: %u", numeric_literal_str, current_token->start);
-                        return false;
-                    }
-                    p.value.i = i_value;
-                    p.type = BSON_PROPERTY_TYPE_INT;
-                }
+    parser->stream = ballocate(sizeof(bson_stream_state), MEMORY_TAG_ARRAY);
+    bson_parse_state_begin(&parser->stream->parse, out_tree);
+    bson_scanner_init(&parser->stream->scanner, parser, &parser->stream->parse);
+    return true;
+}
 
-                if (current_object->type == BSON_OBJECT_TYPE_ARRAY)
-                {
-                    // Apply the value directly to a newly-created, non-named property that gets added to current_object
-                    darray_push(current_object->properties, p);
-                }
-                else
-                {
-                    current_property->type = p.type;
-                    current_property->value = p.value;
-                }
+b8 bson_parser_stream_feed(bson_parser* parser, const char* chunk, u64 size)
+{
+    if (!parser || !parser->stream)
+    {
+        BERROR("bson_parser_stream_feed requires a parser which has had bson_parser_stream_begin() called against it");
+        return false;
+    }
+    bson_stream_state* stream = parser->stream;
+    if (stream->failed)
+        return false;
+    if (!chunk || !size)
+        return true;
 
-                // Reset the numeric parse string state
-                bzero_memory(numeric_literal_str, sizeof(char) * NUMERIC_LITERAL_STR_MAX_LENGTH);
-                expect_numeric = false;
-                numeric_decimal_pos = -1;
-                numeric_literal_str_pos = 0;
+    // Add the chunk after whatever is left of the last one
+    u64 required = stream->window_length + size;
+    if (required > stream->window_capacity)
+    {
+        u64 new_capacity = stream->window_capacity ? stream->window_capacity : size;
+        while (new_capacity < required)
+            new_capacity *= 2;
+        stream->window = breallocate(stream->window, stream->window_capacity, new_capacity, MEMORY_TAG_ARRAY);
+        stream->window_capacity = new_capacity;
+    }
+    bcopy_memory(stream->window + stream->window_length, chunk, size);
+    stream->window_length = required;
 
-                // Current value is set, so now expect another identifier or array element
-            }
+    i64 consumed = bson_scan(&stream->scanner, stream->window, stream->window_length, false);
+    if (consumed < 0)
+    {
+        stream->failed = true;
+        return false;
+    }
 
-            // Don't expect a value after a newline
-            expect_value = current_object->type == BSON_OBJECT_TYPE_ARRAY;
-            expect_identifier = !expect_value;
-            break;
-        case BSON_TOKEN_TYPE_EOF:
-        {
-            b8 valid = true;
-            // Verify that we are not in the middle of assignment
-            if (expect_value || expect_operator || expect_numeric)
-                valid = false;
-            // Verify that the current depth is now 1 (to account for the base object)
-            if (scope.element_count > 1)
-                valid = false;
-
-            if (!valid)
-            {
-                BERROR("Unexpected end of file at position: %u", current_token->start);
-                return false;
-            }
+    // Keep only what is still needed. NOTE: This overlaps when the kept part is larger than the consumed part, so copy forward
+    u64 kept = stream->window_length - (u64)consumed;
+    for (u64 i = 0; i < kept; ++i)
+        stream->window[i] = stream->window[consumed + i];
+    stream->window_length = kept;
+    stream->scanner.base += (u32)consumed;
+    return true;
+}
 
-        } break;
-        }
-        index++;
-        current_token = &parser->tokens[index];
+b8 bson_parser_stream_end(bson_parser* parser)
+{
+    if (!parser || !parser->stream)
+    {
+        BERROR("bson_parser_stream_end requires a parser which has had bson_parser_stream_begin() called against it");
+        return false;
     }
+    bson_stream_state* stream = parser->stream;
 
-    return true;
+    // Finish off whatever is left, which also ends the document
+    b8 result = !stream->failed && bson_scan(&stream->scanner, stream->window, stream->window_length, true) >= 0;
+    if (!result)
+        bson_tree_cleanup(stream->parse.tree);
+
+    bson_parser_stream_state_destroy(parser);
+    return result;
 }
 
 b8 bson_tree_from_string(const char* source, bson_tree* out_tree)
@@ -993,80 +1231,142 @@ b8 bson_tree_from_string(const char* source, bson_tree* out_tree)
     }
 
     // String is empty, return empty tree
-    if (string_length(source) < 1)
+    u64 length = string_length(source);
+    if (length < 1)
     {
         out_tree->root.type = BSON_OBJECT_TYPE_OBJECT;
         out_tree->root.properties = 0;
+        out_tree->root.index = 0;
         return true;
     }
 
-    // Create a parser to use
-    bson_parser parser;
-    if (!bson_parser_create(&parser))
+    // The whole source is already here, so parse tokens straight from it as they are found, without copying it or keeping the tokens
+    bson_parse_state state;
+    bson_parse_state_begin(&state, out_tree);
+    bson_scanner scanner;
+    bson_scanner_init(&scanner, 0, &state);
+    b8 result = bson_scan(&scanner, source, length, true) >= 0;
+    bson_parse_state_end(&state);
+
+    if (!result)
     {
-        BERROR("Failed to create BSON parser");
-        return false;
+        BERROR("Parsing failed. See logs for details");
+        bson_tree_cleanup(out_tree);
     }
+    return result;
+}
 
-    b8 result = true;
+b8 bson_tree_from_file(file_handle* file, bson_tree* out_tree)
+{
+    if (!file || !out_tree)
+    {
+        BERROR("bson_tree_from_file requires valid pointers to file and out_tree");
+        return false;
+    }
 
-    // Start tokenizing
-    if (!bson_parser_tokenize(&parser, source))
+    bson_parser parser;
+    bson_parser_create(&parser);
+    if (!bson_parser_stream_begin(&parser, out_tree))
     {
-        BERROR("Tokenization failed. See logs for details");
-        result = false;
-        goto bson_tree_from_string_parser_cleanup;
+        bson_parser_destroy(&parser);
+        return false;
     }
 
-    // Parse the tokens
-    if (!bson_parser_parse(&parser, out_tree))
+    char* chunk = ballocate(BSON_STREAM_CHUNK_SIZE, MEMORY_TAG_ARRAY);
+    b8 fed = true;
+    while (fed)
     {
-        BERROR("Parsing failed. See logs for details");
-        result = false;
-        goto bson_tree_from_string_parser_cleanup;
+        u64 read_size = 0;
+        // NOTE: A short read means the end of the file was reached
+        b8 full = filesystem_read(file, BSON_STREAM_CHUNK_SIZE, chunk, &read_size);
+        fed = bson_parser_stream_feed(&parser, chunk, read_size);
+        if (!full || !read_size)
+            break;
     }
+    bfree(chunk, BSON_STREAM_CHUNK_SIZE, MEMORY_TAG_ARRAY);
 
-bson_tree_from_string_parser_cleanup:
+    b8 result = bson_parser_stream_end(&parser);
     bson_parser_destroy(&parser);
-    if (!result && out_tree->root.properties)
-        bson_tree_cleanup(out_tree);
+    if (!result)
+        BERROR("Parsing failed. See logs for details");
     return result;
 }
 
-static void write_spaces(char* out_source, u32* position, u16 count)
+// Writes bson text in a single pass, either into a buffer which grows as needed or through a fixed-size buffer into a file
+typedef struct bson_writer
+{
+    char* data;
+    u64 length;
+    u64 capacity;
+    // If set, data is flushed to this file whenever it fills up rather than growing
+    file_handle* file;
+    b8 failed;
+} bson_writer;
+
+static void bson_writer_flush(bson_writer* writer)
 {
-    if (out_source)
+    if (writer->file && writer->length && !writer->failed)
     {
-        for (u32 s = 0; s < count; ++s)
+        u64 written = 0;
+        if (!filesystem_write(writer->file, writer->length, writer->data, &written))
         {
-            out_source[(*position)] = ' ';
-            (*position)++;
+            BERROR("Failed to write bson to file");
+            writer->failed = true;
         }
     }
-    else
-    {
-        (*position) += count;
-    }
+    writer->length = 0;
 }
 
-static void write_string(char* out_source, u32* position, const char* str)
+static void bson_writer_write(bson_writer* writer, const char* str, u64 length)
 {
-    u32 len = string_length(str);
-    if (out_source)
+    if (writer->length + length > writer->capacity)
     {
-        for (u32 s = 0; s < len; ++s)
+        if (writer->file)
+        {
+            bson_writer_flush(writer);
+            // Anything too big for the buffer goes straight to the file
+            if (length > writer->capacity)
+            {
+                u64 written = 0;
+                if (!writer->failed && !filesystem_write(writer->file, length, str, &written))
+                {
+                    BERROR("Failed to write bson to file");
+                    writer->failed = true;
+                }
+                return;
+            }
+        }
+        else
         {
-            out_source[(*position)] = str[s];
-            (*position)++;
+            u64 new_capacity = writer->capacity ? writer->capacity * 2 : KIBIBYTES(4);
+            while (new_capacity < writer->length + length)
+                new_capacity *= 2;
+            writer->data = breallocate(writer->data, writer->capacity, new_capacity, MEMORY_TAG_STRING);
+            writer->capacity = new_capacity;
         }
     }
-    else
+
+    bcopy_memory(writer->data + writer->length, str, length);
+    writer->length += length;
+}
+
+static void write_spaces(bson_writer* writer, u32 count)
+{
+    static const char spaces[] = "                                ";
+    while (count)
     {
-        (*position) += len;
+        u32 n = BMIN(count, (u32)(sizeof(spaces) - 1));
+        bson_writer_write(writer, spaces, n);
+        count -= n;
     }
 }
 
-static void bson_tree_object_to_string(const bson_object* obj, char* out_source, u32* position, i16 indent_level, u8 indent_spaces)
+static void write_string(bson_writer* writer, const char* str)
+{
+    bson_writer_write(writer, str, string_length(str));
+}
+
+static void bson_tree_object_to_string(bson_writer* writer, const bson_object* obj, i16 indent_level, u8 indent_spaces)
 {
     indent_level++;
 
@@ -1077,7 +1377,7 @@ static void bson_tree_object_to_string(const bson_object* obj, char* out_source,
         {
             bson_property* p = &obj->properties[i];
             // Write indent
-            write_spaces(out_source, position, indent_level * indent_spaces);
+            write_spaces(writer, indent_level * indent_spaces);
 
             // If named, it is a property being defined. Otherwise it is an array element
             if (p->name)
@@ -1091,10 +1391,8 @@ static void bson_tree_object_to_string(const bson_object* obj, char* out_source,
                 if (name_str)
                 {
                     // write the name, then a space, then =, then another space
-                    write_string(out_source, position, name_str);
-                    write_spaces(out_source, position, 1);
-                    write_string(out_source, position, "=");
-                    write_spaces(out_source, position, 1);
+                    write_string(writer, name_str);
+                    bson_writer_write(writer, " = ", 3);
                 }
             }
 
@@ -1107,47 +1405,42 @@ static void bson_tree_object_to_string(const bson_object* obj, char* out_source,
                 // Opener/closer and newline based on type
                 const char* opener = p->type == BSON_PROPERTY_TYPE_OBJECT ? "{\n" : "[\n";
                 const char* closer = p->type == BSON_PROPERTY_TYPE_OBJECT ? "}\n" : "]\n";
-                write_string(out_source, position, opener);
+                bson_writer_write(writer, opener, 2);
 
-                bson_tree_object_to_string(&p->value.o, out_source, position, indent_level, indent_spaces);
+                bson_tree_object_to_string(writer, &p->value.o, indent_level, indent_spaces);
 
                 // Indent the closer
-                write_spaces(out_source, position, indent_level * indent_spaces);
-                write_string(out_source, position, closer);
+                write_spaces(writer, indent_level * indent_spaces);
+                bson_writer_write(writer, closer, 2);
             } break;
             case BSON_PROPERTY_TYPE_STRING:
             {
+                // Surround the string with quotes and put a newline after. A null string is written as an empty one
+                bson_writer_write(writer, "\"", 1);
                 if (p->value.s)
-                {
-                    // Surround the string with quotes and put a newline after
-                    write_string(out_source, position, "\"");
-                    write_string(out_source, position, p->value.s);
-                    write_string(out_source, position, "\"\n");
-                }
-                else
-                {
-                    // Write an empty string
-                    write_string(out_source, position, "\"\"\n");
-                }
+                    write_string(writer, p->value.s);
+                bson_writer_write(writer, "\"\n", 2);
             } break;
             case BSON_PROPERTY_TYPE_BOOLEAN:
             {
-                write_string(out_source, position, p->value.b ? "true" : "false");
-                write_string(out_source, position, "\n");
+                if (p->value.b)
+                    bson_writer_write(writer, "true\n", 5);
+                else
+                    bson_writer_write(writer, "false\n", 6);
             } break;
             case BSON_PROPERTY_TYPE_INT:
             {
-                char buffer[30] = {0};
-                string_append_int(buffer, "", p->value.i);
-                write_string(out_source, position, buffer);
-                write_string(out_source, position, "\n");
+                char buffer[32];
+                i32 length = string_format_to(buffer, sizeof(buffer), "%lli\n", p->value.i);
+                bson_writer_write(writer, buffer, length);
             } break;
             case BSON_PROPERTY_TYPE_FLOAT:
             {
-                char buffer[30] = {0};
-                string_append_float(buffer, "", p->value.f);
-                write_string(out_source, position, buffer);
-                write_string(out_source, position, "\n");
+                // Shortest round-trip form, so values survive being written and read back exactly
+                char buffer[STRING_F32_MAX_LENGTH + 2];
+                i32 length = string_format_f32(buffer, sizeof(buffer), p->value.f);
+                buffer[length++] = '\n';
+                bson_writer_write(writer, buffer, length);
             } break;
             default:
             case BSON_PROPERTY_TYPE_UNKNOWN:
@@ -1164,16 +1457,41 @@ const char* bson_tree_to_string(bson_tree* tree)
     if (!tree || !tree->root.properties)
         return 0;
 
-    u32 length = 0;
-    bson_tree_object_to_string(&tree->root, 0, &length, -1, 4);
-    char* out_string = ballocate(sizeof(char) * (length + 1), MEMORY_TAG_STRING);
+    bson_writer writer = {0};
+    bson_tree_object_to_string(&writer, &tree->root, -1, 4);
 
-    length = 0;
-    bson_tree_object_to_string(&tree->root, out_string, &length, -1, 4);
+    // Trim to fit, so the string can be freed with string_free()
+    u64 size = writer.length + 1;
+    char* out_string;
+    if (writer.data)
+        out_string = breallocate(writer.data, writer.capacity, size, MEMORY_TAG_STRING);
+    else
+        out_string = ballocate(size, MEMORY_TAG_STRING);
+    out_string[writer.length] = 0;
 
     return out_string;
 }
 
+b8 bson_tree_to_file(const bson_tree* tree, file_handle* file)
+{
+    if (!tree || !file)
+    {
+        BERROR("bson_tree_to_file requires valid pointers to tree and file");
+        return false;
+    }
+
+    bson_writer writer = {0};
+    writer.file = file;
+    writer.capacity = BSON_STREAM_CHUNK_SIZE;
+    writer.data = ballocate(writer.capacity, MEMORY_TAG_STRING);
+
+    bson_tree_object_to_string(&writer, &tree->root, -1, 4);
+    bson_writer_flush(&writer);
+
+    bfree(writer.data, writer.capacity, MEMORY_TAG_STRING);
+    return !writer.failed;
+}
+
 void bson_object_cleanup(bson_object* obj)
 {
     if (obj && obj->properties)
@@ -1206,8 +1524,11 @@ void bson_object_cleanup(bson_object* obj)
             {
                 // no-op
             } break;
-            default:
             case BSON_PROPERTY_TYPE_UNKNOWN:
+            {
+                // A property whose value was never parsed, as left behind by a parse that stopped partway. Nothing to free
+            } break;
+            default:
             {
                 BWARN("bson_tree_object_cleanup encountered an unknown property type");
                 BWARN("Ensure the same object wasn't added more than once somewhere in code");
@@ -1215,6 +1536,7 @@ void bson_object_cleanup(bson_object* obj)
             }
         }
         darray_destroy(obj->properties);
+        bson_object_index_destroy(obj);
         bzero_memory(obj, sizeof(bson_object));
     }
 }
@@ -1251,49 +1573,39 @@ static b8 bson_object_property_add(bson_object* obj, bson_property_type type, co
 
     bstring_id new_name = bstring_id_create(name);
 
-    if (!obj->properties)
-    {
-        obj->properties = darray_create(bson_property);
-    }
-    else
+    // Check the object's properties and see if an object with that name already exists. If it does, replace it
+    i32 existing_index = bson_object_property_index_get_by_id(obj, new_name);
+    if (existing_index != -1)
     {
-        // Check the object's properties and see if an object with that name already exists. If it does, replace it
-        u32 property_count = darray_length(obj->properties);
-        for (u32 i = 0; i < property_count; ++i)
+        bson_property* p = &obj->properties[existing_index];
+        BTRACE("Property '%s' already exists in object, and will be overwritten. Was this intentional?", name);
+        // Replace the property. Start by cleaning up the old one
+        switch (p->type)
         {
-            bson_property* p = &obj->properties[i];
-            if (p->name == new_name)
+        case BSON_PROPERTY_TYPE_STRING:
+            if (p->value.s)
             {
-                BTRACE("Property '%s' already exists in object, and will be overwritten. Was this intentional?", name);
-                // Replace the property. Start by cleaning up the old one
-                switch (p->type)
-                {
-                case BSON_PROPERTY_TYPE_STRING:
-                    if (p->value.s)
-                    {
-                        string_free(p->value.s);
-                        p->value.s = 0;
-                    }
-                    break;
-                case BSON_PROPERTY_TYPE_OBJECT:
-                case BSON_PROPERTY_TYPE_ARRAY:
-                    bson_object_cleanup(&p->value.o);
-                    break;
-                default:
-                    // Nothing to cleanup for other types
-                    break;
-                }
-                bzero_memory(&p->value, sizeof(bson_property_value));
-                // Assign new values
-                p->type = type;
-                p->name = new_name;
-#ifdef BISMUTH_DEBUG
-                p->name_str = string_duplicate(name);
-#endif
-                p->value = value;
-                return true;
+                string_free(p->value.s);
+                p->value.s = 0;
             }
+            break;
+        case BSON_PROPERTY_TYPE_OBJECT:
+        case BSON_PROPERTY_TYPE_ARRAY:
+            bson_object_cleanup(&p->value.o);
+            break;
+        default:
+            // Nothing to cleanup for other types
+            break;
         }
+        bzero_memory(&p->value, sizeof(bson_property_value));
+        // Assign new values
+        p->type = type;
+        p->name = new_name;
+#ifdef BISMUTH_DEBUG
+        p->name_str = string_duplicate(name);
+#endif
+        p->value = value;
+        return true;
     }
 
     bson_property new_prop = {0};
@@ -1304,7 +1616,7 @@ static b8 bson_object_property_add(bson_object* obj, bson_property_type type, co
 #endif
     new_prop.value = value;
 
-    darray_push(obj->properties, new_prop);
+    bson_object_property_push(obj, new_prop);
 
     return true;
 }
@@ -1876,15 +2188,11 @@ b8 bson_object_property_type_get(const bson_object* object, const char* name, bs
         return false;
     }
 
-    u32 count = darray_length(object->properties);
-    bstring_id search_name = bstring_id_create(name);
-    for (u32 i = 0; i < count; ++i)
+    i32 index = bson_object_property_index_get_by_id(object, bson_property_name_id(name));
+    if (index != -1)
     {
-        if (object->properties[i].name == search_name)
-        {
-            *out_type = object->properties[i].type;
-            return true;
-        }
+        *out_type = object->properties[index].type;
+        return true;
     }
 
     BERROR("Failed to find object property named '%s'", name);
@@ -1911,27 +2219,14 @@ b8 bson_object_property_count_get(const bson_object* object, u32* out_count)
     return true;
 }
 
-static i32 bson_object_property_index_get(const bson_object* object, const char* name)
+b8 bson_object_property_value_type_get(const bson_object* object, const char* name, bson_property_type* out_type)
 {
-    if (!object || !name)
-        return -1;
-    if (!object->properties)
-        return -1;
-
-    u32 count = darray_length(object->properties);
-    bstring_id search_name = bstring_id_create(name);
-    for (u32 i = 0; i < count; ++i)
-    {
-        if (object->properties[i].name == search_name)
-            return i;
-    }
-
-    return -1;
+    return bson_object_property_value_type_get_by_id(object, bson_property_name_id(name), out_type);
 }
 
-b8 bson_object_property_value_type_get(const bson_object* object, const char* name, bson_property_type* out_type)
+b8 bson_object_property_value_type_get_by_id(const bson_object* object, bstring_id name, bson_property_type* out_type)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
     {
         *out_type = BSON_PROPERTY_TYPE_UNKNOWN;
@@ -1944,7 +2239,12 @@ b8 bson_object_property_value_type_get(const bson_object* object, const char* na
 
 b8 bson_object_property_value_get_int(const bson_object* object, const char* name, i64* out_value)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    return bson_object_property_value_get_int_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_int_by_id(const bson_object* object, bstring_id name, i64* out_value)
+{
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
     {
         *out_value = 0;
@@ -1962,7 +2262,7 @@ b8 bson_object_property_value_get_int(const bson_object* object, const char* nam
         *out_value = (i64)p->value.f;
     else
     {
-        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", name, bson_property_type_to_string(BSON_PROPERTY_TYPE_INT), bson_property_type_to_string(p->type));
+        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", bson_property_name_for_log(name), bson_property_type_to_string(BSON_PROPERTY_TYPE_INT), bson_property_type_to_string(p->type));
         return false;
     }
 
@@ -1971,7 +2271,12 @@ b8 bson_object_property_value_get_int(const bson_object* object, const char* nam
 
 b8 bson_object_property_value_get_float(const bson_object* object, const char* name, f32* out_value)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    return bson_object_property_value_get_float_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_float_by_id(const bson_object* object, bstring_id name, f32* out_value)
+{
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
     {
         *out_value = 0;
@@ -1988,7 +2293,7 @@ b8 bson_object_property_value_get_float(const bson_object* object, const char* n
         *out_value = (f32)p->value.b;
     else
     {
-        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", name, bson_property_type_to_string(BSON_PROPERTY_TYPE_FLOAT), bson_property_type_to_string(p->type));
+        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", bson_property_name_for_log(name), bson_property_type_to_string(BSON_PROPERTY_TYPE_FLOAT), bson_property_type_to_string(p->type));
         return false;
     }
 
@@ -1997,7 +2302,12 @@ b8 bson_object_property_value_get_float(const bson_object* object, const char* n
 
 b8 bson_object_property_value_get_bool(const bson_object* object, const char* name, b8* out_value)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    return bson_object_property_value_get_bool_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_bool_by_id(const bson_object* object, bstring_id name, b8* out_value)
+{
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
     {
         *out_value = false;
@@ -2015,7 +2325,7 @@ b8 bson_object_property_value_get_bool(const bson_object* object, const char* na
         *out_value = p->value.f == 0 ? false : true;
     else
     {
-        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", name, bson_property_type_to_string(BSON_PROPERTY_TYPE_BOOLEAN), bson_property_type_to_string(p->type));
+        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", bson_property_name_for_log(name), bson_property_type_to_string(BSON_PROPERTY_TYPE_BOOLEAN), bson_property_type_to_string(p->type));
         return false;
     }
 
@@ -2024,7 +2334,12 @@ b8 bson_object_property_value_get_bool(const bson_object* object, const char* na
 
 b8 bson_object_property_value_get_string(const bson_object* object, const char* name, const char** out_value)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    return bson_object_property_value_get_string_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_string_by_id(const bson_object* object, bstring_id name, const char** out_value)
+{
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
     {
         *out_value = 0;
@@ -2040,7 +2355,7 @@ b8 bson_object_property_value_get_string(const bson_object* object, const char*
     }
     else if (p->type == BSON_PROPERTY_TYPE_FLOAT)
     {
-        *out_value = string_format("%f", p->value.f);
+        *out_value = f32_to_string(p->value.f);
     }
     else if (p->type == BSON_PROPERTY_TYPE_BOOLEAN)
     {
@@ -2060,7 +2375,7 @@ b8 bson_object_property_value_get_string(const bson_object* object, const char*
     }
     else
     {
-        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", name, bson_property_type_to_string(BSON_PROPERTY_TYPE_STRING), bson_property_type_to_string(p->type));
+        BERROR("Attempted to get property '%s' as type '%s' when it is of type '%s'", bson_property_name_for_log(name), bson_property_type_to_string(BSON_PROPERTY_TYPE_STRING), bson_property_type_to_string(p->type));
         *out_value = 0;
         return false;
     }
@@ -2068,9 +2383,9 @@ b8 bson_object_property_value_get_string(const bson_object* object, const char*
     return true;
 }
 
-static const char* bson_object_property_value_get_string_reference(const bson_object* object, const char* name, const char* target_type)
+static const char* bson_object_property_value_get_string_reference(const bson_object* object, bstring_id name, const char* target_type)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
         return 0;
 
@@ -2085,6 +2400,11 @@ static const char* bson_object_property_value_get_string_reference(const bson_ob
 }
 
 b8 bson_object_property_value_get_mat4(const bson_object* object, const char* name, mat4* out_value)
+{
+    return bson_object_property_value_get_mat4_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_mat4_by_id(const bson_object* object, bstring_id name, mat4* out_value)
 {
     if (!out_value)
         return false;
@@ -2094,6 +2414,11 @@ b8 bson_object_property_value_get_mat4(const bson_object* object, const char* na
 }
 
 b8 bson_object_property_value_get_vec4(const bson_object* object, const char* name, vec4* out_value)
+{
+    return bson_object_property_value_get_vec4_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_vec4_by_id(const bson_object* object, bstring_id name, vec4* out_value)
 {
     if (!out_value)
         return false;
@@ -2103,6 +2428,11 @@ b8 bson_object_property_value_get_vec4(const bson_object* object, const char* na
 }
 
 b8 bson_object_property_value_get_vec3(const bson_object* object, const char* name, vec3* out_value)
+{
+    return bson_object_property_value_get_vec3_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_vec3_by_id(const bson_object* object, bstring_id name, vec3* out_value)
 {
     if (!out_value)
         return false;
@@ -2112,6 +2442,11 @@ b8 bson_object_property_value_get_vec3(const bson_object* object, const char* na
 }
 
 b8 bson_object_property_value_get_vec2(const bson_object* object, const char* name, vec2* out_value)
+{
+    return bson_object_property_value_get_vec2_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_vec2_by_id(const bson_object* object, bstring_id name, vec2* out_value)
 {
     if (!out_value)
         return false;
@@ -2121,6 +2456,11 @@ b8 bson_object_property_value_get_vec2(const bson_object* object, const char* na
 }
 
 b8 bson_object_property_value_get_string_as_bname(const bson_object* object, const char* name, bname* out_value)
+{
+    return bson_object_property_value_get_string_as_bname_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_string_as_bname_by_id(const bson_object* object, bstring_id name, bname* out_value)
 {
     if (!out_value)
         return false;
@@ -2134,6 +2474,11 @@ b8 bson_object_property_value_get_string_as_bname(const bson_object* object, con
 }
 
 b8 bson_object_property_value_get_string_as_bstring_id(const bson_object* object, const char* name, bstring_id* out_value)
+{
+    return bson_object_property_value_get_string_as_bstring_id_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_string_as_bstring_id_by_id(const bson_object* object, bstring_id name, bstring_id* out_value)
 {
     if (!out_value)
         return false;
@@ -2148,7 +2493,12 @@ b8 bson_object_property_value_get_string_as_bstring_id(const bson_object* object
 
 b8 bson_object_property_value_get_object(const bson_object* object, const char* name, bson_object* out_value)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    return bson_object_property_value_get_object_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_object_by_id(const bson_object* object, bstring_id name, bson_object* out_value)
+{
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
         return false;
 
@@ -2166,7 +2516,12 @@ b8 bson_object_property_value_get_object(const bson_object* object, const char*
 
 b8 bson_object_property_value_get_array(const bson_object* object, const char* name, bson_array* out_value)
 {
-    i32 index = bson_object_property_index_get(object, name);
+    return bson_object_property_value_get_array_by_id(object, bson_property_name_id(name), out_value);
+}
+
+b8 bson_object_property_value_get_array_by_id(const bson_object* object, bstring_id name, bson_array* out_value)
+{
+    i32 index = bson_object_property_index_get_by_id(object, name);
     if (index == -1)
         return false;
 
@@ -3,6 +3,7 @@
 
 #include "defines.h"
 #include "math/math_types.h"
+#include "platform/filesystem.h"
 #include "strings/bname.h"
 #include "strings/bstring_id.h"
 
@@ -39,6 +40,11 @@ typedef struct bson_token
 #endif
 } bson_token;
 
+struct bson_stream_state;
+
+/** @brief The size of the chunks files are read and written in when streaming bson to or from them. */
+#define BSON_STREAM_CHUNK_SIZE KIBIBYTES(64)
+
 typedef struct bson_parser
 {
     const char* file_content;
@@ -46,6 +52,9 @@ typedef struct bson_parser
 
     // darray
     bson_token* tokens;
+
+    // State for a document being fed in chunks, between bson_parser_stream_begin() and bson_parser_stream_end()
+    struct bson_stream_state* stream;
 } bson_parser;
 
 typedef enum bson_property_type
@@ -60,6 +69,10 @@ typedef enum bson_property_type
 } bson_property_type;
 
 struct bson_property;
+struct bson_object_index;
+
+/** @brief Objects with at least this many properties get a hashed index for property lookups. Smaller ones are just scanned */
+#define BSON_OBJECT_INDEX_MIN_PROPERTIES 8
 
 typedef enum bson_object_type
 {
@@ -74,6 +87,10 @@ typedef struct bson_object
     bson_object_type type;
     // darray
     struct bson_property* properties;
+    // Hashed lookup of properties by name. Attached once an object reaches BSON_OBJECT_INDEX_MIN_PROPERTIES, and
+    // (re)built on the first lookup after the properties change. Shared by copies of the object, and released by bson_object_cleanup()
+    // NOTE: Building happens during lookups, so lookups on the same object from multiple threads at once are not safe
+    struct bson_object_index* index;
 } bson_object;
 
 // An alias to represent bson arrays, which are really just bson_objects that contain properties without names
@@ -162,6 +179,36 @@ BAPI b8 bson_parser_tokenize(bson_parser* parser, const char* source);
  */
 BAPI b8 bson_parser_parse(bson_parser* parser, bson_tree* out_tree);
 
+/**
+ * @brief Starts parsing a document which will be fed to the parser in chunks, i.e. as it is read from a file.
+ * Tokens are parsed as soon as they are complete, so only the current token is ever held on to,
+ * rather than the whole document and its tokens.
+ *
+ * @param parser A pointer to the parser to use. Required. Must be a valid parser.
+ * @param out_tree A pointer to hold the generated bson_tree. Required. Must remain valid until bson_parser_stream_end().
+ * @returns True on success; otherwise false.
+ */
+BAPI b8 bson_parser_stream_begin(bson_parser* parser, bson_tree* out_tree);
+
+/**
+ * @brief Feeds the next chunk of the document to the parser. Chunks may be split anywhere, including within tokens.
+ *
+ * @param parser A pointer to the parser to use. Required. Must have had bson_parser_stream_begin() called against it.
+ * @param chunk A constant pointer to the chunk. Does not need to be null-terminated, and is not held on to.
+ * @param size The size of the chunk in bytes.
+ * @returns True on success; otherwise false. Once false is returned, the rest of the document is ignored.
+ */
+BAPI b8 bson_parser_stream_feed(bson_parser* parser, const char* chunk, u64 size);
+
+/**
+ * @brief Finishes parsing a document fed through bson_parser_stream_feed(). The parser may be used again afterward.
+ * On failure, the tree passed to bson_parser_stream_begin() is cleaned up.
+ *
+ * @param parser A pointer to the parser to use. Required. Must have had bson_parser_stream_begin() called against it.
+ * @returns True if the whole document was parsed successfully; otherwise false.
+ */
+BAPI b8 bson_parser_stream_end(bson_parser* parser);
+
 /**
  * @brief Takes the provided source and tokenizes, then parses it in order to create a tree of bson_objects.
  *
@@ -171,6 +218,16 @@ BAPI b8 bson_parser_parse(bson_parser* parser, bson_tree* out_tree);
  */
 BAPI b8 bson_tree_from_string(const char* source, bson_tree* out_tree);
 
+/**
+ * @brief Parses a tree from the given file, reading it BSON_STREAM_CHUNK_SIZE bytes at a time
+ * rather than loading it all into memory first.
+ *
+ * @param file A pointer to a file opened for reading. Read from its current position to the end. Required.
+ * @param out_tree A pointer to hold the generated bson_tree. Required.
+ * @returns True on success; otherwise false.
+ */
+BAPI b8 bson_tree_from_file(file_handle* file, bson_tree* out_tree);
+
 /**
  * Takes the provided bson_tree and writes it to a bson-formatted string.
  *
@@ -179,6 +236,16 @@ BAPI b8 bson_tree_from_string(const char* source, bson_tree* out_tree);
  */
 BAPI const char* bson_tree_to_string(bson_tree* tree);
 
+/**
+ * @brief Writes the provided bson_tree to the given file in bson format, BSON_STREAM_CHUNK_SIZE bytes
+ * at a time, without building the whole string in memory first.
+ *
+ * @param tree A constant pointer to the bson_tree to write. Required.
+ * @param file A pointer to a file opened for writing. Required.
+ * @returns True on success; otherwise false.
+ */
+BAPI b8 bson_tree_to_file(const bson_tree* tree, file_handle* file);
+
 /**
  * @brief Cleans up the given bson object and its properties recursively.
  *
@@ -747,6 +814,61 @@ BAPI b8 bson_object_property_value_get_object(const bson_object* object, const c
  */
 BAPI b8 bson_object_property_value_get_array(const bson_object* object, const char* name, bson_array* out_value);
 
+/**
+ * @brief Obtains the id used for property names from the given string, without registering the string as bstring_id_create() does.
+ * Useful for hashing names once up front, i.e. into static variables, to use with the bson_object_property_value_get_*_by_id() functions.
+ *
+ * @param name The property name. Required.
+ * @return The id of the name, or INVALID_BSTRING_ID if name is empty or missing.
+ */
+BAPI bstring_id bson_property_name_id(const char* name);
+
+/**
+ * @brief Attempts to retrieve the given object's property value type by pre-hashed name. Fails if not found
+ *
+ * @param object A constant pointer to the object to search. Required
+ * @param name The id of the property name to search for, i.e. from bson_property_name_id() or bstring_id_create().
+ * @param out_type A pointer to hold the object property's type
+ * @return True on success; otherwise false
+ */
+BAPI b8 bson_object_property_value_type_get_by_id(const bson_object* object, bstring_id name, bson_property_type* out_type);
+
+/** @brief As bson_object_property_value_get_int(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_int_by_id(const bson_object* object, bstring_id name, i64* out_value);
+
+/** @brief As bson_object_property_value_get_float(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_float_by_id(const bson_object* object, bstring_id name, f32* out_value);
+
+/** @brief As bson_object_property_value_get_bool(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_bool_by_id(const bson_object* object, bstring_id name, b8* out_value);
+
+/** @brief As bson_object_property_value_get_string(), but by pre-hashed name. NOTE: Also always allocates, so the string should be released afterward. */
+BAPI b8 bson_object_property_value_get_string_by_id(const bson_object* object, bstring_id name, const char** out_value);
+
+/** @brief As bson_object_property_value_get_mat4(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_mat4_by_id(const bson_object* object, bstring_id name, mat4* out_value);
+
+/** @brief As bson_object_property_value_get_vec4(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_vec4_by_id(const bson_object* object, bstring_id name, vec4* out_value);
+
+/** @brief As bson_object_property_value_get_vec3(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_vec3_by_id(const bson_object* object, bstring_id name, vec3* out_value);
+
+/** @brief As bson_object_property_value_get_vec2(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_vec2_by_id(const bson_object* object, bstring_id name, vec2* out_value);
+
+/** @brief As bson_object_property_value_get_string_as_bname(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_string_as_bname_by_id(const bson_object* object, bstring_id name, bname* out_value);
+
+/** @brief As bson_object_property_value_get_string_as_bstring_id(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_string_as_bstring_id_by_id(const bson_object* object, bstring_id name, bstring_id* out_value);
+
+/** @brief As bson_object_property_value_get_object(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_object_by_id(const bson_object* object, bstring_id name, bson_object* out_value);
+
+/** @brief As bson_object_property_value_get_array(), but by pre-hashed name. */
+BAPI b8 bson_object_property_value_get_array_by_id(const bson_object* object, bstring_id name, bson_array* out_value);
+
 /**
  * @brief Creates and returns a new property of the object type.
  * 
@@ -418,7 +418,7 @@ b8 basset_material_deserialize(const char* file_text, basset* out_asset)
         {
             if (bson_array_element_count_get(&samplers_array, &out_material->custom_sampler_count))
             {
-                out_material->custom_samplers = darray_create(bmaterial_sampler_config);
+                out_material->custom_samplers = darray_reserve(bmaterial_sampler_config, out_material->custom_sampler_count);
                 for (u32 i = 0; i < out_material->custom_sampler_count; ++i)
                 {
                     bson_object sampler = {0};
@@ -1,62 +1,175 @@
 #include "bname.h"
 
-#include "containers/u64_bst.h"
+#include "containers/u64_hashtable.h"
 #include "debug/bassert.h"
 #include "logger.h"
+#include "memory/bmemory.h"
 #include "strings/bstring.h"
+#include "threads/bspinlock.h"
 #include "utils/crc64.h"
 
+// The number of independently locked parts of the lookup table. Must be a power of two
+#define BNAME_SHARD_COUNT 64
+// The size of each block saved strings are packed into
+#define BNAME_STRING_BLOCK_SIZE KIBIBYTES(16)
+
+/**
+ * @brief One part of the global lookup table. Names are spread across shards by their hash, so
+ * threads creating different names rarely contend for the same lock.
+ */
+typedef struct bname_shard
+{
+    bspinlock lock;
+    // Saved strings, keyed by name. Created on first use
+    u64_hashtable lookup;
+    // The block strings are currently being packed into, and how much of it is used
+    char* block;
+    u64 block_offset;
+} bname_shard;
+
 // Global lookup table for saved names
-static bt_node* string_lookup = 0;
+static bname_shard shards[BNAME_SHARD_COUNT];
+
+// Strings longer than this get a block to themselves, rather than wasting the rest of the current one
+#define BNAME_LONG_STRING_SIZE (BNAME_STRING_BLOCK_SIZE / 4)
+
+static b8 shard_block_fits(const bname_shard* shard, u64 size)
+{
+    return shard->block && size <= BNAME_STRING_BLOCK_SIZE - shard->block_offset;
+}
 
 bname bname_create(const char* str)
 {
-    if (!str || string_length(str) == 0)
+    if (!str)
         return INVALID_BNAME;
 
-    // Take a copy of the string to hash
-    char* copy = string_duplicate(str);
-    // Convert it to lowercase before hashing
-    string_to_lower(copy);
+    u64 length = string_length(str);
+    if (length == 0)
+        return INVALID_BNAME;
 
-    // Hash the lowercase string
-    bname name = crc64(0, (const u8*)copy, string_length(copy));
+    // Hash the string as if it were lowercase, so no lowercase copy is needed
+    bname name = crc64_lowercase(0, (const u8*)str, length);
     // NOTE: A hash of 0 is never allowed
     BASSERT_MSG(name != 0, string_format("bname_create - provided string '%s' hashed to 0, an invalid value. Please change the string to something else to avoid this", str));
 
-    // Dispose of the lowercase string
-    string_free(copy);
-
-    // Register in a global lookup table if not already there
-    const bt_node* entry = u64_bst_find(string_lookup, name);
-    if (!entry)
+    // Register in the global lookup table if not already there.
+    // Allocating can block on the allocator's mutex, which must never happen with a spinlock held. So whatever the
+    // insert is missing (a larger table, a new string block or a long string's copy) is allocated with the lock
+    // released, and the insert retried, since another thread may have saved the name or done the same meanwhile.
+    // Take a copy of the string in case it was dynamically allocated and might later be freed. Storing a copy of
+    // the *original* string for reference, even though this is _not_ what is used for lookup
+    bname_shard* shard = &shards[name & (BNAME_SHARD_COUNT - 1)];
+    u64 size = length + 1;
+    b8 is_long = size > BNAME_LONG_STRING_SIZE;
+    u64_hashtable spare_table = {0};
+    u64_hashtable retired_table = {0};
+    char* spare_block = 0;
+    char* long_copy = 0;
+    b8 failed = false;
+    for (;;)
     {
-        // Take a copy in case it was dynamically allocated and might later be freed.
-        // Storing a copy of the *original* string for reference, even though this is _not_ what is used for lookup
-        bt_node_value value;
-        value.str = string_duplicate(str);
-        bt_node* inserted = u64_bst_insert(string_lookup, name, value);
-        if (!inserted)
+        bspinlock_lock(&shard->lock);
+        if (u64_hashtable_contains(&shard->lookup, name))
+        {
+            bspinlock_unlock(&shard->lock);
+            break;
+        }
+
+        // Install anything allocated on the previous pass which is still needed
+        u32 needed_count = shard->lookup.count + 1;
+        if (!u64_hashtable_fits(&shard->lookup, needed_count) && u64_hashtable_fits(&spare_table, needed_count))
+        {
+            u32 iterator = 0;
+            u64 key;
+            void* value;
+            while (u64_hashtable_iterate(&shard->lookup, &iterator, &key, &value))
+                u64_hashtable_set(&spare_table, key, value);
+            retired_table = shard->lookup;
+            shard->lookup = spare_table;
+            bzero_memory(&spare_table, sizeof(u64_hashtable));
+        }
+        if (!is_long && spare_block && !shard_block_fits(shard, size))
         {
-            BERROR("Failed to save bname string '%s' to global lookup table");
+            // NOTE: The rest of the old block is abandoned, as strings already saved there live on
+            shard->block = spare_block;
+            shard->block_offset = 0;
+            spare_block = 0;
         }
-        else if (!string_lookup)
+
+        b8 table_ready = u64_hashtable_fits(&shard->lookup, needed_count);
+        b8 string_ready = is_long ? long_copy != 0 : shard_block_fits(shard, size);
+        if (table_ready && string_ready)
+        {
+            const char* saved = long_copy;
+            if (!is_long)
+            {
+                char* dest = shard->block + shard->block_offset;
+                shard->block_offset += size;
+                bcopy_memory(dest, str, length);
+                dest[length] = 0;
+                saved = dest;
+            }
+            // NOTE: The table has room, so this never allocates
+            u64_hashtable_set(&shard->lookup, name, &saved);
+            bspinlock_unlock(&shard->lock);
+            long_copy = 0;
+            break;
+        }
+        bspinlock_unlock(&shard->lock);
+        u64_hashtable_destroy(&retired_table);
+
+        if (failed)
+        {
+            BERROR("Failed to save bname string '%s' to global lookup table", str);
+            break;
+        }
+
+        if (!table_ready)
         {
-            string_lookup = inserted;
+            u64_hashtable_destroy(&spare_table);
+            // Double the room, so growth stays amortized
+            failed |= !u64_hashtable_create(sizeof(const char*), needed_count * 2, &spare_table);
+        }
+        if (!string_ready && is_long)
+        {
+            long_copy = ballocate_uninitialized(size, MEMORY_TAG_STRING);
+            if (long_copy)
+            {
+                bcopy_memory(long_copy, str, length);
+                long_copy[length] = 0;
+            }
+            failed |= !long_copy;
+        }
+        else if (!string_ready && !spare_block)
+        {
+            spare_block = ballocate_uninitialized(BNAME_STRING_BLOCK_SIZE, MEMORY_TAG_STRING);
+            failed |= !spare_block;
         }
     }
+
+    // Free anything which turned out not to be needed, or was replaced
+    u64_hashtable_destroy(&spare_table);
+    u64_hashtable_destroy(&retired_table);
+    if (spare_block)
+        bfree(spare_block, BNAME_STRING_BLOCK_SIZE, MEMORY_TAG_STRING);
+    if (long_copy)
+        bfree(long_copy, size, MEMORY_TAG_STRING);
+
     return name;
 }
 
 const char* bname_string_get(bname name)
 {
-    const bt_node* entry = u64_bst_find(string_lookup, name);
-    if (entry)
+    bname_shard* shard = &shards[name & (BNAME_SHARD_COUNT - 1)];
+    const char* str = 0;
+
+    bspinlock_lock(&shard->lock);
+    if (shard->lookup.keys)
     {
-        // NOTE: For now, just return the existing pointer to the string.
-        // If this ever becomes a problem, return a copy instead
-        return entry->value.str;
+        // NOTE: Saved strings are never moved or freed, so the pointer stays valid after unlocking
+        u64_hashtable_get(&shard->lookup, name, &str);
     }
+    bspinlock_unlock(&shard->lock);
 
-    return 0;
+    return str;
 }
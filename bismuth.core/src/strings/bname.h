@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "threads/batomic.h"
 
 /** @brief Represents an invalid bname, which is essentially used to represent "no name" */
 #define INVALID_BNAME 0
@@ -8,5 +9,40 @@
 /** @brief A bname is a string hash made for quick comparisons versus traditional string comparisons */
 typedef u64 bname;
 
+/**
+ * @brief Creates a bname from the given string. Names are case-insensitive, so "Name" and "name"
+ * give the same bname. The first string a name was created from is saved, and can be retrieved
+ * later with bname_string_get(). Safe to call from any thread.
+ *
+ * @param str The string to create a name from.
+ * @return The name, or INVALID_BNAME if the string was empty or not provided.
+ */
 BAPI bname bname_create(const char* str);
+
+/**
+ * @brief Obtains the string a name was first created from. Safe to call from any thread.
+ *
+ * @param name The name to look up.
+ * @return The saved string, or 0 if the name was never created. Valid for the life of the application.
+ */
 BAPI const char* bname_string_get(bname name);
+
+/**
+ * @brief Creates a bname from a string literal only once per call site, caching the result
+ * so later evaluations cost a single load. Use in place of bname_create() for literals in
+ * code which runs often. Safe to use from any thread (at worst, racing threads create the
+ * same name twice).
+ *
+ * @param literal A string literal.
+ */
+#define BNAME_LITERAL(literal)                                                      \
+    ({                                                                              \
+        static volatile u64 bname_literal_cache = INVALID_BNAME;                    \
+        bname bname_literal_value = batomic_load_relaxed_u64(&bname_literal_cache); \
+        if (bname_literal_value == INVALID_BNAME)                                   \
+        {                                                                           \
+            bname_literal_value = bname_create("" literal);                         \
+            batomic_store_relaxed_u64(&bname_literal_cache, bname_literal_value);   \
+        }                                                                           \
+        bname_literal_value;                                                        \
+    })
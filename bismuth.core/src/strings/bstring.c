@@ -4,6 +4,8 @@
 #include "defines.h"
 #include "logger.h"
 #include "memory/bmemory.h"
+#include "memory/frame_scratch.h"
+#include "strings/bstring_scan.h"
 
 #include <stdarg.h> // For variadic functions
 #include <stdio.h>  // vsnprintf, sscanf, sprintf
@@ -292,27 +294,26 @@ i64 bstr_ncmp(const char* str0, const char* str1, u32 max_len)
 
 i64 bstr_ncmpi(const char* str0, const char* str1, u32 max_len)
 {
-    char* lower_0 = 0;
-    char* lower_1 = 0;
+    if (!str0 || !str1)
+        return bstr_ncmp(str0, str1, max_len);
 
-    // Lowercase both strings and use them for comparison
-    if (str0)
+    // Lowercase each character as it is compared, rather than lowercasing copies of both strings.
+    // NOTE: This also means only max_len characters are ever read, so neither string needs to be terminated
+    for (u32 i = 0; i < max_len; ++i)
     {
-        lower_0 = string_duplicate(str0);
-        string_to_lower(lower_0);
-    }
-    if (str1)
-    {
-        lower_1 = string_duplicate(str1);
-        string_to_lower(lower_1);
+        char c0 = str0[i];
+        char c1 = str1[i];
+        if (codepoint_is_upper(c0))
+            c0 += ('a' - 'A');
+        if (codepoint_is_upper(c1))
+            c1 += ('a' - 'A');
+
+        i64 result = c0 - c1;
+        if (result || !c0)
+            return result;
     }
-    i64 result = bstr_ncmp(lower_0, lower_1, max_len);
-    if (lower_0)
-        string_free(lower_0);
-    if (lower_1)
-        string_free(lower_1);
 
-    return result;
+    return 0;
 }
 
 // Case-sensitive string comparison. True if the same, otherwise false
@@ -348,29 +349,99 @@ char* string_format(const char* format, ...)
     return result;
 }
 
-char* string_format_v(const char* format, void* va_listp)
+// Formats into a block obtained from the given allocator, or the heap if none is given.
+// Most strings are short, so they are formatted on the stack first rather than formatting twice to find the length
+static char* string_format_allocated(frame_allocator_int* allocator, const char* format, void* va_listp)
 {
     if (!format)
         return 0;
 
-    // Create a copy of the va_listp since vsnprintf can invalidate the elements of the list while finding the required buffer length
+    char stack_buffer[256];
+    // Create a copy of the va_listp since vsnprintf can invalidate the elements of the list
     va_list list_copy;
 #ifdef _MSC_VER
     list_copy = va_listp;
 #else
     va_copy(list_copy, va_listp);
 #endif
-    i32 length = vsnprintf(0, 0, format, list_copy);
+    i32 length = vsnprintf(stack_buffer, sizeof(stack_buffer), format, list_copy);
     va_end(list_copy);
-    char* buffer = ballocate(length + 1, MEMORY_TAG_STRING);
+    if (length < 0)
+        return 0;
+
+    char* buffer = allocator ? allocator->allocate(length + 1) : ballocate_uninitialized(length + 1, MEMORY_TAG_STRING);
     if (!buffer)
         return 0;
 
-    vsnprintf(buffer, length + 1, format, va_listp);
-    buffer[length] = 0;
+    if ((u32)length < sizeof(stack_buffer))
+        bcopy_memory(buffer, stack_buffer, length + 1);
+    else
+        vsnprintf(buffer, length + 1, format, va_listp);
     return buffer;
 }
 
+char* string_format_v(const char* format, void* va_listp)
+{
+    return string_format_allocated(0, format, va_listp);
+}
+
+i32 string_format_to(char* dest, u64 dest_size, const char* format, ...)
+{
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    i32 result = string_format_to_v(dest, dest_size, format, arg_ptr);
+    va_end(arg_ptr);
+    return result;
+}
+
+i32 string_format_to_v(char* dest, u64 dest_size, const char* format, void* va_listp)
+{
+    if (!dest || !dest_size || !format)
+        return -1;
+
+    i32 length = vsnprintf(dest, dest_size, format, va_listp);
+    if (length < 0)
+        dest[0] = 0;
+    return length;
+}
+
+char* string_format_with_allocator(frame_allocator_int* allocator, const char* format, ...)
+{
+    if (!allocator)
+    {
+        BERROR("string_format_with_allocator requires a valid pointer to an allocator");
+        return 0;
+    }
+
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    char* result = string_format_allocated(allocator, format, arg_ptr);
+    va_end(arg_ptr);
+    return result;
+}
+
+char* string_format_with_allocator_v(frame_allocator_int* allocator, const char* format, void* va_listp)
+{
+    if (!allocator)
+    {
+        BERROR("string_format_with_allocator_v requires a valid pointer to an allocator");
+        return 0;
+    }
+
+    return string_format_allocated(allocator, format, va_listp);
+}
+
+char* string_format_scratch(const char* format, ...)
+{
+    frame_allocator_int allocator = frame_scratch_allocator_get();
+
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    char* result = string_format_allocated(&allocator, format, arg_ptr);
+    va_end(arg_ptr);
+    return result;
+}
+
 // TODO: remove unsafe/deprecated
 i32 string_format_unsafe(char* dest, const char* format, ...)
 {
@@ -437,7 +508,7 @@ char* string_ncopy(char* dest, const char* source, u32 max_len)
     {
         i64 diff = max_len - source_length;
         if (diff > 0)
-            bset_memory(dest + max_len, 0, diff);
+            bset_memory(dest + source_length, 0, diff);
     }
 
     return dest;
@@ -638,52 +709,1186 @@ void string_remove_at(char* dest, const char* src, u32 pos, u32 length)
     dest[original_length - length] = 0;
 }
 
+// Floating-point parsing and printing. Neither depends on the C library or the current locale.
+//
+// Parsing splits the text into up to 19 significant digits and a power of ten, then converts exactly:
+// - If both are exactly representable in a f64, a single multiplication or division is correctly rounded.
+// - Otherwise the digits are multiplied by a 128-bit approximation of the power of ten (Eisel-Lemire), which
+//   is enough to round correctly for all but a vanishingly small number of inputs.
+// - Those, numbers with more than 19 significant digits which land too close to halfway, and f64s outside
+//   of the power table fall back to exact decimal arithmetic.
+// Printing produces the fewest digits which parse back to the same value; Ryu for f32s, and exact decimal
+// arithmetic for f64s.
+
+// The most significant digits which always fit in a u64
+#define FLOAT_MAX_MANTISSA_DIGITS 19
+// Exponents beyond this are clamped; the value has long since become zero or infinity
+#define FLOAT_MAX_EXPONENT 100000
+
+typedef struct float_format
+{
+    // The number of explicitly stored mantissa bits
+    i32 mantissa_bits;
+    i32 exponent_bits;
+    // The exponent of the smallest normal number, less one
+    i32 bias;
+    // The powers of ten for which the value can be exactly halfway between two floats
+    i32 min_round_to_even;
+    i32 max_round_to_even;
+} float_format;
+
+static const float_format float_format_f32 = {23, 8, -127, -17, 10};
+static const float_format float_format_f64 = {52, 11, -1023, -4, 23};
+
+// A number split into its significant digits and the power of ten to scale them by
+typedef struct float_parts
+{
+    u64 mantissa;
+    i64 exponent;
+    b8 negative;
+    // Non-zero digits past the first 19 were dropped from the mantissa
+    b8 truncated;
+} float_parts;
+
+// Splits [sign]digits[.digits][(e|E)[sign]digits] into its parts. Returns the number of characters consumed, or 0 if there is no number
+static u64 float_parts_parse(const char* str, u64 length, float_parts* out_parts)
+{
+    float_parts parts = {0};
+    u64 i = 0;
+    if (i < length && (str[i] == '-' || str[i] == '+'))
+    {
+        parts.negative = str[i] == '-';
+        i++;
+    }
+
+    // Leading zeros are not significant
+    u64 integer_start = i;
+    i += string_scan_skip_any_of(str + i, length - i, "0", 1);
+    u64 digit_count = string_scan_accumulate_digits(str + i, length - i, FLOAT_MAX_MANTISSA_DIGITS, &parts.mantissa);
+    i += digit_count;
+    // Any integer digits which do not fit still scale the value
+    u64 excess = string_scan_skip_digits(str + i, length - i);
+    parts.truncated = string_scan_skip_any_of(str + i, excess, "0", 1) < excess;
+    parts.exponent += (i64)excess;
+    i += excess;
+    b8 has_digits = i > integer_start;
+
+    if (i < length && str[i] == '.')
+    {
+        i++;
+        u64 fraction_start = i;
+        if (!digit_count)
+        {
+            // Nor are zeros straight after the point, other than to scale the value
+            u64 zeros = string_scan_skip_any_of(str + i, length - i, "0", 1);
+            parts.exponent -= (i64)zeros;
+            i += zeros;
+        }
+        u64 fraction_count = string_scan_accumulate_digits(str + i, length - i, FLOAT_MAX_MANTISSA_DIGITS - (u32)digit_count, &parts.mantissa);
+        parts.exponent -= (i64)fraction_count;
+        i += fraction_count;
+        excess = string_scan_skip_digits(str + i, length - i);
+        parts.truncated |= string_scan_skip_any_of(str + i, excess, "0", 1) < excess;
+        i += excess;
+        has_digits |= i > fraction_start;
+    }
+
+    if (!has_digits)
+        return 0;
+
+    // The exponent is only part of the number if it is complete
+    if (i < length && (str[i] == 'e' || str[i] == 'E'))
+    {
+        u64 e = i + 1;
+        b8 negative_exponent = false;
+        if (e < length && (str[e] == '-' || str[e] == '+'))
+        {
+            negative_exponent = str[e] == '-';
+            e++;
+        }
+        if (e < length && str[e] >= '0' && str[e] <= '9')
+        {
+            i64 exponent = 0;
+            for (; e < length && str[e] >= '0' && str[e] <= '9'; ++e)
+            {
+                if (exponent < FLOAT_MAX_EXPONENT)
+                    exponent = exponent * 10 + (str[e] - '0');
+            }
+            parts.exponent += negative_exponent ? -exponent : exponent;
+            i = e;
+        }
+    }
+
+    if (!parts.mantissa)
+        parts.exponent = 0;
+
+    *out_parts = parts;
+    return i;
+}
+
+// The powers of ten which are exactly representable in a f64
+static const f64 float_exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Converts exactly when both the mantissa and power of ten are exactly representable, so a single operation rounds correctly
+static b8 float_parts_fast_path(const float_parts* parts, f64* out_value)
+{
+    if (parts->truncated || parts->mantissa > (1ull << 53) || parts->exponent < -22 || parts->exponent > 22)
+        return false;
+
+    f64 value = (f64)parts->mantissa;
+    if (parts->exponent < 0)
+        value /= float_exact_powers_of_ten[-parts->exponent];
+    else
+        value *= float_exact_powers_of_ten[parts->exponent];
+    *out_value = parts->negative ? -value : value;
+    return true;
+}
+
+// The range of powers of ten in the table, which covers every f32
+#define FLOAT_POWER_OF_FIVE_MIN -65
+#define FLOAT_POWER_OF_FIVE_MAX 38
+
+// 5^q for q in [FLOAT_POWER_OF_FIVE_MIN, FLOAT_POWER_OF_FIVE_MAX], normalized to 128 bits (high, low). Negative powers are rounded up
+static const u64 float_powers_of_five[][2] = {
+    {0x86CCBB52EA94BAEAULL, 0x98E947129FC2B4E9ULL}, {0xA87FEA27A539E9A5ULL, 0x3F2398D747B36224ULL},
+    {0xD29FE4B18E88640EULL, 0x8EEC7F0D19A03AADULL}, {0x83A3EEEEF9153E89ULL, 0x1953CF68300424ACULL},
+    {0xA48CEAAAB75A8E2BULL, 0x5FA8C3423C052DD7ULL}, {0xCDB02555653131B6ULL, 0x3792F412CB06794DULL},
+    {0x808E17555F3EBF11ULL, 0xE2BBD88BBEE40BD0ULL}, {0xA0B19D2AB70E6ED6ULL, 0x5B6ACEAEAE9D0EC4ULL},
+    {0xC8DE047564D20A8BULL, 0xF245825A5A445275ULL}, {0xFB158592BE068D2EULL, 0xEED6E2F0F0D56712ULL},
+    {0x9CED737BB6C4183DULL, 0x55464DD69685606BULL}, {0xC428D05AA4751E4CULL, 0xAA97E14C3C26B886ULL},
+    {0xF53304714D9265DFULL, 0xD53DD99F4B3066A8ULL}, {0x993FE2C6D07B7FABULL, 0xE546A8038EFE4029ULL},
+    {0xBF8FDB78849A5F96ULL, 0xDE98520472BDD033ULL}, {0xEF73D256A5C0F77CULL, 0x963E66858F6D4440ULL},
+    {0x95A8637627989AADULL, 0xDDE7001379A44AA8ULL}, {0xBB127C53B17EC159ULL, 0x5560C018580D5D52ULL},
+    {0xE9D71B689DDE71AFULL, 0xAAB8F01E6E10B4A6ULL}, {0x9226712162AB070DULL, 0xCAB3961304CA70E8ULL},
+    {0xB6B00D69BB55C8D1ULL, 0x3D607B97C5FD0D22ULL}, {0xE45C10C42A2B3B05ULL, 0x8CB89A7DB77C506AULL},
+    {0x8EB98A7A9A5B04E3ULL, 0x77F3608E92ADB242ULL}, {0xB267ED1940F1C61CULL, 0x55F038B237591ED3ULL},
+    {0xDF01E85F912E37A3ULL, 0x6B6C46DEC52F6688ULL}, {0x8B61313BBABCE2C6ULL, 0x2323AC4B3B3DA015ULL},
+    {0xAE397D8AA96C1B77ULL, 0xABEC975E0A0D081AULL}, {0xD9C7DCED53C72255ULL, 0x96E7BD358C904A21ULL},
+    {0x881CEA14545C7575ULL, 0x7E50D64177DA2E54ULL}, {0xAA242499697392D2ULL, 0xDDE50BD1D5D0B9E9ULL},
+    {0xD4AD2DBFC3D07787ULL, 0x955E4EC64B44E864ULL}, {0x84EC3C97DA624AB4ULL, 0xBD5AF13BEF0B113EULL},
+    {0xA6274BBDD0FADD61ULL, 0xECB1AD8AEACDD58EULL}, {0xCFB11EAD453994BAULL, 0x67DE18EDA5814AF2ULL},
+    {0x81CEB32C4B43FCF4ULL, 0x80EACF948770CED7ULL}, {0xA2425FF75E14FC31ULL, 0xA1258379A94D028DULL},
+    {0xCAD2F7F5359A3B3EULL, 0x096EE45813A04330ULL}, {0xFD87B5F28300CA0DULL, 0x8BCA9D6E188853FCULL},
+    {0x9E74D1B791E07E48ULL, 0x775EA264CF55347EULL}, {0xC612062576589DDAULL, 0x95364AFE032A819EULL},
+    {0xF79687AED3EEC551ULL, 0x3A83DDBD83F52205ULL}, {0x9ABE14CD44753B52ULL, 0xC4926A9672793543ULL},
+    {0xC16D9A0095928A27ULL, 0x75B7053C0F178294ULL}, {0xF1C90080BAF72CB1ULL, 0x5324C68B12DD6339ULL},
+    {0x971DA05074DA7BEEULL, 0xD3F6FC16EBCA5E04ULL}, {0xBCE5086492111AEAULL, 0x88F4BB1CA6BCF585ULL},
+    {0xEC1E4A7DB69561A5ULL, 0x2B31E9E3D06C32E6ULL}, {0x9392EE8E921D5D07ULL, 0x3AFF322E62439FD0ULL},
+    {0xB877AA3236A4B449ULL, 0x09BEFEB9FAD487C3ULL}, {0xE69594BEC44DE15BULL, 0x4C2EBE687989A9B4ULL},
+    {0x901D7CF73AB0ACD9ULL, 0x0F9D37014BF60A11ULL}, {0xB424DC35095CD80FULL, 0x538484C19EF38C95ULL},
+    {0xE12E13424BB40E13ULL, 0x2865A5F206B06FBAULL}, {0x8CBCCC096F5088CBULL, 0xF93F87B7442E45D4ULL},
+    {0xAFEBFF0BCB24AAFEULL, 0xF78F69A51539D749ULL}, {0xDBE6FECEBDEDD5BEULL, 0xB573440E5A884D1CULL},
+    {0x89705F4136B4A597ULL, 0x31680A88F8953031ULL}, {0xABCC77118461CEFCULL, 0xFDC20D2B36BA7C3EULL},
+    {0xD6BF94D5E57A42BCULL, 0x3D32907604691B4DULL}, {0x8637BD05AF6C69B5ULL, 0xA63F9A49C2C1B110ULL},
+    {0xA7C5AC471B478423ULL, 0x0FCF80DC33721D54ULL}, {0xD1B71758E219652BULL, 0xD3C36113404EA4A9ULL},
+    {0x83126E978D4FDF3BULL, 0x645A1CAC083126EAULL}, {0xA3D70A3D70A3D70AULL, 0x3D70A3D70A3D70A4ULL},
+    {0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCDULL}, {0x8000000000000000ULL, 0x0000000000000000ULL},
+    {0xA000000000000000ULL, 0x0000000000000000ULL}, {0xC800000000000000ULL, 0x0000000000000000ULL},
+    {0xFA00000000000000ULL, 0x0000000000000000ULL}, {0x9C40000000000000ULL, 0x0000000000000000ULL},
+    {0xC350000000000000ULL, 0x0000000000000000ULL}, {0xF424000000000000ULL, 0x0000000000000000ULL},
+    {0x9896800000000000ULL, 0x0000000000000000ULL}, {0xBEBC200000000000ULL, 0x0000000000000000ULL},
+    {0xEE6B280000000000ULL, 0x0000000000000000ULL}, {0x9502F90000000000ULL, 0x0000000000000000ULL},
+    {0xBA43B74000000000ULL, 0x0000000000000000ULL}, {0xE8D4A51000000000ULL, 0x0000000000000000ULL},
+    {0x9184E72A00000000ULL, 0x0000000000000000ULL}, {0xB5E620F480000000ULL, 0x0000000000000000ULL},
+    {0xE35FA931A0000000ULL, 0x0000000000000000ULL}, {0x8E1BC9BF04000000ULL, 0x0000000000000000ULL},
+    {0xB1A2BC2EC5000000ULL, 0x0000000000000000ULL}, {0xDE0B6B3A76400000ULL, 0x0000000000000000ULL},
+    {0x8AC7230489E80000ULL, 0x0000000000000000ULL}, {0xAD78EBC5AC620000ULL, 0x0000000000000000ULL},
+    {0xD8D726B7177A8000ULL, 0x0000000000000000ULL}, {0x878678326EAC9000ULL, 0x0000000000000000ULL},
+    {0xA968163F0A57B400ULL, 0x0000000000000000ULL}, {0xD3C21BCECCEDA100ULL, 0x0000000000000000ULL},
+    {0x84595161401484A0ULL, 0x0000000000000000ULL}, {0xA56FA5B99019A5C8ULL, 0x0000000000000000ULL},
+    {0xCECB8F27F4200F3AULL, 0x0000000000000000ULL}, {0x813F3978F8940984ULL, 0x4000000000000000ULL},
+    {0xA18F07D736B90BE5ULL, 0x5000000000000000ULL}, {0xC9F2C9CD04674EDEULL, 0xA400000000000000ULL},
+    {0xFC6F7C4045812296ULL, 0x4D00000000000000ULL}, {0x9DC5ADA82B70B59DULL, 0xF020000000000000ULL},
+    {0xC5371912364CE305ULL, 0x6C28000000000000ULL}, {0xF684DF56C3E01BC6ULL, 0xC732000000000000ULL},
+    {0x9A130B963A6C115CULL, 0x3C7F400000000000ULL}, {0xC097CE7BC90715B3ULL, 0x4B9F100000000000ULL},
+    {0xF0BDC21ABB48DB20ULL, 0x1E86D40000000000ULL}, {0x96769950B50D88F4ULL, 0x1314448000000000ULL}
+};
+
+static void float_multiply_128(u64 a, u64 b, u64* out_high, u64* out_low)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *out_high = (u64)(product >> 64);
+    *out_low = (u64)product;
+#else
+    u64 a_low = (u32)a;
+    u64 a_high = a >> 32;
+    u64 b_low = (u32)b;
+    u64 b_high = b >> 32;
+    u64 low_low = a_low * b_low;
+    u64 high_low = a_high * b_low;
+    u64 low_high = a_low * b_high;
+    u64 cross = (low_low >> 32) + (u32)high_low + low_high;
+    *out_high = a_high * b_high + (high_low >> 32) + (cross >> 32);
+    *out_low = (cross << 32) | (u32)low_low;
+#endif
+}
+
+// Computes the bits of mantissa * 10^exponent (without the sign). Returns false if the power is outside the table
+static b8 float_eisel_lemire(u64 mantissa, i64 exponent, const float_format* format, u64* out_bits)
+{
+    if (exponent < FLOAT_POWER_OF_FIVE_MIN || exponent > FLOAT_POWER_OF_FIVE_MAX)
+        return false;
+    if (!mantissa)
+    {
+        *out_bits = 0;
+        return true;
+    }
+
+    i32 leading_zeros = __builtin_clzll(mantissa);
+    mantissa <<= leading_zeros;
+    const u64* power = float_powers_of_five[exponent - FLOAT_POWER_OF_FIVE_MIN];
+    u64 high, low;
+    float_multiply_128(mantissa, power[0], &high, &low);
+    // Only when the bits below those kept could carry into them does the rest of the power matter
+    u64 precision_mask = U64_MAX >> (format->mantissa_bits + 3);
+    if ((high & precision_mask) == precision_mask)
+    {
+        u64 second_high, second_low;
+        float_multiply_128(mantissa, power[1], &second_high, &second_low);
+        low += second_high;
+        if (second_high > low)
+            high++;
+    }
+
+    i32 upper_bit = (i32)(high >> 63);
+    i32 shift = upper_bit + 64 - format->mantissa_bits - 3;
+    u64 bits = high >> shift;
+    // floor(log2(10^exponent)), in 16.16 fixed point
+    i32 power2 = (i32)(((152170 + 65536) * exponent) >> 16) + 63 + upper_bit - leading_zeros - format->bias;
+
+    if (power2 <= 0)
+    {
+        // Subnormal, or too small to be anything but zero
+        if (-power2 + 1 >= 64)
+        {
+            *out_bits = 0;
+            return true;
+        }
+        bits >>= -power2 + 1;
+        bits += bits & 1;
+        bits >>= 1;
+        // Rounding up to the smallest normal number carries the implicit bit into the exponent
+        *out_bits = bits;
+        return true;
+    }
+
+    // Exactly halfway between two floats rounds to the even one, rather than up
+    if (low <= 1 && exponent >= format->min_round_to_even && exponent <= format->max_round_to_even && (bits & 3) == 1 && (bits << shift) == high)
+        bits &= ~1ull;
+
+    bits += bits & 1;
+    bits >>= 1;
+    if (bits >= (2ull << format->mantissa_bits))
+    {
+        bits = 1ull << format->mantissa_bits;
+        power2++;
+    }
+    bits &= ~(1ull << format->mantissa_bits);
+
+    i32 infinite_power = (1 << format->exponent_bits) - 1;
+    if (power2 >= infinite_power)
+    {
+        power2 = infinite_power;
+        bits = 0;
+    }
+    *out_bits = bits | ((u64)power2 << format->mantissa_bits);
+    return true;
+}
+
+// Converts with Eisel-Lemire. When digits were dropped, the true value lies between the mantissa and the mantissa plus one,
+// so the result is only known if both ends agree
+static b8 float_parts_to_bits(const float_parts* parts, const float_format* format, u64* out_bits)
+{
+    u64 bits;
+    if (!float_eisel_lemire(parts->mantissa, parts->exponent, format, &bits))
+        return false;
+    if (parts->truncated)
+    {
+        u64 upper_bits;
+        if (!float_eisel_lemire(parts->mantissa + 1, parts->exponent, format, &upper_bits) || upper_bits != bits)
+            return false;
+    }
+    *out_bits = bits;
+    return true;
+}
+
+// Enough digits to represent any f64 exactly, well beyond the 767 significant digits of the longest one
+#define FLOAT_DECIMAL_MAX_DIGITS 800
+// The largest binary shift applied at once, which keeps intermediate values within a u64
+#define FLOAT_DECIMAL_MAX_SHIFT 60
+
+// An arbitrary precision decimal. digits holds values 0-9, most significant first, with the decimal point before digits[point]
+typedef struct float_decimal
+{
+    u8 digits[FLOAT_DECIMAL_MAX_DIGITS];
+    i32 count;
+    i32 point;
+    // Non-zero digits were dropped past the end
+    b8 truncated;
+} float_decimal;
+
+static void float_decimal_trim(float_decimal* d)
+{
+    while (d->count > 0 && d->digits[d->count - 1] == 0)
+        d->count--;
+    if (d->count == 0)
+        d->point = 0;
+}
+
+static void float_decimal_assign(float_decimal* d, u64 value)
+{
+    u8 reversed[20];
+    i32 count = 0;
+    for (; value > 0; value /= 10)
+        reversed[count++] = (u8)(value % 10);
+
+    for (i32 i = 0; i < count; ++i)
+        d->digits[i] = reversed[count - 1 - i];
+    d->count = count;
+    d->point = count;
+    d->truncated = false;
+    float_decimal_trim(d);
+}
+
+// Reads a number which float_parts_parse has already validated, without its sign
+static void float_decimal_from_text(float_decimal* d, const char* str, u64 length)
+{
+    d->count = 0;
+    d->point = 0;
+    d->truncated = false;
+
+    u64 i = 0;
+    if (str[i] == '-' || str[i] == '+')
+        i++;
+
+    b8 seen_point = false;
+    for (; i < length; ++i)
+    {
+        char c = str[i];
+        if (c == '.')
+        {
+            seen_point = true;
+            continue;
+        }
+        if (c < '0' || c > '9')
+            break;
+        if (c == '0' && d->count == 0)
+        {
+            // Leading zeros only move the point, and only once past it
+            if (seen_point)
+                d->point--;
+            continue;
+        }
+        if (d->count < FLOAT_DECIMAL_MAX_DIGITS)
+            d->digits[d->count++] = (u8)(c - '0');
+        else if (c != '0')
+            d->truncated = true;
+        if (!seen_point)
+            d->point++;
+    }
+
+    if (i < length && (str[i] == 'e' || str[i] == 'E'))
+    {
+        i++;
+        b8 negative_exponent = false;
+        if (str[i] == '-' || str[i] == '+')
+        {
+            negative_exponent = str[i] == '-';
+            i++;
+        }
+        i32 exponent = 0;
+        for (; i < length && str[i] >= '0' && str[i] <= '9'; ++i)
+        {
+            if (exponent < FLOAT_MAX_EXPONENT)
+                exponent = exponent * 10 + (str[i] - '0');
+        }
+        d->point += negative_exponent ? -exponent : exponent;
+    }
+
+    float_decimal_trim(d);
+}
+
+// Divides by 2^shift
+static void float_decimal_shift_right(float_decimal* d, u32 shift)
+{
+    i32 read = 0;
+    i32 write = 0;
+    u64 n = 0;
+    // Pick up enough leading digits to produce the first digit of the result
+    for (; (n >> shift) == 0; read++)
+    {
+        if (read >= d->count)
+        {
+            if (n == 0)
+            {
+                d->count = 0;
+                return;
+            }
+            while ((n >> shift) == 0)
+            {
+                n *= 10;
+                read++;
+            }
+            break;
+        }
+        n = n * 10 + d->digits[read];
+    }
+    d->point -= read - 1;
+
+    u64 mask = (1ull << shift) - 1;
+    for (; read < d->count; read++)
+    {
+        u8 c = d->digits[read];
+        d->digits[write++] = (u8)(n >> shift);
+        n = (n & mask) * 10 + c;
+    }
+    while (n > 0)
+    {
+        u64 digit = n >> shift;
+        n &= mask;
+        if (write < FLOAT_DECIMAL_MAX_DIGITS)
+            d->digits[write++] = (u8)digit;
+        else if (digit > 0)
+            d->truncated = true;
+        n *= 10;
+    }
+    d->count = write;
+    float_decimal_trim(d);
+}
+
+// Multiplies by 2^shift
+static void float_decimal_shift_left(float_decimal* d, u32 shift)
+{
+    // A shift of up to 60 bits adds at most 19 digits. These are produced least significant first, so fill from the back
+    u8 shifted[FLOAT_DECIMAL_MAX_DIGITS + 20];
+    i32 write = FLOAT_DECIMAL_MAX_DIGITS + 20;
+    u64 n = 0;
+    for (i32 read = d->count - 1; read >= 0; read--)
+    {
+        n += (u64)d->digits[read] << shift;
+        u64 quotient = n / 10;
+        shifted[--write] = (u8)(n - 10 * quotient);
+        n = quotient;
+    }
+    while (n > 0)
+    {
+        u64 quotient = n / 10;
+        shifted[--write] = (u8)(n - 10 * quotient);
+        n = quotient;
+    }
+
+    i32 count = FLOAT_DECIMAL_MAX_DIGITS + 20 - write;
+    d->point += count - d->count;
+    if (count > FLOAT_DECIMAL_MAX_DIGITS)
+    {
+        for (i32 i = FLOAT_DECIMAL_MAX_DIGITS; i < count; ++i)
+        {
+            if (shifted[write + i] != 0)
+                d->truncated = true;
+        }
+        count = FLOAT_DECIMAL_MAX_DIGITS;
+    }
+    bcopy_memory(d->digits, shifted + write, (u64)count);
+    d->count = count;
+    float_decimal_trim(d);
+}
+
+// Multiplies by 2^shift, where a negative shift divides
+static void float_decimal_shift(float_decimal* d, i32 shift)
+{
+    if (d->count == 0)
+        return;
+
+    if (shift > 0)
+    {
+        for (; shift > FLOAT_DECIMAL_MAX_SHIFT; shift -= FLOAT_DECIMAL_MAX_SHIFT)
+            float_decimal_shift_left(d, FLOAT_DECIMAL_MAX_SHIFT);
+        float_decimal_shift_left(d, (u32)shift);
+    }
+    else if (shift < 0)
+    {
+        for (; shift < -FLOAT_DECIMAL_MAX_SHIFT; shift += FLOAT_DECIMAL_MAX_SHIFT)
+            float_decimal_shift_right(d, FLOAT_DECIMAL_MAX_SHIFT);
+        float_decimal_shift_right(d, (u32)-shift);
+    }
+}
+
+// Whether cutting the decimal off at count digits should round up, with ties going to even
+static b8 float_decimal_should_round_up(const float_decimal* d, i32 count)
+{
+    if (count < 0 || count >= d->count)
+        return false;
+    if (d->digits[count] == 5 && count + 1 == d->count)
+    {
+        // Anything dropped puts it past halfway
+        if (d->truncated)
+            return true;
+        return count > 0 && (d->digits[count - 1] % 2) == 1;
+    }
+    return d->digits[count] >= 5;
+}
+
+static void float_decimal_round_down(float_decimal* d, i32 count)
+{
+    if (count < 0 || count >= d->count)
+        return;
+    d->count = count;
+    float_decimal_trim(d);
+}
+
+static void float_decimal_round_up(float_decimal* d, i32 count)
+{
+    if (count < 0 || count >= d->count)
+        return;
+
+    for (i32 i = count - 1; i >= 0; --i)
+    {
+        if (d->digits[i] < 9)
+        {
+            d->digits[i]++;
+            d->count = i + 1;
+            return;
+        }
+    }
+
+    // All nines, so it becomes a single 1 and the point moves up
+    d->digits[0] = 1;
+    d->count = 1;
+    d->point++;
+}
+
+static void float_decimal_round(float_decimal* d, i32 count)
+{
+    if (float_decimal_should_round_up(d, count))
+        float_decimal_round_up(d, count);
+    else
+        float_decimal_round_down(d, count);
+}
+
+// The integer part, rounded to nearest
+static u64 float_decimal_rounded_integer(const float_decimal* d)
+{
+    if (d->point > 20)
+        return U64_MAX;
+
+    i32 i = 0;
+    u64 n = 0;
+    for (; i < d->point && i < d->count; ++i)
+        n = n * 10 + d->digits[i];
+    for (; i < d->point; ++i)
+        n *= 10;
+    if (float_decimal_should_round_up(d, d->point))
+        n++;
+    return n;
+}
+
+// The binary shifts which move the point by at least the number of decimal places indexed
+static const i32 float_decimal_power_shifts[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+
+// Converts exactly (without the sign). Modifies the decimal
+static u64 float_decimal_to_bits(float_decimal* d, const float_format* format)
+{
+    i32 max_exponent = (1 << format->exponent_bits) - 1;
+    i32 exponent = 0;
+    u64 mantissa = 0;
+    u64 bits = 0;
+
+    // Far outside the range of any float, so not worth shifting into place
+    if (d->count == 0 || d->point < -330)
+        return 0;
+    if (d->point > 310)
+        goto float_decimal_to_bits_overflow;
+
+    // Scale into [0.5, 1)
+    while (d->point > 0)
+    {
+        i32 shift = d->point >= 9 ? 27 : float_decimal_power_shifts[d->point];
+        float_decimal_shift(d, -shift);
+        exponent += shift;
+    }
+    while (d->point < 0 || (d->point == 0 && d->digits[0] < 5))
+    {
+        i32 shift = -d->point >= 9 ? 27 : float_decimal_power_shifts[-d->point];
+        float_decimal_shift(d, shift);
+        exponent -= shift;
+    }
+
+    // Then [1, 2), as floats store it
+    exponent--;
+
+    // Subnormals have fewer mantissa bits
+    if (exponent < format->bias + 1)
+    {
+        i32 shift = format->bias + 1 - exponent;
+        float_decimal_shift(d, -shift);
+        exponent += shift;
+    }
+    if (exponent - format->bias >= max_exponent)
+        goto float_decimal_to_bits_overflow;
+
+    float_decimal_shift(d, 1 + format->mantissa_bits);
+    mantissa = float_decimal_rounded_integer(d);
+
+    // Rounding up may have added a bit
+    if (mantissa == (2ull << format->mantissa_bits))
+    {
+        mantissa >>= 1;
+        exponent++;
+        if (exponent - format->bias >= max_exponent)
+            goto float_decimal_to_bits_overflow;
+    }
+    // Still subnormal
+    if ((mantissa & (1ull << format->mantissa_bits)) == 0)
+        exponent = format->bias;
+
+    bits = mantissa & ((1ull << format->mantissa_bits) - 1);
+    bits |= (u64)((exponent - format->bias) & max_exponent) << format->mantissa_bits;
+    return bits;
+
+float_decimal_to_bits_overflow:
+    return (u64)max_exponent << format->mantissa_bits;
+}
+
+u64 string_parse_f32(const char* str, u64 length, f32* out_value)
+{
+    if (!str || !out_value)
+        return 0;
+
+    float_parts parts;
+    u64 consumed = float_parts_parse(str, length, &parts);
+    if (!consumed)
+        return 0;
+
+    // Rounding to f64 and then again to f32 is only wrong when the f64 lands exactly halfway between two f32s
+    f64 value;
+    if (float_parts_fast_path(&parts, &value))
+    {
+        u64 value_bits;
+        bcopy_memory(&value_bits, &value, sizeof(f64));
+        if ((value_bits & 0x1FFFFFFFull) != 0x10000000ull)
+        {
+            *out_value = (f32)value;
+            return consumed;
+        }
+    }
+
+    u64 bits;
+    if (parts.exponent < FLOAT_POWER_OF_FIVE_MIN)
+    {
+        // Even 19 nines scaled by this are less than half the smallest subnormal
+        bits = 0;
+    }
+    else if (parts.exponent > FLOAT_POWER_OF_FIVE_MAX)
+    {
+        bits = 0xFFull << 23;
+    }
+    else if (!float_parts_to_bits(&parts, &float_format_f32, &bits))
+    {
+        float_decimal d;
+        float_decimal_from_text(&d, str, consumed);
+        bits = float_decimal_to_bits(&d, &float_format_f32);
+    }
+
+    u32 result = (u32)bits | ((u32)parts.negative << 31);
+    bcopy_memory(out_value, &result, sizeof(f32));
+    return consumed;
+}
+
+u64 string_parse_f64(const char* str, u64 length, f64* out_value)
+{
+    if (!str || !out_value)
+        return 0;
+
+    float_parts parts;
+    u64 consumed = float_parts_parse(str, length, &parts);
+    if (!consumed)
+        return 0;
+
+    if (float_parts_fast_path(&parts, out_value))
+        return consumed;
+
+    u64 bits;
+    if (!float_parts_to_bits(&parts, &float_format_f64, &bits))
+    {
+        float_decimal d;
+        float_decimal_from_text(&d, str, consumed);
+        bits = float_decimal_to_bits(&d, &float_format_f64);
+    }
+
+    bits |= (u64)parts.negative << 63;
+    bcopy_memory(out_value, &bits, sizeof(f64));
+    return consumed;
+}
+
+u32 string_parse_f32_list(const char* str, u64 length, f32* out_values, u32 count)
+{
+    if (!str || !out_values)
+        return 0;
+
+    u64 i = 0;
+    u32 parsed = 0;
+    for (; parsed < count; ++parsed)
+    {
+        i += string_scan_skip_whitespace(str + i, length - i);
+        u64 consumed = string_parse_f32(str + i, length - i, &out_values[parsed]);
+        if (!consumed)
+            break;
+        i += consumed;
+    }
+    return parsed;
+}
+
+// Writes the digits (values 0-9) with the decimal point before digits[point], in plain notation with at least one digit
+// either side of the point, i.e. "0.5", "1.0" and "100.0". Returns the length. out must hold the longest such number
+static u32 float_write_fixed(char* out, b8 negative, const u8* digits, i32 count, i32 point)
+{
+    u32 length = 0;
+    if (negative)
+        out[length++] = '-';
+
+    if (point <= 0)
+    {
+        out[length++] = '0';
+        out[length++] = '.';
+        for (i32 i = 0; i < -point; ++i)
+            out[length++] = '0';
+        for (i32 i = 0; i < count; ++i)
+            out[length++] = (char)('0' + digits[i]);
+        // Zero
+        if (!count)
+            out[length++] = '0';
+    }
+    else
+    {
+        for (i32 i = 0; i < point; ++i)
+            out[length++] = i < count ? (char)('0' + digits[i]) : '0';
+        out[length++] = '.';
+        if (count > point)
+        {
+            for (i32 i = point; i < count; ++i)
+                out[length++] = (char)('0' + digits[i]);
+        }
+        else
+        {
+            out[length++] = '0';
+        }
+    }
+
+    out[length] = 0;
+    return length;
+}
+
+static u32 float_write_special(char* out, b8 negative, b8 is_nan)
+{
+    const char* text = is_nan ? "nan" : (negative ? "-inf" : "inf");
+    u32 length = (u32)string_length(text);
+    bcopy_memory(out, text, length + 1);
+    return length;
+}
+
+// Ryu tables: 2^k / 5^q, rounded up, and 5^i, each normalized to the given number of bits
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT 61
+
+static const u64 float_pow5_inv_split[] = {
+    0x0800000000000001ULL, 0x0666666666666667ULL, 0x051EB851EB851EB9ULL,
+    0x04189374BC6A7EFAULL, 0x068DB8BAC710CB2AULL, 0x053E2D6238DA3C22ULL,
+    0x0431BDE82D7B634EULL, 0x06B5FCA6AF2BD216ULL, 0x055E63B88C230E78ULL,
+    0x044B82FA09B5A52DULL, 0x06DF37F675EF6EAEULL, 0x057F5FF85E592558ULL,
+    0x0465E6604B7A8447ULL, 0x0709709A125DA071ULL, 0x05A126E1A84AE6C1ULL,
+    0x0480EBE7B9D58567ULL, 0x0734ACA5F6226F0BULL, 0x05C3BD5191B525A3ULL,
+    0x049C97747490EAE9ULL, 0x0760F253EDB4AB0EULL, 0x05E72843249088D8ULL,
+    0x04B8ED0283A6D3E0ULL, 0x078E480405D7B966ULL, 0x060B6CD004AC9452ULL,
+    0x04D5F0A66A23A9DBULL, 0x07BCB43D769F762BULL, 0x063090312BB2C4EFULL,
+    0x04F3A68DBC8F03F3ULL, 0x07EC3DAF94180651ULL, 0x065697BFA9ACD1DAULL,
+    0x051212FFBAF0A7E2ULL
+};
+
+static const u64 float_pow5_split[] = {
+    0x1000000000000000ULL, 0x1400000000000000ULL, 0x1900000000000000ULL,
+    0x1F40000000000000ULL, 0x1388000000000000ULL, 0x186A000000000000ULL,
+    0x1E84800000000000ULL, 0x1312D00000000000ULL, 0x17D7840000000000ULL,
+    0x1DCD650000000000ULL, 0x12A05F2000000000ULL, 0x174876E800000000ULL,
+    0x1D1A94A200000000ULL, 0x12309CE540000000ULL, 0x16BCC41E90000000ULL,
+    0x1C6BF52634000000ULL, 0x11C37937E0800000ULL, 0x16345785D8A00000ULL,
+    0x1BC16D674EC80000ULL, 0x1158E460913D0000ULL, 0x15AF1D78B58C4000ULL,
+    0x1B1AE4D6E2EF5000ULL, 0x10F0CF064DD59200ULL, 0x152D02C7E14AF680ULL,
+    0x1A784379D99DB420ULL, 0x108B2A2C28029094ULL, 0x14ADF4B7320334B9ULL,
+    0x19D971E4FE8401E7ULL, 0x1027E72F1F128130ULL, 0x1431E0FAE6D7217CULL,
+    0x193E5939A08CE9DBULL, 0x1F8DEF8808B02452ULL, 0x13B8B5B5056E16B3ULL,
+    0x18A6E32246C99C60ULL, 0x1ED09BEAD87C0378ULL, 0x13426172C74D822BULL,
+    0x1812F9CF7920E2B6ULL, 0x1E17B84357691B64ULL, 0x12CED32A16A1B11EULL,
+    0x178287F49C4A1D66ULL, 0x1D6329F1C35CA4BFULL, 0x125DFA371A19E6F7ULL,
+    0x16F578C4E0A060B5ULL, 0x1CB2D6F618C878E3ULL, 0x11EFC659CF7D4B8DULL,
+    0x166BB7F0435C9E71ULL, 0x1C06A5EC5433C60DULL, 0x118427B3B4A05BC8ULL
+};
+
+// The number of bits in 5^e, for e in [0, 3528]
+static i32 ryu_pow5_bits(i32 e)
+{
+    return (i32)(((u32)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)), for e in [0, 1650]
+static u32 ryu_log10_pow2(i32 e)
+{
+    return ((u32)e * 78913) >> 18;
+}
+
+// floor(log10(5^e)), for e in [0, 2620]
+static u32 ryu_log10_pow5(i32 e)
+{
+    return ((u32)e * 732923) >> 20;
+}
+
+static b8 ryu_multiple_of_pow5(u32 value, u32 p)
+{
+    u32 count = 0;
+    for (; value % 5 == 0; value /= 5)
+        count++;
+    return count >= p;
+}
+
+static b8 ryu_multiple_of_pow2(u32 value, u32 p)
+{
+    return (value & ((1u << p) - 1)) == 0;
+}
+
+static u32 ryu_mul_shift(u32 m, u64 factor, i32 shift)
+{
+    u64 bits0 = (u64)m * (u32)factor;
+    u64 bits1 = (u64)m * (u32)(factor >> 32);
+    u64 sum = (bits0 >> 32) + bits1;
+    return (u32)(sum >> (shift - 32));
+}
+
+// Finds the shortest digits within the interval of values which round to the float, and the closest to it of those
+static void ryu_f32_shortest(u32 ieee_mantissa, u32 ieee_exponent, u32* out_digits, i32* out_exponent)
+{
+    i32 e2;
+    u32 m2;
+    if (ieee_exponent == 0)
+    {
+        e2 = 1 - 127 - 23 - 2;
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = (i32)ieee_exponent - 127 - 23 - 2;
+        m2 = (1u << 23) | ieee_mantissa;
+    }
+    b8 accept_bounds = (m2 & 1) == 0;
+
+    // The value and the halfway points to its neighbours, all scaled by 4
+    u32 mv = 4 * m2;
+    u32 mp = 4 * m2 + 2;
+    u32 mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    u32 mm = 4 * m2 - 1 - mm_shift;
+
+    u32 vr, vp, vm;
+    i32 e10;
+    b8 vm_trailing_zeros = false;
+    b8 vr_trailing_zeros = false;
+    u8 last_removed_digit = 0;
+    if (e2 >= 0)
+    {
+        u32 q = ryu_log10_pow2(e2);
+        e10 = (i32)q;
+        i32 k = FLOAT_POW5_INV_BITCOUNT + ryu_pow5_bits((i32)q) - 1;
+        i32 i = -e2 + (i32)q + k;
+        vr = ryu_mul_shift(mv, float_pow5_inv_split[q], i);
+        vp = ryu_mul_shift(mp, float_pow5_inv_split[q], i);
+        vm = ryu_mul_shift(mm, float_pow5_inv_split[q], i);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+            // The loop below removes at least one digit, which needs the one before it to round correctly
+            i32 l = FLOAT_POW5_INV_BITCOUNT + ryu_pow5_bits((i32)(q - 1)) - 1;
+            last_removed_digit = (u8)(ryu_mul_shift(mv, float_pow5_inv_split[q - 1], -e2 + (i32)q - 1 + l) % 10);
+        }
+        if (q <= 9)
+        {
+            // Only one of mp, mv and mm can be a multiple of 5, if any
+            if (mv % 5 == 0)
+                vr_trailing_zeros = ryu_multiple_of_pow5(mv, q);
+            else if (accept_bounds)
+                vm_trailing_zeros = ryu_multiple_of_pow5(mm, q);
+            else
+                vp -= ryu_multiple_of_pow5(mp, q);
+        }
+    }
+    else
+    {
+        u32 q = ryu_log10_pow5(-e2);
+        e10 = (i32)q + e2;
+        i32 i = -e2 - (i32)q;
+        i32 k = ryu_pow5_bits(i) - FLOAT_POW5_BITCOUNT;
+        i32 j = (i32)q - k;
+        vr = ryu_mul_shift(mv, float_pow5_split[i], j);
+        vp = ryu_mul_shift(mp, float_pow5_split[i], j);
+        vm = ryu_mul_shift(mm, float_pow5_split[i], j);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+            j = (i32)q - 1 - (ryu_pow5_bits(i + 1) - FLOAT_POW5_BITCOUNT);
+            last_removed_digit = (u8)(ryu_mul_shift(mv, float_pow5_split[i + 1], j) % 10);
+        }
+        if (q <= 1)
+        {
+            // mv has at least q trailing zero bits, so vr has at least q trailing zero digits
+            vr_trailing_zeros = true;
+            if (accept_bounds)
+                vm_trailing_zeros = mm_shift == 1;
+            else
+                --vp;
+        }
+        else if (q < 31)
+        {
+            vr_trailing_zeros = ryu_multiple_of_pow2(mv, q - 1);
+        }
+    }
+
+    // Remove digits while the interval still holds more than one candidate
+    i32 removed = 0;
+    u32 output;
+    if (vm_trailing_zeros || vr_trailing_zeros)
+    {
+        // The rare general case, which has to track whether the removed digits were all zeros
+        while (vp / 10 > vm / 10)
+        {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = (u8)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+        if (vm_trailing_zeros)
+        {
+            while (vm % 10 == 0)
+            {
+                vr_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = (u8)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
+            }
+        }
+        // Exactly halfway rounds to even
+        if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+            last_removed_digit = 4;
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed_digit >= 5);
+    }
+    else
+    {
+        while (vp / 10 > vm / 10)
+        {
+            last_removed_digit = (u8)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+        output = vr + (vr == vm || last_removed_digit >= 5);
+    }
+
+    *out_digits = output;
+    *out_exponent = e10 + removed;
+}
+
+// Writes the shortest round-trip text for the value. out must hold STRING_F32_MAX_LENGTH + 1 characters
+static u32 float_f32_to_text(f32 value, char* out)
+{
+    u32 bits;
+    bcopy_memory(&bits, &value, sizeof(f32));
+    b8 negative = (bits >> 31) != 0;
+    u32 ieee_exponent = (bits >> 23) & 0xFF;
+    u32 ieee_mantissa = bits & ((1u << 23) - 1);
+    if (ieee_exponent == 0xFF)
+        return float_write_special(out, negative, ieee_mantissa != 0);
+    if (ieee_exponent == 0 && ieee_mantissa == 0)
+        return float_write_fixed(out, negative, 0, 0, 0);
+
+    u32 output;
+    i32 exponent;
+    ryu_f32_shortest(ieee_mantissa, ieee_exponent, &output, &exponent);
+
+    u8 reversed[10];
+    i32 count = 0;
+    for (; output > 0; output /= 10)
+        reversed[count++] = (u8)(output % 10);
+    u8 digits[10];
+    for (i32 i = 0; i < count; ++i)
+        digits[i] = reversed[count - 1 - i];
+
+    return float_write_fixed(out, negative, digits, count, count + exponent);
+}
+
+// Cuts the exact decimal of mantissa * 2^(exponent - mantissa_bits) down to the fewest digits which still lie strictly
+// within (or on, for even mantissas) the halfway points to its neighbours, so that it parses back to the same value
+static void float_decimal_round_shortest(float_decimal* d, u64 mantissa, i32 exponent, const float_format* format)
+{
+    if (mantissa == 0)
+    {
+        d->count = 0;
+        return;
+    }
+
+    // If the value is an integer with no more digits than are needed to tell it apart, it is already shortest.
+    // 332/100 is a little more than log2(10)
+    i32 min_exponent = format->bias + 1;
+    if (exponent > min_exponent && 332 * (d->point - d->count) >= 100 * (exponent - format->mantissa_bits))
+        return;
+
+    // The halfway point to the next float up
+    float_decimal upper;
+    float_decimal_assign(&upper, mantissa * 2 + 1);
+    float_decimal_shift(&upper, exponent - format->mantissa_bits - 1);
+
+    // And to the next float down, which is closer when the mantissa is a power of two
+    u64 mantissa_lower;
+    i32 exponent_lower;
+    if (mantissa > (1ull << format->mantissa_bits) || exponent == min_exponent)
+    {
+        mantissa_lower = mantissa - 1;
+        exponent_lower = exponent;
+    }
+    else
+    {
+        mantissa_lower = mantissa * 2 - 1;
+        exponent_lower = exponent - 1;
+    }
+    float_decimal lower;
+    float_decimal_assign(&lower, mantissa_lower * 2 + 1);
+    float_decimal_shift(&lower, exponent_lower - format->mantissa_bits - 1);
+
+    // Round to even means the halfway points themselves parse to this value
+    b8 inclusive = mantissa % 2 == 0;
+
+    // Walk the digits of all three, aligned on upper's, until rounding down or up (or either) is within the bounds.
+    // upper_delta tracks how far upper is from the value so far: 0 while the digits match, 1 while they differ by one
+    // in the last place, and 2 once there is room for the value to round up without reaching upper
+    u8 upper_delta = 0;
+    for (i32 ui = 0;; ui++)
+    {
+        i32 mi = ui - upper.point + d->point;
+        if (mi >= d->count)
+            break;
+        i32 li = ui - upper.point + lower.point;
+        u8 l = (li >= 0 && li < lower.count) ? lower.digits[li] : 0;
+        u8 m = mi >= 0 ? d->digits[mi] : 0;
+        u8 u = ui < upper.count ? upper.digits[ui] : 0;
+
+        b8 ok_down = l != m || (inclusive && li + 1 == lower.count);
+
+        if (upper_delta == 0 && m + 1 < u)
+            upper_delta = 2;
+        else if (upper_delta == 0 && m != u)
+            upper_delta = 1;
+        else if (upper_delta == 1 && (m != 9 || u != 0))
+            upper_delta = 2;
+        b8 ok_up = upper_delta > 0 && (inclusive || upper_delta > 1 || ui + 1 < upper.count);
+
+        if (ok_down && ok_up)
+        {
+            float_decimal_round(d, mi + 1);
+            return;
+        }
+        if (ok_down)
+        {
+            float_decimal_round_down(d, mi + 1);
+            return;
+        }
+        if (ok_up)
+        {
+            float_decimal_round_up(d, mi + 1);
+            return;
+        }
+    }
+}
+
+// Writes the shortest round-trip text for the value. out must hold STRING_F64_MAX_LENGTH + 1 characters
+static u32 float_f64_to_text(f64 value, char* out)
+{
+    u64 bits;
+    bcopy_memory(&bits, &value, sizeof(f64));
+    b8 negative = (bits >> 63) != 0;
+    i32 exponent = (i32)((bits >> 52) & 0x7FF);
+    u64 mantissa = bits & ((1ull << 52) - 1);
+    if (exponent == 0x7FF)
+        return float_write_special(out, negative, mantissa != 0);
+    if (exponent == 0 && mantissa == 0)
+        return float_write_fixed(out, negative, 0, 0, 0);
+
+    if (exponent == 0)
+        exponent++;
+    else
+        mantissa |= 1ull << 52;
+    exponent += float_format_f64.bias;
+
+    float_decimal d;
+    float_decimal_assign(&d, mantissa);
+    float_decimal_shift(&d, exponent - float_format_f64.mantissa_bits);
+    float_decimal_round_shortest(&d, mantissa, exponent, &float_format_f64);
+    return float_write_fixed(out, negative, d.digits, d.count, d.point);
+}
+
+i32 string_format_f32(char* buffer, u64 buffer_size, f32 value)
+{
+    if (!buffer || !buffer_size)
+        return -1;
+
+    char text[STRING_F32_MAX_LENGTH + 1];
+    u32 length = float_f32_to_text(value, text);
+    u64 copy_length = BMIN((u64)length, buffer_size - 1);
+    bcopy_memory(buffer, text, copy_length);
+    buffer[copy_length] = 0;
+    return (i32)length;
+}
+
+i32 string_format_f64(char* buffer, u64 buffer_size, f64 value)
+{
+    if (!buffer || !buffer_size)
+        return -1;
+
+    char text[STRING_F64_MAX_LENGTH + 1];
+    u32 length = float_f64_to_text(value, text);
+    u64 copy_length = BMIN((u64)length, buffer_size - 1);
+    bcopy_memory(buffer, text, copy_length);
+    buffer[copy_length] = 0;
+    return (i32)length;
+}
+
+// Writes the values separated by spaces, each in shortest round-trip form
+static const char* f32_list_to_string(const f32* values, u32 count)
+{
+    char buffer[16 * (STRING_F32_MAX_LENGTH + 1)];
+    u64 length = 0;
+    for (u32 i = 0; i < count; ++i)
+    {
+        if (i > 0)
+            buffer[length++] = ' ';
+        length += (u64)string_format_f32(buffer + length, sizeof(buffer) - length, values[i]);
+    }
+    buffer[length] = 0;
+    return string_duplicate(buffer);
+}
+
 b8 string_to_mat4(const char* str, mat4* out_mat)
 {
     if (!str || !out_mat)
         return false;
 
     bzero_memory(out_mat, sizeof(mat4));
-    i32 result = sscanf(str, "%f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",
-                        &out_mat->data[0],
-                        &out_mat->data[1],
-                        &out_mat->data[2],
-                        &out_mat->data[3],
-                        &out_mat->data[4],
-                        &out_mat->data[5],
-                        &out_mat->data[6],
-                        &out_mat->data[7],
-                        &out_mat->data[8],
-                        &out_mat->data[9],
-                        &out_mat->data[10],
-                        &out_mat->data[11],
-                        &out_mat->data[12],
-                        &out_mat->data[13],
-                        &out_mat->data[14],
-                        &out_mat->data[15]);
-    return result != -1;
+    return string_parse_f32_list(str, string_length(str), out_mat->data, 16) > 0;
 }
 
 const char* mat4_to_string(mat4 m)
 {
-    f32* d = m.data;
-    return string_format("%f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",
-                        d[0],
-                        d[1],
-                        d[2],
-                        d[3],
-                        d[4],
-                        d[5],
-                        d[6],
-                        d[7],
-                        d[8],
-                        d[9],
-                        d[10],
-                        d[11],
-                        d[12],
-                        d[13],
-                        d[14],
-                        d[15]);
+    return f32_list_to_string(m.data, 16);
 }
 
 b8 string_to_vec4(const char* str, vec4* out_vector)
@@ -692,13 +1897,12 @@ b8 string_to_vec4(const char* str, vec4* out_vector)
         return false;
 
     bzero_memory(out_vector, sizeof(vec4));
-    i32 result = sscanf(str, "%f %f %f %f", &out_vector->x, &out_vector->y, &out_vector->z, &out_vector->w);
-    return result != -1;
+    return string_parse_f32_list(str, string_length(str), out_vector->elements, 4) > 0;
 }
 
 const char* vec4_to_string(vec4 v)
 {
-    return string_format("%f %f %f %f", v.x, v.y, v.z, v.w);
+    return f32_list_to_string(v.elements, 4);
 }
 
 b8 string_to_vec3(const char* str, vec3* out_vector)
@@ -707,13 +1911,12 @@ b8 string_to_vec3(const char* str, vec3* out_vector)
         return false;
 
     bzero_memory(out_vector, sizeof(vec3));
-    i32 result = sscanf(str, "%f %f %f", &out_vector->x, &out_vector->y, &out_vector->z);
-    return result != -1;
+    return string_parse_f32_list(str, string_length(str), out_vector->elements, 3) > 0;
 }
 
 const char* vec3_to_string(vec3 v)
 {
-    return string_format("%f %f %f", v.x, v.y, v.z);
+    return f32_list_to_string(v.elements, 3);
 }
 
 b8 string_to_vec2(const char* str, vec2* out_vector)
@@ -722,13 +1925,12 @@ b8 string_to_vec2(const char* str, vec2* out_vector)
         return false;
 
     bzero_memory(out_vector, sizeof(vec2));
-    i32 result = sscanf(str, "%f %f", &out_vector->x, &out_vector->y);
-    return result != -1;
+    return string_parse_f32_list(str, string_length(str), out_vector->elements, 2) > 0;
 }
 
 const char* vec2_to_string(vec2 v)
 {
-    return string_format("%f %f", v.x, v.y);
+    return f32_list_to_string(v.elements, 2);
 }
 
 b8 string_to_f32(const char* str, f32* f)
@@ -737,13 +1939,14 @@ b8 string_to_f32(const char* str, f32* f)
         return false;
 
     *f = 0;
-    i32 result = sscanf(str, "%f", f);
-    return result != -1;
+    return string_parse_f32_list(str, string_length(str), f, 1) == 1;
 }
 
 const char* f32_to_string(f32 f)
 {
-    return string_format("%f", f);
+    char buffer[STRING_F32_MAX_LENGTH + 1];
+    string_format_f32(buffer, sizeof(buffer), f);
+    return string_duplicate(buffer);
 }
 
 b8 string_to_f64(const char* str, f64* f)
@@ -752,13 +1955,16 @@ b8 string_to_f64(const char* str, f64* f)
         return false;
 
     *f = 0;
-    i32 result = sscanf(str, "%lf", f);
-    return result != -1;
+    u64 length = string_length(str);
+    u64 start = string_scan_skip_whitespace(str, length);
+    return string_parse_f64(str + start, length - start, f) != 0;
 }
 
 const char* f64_to_string(f64 f)
 {
-    return string_format("%f", f);
+    char buffer[STRING_F64_MAX_LENGTH + 1];
+    string_format_f64(buffer, sizeof(buffer), f);
+    return string_duplicate(buffer);
 }
 
 b8 string_to_i8(const char* str, i8* i)
@@ -1106,7 +2312,9 @@ void string_append_int(char* dest, const char* source, i64 i)
 
 void string_append_float(char* dest, const char* source, f32 f)
 {
-    sprintf(dest, "%s%f", source, f);
+    char number[STRING_F32_MAX_LENGTH + 1];
+    string_format_f32(number, sizeof(number), f);
+    sprintf(dest, "%s%s", source, number);
 }
 
 void string_append_bool(char* dest, const char* source, b8 b)
@@ -1349,27 +2557,32 @@ void string_to_upper(char* str)
 // ========== BString ==========
 // -----------------------------
 
-void bstring_ensure_allocated(bstring* string, u32 length)
+// Makes sure the string has room for length bytes plus a null terminator, moving it to the heap if need be
+static void bstring_ensure_capacity(bstring* string, u32 length)
 {
-    if (string)
-    {
-        if (string->allocated < length + 1)
-        {
-            char* new_data = ballocate(sizeof(char) * length + 1, MEMORY_TAG_STRING);
-            if (string->data)
-            {
-                // Copy over data if there is data to copy
-                if (string->length > 0)
-                    string_ncopy(new_data, string->data, string->length);
-                // Clean up old data
-                bfree(string->data, sizeof(char) * string->length + 1, MEMORY_TAG_STRING);
-            }
+    if (length < string->capacity)
+        return;
 
-            string->data = new_data;
-            string->length = length;
-            string->allocated = length + 1;
-        }
+    // Grow geometrically, so appending one piece at a time doesn't reallocate every time
+    u32 new_capacity = string->capacity * 2;
+    if (new_capacity < length + 1)
+        new_capacity = length + 1;
+
+    char* new_data = 0;
+    if (string->owns_data)
+    {
+        new_data = breallocate(string->data, string->capacity, new_capacity, MEMORY_TAG_STRING);
+    }
+    else
+    {
+        // Inline or caller-provided storage, so move to the heap
+        new_data = ballocate_uninitialized(new_capacity, MEMORY_TAG_STRING);
+        bcopy_memory(new_data, string->data, string->length + 1);
     }
+
+    string->data = new_data;
+    string->capacity = new_capacity;
+    string->owns_data = true;
 }
 
 void bstring_create(bstring* out_string)
@@ -1380,10 +2593,29 @@ void bstring_create(bstring* out_string)
         return;
     }
 
-    bzero_memory(out_string, sizeof(bstring));
+    out_string->length = 0;
+    out_string->capacity = sizeof(out_string->inline_data);
+    out_string->data = out_string->inline_data;
+    out_string->owns_data = false;
+    out_string->inline_data[0] = 0;  // Null terminator
+}
+
+void bstring_create_from_buffer(char* buffer, u32 buffer_size, bstring* out_string)
+{
+    if (!out_string)
+    {
+        BERROR("bstring_create_from_buffer requires a valid pointer to a string");
+        return;
+    }
 
-    bstring_ensure_allocated(out_string, 0);
-    out_string->data[0] = 0;  // Null terminator
+    bstring_create(out_string);
+    // Only worth using if it is bigger than the inline storage
+    if (buffer && buffer_size > sizeof(out_string->inline_data))
+    {
+        out_string->capacity = buffer_size;
+        out_string->data = buffer;
+        out_string->data[0] = 0;
+    }
 }
 
 void bstring_from_cstring(const char* source, bstring* out_string)
@@ -1394,20 +2626,16 @@ void bstring_from_cstring(const char* source, bstring* out_string)
         return;
     }
 
-    u32 source_length = string_length(source);
-    bzero_memory(out_string, sizeof(bstring));
-
-    bstring_ensure_allocated(out_string, source_length);
-
-    string_ncopy(out_string->data, source, source_length);
-    out_string->data[source_length] = 0;
+    bstring_create(out_string);
+    bstring_append_str(out_string, source);
 }
 
 void bstring_destroy(bstring* string)
 {
     if (string)
     {
-        bfree(string->data, sizeof(char) * string->allocated, MEMORY_TAG_STRING);
+        if (string->owns_data)
+            bfree(string->data, string->capacity, MEMORY_TAG_STRING);
         bzero_memory(string, sizeof(bstring));
     }
 }
@@ -1422,25 +2650,94 @@ u32 bstring_utf8_length(const bstring* string)
     return string ? string_utf8_length(string->data) : 0;
 }
 
-void bstring_append_str(bstring* string, const char* s)
+void bstring_clear(bstring* string)
+{
+    if (string)
+    {
+        string->length = 0;
+        string->data[0] = 0;
+    }
+}
+
+void bstring_reserve(bstring* string, u32 length)
+{
+    if (string)
+        bstring_ensure_capacity(string, length);
+}
+
+void bstring_append_n(bstring* string, const char* s, u32 length)
 {
     if (string && s)
     {
-        u32 length = string_length(s);
-        bstring_ensure_allocated(string, string->length + length);
-        string_ncopy(string->data + string->length, s, length);
-        string->data[string->length + length] = 0;
-        string->length = string->length + length;
+        bstring_ensure_capacity(string, string->length + length);
+        bcopy_memory(string->data + string->length, s, length);
+        string->length += length;
+        string->data[string->length] = 0;
     }
 }
 
+void bstring_append_str(bstring* string, const char* s)
+{
+    if (string && s)
+        bstring_append_n(string, s, string_length(s));
+}
+
 void bstring_append_bstring(bstring* string, const bstring* other)
 {
     if (string && other)
     {
-        bstring_ensure_allocated(string, string->length + other->length);
-        string_ncopy(string->data + string->length, other->data, other->length);
-        string->data[string->length + other->length] = 0;
-        string->length = string->length + other->length;
+        u32 length = other->length;
+        bstring_ensure_capacity(string, string->length + length);
+        // NOTE: other->data is read after growing, in case a string is being appended to itself
+        bcopy_memory(string->data + string->length, other->data, length);
+        string->length += length;
+        string->data[string->length] = 0;
+    }
+}
+
+void bstring_append_char(bstring* string, char c)
+{
+    if (string)
+    {
+        bstring_ensure_capacity(string, string->length + 1);
+        string->data[string->length++] = c;
+        string->data[string->length] = 0;
+    }
+}
+
+void bstring_append_format(bstring* string, const char* format, ...)
+{
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    bstring_append_format_v(string, format, arg_ptr);
+    va_end(arg_ptr);
+}
+
+void bstring_append_format_v(bstring* string, const char* format, void* va_listp)
+{
+    if (!string || !format)
+        return;
+
+    // Format straight into the free space, and only if that's too small grow and format again
+    u32 available = string->capacity - string->length;
+    va_list list_copy;
+#ifdef _MSC_VER
+    list_copy = va_listp;
+#else
+    va_copy(list_copy, va_listp);
+#endif
+    i32 length = vsnprintf(string->data + string->length, available, format, list_copy);
+    va_end(list_copy);
+    if (length < 0)
+    {
+        string->data[string->length] = 0;
+        return;
+    }
+
+    if ((u32)length >= available)
+    {
+        bstring_ensure_capacity(string, string->length + length);
+        vsnprintf(string->data + string->length, length + 1, format, va_listp);
     }
+    string->length += length;
 }
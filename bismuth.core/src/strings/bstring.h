@@ -3,6 +3,8 @@
 #include "defines.h"
 #include "math/math_types.h"
 
+struct frame_allocator_int;
+
 BAPI u64 string_length(const char* str);
 BAPI u32 string_utf8_length(const char* str);
 
@@ -40,6 +42,42 @@ BAPI char* string_format(const char* format, ...);
 // Performs variadic string formatting against the given format string and va_list
 BAPI char* string_format_v(const char* format, void* va_list);
 
+/**
+ * @brief Performs string formatting into a caller-provided buffer, such as one on the stack. Never allocates.
+ * The result is truncated if it doesn't fit, and is always null-terminated as long as dest_size is not 0.
+ *
+ * @param dest The buffer to write to.
+ * @param dest_size The size of dest in bytes, including room for the null terminator.
+ * @param format The string to be formatted.
+ * @returns The length of the full formatted string, not including the null terminator. If this is dest_size or more, the output was truncated. -1 on error.
+ */
+BAPI i32 string_format_to(char* dest, u64 dest_size, const char* format, ...);
+
+// Variadic version of string_format_to()
+BAPI i32 string_format_to_v(char* dest, u64 dest_size, const char* format, void* va_list);
+
+/**
+ * @brief Performs string formatting into memory obtained from the given allocator, such as a frame allocator,
+ * rather than the heap. The string should be released however the allocator expects (i.e. not at all for frame allocators).
+ *
+ * @param allocator A pointer to the allocator interface to use.
+ * @param format The string to be formatted.
+ * @returns The formatted string, or 0 on error.
+ */
+BAPI char* string_format_with_allocator(struct frame_allocator_int* allocator, const char* format, ...);
+
+// Variadic version of string_format_with_allocator()
+BAPI char* string_format_with_allocator_v(struct frame_allocator_int* allocator, const char* format, void* va_list);
+
+/**
+ * @brief Performs string formatting into the calling thread's frame scratch memory. Never touches the heap. The result
+ * must not be freed, and is valid until the end of the next frame. Safe from any thread. See frame_scratch.h.
+ *
+ * @param format The string to be formatted.
+ * @returns The formatted string, or 0 if scratch memory is exhausted or not set up.
+ */
+BAPI char* string_format_scratch(const char* format, ...);
+
 // Performs string formatting to dest given format string and parameters. This version of the function is unsafe. Use string_format() instead
 BDEPRECATED("This version of string format is legacy, and unsafe. Use string_format() instead")
 BAPI i32 string_format_unsafe(char* dest, const char* format, ...);
@@ -223,6 +261,67 @@ BAPI b8 string_to_f64(const char* str, f64* f);
  */
 BAPI const char* f64_to_string(f64 f);
 
+/** @brief The longest text string_format_f32 writes, excluding the null terminator (the smallest negative subnormal). */
+#define STRING_F32_MAX_LENGTH 48
+/** @brief The longest text string_format_f64 writes, excluding the null terminator (the smallest negative subnormal). */
+#define STRING_F64_MAX_LENGTH 327
+
+/**
+ * @brief Parses a 32-bit float of the form [sign]digits[.digits][(e|E)[sign]digits], correctly rounded
+ * to nearest regardless of the number of digits and independent of the current locale. Stops at the first
+ * character which is not part of the number; no leading whitespace is skipped.
+ *
+ * @param str The text to parse. Required.
+ * @param length The number of characters available.
+ * @param out_value A pointer to hold the value. Only written on success. Required.
+ * @return The number of characters consumed, or 0 if there is no number.
+ */
+BAPI u64 string_parse_f32(const char* str, u64 length, f32* out_value);
+
+/**
+ * @brief Parses a 64-bit float. Identical to string_parse_f32 other than the precision.
+ *
+ * @param str The text to parse. Required.
+ * @param length The number of characters available.
+ * @param out_value A pointer to hold the value. Only written on success. Required.
+ * @return The number of characters consumed, or 0 if there is no number.
+ */
+BAPI u64 string_parse_f64(const char* str, u64 length, f64* out_value);
+
+/**
+ * @brief Parses up to count whitespace-separated 32-bit floats, stopping at the first which is missing or malformed.
+ *
+ * @param str The text to parse. Required.
+ * @param length The number of characters available.
+ * @param out_values An array of at least count floats to hold the values. Required.
+ * @param count The maximum number of values to parse.
+ * @return The number of values parsed.
+ */
+BAPI u32 string_parse_f32_list(const char* str, u64 length, f32* out_values, u32 count);
+
+/**
+ * @brief Writes the shortest text which parses back to exactly the same 32-bit float. Always uses plain
+ * notation with at least one digit either side of the point (i.e. "1.0", "0.25", "-120.5"), so it
+ * reads as a float anywhere; infinities and NaNs are written as "inf", "-inf" and "nan".
+ *
+ * @param buffer The buffer to write to. Required.
+ * @param buffer_size The size of the buffer, including room for the null terminator. Longer text is truncated.
+ * @param value The value to write.
+ * @return The length of the full text, as with string_format_to; or -1 if the buffer is invalid.
+ */
+BAPI i32 string_format_f32(char* buffer, u64 buffer_size, f32 value);
+
+/**
+ * @brief Writes the shortest text which parses back to exactly the same 64-bit float. Identical to
+ * string_format_f32 other than the precision.
+ *
+ * @param buffer The buffer to write to. Required.
+ * @param buffer_size The size of the buffer, including room for the null terminator. Longer text is truncated.
+ * @param value The value to write.
+ * @return The length of the full text, as with string_format_to; or -1 if the buffer is invalid.
+ */
+BAPI i32 string_format_f64(char* buffer, u64 buffer_size, f64 value);
+
 /**
  * @brief Attempts to parse an 8-bit signed integer from the provided string.
  * 
@@ -469,24 +568,75 @@ BAPI void string_to_upper(char* str);
 // ========== BString ==========
 // -----------------------------
 
+/** @brief The longest string a bstring can hold without any allocation, not including the null terminator */
+#define BSTRING_INLINE_CAPACITY 46
+
+/**
+ * @brief A growable string, used to build up text piece by piece. Short strings are held inside the
+ * structure itself, and a caller-provided buffer (i.e. on the stack) may also be used as the starting
+ * storage, so most strings are built with no allocations at all. Only once the text outgrows its current
+ * storage does it move to the heap.
+ * @note data may point into the structure itself, so a bstring must not be copied by value.
+ */
 typedef struct bstring
 {
-    // Current length of the string in bytes
+    // Current length of the string in bytes, not including the null terminator
     u32 length;
-    // Amount of currently allocated memory
-    u32 allocated;
-    // TRaw string data
+    // The size of the storage data points to, including room for the null terminator
+    u32 capacity;
+    // The string data. Always null-terminated
     char* data;
+    // Indicates if data was allocated by this string, and so must be freed by it
+    b8 owns_data;
+    // Storage for short strings
+    char inline_data[BSTRING_INLINE_CAPACITY + 1];
 } bstring;
 
+/** @brief Creates an empty string, using its inline storage. */
 BAPI void bstring_create(bstring* out_string);
+
+/**
+ * @brief Creates an empty string which uses the given buffer as its storage until it outgrows it.
+ * The buffer must outlive the string. Any heap storage is still released with bstring_destroy().
+ *
+ * @param buffer The buffer to be used. If smaller than the inline storage, the inline storage is used instead.
+ * @param buffer_size The size of buffer in bytes.
+ * @param out_string A pointer to hold the string.
+ */
+BAPI void bstring_create_from_buffer(char* buffer, u32 buffer_size, bstring* out_string);
 BAPI void bstring_from_cstring(const char* source, bstring* out_string);
 BAPI void bstring_destroy(bstring* string);
 
 BAPI u32 bstring_length(const bstring* string);
 BAPI u32 bstring_utf8_length(const bstring* string);
-BAPI u64 string_nlength(const char* str, u32 max_len);
-BAPI u32 string_utf8_nlength(const char* str, u32 max_len);
+
+/** @brief Empties the string, keeping its current storage. */
+BAPI void bstring_clear(bstring* string);
+
+/** @brief Makes sure the string can hold at least length bytes (not including the null terminator) without growing again. */
+BAPI void bstring_reserve(bstring* string, u32 length);
 
 BAPI void bstring_append_str(bstring* string, const char* s);
 BAPI void bstring_append_bstring(bstring* string, const bstring* other);
+BAPI void bstring_append_char(bstring* string, char c);
+
+/**
+ * @brief Appends the given bytes to the string. The bytes need not be null-terminated.
+ *
+ * @param string A pointer to the string to append to.
+ * @param s The bytes to append.
+ * @param length The number of bytes to append.
+ */
+BAPI void bstring_append_n(bstring* string, const char* s, u32 length);
+
+/**
+ * @brief Performs string formatting and appends the result to the string. Formats directly into the
+ * string's storage, so only allocates if the string needs to grow.
+ *
+ * @param string A pointer to the string to append to.
+ * @param format The string to be formatted.
+ */
+BAPI void bstring_append_format(bstring* string, const char* format, ...);
+
+// Variadic version of bstring_append_format()
+BAPI void bstring_append_format_v(bstring* string, const char* format, void* va_list);
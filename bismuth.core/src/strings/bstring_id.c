@@ -1,13 +1,13 @@
 #include "bstring_id.h"
 
-#include "containers/u64_bst.h"
+#include "containers/u64_btree.h"
 #include "debug/bassert.h"
 #include "bstring.h"
 #include "logger.h"
 #include "utils/crc64.h"
 
 // Global lookup table for saved strings
-static bt_node* bstring_id_lookup = 0;
+static u64_btree bstring_id_lookup = {0};
 
 bstring_id bstring_id_create(const char* str)
 {
@@ -27,33 +27,34 @@ bstring_id bstring_id_create(const char* str)
     BASSERT_MSG(new_string_id != 0, string_format("bstring_id_create - provided string '%s' hashed to 0, an invalid value. Please change the string to something else to avoid this", str));
 
     // Register in a global lookup table if not already there
-    const bt_node* entry = u64_bst_find(bstring_id_lookup, new_string_id);
+    const bt_node_value* entry = u64_btree_find(&bstring_id_lookup, new_string_id);
     if (!entry)
     {
         bt_node_value value;
         value.str = copy;
-        bt_node* inserted = u64_bst_insert(bstring_id_lookup, new_string_id, value);
-        if (!inserted)
+        if (!u64_btree_insert(&bstring_id_lookup, new_string_id, value))
         {
-            BERROR("Failed to save bstring_id string '%s' to global lookup table.");
-        }
-        else if (!bstring_id_lookup)
-        {
-            bstring_id_lookup = inserted;
+            BERROR("Failed to save bstring_id string '%s' to global lookup table.", str);
+            string_free(copy);
         }
     }
+    else
+    {
+        // Already saved, so the copy isn't needed
+        string_free(copy);
+    }
 
     return new_string_id;
 }
 
 const char* bstring_id_string_get(bstring_id stringid)
 {
-    const bt_node* entry = u64_bst_find(bstring_id_lookup, stringid);
+    const bt_node_value* entry = u64_btree_find(&bstring_id_lookup, stringid);
     if (entry)
     {
         // NOTE: For now, just return the existing pointer to the string
         // If this ever becomes a problem, return a copy instead
-        return entry->value.str;
+        return entry->str;
     }
 
     return 0;
@@ -0,0 +1,259 @@
+#include "strings/bstring_scan.h"
+
+#include <string.h> // memcpy
+
+// SSE2 is part of the x86-64 baseline, so it is always available there without any extra compiler flags
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define BSTRING_SCAN_SSE2 1
+#    include <emmintrin.h>
+#endif
+
+// Reading 8 digits at once relies on the first character landing in the lowest byte
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#    define BSTRING_SCAN_SWAR 1
+#endif
+
+// The largest set which is vectorized, one comparison per character
+#define SCAN_SET_MAX_VECTORIZED 16
+
+static b8 scan_in_set(char c, const char* set, u32 set_count)
+{
+    for (u32 s = 0; s < set_count; ++s)
+    {
+        if (c == set[s])
+            return true;
+    }
+    return false;
+}
+
+static b8 scan_is_whitespace(char c)
+{
+    return c == ' ' || (u8)(c - '\t') <= '\r' - '\t';
+}
+
+static b8 scan_is_digit(char c)
+{
+    return (u8)(c - '0') <= 9;
+}
+
+#if BSTRING_SCAN_SSE2
+// Flags each of the 16 characters which is in the set, one bit per character
+static u32 scan_match_set(__m128i chars, const __m128i* set_vectors, u32 set_count)
+{
+    __m128i matches = _mm_cmpeq_epi8(chars, set_vectors[0]);
+    for (u32 s = 1; s < set_count; ++s)
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chars, set_vectors[s]));
+    return (u32)_mm_movemask_epi8(matches);
+}
+
+// Flags each of the 16 characters in the range [low, low + span], one bit per character
+static u32 scan_match_range(__m128i chars, char low, u8 span)
+{
+    // Values below low wrap around to large unsigned values, so a single unsigned comparison covers both ends
+    __m128i offset = _mm_sub_epi8(chars, _mm_set1_epi8(low));
+    __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8((char)span)), offset);
+    return (u32)_mm_movemask_epi8(in_range);
+}
+#endif
+
+u64 string_scan_find_char(const char* str, u64 length, char c)
+{
+    u64 i = 0;
+#if BSTRING_SCAN_SSE2
+    __m128i needle = _mm_set1_epi8(c);
+    for (; i + 16 <= length; i += 16)
+    {
+        u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(str + i)), needle));
+        if (mask)
+            return i + (u32)__builtin_ctz(mask);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        if (str[i] == c)
+            return i;
+    }
+    return length;
+}
+
+u64 string_scan_find_any_of(const char* str, u64 length, const char* set, u32 set_count)
+{
+    if (!set_count)
+        return length;
+    if (set_count == 1)
+        return string_scan_find_char(str, length, set[0]);
+
+    u64 i = 0;
+#if BSTRING_SCAN_SSE2
+    if (set_count <= SCAN_SET_MAX_VECTORIZED)
+    {
+        __m128i set_vectors[SCAN_SET_MAX_VECTORIZED];
+        for (u32 s = 0; s < set_count; ++s)
+            set_vectors[s] = _mm_set1_epi8(set[s]);
+        for (; i + 16 <= length; i += 16)
+        {
+            u32 mask = scan_match_set(_mm_loadu_si128((const __m128i*)(str + i)), set_vectors, set_count);
+            if (mask)
+                return i + (u32)__builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        if (scan_in_set(str[i], set, set_count))
+            return i;
+    }
+    return length;
+}
+
+u64 string_scan_find_newline(const char* str, u64 length)
+{
+    return string_scan_find_any_of(str, length, "\n\r", 2);
+}
+
+u64 string_scan_skip_any_of(const char* str, u64 length, const char* set, u32 set_count)
+{
+    if (!set_count)
+        return 0;
+
+    u64 i = 0;
+#if BSTRING_SCAN_SSE2
+    if (set_count <= SCAN_SET_MAX_VECTORIZED)
+    {
+        __m128i set_vectors[SCAN_SET_MAX_VECTORIZED];
+        for (u32 s = 0; s < set_count; ++s)
+            set_vectors[s] = _mm_set1_epi8(set[s]);
+        for (; i + 16 <= length; i += 16)
+        {
+            u32 mismatch = ~scan_match_set(_mm_loadu_si128((const __m128i*)(str + i)), set_vectors, set_count) & 0xFFFF;
+            if (mismatch)
+                return i + (u32)__builtin_ctz(mismatch);
+        }
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        if (!scan_in_set(str[i], set, set_count))
+            return i;
+    }
+    return length;
+}
+
+u64 string_scan_skip_whitespace(const char* str, u64 length)
+{
+    u64 i = 0;
+#if BSTRING_SCAN_SSE2
+    __m128i space = _mm_set1_epi8(' ');
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(str + i));
+        u32 whitespace = scan_match_range(chars, '\t', '\r' - '\t') | (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, space));
+        u32 mismatch = ~whitespace & 0xFFFF;
+        if (mismatch)
+            return i + (u32)__builtin_ctz(mismatch);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        if (!scan_is_whitespace(str[i]))
+            return i;
+    }
+    return length;
+}
+
+u64 string_scan_skip_digits(const char* str, u64 length)
+{
+    u64 i = 0;
+#if BSTRING_SCAN_SSE2
+    for (; i + 16 <= length; i += 16)
+    {
+        u32 mismatch = ~scan_match_range(_mm_loadu_si128((const __m128i*)(str + i)), '0', 9) & 0xFFFF;
+        if (mismatch)
+            return i + (u32)__builtin_ctz(mismatch);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        if (!scan_is_digit(str[i]))
+            return i;
+    }
+    return length;
+}
+
+#if BSTRING_SCAN_SWAR
+static u64 scan_load_eight(const char* str)
+{
+    u64 value;
+    memcpy(&value, str, sizeof(u64));
+    return value;
+}
+
+// Checks whether all 8 characters packed in the value are digits
+static b8 scan_is_eight_digits(u64 value)
+{
+    return ((value & 0xF0F0F0F0F0F0F0F0ull) | (((value + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+// Converts 8 packed digits to their value by combining pairs, then pairs of pairs, then the two halves
+static u32 scan_parse_eight_digits(u64 value)
+{
+    const u64 mask = 0x000000FF000000FFull;
+    const u64 mul1 = 0x000F424000000064ull; // 100 + (1000000 << 32)
+    const u64 mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+    value -= 0x3030303030303030ull;
+    value = (value * 10) + (value >> 8);
+    value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+    return (u32)value;
+}
+#endif
+
+u64 string_scan_accumulate_digits(const char* str, u64 length, u32 max_digits, u64* value)
+{
+    u64 i = 0;
+    u64 limit = BMIN(length, (u64)max_digits);
+    u64 v = *value;
+#if BSTRING_SCAN_SWAR
+    while (i + 8 <= limit && scan_is_eight_digits(scan_load_eight(str + i)))
+    {
+        v = v * 100000000ull + scan_parse_eight_digits(scan_load_eight(str + i));
+        i += 8;
+    }
+#endif
+    for (; i < limit && scan_is_digit(str[i]); ++i)
+        v = v * 10 + (u64)(str[i] - '0');
+    *value = v;
+    return i;
+}
+
+u64 string_scan_parse_i64(const char* str, u64 length, i64* out_value)
+{
+    u64 i = 0;
+    b8 negative = false;
+    if (i < length && (str[i] == '-' || str[i] == '+'))
+    {
+        negative = str[i] == '-';
+        i++;
+    }
+
+    u64 digits_start = i;
+    u64 value = 0;
+    // Up to 18 digits can never overflow, so take those as quickly as possible
+    i += string_scan_accumulate_digits(str + i, length - i, 18, &value);
+    for (; i < length && scan_is_digit(str[i]); ++i)
+    {
+        u64 digit = (u64)(str[i] - '0');
+        if (value > (U64_MAX - digit) / 10)
+            return 0;
+        value = value * 10 + digit;
+    }
+
+    if (i == digits_start)
+        return 0;
+
+    // The magnitude of the smallest i64 is one more than the largest
+    if (value > (u64)I64_MAX + negative)
+        return 0;
+
+    *out_value = negative ? (i64)(0 - value) : (i64)value;
+    return i;
+}
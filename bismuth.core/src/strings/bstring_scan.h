@@ -0,0 +1,94 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Scanning primitives for text parsers (bson, OBJ, the console and the like), which spend most
+ * of their time skipping runs of whitespace, string contents, comments and digits.
+ *
+ * Every function takes an explicit length and never reads past it, so they work on unterminated
+ * windows of text (i.e. a streamed chunk). Where SSE2 is available, 16 characters are checked at
+ * a time; otherwise each falls back to a plain scalar loop with identical results.
+ */
+
+/**
+ * @brief Finds the first occurrence of the given character.
+ *
+ * @param str The text to search. Required.
+ * @param length The number of characters to search.
+ * @param c The character to find.
+ * @return The index of the character if found; otherwise length.
+ */
+BAPI u64 string_scan_find_char(const char* str, u64 length, char c);
+
+/**
+ * @brief Finds the first character which is any of those in the given set.
+ *
+ * @param str The text to search. Required.
+ * @param length The number of characters to search.
+ * @param set The characters to look for. May include '\0'. Required.
+ * @param set_count The number of characters in the set. Sets of up to 16 characters are vectorized.
+ * @return The index of the first matching character if found; otherwise length.
+ */
+BAPI u64 string_scan_find_any_of(const char* str, u64 length, const char* set, u32 set_count);
+
+/**
+ * @brief Finds the end of the current line, i.e. the first '\n' or '\r'.
+ *
+ * @param str The text to search. Required.
+ * @param length The number of characters to search.
+ * @return The index of the first newline character if found; otherwise length.
+ */
+BAPI u64 string_scan_find_newline(const char* str, u64 length);
+
+/**
+ * @brief Skips past all leading characters which are in the given set.
+ *
+ * @param str The text to scan. Required.
+ * @param length The number of characters to scan.
+ * @param set The characters to skip. Required.
+ * @param set_count The number of characters in the set. Sets of up to 16 characters are vectorized.
+ * @return The index of the first character not in the set, or length if all of them are.
+ */
+BAPI u64 string_scan_skip_any_of(const char* str, u64 length, const char* set, u32 set_count);
+
+/**
+ * @brief Skips past all leading whitespace (space, \t, \n, \v, \f and \r).
+ *
+ * @param str The text to scan. Required.
+ * @param length The number of characters to scan.
+ * @return The index of the first non-whitespace character, or length if there is none.
+ */
+BAPI u64 string_scan_skip_whitespace(const char* str, u64 length);
+
+/**
+ * @brief Skips past all leading decimal digits.
+ *
+ * @param str The text to scan. Required.
+ * @param length The number of characters to scan.
+ * @return The index of the first non-digit character, or length if there is none.
+ */
+BAPI u64 string_scan_skip_digits(const char* str, u64 length);
+
+/**
+ * @brief Reads up to max_digits leading decimal digits, appending each to value, i.e. value * 10 + digit.
+ * The caller is responsible for making sure the result fits, i.e. 19 digits always fit in a zeroed value.
+ *
+ * @param str The text to read. Required.
+ * @param length The number of characters available.
+ * @param max_digits The maximum number of digits to read.
+ * @param value A pointer to the value to append the digits to. Required.
+ * @return The number of digits read.
+ */
+BAPI u64 string_scan_accumulate_digits(const char* str, u64 length, u32 max_digits, u64* value);
+
+/**
+ * @brief Parses a decimal integer with an optional leading sign. Stops at the first character
+ * which is not part of the number; no leading whitespace is skipped.
+ *
+ * @param str The text to parse. Required.
+ * @param length The number of characters available.
+ * @param out_value A pointer to hold the value. Only written on success. Required.
+ * @return The number of characters consumed, or 0 if there is no number or it does not fit in an i64.
+ */
+BAPI u64 string_scan_parse_i64(const char* str, u64 length, i64* out_value);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @file batomic.h
+ * @brief Thin wrappers around the compiler's atomic intrinsics. All operations
+ * work on naturally-aligned plain integer/pointer storage, so atomics can be
+ * embedded in existing structures without changing their layout.
+ */
+
+#if defined(__clang__) || defined(__gcc__)
+
+/** @brief Hints to the processor that the calling thread is in a spin-wait loop */
+#define batomic_pause() __builtin_ia32_pause()
+
+/** @brief Full memory barrier */
+#define batomic_thread_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+BINLINE u8 batomic_load_u8(volatile u8* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+BINLINE void batomic_store_u8(volatile u8* ptr, u8 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+
+BINLINE u32 batomic_load_u32(volatile u32* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+BINLINE u32 batomic_load_relaxed_u32(volatile u32* ptr) { return __atomic_load_n(ptr, __ATOMIC_RELAXED); }
+BINLINE void batomic_store_u32(volatile u32* ptr, u32 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+BINLINE void batomic_store_relaxed_u32(volatile u32* ptr, u32 value) { __atomic_store_n(ptr, value, __ATOMIC_RELAXED); }
+BINLINE u32 batomic_exchange_u32(volatile u32* ptr, u32 value) { return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Adds value to the target and returns the value held _before_ the add */
+BINLINE u32 batomic_fetch_add_u32(volatile u32* ptr, u32 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Subtracts value from the target and returns the value held _before_ the subtract */
+BINLINE u32 batomic_fetch_sub_u32(volatile u32* ptr, u32 value) { return __atomic_fetch_sub(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Stores desired if the target holds *expected. On failure, *expected is updated with the current value */
+BINLINE b8 batomic_compare_exchange_u32(volatile u32* ptr, u32* expected, u32 desired) { return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); }
+
+BINLINE u64 batomic_load_u64(volatile u64* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+BINLINE u64 batomic_load_relaxed_u64(volatile u64* ptr) { return __atomic_load_n(ptr, __ATOMIC_RELAXED); }
+BINLINE void batomic_store_u64(volatile u64* ptr, u64 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+BINLINE void batomic_store_relaxed_u64(volatile u64* ptr, u64 value) { __atomic_store_n(ptr, value, __ATOMIC_RELAXED); }
+BINLINE u64 batomic_exchange_u64(volatile u64* ptr, u64 value) { return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Adds value to the target and returns the value held _before_ the add */
+BINLINE u64 batomic_fetch_add_u64(volatile u64* ptr, u64 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Subtracts value from the target and returns the value held _before_ the subtract */
+BINLINE u64 batomic_fetch_sub_u64(volatile u64* ptr, u64 value) { return __atomic_fetch_sub(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Stores desired if the target holds *expected. On failure, *expected is updated with the current value */
+BINLINE b8 batomic_compare_exchange_u64(volatile u64* ptr, u64* expected, u64 desired) { return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); }
+
+BINLINE void* batomic_load_ptr(void* volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+BINLINE void batomic_store_ptr(void* volatile* ptr, void* value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+BINLINE void* batomic_exchange_ptr(void* volatile* ptr, void* value) { return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL); }
+/** @brief Stores desired if the target holds *expected. On failure, *expected is updated with the current value */
+BINLINE b8 batomic_compare_exchange_ptr(void* volatile* ptr, void** expected, void* desired) { return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); }
+
+#else
+#error "Unsupported compiler - don't know how to define atomic operations!"
+#endif
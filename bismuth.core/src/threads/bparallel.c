@@ -0,0 +1,27 @@
+#include "bparallel.h"
+
+#include "threads/batomic.h"
+
+static pfn_parallel_for dispatcher_ptr = 0;
+
+void bparallel_for_dispatcher_set(pfn_parallel_for dispatcher)
+{
+    batomic_store_ptr((void* volatile*)&dispatcher_ptr, (void*)dispatcher);
+}
+
+b8 bparallel_for_available(void)
+{
+    return batomic_load_ptr((void* volatile*)&dispatcher_ptr) != 0;
+}
+
+void bparallel_for(u32 count, u32 grain, pfn_parallel_range fn, void* user)
+{
+    if (!count || !fn)
+        return;
+
+    pfn_parallel_for dispatcher = (pfn_parallel_for)batomic_load_ptr((void* volatile*)&dispatcher_ptr);
+    if (dispatcher)
+        dispatcher(count, grain, fn, user);
+    else
+        fn(0, count, user);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief Processes the items [begin, end) of a larger range. Called once per chunk,
+ * possibly from several threads at once, so chunks must only write their own items.
+ */
+typedef void (*pfn_parallel_range)(u32 begin, u32 end, void* user);
+
+/** @brief Splits count items into chunks of up to grain items, runs fn over all of them and returns once every chunk is done. */
+typedef void (*pfn_parallel_for)(u32 count, u32 grain, pfn_parallel_range fn, void* user);
+
+/**
+ * @brief Sets the function used to spread bparallel_for work across threads. Core has no threads
+ * of its own, so this is provided by whatever does (i.e. the job system). Pass 0 to clear it.
+ */
+BAPI void bparallel_for_dispatcher_set(pfn_parallel_for dispatcher);
+
+/** @brief Indicates if a dispatcher is set, meaning bparallel_for can actually run in parallel. */
+BAPI b8 bparallel_for_available(void);
+
+/**
+ * @brief Runs fn over the range [0, count) in chunks of up to grain items, in parallel if a
+ * dispatcher is set, and returns once all of them are done. Without one, fn is simply called
+ * once with the whole range on the calling thread.
+ */
+BAPI void bparallel_for(u32 count, u32 grain, pfn_parallel_range fn, void* user);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "defines.h"
+#include "threads/batomic.h"
+
+/**
+ * @brief A lightweight, non-recursive user-space lock. Intended to guard very
+ * short critical sections (a handful of pointer swaps) where the cost of a
+ * bmutex (an OS object) would dominate. Never hold one across anything that
+ * could block.
+ */
+typedef struct bspinlock
+{
+    volatile u32 locked;
+} bspinlock;
+
+BINLINE void bspinlock_create(bspinlock* out_lock)
+{
+    out_lock->locked = 0;
+}
+
+BINLINE b8 bspinlock_try_lock(bspinlock* lock)
+{
+    return batomic_load_relaxed_u32(&lock->locked) == 0 && batomic_exchange_u32(&lock->locked, 1) == 0;
+}
+
+BINLINE void bspinlock_lock(bspinlock* lock)
+{
+    while (batomic_exchange_u32(&lock->locked, 1) != 0)
+    {
+        // Spin on a plain load so the cache line is not hammered with writes
+        while (batomic_load_relaxed_u32(&lock->locked) != 0)
+            batomic_pause();
+    }
+}
+
+BINLINE void bspinlock_unlock(bspinlock* lock)
+{
+    batomic_store_u32(&lock->locked, 0);
+}
@@ -37,6 +37,9 @@ static u32 worker_thread_loop(void* params)
 
     BTRACE("Worker thread work complete");
 
+    // Hand back any cached allocations before the thread goes away
+    memory_system_thread_release();
+
     return 1;
 }
 
@@ -0,0 +1,112 @@
+#include "bhash.h"
+
+// Odd constants with an even mix of set bits, which the input is folded against
+#define BHASH_SECRET_0 0xa0761d6478bd642fULL
+#define BHASH_SECRET_1 0xe7037ed1a0b428dbULL
+#define BHASH_SECRET_2 0x8ebc6af09c88c6e3ULL
+#define BHASH_SECRET_3 0x589965cc75374cc3ULL
+
+// Multiplies a and b into a full 128-bit result, returning the low half in a and the high half in b
+static void multiply_128(u64* a, u64* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t result = (__uint128_t)*a * *b;
+    *a = (u64)result;
+    *b = (u64)(result >> 64);
+#else
+    u64 a_high = *a >> 32, a_low = (u32)*a;
+    u64 b_high = *b >> 32, b_low = (u32)*b;
+    u64 high = a_high * b_high;
+    u64 middle_0 = a_high * b_low;
+    u64 middle_1 = a_low * b_high;
+    u64 low = a_low * b_low;
+    u64 middle = (low >> 32) + (u32)middle_0 + (u32)middle_1;
+    *a = (middle << 32) | (u32)low;
+    *b = high + (middle_0 >> 32) + (middle_1 >> 32) + (middle >> 32);
+#endif
+}
+
+static u64 mix(u64 a, u64 b)
+{
+    multiply_128(&a, &b);
+    return a ^ b;
+}
+
+// Little-endian reads, regardless of alignment
+static u64 read_u64(const u8* p)
+{
+    return (u64)p[0] | ((u64)p[1] << 8) | ((u64)p[2] << 16) | ((u64)p[3] << 24) |
+           ((u64)p[4] << 32) | ((u64)p[5] << 40) | ((u64)p[6] << 48) | ((u64)p[7] << 56);
+}
+
+static u64 read_u32(const u8* p)
+{
+    return (u64)p[0] | ((u64)p[1] << 8) | ((u64)p[2] << 16) | ((u64)p[3] << 24);
+}
+
+// Reads 1-3 bytes, covering all of them with (possibly overlapping) reads from the start, middle and end
+static u64 read_small(const u8* p, u64 length)
+{
+    return ((u64)p[0] << 16) | ((u64)p[length >> 1] << 8) | p[length - 1];
+}
+
+u64 bhash64(const void* data, u64 length, u64 seed)
+{
+    const u8* p = data;
+    seed ^= mix(seed ^ BHASH_SECRET_0, BHASH_SECRET_1);
+
+    u64 a;
+    u64 b;
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            // Two overlapping pairs of 4-byte reads cover anything from 4 to 16 bytes
+            u64 offset = (length >> 3) << 2;
+            a = (read_u32(p) << 32) | read_u32(p + offset);
+            b = (read_u32(p + length - 4) << 32) | read_u32(p + length - 4 - offset);
+        }
+        else if (length > 0)
+        {
+            a = read_small(p, length);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        u64 remaining = length;
+        if (remaining > 48)
+        {
+            // Three independent lanes, so the multiplies can overlap
+            u64 seed_1 = seed;
+            u64 seed_2 = seed;
+            do
+            {
+                seed = mix(read_u64(p) ^ BHASH_SECRET_1, read_u64(p + 8) ^ seed);
+                seed_1 = mix(read_u64(p + 16) ^ BHASH_SECRET_2, read_u64(p + 24) ^ seed_1);
+                seed_2 = mix(read_u64(p + 32) ^ BHASH_SECRET_3, read_u64(p + 40) ^ seed_2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed_1 ^ seed_2;
+        }
+        while (remaining > 16)
+        {
+            seed = mix(read_u64(p) ^ BHASH_SECRET_1, read_u64(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        // The last 16 bytes, overlapping what came before if need be
+        a = read_u64(p + remaining - 16);
+        b = read_u64(p + remaining - 8);
+    }
+
+    a ^= BHASH_SECRET_1;
+    b ^= seed;
+    multiply_128(&a, &b);
+    return mix(a ^ BHASH_SECRET_0 ^ length, b ^ BHASH_SECRET_1);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Computes a fast, well-distributed 64-bit hash of the given data (wyhash-style: 64-bit
+ * multiply-mixing, reading up to 48 bytes per step). Several times faster than crc64,
+ * especially for longer data.
+ *
+ * NOTE: The result is not guaranteed to stay the same between versions of the engine,
+ * so should only be used for in-memory lookups. Anything which is saved, or must match
+ * an existing value (i.e. bnames and bstring_ids), should use crc64 instead.
+ *
+ * @param data A constant pointer to a buffer of length bytes.
+ * @param length Number of bytes in the data buffer.
+ * @param seed A value to vary the hash by. Can pass 0.
+ */
+BAPI u64 bhash64(const void* data, u64 length, u64 seed);
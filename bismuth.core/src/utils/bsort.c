@@ -16,46 +16,224 @@ static void* data_at_index(void* block, u64 element_size, u32 index)
     return (void*)(addr);
 }
 
-static i32 bquick_sort_partition(void* scratch_mem, u64 size, void* data, i32 low_index, i32 high_index, PFN_bquicksort_compare compare_pfn)
+// Elements up to this size are swapped through a buffer on the stack rather than an allocated one
+#define BSORT_STACK_SCRATCH_SIZE 256
+
+// Sorts small ranges. Each element is held in the scratch memory while larger ones shift up past it
+static void insertion_sort(void* scratch_mem, u8* data, u64 size, u32 count, PFN_bquicksort_compare compare_pfn)
+{
+    for (u32 i = 1; i < count; ++i)
+    {
+        u8* current = data_at_index(data, size, i);
+        if (compare_pfn(current, current - size) <= 0)
+            continue;
+
+        bcopy_memory(scratch_mem, current, size);
+        u32 j = i;
+        for (; j > 0 && compare_pfn(scratch_mem, data_at_index(data, size, j - 1)) > 0; --j)
+            bcopy_memory(data_at_index(data, size, j), data_at_index(data, size, j - 1), size);
+        bcopy_memory(data_at_index(data, size, j), scratch_mem, size);
+    }
+}
+
+static void heap_sift(void* scratch_mem, u8* data, u64 size, u32 root, u32 count, PFN_bquicksort_compare compare_pfn)
+{
+    for (u32 child = root * 2 + 1; child < count; child = root * 2 + 1)
+    {
+        if (child + 1 < count && compare_pfn(data_at_index(data, size, child), data_at_index(data, size, child + 1)) > 0)
+            child++;
+        if (compare_pfn(data_at_index(data, size, root), data_at_index(data, size, child)) <= 0)
+            break;
+        ptr_swap(scratch_mem, size, data_at_index(data, size, root), data_at_index(data, size, child));
+        root = child;
+    }
+}
+
+// The fallback for when partitioning keeps going badly. Always O(n log n)
+static void heap_sort(void* scratch_mem, u8* data, u64 size, u32 count, PFN_bquicksort_compare compare_pfn)
+{
+    for (u32 i = count / 2; i > 0; --i)
+        heap_sift(scratch_mem, data, size, i - 1, count, compare_pfn);
+    for (u32 end = count - 1; end > 0; --end)
+    {
+        ptr_swap(scratch_mem, size, data, data_at_index(data, size, end));
+        heap_sift(scratch_mem, data, size, 0, end, compare_pfn);
+    }
+}
+
+static u32 bquick_sort_partition(void* scratch_mem, u8* data, u64 size, u32 count, PFN_bquicksort_compare compare_pfn)
 {
-    void* pivot = data_at_index(data, size, high_index);
-    i32 i = (low_index - 1);
+    // Median of three goes to the front as the pivot
+    u8* first = data;
+    u8* mid = data_at_index(data, size, count / 2);
+    u8* last = data_at_index(data, size, count - 1);
+    if (compare_pfn(mid, first) > 0)
+        ptr_swap(scratch_mem, size, mid, first);
+    if (compare_pfn(last, mid) > 0)
+    {
+        ptr_swap(scratch_mem, size, last, mid);
+        if (compare_pfn(mid, first) > 0)
+            ptr_swap(scratch_mem, size, mid, first);
+    }
+    ptr_swap(scratch_mem, size, first, mid);
 
-    for (i32 j = low_index; j <= high_index - 1; ++j)
+    // NOTE: The pivot stays at the front until the end, so can be compared in place
+    u32 i = 0;
+    u32 j = count;
+    for (;;)
     {
-        void* dataj = data_at_index(data, size, j);
-        i32 result = compare_pfn(dataj, pivot);
-        if (result > 0)
+        // Both scans stop at values equal to the pivot, so runs of them split evenly
+        while (compare_pfn(data_at_index(data, size, ++i), first) > 0)
         {
-            ++i;
-            void* datai = data_at_index(data, size, i);
-            ptr_swap(scratch_mem, size, datai, dataj);
+            if (i == count - 1)
+                break;
         }
+        while (compare_pfn(first, data_at_index(data, size, --j)) > 0)
+        {
+            if (j == 0)
+                break;
+        }
+        if (i >= j)
+            break;
+        ptr_swap(scratch_mem, size, data_at_index(data, size, i), data_at_index(data, size, j));
     }
-    ptr_swap(scratch_mem, size, data_at_index(data, size, i + 1), data_at_index(data, size, high_index));
-    return i + 1;
+    ptr_swap(scratch_mem, size, first, data_at_index(data, size, j));
+    return j;
 }
 
-static void bquick_sort_internal(void* scratch_mem, u64 size, void* data, i32 low_index, i32 high_index, PFN_bquicksort_compare compare_pfn)
+static void bquick_sort_internal(void* scratch_mem, u8* data, u64 size, u32 count, u32 depth_limit, PFN_bquicksort_compare compare_pfn)
 {
-    if (low_index < high_index)
+    while (count > BSORT_INSERTION_THRESHOLD)
     {
-        i32 partition_index = bquick_sort_partition(scratch_mem, size, data, low_index, high_index, compare_pfn);
-        bquick_sort_internal(scratch_mem, size, data, low_index, partition_index - 1, compare_pfn);
-        bquick_sort_internal(scratch_mem, size, data, partition_index + 1, high_index, compare_pfn);
+        if (depth_limit == 0)
+        {
+            heap_sort(scratch_mem, data, size, count, compare_pfn);
+            return;
+        }
+        depth_limit--;
+
+        u32 split = bquick_sort_partition(scratch_mem, data, size, count, compare_pfn);
+        // Recurse into the smaller side and carry on with the larger, which keeps the stack shallow
+        u32 right_count = count - split - 1;
+        if (split < right_count)
+        {
+            bquick_sort_internal(scratch_mem, data, size, split, depth_limit, compare_pfn);
+            data = data_at_index(data, size, split + 1);
+            count = right_count;
+        }
+        else
+        {
+            bquick_sort_internal(scratch_mem, data_at_index(data, size, split + 1), size, right_count, depth_limit, compare_pfn);
+            count = split;
+        }
     }
+    insertion_sort(scratch_mem, data, size, count, compare_pfn);
 }
 
 void bquick_sort(u64 type_size, void* data, i32 low_index, i32 high_index, PFN_bquicksort_compare compare_pfn)
 {
-    if (low_index < high_index)
-    {
-        void* scratch_mem = ballocate(type_size, MEMORY_TAG_ARRAY);
-        i32 partition_index = bquick_sort_partition(scratch_mem, type_size, data, low_index, high_index, compare_pfn);
-        bquick_sort_internal(scratch_mem, type_size, data, low_index, partition_index - 1, compare_pfn);
-        bquick_sort_internal(scratch_mem, type_size, data, partition_index + 1, high_index, compare_pfn);
+    if (!data || !compare_pfn || low_index >= high_index)
+        return;
+
+    u32 count = (u32)(high_index - low_index) + 1;
+    // Partitioning is allowed to go badly for up to twice the ideal depth before heapsort takes over
+    u32 depth_limit = 0;
+    for (u32 n = count; n > 1; n >>= 1)
+        depth_limit += 2;
+
+    u8 stack_scratch[BSORT_STACK_SCRATCH_SIZE];
+    void* scratch_mem = type_size <= BSORT_STACK_SCRATCH_SIZE ? stack_scratch : ballocate(type_size, MEMORY_TAG_ARRAY);
+    bquick_sort_internal(scratch_mem, data_at_index(data, type_size, low_index), type_size, count, depth_limit, compare_pfn);
+    if (scratch_mem != stack_scratch)
         bfree(scratch_mem, type_size, MEMORY_TAG_ARRAY);
+}
+
+// Counts how many keys have each value of each digit, all in one pass
+#define RADIX_HISTOGRAMS(keys, count, digit_count, histograms)        \
+    for (u32 i = 0; i < (count); ++i)                                 \
+    {                                                                 \
+        u64 key = (keys)[i].key;                                      \
+        for (u32 d = 0; d < (digit_count); ++d)                       \
+            (histograms)[d][(key >> (d * 8)) & 0xFF]++;               \
+    }
+
+// Scatters keys into place by one digit. Keys keep their order within each bucket, which is what makes the sort stable
+#define RADIX_PASS(source, dest, count, digit, histogram)             \
+    {                                                                 \
+        u32 offset = 0;                                               \
+        for (u32 b = 0; b < 256; ++b)                                 \
+        {                                                             \
+            u32 bucket_count = (histogram)[b];                        \
+            (histogram)[b] = offset;                                  \
+            offset += bucket_count;                                   \
+        }                                                             \
+        for (u32 i = 0; i < (count); ++i)                             \
+        {                                                             \
+            u32 bucket = ((source)[i].key >> ((digit) * 8)) & 0xFF;   \
+            (dest)[(histogram)[bucket]++] = (source)[i];              \
+        }                                                             \
+    }
+
+void bradix_sort_u32(bsort_key_u32* keys, u32 count, bsort_key_u32* scratch)
+{
+    if (!keys || count < 2)
+        return;
+
+    b8 owns_scratch = !scratch;
+    if (owns_scratch)
+        scratch = ballocate_uninitialized(sizeof(bsort_key_u32) * count, MEMORY_TAG_ARRAY);
+
+    u32 histograms[4][256] = {0};
+    RADIX_HISTOGRAMS(keys, count, 4, histograms);
+
+    bsort_key_u32* source = keys;
+    bsort_key_u32* dest = scratch;
+    for (u32 d = 0; d < 4; ++d)
+    {
+        // A digit which is the same for every key wouldn't change anything
+        if (histograms[d][(source[0].key >> (d * 8)) & 0xFF] == count)
+            continue;
+        RADIX_PASS(source, dest, count, d, histograms[d]);
+        bsort_key_u32* temp = source;
+        source = dest;
+        dest = temp;
     }
+    if (source != keys)
+        bcopy_memory(keys, source, sizeof(bsort_key_u32) * count);
+
+    if (owns_scratch)
+        bfree(scratch, sizeof(bsort_key_u32) * count, MEMORY_TAG_ARRAY);
+}
+
+void bradix_sort_u64(bsort_key_u64* keys, u32 count, bsort_key_u64* scratch)
+{
+    if (!keys || count < 2)
+        return;
+
+    b8 owns_scratch = !scratch;
+    if (owns_scratch)
+        scratch = ballocate_uninitialized(sizeof(bsort_key_u64) * count, MEMORY_TAG_ARRAY);
+
+    u32 histograms[8][256] = {0};
+    RADIX_HISTOGRAMS(keys, count, 8, histograms);
+
+    bsort_key_u64* source = keys;
+    bsort_key_u64* dest = scratch;
+    for (u32 d = 0; d < 8; ++d)
+    {
+        // A digit which is the same for every key wouldn't change anything
+        if (histograms[d][(source[0].key >> (d * 8)) & 0xFF] == count)
+            continue;
+        RADIX_PASS(source, dest, count, d, histograms[d]);
+        bsort_key_u64* temp = source;
+        source = dest;
+        dest = temp;
+    }
+    if (source != keys)
+        bcopy_memory(keys, source, sizeof(bsort_key_u64) * count);
+
+    if (owns_scratch)
+        bfree(scratch, sizeof(bsort_key_u64) * count, MEMORY_TAG_ARRAY);
 }
 
 i32 bquicksort_compare_u32_desc(void* a, void* b)
@@ -2,11 +2,209 @@
 
 #include "defines.h"
 
+/**
+ * @brief Compares two elements for sorting.
+ * @returns A positive value if a should be sorted before b, a negative value if b should be sorted before a; otherwise 0.
+ */
 typedef i32 (*PFN_bquicksort_compare)(void* a, void* b);
 
 BAPI void ptr_swap(void* scratch_mem, u64 size, void* a, void* b);
 
+/**
+ * @brief Sorts the elements from low_index to high_index (inclusive) in place. Uses introsort:
+ * quicksort with a median-of-three pivot, handing small ranges to insertion sort and falling
+ * back to heapsort if partitioning goes badly, so it never degrades to O(n^2). Not stable.
+ *
+ * @param type_size The size of each element in bytes.
+ * @param data The array of elements to sort.
+ * @param low_index The index of the first element to sort.
+ * @param high_index The index of the last element to sort.
+ * @param compare_pfn The comparison function. See PFN_bquicksort_compare.
+ */
 BAPI void bquick_sort(u64 type_size, void* data, i32 low_index, i32 high_index, PFN_bquicksort_compare compare_pfn);
 
 BAPI i32 bquicksort_compare_u32_desc(void* a, void* b);
 BAPI i32 bquicksort_compare_u32(void* a, void* b);
+
+/** @brief A u32 sort key, along with the index of the element it belongs to. */
+typedef struct bsort_key_u32
+{
+    u32 key;
+    u32 index;
+} bsort_key_u32;
+
+/** @brief A u64 sort key, along with the index of the element it belongs to. */
+typedef struct bsort_key_u64
+{
+    u64 key;
+    u32 index;
+} bsort_key_u64;
+
+/**
+ * @brief Sorts the given keys into ascending order with a stable LSD radix sort. Takes linear time,
+ * so is well suited to large arrays. Sort the keys, then use each one's index to visit the elements in order.
+ *
+ * @param keys The keys to be sorted.
+ * @param count The number of keys.
+ * @param scratch Room for count keys to be used while sorting. Optional; allocated internally if not provided.
+ */
+BAPI void bradix_sort_u32(bsort_key_u32* keys, u32 count, bsort_key_u32* scratch);
+
+/**
+ * @brief Sorts the given keys into ascending order with a stable LSD radix sort. Takes linear time,
+ * so is well suited to large arrays. Sort the keys, then use each one's index to visit the elements in order.
+ *
+ * @param keys The keys to be sorted.
+ * @param count The number of keys.
+ * @param scratch Room for count keys to be used while sorting. Optional; allocated internally if not provided.
+ */
+BAPI void bradix_sort_u64(bsort_key_u64* keys, u32 count, bsort_key_u64* scratch);
+
+/**
+ * @brief Converts a float to a u32 sort key which orders the same way the float does,
+ * including negative values. Invert the result (~key) to sort in descending order.
+ */
+BINLINE u32 bsort_key_from_f32(f32 value)
+{
+    union
+    {
+        f32 f;
+        u32 u;
+    } bits;
+    bits.f = value;
+    // Negative values have every bit flipped so larger magnitudes sort first, positive ones just have the sign bit set
+    return (bits.u & 0x80000000u) ? ~bits.u : (bits.u | 0x80000000u);
+}
+
+/** @brief Ranges this small or smaller are sorted with insertion sort instead of being partitioned further. */
+#define BSORT_INSERTION_THRESHOLD 16
+
+/** @brief For use with BSORT_DEFINE. Sorts values which support < into ascending order. */
+#define BSORT_ASCENDING(a, b) (*(a) < *(b))
+/** @brief For use with BSORT_DEFINE. Sorts values which support > into descending order. */
+#define BSORT_DESCENDING(a, b) (*(a) > *(b))
+
+/**
+ * @brief Defines a sorting function specialised for a single type, called as name(type* data, u32 count).
+ * Uses the same introsort as bquick_sort(), but the comparison is inlined and elements are moved by
+ * assignment, which makes it several times faster. Not stable. Use at file scope.
+ *
+ * @param name The name of the function to define.
+ * @param type The type of the elements to be sorted.
+ * @param before A macro or function taking (const type* a, const type* b), which is true if a should be sorted before b.
+ */
+#define BSORT_DEFINE(name, type, before)                                                     \
+    static void name##_insertion(type* data, u32 count)                                      \
+    {                                                                                        \
+        for (u32 i = 1; i < count; ++i)                                                      \
+        {                                                                                    \
+            type value = data[i];                                                            \
+            u32 j = i;                                                                       \
+            for (; j > 0 && before(&value, &data[j - 1]); --j)                               \
+                data[j] = data[j - 1];                                                       \
+            data[j] = value;                                                                 \
+        }                                                                                    \
+    }                                                                                        \
+    static void name##_sift(type* data, u32 root, u32 count)                                 \
+    {                                                                                        \
+        type value = data[root];                                                             \
+        for (u32 child = root * 2 + 1; child < count; child = root * 2 + 1)                  \
+        {                                                                                    \
+            if (child + 1 < count && before(&data[child], &data[child + 1]))                 \
+                child++;                                                                     \
+            if (!before(&value, &data[child]))                                               \
+                break;                                                                       \
+            data[root] = data[child];                                                        \
+            root = child;                                                                    \
+        }                                                                                    \
+        data[root] = value;                                                                  \
+    }                                                                                        \
+    static void name##_heap(type* data, u32 count)                                           \
+    {                                                                                        \
+        for (u32 i = count / 2; i > 0; --i)                                                  \
+            name##_sift(data, i - 1, count);                                                 \
+        for (u32 end = count - 1; end > 0; --end)                                            \
+        {                                                                                    \
+            type temp = data[0];                                                             \
+            data[0] = data[end];                                                             \
+            data[end] = temp;                                                                \
+            name##_sift(data, 0, end);                                                       \
+        }                                                                                    \
+    }                                                                                        \
+    static u32 name##_partition(type* data, u32 count)                                       \
+    {                                                                                        \
+        /* Median of three goes to the front as the pivot */                                 \
+        u32 mid = count / 2;                                                                 \
+        u32 last = count - 1;                                                                \
+        type temp;                                                                           \
+        if (before(&data[mid], &data[0]))                                                    \
+        {                                                                                    \
+            temp = data[mid];                                                                \
+            data[mid] = data[0];                                                             \
+            data[0] = temp;                                                                  \
+        }                                                                                    \
+        if (before(&data[last], &data[mid]))                                                 \
+        {                                                                                    \
+            temp = data[last];                                                               \
+            data[last] = data[mid];                                                          \
+            data[mid] = temp;                                                                \
+            if (before(&data[mid], &data[0]))                                                \
+            {                                                                                \
+                temp = data[mid];                                                            \
+                data[mid] = data[0];                                                         \
+                data[0] = temp;                                                              \
+            }                                                                                \
+        }                                                                                    \
+        temp = data[mid];                                                                    \
+        data[mid] = data[0];                                                                 \
+        data[0] = temp;                                                                      \
+        type pivot = data[0];                                                                \
+        u32 i = 0;                                                                           \
+        u32 j = count;                                                                       \
+        for (;;)                                                                             \
+        {                                                                                    \
+            /* Both scans stop at values equal to the pivot, so runs of them split evenly */ \
+            while (before(&data[++i], &pivot))                                               \
+                if (i == last)                                                               \
+                    break;                                                                   \
+            while (before(&pivot, &data[--j]))                                               \
+                if (j == 0)                                                                  \
+                    break;                                                                   \
+            if (i >= j)                                                                      \
+                break;                                                                       \
+            temp = data[i];                                                                  \
+            data[i] = data[j];                                                               \
+            data[j] = temp;                                                                  \
+        }                                                                                    \
+        data[0] = data[j];                                                                   \
+        data[j] = pivot;                                                                     \
+        return j;                                                                            \
+    }                                                                                        \
+    static void name(type* data, u32 count)                                                  \
+    {                                                                                        \
+        u32 depth_limit = 0;                                                                 \
+        for (u32 n = count; n > 1; n >>= 1)                                                  \
+            depth_limit += 2;                                                                \
+        while (count > BSORT_INSERTION_THRESHOLD)                                            \
+        {                                                                                    \
+            if (depth_limit-- == 0)                                                          \
+            {                                                                                \
+                name##_heap(data, count);                                                    \
+                return;                                                                      \
+            }                                                                                \
+            u32 split = name##_partition(data, count);                                       \
+            /* Recurse into the smaller side, and carry on with the larger */                \
+            if (split < count - split - 1)                                                   \
+            {                                                                                \
+                name(data, split);                                                           \
+                data += split + 1;                                                           \
+                count -= split + 1;                                                          \
+            }                                                                                \
+            else                                                                             \
+            {                                                                                \
+                name(data + split + 1, count - split - 1);                                   \
+                count = split;                                                               \
+            }                                                                                \
+        }                                                                                    \
+        name##_insertion(data, count);                                                       \
+    }
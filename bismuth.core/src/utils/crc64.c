@@ -44,6 +44,9 @@
 
 #include "crc64.h"
 
+#include "threads/batomic.h"
+#include "threads/bspinlock.h"
+
 #include <stdint.h>
 
 static const uint64_t crc64_tab[256] = {
@@ -305,11 +308,100 @@ static const uint64_t crc64_tab[256] = {
     UINT64_C(0x29b7d047efec8728),
 };
 
+/*
+ * NOTE: Slice-by-8. Table k gives the effect of a byte followed by k zero bytes, so eight
+ * bytes can be folded into the crc at once with eight independent lookups. Tables 1-7 are
+ * derived from the one above the first time they are needed.
+ */
+static u64 crc64_slice_tab[7][256];
+static volatile u32 crc64_slice_tab_ready = 0;
+static bspinlock crc64_slice_tab_lock = {0};
+
+static void crc64_slice_tab_ensure(void)
+{
+    if (batomic_load_u32(&crc64_slice_tab_ready))
+        return;
+
+    bspinlock_lock(&crc64_slice_tab_lock);
+    if (!crc64_slice_tab_ready)
+    {
+        for (u32 n = 0; n < 256; ++n)
+        {
+            u64 crc = crc64_tab[n];
+            for (u32 k = 0; k < 7; ++k)
+            {
+                crc = crc64_tab[(u8)crc] ^ (crc >> 8);
+                crc64_slice_tab[k][n] = crc;
+            }
+        }
+        batomic_store_u32(&crc64_slice_tab_ready, 1);
+    }
+    bspinlock_unlock(&crc64_slice_tab_lock);
+}
+
+// Reads 8 bytes as a little-endian value, regardless of alignment
+static u64 read_u64_le(const u8* data)
+{
+    return (u64)data[0] | ((u64)data[1] << 8) | ((u64)data[2] << 16) | ((u64)data[3] << 24) |
+           ((u64)data[4] << 32) | ((u64)data[5] << 40) | ((u64)data[6] << 48) | ((u64)data[7] << 56);
+}
+
+static u64 crc64_fold_u64(u64 crc, u64 word)
+{
+    crc ^= word;
+    return crc64_slice_tab[6][(u8)crc] ^
+           crc64_slice_tab[5][(u8)(crc >> 8)] ^
+           crc64_slice_tab[4][(u8)(crc >> 16)] ^
+           crc64_slice_tab[3][(u8)(crc >> 24)] ^
+           crc64_slice_tab[2][(u8)(crc >> 32)] ^
+           crc64_slice_tab[1][(u8)(crc >> 40)] ^
+           crc64_slice_tab[0][(u8)(crc >> 48)] ^
+           crc64_tab[crc >> 56];
+}
+
+// Lowercases all eight ASCII bytes of a word at once. Bytes outside 'A'-'Z' (including any above 0x7F) are left alone
+static u64 word_to_lower(u64 word)
+{
+    const u64 low_bits = 0x7F7F7F7F7F7F7F7FULL;
+    const u64 high_bits = 0x8080808080808080ULL;
+    u64 low = word & low_bits;
+    // The high bit of each byte ends up set if the byte is >= 'A', and clear if it is > 'Z'
+    u64 at_least_a = low + 0x3F3F3F3F3F3F3F3FULL;
+    u64 above_z = low + 0x2525252525252525ULL;
+    u64 upper = at_least_a & ~above_z & ~word & high_bits;
+    // 0x80 >> 2 is 0x20, the difference between upper and lower case
+    return word | (upper >> 2);
+}
+
 u64 crc64(u64 crc, const u8* data, u64 length)
 {
-    for (u64 j = 0; j < length; ++j)
+    crc64_slice_tab_ensure();
+
+    u64 j = 0;
+    for (; j + 8 <= length; j += 8)
+        crc = crc64_fold_u64(crc, read_u64_le(data + j));
+
+    for (; j < length; ++j)
+    {
+        u8 byte = data[j];
+        crc = crc64_tab[(u8)crc ^ byte] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+u64 crc64_lowercase(u64 crc, const u8* data, u64 length)
+{
+    crc64_slice_tab_ensure();
+
+    u64 j = 0;
+    for (; j + 8 <= length; j += 8)
+        crc = crc64_fold_u64(crc, word_to_lower(read_u64_le(data + j)));
+
+    for (; j < length; ++j)
     {
         u8 byte = data[j];
+        if (byte >= 'A' && byte <= 'Z')
+            byte += ('a' - 'A');
         crc = crc64_tab[(u8)crc ^ byte] ^ (crc >> 8);
     }
     return crc;
@@ -10,3 +10,13 @@
  * @param length Number of bytes in the data buffer.
  */
 BAPI u64 crc64(u64 crc, const u8* data, u64 length);
+
+/**
+ * Compute crc64 of the given data as if it had been converted to lowercase first (ASCII only,
+ * matching string_to_lower), without needing a lowercase copy of it.
+ *
+ * @param crc The current crc value. Can pass 0 for a new one.
+ * @param data A constant pointer to a buffer of length bytes.
+ * @param length Number of bytes in the data buffer.
+ */
+BAPI u64 crc64_lowercase(u64 crc, const u8* data, u64 length);
@@ -845,6 +845,7 @@ static u32 source_work_thread(void* params)
         if (!source->data_mutex.internal_data)
         {
             // This can happen during unexpected shutdown, and if so kill the thread
+            memory_system_thread_release();
             return 0;
         }
         bmutex_lock(&source->data_mutex);
@@ -867,6 +868,7 @@ static u32 source_work_thread(void* params)
     }
 
     BDEBUG("Audio source thread shutting down");
+    memory_system_thread_release();
     return 0;
 }
 
@@ -26,12 +26,17 @@ b8 basset_importer_static_mesh_obj_import(const struct basset_importer* self, u6
     basset_static_mesh* typed_asset = (basset_static_mesh*)out_asset;
     const char* material_file_name = 0;
 
+    // Options are optional here. Without them, everything is left at its default
+    basset_static_mesh_import_options options = {0};
+    if (params)
+        options = *(basset_static_mesh_import_options*)params;
+
     struct vfs_state* vfs = engine_systems_get()->vfs_system_state;
 
     // Handle OBJ file import
     {
         obj_source_asset obj_asset = {0};
-        if (!obj_serializer_deserialize(data, &obj_asset))
+        if (!obj_serializer_deserialize(data, options.parallel_tangents, &obj_asset))
         {
             BERROR("OBJ file import failed! See logs for details");
             return false;
@@ -7,6 +7,7 @@
 #include <math/bmath.h>
 #include <memory/bmemory.h>
 #include <strings/bstring.h>
+#include <strings/bstring_scan.h>
 
 #include <stdio.h> // sscanf
 
@@ -29,6 +30,7 @@ typedef struct mesh_group_data
 } mesh_group_data;
 
 static void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, obj_source_geometry* out_data);
+static void obj_parse_face(const char* line, u64 length, b8 full, mesh_face_data* out_face);
 
 b8 obj_serializer_serialize(const obj_source_asset* out_source_asset, const char** out_file_text)
 {
@@ -36,7 +38,7 @@ b8 obj_serializer_serialize(const obj_source_asset* out_source_asset, const char
     return false;
 }
 
-b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_source_asset)
+b8 obj_serializer_deserialize(const char* obj_file_text, b8 parallel_tangents, obj_source_asset* out_source_asset)
 {
     if (!obj_file_text || !out_source_asset)
     {
@@ -65,28 +67,29 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
     u8 current_mat_name_count = 0;
     char material_names[32][64];
 
+    // Names are read from a terminated copy of their line
     char line_buf[512] = "";
-    char* p = &line_buf[0];
-    u32 line_length = 0;
-    u8 addl_advance = 0;
 
     // index 0 is previous, 1 is previous before that
     char prev_first_chars[2] = {0, 0};
-    u32 start_from = 0;
-    while (true)
+    u64 text_length = string_length(obj_file_text);
+    u64 line_start = 0;
+    while (line_start < text_length)
     {
-        start_from += line_length + addl_advance;
-        if (!string_line_get(obj_file_text, 511, start_from, &p, &line_length, &addl_advance))
-        {
-            /* if (!filesystem_read_line(obj_file, 511, &p, &line_length)) { */
-            break;
-        }
+        // Lines are parsed in place, ending at the next newline
+        const char* line = obj_file_text + line_start;
+        u64 line_length = string_scan_find_newline(line, text_length - line_start);
+        line_start += line_length + 1;
+        // Treat \r\n as a single line break
+        if (line[line_length] == '\r' && line[line_length + 1] == '\n')
+            line_start++;
 
         // Skip blank lines
         if (line_length < 1)
             continue;
 
-        char first_char = line_buf[0];
+        u64 copy_length = BMIN(line_length, sizeof(line_buf) - 1);
+        char first_char = line[0];
 
         switch (first_char)
         {
@@ -95,35 +98,34 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
             continue;
         case 'v':
         {
-            char second_char = line_buf[1];
+            if (line_length < 2)
+                break;
+            char second_char = line[1];
             switch (second_char)
             {
             case ' ':
             {
                 // Vertex position
-                vec3 pos;
-                char t[2];
-                sscanf(line_buf, "%s %f %f %f", t, &pos.x, &pos.y, &pos.z);
+                vec3 pos = {0};
+                string_parse_f32_list(line + 1, line_length - 1, pos.elements, 3);
 
                 darray_push(positions, pos);
             } break;
             case 'n':
             {
                 // Vertex normal
-                vec3 norm;
-                char t[2];
-                sscanf(line_buf, "%s %f %f %f", t, &norm.x, &norm.y, &norm.z);
+                vec3 norm = {0};
+                string_parse_f32_list(line + 2, line_length - 2, norm.elements, 3);
 
                 darray_push(normals, norm);
             } break;
             case 't':
             {
                 // Vertex texture coords
-                vec2 tex_coord;
-                char t[2];
+                vec2 tex_coord = {0};
 
                 // NOTE: Ignoring Z if present
-                sscanf(line_buf, "%s %f %f", t, &tex_coord.x, &tex_coord.y);
+                string_parse_f32_list(line + 2, line_length - 2, tex_coord.elements, 2);
 
                 darray_push(tex_coords, tex_coord);
             } break;
@@ -136,31 +138,13 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
         {
             // face
             // f 1/1/1 2/2/2 3/3/3  = pos/tex/norm pos/tex/norm pos/tex/norm
-            mesh_face_data face;
-            char t[2];
+            mesh_face_data face = {0};
 
             u64 normal_count = darray_length(normals);
             u64 tex_coord_count = darray_length(tex_coords);
 
-            if (normal_count == 0 || tex_coord_count == 0)
-            {
-                sscanf(line_buf, "%s %d %d %d", t, &face.vertices[0].position_index,
-                       &face.vertices[1].position_index,
-                       &face.vertices[2].position_index);
-            }
-            else
-            {
-                sscanf(line_buf, "%s %d/%d/%d %d/%d/%d %d/%d/%d", t,
-                       &face.vertices[0].position_index,
-                       &face.vertices[0].texcoord_index, &face.vertices[0].normal_index,
-
-                       &face.vertices[1].position_index,
-                       &face.vertices[1].texcoord_index, &face.vertices[1].normal_index,
-
-                       &face.vertices[2].position_index,
-                       &face.vertices[2].texcoord_index,
-                       &face.vertices[2].normal_index);
-            }
+            // Positions only, unless there are both normals and texture coordinates
+            obj_parse_face(line + 1, line_length - 1, normal_count != 0 && tex_coord_count != 0, &face);
             u64 group_index = darray_length(groups) - 1;
             darray_push(groups[group_index].faces, face);
         } break;
@@ -168,6 +152,8 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
         {
             // Material library file
             char substr[7];
+            bcopy_memory(line_buf, line, copy_length);
+            line_buf[copy_length] = 0;
 
             sscanf(line_buf, "%s %s", substr, material_file_name);
 
@@ -189,6 +175,8 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
             // usemtl
             // Read the material name
             char t[8];
+            bcopy_memory(line_buf, line, copy_length);
+            line_buf[copy_length] = 0;
             sscanf(line_buf, "%s %s", t, material_names[current_mat_name_count]);
             current_mat_name_count++;
         } break;
@@ -222,6 +210,8 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
 
             // Read the name
             char t[2];
+            bcopy_memory(line_buf, line, copy_length);
+            line_buf[copy_length] = 0;
             sscanf(line_buf, "%s %s", t, name);
         } break;
         }
@@ -304,7 +294,10 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
         g->indices = indices;
 
         // Also generate tangents here, this way tangents are also stored in the output file
-        geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
+        if (parallel_tangents)
+            geometry_generate_tangents_parallel(g->vertex_count, g->vertices, g->index_count, g->indices);
+        else
+            geometry_generate_tangents(g->vertex_count, g->vertices, g->index_count, g->indices);
     }
 
     // Take a copy of the array since the output doesn't need to be a darray
@@ -316,6 +309,33 @@ b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_s
     return true;
 }
 
+// Parses the 3 vertices of a face, each either as a position index only or as pos/tex/norm if full
+static void obj_parse_face(const char* line, u64 length, b8 full, mesh_face_data* out_face)
+{
+    u64 i = 0;
+    for (u32 v = 0; v < 3; ++v)
+    {
+        mesh_vertex_index_data* vertex = &out_face->vertices[v];
+        u32* indices[3] = {&vertex->position_index, &vertex->texcoord_index, &vertex->normal_index};
+        i += string_scan_skip_whitespace(line + i, length - i);
+        for (u32 n = 0; n < (full ? 3u : 1u); ++n)
+        {
+            if (n > 0)
+            {
+                if (i >= length || line[i] != '/')
+                    return;
+                i++;
+            }
+            i64 index = 0;
+            u64 consumed = string_scan_parse_i64(line + i, length - i, &index);
+            if (!consumed)
+                return;
+            *indices[n] = (u32)index;
+            i += consumed;
+        }
+    }
+}
+
 static void process_subobject(vec3* positions, vec3* normals, vec2* tex_coords, mesh_face_data* faces, obj_source_geometry* out_data)
 {
     out_data->indices = darray_create(u32);
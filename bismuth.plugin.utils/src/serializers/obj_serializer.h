@@ -39,4 +39,4 @@ typedef struct obj_source_asset
 } obj_source_asset;
 
 BAPI b8 obj_serializer_serialize(const obj_source_asset* out_source_asset, const char** out_file_text);
-BAPI b8 obj_serializer_deserialize(const char* obj_file_text, obj_source_asset* out_source_asset);
+BAPI b8 obj_serializer_deserialize(const char* obj_file_text, b8 parallel_tangents, obj_source_asset* out_source_asset);
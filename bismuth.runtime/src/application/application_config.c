@@ -44,6 +44,13 @@ b8 application_config_parse_file_content(const char* file_content, application_c
     else
         out_config->frame_allocator_size = (u64)frame_alloc_size;
 
+    // frame_scratch_size is optional, so use a default if it isn't defined
+    i64 frame_scratch_size = 0;
+    if (!bson_object_property_value_get_int(&app_config_tree.root, "frame_scratch_size", &frame_scratch_size) || frame_scratch_size <= 0)
+        out_config->frame_scratch_size = MEBIBYTES(1);
+    else
+        out_config->frame_scratch_size = (u64)frame_scratch_size;
+
     // app_frame_data_size is optional, so use a defualt if it isn't defined
     i64 iapp_frame_data_size = 0; // bson doesn't do unsigned ints, so convert it after
     if (!bson_object_property_value_get_int(&app_config_tree.root, "app_frame_data_size", &iapp_frame_data_size))
@@ -53,6 +53,9 @@ typedef struct application_config
     /** @brief The size of the engine's frame allocator */
     u64 frame_allocator_size;
 
+    /** @brief The size of each per-thread frame scratch arena. Every thread using scratch memory gets two of these */
+    u64 frame_scratch_size;
+
     /** @brief The size of the application-specific frame data. Set to 0 if not used */
     u64 app_frame_data_size;
 
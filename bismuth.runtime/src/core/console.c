@@ -7,6 +7,7 @@
 #include "logger.h"
 #include "memory/bmemory.h"
 #include "strings/bstring.h"
+#include "strings/bstring_scan.h"
 
 typedef struct console_consumer
 {
@@ -75,6 +76,8 @@ void console_shutdown(struct console_state* state)
         darray_destroy(state_ptr->registered_objects);
 
         bzero_memory(state, sizeof(console_state) + (sizeof(console_consumer) * MAX_CONSUMER_COUNT));
+        // Anything logged from here on (i.e. the leak report at shutdown) goes straight to the platform console
+        logger_console_write_hook_set(0);
     }
 
     state_ptr = 0;
@@ -1217,6 +1220,44 @@ console_expression_parse_cleanup:
     return false;
 }
 
+// Splits a command into its name and arguments, separated by whitespace. Arguments wrapped in double quotes are taken whole, whitespace and all
+static u32 console_command_split(const char* command, char*** parts)
+{
+    u32 part_count = 0;
+    u64 length = string_length(command);
+    u64 i = string_scan_skip_whitespace(command, length);
+    while (i < length)
+    {
+        u64 start = i;
+        u64 end;
+        if (command[i] == '"')
+        {
+            start = i + 1;
+            end = start + string_scan_find_char(command + start, length - start, '"');
+            // Move past the closing quote, if there is one
+            i = end < length ? end + 1 : end;
+        }
+        else
+        {
+            end = i + string_scan_find_any_of(command + i, length - i, " \t\r\n", 4);
+            i = end;
+        }
+
+        u64 part_length = end - start;
+        char* part = ballocate(sizeof(char) * (part_length + 1), MEMORY_TAG_STRING);
+        bcopy_memory(part, command + start, part_length);
+        part[part_length] = 0;
+        char** a = *parts;
+        darray_push(a, part);
+        *parts = a;
+        part_count++;
+
+        i += string_scan_skip_whitespace(command + i, length - i);
+    }
+
+    return part_count;
+}
+
 b8 console_command_execute(const char* command)
 {
     if (!command)
@@ -1224,8 +1265,7 @@ b8 console_command_execute(const char* command)
 
     b8 has_error = true;
     char** parts = darray_create(char*);
-    // TODO: If strings are ever used as arguments, this will split improperly
-    u32 part_count = string_split(command, ' ', &parts, true, false);
+    u32 part_count = console_command_split(command, &parts);
     if (part_count < 1)
     {
         has_error = true;
@@ -7,6 +7,7 @@
 #include <identifiers/uuid.h>
 #include <logger.h>
 #include <memory/allocators/linear_allocator.h>
+#include <memory/frame_scratch.h>
 #include <memory/bmemory.h>
 #include <platform/filesystem.h>
 #include <platform/platform.h>
@@ -66,6 +67,8 @@ typedef struct engine_state_t
     u8 logfile_consumer_id;
     // Log file handle
     file_handle log_file_handle;
+    // Per-frame allocation trace, written as CSV while valid. See the memory_trace_start console command
+    file_handle memory_trace_file;
 
     // Engine system states
     engine_system_states systems;
@@ -116,6 +119,11 @@ static void engine_on_process_mouse_move(i16 x, i16 y);
 static void engine_on_process_mouse_wheel(i8 z_delta);
 static b8 engine_log_file_write(void* engine, log_level level, const char* message);
 static b8 engine_platform_console_write(void* platform, log_level level, const char* message);
+static void engine_memory_trace_write(void);
+static void engine_console_command_memory_stats(console_command_context context);
+static void engine_console_command_memory_trace_start(console_command_context context);
+static void engine_console_command_memory_trace_stop(console_command_context context);
+static void engine_console_command_memory_call_sites(console_command_context context);
 
 b8 engine_create(application* app)
 {
@@ -655,6 +663,20 @@ b8 engine_create(application* app)
     engine_state->p_frame_data.allocator.free = frame_allocator_free;
     engine_state->p_frame_data.allocator.free_all = frame_allocator_free_all;
 
+    // Setup the per-thread scratch arenas
+    if (!frame_scratch_initialize(app->app_config.frame_scratch_size))
+    {
+        BFATAL("Failed to initialize frame scratch arenas. Application cannot continue");
+        return false;
+    }
+    engine_state->p_frame_data.scratch_allocator = frame_scratch_allocator_get();
+
+    // Allocation stats
+    console_command_register("memory_stats", 0, engine_state, engine_console_command_memory_stats);
+    console_command_register("memory_trace_start", 1, engine_state, engine_console_command_memory_trace_start);
+    console_command_register("memory_trace_stop", 0, engine_state, engine_console_command_memory_trace_stop);
+    console_command_register("memory_call_sites", 0, engine_state, engine_console_command_memory_call_sites);
+
     // Allocate for the application's frame data.
     if (app->app_config.app_frame_data_size > 0)
         engine_state->p_frame_data.application_frame_data = ballocate(app->app_config.app_frame_data_size, MEMORY_TAG_GAME);
@@ -711,6 +733,12 @@ b8 engine_run(application* app)
 
             // Reset the frame allocator
             engine_state->p_frame_data.allocator.free_all();
+            // Start a new scratch frame. Scratch from the previous frame is still valid until the next one
+            frame_scratch_frame_advance();
+            // Close out allocation stats for the previous frame
+            memory_system_frame_mark();
+            if (engine_state->memory_trace_file.is_valid)
+                engine_memory_trace_write();
 
             // TODO: Update systems here that need them
             job_system_update(engine_state->systems.job_system, &engine_state->p_frame_data);
@@ -901,6 +929,10 @@ b8 engine_run(application* app)
         bresource_system_shutdown(systems->bresource_state);
         renderer_system_shutdown(systems->renderer_system);
         job_system_shutdown(systems->job_system);
+        // Job threads are gone now, so nothing can still be using scratch memory
+        frame_scratch_shutdown();
+        if (engine_state->memory_trace_file.is_valid)
+            filesystem_close(&engine_state->memory_trace_file);
         input_system_shutdown(systems->input_system);
         event_system_shutdown(systems->event_system);
         bvar_system_shutdown(systems->bvar_system);
@@ -1045,3 +1077,104 @@ static b8 engine_platform_console_write(void* platform, log_level level, const c
     platform_console_write(platform, level, message);
     return true;
 }
+
+static void engine_memory_trace_write(void)
+{
+    memory_system_stats stats;
+    if (!memory_system_stats_get(&stats))
+        return;
+
+    // Lines are formatted on the stack, since allocating here would show up in the counters being traced
+    char line[256];
+
+    // Only tags which allocated during the frame, to keep the trace small
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
+    {
+        const memory_tag_stats* tag = &stats.tags[i];
+        if (!tag->frame_allocation_count)
+            continue;
+
+        string_format_to(line, sizeof(line), "%llu,%s,%llu,%llu,%llu,%llu", stats.frame_number, memory_tag_name((memory_tag)i), tag->frame_allocation_count, tag->frame_allocated_bytes, tag->allocated, tag->peak_allocated);
+        if (!filesystem_write_line(&engine_state->memory_trace_file, line))
+        {
+            BERROR("Failed to write to memory trace file. Stopping trace");
+            filesystem_close(&engine_state->memory_trace_file);
+            return;
+        }
+    }
+}
+
+static void engine_console_command_memory_stats(console_command_context context)
+{
+    memory_system_stats stats;
+    if (!memory_system_stats_get(&stats))
+    {
+        BERROR("Unable to obtain memory stats");
+        return;
+    }
+
+    f32 total_amount = 1.0f;
+    const char* total_unit = get_unit_for_size(stats.total_allocated, &total_amount);
+    f32 peak_amount = 1.0f;
+    const char* peak_unit = get_unit_for_size(stats.peak_total_allocated, &peak_amount);
+    BINFO("Memory: %.2f%s allocated (peak %.2f%s), %llu live allocations. Last frame: %llu allocations, %llu bytes",
+          total_amount, total_unit, peak_amount, peak_unit, stats.live_allocation_count, stats.frame_allocation_count, stats.frame_allocated_bytes);
+
+    // Where last frame's allocations came from
+    for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
+    {
+        const memory_tag_stats* tag = &stats.tags[i];
+        if (!tag->frame_allocation_count)
+            continue;
+
+        // The most common allocation size over the tag's lifetime
+        u32 common_bucket = 0;
+        for (u32 b = 1; b < MEMORY_SIZE_HISTOGRAM_BUCKETS; ++b)
+        {
+            if (tag->size_histogram[b] > tag->size_histogram[common_bucket])
+                common_bucket = b;
+        }
+        u64 common_limit = memory_size_histogram_bucket_limit(common_bucket);
+        if (common_limit == U64_MAX)
+        {
+            BINFO("  %-12s: %llu allocations, %llu bytes (mostly > %lluB)", memory_tag_name((memory_tag)i), tag->frame_allocation_count, tag->frame_allocated_bytes, memory_size_histogram_bucket_limit(common_bucket - 1));
+        }
+        else
+        {
+            BINFO("  %-12s: %llu allocations, %llu bytes (mostly <= %lluB)", memory_tag_name((memory_tag)i), tag->frame_allocation_count, tag->frame_allocated_bytes, common_limit);
+        }
+    }
+}
+
+static void engine_console_command_memory_trace_start(console_command_context context)
+{
+    // NOTE: argument count is verified by the console
+    const char* path = context.arguments[0].value;
+    if (engine_state->memory_trace_file.is_valid)
+        filesystem_close(&engine_state->memory_trace_file);
+
+    if (!filesystem_open(path, FILE_MODE_WRITE, false, &engine_state->memory_trace_file))
+    {
+        BERROR("Unable to open memory trace file '%s'", path);
+        return;
+    }
+    filesystem_write_line(&engine_state->memory_trace_file, "frame,tag,allocations,allocated_bytes,live_bytes,peak_bytes");
+    BINFO("Tracing per-frame allocations to '%s'", path);
+}
+
+static void engine_console_command_memory_trace_stop(console_command_context context)
+{
+    if (!engine_state->memory_trace_file.is_valid)
+    {
+        BWARN("No memory trace is running");
+        return;
+    }
+    filesystem_close(&engine_state->memory_trace_file);
+    BINFO("Memory trace stopped");
+}
+
+static void engine_console_command_memory_call_sites(console_command_context context)
+{
+    // NOTE: Only has anything to report in builds with BMEMORY_TRACK_CALL_SITES enabled
+    memory_call_sites_report(10);
+}
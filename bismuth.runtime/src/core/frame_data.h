@@ -13,9 +13,13 @@ typedef struct frame_data
     // Number of meshes drawn in the shadow pass in the last frame
     u32 drawn_shadow_mesh_count;
 
-    // An allocator used for per-frame allocations
+    // An allocator used for per-frame allocations. Main thread only
     frame_allocator_int allocator;
 
+    // Allocates from the calling thread's scratch arena, so is safe to use from job entry points.
+    // Allocations stay valid through the next frame, so results can be read from completion callbacks
+    frame_allocator_int scratch_allocator;
+
     // Application level frame specific data. Optional, up to the app to know how to use this if needed
     void* application_frame_data;
 } frame_data;
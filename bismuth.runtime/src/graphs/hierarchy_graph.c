@@ -9,6 +9,7 @@
 #include "logger.h"
 #include "math/bmath.h"
 #include "memory/bmemory.h"
+#include "systems/job_system.h"
 #include "systems/xform_system.h"
 
 static bhandle node_acquire(hierarchy_graph* graph, u32 parent_index, bhandle xform_handle);
@@ -19,6 +20,10 @@ static void build_view_tree(hierarchy_graph* graph, hierarchy_graph_view* out_vi
 static void destroy_view_tree(hierarchy_graph* graph, hierarchy_graph_view* out_view);
 static void hierarchy_graph_update_tree_view_node(hierarchy_graph* graph, u32 node_index);
 static u32 hierarchy_graph_parent_index_get(const hierarchy_graph* graph, bhandle node_handle);
+static void hierarchy_graph_update_roots(u32 begin, u32 end, void* user);
+
+// The number of root subtrees handed to a job thread at a time during a parallel update
+#define HIERARCHY_GRAPH_ROOT_GRAIN 4
 
 b8 hierarchy_graph_create(hierarchy_graph* out_graph)
 {
@@ -82,6 +87,13 @@ void hierarchy_graph_update(hierarchy_graph* graph)
 
     // Traverse the tree and update the transforms
     u32 root_count = darray_length(graph->view.root_indices);
+    if (graph->parallel_update)
+    {
+        // Each root's subtree only touches its own xforms, so they can be updated independently
+        job_system_parallel_for(root_count, HIERARCHY_GRAPH_ROOT_GRAIN, hierarchy_graph_update_roots, graph);
+        return;
+    }
+
     for (u32 i = 0; i < root_count; ++i)
     {
         // Roots have no parent, so no world matrix is passed
@@ -536,6 +548,13 @@ static void destroy_view_tree(hierarchy_graph* graph, hierarchy_graph_view* view
     }
 }
 
+static void hierarchy_graph_update_roots(u32 begin, u32 end, void* user)
+{
+    hierarchy_graph* graph = user;
+    for (u32 i = begin; i < end; ++i)
+        hierarchy_graph_update_tree_view_node(graph, graph->view.root_indices[i]);
+}
+
 static void hierarchy_graph_update_tree_view_node(hierarchy_graph* graph, u32 node_index)
 {
     if (node_index == INVALID_ID)
@@ -32,6 +32,9 @@ typedef struct hierarchy_graph
     bhandle* xform_handles;
 
     hierarchy_graph_view view;
+
+    // If set, the subtrees under each root are updated in parallel across the job threads
+    b8 parallel_update;
 } hierarchy_graph;
 
 BAPI b8 hierarchy_graph_create(hierarchy_graph* out_graph);
@@ -1066,12 +1066,13 @@ b8 renderer_renderbuffer_create(const char* name, renderbuffer_type type, u64 to
 
     out_buffer->track_type = track_type;
 
-    // Create freelist, if needed
+    // Create freelist, if needed. Geometry buffers see lots of differently-sized loads/unloads, so use
+    // segregated-fit to keep allocations constant-time regardless of fragmentation
     if (track_type == RENDERBUFFER_TRACK_TYPE_FREELIST)
     {
-        freelist_create(total_size, &out_buffer->freelist_memory_requirement, 0, 0);
+        freelist_create_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &out_buffer->freelist_memory_requirement, 0, 0);
         out_buffer->freelist_block = ballocate(out_buffer->freelist_memory_requirement, MEMORY_TAG_RENDERER);
-        freelist_create(total_size, &out_buffer->freelist_memory_requirement, out_buffer->freelist_block, &out_buffer->buffer_freelist);
+        freelist_create_mode(total_size, FREELIST_MODE_SEGREGATED_FIT, &out_buffer->freelist_memory_requirement, out_buffer->freelist_block, &out_buffer->buffer_freelist);
     }
     else if (track_type == RENDERBUFFER_TRACK_TYPE_LINEAR)
     {
@@ -1211,7 +1212,7 @@ b8 renderer_renderbuffer_resize(renderbuffer* buffer, u64 new_total_size)
     {
         // Resize freelist first, if used
         u64 new_memory_requirement = 0;
-        freelist_resize(&buffer->buffer_freelist, &new_memory_requirement, 0, 0, 0);
+        freelist_resize(&buffer->buffer_freelist, &new_memory_requirement, 0, new_total_size, 0);
         void* new_block = ballocate(new_memory_requirement, MEMORY_TAG_RENDERER);
         void* old_block = 0;
         if (!freelist_resize(&buffer->buffer_freelist, &new_memory_requirement, new_block, new_total_size, &old_block))
@@ -33,6 +33,7 @@
 #include "strings/bstring.h"
 #include "strings/bstring_id.h"
 #include "systems/bresource_system.h"
+#include "systems/job_system.h"
 #include "systems/light_system.h"
 #include "systems/material_system.h"
 #include "systems/static_mesh_system.h"
@@ -108,23 +109,44 @@ typedef struct geometry_distance
     f32 distance;
 } geometry_distance;
 
-static i32 geometry_render_data_compare(void* a, void* b)
+// Sorts opaque geometries by material and appends transparent ones furthest-first
+static void geometries_sort(frame_data* p_frame_data, geometry_render_data** out_geometries, geometry_distance* transparent_geometries)
 {
-    geometry_render_data* a_typed = a;
-    geometry_render_data* b_typed = b;
-    return a_typed->material.material.handle_index - b_typed->material.material.handle_index;
-}
+    u32 opaque_count = darray_length(*out_geometries);
+    u32 transparent_count = darray_length(transparent_geometries);
+    u32 key_count = opaque_count > transparent_count ? opaque_count : transparent_count;
+    if (!key_count)
+        return;
 
-static i32 geometry_distance_compare(void* a, void* b)
-{
-    geometry_distance* a_typed = a;
-    geometry_distance* b_typed = b;
-    if (a_typed->distance > b_typed->distance)
-        return 1;
-    else if (a_typed->distance < b_typed->distance)
-        return -1;
-
-    return 0;
+    bsort_key_u32* keys = p_frame_data->allocator.allocate(sizeof(bsort_key_u32) * key_count * 2);
+    bsort_key_u32* scratch = keys + key_count;
+
+    // Sort opaque geometries by material. Only the keys move during the sort, and it is stable,
+    // so geometries sharing a material keep their relative order
+    if (opaque_count > 1)
+    {
+        for (u32 i = 0; i < opaque_count; ++i)
+        {
+            keys[i].key = (*out_geometries)[i].material.material.handle_index;
+            keys[i].index = i;
+        }
+        bradix_sort_u32(keys, opaque_count, scratch);
+
+        geometry_render_data* sorted = p_frame_data->allocator.allocate(sizeof(geometry_render_data) * opaque_count);
+        for (u32 i = 0; i < opaque_count; ++i)
+            sorted[i] = (*out_geometries)[keys[i].index];
+        bcopy_memory(*out_geometries, sorted, sizeof(geometry_render_data) * opaque_count);
+    }
+
+    // Sort transparent geometries furthest first, then add them after the opaque ones
+    for (u32 i = 0; i < transparent_count; ++i)
+    {
+        keys[i].key = ~bsort_key_from_f32(transparent_geometries[i].distance);
+        keys[i].index = i;
+    }
+    bradix_sort_u32(keys, transparent_count, scratch);
+    for (u32 i = 0; i < transparent_count; ++i)
+        darray_push(*out_geometries, transparent_geometries[keys[i].index].g);
 }
 
 b8 scene_create(bresource_scene* config, scene_flags flags, scene* out_scene)
@@ -180,6 +202,7 @@ b8 scene_create(bresource_scene* config, scene_flags flags, scene* out_scene)
         BERROR("Failed to create hierarchy graph");
         return false;
     }
+    out_scene->hierarchy.parallel_update = ((out_scene->flags & SCENE_FLAG_PARALLEL) != 0);
 
     if (config)
     {
@@ -725,6 +748,7 @@ void scene_node_initialize(scene* s, bhandle parent_handle, scene_node_config* n
                     BWARN("Failed to load heightmap terrain");
                     return;
                 }
+                new_terrain.parallel_generation = ((s->flags & SCENE_FLAG_PARALLEL) != 0);
 
                 if (!terrain_initialize(&new_terrain))
                 {
@@ -2237,14 +2261,7 @@ b8 scene_mesh_render_data_query_from_line(const scene* scene, vec3 direction, ve
         }
     }
 
-    // Sort opaque geometries by material
-    bquick_sort(sizeof(geometry_render_data), *out_geometries, 0, darray_length(*out_geometries) - 1, geometry_render_data_compare);
-
-    // Sort transparent geometries, then add them to the ext_data->geometries array
-    u32 transparent_geometry_count = darray_length(transparent_geometries);
-    bquick_sort(sizeof(geometry_distance), transparent_geometries, 0, transparent_geometry_count - 1, geometry_distance_compare);
-    for (u32 i = 0; i < transparent_geometry_count; ++i)
-        darray_push(*out_geometries, transparent_geometries[i].g);
+    geometries_sort(p_frame_data, out_geometries, transparent_geometries);
 
     *out_count = darray_length(*out_geometries);
 
@@ -2320,6 +2337,145 @@ b8 scene_terrain_render_data_query_from_line(const scene* scene, vec3 direction,
     return true;
 }
 
+// Where a submesh ended up after culling
+typedef enum submesh_query_result
+{
+    SUBMESH_QUERY_CULLED,
+    SUBMESH_QUERY_OPAQUE,
+    SUBMESH_QUERY_TRANSPARENT
+} submesh_query_result;
+
+/** @brief A private structure holding the culling result of a single submesh */
+typedef struct submesh_query_entry
+{
+    geometry_render_data data;
+    // Distance from the camera. Only set for transparent geometry
+    f32 distance;
+    submesh_query_result result;
+} submesh_query_entry;
+
+/** @brief A private structure holding everything needed to cull a range of meshes in parallel */
+typedef struct mesh_query_context
+{
+    const scene* scene;
+    const frustum* f;
+    vec3 center;
+    // Per mesh, the index of its first entry. Unqueryable meshes have no entries
+    u32* entry_offsets;
+    submesh_query_entry* entries;
+} mesh_query_context;
+
+static b8 static_mesh_queryable(const static_mesh_instance* m)
+{
+    // Only count loaded meshes
+    return m->mesh_resource->base.state >= BRESOURCE_STATE_LOADED && m->material_instances;
+}
+
+// Gets the world matrix of the mesh at the given index, and whether it flips triangle winding
+static mat4 static_mesh_model_get(const scene* scene, u32 resource_index, b8* out_winding_inverted)
+{
+    // Attachment lookup - by resource index
+    scene_attachment* attachment = &scene->mesh_attachments[resource_index];
+    bhandle xform_handle = hierarchy_graph_xform_handle_get(&scene->hierarchy, attachment->hierarchy_node_handle);
+    mat4 model = xform_world_get(xform_handle);
+
+    // TODO: Cache this somewhere instead of calculating all the time
+    f32 determinant = mat4_determinant(model);
+    *out_winding_inverted = determinant < 0;
+    return model;
+}
+
+// Culls a single submesh, writing the outcome to out_entry
+static void static_mesh_query_submesh(const static_mesh_instance* m, u32 submesh_index, mat4 model, b8 winding_inverted, const frustum* f, vec3 center, submesh_query_entry* out_entry)
+{
+    static_mesh_submesh* submesh = &m->mesh_resource->submeshes[submesh_index];
+    bgeometry* g = &submesh->geometry;
+    material_instance m_inst = m->material_instances[submesh_index];
+    out_entry->result = SUBMESH_QUERY_CULLED;
+
+    // AABB calculation
+    // Translate/scale the extents
+    // vec3 extents_min = vec3_mul_mat4(g->extents.min, model);
+    vec3 extents_max = mat4_mul_vec3(model, g->extents.max);
+
+    // Translate/scale the center
+    vec3 g_center = mat4_mul_vec3(model, g->center);
+    vec3 half_extents = {
+        babs(extents_max.x - g_center.x),
+        babs(extents_max.y - g_center.y),
+        babs(extents_max.z - g_center.z),
+    };
+
+    if (f && !frustum_intersects_aabb(f, &g_center, &half_extents))
+        return;
+
+    // Add it to the list to be rendered
+    geometry_render_data data = {0};
+    data.model = model;
+    data.material = m_inst;
+    data.vertex_count = g->vertex_count;
+    data.vertex_buffer_offset = g->vertex_buffer_offset;
+    data.index_count = g->index_count;
+    data.index_buffer_offset = g->index_buffer_offset;
+    data.unique_id = 0; // m->id.uniqueid; FIXME: needed for per-pixel selection
+    data.winding_inverted = winding_inverted;
+    out_entry->data = data;
+
+    // Check if transparent. If so, it goes into a separate, temp array to be sorted by distance from the camera
+    b8 has_transparency = material_flag_get(engine_systems_get()->material_system, m_inst.material, BMATERIAL_FLAG_HAS_TRANSPARENCY_BIT);
+    if (has_transparency)
+    {
+        // NOTE: This isn't perfect for translucent meshes that intersect, but is enough for our purposes now
+        out_entry->distance = babs(vec3_distance(g_center, center));
+        out_entry->result = SUBMESH_QUERY_TRANSPARENT;
+    }
+    else
+    {
+        out_entry->result = SUBMESH_QUERY_OPAQUE;
+    }
+}
+
+// Files a culled submesh into the opaque or transparent list
+static void submesh_query_entry_push(const submesh_query_entry* entry, frame_data* p_frame_data, geometry_distance** transparent_geometries, geometry_render_data** out_geometries)
+{
+    if (entry->result == SUBMESH_QUERY_CULLED)
+        return;
+
+    if (entry->result == SUBMESH_QUERY_TRANSPARENT)
+    {
+        geometry_distance gdist;
+        gdist.distance = entry->distance;
+        gdist.g = entry->data;
+        darray_push(*transparent_geometries, gdist);
+    }
+    else
+    {
+        darray_push(*out_geometries, entry->data);
+    }
+    p_frame_data->drawn_mesh_count++;
+}
+
+static void static_mesh_query_range(u32 begin, u32 end, void* user)
+{
+    mesh_query_context* context = user;
+    for (u32 i = begin; i < end; ++i)
+    {
+        // Skipped meshes take up no entries
+        u32 offset = context->entry_offsets[i];
+        u32 submesh_count = context->entry_offsets[i + 1] - offset;
+        if (!submesh_count)
+            continue;
+
+        b8 winding_inverted;
+        mat4 model = static_mesh_model_get(context->scene, i, &winding_inverted);
+        for (u32 j = 0; j < submesh_count; ++j)
+            static_mesh_query_submesh(&context->scene->static_meshes[i], j, model, winding_inverted, context->f, context->center, &context->entries[offset + j]);
+    }
+}
+
+// The number of meshes handed to a job thread at a time when querying in parallel
+#define SCENE_MESH_QUERY_GRAIN 64
+
 b8 scene_mesh_render_data_query(const scene* scene, const frustum* f, vec3 center, frame_data* p_frame_data, u32* out_count, struct geometry_render_data** out_geometries)
 {
     if (!scene)
@@ -2335,90 +2491,53 @@ b8 scene_mesh_render_data_query(const scene* scene, const frustum* f, vec3 cente
 
     // Iterate all meshes in the scene
     u32 mesh_count = darray_length(scene->static_meshes);
-    for (u32 resource_index = 0; resource_index < mesh_count; ++resource_index)
-    {
-        static_mesh_instance* m = &scene->static_meshes[resource_index];
-
-        // Only count loaded meshes
-        if (m->mesh_resource->base.state < BRESOURCE_STATE_LOADED)
-            continue;
-        if (!m->material_instances)
-            continue;
-
-        // Attachment lookup - by resource index
-        scene_attachment* attachment = &scene->mesh_attachments[resource_index];
-        bhandle xform_handle = hierarchy_graph_xform_handle_get(&scene->hierarchy, attachment->hierarchy_node_handle);
-        mat4 model = xform_world_get(xform_handle);
-
-        // TODO: Cache this somewhere instead of calculating all the time
-        f32 determinant = mat4_determinant(model);
-        b8 winding_inverted = determinant < 0;
-
-        for (u32 j = 0; j < m->mesh_resource->submesh_count; ++j)
+    if ((scene->flags & SCENE_FLAG_PARALLEL) && mesh_count > SCENE_MESH_QUERY_GRAIN)
+    {
+        // Give each submesh its own entry up front, so meshes can be culled in parallel without
+        // sharing anything. The entries are then gathered in mesh order, so the result is the same as the serial path
+        mesh_query_context context;
+        context.scene = scene;
+        context.f = f;
+        context.center = center;
+        context.entry_offsets = p_frame_data->allocator.allocate(sizeof(u32) * (mesh_count + 1));
+        u32 entry_count = 0;
+        for (u32 i = 0; i < mesh_count; ++i)
         {
-            static_mesh_submesh* submesh = &m->mesh_resource->submeshes[j];
-            bgeometry* g = &submesh->geometry;
-            material_instance m_inst = m->material_instances[j];
-
-            // AABB calculation
-            {
-                // Translate/scale the extents
-                // vec3 extents_min = vec3_mul_mat4(g->extents.min, model);
-                vec3 extents_max = mat4_mul_vec3(model, g->extents.max);
-
-                // Translate/scale the center
-                vec3 g_center = mat4_mul_vec3(model, g->center);
-                vec3 half_extents = {
-                    babs(extents_max.x - g_center.x),
-                    babs(extents_max.y - g_center.y),
-                    babs(extents_max.z - g_center.z),
-                };
+            context.entry_offsets[i] = entry_count;
+            static_mesh_instance* m = &scene->static_meshes[i];
+            if (static_mesh_queryable(m))
+                entry_count += m->mesh_resource->submesh_count;
+        }
+        context.entry_offsets[mesh_count] = entry_count;
+        context.entries = p_frame_data->allocator.allocate(sizeof(submesh_query_entry) * entry_count);
 
-                if (!f || frustum_intersects_aabb(f, &g_center, &half_extents))
-                {
-                    // Add it to the list to be rendered
-                    geometry_render_data data = {0};
-                    data.model = model;
-                    data.material = m_inst;
-                    data.vertex_count = g->vertex_count;
-                    data.vertex_buffer_offset = g->vertex_buffer_offset;
-                    data.index_count = g->index_count;
-                    data.index_buffer_offset = g->index_buffer_offset;
-                    data.unique_id = 0; // m->id.uniqueid; FIXME: needed for per-pixel selection
-                    data.winding_inverted = winding_inverted;
+        job_system_parallel_for(mesh_count, SCENE_MESH_QUERY_GRAIN, static_mesh_query_range, &context);
 
-                    // Check if transparent. If so, put into a separate, temp array to be
-                    // sorted by distance from the camera. Otherwise, put into the out_geometries array directly
-                    b8 has_transparency = material_flag_get(engine_systems_get()->material_system, m_inst.material, BMATERIAL_FLAG_HAS_TRANSPARENCY_BIT);
+        for (u32 i = 0; i < entry_count; ++i)
+            submesh_query_entry_push(&context.entries[i], p_frame_data, &transparent_geometries, out_geometries);
+    }
+    else
+    {
+        for (u32 resource_index = 0; resource_index < mesh_count; ++resource_index)
+        {
+            static_mesh_instance* m = &scene->static_meshes[resource_index];
+            if (!static_mesh_queryable(m))
+                continue;
 
-                    if (has_transparency)
-                    {
-                        // NOTE: This isn't perfect for translucent meshes that intersect, but is enough for our purposes now
-                        f32 distance = vec3_distance(g_center, center);
+            b8 winding_inverted;
+            mat4 model = static_mesh_model_get(scene, resource_index, &winding_inverted);
 
-                        geometry_distance gdist;
-                        gdist.distance = babs(distance);
-                        gdist.g = data;
-                        darray_push(transparent_geometries, gdist);
-                    }
-                    else
-                    {
-                        darray_push(*out_geometries, data);
-                    }
-                    p_frame_data->drawn_mesh_count++;
-                }
+            // Cull one submesh at a time so nothing needs to be allocated
+            for (u32 j = 0; j < m->mesh_resource->submesh_count; ++j)
+            {
+                submesh_query_entry entry;
+                static_mesh_query_submesh(m, j, model, winding_inverted, f, center, &entry);
+                submesh_query_entry_push(&entry, p_frame_data, &transparent_geometries, out_geometries);
             }
         }
     }
 
-    // Sort opaque geometries by material
-    bquick_sort(sizeof(geometry_render_data), *out_geometries, 0, darray_length(*out_geometries) - 1, geometry_render_data_compare);
-
-    // Sort transparent geometries, then add them to the ext_data->geometries array
-    u32 transparent_geometry_count = darray_length(transparent_geometries);
-    bquick_sort(sizeof(geometry_distance), transparent_geometries, 0, transparent_geometry_count - 1, geometry_distance_compare);
-    for (u32 i = 0; i < transparent_geometry_count; ++i)
-        darray_push(*out_geometries, transparent_geometries[i].g);
+    geometries_sort(p_frame_data, out_geometries, transparent_geometries);
 
     *out_count = darray_length(*out_geometries);
 
@@ -3134,12 +3253,12 @@ b8 scene_save(scene* s)
     // Push the nodes array object into the root properties
     darray_push(tree.root.properties, nodes_prop);
 
-    // Write the contents of the tree to a string
+#if LOG_TRACE_ENABLED == 1
+    // Only build the whole file as a string when it's actually going to be logged
     const char* file_content = bson_tree_to_string(&tree);
     BTRACE("File content: \n%s", file_content);
-
-    // Cleanup the tree
-    bson_tree_cleanup(&tree);
+    string_free((char*)file_content);
+#endif
 
     // Write to file
 
@@ -3154,18 +3273,18 @@ b8 scene_save(scene* s)
         goto scene_save_file_cleanup;
     }
 
-    u32 content_length = string_length(file_content);
-    u64 bytes_written = 0;
-    result = filesystem_write(&f, sizeof(char) * content_length, file_content, &bytes_written);
+    // Streamed straight to the file, so the whole scene is never held as a string
+    result = bson_tree_to_file(&tree, &f);
     if (!result)
         BERROR("Failed to write scene file");
+
+    // Close the file
+    filesystem_close(&f);
     */
 
 // scene_save_file_cleanup:
-    string_free((char*)file_content);
-
-    // Close the file
-    // filesystem_close(&f);
+    // Cleanup the tree
+    bson_tree_cleanup(&tree);
     return result;
 }
 
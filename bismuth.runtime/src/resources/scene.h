@@ -57,7 +57,9 @@ typedef enum scene_flag
 {
     SCENE_FLAG_NONE = 0,
     // Indicates if the scene can be saved once modified (i.e. read-only would be used for runtime, writing would be used in editor, etc.)
-    SCENE_FLAG_READONLY = 1
+    SCENE_FLAG_READONLY = 1,
+    // Spreads hierarchy updates, mesh render data queries and terrain generation across the job threads
+    SCENE_FLAG_PARALLEL = 2
 } scene_flag;
 
 // Bitwise flags to be used on scene load, etc.
@@ -14,6 +14,7 @@
 #include "renderer/renderer_frontend.h"
 #include "renderer/renderer_types.h"
 #include "systems/asset_system.h"
+#include "systems/job_system.h"
 #include "systems/material_system.h"
 
 static void terrain_chunk_destroy(terrain* t, terrain_chunk* chunk);
@@ -534,6 +535,15 @@ static void terrain_chunk_calculate_geometry(terrain* t, terrain_chunk* chunk, u
     terrain_geometry_generate_tangents(chunk->surface_vertex_count, chunk->vertices, chunk->lods[0].surface_index_count, chunk->lods[0].indices);
 }
 
+// Calculates geometry for the chunks [begin, end). Used to generate chunks in parallel
+static void terrain_chunks_calculate_geometry(u32 begin, u32 end, void* user)
+{
+    terrain* t = user;
+    u32 chunk_col_count = t->tile_count_x / t->chunk_size;
+    for (u32 i = begin; i < end; ++i)
+        terrain_chunk_calculate_geometry(t, &t->chunks[i], i % chunk_col_count, i / chunk_col_count);
+}
+
 // FIXME: These should be made more generic and be rolled back into geometry utils in core
 void terrain_geometry_generate_normals(u32 vertex_count, terrain_vertex* vertices, u32 index_count, u32 *indices)
 {
@@ -633,14 +643,22 @@ static void generate_and_load_geometry(terrain* t)
     u32 chunk_row_count = t->tile_count_z / t->chunk_size;
     u32 chunk_col_count = t->tile_count_x / t->chunk_size;
 
-    for (u32 z = 0, i = 0; z < chunk_row_count; z++)
+    if (t->parallel_generation)
     {
-        for (u32 x = 0; x < chunk_col_count; ++x, ++i)
+        // Chunks only write their own vertices and indices, so each can be generated independently
+        job_system_parallel_for(t->chunk_count, 1, terrain_chunks_calculate_geometry, t);
+    }
+    else
+    {
+        for (u32 z = 0, i = 0; z < chunk_row_count; z++)
         {
-            // x/z chunk indices within terrain grid
-            u32 chunk_offset_x = i % chunk_col_count;
-            u32 chunk_offset_z = i / chunk_col_count;
-            terrain_chunk_calculate_geometry(t, &t->chunks[i], chunk_offset_x, chunk_offset_z);
+            for (u32 x = 0; x < chunk_col_count; ++x, ++i)
+            {
+                // x/z chunk indices within terrain grid
+                u32 chunk_offset_x = i % chunk_col_count;
+                u32 chunk_offset_z = i / chunk_col_count;
+                terrain_chunk_calculate_geometry(t, &t->chunks[i], chunk_offset_x, chunk_offset_z);
+            }
         }
     }
 
@@ -108,6 +108,9 @@ typedef struct terrain
 
     u32 material_count;
     bname* material_names;
+
+    // If set before loading, chunk geometry is generated in parallel across the job threads
+    b8 parallel_generation;
 } terrain;
 
 BAPI b8 terrain_create(bresource_heightmap_terrain* terrain_resource, terrain* out_terrain);
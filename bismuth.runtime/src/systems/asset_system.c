@@ -20,7 +20,7 @@
 #include <assets/basset_types.h>
 #include <assets/basset_utils.h>
 #include <containers/darray.h>
-#include <containers/u64_bst.h>
+#include <containers/u64_btree.h>
 #include <core/event.h>
 #include <debug/bassert.h>
 #include <defines.h>
@@ -57,8 +57,8 @@ typedef struct asset_system_state
     u32 max_asset_count;
     // An array of lookups which contain reference and release data
     asset_lookup* lookups;
-    // A BST to use for lookups of assets by name
-    bt_node* lookup_tree;
+    // A tree to use for lookups of assets by name
+    u64_btree lookup_tree;
 
     // An array of handlers for various asset types
     asset_handler handlers[BASSET_TYPE_MAX];
@@ -126,8 +126,8 @@ b8 asset_system_initialize(u64* memory_requirement, struct asset_system_state* s
 
     // Asset lookup tree
     {
-        // NOTE: BST node created when first asset is requested
-        state->lookup_tree = 0;
+        // NOTE: Tree nodes are created when the first asset is requested
+        bzero_memory(&state->lookup_tree, sizeof(u64_btree));
 
         // Invalidate all lookups
         for (u32 i = 0; i < state->max_asset_count; ++i)
@@ -171,8 +171,8 @@ void asset_system_shutdown(struct asset_system_state* state)
             bfree(state->lookups, sizeof(asset_lookup) * state->max_asset_count, MEMORY_TAG_ARRAY);
         }
 
-        // Destroy the BST
-        u64_bst_cleanup(state->lookup_tree);
+        // Destroy the tree
+        u64_btree_cleanup(&state->lookup_tree);
 
         bzero_memory(state, sizeof(asset_system_state));
     }
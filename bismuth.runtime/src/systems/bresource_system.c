@@ -1,6 +1,7 @@
 #include "bresource_system.h"
 
-#include "containers/u64_bst.h"
+#include "containers/slot_map.h"
+#include "containers/u64_btree.h"
 #include "core/engine.h"
 #include "debug/bassert.h"
 #include "defines.h"
@@ -30,6 +31,8 @@ typedef struct resource_lookup
 {
     // The resource itself, owned by this lookup
     bresource* r;
+    // The handle which owns this lookup's slot
+    bhandle handle;
     // The current number of references to the resource
     i32 reference_count;
     // Indicates if the resource will be released when the reference_count reaches 0
@@ -45,11 +48,13 @@ typedef struct bresource_system_state
     u32 max_resource_count;
     // An array of lookups which contain reference and release data
     resource_lookup* lookups;
-    // A BST to use for lookups of resources by bname
-    bt_node* lookup_tree;
+    // Hands out free slots in the lookups array
+    slot_map lookup_slots;
+    // A tree to use for lookups of resources by bname
+    u64_btree lookup_tree;
 
-    // A BST to use for lookups of resources by file watch id
-    bt_node* file_watch_lookup;
+    // A tree to use for lookups of resources by file watch id
+    u64_btree file_watch_lookup;
 } bresource_system_state;
 
 static void bresource_system_release_internal(struct bresource_system_state* state, bname resource_name, b8 force_release);
@@ -66,8 +71,13 @@ b8 bresource_system_initialize(u64* memory_requirement, struct bresource_system_
 
     state->max_resource_count = config->max_resource_count;
     state->lookups = ballocate(sizeof(resource_lookup) * state->max_resource_count, MEMORY_TAG_ARRAY);
-    state->lookup_tree = 0;
-    state->file_watch_lookup = 0;
+    if (!slot_map_create(0, state->max_resource_count, &state->lookup_slots))
+    {
+        BERROR("Failed to create resource lookup slots");
+        return false;
+    }
+    bzero_memory(&state->lookup_tree, sizeof(u64_btree));
+    bzero_memory(&state->file_watch_lookup, sizeof(u64_btree));
 
     state->asset_system = engine_systems_get()->asset_state;
 
@@ -213,15 +223,18 @@ void bresource_system_shutdown(struct bresource_system_state* state)
 {
     if (state)
     {
-        for (u32 i = 0; i < state->max_resource_count; ++i)
+        // Walk backwards, since releasing moves the last live slot into the released one's place
+        for (u32 i = state->lookup_slots.count; i > 0; --i)
         {
-            if (state->lookups[i].r)
-                bresource_system_release_internal(state, state->lookups[i].r->name, true);
+            resource_lookup* lookup = &state->lookups[state->lookup_slots.dense_slots[i - 1]];
+            if (lookup->r)
+                bresource_system_release_internal(state, lookup->r->name, true);
         }
+        slot_map_destroy(&state->lookup_slots);
 
-        // Destroy the bst
-        u64_bst_cleanup(state->lookup_tree);
-        u64_bst_cleanup(state->file_watch_lookup);
+        // Destroy the trees
+        u64_btree_cleanup(&state->lookup_tree);
+        u64_btree_cleanup(&state->file_watch_lookup);
 
         bfree(state->lookups, sizeof(resource_lookup) * state->max_resource_count, MEMORY_TAG_ARRAY);
 
@@ -235,9 +248,9 @@ bresource* bresource_system_request(struct bresource_system_state* state, bname
 
     // Attempt to find the resource by bname
     u32 lookup_index = INVALID_ID;
-    const bt_node* node = u64_bst_find(state->lookup_tree, name);
+    const bt_node_value* node = u64_btree_find(&state->lookup_tree, name);
     if (node)
-        lookup_index = node->value.u32;
+        lookup_index = node->u32;
 
     if (lookup_index != INVALID_ID && state->lookups[lookup_index].r)
     {
@@ -252,61 +265,63 @@ bresource* bresource_system_request(struct bresource_system_state* state, bname
     }
     else
     {
-        // Resource doesn't exist. Create a new one and its lookup
-        // Look for an empty slot
-        for (u32 i = 0; i < state->max_resource_count; ++i)
+        // Resource doesn't exist. Create a new one and its lookup in the next free slot
+        if (state->lookup_slots.count >= state->max_resource_count)
         {
-            resource_lookup* lookup = &state->lookups[i];
-            if (!lookup->r)
-            {
-                // Grab a handler for the resource type, if there is one
-                bresource_handler* handler = &state->handlers[info->type];
-                
-                // Allocate memory for the resource
-                lookup->r = ballocate(handler->size, MEMORY_TAG_RESOURCE);
-                if (!lookup->r)
-                {
-                    BERROR("Resource handler failed to allocate resource. Null/0 will be returned");
-                    return 0;
-                }
-
-                // Add an entry to the bst for this node
-                bt_node_value v;
-                v.u32 = i;
-                bt_node* new_node = u64_bst_insert(state->lookup_tree, name, v);
-                // Save as root if this is the first resource. Otherwise it'll be part of the tree automatically
-                if (!state->lookup_tree)
-                    state->lookup_tree = new_node;
-
-                // Setup the resource
-                lookup->r->name = name;
-                lookup->r->type = info->type;
-                lookup->r->state = BRESOURCE_STATE_UNINITIALIZED;
-                lookup->r->generation = INVALID_ID;
-                lookup->r->tag_count = 0;
-                lookup->r->tags = 0;
-                lookup->reference_count = 0;
-                // Only allow auto-release for resources which aren't hot-reloadable
-                lookup->auto_release = handler->handle_hot_reload == 0;
-
-                // Make the actual request
-                b8 result = handler->request(handler, lookup->r, info);
-                if (result)
-                {
-                    // Increment reference count
-                    lookup->reference_count++;
-
-                    // Return a pointer to the resource, even if it's not yet ready
-                    return lookup->r;
-                }
-
-                // This means the handler failed
-                BERROR("Resource handler failed to fulfill request. See logs for details. Null/0 will be returned");
-                return 0;
-            }
+            BFATAL("Max configured resource count of %u has been exceeded and all slots are full. Increase this count in configuration", state->max_resource_count);
+            return 0;
+        }
+        bhandle slot_handle;
+        if (!slot_map_add(&state->lookup_slots, 0, &slot_handle))
+        {
+            BERROR("Failed to obtain a resource lookup slot. Null/0 will be returned");
+            return 0;
+        }
+        u32 i = slot_handle.handle_index;
+        resource_lookup* lookup = &state->lookups[i];
+        lookup->handle = slot_handle;
+
+        // Grab a handler for the resource type, if there is one
+        bresource_handler* handler = &state->handlers[info->type];
+        
+        // Allocate memory for the resource
+        lookup->r = ballocate(handler->size, MEMORY_TAG_RESOURCE);
+        if (!lookup->r)
+        {
+            slot_map_remove(&state->lookup_slots, slot_handle, 0);
+            BERROR("Resource handler failed to allocate resource. Null/0 will be returned");
+            return 0;
+        }
+
+        // Add an entry to the tree for this node
+        bt_node_value v;
+        v.u32 = i;
+        u64_btree_insert(&state->lookup_tree, name, v);
+
+        // Setup the resource
+        lookup->r->name = name;
+        lookup->r->type = info->type;
+        lookup->r->state = BRESOURCE_STATE_UNINITIALIZED;
+        lookup->r->generation = INVALID_ID;
+        lookup->r->tag_count = 0;
+        lookup->r->tags = 0;
+        lookup->reference_count = 0;
+        // Only allow auto-release for resources which aren't hot-reloadable
+        lookup->auto_release = handler->handle_hot_reload == 0;
+
+        // Make the actual request
+        b8 result = handler->request(handler, lookup->r, info);
+        if (result)
+        {
+            // Increment reference count
+            lookup->reference_count++;
+
+            // Return a pointer to the resource, even if it's not yet ready
+            return lookup->r;
         }
 
-        BFATAL("Max configured resource count of %u has been exceeded and all slots are full. Increase this count in configuration", state->max_resource_count);
+        // This means the handler failed
+        BERROR("Resource handler failed to fulfill request. See logs for details. Null/0 will be returned");
         return 0;
     }
 }
@@ -322,20 +337,17 @@ void bresource_system_register_for_hot_reload(struct bresource_system_state* sta
 {
     // TODO: also handle unload and removing from this lookup when destroying
 
-    // Add an entry to the bst for this node
+    // Add an entry to the tree for this node
     u32 lookup_index = INVALID_ID;
-    const bt_node* node = u64_bst_find(state->lookup_tree, resource->name);
+    const bt_node_value* node = u64_btree_find(&state->lookup_tree, resource->name);
     if (node)
-        lookup_index = node->value.u32;
+        lookup_index = node->u32;
 
     if (lookup_index != INVALID_ID)
     {
         bt_node_value v;
         v.u32 = lookup_index;
-        bt_node* new_node = u64_bst_insert(state->file_watch_lookup, file_watch_id, v);
-        // Save as root if this is the first resource. Otherwise it'll be part of the tree automatically
-        if (!state->file_watch_lookup)
-            state->file_watch_lookup = new_node;
+        u64_btree_insert(&state->file_watch_lookup, file_watch_id, v);
     }
     else
     {
@@ -372,9 +384,9 @@ static void bresource_system_release_internal(struct bresource_system_state* sta
     BASSERT_MSG(state, "bresource_system_release requires a valid pointer to state");
 
     u32 lookup_index = INVALID_ID;
-    const bt_node* node = u64_bst_find(state->lookup_tree, resource_name);
+    const bt_node_value* node = u64_btree_find(&state->lookup_tree, resource_name);
     if (node)
-        lookup_index = node->value.u32;
+        lookup_index = node->u32;
     if (lookup_index != INVALID_ID)
     {
         // Valid entry found, decrement the reference count
@@ -414,15 +426,15 @@ static void bresource_system_release_internal(struct bresource_system_state* sta
             // Free the resource structure itself
             bfree(lookup->r, handler->size, MEMORY_TAG_RESOURCE);
 
-            // Ensure the lookup is invalidated
+            // Ensure the lookup is invalidated, and its slot freed up
             lookup->r = 0;
             lookup->reference_count = 0;
             lookup->auto_release = false;
+            slot_map_remove(&state->lookup_slots, lookup->handle, 0);
+            bhandle_invalidate(&lookup->handle);
 
-            // Remove the entry from the bst too
-            bt_node* deleted = u64_bst_delete(state->lookup_tree, resource_name);
-            if (!deleted)
-                state->lookup_tree = 0;
+            // Remove the entry from the tree too
+            u64_btree_delete(&state->lookup_tree, resource_name, 0);
         }
     }
     else
@@ -437,10 +449,10 @@ static void on_asset_system_hot_reload(void* listener, basset* asset)
     bresource_system_state* state = (bresource_system_state*)listener;
 
     // Find the resource from a lookup table based on file_watch_id
-    const bt_node* node = u64_bst_find(state->file_watch_lookup, asset->file_watch_id);
+    const bt_node_value* node = u64_btree_find(&state->file_watch_lookup, asset->file_watch_id);
     u32 lookup_index = INVALID_ID;
     if (node)
-        lookup_index = node->value.u32;
+        lookup_index = node->u32;
 
     if (lookup_index != INVALID_ID)
     {
@@ -1,178 +1,592 @@
 #include "job_system.h"
 
-#include "containers/ring_queue.h"
 #include "core/frame_data.h"
 #include "defines.h"
 #include "debug/bassert.h"
 #include "memory/bmemory.h"
-#include "threads/bmutex.h"
+#include "memory/frame_scratch.h"
+#include "platform/platform.h"
+#include "threads/batomic.h"
+#include "threads/bparallel.h"
 #include "threads/bsemaphore.h"
+#include "threads/bspinlock.h"
 #include "threads/bthread.h"
 #include "logger.h"
 
+#define JOB_PRIORITY_COUNT 3
+#define JOB_QUEUE_INITIAL_CAPACITY 256
+
+/**
+ * A double-ended queue of jobs owned by a single job thread. The owner pushes and pops
+ * at the bottom (newest first, which keeps related work hot in cache), while other
+ * threads steal from the top (oldest first). Guarded by a spinlock since every hold is
+ * only a handful of instructions.
+ */
+typedef struct job_queue
+{
+    bspinlock lock;
+    // Always a power of two
+    u32 capacity;
+    // Steal end. Indices are free-running and wrapped with (capacity - 1)
+    u64 top;
+    // Owner end
+    u64 bottom;
+    job_info* items;
+} job_queue;
+
 typedef struct job_thread
 {
     u8 index;
     bthread thread;
-    job_info info;
 
-    // Mutex to guard access to this thread's info
-    bmutex info_mutex;
+    // One queue per priority, indexed by job_priority
+    job_queue queues[JOB_PRIORITY_COUNT];
 
     // Used to cause a thread to block until work is available
     bsemaphore semaphore;
+    // Set while the thread is (about to be) blocked on its semaphore
+    volatile u32 sleeping;
 
     // Types of jobs this thread can handle
     u32 type_mask;
 } job_thread;
 
+// Must be a power of two
+#define JOB_RESULT_RING_SIZE 1024
+// Results up to this size are stored in the ring entry itself rather than on the heap
+#define JOB_RESULT_INLINE_SIZE 64
+
 typedef struct job_result_entry
 {
-    u16 id;
+    // Ring position this entry is ready for. Hands the entry back and forth between the producers and the consumer
+    volatile u32 sequence;
     pfn_job_on_complete callback;
     u32 param_size;
+    // Points at inline_params if the result fits there, otherwise at a heap block owned by the entry
     void* params;
+    u8 inline_params[JOB_RESULT_INLINE_SIZE];
 } job_result_entry;
 
-#define MAX_JOB_RESULTS 512
+// Holds a result which arrived while the ring was full
+typedef struct job_result_overflow
+{
+    struct job_result_overflow* next;
+    job_result_entry entry;
+} job_result_overflow;
+
+// The maximum number of jobs that can be outstanding at once
+#define JOB_SLOT_COUNT 65536
+
+// A submitted job still waiting for its dependencies to complete
+typedef struct job_pending
+{
+    job_info info;
+    // Outstanding dependencies. The job is queued once this hits 0
+    volatile u32 remaining;
+} job_pending;
+
+// Links a pending job into the continuation list of one of its dependencies
+typedef struct job_continuation
+{
+    struct job_continuation* next;
+    job_pending* pending;
+} job_continuation;
+
+/**
+ * Tracks one outstanding job. Slots are recycled once their job completes, with the generation
+ * bumped each time, so a handle from an earlier use of the slot reads as complete.
+ */
+typedef struct job_slot
+{
+    // The generation shifted up by one. The low bit is set once the job is complete (or the slot is free)
+    volatile u32 state;
+    // Guards continuations, and the transition to complete
+    bspinlock lock;
+    // Jobs to be scheduled once this one completes
+    job_continuation* continuations;
+} job_slot;
 
 typedef struct job_system_state
 {
-    b8 running;
+    volatile b8 running;
     u8 thread_count;
     job_thread job_threads[32];
 
-    u16 current_job_id;
-    // TODO: Combine 8 into each bool
-    b8* job_statuses;
-    bmutex job_status_mutex;
+    // Rotates the thread that jobs submitted from outside the job threads are handed to
+    volatile u32 next_thread;
+
+    // JOB_SLOT_COUNT slots, indexed by job_handle.index
+    job_slot* slots;
+    // Stack of free slot indices
+    u32* free_slots;
+    u32 free_slot_count;
+    bspinlock free_slot_lock;
+
+    // Completed job callbacks waiting to be run on the main thread. Many producers (any thread
+    // finishing a job), one consumer (job_system_update). Positions are free-running
+    job_result_entry results[JOB_RESULT_RING_SIZE];
+    volatile u32 result_enqueue_pos;
+    u32 result_dequeue_pos;
+    // Results which didn't fit in the ring
+    job_result_overflow* result_overflow;
+    bspinlock result_overflow_lock;
+} job_system_state;
 
-    ring_queue low_priority_queue;
-    ring_queue normal_priority_queue;
-    ring_queue high_priority_queue;
+static job_system_state* state_ptr;
 
-    bmutex low_pri_queue_mutex;
-    bmutex normal_pri_queue_mutex;
-    bmutex high_pri_queue_mutex;
+// The job thread owning the calling thread, if any
+static BTHREAD_LOCAL job_thread* current_job_thread;
 
-    job_result_entry pending_results[MAX_JOB_RESULTS];
-    bmutex result_mutex;
-} job_system_state;
+static void job_queue_create(job_queue* queue)
+{
+    bspinlock_create(&queue->lock);
+    queue->capacity = JOB_QUEUE_INITIAL_CAPACITY;
+    queue->top = 0;
+    queue->bottom = 0;
+    queue->items = ballocate(sizeof(job_info) * queue->capacity, MEMORY_TAG_JOB);
+}
 
-static job_system_state* state_ptr;
+static void job_queue_destroy(job_queue* queue)
+{
+    if (queue->items)
+        bfree(queue->items, sizeof(job_info) * queue->capacity, MEMORY_TAG_JOB);
+    bzero_memory(queue, sizeof(job_queue));
+}
 
-static void store_result(pfn_job_on_complete callback, u32 param_size, void* params)
+// NOTE: Must be called with the lock held
+static void job_queue_grow(job_queue* queue)
 {
-    // Create new entry
-    job_result_entry entry;
-    entry.id = INVALID_ID_U16;
-    entry.param_size = param_size;
-    entry.callback = callback;
-    if (entry.param_size > 0)
+    u32 new_capacity = queue->capacity * 2;
+    job_info* items = ballocate_uninitialized(sizeof(job_info) * new_capacity, MEMORY_TAG_JOB);
+    for (u64 i = queue->top; i != queue->bottom; ++i)
+        items[i & (new_capacity - 1)] = queue->items[i & (queue->capacity - 1)];
+    bfree(queue->items, sizeof(job_info) * queue->capacity, MEMORY_TAG_JOB);
+    queue->items = items;
+    queue->capacity = new_capacity;
+}
+
+static void job_queue_push_bottom(job_queue* queue, const job_info* info)
+{
+    bspinlock_lock(&queue->lock);
+    if (queue->bottom - queue->top == queue->capacity)
+        job_queue_grow(queue);
+    queue->items[queue->bottom & (queue->capacity - 1)] = *info;
+    queue->bottom++;
+    bspinlock_unlock(&queue->lock);
+}
+
+static b8 job_queue_pop_bottom(job_queue* queue, job_info* out_info)
+{
+    // Cheap unlocked check first, so scanning empty queues doesn't contend on the lock
+    if (batomic_load_relaxed_u64(&queue->bottom) == batomic_load_relaxed_u64(&queue->top))
+        return false;
+
+    b8 found = false;
+    bspinlock_lock(&queue->lock);
+    if (queue->bottom != queue->top)
     {
-        // Take copy, as job is destroyed after this
-        entry.params = ballocate(param_size, MEMORY_TAG_JOB);
-        bcopy_memory(entry.params, params, param_size);
+        queue->bottom--;
+        *out_info = queue->items[queue->bottom & (queue->capacity - 1)];
+        found = true;
+    }
+    bspinlock_unlock(&queue->lock);
+    return found;
+}
+
+// Takes the oldest job, but only if the given type mask can handle it
+static b8 job_queue_steal_top(job_queue* queue, u32 type_mask, b8 peek_only, job_info* out_info)
+{
+    if (batomic_load_relaxed_u64(&queue->bottom) == batomic_load_relaxed_u64(&queue->top))
+        return false;
+
+    b8 found = false;
+    bspinlock_lock(&queue->lock);
+    if (queue->bottom != queue->top)
+    {
+        job_info* info = &queue->items[queue->top & (queue->capacity - 1)];
+        if (info->type & type_mask)
+        {
+            found = true;
+            if (!peek_only)
+            {
+                *out_info = *info;
+                queue->top++;
+            }
+        }
+    }
+    bspinlock_unlock(&queue->lock);
+    return found;
+}
+
+// Fills a result entry, taking ownership of the job's result data if it is too big to store inline
+static void job_result_fill(job_result_entry* entry, pfn_job_on_complete callback, job_info* info)
+{
+    entry->callback = callback;
+    entry->param_size = info->result_data_size;
+    if (entry->param_size == 0)
+    {
+        entry->params = 0;
+    }
+    else if (entry->param_size <= JOB_RESULT_INLINE_SIZE)
+    {
+        bcopy_memory(entry->inline_params, info->result_data, entry->param_size);
+        entry->params = entry->inline_params;
     }
     else
     {
-        entry.params = 0;
+        // Hand over the block instead of copying it. The job is destroyed after this
+        entry->params = info->result_data;
+        info->result_data = 0;
     }
+}
+
+static void job_result_release(job_result_entry* entry)
+{
+    if (entry->params && entry->params != entry->inline_params)
+        bfree(entry->params, entry->param_size, MEMORY_TAG_JOB);
+    entry->params = 0;
+}
 
-    // Lock, find free space, store, unlock
-    if (!bmutex_lock(&state_ptr->result_mutex))
-        BERROR("Failed to obtain mutex lock for storing a result! Result storage may be corrupted");
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i)
+/**
+ * Queues a completion callback for the main thread. Claims a ring entry by advancing the
+ * enqueue position, fills it, then publishes it by bumping its sequence. Never blocks or drops:
+ * if the ring is full (i.e. the main thread has fallen behind) the result goes on the overflow list.
+ */
+static void store_result(pfn_job_on_complete callback, job_info* info)
+{
+    u32 pos = batomic_load_relaxed_u32(&state_ptr->result_enqueue_pos);
+    for (;;)
     {
-        if (state_ptr->pending_results[i].id == INVALID_ID_U16)
+        job_result_entry* entry = &state_ptr->results[pos & (JOB_RESULT_RING_SIZE - 1)];
+        i32 diff = (i32)(batomic_load_u32(&entry->sequence) - pos);
+        if (diff == 0)
+        {
+            // Entry is free for this position. Try to claim it
+            if (batomic_compare_exchange_u32(&state_ptr->result_enqueue_pos, &pos, pos + 1))
+            {
+                job_result_fill(entry, callback, info);
+                batomic_store_u32(&entry->sequence, pos + 1);
+                return;
+            }
+        }
+        else if (diff < 0)
         {
-            state_ptr->pending_results[i] = entry;
-            state_ptr->pending_results[i].id = i;
+            // Entry still holds a result from the previous lap, so the ring is full
             break;
         }
+        else
+        {
+            // Another producer got here first
+            pos = batomic_load_relaxed_u32(&state_ptr->result_enqueue_pos);
+        }
     }
-    if (!bmutex_unlock(&state_ptr->result_mutex))
-        BERROR("Failed to release mutex lock for result storage, storage may be corrupted");
+
+    job_result_overflow* overflow = ballocate(sizeof(job_result_overflow), MEMORY_TAG_JOB);
+    job_result_fill(&overflow->entry, callback, info);
+    bspinlock_lock(&state_ptr->result_overflow_lock);
+    overflow->next = state_ptr->result_overflow;
+    state_ptr->result_overflow = overflow;
+    bspinlock_unlock(&state_ptr->result_overflow_lock);
 }
 
-static u32 job_thread_run(void* params)
+/**
+ * Runs callbacks for results published since the last call. Only called from the main thread.
+ * If run is false the results are discarded instead (used at shutdown).
+ */
+static void job_results_process(b8 run)
 {
-    u32 index = *(u32*)params;
-    job_thread* thread = &state_ptr->job_threads[index];
-    BTRACE("Starting job thread #%i (id=%#x, type=%#x)", thread->index, thread->thread.thread_id, thread->type_mask);
+    for (;;)
+    {
+        u32 pos = state_ptr->result_dequeue_pos;
+        job_result_entry* entry = &state_ptr->results[pos & (JOB_RESULT_RING_SIZE - 1)];
+        if ((i32)(batomic_load_u32(&entry->sequence) - (pos + 1)) < 0)
+            break;
+
+        if (run)
+            entry->callback(entry->params);
+        job_result_release(entry);
+
+        // Make the entry available to producers again, one lap ahead
+        state_ptr->result_dequeue_pos = pos + 1;
+        batomic_store_u32(&entry->sequence, pos + JOB_RESULT_RING_SIZE);
+    }
+
+    if (!batomic_load_ptr((void* volatile*)&state_ptr->result_overflow))
+        return;
 
-    // Mutex to lock info for this thread
-    if (!bmutex_create(&thread->info_mutex))
+    bspinlock_lock(&state_ptr->result_overflow_lock);
+    job_result_overflow* overflow = state_ptr->result_overflow;
+    state_ptr->result_overflow = 0;
+    bspinlock_unlock(&state_ptr->result_overflow_lock);
+
+    while (overflow)
     {
-        BERROR("Failed to create job thread mutex! Aborting thread...");
-        return 0;
+        job_result_overflow* next = overflow->next;
+        if (run)
+            overflow->entry.callback(overflow->entry.params);
+        job_result_release(&overflow->entry);
+        bfree(overflow, sizeof(job_result_overflow), MEMORY_TAG_JOB);
+        overflow = next;
     }
+}
 
-    // Create a semaphore for the thread which will block until there is work to do
-    if (!bsemaphore_create(&thread->semaphore, 1, 1))
+static void job_release(job_info* info)
+{
+    // NOTE: Params with no size are borrowed rather than owned (i.e. parallel-for helpers)
+    if (info->param_data && info->param_data_size)
+        bfree(info->param_data, info->param_data_size, MEMORY_TAG_JOB);
+    if (info->result_data)
+        bfree(info->result_data, info->result_data_size, MEMORY_TAG_JOB);
+    if (info->dependencies)
+        bfree(info->dependencies, sizeof(job_handle) * info->dependency_count, MEMORY_TAG_ARRAY);
+    bzero_memory(info, sizeof(job_info));
+}
+
+static void job_enqueue(job_info* info);
+static b8 job_system_help(void);
+
+/**
+ * Takes a free slot for a new job. If every slot is taken by an outstanding job, the caller
+ * helps run jobs until one frees up.
+ */
+static job_handle job_slot_acquire(void)
+{
+    u32 index = INVALID_ID;
+    for (;;)
     {
-        BERROR("Failed to create job thread semaphore! Aborting thread...");
+        bspinlock_lock(&state_ptr->free_slot_lock);
+        if (state_ptr->free_slot_count)
+            index = state_ptr->free_slots[--state_ptr->free_slot_count];
+        bspinlock_unlock(&state_ptr->free_slot_lock);
+        if (index != INVALID_ID)
+            break;
+
+        if (!job_system_help())
+            platform_sleep(0);
+    }
+
+    job_slot* slot = &state_ptr->slots[index];
+    job_handle handle;
+    handle.index = index;
+    // NOTE: Generations only need to differ from recent uses of the slot, so wrapping is fine
+    handle.generation = ((slot->state >> 1) + 1) & 0x7FFFFFFF;
+    slot->continuations = 0;
+    batomic_store_u32(&slot->state, handle.generation << 1);
+    return handle;
+}
+
+// Returns the slot of a job which is still outstanding, or 0 if it has completed (or never existed)
+static job_slot* job_slot_get_pending(job_handle handle)
+{
+    if (handle.index >= JOB_SLOT_COUNT)
         return 0;
+    job_slot* slot = &state_ptr->slots[handle.index];
+    return batomic_load_u32(&slot->state) == (handle.generation << 1) ? slot : 0;
+}
+
+/**
+ * Drops one outstanding dependency from the pending job, queueing it when none are left.
+ * If discard is set the job is released instead of queued (used at shutdown).
+ */
+static void job_pending_release(job_pending* pending, b8 discard)
+{
+    if (batomic_fetch_sub_u32(&pending->remaining, 1) != 1)
+        return;
+
+    job_info info = pending->info;
+    bfree(pending, sizeof(job_pending), MEMORY_TAG_JOB);
+    if (discard)
+        job_release(&info);
+    else
+        job_enqueue(&info);
+}
+
+// Marks the job as complete, schedules anything that was only waiting on it and frees up its slot
+static void job_complete(job_handle handle)
+{
+    job_slot* slot = &state_ptr->slots[handle.index];
+    bspinlock_lock(&slot->lock);
+    batomic_store_u32(&slot->state, (handle.generation << 1) | 1);
+    job_continuation* link = slot->continuations;
+    slot->continuations = 0;
+    bspinlock_unlock(&slot->lock);
+
+    while (link)
+    {
+        job_continuation* next = link->next;
+        job_pending_release(link->pending, false);
+        bfree(link, sizeof(job_continuation), MEMORY_TAG_JOB);
+        link = next;
     }
 
-    // Run forever, waiting for jobs
-    while (true)
+    // Any handle still referring to this use of the slot now reads as complete, so it can be reused
+    bspinlock_lock(&state_ptr->free_slot_lock);
+    state_ptr->free_slots[state_ptr->free_slot_count++] = handle.index;
+    bspinlock_unlock(&state_ptr->free_slot_lock);
+}
+
+/**
+ * Parks a job until all of its dependencies complete. A continuation is linked into each
+ * dependency's slot, and whichever completes last queues the job. Dependencies that are
+ * already complete are counted off immediately.
+ */
+static void job_schedule_after_dependencies(job_info* info)
+{
+    job_pending* pending = ballocate(sizeof(job_pending), MEMORY_TAG_JOB);
+    pending->info = *info;
+    // One extra reference is held while linking, so the job can't be queued part way through
+    pending->remaining = info->dependency_count + 1;
+
+    for (u32 i = 0; i < info->dependency_count; ++i)
     {
-        if (!state_ptr || !state_ptr->running || !thread)
-            break;
-        
-        // Wait for the semaphore to be signaled
-        bsemaphore_wait(&thread->semaphore, 0xFFFFFFFF);
+        job_handle dependency = info->dependencies[i];
+        b8 linked = false;
+        job_slot* slot = job_slot_get_pending(dependency);
+        if (slot)
+        {
+            job_continuation* link = ballocate(sizeof(job_continuation), MEMORY_TAG_JOB);
+            link->pending = pending;
+            bspinlock_lock(&slot->lock);
+            // Check again under the lock, since it may have completed in the meantime
+            if (batomic_load_u32(&slot->state) == (dependency.generation << 1))
+            {
+                link->next = slot->continuations;
+                slot->continuations = link;
+                linked = true;
+            }
+            bspinlock_unlock(&slot->lock);
+            if (!linked)
+                bfree(link, sizeof(job_continuation), MEMORY_TAG_JOB);
+        }
+
+        // Already complete
+        if (!linked)
+            job_pending_release(pending, false);
+    }
+
+    job_pending_release(pending, false);
+}
+
+static void job_execute(job_info* info)
+{
+    b8 result = info->entry_point(info->param_data, info->result_data);
+
+    if (result && info->on_success)
+        store_result(info->on_success, info);
+    else if (!result && info->on_fail)
+        store_result(info->on_fail, info);
+
+    // Update the job status for this job, then signal anyone waiting on its counter
+    job_handle handle = info->handle;
+    job_counter* counter = info->counter;
+    job_release(info);
+    if (handle.index != INVALID_ID)
+        job_complete(handle);
+    if (counter)
+        batomic_fetch_sub_u32(&counter->value, 1);
+}
+
+/**
+ * Wakes the given thread if it is asleep. The sleeping flag is cleared by whoever wins the
+ * exchange, so the semaphore is only ever signalled once per sleep.
+ */
+static b8 job_thread_wake(job_thread* thread)
+{
+    if (batomic_load_relaxed_u32(&thread->sleeping) && batomic_exchange_u32(&thread->sleeping, 0))
+    {
+        bsemaphore_signal(&thread->semaphore);
+        return true;
+    }
+    return false;
+}
 
-        // Lock and grab copy of the info
-        if (!bmutex_lock(&thread->info_mutex))
-            BERROR("Failed to obtain lock on job thread mutex");
-        job_info info = thread->info;
-        if (!bmutex_unlock(&thread->info_mutex))
-            BERROR("Failed to release lock on job thread mutex");
+// Wakes one sleeping thread able to run the given type so it can come and steal
+static void job_thread_wake_one(u32 type, job_thread* exclude)
+{
+    u32 thread_count = state_ptr->thread_count;
+    u32 start = batomic_fetch_add_u32(&state_ptr->next_thread, 1);
+    for (u32 i = 0; i < thread_count; ++i)
+    {
+        job_thread* thread = &state_ptr->job_threads[(start + i) % thread_count];
+        if (thread != exclude && (thread->type_mask & type) && job_thread_wake(thread))
+            return;
+    }
+}
 
-        if (info.entry_point)
+/**
+ * Looks for the next job to run, highest priority first. At each priority the thread's own
+ * queue is checked first, then the other threads' queues are stolen from. Passing no thread
+ * only steals, which is how threads outside the job system help out.
+ */
+static b8 job_find(job_thread* thread, u32 type_mask, job_info* out_info)
+{
+    u32 thread_count = state_ptr->thread_count;
+    u32 start = thread ? thread->index : 0;
+    for (i32 priority = JOB_PRIORITY_HIGH; priority >= JOB_PRIORITY_LOW; --priority)
+    {
+        if (thread && job_queue_pop_bottom(&thread->queues[priority], out_info))
+            return true;
+        for (u32 i = thread ? 1 : 0; i < thread_count; ++i)
         {
-            b8 result = info.entry_point(info.param_data, info.result_data);
-
-            if (result && info.on_success)
-                store_result(info.on_success, info.result_data_size, info.result_data);
-            else if (!result && info.on_fail)
-                store_result(info.on_fail, info.result_data_size, info.result_data);
-
-            // Clear the param data and result data.
-            if (info.param_data)
-                bfree(info.param_data, info.param_data_size, MEMORY_TAG_JOB);
-            if (info.result_data)
-                bfree(info.result_data, info.result_data_size, MEMORY_TAG_JOB);
-
-            // Update the job status for this job
-            if (!bmutex_lock(&state_ptr->job_status_mutex))
-                BERROR("Failed to lock job status mutex");
-            state_ptr->job_statuses[thread->info.id] = true;
-            if (!bmutex_unlock(&state_ptr->job_status_mutex))
-                BERROR("Failed to unlock job status mutex");
-
-            // Lock and reset the thread's info object
-            if (!bmutex_lock(&thread->info_mutex))
-                BERROR("Failed to obtain lock on job thread mutex");
-            if (thread->info.dependency_ids)
-                bfree(thread->info.dependency_ids, sizeof(u16) * thread->info.dependency_count, MEMORY_TAG_ARRAY);
-            bzero_memory(&thread->info, sizeof(job_info));
-            if (!bmutex_unlock(&thread->info_mutex))
-                BERROR("Failed to release lock on job thread mutex");
+            job_thread* victim = &state_ptr->job_threads[(start + i) % thread_count];
+            if (job_queue_steal_top(&victim->queues[priority], type_mask, false, out_info))
+                return true;
         }
+    }
+    return false;
+}
 
-        // If no longer running shut down the thread
-        if (!state_ptr->running)
-            break;
+// Checks, without taking anything, whether this thread could find work right now
+static b8 job_thread_has_work(job_thread* thread)
+{
+    u32 thread_count = state_ptr->thread_count;
+    for (u32 priority = 0; priority < JOB_PRIORITY_COUNT; ++priority)
+    {
+        for (u32 i = 0; i < thread_count; ++i)
+        {
+            job_thread* other = &state_ptr->job_threads[(thread->index + i) % thread_count];
+            if (job_queue_steal_top(&other->queues[priority], thread->type_mask, true, 0))
+                return true;
+        }
     }
+    return false;
+}
 
-    // Destroy mutex for this thread
-    bmutex_destroy(&thread->info_mutex);
+static u32 job_thread_run(void* params)
+{
+    u32 index = *(u8*)params;
+    job_thread* thread = &state_ptr->job_threads[index];
+    current_job_thread = thread;
+    BTRACE("Starting job thread #%i (id=%#x, type=%#x)", thread->index, thread->thread.thread_id, thread->type_mask);
+
+    // Run until shut down, pulling work as soon as the previous job is done
+    while (state_ptr->running)
+    {
+        job_info info;
+        if (job_find(thread, thread->type_mask, &info))
+        {
+            job_execute(&info);
+            continue;
+        }
+
+        // Nothing to do. Announce the intent to sleep, then check again so a job submitted in between isn't missed
+        batomic_store_u32(&thread->sleeping, 1);
+        batomic_thread_fence();
+        if (!state_ptr->running || job_thread_has_work(thread))
+        {
+            // If a submitter already claimed the wake-up, consume its signal so the semaphore count stays balanced
+            if (!batomic_exchange_u32(&thread->sleeping, 0))
+                bsemaphore_wait(&thread->semaphore, 0xFFFFFFFF);
+            continue;
+        }
+        bsemaphore_wait(&thread->semaphore, 0xFFFFFFFF);
+    }
 
-    // Destroy semaphore
-    bsemaphore_destroy(&thread->semaphore);
+    current_job_thread = 0;
+
+    // Hand back any cached allocations and scratch arenas before the thread goes away
+    frame_scratch_thread_release();
+    memory_system_thread_release();
 
     return 1;
 }
@@ -180,7 +594,7 @@ static u32 job_thread_run(void* params)
 b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void* config)
 {
     job_system_config* typed_config = (job_system_config*)config;
-    *job_system_memory_requirement = sizeof(job_system_state) + (sizeof(u8) * (INVALID_ID_U16 - 1));
+    *job_system_memory_requirement = sizeof(job_system_state) + (sizeof(job_slot) * JOB_SLOT_COUNT) + (sizeof(u32) * JOB_SLOT_COUNT);
     if (state == 0)
         return true;
 
@@ -188,60 +602,59 @@ b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void*
 
     state_ptr = state;
     state_ptr->running = true;
-    state_ptr->job_statuses = (void*)((u64)state_ptr + sizeof(job_system_state));
-
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->low_priority_queue);
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->normal_priority_queue);
-    ring_queue_create(sizeof(job_info), 1024, 0, &state_ptr->high_priority_queue);
     state_ptr->thread_count = typed_config->max_job_thread_count;
 
-    // Invalidate all result slots
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i)
-        state_ptr->pending_results[i].id = INVALID_ID_U16;
+    // Every slot starts out free, which reads as complete
+    state_ptr->slots = (void*)((u64)state_ptr + sizeof(job_system_state));
+    state_ptr->free_slots = (void*)((u64)state_ptr->slots + (sizeof(job_slot) * JOB_SLOT_COUNT));
+    bspinlock_create(&state_ptr->free_slot_lock);
+    for (u32 i = 0; i < JOB_SLOT_COUNT; ++i)
+    {
+        job_slot* slot = &state_ptr->slots[i];
+        slot->state = 1;
+        bspinlock_create(&slot->lock);
+        slot->continuations = 0;
+        // Reversed so that low indices are handed out first
+        state_ptr->free_slots[i] = JOB_SLOT_COUNT - 1 - i;
+    }
+    state_ptr->free_slot_count = JOB_SLOT_COUNT;
+
+    // Each result entry starts out ready for the position matching its index
+    for (u32 i = 0; i < JOB_RESULT_RING_SIZE; ++i)
+        state_ptr->results[i].sequence = i;
+    bspinlock_create(&state_ptr->result_overflow_lock);
 
     BDEBUG("Main thread id is: %#x", platform_current_thread_id());
 
     BDEBUG("Spawning %i job threads", state_ptr->thread_count);
 
+    // Queues and semaphores must all exist before any thread starts, since threads steal from each other
     for (u8 i = 0; i < state_ptr->thread_count; ++i)
     {
-        state_ptr->job_threads[i].index = i;
-        state_ptr->job_threads[i].type_mask = typed_config->type_masks[i];
-        if (!bthread_create(job_thread_run, &state_ptr->job_threads[i].index, false, &state_ptr->job_threads[i].thread))
+        job_thread* thread = &state_ptr->job_threads[i];
+        thread->index = i;
+        thread->type_mask = typed_config->type_masks[i];
+        for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p)
+            job_queue_create(&thread->queues[p]);
+        if (!bsemaphore_create(&thread->semaphore, 1, 0))
         {
-            BFATAL("OS Error in creating job thread. Application cannot continue");
+            BERROR("Failed to create job thread semaphore!");
             return false;
         }
-        bzero_memory(&state_ptr->job_threads[i].info, sizeof(job_info));
     }
 
-    // Create needed mutexes
-    if (!bmutex_create(&state_ptr->result_mutex))
-    {
-        BERROR("Failed to create result mutex!");
-        return false;
-    }
-    if (!bmutex_create(&state_ptr->low_pri_queue_mutex))
-    {
-        BERROR("Failed to create low priority queue mutex!");
-        return false;
-    }
-    if (!bmutex_create(&state_ptr->normal_pri_queue_mutex))
-    {
-        BERROR("Failed to create normal priority queue mutex!");
-        return false;
-    }
-    if (!bmutex_create(&state_ptr->high_pri_queue_mutex))
-    {
-        BERROR("Failed to create high priority queue mutex!");
-        return false;
-    }
-    if (!bmutex_create(&state_ptr->job_status_mutex))
+    for (u8 i = 0; i < state_ptr->thread_count; ++i)
     {
-        BERROR("Failed to create job status mutex!");
-        return false;
+        if (!bthread_create(job_thread_run, &state_ptr->job_threads[i].index, false, &state_ptr->job_threads[i].thread))
+        {
+            BFATAL("OS Error in creating job thread. Application cannot continue");
+            return false;
+        }
     }
 
+    // Let core code split loops across the job threads too
+    bparallel_for_dispatcher_set(job_system_parallel_for);
+
     return true;
 }
 
@@ -249,93 +662,52 @@ void job_system_shutdown(void* state)
 {
     if (state_ptr)
     {
+        bparallel_for_dispatcher_set(0);
         state_ptr->running = false;
+        batomic_thread_fence();
 
         u64 thread_count = state_ptr->thread_count;
 
-        // Check for free thread first
+        // Wake everything up and wait for each thread to notice
         for (u8 i = 0; i < thread_count; ++i)
-            bthread_destroy(&state_ptr->job_threads[i].thread);
-        ring_queue_destroy(&state_ptr->low_priority_queue);
-        ring_queue_destroy(&state_ptr->normal_priority_queue);
-        ring_queue_destroy(&state_ptr->high_priority_queue);
-
-        // Destroy mutexes
-        bmutex_destroy(&state_ptr->result_mutex);
-        bmutex_destroy(&state_ptr->low_pri_queue_mutex);
-        bmutex_destroy(&state_ptr->normal_pri_queue_mutex);
-        bmutex_destroy(&state_ptr->high_pri_queue_mutex);
-        bmutex_destroy(&state_ptr->job_status_mutex);
-
-        state_ptr = 0;
-    }
-}
-
-static void process_queue(ring_queue* queue, bmutex* queue_mutex)
-{
-    u64 thread_count = state_ptr->thread_count;
+            job_thread_wake(&state_ptr->job_threads[i]);
+        for (u8 i = 0; i < thread_count; ++i)
+        {
+            job_thread* thread = &state_ptr->job_threads[i];
+            bthread_wait(&thread->thread);
+            bthread_destroy(&thread->thread);
+        }
 
-    // Check for free thread first
-    while (queue->length > 0)
-    {
-        job_info info;
-        if (!ring_queue_peek(queue, &info))
-            break;
-        
-        // Verify dependencies are complete
-        b8 awaiting_dependency = false;
-        if (info.dependency_count)
+        // Anything never started is dropped, including jobs still waiting on dependencies
+        for (u32 i = 0; i < JOB_SLOT_COUNT; ++i)
         {
-            for (u32 i = 0; i < info.dependency_count; ++i)
+            job_continuation* link = state_ptr->slots[i].continuations;
+            state_ptr->slots[i].continuations = 0;
+            while (link)
             {
-                if (!job_system_query_job_complete(info.dependency_ids[i]))
-                {
-                    BTRACE("Note: Not starting job id %u because it's dependency (job id=%u) is still running", info.id, info.dependency_ids[i]);
-                    awaiting_dependency = true;
-                    break;
-                }
+                job_continuation* next = link->next;
+                job_pending_release(link->pending, true);
+                bfree(link, sizeof(job_continuation), MEMORY_TAG_JOB);
+                link = next;
             }
         }
-
-        if (awaiting_dependency)
-            continue;
-
-        b8 thread_found = false;
         for (u8 i = 0; i < thread_count; ++i)
         {
             job_thread* thread = &state_ptr->job_threads[i];
-            if ((thread->type_mask & info.type) == 0)
-                continue;
-
-            // Check that job thread can handle job type
-            if (!bmutex_lock(&thread->info_mutex))
-                BERROR("Failed to obtain lock on job thread mutex!");
-            if (!thread->info.entry_point)
+            for (u32 p = 0; p < JOB_PRIORITY_COUNT; ++p)
             {
-                // Make sure to remove entry from the queue
-                if (!bmutex_lock(queue_mutex))
-                    BERROR("Failed to obtain lock on queue mutex!");
-                ring_queue_dequeue(queue, &info);
-                if (!bmutex_unlock(queue_mutex))
-                    BERROR("Failed to release lock on queue mutex!");
-                thread->info = info;
-                BTRACE("Assigning job to thread: %u", thread->index);
-                thread_found = true;
-                // Signal the thread's semaphore since there is work to be done
-                bsemaphore_signal(&thread->semaphore);
+                job_info info;
+                while (job_queue_pop_bottom(&thread->queues[p], &info))
+                    job_release(&info);
+                job_queue_destroy(&thread->queues[p]);
             }
-            if (!bmutex_unlock(&thread->info_mutex))
-                BERROR("Failed to release lock on job thread mutex!");
-
-            // Break after unlocking if available thread was found
-            if (thread_found)
-                break;
+            bsemaphore_destroy(&thread->semaphore);
         }
 
-        // This means all of the threads are currently handling a job,
-        // so wait until the next update and try again
-        if (!thread_found)
-            break;
+        // Callbacks which never got to run are dropped too
+        job_results_process(false);
+
+        state_ptr = 0;
     }
 }
 
@@ -344,93 +716,76 @@ b8 job_system_update(void* state, struct frame_data* p_frame_data)
     if (!state_ptr || !state_ptr->running)
         return false;
 
-    process_queue(&state_ptr->high_priority_queue, &state_ptr->high_pri_queue_mutex);
-    process_queue(&state_ptr->normal_priority_queue, &state_ptr->normal_pri_queue_mutex);
-    process_queue(&state_ptr->low_priority_queue, &state_ptr->low_pri_queue_mutex);
-
-    // Process pending results
-    for (u16 i = 0; i < MAX_JOB_RESULTS; ++i)
-    {
-        // Lock and take copy, unlock
-        if (!bmutex_lock(&state_ptr->result_mutex))
-            BERROR("Failed to obtain lock on result mutex!");
-        job_result_entry entry = state_ptr->pending_results[i];
-        if (!bmutex_unlock(&state_ptr->result_mutex))
-            BERROR("Failed to release lock on result mutex!");
-
-        if (entry.id != INVALID_ID_U16)
-        {
-            // Execute callback
-            entry.callback(entry.params);
-
-            if (entry.params)
-                bfree(entry.params, entry.param_size, MEMORY_TAG_JOB);
-
-            // Lock actual entry, invalidate and clear it
-            if (!bmutex_lock(&state_ptr->result_mutex))
-            {
-                BERROR("Failed to obtain lock on result mutex!");
-            }
-            bzero_memory(&state_ptr->pending_results[i], sizeof(job_result_entry));
-            state_ptr->pending_results[i].id = INVALID_ID_U16;
-            if (!bmutex_unlock(&state_ptr->result_mutex))
-                BERROR("Failed to release lock on result mutex!");
-        }
-    }
+    // NOTE: Job threads pull work themselves, so all that is left here is to run completion callbacks on the main thread.
+    // Only results which actually arrived are touched, so this costs nothing on frames where no jobs complete
+    job_results_process(true);
 
     return true;
 }
 
 void job_system_submit(job_info info)
 {
-    u64 thread_count = state_ptr->thread_count;
-    ring_queue* queue = &state_ptr->normal_priority_queue;
-    bmutex* queue_mutex = &state_ptr->normal_pri_queue_mutex;
+    // Jobs with dependencies are held back until the last of them completes, rather than sitting in a queue
+    if (info.dependency_count)
+        job_schedule_after_dependencies(&info);
+    else
+        job_enqueue(&info);
+}
 
-    // If job is high priority, try to kick it off immediately
-    if (info.priority == JOB_PRIORITY_HIGH)
-    {
-        queue = &state_ptr->high_priority_queue;
-        queue_mutex = &state_ptr->high_pri_queue_mutex;
+void job_system_submit_with_counter(job_info info, job_counter* counter)
+{
+    if (counter)
+        batomic_fetch_add_u32(&counter->value, 1);
+    info.counter = counter;
+    job_system_submit(info);
+}
 
-        // Check for free thread that supports job type first
-        for (u8 i = 0; i < thread_count; ++i)
+static void job_enqueue(job_info* info)
+{
+    u32 thread_count = state_ptr->thread_count;
+    u32 priority = BCLAMP(info->priority, JOB_PRIORITY_LOW, JOB_PRIORITY_HIGH);
+
+    // Jobs spawned from a job thread stay local if that thread can run them, where they are
+    // hot in cache and cost nothing to hand out. Others go round-robin to a capable thread
+    job_thread* target = 0;
+    if (current_job_thread && (current_job_thread->type_mask & info->type))
+    {
+        target = current_job_thread;
+    }
+    else
+    {
+        u32 start = batomic_fetch_add_u32(&state_ptr->next_thread, 1);
+        for (u32 i = 0; i < thread_count; ++i)
         {
-            job_thread* thread = &state_ptr->job_threads[i];
-            if (state_ptr->job_threads[i].type_mask & info.type)
+            job_thread* thread = &state_ptr->job_threads[(start + i) % thread_count];
+            if (thread->type_mask & info->type)
             {
-                b8 found = false;
-                if (!bmutex_lock(&thread->info_mutex))
-                    BERROR("Failed to obtain lock on job thread mutex!");
-                if (!state_ptr->job_threads[i].info.entry_point)
-                {
-                    BTRACE("Job immediately submitted on thread %i", state_ptr->job_threads[i].index);
-                    state_ptr->job_threads[i].info = info;
-                    found = true;
-                }
-                if (!bmutex_unlock(&thread->info_mutex))
-                    BERROR("Failed to release lock on job thread mutex!");
-                if (found)
-                    return;
+                target = thread;
+                break;
             }
         }
     }
 
-    // If this point is reached, all threads are busy (if high)
-    // Add to queue and try again next cycle
-    if (info.priority == JOB_PRIORITY_LOW)
+    if (!target)
     {
-        queue = &state_ptr->low_priority_queue;
-        queue_mutex = &state_ptr->low_pri_queue_mutex;
+        BERROR("job_system_submit - no job thread can handle job type %#x. Job dropped", info->type);
+        // Still count it as done so nothing waits on it forever
+        job_handle handle = info->handle;
+        job_counter* counter = info->counter;
+        job_release(info);
+        if (handle.index != INVALID_ID)
+            job_complete(handle);
+        if (counter)
+            batomic_fetch_sub_u32(&counter->value, 1);
+        return;
     }
 
-    // NOTE: Locking here in case job is submitted from another job/thread
-    if (!bmutex_lock(queue_mutex))
-        BERROR("Failed to obtain lock on queue mutex!");
-    ring_queue_enqueue(queue, &info);
-    if (!bmutex_unlock(queue_mutex))
-        BERROR("Failed to release lock on queue mutex!");
-    BTRACE("Job queued");
+    job_queue_push_bottom(&target->queues[priority], info);
+    batomic_thread_fence();
+
+    // Wake the owner if idle. If it's busy, wake someone else to steal it instead
+    if (target == current_job_thread || !job_thread_wake(target))
+        job_thread_wake_one(info->type, target);
 }
 
 job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size)
@@ -458,7 +813,7 @@ job_info job_create_with_dependencies(
     job_type type,
     job_priority priority,
     u8 dependency_count,
-    u16* dependencies)
+    job_handle* dependencies)
 {
     job_info job;
     job.entry_point = entry_point;
@@ -466,17 +821,9 @@ job_info job_create_with_dependencies(
     job.on_fail = on_fail;
     job.type = type;
     job.priority = priority;
+    job.counter = 0;
 
-    if (!bmutex_lock(&state_ptr->job_status_mutex))
-        BERROR("Failed to lock job status mutex!");
-
-    // TODO: Pack booleans
-    BASSERT_MSG(state_ptr->current_job_id < INVALID_ID_U16, "Job system identifier overflow - need to pack booleans");
-    job.id = state_ptr->current_job_id;
-    state_ptr->current_job_id++;
-    state_ptr->job_statuses[job.id] = false;
-    if (!bmutex_unlock(&state_ptr->job_status_mutex))
-        BERROR("Failed to unlock job status mutex!");
+    job.handle = job_slot_acquire();
 
     job.param_data_size = param_data_size;
     if (param_data_size)
@@ -498,30 +845,145 @@ job_info job_create_with_dependencies(
     job.dependency_count = dependency_count;
     if (dependency_count)
     {
-        job.dependency_ids = ballocate(sizeof(u16) * dependency_count, MEMORY_TAG_ARRAY);
-        bcopy_memory(job.dependency_ids, dependencies, sizeof(u16) * dependency_count);
+        job.dependencies = ballocate(sizeof(job_handle) * dependency_count, MEMORY_TAG_ARRAY);
+        bcopy_memory(job.dependencies, dependencies, sizeof(job_handle) * dependency_count);
     }
     else
     {
-        job.dependency_ids = 0;
+        job.dependencies = 0;
     }
 
     return job;
 }
 
-b8 job_system_query_job_complete(u16 job_id)
+b8 job_system_query_job_complete(job_handle job)
+{
+    return job_slot_get_pending(job) == 0;
+}
+
+job_handle job_handle_invalid(void)
 {
-    b8 status = INVALID_ID;
-    if (!bmutex_lock(&state_ptr->job_status_mutex))
-        BERROR("Failed to lock job status mutex!");
-    status = state_ptr->job_statuses[job_id];
-    if (!bmutex_unlock(&state_ptr->job_status_mutex))
-        BERROR("Failed to unlock job status mutex!");
+    job_handle handle;
+    handle.index = INVALID_ID;
+    handle.generation = INVALID_ID;
+    return handle;
+}
 
-    return status;
+// Runs one job on behalf of whoever is waiting. Returns false if there was nothing it could run
+static b8 job_system_help(void)
+{
+    job_info info;
+    // NOTE: Threads outside the job system only pick up general work, since other types may need a specific thread (i.e. GPU resources)
+    b8 found = current_job_thread ? job_find(current_job_thread, current_job_thread->type_mask, &info) : job_find(0, JOB_TYPE_GENERAL, &info);
+    if (found)
+        job_execute(&info);
+    return found;
 }
 
-b8 job_system_wait_for_jobs(u8 job_count, u16 job_ids)
+void job_system_wait_for_counter(job_counter* counter)
 {
+    while (batomic_load_u32(&counter->value))
+    {
+        if (!job_system_help())
+            platform_sleep(0);
+    }
+}
+
+b8 job_system_wait_for_jobs(u8 job_count, job_handle* jobs)
+{
+    if (!state_ptr)
+        return false;
+
+    for (u8 i = 0; i < job_count; ++i)
+    {
+        while (!job_system_query_job_complete(jobs[i]))
+        {
+            if (!job_system_help())
+                platform_sleep(0);
+        }
+    }
+    return true;
+}
+
+// Shared by everyone working on a single parallel-for. Lives on the caller's stack
+typedef struct parallel_for_state
+{
+    pfn_parallel_range fn;
+    void* user;
+    u32 count;
+    u32 grain;
+    u32 chunk_count;
+    // The next chunk to be claimed
+    volatile u32 next_chunk;
+} parallel_for_state;
+
+// Claims and runs chunks until there are none left
+static void parallel_for_run_chunks(parallel_for_state* pf)
+{
+    for (;;)
+    {
+        u32 chunk = batomic_fetch_add_u32(&pf->next_chunk, 1);
+        if (chunk >= pf->chunk_count)
+            break;
+
+        u32 begin = chunk * pf->grain;
+        u32 end = (pf->count - begin) < pf->grain ? pf->count : begin + pf->grain;
+        pf->fn(begin, end, pf->user);
+    }
+}
+
+static b8 parallel_for_job_entry(void* param_data, void* result_data)
+{
+    parallel_for_run_chunks(param_data);
     return true;
 }
+
+void job_system_parallel_for(u32 count, u32 grain, pfn_parallel_range fn, void* user)
+{
+    if (!count || !fn)
+        return;
+    if (!grain)
+        grain = 1;
+
+    // Not worth splitting, or nobody to split it with
+    if (!state_ptr || !state_ptr->running || count <= grain)
+    {
+        fn(0, count, user);
+        return;
+    }
+
+    parallel_for_state pf;
+    pf.fn = fn;
+    pf.user = user;
+    pf.count = count;
+    pf.grain = grain;
+    pf.chunk_count = (u32)(((u64)count + grain - 1) / grain);
+    pf.next_chunk = 0;
+
+    // One helper per thread that can take general work, but never more than there are chunks left for them
+    u32 helper_count = 0;
+    for (u32 i = 0; i < state_ptr->thread_count; ++i)
+    {
+        if (state_ptr->job_threads[i].type_mask & JOB_TYPE_GENERAL)
+            helper_count++;
+    }
+    helper_count = BMIN(helper_count, pf.chunk_count - 1);
+
+    // Helpers point back at the shared state instead of carrying their own range, so nothing is
+    // allocated per chunk. They take no job slot either, as nothing can depend on them but the counter
+    job_info helper = {0};
+    helper.type = JOB_TYPE_GENERAL;
+    helper.handle = job_handle_invalid();
+    helper.priority = JOB_PRIORITY_HIGH;
+    helper.entry_point = parallel_for_job_entry;
+    helper.param_data = &pf;
+
+    job_counter counter = {0};
+    for (u32 i = 0; i < helper_count; ++i)
+        job_system_submit_with_counter(helper, &counter);
+
+    // Work alongside the helpers, then wait for the chunks they claimed. Helpers started after
+    // the last chunk is claimed find nothing to do and finish straight away
+    parallel_for_run_chunks(&pf);
+    job_system_wait_for_counter(&counter);
+}
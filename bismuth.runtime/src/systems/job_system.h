@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defines.h"
+#include "threads/bparallel.h"
 
 typedef b8 (*pfn_job_start)(void*, void*);
 
@@ -22,11 +23,34 @@ typedef enum job_priority
     JOB_PRIORITY_HIGH
 } job_priority;
 
+/**
+ * @brief A counter which tracks a group of outstanding jobs. Each job submitted with the
+ * counter increments it, and decrements it when complete, so a value of 0 means the whole
+ * group is done. Zero-initialize before use. Must outlive every job submitted with it.
+ */
+typedef struct job_counter
+{
+    volatile u32 value;
+} job_counter;
+
+/**
+ * @brief Identifies a submitted job. Handles are recycled, so each carries the generation of its
+ * slot; once the job completes and the slot is reused, the old handle simply reads as complete.
+ * This means any number of jobs can be created over the lifetime of the job system.
+ */
+typedef struct job_handle
+{
+    /** @brief Index of the job slot. Considered invalid if == INVALID_ID */
+    u32 index;
+    /** @brief Generation of the slot when the job was created */
+    u32 generation;
+} job_handle;
+
 typedef struct job_info
 {
     job_type type;
 
-    u16 id;
+    job_handle handle;
 
     job_priority priority;
 
@@ -46,7 +70,10 @@ typedef struct job_info
 
     u8 dependency_count;
 
-    u16* dependency_ids;
+    job_handle* dependencies;
+
+    // Decremented when this job completes. Set via job_system_submit_with_counter
+    job_counter* counter;
 } job_info;
 
 typedef struct job_system_config
@@ -55,13 +82,51 @@ typedef struct job_system_config
     u32* type_masks;
 } job_system_config;
 
-b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void* config);
-void job_system_shutdown(void* state);
+BAPI b8 job_system_initialize(u64* job_system_memory_requirement, void* state, void* config);
+BAPI void job_system_shutdown(void* state);
 
-b8 job_system_update(void* state, struct frame_data* p_frame_data);
+BAPI b8 job_system_update(void* state, struct frame_data* p_frame_data);
 
+/**
+ * @brief Submits a job to be run. If the job has dependencies it is held back, and scheduled
+ * as a continuation once the last of them completes.
+ */
 BAPI void job_system_submit(job_info info);
 
+/**
+ * @brief Submits a job which decrements the given counter once complete. The counter is
+ * incremented immediately, so it can be waited on as soon as this returns.
+ */
+BAPI void job_system_submit_with_counter(job_info info, job_counter* counter);
+
+/**
+ * @brief Blocks until the given counter reaches 0. Rather than idling, the calling thread runs
+ * other queued jobs while it waits. Threads outside the job system only help with general jobs.
+ */
+BAPI void job_system_wait_for_counter(job_counter* counter);
+
+/**
+ * @brief Blocks until all of the given jobs are complete, running other queued jobs while waiting.
+ *
+ * @param job_count The number of job handles.
+ * @param jobs An array of handles of the jobs to wait on.
+ * @return True on success; otherwise false.
+ */
+BAPI b8 job_system_wait_for_jobs(u8 job_count, job_handle* jobs);
+
+/**
+ * @brief Runs fn over the range [0, count), split into chunks of up to grain items which are
+ * spread across the job threads able to take general work. The calling thread works through
+ * chunks too, and this only returns once all of them are done. Nothing is allocated per chunk.
+ * Runs fn on the calling thread if the range fits in a single chunk or the job system isn't running.
+ *
+ * @param count The number of items in the range.
+ * @param grain The most items handed to fn per call. Larger grains mean less overhead, smaller ones better balance.
+ * @param fn The function to run on each chunk. Must only touch the items it is given.
+ * @param user User data passed to each call of fn.
+ */
+BAPI void job_system_parallel_for(u32 count, u32 grain, pfn_parallel_range fn, void* user);
+
 BAPI job_info job_create(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size);
 
 BAPI job_info job_create_type(pfn_job_start entry_point, pfn_job_on_complete on_success, pfn_job_on_complete on_fail, void* param_data, u32 param_data_size, u32 result_data_size, job_type type);
@@ -78,6 +143,9 @@ BAPI job_info job_create_with_dependencies(
     job_type type,
     job_priority priority,
     u8 dependency_count,
-    u16* dependencies);
+    job_handle* dependencies);
+
+BAPI b8 job_system_query_job_complete(job_handle job);
 
-BAPI b8 job_system_query_job_complete(u16 job_id);
+/** @brief Returns an invalid job handle. Invalid handles always read as complete */
+BAPI job_handle job_handle_invalid(void);
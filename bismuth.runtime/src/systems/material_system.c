@@ -2,6 +2,7 @@
 
 #include <assets/basset_types.h>
 #include <containers/darray.h>
+#include <containers/slot_map.h>
 #include <core_render_types.h>
 #include <debug/bassert.h>
 #include <defines.h>
@@ -335,6 +336,11 @@ typedef struct material_system_state
     // darray of material instances, indexed first by material bhandle index, then by instance bhandle index
     material_instance_data** instances;
 
+    // Hands out material handles. Its slots line up with the materials array
+    slot_map material_handles;
+    // darray of maps handing out instance handles, one per material slot. Each lines up with that material's instance array
+    slot_map* instance_handles;
+
     // A default material for each type of material
     material_data* default_standard_material;
     material_data* default_water_material;
@@ -417,6 +423,12 @@ b8 material_system_initialize(u64* memory_requirement, material_system_state* st
     state->materials = darray_reserve(material_data, config->max_material_count);
     // An array for each material will be created when a material is created
     state->instances = darray_reserve(material_instance_data*, config->max_material_count);
+    state->instance_handles = darray_reserve(slot_map, config->max_material_count);
+    if (!slot_map_create(0, config->max_material_count, &state->material_handles))
+    {
+        BERROR("Failed to create material handle map");
+        return false;
+    }
 
     state->default_texture = texture_system_request_cube(bname_create(DEFAULT_TEXTURE_NAME), false, false, 0, 0);
     state->default_ibl_cubemap = texture_system_request_cube(bname_create(DEFAULT_CUBE_TEXTURE_NAME), false, false, 0, 0);
@@ -721,6 +733,13 @@ void material_system_shutdown(struct material_system_state* state)
         material_destroy(state, state->default_water_material, 1);
         // TODO: destroy this when it's implemented
         /* material_destroy(state, state->default_blended_material, 2); */
+
+        u32 material_slot_count = darray_length(state->instance_handles);
+        for (u32 i = 0; i < material_slot_count; ++i)
+            slot_map_destroy(&state->instance_handles[i]);
+        darray_destroy(state->instance_handles);
+        state->instance_handles = 0;
+        slot_map_destroy(&state->material_handles);
     }
 }
 
@@ -1640,23 +1659,12 @@ material_instance material_system_get_default_blended(material_system_state* sta
 
 void material_system_dump(material_system_state* state)
 {
-    u32 material_count = darray_length(state->materials);
-    for (u32 i = 0; i < material_count; ++i)
+    // Only live materials are visited, and each instance map knows its own live count
+    for (u32 i = 0; i < state->material_handles.count; ++i)
     {
-        material_data* m = &state->materials[i];
-        // Skip "free" slots
-        if (m->unique_id == INVALID_ID_U64)
-            continue;
-
-        material_instance_data* instance_array = state->instances[i];
-        // Get a count of active instances
-        u32 instance_count = darray_length(instance_array);
-        u32 active_instance_count = 0;
-        for (u32 j = 0; j < instance_count; ++j)
-        {
-            if (instance_array[j].unique_id != INVALID_ID_U64)
-                active_instance_count++;
-        }
+        u32 index = slot_map_handle_at(&state->material_handles, i).handle_index;
+        material_data* m = &state->materials[index];
+        u32 active_instance_count = state->instance_handles[index].count;
 
         BINFO("Material name: '%s', active instance count = %u", bname_string_get(m->name), active_instance_count);
     }
@@ -1823,34 +1831,31 @@ static bhandle get_shader_for_material_type(const material_system_state* state,
 
 static bhandle material_handle_create(material_system_state* state, bname name)
 {
-    u32 resource_index = INVALID_ID;
-
-    // Attempt to find a free "slot", or create a new entry if there isn't one
-    u32 material_count = darray_length(state->materials);
-    for (u32 i = 0; i < material_count; ++i)
+    // Take a free slot, or a new one if there are none
+    bhandle handle;
+    if (!slot_map_add(&state->material_handles, 0, &handle))
     {
-        if (state->materials[i].unique_id == INVALID_ID_U64)
-        {
-            // free slot. An array should already exists for instances here
-            resource_index = i;
-            break;
-        }
+        BERROR("Failed to create material handle");
+        return bhandle_invalid();
     }
-    if (resource_index == INVALID_ID)
+    u32 resource_index = handle.handle_index;
+
+    // Fresh slots are handed out in index order, so one past the end of the arrays is new. Each new slot also needs its own instances
+    while (darray_length(state->materials) <= resource_index)
     {
-        resource_index = material_count;
-        darray_push(state->materials, (material_data){0});
-        // This also means a new entry needs to be created at this index for instances
+        material_data empty_material = {0};
+        empty_material.unique_id = INVALID_ID_U64;
+        darray_push(state->materials, empty_material);
         material_instance_data* new_inst_array = darray_create(material_instance_data);
-        new_inst_array->unique_id = INVALID_ID_U64;
         darray_push(state->instances, new_inst_array);
+        slot_map new_inst_handles = {0};
+        slot_map_create(0, 0, &new_inst_handles);
+        darray_push(state->instance_handles, new_inst_handles);
     }
 
     material_data* material = &state->materials[resource_index];
-
-    // Setup a handle first
-    bhandle handle = bhandle_create(resource_index);
     material->unique_id = handle.unique_id.uniqueid;
+    material->index = resource_index;
     material->name = name;
 
     BTRACE("Material system - new handle created at index: '%d'", resource_index);
@@ -1860,29 +1865,24 @@ static bhandle material_handle_create(material_system_state* state, bname name)
 
 static bhandle material_instance_handle_create(material_system_state* state, bhandle material_handle)
 {
-    u32 instance_index = INVALID_ID;
-
-    // Attempt to find a free "slot", or create a new entry if there isn't one
-    u32 instance_count = darray_length(state->instances[material_handle.handle_index]);
-    for (u32 i = 0; i < instance_count; ++i)
+    // Take a free slot in this material's instance map, or a new one if there are none
+    bhandle handle;
+    if (!slot_map_add(&state->instance_handles[material_handle.handle_index], 0, &handle))
     {
-        if (state->instances[material_handle.handle_index][i].unique_id == INVALID_ID_U64)
-        {
-            // free slot. An array should already exists for instances here
-            instance_index = i;
-            break;
-        }
+        BERROR("Failed to create material instance handle");
+        return bhandle_invalid();
     }
-    if (instance_index == INVALID_ID)
+    u32 instance_index = handle.handle_index;
+
+    // Fresh slots are handed out in index order, so one past the end of the array is new
+    while (darray_length(state->instances[material_handle.handle_index]) <= instance_index)
     {
-        instance_index = instance_count;
-        darray_push(state->instances[material_handle.handle_index], (material_instance_data){0});
+        material_instance_data empty_instance = {0};
+        empty_instance.unique_id = INVALID_ID_U64;
+        darray_push(state->instances[material_handle.handle_index], empty_instance);
     }
 
     material_instance_data* inst = &state->instances[material_handle.handle_index][instance_index];
-
-    // Setup a handle first
-    bhandle handle = bhandle_create(instance_index);
     inst->unique_id = handle.unique_id.uniqueid;
     inst->material = material_handle;
 
@@ -2148,16 +2148,17 @@ static void material_destroy(material_system_state* state, material_data* materi
 
     // TODO: Custom samplers
 
-    // Destroy instances
-    u32 instance_count = darray_length(state->instances[material_index]);
-    for (u32 i = 0; i < instance_count; ++i)
+    // Destroy instances. Each removes itself from the instance map, so walk the live entries from the back
+    slot_map* instance_handles = &state->instance_handles[material_index];
+    for (u32 i = instance_handles->count; i > 0; --i)
     {
-        material_instance_data* inst = &state->instances[material_index][i];
-        if (inst->unique_id != INVALID_ID_U64)
-        {
-            material_instance_destroy(state, material, inst);
-        }
+        u32 instance_index = slot_map_handle_at(instance_handles, i - 1).handle_index;
+        material_instance_destroy(state, material, &state->instances[material_index][instance_index]);
     }
+    slot_map_clear(instance_handles);
+
+    // Free the slot, making any outstanding handles to this material stale
+    slot_map_remove(&state->material_handles, bhandle_create_with_u64_identifier(material_index, material->unique_id), 0);
 
     bzero_memory(material, sizeof(material_data));
 
@@ -2201,6 +2202,11 @@ static void material_instance_destroy(material_system_state* state, material_dat
         // Release per-draw resources for the instance
         renderer_shader_per_draw_resources_release(state->renderer, get_shader_for_material_type(state, base_material->type), inst->per_draw_id);
 
+        // Free the slot, making any outstanding handles to this instance stale
+        material_instance_data* instance_array = state->instances[base_material->index];
+        u32 instance_index = (u32)(inst - instance_array);
+        slot_map_remove(&state->instance_handles[base_material->index], bhandle_create_with_u64_identifier(instance_index, inst->unique_id), 0);
+
         bzero_memory(inst, sizeof(material_instance_data));
 
         // Make sure to invalidate the entry
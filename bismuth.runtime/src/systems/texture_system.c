@@ -1,7 +1,7 @@
 #include "texture_system.h"
 
 #include "assets/basset_types.h"
-#include "containers/u64_bst.h"
+#include "containers/u64_btree.h"
 #include "core/engine.h"
 #include "core_render_types.h"
 #include "defines.h"
@@ -41,7 +41,7 @@ typedef struct texture_system_state
     b8* auto_releases;
 
     // For quick lookups by name
-    bt_node* texture_name_lookup;
+    u64_btree texture_name_lookup;
 
     btexture default_kresource_texture;
     btexture default_kresource_base_color_texture;
@@ -148,6 +148,8 @@ void texture_system_shutdown(void* state)
         BFREE_TYPE_CARRAY(state_ptr->texture_reference_counts, u16, typed_config->max_texture_count);
         BFREE_TYPE_CARRAY(state_ptr->auto_releases, b8, typed_config->max_texture_count);
 
+        u64_btree_cleanup(&state_ptr->texture_name_lookup);
+
         state_ptr->renderer = 0;
         state_ptr = 0;
     }
@@ -974,11 +976,11 @@ static btexture texture_get_if_exists(bname name)
     btexture t = 0;
 
     // Check first if an entry with the name exists. If it does, return it
-    const bt_node* node = u64_bst_find(state_ptr->texture_name_lookup, name);
+    const bt_node_value* node = u64_btree_find(&state_ptr->texture_name_lookup, name);
     if (node)
     {
         // Already exists, just return it
-        t = node->value.u16;
+        t = node->u16;
         if (state_ptr->formats[t] != BPIXEL_FORMAT_UNKNOWN)
         {
             BERROR("%s - lookup for name '%s' exists, but texture is invalid. This likely means a release wasn't done properly", __FUNCTION__, bname_string_get(name));
@@ -1002,9 +1004,7 @@ static btexture texture_get_new(bname name)
 
             // Insert into the lookup tree
             bt_node_value val = {.u16 = i};
-            bt_node* new_node = u64_bst_insert(state_ptr->texture_name_lookup, name, val);
-            if (!state_ptr->texture_name_lookup)
-                state_ptr->texture_name_lookup = new_node;
+            u64_btree_insert(&state_ptr->texture_name_lookup, name, val);
 
             // Start reference count at 1
             state_ptr->texture_reference_counts[i] = 1;
@@ -1,7 +1,7 @@
 #include "xform_system.h"
 
-#include <stdio.h>
-
+#include "containers/slot_map.h"
+#include "containers/sparse_set.h"
 #include "core/engine.h"
 #include "debug/bassert.h"
 #include "defines.h"
@@ -27,12 +27,11 @@ typedef struct xform_system_state
     // The scales in the world, indexed by handle
     vec3* scales;
 
-    // A globally unique id used to validate handles against the xform they were created for. Indexed by handle
-    identifier* ids;
+    // Hands out and validates handles. Slot indices index the arrays above
+    slot_map handles;
 
-    // A list of handle ids that represent dirty local xforms
-    u32* local_dirty_handles;
-    u32 local_dirty_count;
+    // The handle indices of dirty local xforms. Adding one which is already dirty is O(1)
+    sparse_set local_dirty;
 
     // The number of currently-allocated slots available (NOT the allocated space in bytes!)
     u32 allocated;
@@ -70,10 +69,11 @@ b8 xform_system_initialize(u64* memory_requirement, void* state, void* config)
     }
 
     ensure_allocated(state, typed_config->initial_slot_count);
-
-    // Invalidate all IDs
-    for (u32 i = 0; i < typed_config->initial_slot_count; ++i)
-        typed_state->ids[i].uniqueid = INVALID_ID_U64;
+    if (!slot_map_create(0, typed_config->initial_slot_count, &typed_state->handles))
+    {
+        BERROR("Failed to create xform handle map");
+        return false;
+    }
 
     dirty_list_reset(state);
 
@@ -111,16 +111,8 @@ void xform_system_shutdown(void* state)
             bfree_aligned(typed_state->scales, sizeof(vec3) * typed_state->allocated, 16, MEMORY_TAG_TRANSFORM);
             typed_state->scales = 0;
         }
-        if (typed_state->ids)
-        {
-            bfree_aligned(typed_state->ids, sizeof(identifier) * typed_state->allocated, 16, MEMORY_TAG_TRANSFORM);
-            typed_state->ids = 0;
-        }
-        if (typed_state->local_dirty_handles)
-        {
-            bfree_aligned(typed_state->local_dirty_handles, sizeof(u32) * typed_state->allocated, 16, MEMORY_TAG_TRANSFORM);
-            typed_state->local_dirty_handles = 0;
-        }
+        slot_map_destroy(&typed_state->handles);
+        sparse_set_destroy(&typed_state->local_dirty);
     }
 }
 
@@ -476,18 +468,16 @@ const char* xform_to_string(bhandle t)
         vec3 scale = state->scales[index];
         quat rotation = state->rotations[index];
 
-        return string_format(
-            "%f %f %f %f %f %f %f %f %f %f",
-            position.x,
-            position.y,
-            position.z,
-            rotation.x,
-            rotation.y,
-            rotation.z,
-            rotation.w,
-            scale.x,
-            scale.y,
-            scale.z);
+        f32 values[10] = {position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w, scale.x, scale.y, scale.z};
+        char buffer[10 * (STRING_F32_MAX_LENGTH + 1)];
+        u64 length = 0;
+        for (u32 i = 0; i < 10; ++i)
+        {
+            if (i > 0)
+                buffer[length++] = ' ';
+            length += (u64)string_format_f32(buffer + length, sizeof(buffer) - length, values[i]);
+        }
+        return string_duplicate(buffer);
     }
 
     BERROR("Invalid handle passed to xform_to_string. Returning null");
@@ -515,38 +505,34 @@ b8 xform_from_string(const char* str, bhandle* out_xform)
     }
     else
     {
-        f32 values[7] = {0};
-
-        i32 count = sscanf(
-            str,
-            "%f %f %f %f %f %f %f %f %f %f",
-            &position.x, &position.y, &position.z,
-            &values[0], &values[1], &values[2], &values[3], &values[4], &values[5], &values[6]);
+        f32 values[10] = {0};
+        u32 count = string_parse_f32_list(str, string_length(str), values, 10);
+        position = (vec3){values[0], values[1], values[2]};
 
         if (count == 10)
         {
             // Treat as quat, load directly
-            rotation.x = values[0];
-            rotation.y = values[1];
-            rotation.z = values[2];
-            rotation.w = values[3];
+            rotation.x = values[3];
+            rotation.y = values[4];
+            rotation.z = values[5];
+            rotation.w = values[6];
 
             // Set scale
-            scale.x = values[4];
-            scale.y = values[5];
-            scale.z = values[6];
+            scale.x = values[7];
+            scale.y = values[8];
+            scale.z = values[9];
         }
         else if (count == 9)
         {
-            quat x_rot = quat_from_axis_angle((vec3){1.0f, 0, 0}, deg_to_rad(values[0]), true);
-            quat y_rot = quat_from_axis_angle((vec3){0, 1.0f, 0}, deg_to_rad(values[1]), true);
-            quat z_rot = quat_from_axis_angle((vec3){0, 0, 1.0f}, deg_to_rad(values[2]), true);
+            quat x_rot = quat_from_axis_angle((vec3){1.0f, 0, 0}, deg_to_rad(values[3]), true);
+            quat y_rot = quat_from_axis_angle((vec3){0, 1.0f, 0}, deg_to_rad(values[4]), true);
+            quat z_rot = quat_from_axis_angle((vec3){0, 0, 1.0f}, deg_to_rad(values[5]), true);
             rotation = quat_mul(x_rot, quat_mul(y_rot, z_rot));
 
             // Set scale
-            scale.x = values[3];
-            scale.y = values[4];
-            scale.z = values[5];
+            scale.x = values[6];
+            scale.y = values[7];
+            scale.z = values[8];
         }
         else
         {
@@ -586,66 +572,19 @@ static void ensure_allocated(xform_system_state* state, u32 slot_count)
 
     if (state->allocated < slot_count)
     {
-        // Setup the arrays of data, starting with the matrices.
+        // Grow the arrays of data, starting with the matrices. Growth happens in place where the allocator
+        // has room after the block, otherwise the contents are moved. Newly-exposed slots are zeroed either way.
         // These should be 16-bit aligned so that SIMD is an easy addition later on
-        mat4* new_local_matrices = ballocate_aligned(sizeof(mat4) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->local_matrices)
-        {
-            bcopy_memory(new_local_matrices, state->local_matrices, sizeof(mat4) * state->allocated);
-            bfree_aligned(state->local_matrices, sizeof(mat4) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->local_matrices = new_local_matrices;
-
-        mat4* new_world_matrices = ballocate_aligned(sizeof(mat4) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->world_matrices)
-        {
-            bcopy_memory(new_world_matrices, state->world_matrices, sizeof(mat4) * state->allocated);
-            bfree_aligned(state->world_matrices, sizeof(mat4) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->world_matrices = new_world_matrices;
+        state->local_matrices = breallocate_aligned(state->local_matrices, sizeof(mat4) * state->allocated, sizeof(mat4) * slot_count, 16, MEMORY_TAG_TRANSFORM);
+        state->world_matrices = breallocate_aligned(state->world_matrices, sizeof(mat4) * state->allocated, sizeof(mat4) * slot_count, 16, MEMORY_TAG_TRANSFORM);
 
         // Also align positions, rotations and scales for future SIMD purposes
-        vec3* new_positions = ballocate_aligned(sizeof(vec3) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->positions)
-        {
-            bcopy_memory(new_positions, state->positions, sizeof(vec3) * state->allocated);
-            bfree_aligned(state->positions, sizeof(vec3) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->positions = new_positions;
+        state->positions = breallocate_aligned(state->positions, sizeof(vec3) * state->allocated, sizeof(vec3) * slot_count, 16, MEMORY_TAG_TRANSFORM);
+        state->rotations = breallocate_aligned(state->rotations, sizeof(quat) * state->allocated, sizeof(quat) * slot_count, 16, MEMORY_TAG_TRANSFORM);
+        state->scales = breallocate_aligned(state->scales, sizeof(vec3) * state->allocated, sizeof(vec3) * slot_count, 16, MEMORY_TAG_TRANSFORM);
 
-        quat* new_rotations = ballocate_aligned(sizeof(quat) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->rotations)
-        {
-            bcopy_memory(new_rotations, state->rotations, sizeof(quat) * state->allocated);
-            bfree_aligned(state->rotations, sizeof(quat) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->rotations = new_rotations;
-
-        vec3* new_scales = ballocate_aligned(sizeof(vec3) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->scales)
-        {
-            bcopy_memory(new_scales, state->scales, sizeof(vec3) * state->allocated);
-            bfree_aligned(state->scales, sizeof(vec3) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->scales = new_scales;
-
-        // Identifiers don't *need* to be aligned, but do it anyways since everything else is
-        identifier* new_ids = ballocate_aligned(sizeof(identifier) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->ids)
-        {
-            bcopy_memory(new_ids, state->ids, sizeof(identifier) * state->allocated);
-            bfree_aligned(state->ids, sizeof(identifier) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->ids = new_ids;
-
-        // Dirty handle list doesn't *need* to be aligned, but do it anyways since everything else is
-        u32* new_dirty_handles = ballocate_aligned(sizeof(u32) * slot_count, 16, MEMORY_TAG_TRANSFORM);
-        if (state->local_dirty_handles)
-        {
-            bcopy_memory(new_dirty_handles, state->local_dirty_handles, sizeof(u32) * state->allocated);
-            bfree_aligned(state->local_dirty_handles, sizeof(u32) * state->allocated, 16, MEMORY_TAG_TRANSFORM);
-        }
-        state->local_dirty_handles = new_dirty_handles;
+        // Every slot may be dirty at once
+        sparse_set_resize(&state->local_dirty, slot_count);
 
         // Make sure the allocated count is up to date
         state->allocated = slot_count;
@@ -654,23 +593,13 @@ static void ensure_allocated(xform_system_state* state, u32 slot_count)
 
 static void dirty_list_reset(xform_system_state* state)
 {
-    for (u32 i = 0; i < state->local_dirty_count; ++i)
-        state->local_dirty_handles[i] = INVALID_ID;
-    state->local_dirty_count = 0;
+    sparse_set_clear(&state->local_dirty);
 }
 
 static void dirty_list_add(xform_system_state* state, bhandle t)
 {
-    for (u32 i = 0; i < state->local_dirty_count; ++i)
-    {
-        if (state->local_dirty_handles[i] == t.handle_index)
-        {
-            // Already there, do nothing
-            return;
-        }
-    }
-    state->local_dirty_handles[state->local_dirty_count] = t.handle_index;
-    state->local_dirty_count++;
+    // Does nothing if already there
+    sparse_set_insert(&state->local_dirty, t.handle_index);
 }
 
 static bhandle handle_create(xform_system_state* state)
@@ -678,22 +607,15 @@ static bhandle handle_create(xform_system_state* state)
     BASSERT_MSG(state, "xform_system state pointer accessed before initialized");
 
     bhandle handle;
-    u32 xform_count = state->allocated;
-    for (u32 i = 0; i < xform_count; ++i)
+    if (!slot_map_add(&state->handles, 0, &handle))
     {
-        if (state->ids[i].uniqueid == INVALID_ID_U64)
-        {
-            // Found an entry. Fill out the handle, and update the unique_id.uniqueid
-            handle = bhandle_create(i);
-            state->ids[i].uniqueid = handle.unique_id.uniqueid;
-            return handle;
-        }
+        BERROR("Failed to create xform handle");
+        return bhandle_invalid();
     }
 
-    // No open slots, expand array and use the first slot of the new memory
-    ensure_allocated(state, state->allocated * 2);
-    handle = bhandle_create(xform_count);
-    state->ids[xform_count].uniqueid = handle.unique_id.uniqueid;
+    // The map grows by doubling when full, so grow the data arrays to match
+    if (state->handles.capacity > state->allocated)
+        ensure_allocated(state, (state->handles.capacity + 7) & ~7u);
     return handle;
 }
 
@@ -701,9 +623,9 @@ static void handle_destroy(xform_system_state* state, bhandle* t)
 {
     BASSERT_MSG(state, "xform_system state pointer accessed before initialized");
 
-    if (t->handle_index != INVALID_ID)
-        state->ids[t->handle_index].uniqueid = INVALID_ID_U64;
-
+    // A destroyed xform has nothing left to update, and its slot may be reused before the next update
+    if (slot_map_remove(&state->handles, *t, 0))
+        sparse_set_remove(&state->local_dirty, t->handle_index);
     bhandle_invalidate(t);
 }
 
@@ -715,12 +637,5 @@ static b8 validate_handle(xform_system_state* state, bhandle handle)
         return false;
     }
 
-    if (handle.handle_index >= state->allocated)
-    {
-        BTRACE("Provided handle index is out of bounds: %u", handle.handle_index);
-        return false;
-    }
-
-    // Check for a match
-    return state->ids[handle.handle_index].uniqueid == handle.unique_id.uniqueid;
+    return slot_map_is_valid(&state->handles, handle);
 }
@@ -1,6 +1,10 @@
 #include <containers/darray.h>
 #include <defines.h>
 #include <logger.h>
+#include <memory/bmemory.h>
+#include <parsers/bson_binary.h>
+#include <parsers/bson_parser.h>
+#include <platform/filesystem.h>
 #include <stdio.h>
 #include <strings/bstring.h>
 #include <utils/crc64.h>
@@ -16,6 +20,7 @@
 
 void print_help(void);
 i32 combine_texture_maps(i32 argc, char** argv);
+i32 convert_bson(i32 argc, char** argv);
 
 i32 main(i32 argc, char** argv)
 {
@@ -40,6 +45,10 @@ i32 main(i32 argc, char** argv)
     {
         return combine_texture_maps(argc, argv);
     }
+    else if (strings_equali(argv[1], "bson"))
+    {
+        return convert_bson(argc, argv);
+    }
     else
     {
         BERROR("Unrecognized argument '%s'", argv[1]);
@@ -231,6 +240,89 @@ i32 combine_texture_maps(i32 argc, char** argv)
     return 0;
 }
 
+i32 convert_bson(i32 argc, char** argv)
+{
+    // tools.exe bson [infile] [outfile]
+    // Text input is written out as binary bson, and binary input as text
+    if (argc != 4)
+    {
+        BERROR("bson mode requires an input and output file. Usage: bson [infile] [outfile]");
+        return -3;
+    }
+
+    file_handle in_file;
+    if (!filesystem_open(argv[2], FILE_MODE_READ, true, &in_file))
+    {
+        BERROR("Failed to open '%s'", argv[2]);
+        return -4;
+    }
+    u64 in_size = 0;
+    filesystem_size(&in_file, &in_size);
+    // NOTE: One extra byte so text input is null-terminated. ballocate() also keeps the buffer aligned for the binary reader
+    u8* in_data = ballocate(in_size + 1, MEMORY_TAG_ARRAY);
+    u64 bytes_read = 0;
+    b8 read = filesystem_read_all_bytes(&in_file, in_data, &bytes_read);
+    filesystem_close(&in_file);
+    if (!read || bytes_read != in_size)
+    {
+        BERROR("Failed to read '%s'", argv[2]);
+        bfree(in_data, in_size + 1, MEMORY_TAG_ARRAY);
+        return -5;
+    }
+
+    b8 to_binary = !bson_binary_is_binary(in_data, in_size);
+    bson_tree tree;
+    b8 parsed = to_binary ? bson_tree_from_string((const char*)in_data, &tree) : bson_tree_from_binary(in_data, in_size, &tree);
+    bfree(in_data, in_size + 1, MEMORY_TAG_ARRAY);
+    if (!parsed)
+    {
+        BERROR("Failed to parse '%s'", argv[2]);
+        return -6;
+    }
+
+    u64 out_size = 0;
+    void* out_data = 0;
+    const char* out_text = 0;
+    if (to_binary)
+    {
+        if (!bson_tree_to_binary(&tree, &out_size, &out_data))
+        {
+            BERROR("Failed to convert '%s' to binary", argv[2]);
+            bson_tree_cleanup(&tree);
+            return -7;
+        }
+    }
+    else
+    {
+        out_text = bson_tree_to_string(&tree);
+        out_size = string_length(out_text);
+    }
+    bson_tree_cleanup(&tree);
+
+    file_handle out_file;
+    b8 written = false;
+    if (filesystem_open(argv[3], FILE_MODE_WRITE, true, &out_file))
+    {
+        u64 bytes_written = 0;
+        written = filesystem_write(&out_file, out_size, to_binary ? out_data : (const void*)out_text, &bytes_written) && bytes_written == out_size;
+        filesystem_close(&out_file);
+    }
+
+    if (to_binary)
+        bfree(out_data, out_size, MEMORY_TAG_ARRAY);
+    else
+        string_free(out_text);
+
+    if (!written)
+    {
+        BERROR("Failed to write '%s'", argv[3]);
+        return -8;
+    }
+
+    BINFO("Converted '%s' (%lluB) to %s '%s' (%lluB)", argv[2], in_size, to_binary ? "binary" : "text", argv[3], out_size);
+    return 0;
+}
+
 void print_help(void)
 {
 #ifdef BPLATFORM_WINDOWS
@@ -248,6 +340,8 @@ void print_help(void)
                     should be provided that all end in <stage>.glsl, where <stage> is\n\
                     replaced by one of the following supported stages:\n\
                         vert, frag, geom, comp\n\
-                    Compiled .spv file is output to the same path as the input file\n",
+                    Compiled .spv file is output to the same path as the input file\n\
+    bson         -  Converts a bson file between text and binary. Usage: bson [infile] [outfile]\n\
+                    Text input is written as binary, and binary input as text\n",
         extension);
 }
@@ -968,7 +968,10 @@ b8 application_update(struct application* game_inst, struct frame_data* p_frame_
         }
 
         char* vsync_text = renderer_flag_enabled_get(RENDERER_CONFIG_FLAG_VSYNC_ENABLED_BIT) ? "YES" : " NO";
-        char* text_buffer = string_format(
+        // Rebuilt every frame, so formatted on the stack rather than allocated
+        char text_buffer[512];
+        string_format_to(
+            text_buffer, sizeof(text_buffer),
             "\
 FPS: %5.1f(%4.1fms)        Pos=[%7.3f %7.3f %7.3f] Rot=[%7.3f, %7.3f, %7.3f]\n\
 Upd: %8.3fus, Prep: %8.3fus, Rend: %8.3fus, Total: %8.3fus \n\
@@ -996,7 +999,6 @@ VSync: %s Drawn: %-5u (%-5u shadow pass) Hovered: %s%u",
         // Update text control
         sui_label_text_set(state->sui_state, &state->test_text, text_buffer);
         sui_label_text_set(state->sui_state, &state->test_text_black, text_buffer);
-        string_free(text_buffer);
     }
 
 #ifdef BISMUTH_DEBUG
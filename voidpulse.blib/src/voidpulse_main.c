@@ -588,7 +588,10 @@ b8 application_update(struct application* app, struct frame_data* p_frame_data)
             break;
         }
 
-        char* text_buffer = string_format(
+        // Rebuilt every frame, so formatted on the stack rather than allocated
+        char text_buffer[512];
+        string_format_to(
+            text_buffer, sizeof(text_buffer),
             "\
 FPS: %5.1f(%4.1fms)        Pos=[%7.3f %7.3f %7.3f] Rot=[%7.3f, %7.3f, %7.3f]\n\
 Upd: %8.3fus, Prep: %8.3fus, Rend: %8.3fus, Total: %8.3fus \n\
@@ -616,7 +619,6 @@ VSync: %s Drawn: %-5u (%-5u shadow pass), Mode: %s, Run time: %s",
         // Update the text control
         sui_label_text_set(state->sui_state, &state->debug_text, text_buffer);
         sui_label_text_set(state->sui_state, &state->debug_text_shadow, text_buffer);
-        string_free(text_buffer);
         string_free(time_str);
     }
 